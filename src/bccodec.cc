@@ -0,0 +1,2286 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements block-compression encoders for the BC1, BC3, BC4, BC5,
+/// BC6H and BC7 formats, and decoders for all of BC1 through BC7. Every 4x4
+/// block is processed independently, so block rows may be encoded or decoded 
+/// in any order, and on any thread. The endpoint search is selected with an 
+/// image_encoder_quality_e value; IMAGE_ENCODER_QUALITY_HIGH performs an 
+/// exhaustive partition search for BC7 and is intended for offline packing. 
+/// The inner loops use SSE2, which is always available on x64 targets.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <emmintrin.h>
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The width and height of a compressed block, in pixels.
+#define BC_BLOCK_DIMENSION        4
+
+/// @summary The number of pixels in a compressed block.
+#define BC_BLOCK_PIXELS           16
+
+/// @summary The size of an uncompressed RGBA8 block, in bytes.
+#define BC_BLOCK_RGBA_SIZE        64
+
+/// @summary The number of least-squares refinement passes applied to endpoints at IMAGE_ENCODER_QUALITY_HIGH.
+#define BC_REFINE_ITERATIONS      2
+
+/// @summary BC1 pixels with an alpha value below this threshold are encoded as transparent.
+#define BC1_ALPHA_THRESHOLD       128
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Defines the state of a little-endian bit writer used to pack BC6H and BC7 blocks.
+struct bc_bit_writer_t
+{
+    uint8_t               *Data;            /// The 16-byte output block. Must be zero-initialized.
+    uint32_t               BitPos;          /// The index of the next bit to write.
+};
+
+/// @summary Defines the state of a little-endian bit reader used to unpack BC6H and BC7 blocks.
+struct bc_bit_reader_t
+{
+    uint64_t               Bits[2];         /// The 16-byte input block, as two little-endian 64-bit words.
+    uint32_t               BitPos;          /// The index of the next bit to read.
+};
+
+/// @summary Describes the layout of one of the eight BC7 modes.
+struct bc7_mode_info_t
+{
+    int                    Mode;            /// The BC7 mode number, in [0, 7].
+    int                    SubsetCount;     /// The number of subsets (1, 2 or 3.)
+    int                    PartitionBits;   /// The number of bits used to store the partition index.
+    int                    RotationBits;    /// The number of bits used to store the channel rotation.
+    int                    SelectorBits;    /// The number of bits used to store the index selector.
+    int                    ColorBits;       /// The number of bits per color endpoint component, excluding the p-bit.
+    int                    AlphaBits;       /// The number of bits per alpha endpoint component, or zero if the mode has no alpha.
+    int                    PBitType;        /// One of bc7_pbit_type_e.
+    int                    IndexBits;       /// The number of bits per index.
+    int                    IndexBits2;      /// The number of bits per index in the secondary index set, or zero if the mode has one index set.
+};
+
+/// @summary Define the ways in which BC7 modes use p-bits (the shared least-significant bit of each endpoint.)
+enum bc7_pbit_type_e : int
+{
+    BC7_PBIT_NONE          = 0,             /// The mode has no p-bits.
+    BC7_PBIT_SHARED        = 1,             /// Both endpoints of a subset share one p-bit.
+    BC7_PBIT_UNIQUE        = 2,             /// Each endpoint has its own p-bit.
+};
+
+/// @summary Stores a candidate BC7 encoding of a block.
+struct bc7_block_t
+{
+    bc7_mode_info_t const *Info;            /// The mode used to encode the block.
+    int                    Partition;       /// The two-subset partition index, or zero.
+    int                    Comp[2][2][4];   /// The quantized endpoint components, indexed by [subset][endpoint][channel].
+    int                    PBit[2][2];      /// The endpoint p-bits, indexed by [subset][endpoint].
+    uint8_t                Index[BC_BLOCK_PIXELS]; /// The palette index of each pixel.
+    uint32_t               Error;           /// The sum of squared differences over all channels.
+};
+
+/// @summary Define the endpoint fields stored in a BC6H block. W and X are the endpoints of region 0, and Y and Z are the endpoints of region 1.
+enum bc6h_field_e : int
+{
+    BC6H_RW                = 0,             /// The red component of endpoint W.
+    BC6H_GW                = 1,             /// The green component of endpoint W.
+    BC6H_BW                = 2,             /// The blue component of endpoint W.
+    BC6H_RX                = 3,             /// The red component of endpoint X.
+    BC6H_GX                = 4,             /// The green component of endpoint X.
+    BC6H_BX                = 5,             /// The blue component of endpoint X.
+    BC6H_RY                = 6,             /// The red component of endpoint Y.
+    BC6H_GY                = 7,             /// The green component of endpoint Y.
+    BC6H_BY                = 8,             /// The blue component of endpoint Y.
+    BC6H_RZ                = 9,             /// The red component of endpoint Z.
+    BC6H_GZ                = 10,            /// The green component of endpoint Z.
+    BC6H_BZ                = 11,            /// The blue component of endpoint Z.
+    BC6H_D                 = 12,            /// The partition index.
+};
+
+/// @summary Describes a run of bits in a BC6H block that stores part of an endpoint field.
+struct bc6h_field_t
+{
+    uint8_t                Field;           /// One of bc6h_field_e.
+    uint8_t                Shift;           /// The bit position within the field of the first bit of the run.
+    uint8_t                Count;           /// The number of bits in the run, or zero to terminate the field list.
+};
+
+/// @summary Describes the layout of one of the fourteen BC6H modes.
+struct bc6h_mode_desc_t
+{
+    uint8_t                Mode;            /// The value of the mode bits (2 bits for modes 1 and 2, and 5 bits for all other modes.)
+    uint8_t                Regions;         /// The number of regions (1 or 2.)
+    uint8_t                Transformed;     /// Non-zero if endpoints X, Y and Z are stored as deltas from endpoint W.
+    uint8_t                EndpointBits;    /// The number of bits in endpoint W.
+    uint8_t                DeltaBits[3];    /// The number of bits in the red, green and blue components of endpoints X, Y and Z.
+    bc6h_field_t           Fields[25];      /// The runs of endpoint bits, in the order they are stored, following the mode bits.
+};
+
+/// @summary Stores a candidate BC6H encoding of a block.
+struct bc6h_block_t
+{
+    int                    Mode;            /// The BC6H mode number, 11 or 12.
+    int                    Comp[2][3];      /// The quantized endpoint components, indexed by [endpoint][channel]. Endpoint 1 is absolute.
+    uint8_t                Index[BC_BLOCK_PIXELS]; /// The palette index of each pixel.
+    uint64_t               Error;           /// The sum of squared differences, in half-float units.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The BC7 and BC6H two-subset partition table. Bit i is set if pixel i belongs to subset 1.
+global_variable uint16_t const BC7_PARTITION2[64] = 
+{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000, 
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C, 
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660, 
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+/// @summary The index of the anchor pixel of subset 1 for each two-subset partition. The anchor of subset 0 is always pixel 0.
+global_variable uint8_t const BC7_ANCHOR2[64] = 
+{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2, 
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6, 
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+};
+
+/// @summary The BC6H and BC7 interpolation weights for 2, 3 and 4-bit indices, out of 64.
+global_variable int const BC_WEIGHTS2[4]  = { 0, 21, 43, 64 };
+global_variable int const BC_WEIGHTS3[8]  = { 0, 9, 18, 27, 37, 46, 55, 64 };
+global_variable int const BC_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/// @summary The BC7 three-subset partition table. Bits 2i and 2i+1 store the subset of pixel i.
+global_variable uint32_t const BC7_PARTITION3[64] = 
+{
+    0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050, 
+    0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250, 
+    0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500, 
+    0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200, 
+    0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50, 
+    0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600, 
+    0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000, 
+    0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+};
+
+/// @summary The indices of the anchor pixels of subsets 1 and 2 for each three-subset partition.
+global_variable uint8_t const BC7_ANCHOR3[64][2] = 
+{
+    { 3,15}, { 3, 8}, {15, 8}, {15, 3}, { 8,15}, { 3,15}, {15, 3}, {15, 8}, 
+    { 8,15}, { 8,15}, { 6,15}, { 6,15}, { 6,15}, { 5,15}, { 3,15}, { 3, 8}, 
+    { 3,15}, { 3, 8}, { 8,15}, {15, 3}, { 3,15}, { 3, 8}, { 6,15}, {10, 8}, 
+    { 5, 3}, { 8,15}, { 8, 6}, { 6,10}, { 8,15}, { 5,15}, {15,10}, {15, 8}, 
+    { 8,15}, {15, 3}, { 3,15}, { 5,10}, { 6,10}, {10, 8}, { 8, 9}, {15,10}, 
+    {15, 6}, { 3,15}, {15, 8}, { 5,15}, {15, 3}, {15, 6}, {15, 6}, {15, 8}, 
+    { 3,15}, {15, 3}, { 5,15}, { 5,15}, { 5,15}, { 8,15}, { 5,15}, {10,15}, 
+    { 5,15}, {10,15}, { 8,15}, {13,15}, {15, 3}, {12,15}, { 3,15}, { 3, 8}
+};
+
+/// @summary The layout of each BC7 mode, indexed by mode number. The encoder generates modes 1, 3, 6 and 7 only.
+global_variable bc7_mode_info_t const BC7_MODES[8] = 
+{
+    { 0, 3, 4, 0, 0, 4, 0, BC7_PBIT_UNIQUE, 3, 0 }, 
+    { 1, 2, 6, 0, 0, 6, 0, BC7_PBIT_SHARED, 3, 0 }, 
+    { 2, 3, 6, 0, 0, 5, 0, BC7_PBIT_NONE  , 2, 0 }, 
+    { 3, 2, 6, 0, 0, 7, 0, BC7_PBIT_UNIQUE, 2, 0 }, 
+    { 4, 1, 0, 2, 1, 5, 6, BC7_PBIT_NONE  , 2, 3 }, 
+    { 5, 1, 0, 2, 0, 7, 8, BC7_PBIT_NONE  , 2, 2 }, 
+    { 6, 1, 0, 0, 0, 7, 7, BC7_PBIT_UNIQUE, 4, 0 }, 
+    { 7, 2, 6, 0, 0, 5, 5, BC7_PBIT_UNIQUE, 2, 0 }
+};
+
+/// @summary The layout of each BC6H mode, in the order of the mode numbers used by the specification (1 through 14.)
+global_variable bc6h_mode_desc_t const BC6H_MODES[14] = 
+{
+    { 0x00, 2, 1, 10, {  5,  5,  5 }, {
+        { BC6H_GY, 4, 1 }, { BC6H_BY, 4, 1 }, { BC6H_BZ, 4, 1 }, { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 },
+        { BC6H_RX, 0, 5 }, { BC6H_GZ, 4, 1 }, { BC6H_GY, 0, 4 }, { BC6H_GX, 0, 5 }, { BC6H_BZ, 0, 1 }, { BC6H_GZ, 0, 4 },
+        { BC6H_BX, 0, 5 }, { BC6H_BZ, 1, 1 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 5 }, { BC6H_BZ, 2, 1 }, { BC6H_RZ, 0, 5 },
+        { BC6H_BZ, 3, 1 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x01, 2, 1,  7, {  6,  6,  6 }, {
+        { BC6H_GY, 5, 1 }, { BC6H_GZ, 4, 1 }, { BC6H_GZ, 5, 1 }, { BC6H_RW, 0, 7 }, { BC6H_BZ, 0, 1 }, { BC6H_BZ, 1, 1 },
+        { BC6H_BY, 4, 1 }, { BC6H_GW, 0, 7 }, { BC6H_BY, 5, 1 }, { BC6H_BZ, 2, 1 }, { BC6H_GY, 4, 1 }, { BC6H_BW, 0, 7 },
+        { BC6H_BZ, 3, 1 }, { BC6H_BZ, 5, 1 }, { BC6H_BZ, 4, 1 }, { BC6H_RX, 0, 6 }, { BC6H_GY, 0, 4 }, { BC6H_GX, 0, 6 },
+        { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 6 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 6 }, { BC6H_RZ, 0, 6 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x02, 2, 1, 11, {  5,  4,  4 }, {
+        { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 }, { BC6H_RX, 0, 5 }, { BC6H_RW,10, 1 }, { BC6H_GY, 0, 4 },
+        { BC6H_GX, 0, 4 }, { BC6H_GW,10, 1 }, { BC6H_BZ, 0, 1 }, { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 4 }, { BC6H_BW,10, 1 },
+        { BC6H_BZ, 1, 1 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 5 }, { BC6H_BZ, 2, 1 }, { BC6H_RZ, 0, 5 }, { BC6H_BZ, 3, 1 },
+        { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x06, 2, 1, 11, {  4,  5,  4 }, {
+        { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 }, { BC6H_RX, 0, 4 }, { BC6H_RW,10, 1 }, { BC6H_GZ, 4, 1 },
+        { BC6H_GY, 0, 4 }, { BC6H_GX, 0, 5 }, { BC6H_GW,10, 1 }, { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 4 }, { BC6H_BW,10, 1 },
+        { BC6H_BZ, 1, 1 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 4 }, { BC6H_BZ, 0, 1 }, { BC6H_BZ, 2, 1 }, { BC6H_RZ, 0, 4 },
+        { BC6H_GY, 4, 1 }, { BC6H_BZ, 3, 1 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x0A, 2, 1, 11, {  4,  4,  5 }, {
+        { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 }, { BC6H_RX, 0, 4 }, { BC6H_RW,10, 1 }, { BC6H_BY, 4, 1 },
+        { BC6H_GY, 0, 4 }, { BC6H_GX, 0, 4 }, { BC6H_GW,10, 1 }, { BC6H_BZ, 0, 1 }, { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 5 },
+        { BC6H_BW,10, 1 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 4 }, { BC6H_BZ, 1, 1 }, { BC6H_BZ, 2, 1 }, { BC6H_RZ, 0, 4 },
+        { BC6H_BZ, 4, 1 }, { BC6H_BZ, 3, 1 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x0E, 2, 1,  9, {  5,  5,  5 }, {
+        { BC6H_RW, 0, 9 }, { BC6H_BY, 4, 1 }, { BC6H_GW, 0, 9 }, { BC6H_GY, 4, 1 }, { BC6H_BW, 0, 9 }, { BC6H_BZ, 4, 1 },
+        { BC6H_RX, 0, 5 }, { BC6H_GZ, 4, 1 }, { BC6H_GY, 0, 4 }, { BC6H_GX, 0, 5 }, { BC6H_BZ, 0, 1 }, { BC6H_GZ, 0, 4 },
+        { BC6H_BX, 0, 5 }, { BC6H_BZ, 1, 1 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 5 }, { BC6H_BZ, 2, 1 }, { BC6H_RZ, 0, 5 },
+        { BC6H_BZ, 3, 1 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x12, 2, 1,  8, {  6,  5,  5 }, {
+        { BC6H_RW, 0, 8 }, { BC6H_GZ, 4, 1 }, { BC6H_BY, 4, 1 }, { BC6H_GW, 0, 8 }, { BC6H_BZ, 2, 1 }, { BC6H_GY, 4, 1 },
+        { BC6H_BW, 0, 8 }, { BC6H_BZ, 3, 1 }, { BC6H_BZ, 4, 1 }, { BC6H_RX, 0, 6 }, { BC6H_GY, 0, 4 }, { BC6H_GX, 0, 5 },
+        { BC6H_BZ, 0, 1 }, { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 5 }, { BC6H_BZ, 1, 1 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 6 },
+        { BC6H_RZ, 0, 6 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x16, 2, 1,  8, {  5,  6,  5 }, {
+        { BC6H_RW, 0, 8 }, { BC6H_BZ, 0, 1 }, { BC6H_BY, 4, 1 }, { BC6H_GW, 0, 8 }, { BC6H_GY, 5, 1 }, { BC6H_GY, 4, 1 },
+        { BC6H_BW, 0, 8 }, { BC6H_GZ, 5, 1 }, { BC6H_BZ, 4, 1 }, { BC6H_RX, 0, 5 }, { BC6H_GZ, 4, 1 }, { BC6H_GY, 0, 4 },
+        { BC6H_GX, 0, 6 }, { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 5 }, { BC6H_BZ, 1, 1 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 5 },
+        { BC6H_BZ, 2, 1 }, { BC6H_RZ, 0, 5 }, { BC6H_BZ, 3, 1 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x1A, 2, 1,  8, {  5,  5,  6 }, {
+        { BC6H_RW, 0, 8 }, { BC6H_BZ, 1, 1 }, { BC6H_BY, 4, 1 }, { BC6H_GW, 0, 8 }, { BC6H_BY, 5, 1 }, { BC6H_GY, 4, 1 },
+        { BC6H_BW, 0, 8 }, { BC6H_BZ, 5, 1 }, { BC6H_BZ, 4, 1 }, { BC6H_RX, 0, 5 }, { BC6H_GZ, 4, 1 }, { BC6H_GY, 0, 4 },
+        { BC6H_GX, 0, 5 }, { BC6H_BZ, 0, 1 }, { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 6 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 5 },
+        { BC6H_BZ, 2, 1 }, { BC6H_RZ, 0, 5 }, { BC6H_BZ, 3, 1 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x1E, 2, 0,  6, {  6,  6,  6 }, {
+        { BC6H_RW, 0, 6 }, { BC6H_GZ, 4, 1 }, { BC6H_BZ, 0, 1 }, { BC6H_BZ, 1, 1 }, { BC6H_BY, 4, 1 }, { BC6H_GW, 0, 6 },
+        { BC6H_GY, 5, 1 }, { BC6H_BY, 5, 1 }, { BC6H_BZ, 2, 1 }, { BC6H_GY, 4, 1 }, { BC6H_BW, 0, 6 }, { BC6H_GZ, 5, 1 },
+        { BC6H_BZ, 3, 1 }, { BC6H_BZ, 5, 1 }, { BC6H_BZ, 4, 1 }, { BC6H_RX, 0, 6 }, { BC6H_GY, 0, 4 }, { BC6H_GX, 0, 6 },
+        { BC6H_GZ, 0, 4 }, { BC6H_BX, 0, 6 }, { BC6H_BY, 0, 4 }, { BC6H_RY, 0, 6 }, { BC6H_RZ, 0, 6 }, { BC6H_D, 0, 5 }, { 0, 0, 0 } } },
+    { 0x03, 1, 0, 10, { 10, 10, 10 }, {
+        { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 }, { BC6H_RX, 0,10 }, { BC6H_GX, 0,10 }, { BC6H_BX, 0,10 }, { 0, 0, 0 } } },
+    { 0x07, 1, 1, 11, {  9,  9,  9 }, {
+        { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 }, { BC6H_RX, 0, 9 }, { BC6H_RW,10, 1 }, { BC6H_GX, 0, 9 },
+        { BC6H_GW,10, 1 }, { BC6H_BX, 0, 9 }, { BC6H_BW,10, 1 }, { 0, 0, 0 } } },
+    { 0x0B, 1, 1, 12, {  8,  8,  8 }, {
+        { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 }, { BC6H_RX, 0, 8 }, { BC6H_RW,11, 1 }, { BC6H_RW,10, 1 },
+        { BC6H_GX, 0, 8 }, { BC6H_GW,11, 1 }, { BC6H_GW,10, 1 }, { BC6H_BX, 0, 8 }, { BC6H_BW,11, 1 }, { BC6H_BW,10, 1 }, { 0, 0, 0 } } },
+    { 0x0F, 1, 1, 16, {  4,  4,  4 }, {
+        { BC6H_RW, 0,10 }, { BC6H_GW, 0,10 }, { BC6H_BW, 0,10 }, { BC6H_RX, 0, 4 }, { BC6H_RW,15, 1 }, { BC6H_RW,14, 1 },
+        { BC6H_RW,13, 1 }, { BC6H_RW,12, 1 }, { BC6H_RW,11, 1 }, { BC6H_RW,10, 1 }, { BC6H_GX, 0, 4 }, { BC6H_GW,15, 1 },
+        { BC6H_GW,14, 1 }, { BC6H_GW,13, 1 }, { BC6H_GW,12, 1 }, { BC6H_GW,11, 1 }, { BC6H_GW,10, 1 }, { BC6H_BX, 0, 4 },
+        { BC6H_BW,15, 1 }, { BC6H_BW,14, 1 }, { BC6H_BW,13, 1 }, { BC6H_BW,12, 1 }, { BC6H_BW,11, 1 }, { BC6H_BW,10, 1 }, { 0, 0, 0 } } }
+};
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Quantize an RGB888 color to RGB565, rounding to nearest.
+/// @param rgb The red, green and blue components, in [0, 255].
+/// @return The packed RGB565 value.
+internal_function inline uint32_t bc_pack565(int const *rgb)
+{
+    return (uint32_t((rgb[0] * 31 + 127) / 255) << 11) |
+           (uint32_t((rgb[1] * 63 + 127) / 255) <<  5) |
+           (uint32_t((rgb[2] * 31 + 127) / 255));
+}
+
+/// @summary Expand an RGB565 color to RGB888 the way the hardware does, by replicating the high bits.
+/// @param c The packed RGB565 value.
+/// @param rgb On return, the red, green and blue components, in [0, 255].
+internal_function inline void bc_unpack565(uint32_t c, int *rgb)
+{
+    int r  = (c >> 11) & 31;
+    int g  = (c >>  5) & 63;
+    int b  = (c      ) & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+/// @summary Clamp a floating-point color component to [0, 255] and round it to an integer.
+/// @param v The component value.
+/// @return The rounded, clamped value.
+internal_function inline int bc_clamp255(float v)
+{
+    if (v <=   0.0f) return 0;
+    if (v >= 255.0f) return 255;
+    return int(v + 0.5f);
+}
+
+/// @summary Swap the red and blue channels of four RGBA8 or BGRA8 pixels.
+/// @param p The four pixels.
+/// @return The swizzled pixels.
+internal_function inline __m128i bc_swap_rb(__m128i p)
+{
+    __m128i ag = _mm_and_si128(p, _mm_set1_epi32(int(0xFF00FF00)));
+    __m128i rb = _mm_and_si128(p, _mm_set1_epi32(int(0x00FF00FF)));
+    return _mm_or_si128(ag, _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+}
+
+/// @summary Compute the per-channel minimum and maximum of all sixteen pixels of a block.
+/// @param block The 64-byte RGBA8 block.
+/// @param min_rgba On return, the minimum value of each channel.
+/// @param max_rgba On return, the maximum value of each channel.
+internal_function inline void bc_block_bounds(uint8_t const *block, int *min_rgba, int *max_rgba)
+{
+    __m128i r0 = _mm_loadu_si128((__m128i const*)(block +  0));
+    __m128i r1 = _mm_loadu_si128((__m128i const*)(block + 16));
+    __m128i r2 = _mm_loadu_si128((__m128i const*)(block + 32));
+    __m128i r3 = _mm_loadu_si128((__m128i const*)(block + 48));
+    __m128i mn = _mm_min_epu8(_mm_min_epu8(r0, r1), _mm_min_epu8(r2, r3));
+    __m128i mx = _mm_max_epu8(_mm_max_epu8(r0, r1), _mm_max_epu8(r2, r3));
+    // reduce the four pixels in each register down to a single pixel in lane 0.
+    mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+    mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(1, 0, 3, 2)));
+    mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+    mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t lo = uint32_t(_mm_cvtsi128_si32(mn));
+    uint32_t hi = uint32_t(_mm_cvtsi128_si32(mx));
+    for (int c = 0; c < 4; ++c)
+    {
+        min_rgba[c] = int((lo >> (c * 8)) & 0xFF);
+        max_rgba[c] = int((hi >> (c * 8)) & 0xFF);
+    }
+}
+
+/// @summary Extract one channel of all sixteen pixels of a block.
+/// @param block The 64-byte RGBA8 block.
+/// @param channel The zero-based channel index, in [0, 3].
+/// @return The sixteen channel values, in pixel order.
+internal_function inline __m128i bc_block_channel(uint8_t const *block, int channel)
+{
+    __m128i shift = _mm_cvtsi32_si128(channel * 8);
+    __m128i mask  = _mm_set1_epi32(0xFF);
+    __m128i r0    = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((__m128i const*)(block +  0)), shift), mask);
+    __m128i r1    = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((__m128i const*)(block + 16)), shift), mask);
+    __m128i r2    = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((__m128i const*)(block + 32)), shift), mask);
+    __m128i r3    = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((__m128i const*)(block + 48)), shift), mask);
+    return _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+}
+
+/// @summary Select the color endpoints for a block using the selected quality setting.
+/// @param block The 64-byte RGBA8 block.
+/// @param opaque A 16-bit mask of the pixels to consider. Must be non-zero.
+/// @param quality One of image_encoder_quality_e.
+/// @param e0 On return, the RGB components of the high endpoint.
+/// @param e1 On return, the RGB components of the low endpoint.
+internal_function void bc_color_endpoints(uint8_t const *block, uint32_t opaque, int quality, int *e0, int *e1)
+{
+    int mn[4], mx[4];
+    if (opaque == 0xFFFF)
+    {   // all pixels participate; use the SIMD bounds.
+        bc_block_bounds(block, mn, mx);
+    }
+    else
+    {   // only some pixels participate; this only happens for BC1 blocks with transparency.
+        mn[0] = mn[1] = mn[2] = 255;
+        mx[0] = mx[1] = mx[2] = 0;
+        for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+        {
+            if (opaque & (1U << i))
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    int v = block[i * 4 + c];
+                    if (v < mn[c]) mn[c] = v;
+                    if (v > mx[c]) mx[c] = v;
+                }
+            }
+        }
+    }
+    if (quality == IMAGE_ENCODER_QUALITY_FAST)
+    {   // use the bounding box diagonal, inset by 1/16th of its extent to reduce the error at the extremes.
+        for (int c = 0; c < 3; ++c)
+        {
+            int inset = (mx[c] - mn[c]) >> 4;
+            e0[c] = mx[c] - inset;
+            e1[c] = mn[c] + inset;
+        }
+        return;
+    }
+
+    // compute the covariance matrix of the participating pixels.
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    float cov [6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    float count   = 0.0f;
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        if (opaque & (1U << i))
+        {
+            mean[0] += block[i * 4 + 0];
+            mean[1] += block[i * 4 + 1];
+            mean[2] += block[i * 4 + 2];
+            count   += 1.0f;
+        }
+    }
+    mean[0] /= count; mean[1] /= count; mean[2] /= count;
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        if (opaque & (1U << i))
+        {
+            float r = block[i * 4 + 0] - mean[0];
+            float g = block[i * 4 + 1] - mean[1];
+            float b = block[i * 4 + 2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+    }
+
+    // find the principal axis with a few rounds of power iteration, starting from the bounding box diagonal.
+    float axis[3] = { float(mx[0] - mn[0]), float(mx[1] - mn[1]), float(mx[2] - mn[2]) };
+    for (int iter = 0; iter < 4; ++iter)
+    {
+        float x = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+        float y = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+        float z = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+        float m = fabsf(x);
+        if (fabsf(y) > m) m = fabsf(y);
+        if (fabsf(z) > m) m = fabsf(z);
+        if (m < 1e-6f)
+        {   // the block is flat, or the axis is orthogonal to the data; keep the current axis.
+            break;
+        }
+        axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+    }
+
+    // the endpoints are the pixels with the smallest and largest projections onto the axis.
+    float pmin =  FLT_MAX; int imin = 0;
+    float pmax = -FLT_MAX; int imax = 0;
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        if (opaque & (1U << i))
+        {
+            float p = block[i * 4 + 0] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+            if (p < pmin) { pmin = p; imin = i; }
+            if (p > pmax) { pmax = p; imax = i; }
+        }
+    }
+    for (int c = 0; c < 3; ++c)
+    {
+        e0[c] = block[imax * 4 + c];
+        e1[c] = block[imin * 4 + c];
+    }
+}
+
+/// @summary Select the 2-bit color index of each pixel of a block by projecting it onto the line between the endpoints.
+/// @param block The 64-byte RGBA8 block.
+/// @param c0 The RGB565 value of endpoint 0.
+/// @param c1 The RGB565 value of endpoint 1.
+/// @param transparent A 16-bit mask of pixels to encode as transparent. Non-zero only for the three-color mode.
+/// @return The packed color indices.
+internal_function uint32_t bc_color_indices(uint8_t const *block, uint32_t c0, uint32_t c1, uint32_t transparent)
+{
+    static int const MAP4[4] = { 1, 3, 2, 0 }; // projection step => index, c0 > c1
+    static int const MAP3[3] = { 1, 2, 0 };    // projection step => index, c0 <= c1
+    bool   four_color   = c0 > c1;
+    int    const *map   = four_color ? MAP4 : MAP3;
+    int    steps        = four_color ? 3 : 2;
+    int    e0[3], e1[3];
+    bc_unpack565(c0, e0);
+    bc_unpack565(c1, e1);
+    int    d[3]         = { e0[0] - e1[0], e0[1] - e1[1], e0[2] - e1[2] };
+    int    dd           = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    uint32_t indices    = 0;
+    if (dd == 0)
+    {   // both endpoints are the same color; every opaque pixel uses index 0.
+        for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+        {
+            if (transparent & (1U << i)) indices |= 3U << (i * 2);
+        }
+        return indices;
+    }
+
+    __m128i zero  = _mm_setzero_si128();
+    __m128i base  = _mm_set_epi16(0, short(e1[2]), short(e1[1]), short(e1[0]), 0, short(e1[2]), short(e1[1]), short(e1[0]));
+    __m128i dir   = _mm_set_epi16(0, short( d[2]), short( d[1]), short( d[0]), 0, short( d[2]), short( d[1]), short( d[0]));
+    __m128  scale = _mm_set1_ps(float(steps) / float(dd));
+    __m128  half  = _mm_set1_ps(0.5f);
+    __m128  lo    = _mm_setzero_ps();
+    __m128  hi    = _mm_set1_ps(float(steps));
+    int32_t step[BC_BLOCK_PIXELS];
+    for (int row = 0; row < BC_BLOCK_DIMENSION; ++row)
+    {   // widen each pixel to 16 bits, and take its dot product with the endpoint axis.
+        __m128i px   = _mm_loadu_si128((__m128i const*)(block + row * 16));
+        __m128i p01  = _mm_sub_epi16(_mm_unpacklo_epi8(px, zero), base);
+        __m128i p23  = _mm_sub_epi16(_mm_unpackhi_epi8(px, zero), base);
+        __m128  m01  = _mm_castsi128_ps(_mm_madd_epi16(p01, dir)); // r*dr+g*dg, b*db for pixels 0, 1
+        __m128  m23  = _mm_castsi128_ps(_mm_madd_epi16(p23, dir)); // r*dr+g*dg, b*db for pixels 2, 3
+        __m128i even = _mm_castps_si128(_mm_shuffle_ps(m01, m23, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd  = _mm_castps_si128(_mm_shuffle_ps(m01, m23, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128  t    = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(even, odd)), scale), half);
+        t = _mm_min_ps(_mm_max_ps(t, lo), hi);
+        _mm_storeu_si128((__m128i*) &step[row * 4], _mm_cvttps_epi32(t));
+    }
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        uint32_t index = (transparent & (1U << i)) ? 3U : uint32_t(map[step[i]]);
+        indices |= index << (i * 2);
+    }
+    return indices;
+}
+
+/// @summary Compute the squared error of an encoded color block against the source pixels.
+/// @param block The 64-byte RGBA8 block.
+/// @param c0 The RGB565 value of endpoint 0.
+/// @param c1 The RGB565 value of endpoint 1.
+/// @param indices The packed color indices.
+/// @return The sum of squared differences over all non-transparent pixels.
+internal_function uint32_t bc_color_error(uint8_t const *block, uint32_t c0, uint32_t c1, uint32_t indices)
+{
+    int palette[4][3];
+    bc_unpack565(c0, palette[0]);
+    bc_unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+        if (c0 > c1)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    uint32_t error = 0;
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        uint32_t index = (indices >> (i * 2)) & 3;
+        if (c0 <= c1 && index == 3)
+            continue;
+        for (int c = 0; c < 3; ++c)
+        {
+            int d  = int(block[i * 4 + c]) - palette[index][c];
+            error += uint32_t(d * d);
+        }
+    }
+    return error;
+}
+
+/// @summary Solve for the pair of endpoints that minimizes the squared error for a fixed set of color indices.
+/// @param block The 64-byte RGBA8 block.
+/// @param c0 The RGB565 value of endpoint 0 used to generate the indices.
+/// @param c1 The RGB565 value of endpoint 1 used to generate the indices.
+/// @param indices The packed color indices.
+/// @param e0 On return, the RGB components of the refined endpoint 0.
+/// @param e1 On return, the RGB components of the refined endpoint 1.
+/// @return true if the refined endpoints were computed, or false if the system is singular.
+internal_function bool bc_color_refine(uint8_t const *block, uint32_t c0, uint32_t c1, uint32_t indices, int *e0, int *e1)
+{
+    static float const W4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    static float const W3[4] = { 1.0f, 0.0f, 0.5f       , 0.0f        };
+    float const *w = (c0 > c1) ? W4 : W3;
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f };
+    float bx[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        uint32_t index = (indices >> (i * 2)) & 3;
+        if (c0 <= c1 && index == 3)
+            continue;
+        float a = w[index];
+        float b = 1.0f - a;
+        aa += a * a; bb += b * b; ab += a * b;
+        for (int c = 0; c < 3; ++c)
+        {
+            ax[c] += a * block[i * 4 + c];
+            bx[c] += b * block[i * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+    {   // all pixels map to the same index.
+        return false;
+    }
+    float inv = 1.0f / det;
+    for (int c = 0; c < 3; ++c)
+    {
+        e0[c] = bc_clamp255((ax[c] * bb - bx[c] * ab) * inv);
+        e1[c] = bc_clamp255((bx[c] * aa - ax[c] * ab) * inv);
+    }
+    return true;
+}
+
+/// @summary Order a pair of RGB565 endpoints for the four-color or three-color mode, and compute the color indices.
+/// @param block The 64-byte RGBA8 block.
+/// @param e0 The RGB components of the first endpoint.
+/// @param e1 The RGB components of the second endpoint.
+/// @param transparent A 16-bit mask of transparent pixels. If non-zero, the three-color mode is used.
+/// @param c0 On return, the RGB565 value of endpoint 0.
+/// @param c1 On return, the RGB565 value of endpoint 1.
+/// @return The packed color indices.
+internal_function uint32_t bc_color_fit(uint8_t const *block, int const *e0, int const *e1, uint32_t transparent, uint32_t &c0, uint32_t &c1)
+{
+    uint32_t a = bc_pack565(e0);
+    uint32_t b = bc_pack565(e1);
+    if (transparent != 0)
+    {   // the three-color mode requires c0 <= c1.
+        c0 = a < b ? a : b;
+        c1 = a < b ? b : a;
+    }
+    else
+    {   // the four-color mode requires c0 > c1; if they're equal, every pixel uses index 0 anyway.
+        c0 = a > b ? a : b;
+        c1 = a > b ? b : a;
+    }
+    return bc_color_indices(block, c0, c1, transparent);
+}
+
+/// @summary Encode the color portion of a block in the BC1 layout.
+/// @param block The 64-byte RGBA8 block.
+/// @param allow_transparent Specify true to use the three-color mode for blocks with transparent pixels (BC1 only.)
+/// @param quality One of image_encoder_quality_e.
+/// @param dst The 8-byte output block.
+internal_function void bc_encode_color(uint8_t const *block, bool allow_transparent, int quality, uint8_t *dst)
+{
+    uint32_t transparent = 0;
+    uint32_t c0 = 0, c1 = 0, indices = 0;
+    int      e0[3], e1[3];
+    if (allow_transparent)
+    {   // build the transparency mask from the alpha channel.
+        __m128i a   = bc_block_channel(block, 3);
+        __m128i lt  = _mm_cmplt_epi8(_mm_xor_si128(a, _mm_set1_epi8(char(0x80))), _mm_set1_epi8(char(BC1_ALPHA_THRESHOLD - 128)));
+        transparent = uint32_t(_mm_movemask_epi8(lt));
+    }
+    if (transparent == 0xFFFF)
+    {   // every pixel is transparent.
+        c0 = 0; c1 = 0; indices = 0xFFFFFFFFU;
+    }
+    else
+    {
+        bc_color_endpoints(block, ~transparent & 0xFFFF, quality, e0, e1);
+        indices = bc_color_fit(block, e0, e1, transparent, c0, c1);
+        if (quality == IMAGE_ENCODER_QUALITY_HIGH)
+        {   // refine the endpoints while the error continues to decrease.
+            uint32_t error = bc_color_error(block, c0, c1, indices);
+            for (int iter  = 0; iter < BC_REFINE_ITERATIONS && error > 0; ++iter)
+            {
+                uint32_t r0, r1, ri;
+                if (!bc_color_refine(block, c0, c1, indices, e0, e1))
+                    break;
+                ri = bc_color_fit(block, e0, e1, transparent, r0, r1);
+                uint32_t new_error = bc_color_error(block, r0, r1, ri);
+                if (new_error >= error)
+                    break;
+                c0 = r0; c1 = r1; indices = ri; error = new_error;
+            }
+        }
+    }
+    dst[0] = uint8_t(c0); dst[1] = uint8_t(c0 >> 8);
+    dst[2] = uint8_t(c1); dst[3] = uint8_t(c1 >> 8);
+    dst[4] = uint8_t(indices      ); dst[5] = uint8_t(indices >>  8);
+    dst[6] = uint8_t(indices >> 16); dst[7] = uint8_t(indices >> 24);
+}
+
+/// @summary Build the eight-entry palette of a BC4 block.
+/// @param a0 The value of endpoint 0.
+/// @param a1 The value of endpoint 1.
+/// @param palette On return, the eight palette values.
+internal_function inline void bc_alpha_palette(int a0, int a1, int *palette)
+{
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1)
+    {   // eight-value mode; six interpolated values.
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    }
+    else
+    {   // six-value mode; four interpolated values plus 0 and 255.
+        for (int i = 1; i < 5; ++i)
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+/// @summary Select the nearest palette entry for each value of a BC4 block, and compute the total squared error.
+/// @param values The sixteen channel values.
+/// @param a0 The value of endpoint 0.
+/// @param a1 The value of endpoint 1.
+/// @param indices On return, the packed 3-bit indices.
+/// @return The sum of squared differences.
+internal_function uint32_t bc_alpha_search(uint8_t const *values, int a0, int a1, uint64_t &indices)
+{
+    int      palette[8];
+    uint32_t error = 0;
+    bc_alpha_palette(a0, a1, palette);
+    indices = 0;
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        int best = 0, best_d = INT_MAX;
+        for (int j = 0; j < 8; ++j)
+        {
+            int d = (values[i] - palette[j]) * (values[i] - palette[j]);
+            if (d < best_d) { best_d = d; best = j; }
+        }
+        indices |= uint64_t(best) << (i * 3);
+        error   += uint32_t(best_d);
+    }
+    return error;
+}
+
+/// @summary Encode one channel of a block in the BC4 layout, which is also used for BC3 alpha and each BC5 channel.
+/// @param block The 64-byte RGBA8 block.
+/// @param channel The zero-based index of the channel to encode.
+/// @param quality One of image_encoder_quality_e.
+/// @param dst The 8-byte output block.
+internal_function void bc_encode_alpha(uint8_t const *block, int channel, int quality, uint8_t *dst)
+{
+    __m128i  v  = bc_block_channel(block, channel);
+    __m128i  mn = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+    __m128i  mx = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+    mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 4)); mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 4));
+    mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 2)); mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 2));
+    mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 1)); mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 1));
+    int      a0 = _mm_cvtsi128_si32(mx) & 0xFF;
+    int      a1 = _mm_cvtsi128_si32(mn) & 0xFF;
+    uint64_t indices = 0;
+    if (a0 != a1)
+    {   // eight-value mode; quantize (v - min) / (max - min) to 7 steps, four values at a time.
+        static int const MAP8[8] = { 1, 7, 6, 5, 4, 3, 2, 0 }; // quantized step => index
+        __m128i  zero  = _mm_setzero_si128();
+        __m128i  v16lo = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), _mm_set1_epi16(short(a1)));
+        __m128i  v16hi = _mm_sub_epi16(_mm_unpackhi_epi8(v, zero), _mm_set1_epi16(short(a1)));
+        __m128   scale = _mm_set1_ps(7.0f / float(a0 - a1));
+        __m128   half  = _mm_set1_ps(0.5f);
+        int32_t  step[BC_BLOCK_PIXELS];
+        _mm_storeu_si128((__m128i*) &step[ 0], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v16lo, zero)), scale), half)));
+        _mm_storeu_si128((__m128i*) &step[ 4], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v16lo, zero)), scale), half)));
+        _mm_storeu_si128((__m128i*) &step[ 8], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v16hi, zero)), scale), half)));
+        _mm_storeu_si128((__m128i*) &step[12], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v16hi, zero)), scale), half)));
+        for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+        {
+            indices |= uint64_t(MAP8[step[i]]) << (i * 3);
+        }
+        if (quality == IMAGE_ENCODER_QUALITY_HIGH)
+        {   // try the six-value mode, which represents 0 and 255 exactly, and keep whichever is better.
+            uint8_t values[BC_BLOCK_PIXELS];
+            _mm_storeu_si128((__m128i*) values, v);
+            int lo = 255, hi = 0;
+            for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+            {
+                if (values[i] != 0 && values[i] != 255)
+                {
+                    if (values[i] < lo) lo = values[i];
+                    if (values[i] > hi) hi = values[i];
+                }
+            }
+            if (lo > hi)
+            {   // only 0 and 255 are present.
+                lo = hi = 0;
+            }
+            uint64_t idx8, idx6;
+            uint32_t err8 = bc_alpha_search(values, a0, a1, idx8);
+            uint32_t err6 = bc_alpha_search(values, lo, hi, idx6);
+            if (err6 < err8)
+            {
+                a0 = lo; a1 = hi; indices = idx6;
+            }
+            else indices = idx8;
+        }
+    }
+    dst[0] = uint8_t(a0);
+    dst[1] = uint8_t(a1);
+    for (int i = 0; i < 6; ++i)
+    {
+        dst[i + 2] = uint8_t(indices >> (i * 8));
+    }
+}
+
+/// @summary Load one block of pixels from up to four rows of source image data, replicating edge pixels to fill partial blocks.
+/// @param src The address of the first pixel of the first row of the block row.
+/// @param src_pitch The number of bytes between source rows.
+/// @param x The x-coordinate of the left edge of the block, in pixels.
+/// @param width The width of the source image, in pixels.
+/// @param height The number of valid rows in the block row, in [1, 4].
+/// @param swap_rb Specify true if the source data is BGRA8.
+/// @param block On return, the 64-byte RGBA8 block.
+internal_function inline void bc_load_block(uint8_t const *src, size_t src_pitch, size_t x, size_t width, size_t height, bool swap_rb, uint8_t *block)
+{
+    for (size_t row = 0; row < BC_BLOCK_DIMENSION; ++row)
+    {
+        uint8_t const *rowp = src + ((row < height) ? row : height - 1) * src_pitch;
+        __m128i        px;
+        if (x + BC_BLOCK_DIMENSION <= width)
+        {   // the common case - the block is entirely inside the image.
+            px = _mm_loadu_si128((__m128i const*)(rowp + x * 4));
+        }
+        else
+        {   // replicate the last column.
+            uint32_t p[4];
+            for (size_t i = 0; i < BC_BLOCK_DIMENSION; ++i)
+            {
+                size_t sx = (x + i < width) ? x + i : width - 1;
+                memcpy(&p[i], rowp + sx * 4, sizeof(uint32_t));
+            }
+            px = _mm_loadu_si128((__m128i const*) p);
+        }
+        if (swap_rb) px = bc_swap_rb(px);
+        _mm_storeu_si128((__m128i*)(block + row * 16), px);
+    }
+}
+
+/// @summary Append a value to a packed block.
+/// @param w The bit writer.
+/// @param value The value to write. Only the low count bits are written.
+/// @param count The number of bits to write.
+internal_function inline void bc_write_bits(bc_bit_writer_t &w, uint32_t value, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i, ++w.BitPos)
+    {
+        w.Data[w.BitPos >> 3] |= uint8_t(((value >> i) & 1U) << (w.BitPos & 7));
+    }
+}
+
+/// @summary Retrieve the interpolation weight table for a given index size.
+/// @param index_bits The number of bits per index, in [2, 4].
+/// @return The table of (1 << index_bits) weights.
+internal_function inline int const* bc_weights(int index_bits)
+{
+    return (index_bits == 2) ? BC_WEIGHTS2 : ((index_bits == 3) ? BC_WEIGHTS3 : BC_WEIGHTS4);
+}
+
+/// @summary Fit a line through a set of points with principal component analysis and return the extent of the points along it.
+/// @param pts The points, stored with a stride of four floats.
+/// @param count The number of points. Must be non-zero.
+/// @param nch The number of channels to consider, 3 or 4.
+/// @param quality One of image_encoder_quality_e. At IMAGE_ENCODER_QUALITY_FAST, the bounding box diagonal is used instead.
+/// @param a On return, the low endpoint.
+/// @param b On return, the high endpoint.
+internal_function void bc_fit_line(float const *pts, int count, int nch, int quality, float *a, float *b)
+{
+    float mn[4] = {  FLT_MAX,  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    float mx[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < count; ++i)
+    {
+        for (int c = 0; c < nch; ++c)
+        {
+            float v  = pts[i * 4 + c];
+            mean[c] += v;
+            if (v < mn[c]) mn[c] = v;
+            if (v > mx[c]) mx[c] = v;
+        }
+    }
+    if (quality == IMAGE_ENCODER_QUALITY_FAST || count == 1)
+    {   // use the bounding box diagonal.
+        for (int c = 0; c < nch; ++c)
+        {
+            a[c] = mn[c]; b[c] = mx[c];
+        }
+        return;
+    }
+    float cov[4][4] = {};
+    for (int c = 0; c < nch; ++c)
+    {
+        mean[c] /= float(count);
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        float d[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int c = 0; c < nch; ++c)
+            d[c] = pts[i * 4 + c] - mean[c];
+        for (int r = 0; r < nch; ++r)
+            for (int c = r; c < nch; ++c)
+                cov[r][c] += d[r] * d[c];
+    }
+    for (int r = 0; r < nch; ++r)
+        for (int c = 0; c < r; ++c)
+            cov[r][c] = cov[c][r];
+
+    // power iteration, starting from the bounding box diagonal.
+    float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int c = 0; c < nch; ++c)
+        axis[c] = mx[c] - mn[c];
+    for (int iter = 0; iter < 6; ++iter)
+    {
+        float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float m = 0.0f;
+        for (int r = 0; r < nch; ++r)
+        {
+            for (int c = 0; c < nch; ++c)
+                next[r] += cov[r][c] * axis[c];
+            if (fabsf(next[r]) > m) m = fabsf(next[r]);
+        }
+        if (m < 1e-6f)
+            break;
+        for (int c = 0; c < nch; ++c)
+            axis[c] = next[c] / m;
+    }
+    float len2 = 0.0f;
+    for (int c = 0; c < nch; ++c)
+        len2 += axis[c] * axis[c];
+    if (len2 < 1e-12f)
+    {   // all points are the same.
+        for (int c = 0; c < nch; ++c)
+        {
+            a[c] = mean[c]; b[c] = mean[c];
+        }
+        return;
+    }
+    float tmin = FLT_MAX, tmax = -FLT_MAX;
+    for (int i = 0; i < count; ++i)
+    {
+        float t = 0.0f;
+        for (int c = 0; c < nch; ++c)
+            t += (pts[i * 4 + c] - mean[c]) * axis[c];
+        if (t < tmin) tmin = t;
+        if (t > tmax) tmax = t;
+    }
+    tmin /= len2; tmax /= len2;
+    for (int c = 0; c < nch; ++c)
+    {
+        a[c] = mean[c] + axis[c] * tmin;
+        b[c] = mean[c] + axis[c] * tmax;
+    }
+}
+
+/// @summary Solve for the pair of endpoints that minimizes the squared error for a fixed set of palette indices.
+/// @param pts The points, stored with a stride of four floats.
+/// @param index The palette index of each point.
+/// @param count The number of points.
+/// @param nch The number of channels, 3 or 4.
+/// @param weights The interpolation weight of each palette entry, out of 64.
+/// @param a On return, endpoint 0.
+/// @param b On return, endpoint 1.
+/// @return true if the endpoints were computed, or false if the system is singular.
+internal_function bool bc_refine_line(float const *pts, uint8_t const *index, int count, int nch, int const *weights, float *a, float *b)
+{
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < count; ++i)
+    {
+        float wb = float(weights[index[i]]) / 64.0f;
+        float wa = 1.0f - wb;
+        aa += wa * wa; bb += wb * wb; ab += wa * wb;
+        for (int c = 0; c < nch; ++c)
+        {
+            ax[c] += wa * pts[i * 4 + c];
+            bx[c] += wb * pts[i * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+    {   // all points map to the same index.
+        return false;
+    }
+    float inv = 1.0f / det;
+    for (int c = 0; c < nch; ++c)
+    {
+        a[c] = (ax[c] * bb - bx[c] * ab) * inv;
+        b[c] = (bx[c] * aa - ax[c] * ab) * inv;
+    }
+    return true;
+}
+
+/// @summary Expand a quantized BC7 endpoint component to eight bits.
+/// @param comp The quantized component.
+/// @param pbit The p-bit, or zero if the mode has no p-bits.
+/// @param bits The number of bits in comp.
+/// @param has_pbit Specify true if the mode has p-bits.
+/// @return The expanded component, in [0, 255].
+internal_function inline int bc7_unquantize(int comp, int pbit, int bits, bool has_pbit)
+{
+    int v = has_pbit ? ((comp << 1) | pbit) : comp;
+    int t = has_pbit ? bits + 1 : bits;
+    v   <<= (8 - t);
+    return v | (v >> t);
+}
+
+/// @summary Quantize one BC7 endpoint for a fixed p-bit value.
+/// @param v The endpoint components, in [0, 255].
+/// @param nch The number of channels to quantize, 3 or 4.
+/// @param info The BC7 mode.
+/// @param pbit The p-bit value, 0 or 1.
+/// @param comp On return, the quantized components.
+/// @return The squared quantization error.
+internal_function float bc7_quantize_endpoint(float const *v, int nch, bc7_mode_info_t const *info, int pbit, int *comp)
+{
+    bool  has_pbit = info->PBitType != BC7_PBIT_NONE;
+    float error    = 0.0f;
+    for (int c = 0; c < nch; ++c)
+    {
+        int   bits = (c < 3) ? info->ColorBits : info->AlphaBits;
+        int   cmax = (1 << bits) - 1;
+        int   tmax = has_pbit ? (1 << (bits + 1)) - 1 : cmax;
+        float x    = v[c] < 0.0f ? 0.0f : (v[c] > 255.0f ? 255.0f : v[c]);
+        float s    = x * float(tmax) / 255.0f;
+        int   g    = has_pbit ? int((s - float(pbit)) * 0.5f + 0.5f) : int(s + 0.5f);
+        int   best = 0;
+        float best_e = FLT_MAX;
+        for (int k = g - 1; k <= g + 1; ++k)
+        {
+            if (k < 0 || k > cmax) continue;
+            float e = float(bc7_unquantize(k, pbit, bits, has_pbit)) - x;
+            if (e * e < best_e) { best_e = e * e; best = k; }
+        }
+        comp[c] = best;
+        error  += best_e;
+    }
+    return error;
+}
+
+/// @summary Quantize both endpoints of a BC7 subset, selecting the p-bits that minimize the quantization error.
+/// @param a Endpoint 0, with components in [0, 255].
+/// @param b Endpoint 1, with components in [0, 255].
+/// @param info The BC7 mode.
+/// @param blk The candidate block to update.
+/// @param subset The zero-based subset index.
+internal_function void bc7_quantize_subset(float const *a, float const *b, bc7_mode_info_t const *info, bc7_block_t &blk, int subset)
+{
+    int nch = (info->AlphaBits > 0) ? 4 : 3;
+    if (info->PBitType == BC7_PBIT_NONE)
+    {
+        bc7_quantize_endpoint(a, nch, info, 0, blk.Comp[subset][0]);
+        bc7_quantize_endpoint(b, nch, info, 0, blk.Comp[subset][1]);
+        blk.PBit[subset][0] = blk.PBit[subset][1] = 0;
+    }
+    else if (info->PBitType == BC7_PBIT_SHARED)
+    {
+        int   ca[2][4], cb[2][4];
+        float e0 = bc7_quantize_endpoint(a, nch, info, 0, ca[0]) + bc7_quantize_endpoint(b, nch, info, 0, cb[0]);
+        float e1 = bc7_quantize_endpoint(a, nch, info, 1, ca[1]) + bc7_quantize_endpoint(b, nch, info, 1, cb[1]);
+        int   p  = (e1 < e0) ? 1 : 0;
+        memcpy(blk.Comp[subset][0], ca[p], sizeof(ca[p]));
+        memcpy(blk.Comp[subset][1], cb[p], sizeof(cb[p]));
+        blk.PBit[subset][0] = blk.PBit[subset][1] = p;
+    }
+    else
+    {
+        float const *ep[2] = { a, b };
+        for (int e = 0; e < 2; ++e)
+        {
+            int   c0[4], c1[4];
+            float e0 = bc7_quantize_endpoint(ep[e], nch, info, 0, c0);
+            float e1 = bc7_quantize_endpoint(ep[e], nch, info, 1, c1);
+            int   p  = (e1 < e0) ? 1 : 0;
+            memcpy(blk.Comp[subset][e], p ? c1 : c0, sizeof(c0));
+            blk.PBit[subset][e] = p;
+        }
+    }
+    if (nch == 3)
+    {   // modes without alpha always decode alpha as 255.
+        blk.Comp[subset][0][3] = blk.Comp[subset][1][3] = 0;
+    }
+}
+
+/// @summary Select the nearest palette entry for each pixel of a BC7 subset.
+/// @param block The 64-byte RGBA8 block.
+/// @param blk The candidate block to update.
+/// @param subset The zero-based subset index.
+/// @param mask A 16-bit mask of the pixels belonging to the subset.
+/// @return The sum of squared differences over the pixels of the subset.
+internal_function uint32_t bc7_select_indices(uint8_t const *block, bc7_block_t &blk, int subset, uint32_t mask)
+{
+    bc7_mode_info_t const *info = blk.Info;
+    bool        has_pbit = info->PBitType != BC7_PBIT_NONE;
+    int         nentries = 1 << info->IndexBits;
+    int const  *weights  = bc_weights(info->IndexBits);
+    int         e[2][4];
+    int         palette[16][4];
+    uint32_t    error    = 0;
+    for (int k = 0; k < 2; ++k)
+    {
+        for (int c = 0; c < 3; ++c)
+            e[k][c] = bc7_unquantize(blk.Comp[subset][k][c], blk.PBit[subset][k], info->ColorBits, has_pbit);
+        e[k][3] = (info->AlphaBits > 0) ? bc7_unquantize(blk.Comp[subset][k][3], blk.PBit[subset][k], info->AlphaBits, has_pbit) : 255;
+    }
+    for (int i = 0; i < nentries; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+            palette[i][c] = ((64 - weights[i]) * e[0][c] + weights[i] * e[1][c] + 32) >> 6;
+    }
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        if ((mask & (1U << i)) == 0)
+            continue;
+        uint8_t const *p = block + i * 4;
+        int best = 0, best_e = INT_MAX;
+        for (int k = 0; k < nentries; ++k)
+        {
+            int dr = p[0] - palette[k][0], dg = p[1] - palette[k][1];
+            int db = p[2] - palette[k][2], da = p[3] - palette[k][3];
+            int d  = dr * dr + dg * dg + db * db + da * da;
+            if (d < best_e) { best_e = d; best = k; }
+        }
+        blk.Index[i] = uint8_t(best);
+        error += uint32_t(best_e);
+    }
+    return error;
+}
+
+/// @summary Encode one subset of a BC7 block, optionally refining the endpoints with a least-squares fit.
+/// @param block The 64-byte RGBA8 block.
+/// @param blk The candidate block to update. The Info field must be set.
+/// @param subset The zero-based subset index.
+/// @param mask A 16-bit mask of the pixels belonging to the subset.
+/// @param quality One of image_encoder_quality_e.
+/// @param refine The number of least-squares refinement passes.
+/// @return The sum of squared differences over the pixels of the subset.
+internal_function uint32_t bc7_encode_subset(uint8_t const *block, bc7_block_t &blk, int subset, uint32_t mask, int quality, int refine)
+{
+    bc7_mode_info_t const *info = blk.Info;
+    int      nch   = (info->AlphaBits > 0) ? 4 : 3;
+    int      count = 0;
+    float    pts[BC_BLOCK_PIXELS * 4];
+    uint8_t  idx[BC_BLOCK_PIXELS];
+    float    a[4], b[4];
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        if (mask & (1U << i))
+        {
+            for (int c = 0; c < 4; ++c)
+                pts[count * 4 + c] = float(block[i * 4 + c]);
+            count++;
+        }
+    }
+    bc_fit_line(pts, count, nch, quality, a, b);
+    bc7_quantize_subset(a, b, info, blk, subset);
+    uint32_t error = bc7_select_indices(block, blk, subset, mask);
+    for (int iter  = 0; iter < refine && error > 0; ++iter)
+    {
+        bc7_block_t trial = blk;
+        for (int i = 0, n = 0; i < BC_BLOCK_PIXELS; ++i)
+        {
+            if (mask & (1U << i)) idx[n++] = blk.Index[i];
+        }
+        if (!bc_refine_line(pts, idx, count, nch, bc_weights(info->IndexBits), a, b))
+            break;
+        bc7_quantize_subset(a, b, info, trial, subset);
+        uint32_t trial_error = bc7_select_indices(block, trial, subset, mask);
+        if (trial_error >= error)
+            break;
+        blk   = trial;
+        error = trial_error;
+    }
+    return error;
+}
+
+/// @summary Encode a block using a given BC7 mode and partition.
+/// @param block The 64-byte RGBA8 block.
+/// @param info The BC7 mode.
+/// @param partition The two-subset partition index, or zero for single-subset modes.
+/// @param quality One of image_encoder_quality_e.
+/// @param refine The number of least-squares refinement passes.
+/// @param blk On return, the candidate encoding.
+internal_function void bc7_encode_mode(uint8_t const *block, bc7_mode_info_t const *info, int partition, int quality, int refine, bc7_block_t &blk)
+{
+    uint32_t mask1 = (info->SubsetCount > 1) ? BC7_PARTITION2[partition] : 0;
+    blk.Info       = info;
+    blk.Partition  = partition;
+    blk.Error      = bc7_encode_subset(block, blk, 0, ~mask1 & 0xFFFF, quality, refine);
+    if (info->SubsetCount > 1)
+    {
+        blk.Error += bc7_encode_subset(block, blk, 1, mask1, quality, refine);
+    }
+}
+
+/// @summary Write a candidate BC7 encoding to a 16-byte block, swapping endpoints as needed so the anchor indices have a zero high bit.
+/// @param blk The candidate encoding. The endpoints and indices may be modified.
+/// @param dst The 16-byte output block.
+internal_function void bc7_pack_block(bc7_block_t &blk, uint8_t *dst)
+{
+    bc7_mode_info_t const *info = blk.Info;
+    uint32_t mask1   = (info->SubsetCount > 1) ? BC7_PARTITION2[blk.Partition] : 0;
+    int      anchor[2] = { 0, (info->SubsetCount > 1) ? BC7_ANCHOR2[blk.Partition] : 0 };
+    int      high    = 1 << (info->IndexBits - 1);
+    int      imax    =(1 << info->IndexBits) - 1;
+    for (int s = 0; s < info->SubsetCount; ++s)
+    {
+        if (blk.Index[anchor[s]] & high)
+        {   // swap the endpoints of the subset, and invert its indices.
+            for (int c = 0; c < 4; ++c)
+            {
+                int t = blk.Comp[s][0][c]; blk.Comp[s][0][c] = blk.Comp[s][1][c]; blk.Comp[s][1][c] = t;
+            }
+            int t = blk.PBit[s][0]; blk.PBit[s][0] = blk.PBit[s][1]; blk.PBit[s][1] = t;
+            for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+            {
+                int pixel_subset = (mask1 >> i) & 1;
+                if (pixel_subset == s) blk.Index[i] = uint8_t(imax - blk.Index[i]);
+            }
+        }
+    }
+    bc_bit_writer_t w = { dst, 0 };
+    memset(dst, 0, 16);
+    bc_write_bits(w, 1U << info->Mode, uint32_t(info->Mode + 1));
+    bc_write_bits(w, uint32_t(blk.Partition), uint32_t(info->PartitionBits));
+    for (int c = 0; c < ((info->AlphaBits > 0) ? 4 : 3); ++c)
+    {
+        int bits = (c < 3) ? info->ColorBits : info->AlphaBits;
+        for (int s = 0; s < info->SubsetCount; ++s)
+        {
+            bc_write_bits(w, uint32_t(blk.Comp[s][0][c]), uint32_t(bits));
+            bc_write_bits(w, uint32_t(blk.Comp[s][1][c]), uint32_t(bits));
+        }
+    }
+    for (int s = 0; s < info->SubsetCount; ++s)
+    {
+        if (info->PBitType == BC7_PBIT_UNIQUE)
+        {
+            bc_write_bits(w, uint32_t(blk.PBit[s][0]), 1);
+            bc_write_bits(w, uint32_t(blk.PBit[s][1]), 1);
+        }
+        else if (info->PBitType == BC7_PBIT_SHARED)
+        {
+            bc_write_bits(w, uint32_t(blk.PBit[s][0]), 1);
+        }
+    }
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        bool is_anchor = (i == anchor[0]) || (info->SubsetCount > 1 && i == anchor[1]);
+        bc_write_bits(w, blk.Index[i], uint32_t(is_anchor ? info->IndexBits - 1 : info->IndexBits));
+    }
+}
+
+/// @summary Encode a block in the BC7 format. Fast and normal quality use mode 6 only; high quality searches all 64 partitions of the two-subset modes.
+/// @param block The 64-byte RGBA8 block.
+/// @param quality One of image_encoder_quality_e.
+/// @param dst The 16-byte output block.
+internal_function void bc_encode_bc7(uint8_t const *block, int quality, uint8_t *dst)
+{
+    int         refine = (quality == IMAGE_ENCODER_QUALITY_FAST) ? 0 : ((quality == IMAGE_ENCODER_QUALITY_NORMAL) ? 1 : BC_REFINE_ITERATIONS);
+    bc7_block_t best;
+    bc7_block_t trial;
+    bc7_encode_mode(block, &BC7_MODES[6], 0, quality, refine, best);
+    if (quality >= IMAGE_ENCODER_QUALITY_HIGH && best.Error > 0)
+    {   // search every partition of the two-subset modes without refinement, then refine the best.
+        int mn[4], mx[4];
+        bc_block_bounds(block, mn, mx);
+        bc7_mode_info_t const *modes[2] = { &BC7_MODES[1], &BC7_MODES[3] };
+        size_t                 nmodes   = 2;
+        if (mn[3] < 255)
+        {   // the block has alpha; only mode 7 has alpha and two subsets.
+            modes[0] = &BC7_MODES[7];
+            nmodes   = 1;
+        }
+        for (size_t m = 0; m < nmodes; ++m)
+        {
+            int      best_partition = 0;
+            uint32_t best_error     = UINT_MAX;
+            for (int p = 0; p < 64; ++p)
+            {
+                bc7_encode_mode(block, modes[m], p, quality, 0, trial);
+                if (trial.Error < best_error)
+                {
+                    best_error     = trial.Error;
+                    best_partition = p;
+                }
+            }
+            bc7_encode_mode(block, modes[m], best_partition, quality, refine, trial);
+            if (trial.Error < best.Error)
+            {
+                best = trial;
+            }
+        }
+    }
+    bc7_pack_block(best, dst);
+}
+
+/// @summary Expand a quantized BC6H endpoint component to 16 bits, for the unsigned format.
+/// @param comp The quantized component.
+/// @param bits The number of bits in comp.
+/// @return The unquantized component.
+internal_function inline int bc6h_unquantize(int comp, int bits)
+{
+    if (comp == 0) return 0;
+    if (comp == (1 << bits) - 1) return 0xFFFF;
+    return ((comp << 16) + 0x8000) >> bits;
+}
+
+/// @summary Convert a half-precision bit pattern to the unquantized BC6H domain, in which interpolation is performed.
+/// Negative values, infinity and NaN are not representable in the unsigned format and are clamped.
+/// @param h The half-precision bit pattern.
+/// @return The equivalent unquantized value.
+internal_function inline float bc6h_from_half(uint16_t h)
+{
+    if (h & 0x8000) return 0.0f;
+    if (h > 0x7BFF) h = 0x7BFF;
+    return float(h) * (64.0f / 31.0f);
+}
+
+/// @summary Quantize an unquantized BC6H value to a given number of bits.
+/// @param v The unquantized value.
+/// @param bits The number of bits.
+/// @return The quantized component whose unquantized value is nearest to v.
+internal_function int bc6h_quantize(float v, int bits)
+{
+    int   cmax = (1 << bits) - 1;
+    float x    = v < 0.0f ? 0.0f : (v > 65535.0f ? 65535.0f : v);
+    int   g    = int((x * float(1 << bits) - 32768.0f) / 65536.0f + 0.5f);
+    int   best = 0;
+    float best_e = FLT_MAX;
+    for (int k = g - 1; k <= g + 1; ++k)
+    {
+        if (k < 0 || k > cmax) continue;
+        float e = fabsf(float(bc6h_unquantize(k, bits)) - x);
+        if (e < best_e) { best_e = e; best = k; }
+    }
+    return best;
+}
+
+/// @summary Select the nearest palette entry for each pixel of a BC6H block.
+/// @param h The 16 pixels of the block, as half-precision RGB values with a stride of four.
+/// @param blk The candidate block to update.
+/// @return The sum of squared differences, in half-float units.
+internal_function uint64_t bc6h_select_indices(uint16_t const *h, bc6h_block_t &blk)
+{
+    int      bits = (blk.Mode == 11) ? 10 : 11;
+    int      palette[16][3];
+    uint64_t error = 0;
+    for (int k = 0; k < 16; ++k)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            int u0 = bc6h_unquantize(blk.Comp[0][c], bits);
+            int u1 = bc6h_unquantize(blk.Comp[1][c], bits);
+            palette[k][c] = ((((64 - BC_WEIGHTS4[k]) * u0 + BC_WEIGHTS4[k] * u1 + 32) >> 6) * 31) >> 6;
+        }
+    }
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        int v[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            uint16_t x = h[i * 4 + c];
+            v[c] = (x & 0x8000) ? 0 : (x > 0x7BFF ? 0x7BFF : x);
+        }
+        int64_t best_e = INT64_MAX; int best = 0;
+        for (int k = 0; k < 16; ++k)
+        {
+            int64_t dr = v[0] - palette[k][0], dg = v[1] - palette[k][1], db = v[2] - palette[k][2];
+            int64_t d  = dr * dr + dg * dg + db * db;
+            if (d < best_e) { best_e = d; best = k; }
+        }
+        blk.Index[i] = uint8_t(best);
+        error += uint64_t(best_e);
+    }
+    return error;
+}
+
+/// @summary Quantize a pair of endpoints for a BC6H single-region mode. Mode 12 stores endpoint 1 as a 9-bit delta from endpoint 0.
+/// @param a Endpoint 0, in the unquantized domain.
+/// @param b Endpoint 1, in the unquantized domain.
+/// @param blk The candidate block to update. The Mode field must be set.
+internal_function void bc6h_quantize_endpoints(float const *a, float const *b, bc6h_block_t &blk)
+{
+    int bits = (blk.Mode == 11) ? 10 : 11;
+    for (int c = 0; c < 3; ++c)
+    {
+        blk.Comp[0][c] = bc6h_quantize(a[c], bits);
+        blk.Comp[1][c] = bc6h_quantize(b[c], bits);
+        if (blk.Mode == 12)
+        {   // clamp endpoint 1 to the range of the delta.
+            int d = blk.Comp[1][c] - blk.Comp[0][c];
+            if (d < -256) blk.Comp[1][c] = blk.Comp[0][c] - 256;
+            if (d >  255) blk.Comp[1][c] = blk.Comp[0][c] + 255;
+            if (blk.Comp[1][c] < 0) blk.Comp[1][c] = 0;
+            if (blk.Comp[1][c] > 2047) blk.Comp[1][c] = 2047;
+        }
+    }
+}
+
+/// @summary Encode a block using a BC6H single-region mode.
+/// @param h The 16 pixels of the block, as half-precision RGBA values.
+/// @param mode The BC6H mode, 11 (10-bit endpoints) or 12 (11-bit endpoint and 9-bit delta.)
+/// @param quality One of image_encoder_quality_e.
+/// @param refine The number of least-squares refinement passes.
+/// @param blk On return, the candidate encoding.
+internal_function void bc6h_encode_mode(uint16_t const *h, int mode, int quality, int refine, bc6h_block_t &blk)
+{
+    float pts[BC_BLOCK_PIXELS * 4];
+    float a[4], b[4];
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            pts[i * 4 + c] = bc6h_from_half(h[i * 4 + c]);
+        pts[i * 4 + 3] = 0.0f;
+    }
+    bc_fit_line(pts, BC_BLOCK_PIXELS, 3, quality, a, b);
+    blk.Mode  = mode;
+    bc6h_quantize_endpoints(a, b, blk);
+    blk.Error = bc6h_select_indices(h, blk);
+    for (int iter = 0; iter < refine && blk.Error > 0; ++iter)
+    {
+        bc6h_block_t trial = blk;
+        if (!bc_refine_line(pts, blk.Index, BC_BLOCK_PIXELS, 3, BC_WEIGHTS4, a, b))
+            break;
+        bc6h_quantize_endpoints(a, b, trial);
+        trial.Error = bc6h_select_indices(h, trial);
+        if (trial.Error >= blk.Error)
+            break;
+        blk = trial;
+    }
+    if (blk.Index[0] & 8)
+    {   // the anchor index must have a zero high bit; swap the endpoints and invert the indices.
+        for (int c = 0; c < 3; ++c)
+        {
+            int t = blk.Comp[0][c]; blk.Comp[0][c] = blk.Comp[1][c]; blk.Comp[1][c] = t;
+            if (mode == 12 && blk.Comp[1][c] - blk.Comp[0][c] > 255)
+            {   // the swapped delta is out of range; this mode can't represent the block.
+                blk.Error = UINT64_MAX;
+            }
+        }
+        for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+        {
+            blk.Index[i] = uint8_t(15 - blk.Index[i]);
+        }
+    }
+}
+
+/// @summary Encode a block in the BC6H unsigned format. Only the single-region modes 11 and 12 are generated; high quality tries both.
+/// @param h The 16 pixels of the block, as half-precision RGBA values. Alpha is ignored.
+/// @param quality One of image_encoder_quality_e.
+/// @param dst The 16-byte output block.
+internal_function void bc_encode_bc6h(uint16_t const *h, int quality, uint8_t *dst)
+{
+    int          refine = (quality == IMAGE_ENCODER_QUALITY_FAST) ? 0 : ((quality == IMAGE_ENCODER_QUALITY_NORMAL) ? 1 : BC_REFINE_ITERATIONS);
+    bc6h_block_t best;
+    bc6h_encode_mode(h, 11, quality, refine, best);
+    if (quality >= IMAGE_ENCODER_QUALITY_HIGH && best.Error > 0)
+    {   // the transformed mode has more precision when the endpoints are close together.
+        bc6h_block_t trial;
+        bc6h_encode_mode(h, 12, quality, refine, trial);
+        if (trial.Error < best.Error) best = trial;
+    }
+    bc_bit_writer_t w = { dst, 0 };
+    memset(dst, 0, 16);
+    if (best.Mode == 11)
+    {
+        bc_write_bits(w, 0x03, 5);
+        for (int c = 0; c < 3; ++c) bc_write_bits(w, uint32_t(best.Comp[0][c]), 10);
+        for (int c = 0; c < 3; ++c) bc_write_bits(w, uint32_t(best.Comp[1][c]), 10);
+    }
+    else
+    {
+        bc_write_bits(w, 0x07, 5);
+        for (int c = 0; c < 3; ++c) bc_write_bits(w, uint32_t(best.Comp[0][c]), 10);
+        for (int c = 0; c < 3; ++c)
+        {   // the delta is followed by the high bit of the base endpoint.
+            bc_write_bits(w, uint32_t(best.Comp[1][c] - best.Comp[0][c]) & 0x1FF, 9);
+            bc_write_bits(w, uint32_t(best.Comp[0][c]) >> 10, 1);
+        }
+    }
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        bc_write_bits(w, best.Index[i], (i == 0) ? 3 : 4);
+    }
+}
+
+/// @summary Load one block of half or single-precision RGBA pixels, replicating edge pixels to fill partial blocks.
+/// @param src The address of the first pixel of the first row of the block row.
+/// @param src_pitch The number of bytes between source rows.
+/// @param x The x-coordinate of the left edge of the block, in pixels.
+/// @param width The width of the source image, in pixels.
+/// @param height The number of valid rows in the block row, in [1, 4].
+/// @param src_format Either DXGI_FORMAT_R16G16B16A16_FLOAT or DXGI_FORMAT_R32G32B32A32_FLOAT.
+/// @param block On return, the sixteen RGBA16F pixels of the block.
+internal_function void bc_load_block_hdr(uint8_t const *src, size_t src_pitch, size_t x, size_t width, size_t height, uint32_t src_format, uint16_t *block)
+{
+    for (size_t row = 0; row < BC_BLOCK_DIMENSION; ++row)
+    {
+        uint8_t const *rowp = src + ((row < height) ? row : height - 1) * src_pitch;
+        for (size_t i = 0; i < BC_BLOCK_DIMENSION; ++i)
+        {
+            size_t    sx  = (x + i < width) ? x + i : width - 1;
+            uint16_t *dst = block + (row * BC_BLOCK_DIMENSION + i) * 4;
+            if (src_format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+            {
+                memcpy(dst, rowp + sx * 8, 8);
+            }
+            else
+            {
+                float const *p = (float const*)(rowp + sx * 16);
+                for (size_t c = 0; c < 4; ++c)
+                    dst[c] = image_float_to_half(p[c]);
+            }
+        }
+    }
+}
+
+/// @summary Initialize a bit reader to read from the start of a packed block.
+/// @param r The bit reader to initialize.
+/// @param src The 16-byte block.
+internal_function inline void bc_bit_reader_init(bc_bit_reader_t &r, uint8_t const *src)
+{
+    memcpy(r.Bits, src, 16);
+    r.BitPos = 0;
+}
+
+/// @summary Read a value from a packed block.
+/// @param r The bit reader.
+/// @param count The number of bits to read, in [0, 32].
+/// @return The value, with the first bit read stored in bit 0.
+internal_function inline uint32_t bc_read_bits(bc_bit_reader_t &r, uint32_t count)
+{
+    uint32_t pos = r.BitPos;
+    uint64_t v;
+    if (pos >= 64) v = r.Bits[1] >> (pos - 64);
+    else if (pos == 0) v = r.Bits[0];
+    else v = (r.Bits[0] >> pos) | (r.Bits[1] << (64 - pos));
+    r.BitPos += count;
+    return uint32_t(v & ((uint64_t(1) << count) - 1));
+}
+
+/// @summary Interpolate between two RGBA8 endpoints, computing all four channels at once.
+/// @param e0 The first endpoint, as four 16-bit lanes in [0, 255].
+/// @param e1 The second endpoint, as four 16-bit lanes in [0, 255].
+/// @param weight The weight of the second endpoint, out of 64.
+/// @return The interpolated RGBA8 value, packed into 32 bits.
+internal_function inline uint32_t bc_interpolate_rgba(__m128i e0, __m128i e1, int weight)
+{
+    __m128i w1 = _mm_set1_epi16(short(weight));
+    __m128i w0 = _mm_set1_epi16(short(64 - weight));
+    __m128i v  = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(e0, w0), _mm_mullo_epi16(e1, w1)), _mm_set1_epi16(32));
+    v = _mm_srli_epi16(v, 6);
+    return uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(v, v)));
+}
+
+/// @summary Decode the color portion of a BC1, BC2 or BC3 block.
+/// @param src The 8-byte color block.
+/// @param allow_transparent Specify true for BC1, which selects the three-color mode when endpoint 0 is not greater than endpoint 1.
+/// @param block On return, the sixteen RGBA8 pixels of the block. The alpha channel is set to 255 (or 0 for transparent BC1 pixels.)
+internal_function void bc_decode_color(uint8_t const *src, bool allow_transparent, uint8_t *block)
+{
+    uint32_t c0 = uint32_t(src[0]) | (uint32_t(src[1]) << 8);
+    uint32_t c1 = uint32_t(src[2]) | (uint32_t(src[3]) << 8);
+    uint32_t bits = uint32_t(src[4]) | (uint32_t(src[5]) << 8) | (uint32_t(src[6]) << 16) | (uint32_t(src[7]) << 24);
+    int      rgb0[3], rgb1[3];
+    bc_unpack565(c0, rgb0);
+    bc_unpack565(c1, rgb1);
+    // lanes 0-3 hold endpoint 0, and lanes 4-7 hold endpoint 1.
+    __m128i  e   = _mm_setr_epi16(short(rgb0[0]), short(rgb0[1]), short(rgb0[2]), 255, short(rgb1[0]), short(rgb1[1]), short(rgb1[2]), 255);
+    __m128i  e10 = _mm_shuffle_epi32(e, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i  p23;
+    if (c0 > c1 || !allow_transparent)
+    {   // four-color mode; p2 = (2*c0 + c1) / 3 and p3 = (c0 + 2*c1) / 3.
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(e, e), e10);
+        p23 = _mm_mulhi_epu16(sum, _mm_set1_epi16(short(21846)));
+    }
+    else
+    {   // three-color mode; p2 = (c0 + c1) / 2 and p3 = transparent black.
+        __m128i avg = _mm_srli_epi16(_mm_add_epi16(e, e10), 1);
+        p23 = _mm_unpacklo_epi64(avg, _mm_setzero_si128());
+    }
+    uint32_t palette[4];
+    _mm_storeu_si128((__m128i*) palette, _mm_packus_epi16(e, p23));
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        memcpy(block + i * 4, &palette[(bits >> (i * 2)) & 3], sizeof(uint32_t));
+    }
+}
+
+/// @summary Decode a BC3, BC4 or BC5 interpolated alpha block into one channel of an RGBA8 block.
+/// @param src The 8-byte alpha block.
+/// @param channel The zero-based index of the channel to write, in [0, 3].
+/// @param block The sixteen RGBA8 pixels of the block. Only the specified channel is modified.
+internal_function void bc_decode_alpha(uint8_t const *src, int channel, uint8_t *block)
+{
+    uint64_t bits = 0;
+    int      palette[8];
+    bc_alpha_palette(src[0], src[1], palette);
+    for (int i = 0; i < 6; ++i)
+    {
+        bits |= uint64_t(src[i + 2]) << (i * 8);
+    }
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        block[i * 4 + channel] = uint8_t(palette[(bits >> (i * 3)) & 7]);
+    }
+}
+
+/// @summary Decode a BC2 explicit alpha block into the alpha channel of an RGBA8 block.
+/// @param src The 8-byte alpha block.
+/// @param block The sixteen RGBA8 pixels of the block. Only the alpha channel is modified.
+internal_function void bc_decode_explicit_alpha(uint8_t const *src, uint8_t *block)
+{
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        int a = (src[i >> 1] >> ((i & 1) * 4)) & 0xF;
+        block[i * 4 + 3] = uint8_t(a * 17);
+    }
+}
+
+/// @summary Decode a BC7 block. Blocks with a reserved mode decode to transparent black.
+/// @param src The 16-byte BC7 block.
+/// @param block On return, the sixteen RGBA8 pixels of the block.
+internal_function void bc_decode_bc7(uint8_t const *src, uint8_t *block)
+{
+    bc_bit_reader_t r;
+    int mode = 0;
+    bc_bit_reader_init(r, src);
+    while (mode < 8 && bc_read_bits(r, 1) == 0)
+    {
+        mode++;
+    }
+    if (mode == 8)
+    {   // reserved mode.
+        memset(block, 0, BC_BLOCK_RGBA_SIZE);
+        return;
+    }
+    bc7_mode_info_t const *info     = &BC7_MODES[mode];
+    bool                   has_pbit = info->PBitType != BC7_PBIT_NONE;
+    int                    ns       = info->SubsetCount;
+    int                    part     = int(bc_read_bits(r, uint32_t(info->PartitionBits)));
+    int                    rotation = int(bc_read_bits(r, uint32_t(info->RotationBits)));
+    int                    selector = int(bc_read_bits(r, uint32_t(info->SelectorBits)));
+    int                    comp[3][2][4];
+    int                    pbit[3][2] = {};
+    for (int c = 0; c < 4; ++c)
+    {
+        int bits = (c < 3) ? info->ColorBits : info->AlphaBits;
+        for (int s = 0; s < ns; ++s)
+        {
+            comp[s][0][c] = int(bc_read_bits(r, uint32_t(bits)));
+            comp[s][1][c] = int(bc_read_bits(r, uint32_t(bits)));
+        }
+    }
+    for (int s = 0; s < ns; ++s)
+    {
+        if (info->PBitType == BC7_PBIT_UNIQUE)
+        {
+            pbit[s][0] = int(bc_read_bits(r, 1));
+            pbit[s][1] = int(bc_read_bits(r, 1));
+        }
+        else if (info->PBitType == BC7_PBIT_SHARED)
+        {
+            pbit[s][0] = pbit[s][1] = int(bc_read_bits(r, 1));
+        }
+    }
+    __m128i endpoint[3][2];
+    for (int s = 0; s < ns; ++s)
+    {
+        for (int e = 0; e < 2; ++e)
+        {
+            int v[4];
+            for (int c = 0; c < 3; ++c)
+                v[c] = bc7_unquantize(comp[s][e][c], pbit[s][e], info->ColorBits, has_pbit);
+            v[3] = (info->AlphaBits > 0) ? bc7_unquantize(comp[s][e][3], pbit[s][e], info->AlphaBits, has_pbit) : 255;
+            endpoint[s][e] = _mm_setr_epi16(short(v[0]), short(v[1]), short(v[2]), short(v[3]), 0, 0, 0, 0);
+        }
+    }
+    // determine the subset and anchor status of each pixel.
+    uint8_t subset[BC_BLOCK_PIXELS];
+    uint8_t anchor[BC_BLOCK_PIXELS] = {};
+    anchor[0] = 1;
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        if (ns == 1) subset[i] = 0;
+        else if (ns == 2) subset[i] = uint8_t((BC7_PARTITION2[part] >> i) & 1);
+        else subset[i] = uint8_t((BC7_PARTITION3[part] >> (i * 2)) & 3);
+    }
+    if (ns == 2) anchor[BC7_ANCHOR2[part]] = 1;
+    if (ns == 3) anchor[BC7_ANCHOR3[part][0]] = anchor[BC7_ANCHOR3[part][1]] = 1;
+
+    uint8_t index[BC_BLOCK_PIXELS];
+    uint8_t index2[BC_BLOCK_PIXELS];
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        index[i] = uint8_t(bc_read_bits(r, uint32_t(anchor[i] ? info->IndexBits - 1 : info->IndexBits)));
+    }
+    if (info->IndexBits2 > 0)
+    {   // modes 4 and 5 have a second index set; only pixel 0 is an anchor.
+        for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+            index2[i] = uint8_t(bc_read_bits(r, uint32_t(i == 0 ? info->IndexBits2 - 1 : info->IndexBits2)));
+    }
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        __m128i  e0 = endpoint[subset[i]][0];
+        __m128i  e1 = endpoint[subset[i]][1];
+        uint32_t px;
+        if (info->IndexBits2 == 0)
+        {   // one index set for all channels.
+            px = bc_interpolate_rgba(e0, e1, bc_weights(info->IndexBits)[index[i]]);
+        }
+        else
+        {   // color and alpha are interpolated separately. the selector swaps the index sets.
+            int      cw = selector ? bc_weights(info->IndexBits2)[index2[i]] : bc_weights(info->IndexBits)[index[i]];
+            int      aw = selector ? bc_weights(info->IndexBits)[index[i]] : bc_weights(info->IndexBits2)[index2[i]];
+            uint32_t c  = bc_interpolate_rgba(e0, e1, cw);
+            uint32_t a  = bc_interpolate_rgba(e0, e1, aw);
+            px = (c & 0x00FFFFFFU) | (a & 0xFF000000U);
+        }
+        uint8_t *p = block + i * 4;
+        memcpy(p, &px, sizeof(uint32_t));
+        if (rotation > 0)
+        {   // swap alpha with the rotated channel.
+            uint8_t t = p[3]; p[3] = p[rotation - 1]; p[rotation - 1] = t;
+        }
+    }
+}
+
+/// @summary Expand a quantized BC6H endpoint component to 16 bits.
+/// @param comp The quantized component. Signed for BC6H_SF16.
+/// @param bits The number of bits in the endpoint.
+/// @param is_signed Specify true for BC6H_SF16.
+/// @return The unquantized component.
+internal_function inline int bc6h_unquantize_any(int comp, int bits, bool is_signed)
+{
+    if (!is_signed)
+    {
+        if (bits >= 15) return comp;
+        return bc6h_unquantize(comp, bits);
+    }
+    if (bits >= 16) return comp;
+    int  mag = comp < 0 ? -comp : comp;
+    int  unq;
+    if (mag == 0) unq = 0;
+    else if (mag >= ((1 << (bits - 1)) - 1)) unq = 0x7FFF;
+    else unq = ((mag << 15) + 0x4000) >> (bits - 1);
+    return comp < 0 ? -unq : unq;
+}
+
+/// @summary Sign-extend a value stored in a given number of bits.
+/// @param v The value.
+/// @param bits The number of bits in the value.
+/// @return The sign-extended value.
+internal_function inline int bc_sign_extend(int v, int bits)
+{
+    int m = 1 << (bits - 1);
+    v    &=(1 << bits) - 1;
+    return (v ^ m) - m;
+}
+
+/// @summary Decode a BC6H block. Blocks with a reserved mode decode to black.
+/// @param src The 16-byte BC6H block.
+/// @param is_signed Specify true for BC6H_SF16, or false for BC6H_UF16.
+/// @param block On return, the sixteen RGBA16F pixels of the block. Alpha is set to 1.0.
+internal_function void bc_decode_bc6h(uint8_t const *src, bool is_signed, uint16_t *block)
+{
+    bc_bit_reader_t         r;
+    bc6h_mode_desc_t const *desc = NULL;
+    bc_bit_reader_init(r, src);
+    uint32_t                mode = bc_read_bits(r, 2);
+    if (mode > 1)
+    {   // modes 3 through 14 use five mode bits.
+        mode |= bc_read_bits(r, 3) << 2;
+    }
+    for (size_t i = 0; i < 14; ++i)
+    {
+        if (BC6H_MODES[i].Mode == mode)
+        {
+            desc = &BC6H_MODES[i];
+            break;
+        }
+    }
+    if (desc == NULL)
+    {   // reserved mode.
+        for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+        {
+            block[i * 4 + 0] = block[i * 4 + 1] = block[i * 4 + 2] = 0;
+            block[i * 4 + 3] = 0x3C00;
+        }
+        return;
+    }
+    int field[13] = {};
+    for (size_t i = 0; desc->Fields[i].Count > 0; ++i)
+    {
+        bc6h_field_t const &f = desc->Fields[i];
+        field[f.Field] |= int(bc_read_bits(r, f.Count) << f.Shift);
+    }
+    int epb = desc->EndpointBits;
+    int nep = desc->Regions * 2;
+    int e[4][3];
+    for (int k = 0; k < nep; ++k)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            int v = field[k * 3 + c];
+            if (k == 0 || !desc->Transformed)
+            {   // stored as an absolute value.
+                if (is_signed) v = bc_sign_extend(v, k == 0 ? epb : desc->DeltaBits[c]);
+            }
+            else
+            {   // stored as a signed delta from endpoint W.
+                v = field[c] + bc_sign_extend(v, desc->DeltaBits[c]);
+                v = is_signed ? bc_sign_extend(v, epb) : (v & ((1 << epb) - 1));
+            }
+            e[k][c] = bc6h_unquantize_any(v, epb, is_signed);
+        }
+    }
+    int        part    = field[BC6H_D];
+    int        ibits   = (desc->Regions == 2) ? 3 : 4;
+    int const *weights = bc_weights(ibits);
+    for (int i = 0; i < BC_BLOCK_PIXELS; ++i)
+    {
+        int  region = (desc->Regions == 2) ? int((BC7_PARTITION2[part] >> i) & 1) : 0;
+        bool anchor = (i == 0) || (desc->Regions == 2 && i == BC7_ANCHOR2[part]);
+        int  w      = weights[bc_read_bits(r, uint32_t(anchor ? ibits - 1 : ibits))];
+        for (int c = 0; c < 3; ++c)
+        {
+            int v = ((64 - w) * e[region * 2][c] + w * e[region * 2 + 1][c] + 32) >> 6;
+            if (is_signed)
+            {   // scale the magnitude by 31/32 and rebuild the sign-magnitude half.
+                v = (v < 0) ? (0x8000 | (((-v) * 31) >> 5)) : ((v * 31) >> 5);
+            }
+            else v = (v * 31) >> 6;
+            block[i * 4 + c] = uint16_t(v);
+        }
+        block[i * 4 + 3] = 0x3C00;
+    }
+}
+
+/// @summary Decode a single block of any supported block-compressed format.
+/// @param format One of dxgi_format_e specifying the block-compressed format.
+/// @param src The compressed block.
+/// @param block On return, the sixteen decoded pixels: RGBA16F for BC6H, and RGBA8 for all other formats.
+/// @return true if the format is supported.
+internal_function bool bc_decode_any(uint32_t format, uint8_t const *src, void *block)
+{
+    uint8_t *rgba = (uint8_t*) block;
+    switch (format)
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            bc_decode_color(src, true, rgba);
+            return true;
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+            bc_decode_color(src + 8, false, rgba);
+            bc_decode_explicit_alpha(src, rgba);
+            return true;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            bc_decode_color(src + 8, false, rgba);
+            bc_decode_alpha(src, 3, rgba);
+            return true;
+        case DXGI_FORMAT_BC4_UNORM:
+            memset(rgba, 0, BC_BLOCK_RGBA_SIZE);
+            bc_decode_alpha(src, 0, rgba);
+            for (int i = 0; i < BC_BLOCK_PIXELS; ++i) rgba[i * 4 + 3] = 255;
+            return true;
+        case DXGI_FORMAT_BC5_UNORM:
+            memset(rgba, 0, BC_BLOCK_RGBA_SIZE);
+            bc_decode_alpha(src, 0, rgba);
+            bc_decode_alpha(src + 8, 1, rgba);
+            for (int i = 0; i < BC_BLOCK_PIXELS; ++i) rgba[i * 4 + 3] = 255;
+            return true;
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+            bc_decode_bc6h(src, format == DXGI_FORMAT_BC6H_SF16, (uint16_t*) block);
+            return true;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            bc_decode_bc7(src, rgba);
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+/// @summary Copy part of one row of a decoded block to the output, converting to the output format.
+/// @param block The decoded block: RGBA16F if hdr is true, otherwise RGBA8.
+/// @param hdr Specify true if the block contains RGBA16F pixels.
+/// @param row The zero-based row within the block, in [0, 3].
+/// @param x0 The first column to copy, in [0, 3].
+/// @param count The number of pixels to copy, in [1, 4 - x0].
+/// @param dst_format One of DXGI_FORMAT_R8G8B8A8_UNORM[_SRGB], DXGI_FORMAT_B8G8R8A8_UNORM[_SRGB] or DXGI_FORMAT_R16G16B16A16_FLOAT.
+/// @param dst The address of the first output pixel.
+internal_function inline void bc_store_block_row(void const *block, bool hdr, size_t row, size_t x0, size_t count, uint32_t dst_format, uint8_t *dst)
+{
+    if (hdr)
+    {   // BC6H output is always RGBA16F.
+        memcpy(dst, (uint8_t const*) block + (row * 4 + x0) * 8, count * 8);
+        return;
+    }
+    uint8_t const *src = (uint8_t const*) block + (row * 4 + x0) * 4;
+    switch (dst_format)
+    {
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            {
+                uint8_t px[16];
+                _mm_storeu_si128((__m128i*) px, bc_swap_rb(_mm_loadu_si128((__m128i const*)((uint8_t const*) block + row * 16))));
+                memcpy(dst, px + x0 * 4, count * 4);
+            }
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            {
+                uint16_t *h = (uint16_t*) dst;
+                for (size_t i = 0; i < count * 4; ++i)
+                    h[i] = image_float_to_half(float(src[i]) * (1.0f / 255.0f));
+            }
+            break;
+        default:
+            memcpy(dst, src, count * 4);
+            break;
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Determine the block-compressed format produced when encoding source data of a given format.
+/// @param src_format One of dxgi_format_e specifying the source data format. BC6H requires an R16G16B16A16_FLOAT or R32G32B32A32_FLOAT source; the other formats require an RGBA8 or BGRA8 source.
+/// @param dst_format One of dxgi_format_e specifying the requested target format. One of BC1, BC3, BC4, BC5, BC6H_UF16 or BC7.
+/// @return The target format, or DXGI_FORMAT_UNKNOWN if the conversion is not supported. The sRGB variant of BC1, BC3 or BC7 is returned for sRGB sources.
+public_function uint32_t bc_encoder_target_format(uint32_t src_format, uint32_t dst_format)
+{
+    bool srgb = false;
+    switch (src_format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+            srgb = false;
+            break;
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            srgb = true;
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return (dst_format == DXGI_FORMAT_BC6H_UF16) ? DXGI_FORMAT_BC6H_UF16 : DXGI_FORMAT_UNKNOWN;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+    }
+    switch (dst_format)
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+        case DXGI_FORMAT_BC4_UNORM:
+            return DXGI_FORMAT_BC4_UNORM;
+        case DXGI_FORMAT_BC5_UNORM:
+            return DXGI_FORMAT_BC5_UNORM;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+        default:
+            break;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+/// @summary Compress a single 4x4 block of pixels. BC4 encodes the red channel, and BC5 encodes the red and green channels.
+/// @param format One of DXGI_FORMAT_BC1_UNORM[_SRGB], DXGI_FORMAT_BC3_UNORM[_SRGB], DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC6H_UF16 or DXGI_FORMAT_BC7_UNORM[_SRGB].
+/// @param pixels The sixteen pixels of the block, in row-major order. RGBA16F for BC6H, and RGBA8 for all other formats.
+/// @param dst The output block.
+/// @param quality One of image_encoder_quality_e.
+/// @return The number of bytes written to dst (8 or 16), or zero if the format is not supported.
+public_function size_t bc_encode_block(uint32_t format, void const *pixels, void *dst, int quality)
+{
+    uint8_t const *block = (uint8_t const*) pixels;
+    uint8_t       *out   = (uint8_t*) dst;
+    switch (format)
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            bc_encode_color(block, true , quality, out);
+            return 8;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            bc_encode_alpha(block, 3, quality, out);
+            bc_encode_color(block, false, quality, out + 8);
+            return 16;
+        case DXGI_FORMAT_BC4_UNORM:
+            bc_encode_alpha(block, 0, quality, out);
+            return 8;
+        case DXGI_FORMAT_BC5_UNORM:
+            bc_encode_alpha(block, 0, quality, out);
+            bc_encode_alpha(block, 1, quality, out + 8);
+            return 16;
+        case DXGI_FORMAT_BC6H_UF16:
+            bc_encode_bc6h((uint16_t const*) pixels, quality, out);
+            return 16;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            bc_encode_bc7(block, quality, out);
+            return 16;
+        default:
+            break;
+    }
+    return 0;
+}
+
+/// @summary Compress one row of blocks from up to four rows of source data.
+/// Partial blocks at the right and bottom edges are padded by replicating the edge pixels.
+/// @param format The target block-compressed format. See bc_encode_block().
+/// @param quality One of image_encoder_quality_e.
+/// @param src_format The source data format. See bc_encoder_target_format().
+/// @param src The address of the first pixel of the first source row.
+/// @param src_pitch The number of bytes between source rows.
+/// @param width The width of the source image, in pixels.
+/// @param height The number of source rows available, in [1, 4].
+/// @param dst The output buffer, which must hold (width + 3) / 4 blocks.
+/// @return The number of bytes written to dst, or zero if the format is not supported.
+public_function size_t bc_encode_block_row(uint32_t format, int quality, uint32_t src_format, void const *src, size_t src_pitch, size_t width, size_t height, void *dst)
+{
+    uint8_t const *srcp    = (uint8_t const*) src;
+    uint8_t       *dstp    = (uint8_t*) dst;
+    size_t         total   = 0;
+    bool           hdr     = (src_format == DXGI_FORMAT_R16G16B16A16_FLOAT || src_format == DXGI_FORMAT_R32G32B32A32_FLOAT);
+    bool           swap_rb = (src_format == DXGI_FORMAT_B8G8R8A8_UNORM     || src_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+    uint16_t       block[BC_BLOCK_PIXELS * 4];
+    for (size_t x = 0; x < width; x += BC_BLOCK_DIMENSION)
+    {
+        if (hdr) bc_load_block_hdr(srcp, src_pitch, x, width, height, src_format, block);
+        else bc_load_block(srcp, src_pitch, x, width, height, swap_rb, (uint8_t*) block);
+        size_t n = bc_encode_block(format, block, dstp + total, quality);
+        if (n == 0) return 0;
+        total += n;
+    }
+    return total;
+}
+
+/// @summary Measure the throughput of the block-compression encoder on a synthetic image containing smooth gradients, noise and hard edges.
+/// @param format The target block-compressed format. See bc_encode_block(). BC6H is measured with an RGBA16F source, and all other formats with an RGBA8 source.
+/// @param quality One of image_encoder_quality_e.
+/// @param width The width of the synthetic image, in pixels.
+/// @param height The height of the synthetic image, in pixels.
+/// @param iterations The number of times to encode the image.
+/// @return The encoder throughput, in millions of source pixels per-second, or zero if the format is not supported or memory allocation fails.
+public_function double bc_encoder_benchmark(uint32_t format, int quality, size_t width, size_t height, size_t iterations)
+{
+    bool     hdr       = (format == DXGI_FORMAT_BC6H_UF16);
+    uint32_t src_format=  hdr ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+    size_t   src_pitch =  width * (hdr ? 8 : 4);
+    size_t   dst_pitch =((width + 3) / 4) * 16;
+    uint8_t *src       =(uint8_t*) malloc(src_pitch * height);
+    uint8_t *dst       =(uint8_t*) malloc(dst_pitch);
+    uint32_t seed      = 0x2545F491U;
+    double   rate      = 0.0;
+    if (src == NULL || dst == NULL || width == 0 || height == 0 || iterations == 0)
+    {   // nothing to measure.
+        free(dst); free(src);
+        return 0.0;
+    }
+    for (size_t y = 0; y < height; ++y)
+    {
+        uint8_t *row = src + y * src_pitch;
+        for (size_t x = 0; x < width; ++x)
+        {
+            seed = seed * 1664525U + 1013904223U;
+            uint32_t noise = (seed >> 24) & 15;
+            uint8_t  rgba[4];
+            rgba[0] = uint8_t((x * 255) / width);
+            rgba[1] = uint8_t(((y * 255) / height + noise) & 0xFF);
+            rgba[2] = uint8_t(((x / 16 + y / 16) & 1) ? 224 : 32);
+            rgba[3] = uint8_t(((x + y) * 4) & 0xFF);
+            if (hdr)
+            {   // scale into [0, 16] to exercise the high-dynamic-range encoding.
+                uint16_t *h = (uint16_t*)(row + x * 8);
+                for (size_t c = 0; c < 4; ++c)
+                    h[c] = image_float_to_half(float(rgba[c]) / 16.0f);
+            }
+            else memcpy(row + x * 4, rgba, 4);
+        }
+    }
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        for (size_t y = 0; y < height; y += BC_BLOCK_DIMENSION)
+        {
+            size_t rows = (height - y) < BC_BLOCK_DIMENSION ? (height - y) : BC_BLOCK_DIMENSION;
+            if (bc_encode_block_row(format, quality, src_format, src + y * src_pitch, src_pitch, width, rows, dst) == 0)
+            {   // the format is not supported.
+                free(dst); free(src);
+                return 0.0;
+            }
+        }
+    }
+    QueryPerformanceCounter(&end);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(frequency.QuadPart);
+    if (seconds > 0.0)
+    {
+        rate = (double(width) * double(height) * double(iterations)) / (seconds * 1000000.0);
+    }
+    free(dst); free(src);
+    return rate;
+}
+
+/// @summary Determine the uncompressed format produced when decoding block-compressed data of a given format.
+/// @param src_format One of dxgi_format_e specifying the block-compressed source format. BC4 and BC5 must be UNORM.
+/// @param dst_format One of dxgi_format_e specifying the requested target format. BC6H data can be decoded to R16G16B16A16_FLOAT only. All other formats can be decoded to RGBA8 or BGRA8, and formats that are not sRGB-encoded can also be decoded to R16G16B16A16_FLOAT.
+/// @return The target format, or DXGI_FORMAT_UNKNOWN if the conversion is not supported. The sRGB variant of RGBA8 or BGRA8 is returned for sRGB sources.
+public_function uint32_t bc_decoder_target_format(uint32_t src_format, uint32_t dst_format)
+{
+    bool srgb = false;
+    switch (src_format)
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC7_UNORM:
+            srgb = false;
+            break;
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            srgb = true;
+            break;
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+            return (dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT) ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_UNKNOWN;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+    }
+    switch (dst_format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return srgb ? DXGI_FORMAT_B8G8R8A8_UNORM_SRGB : DXGI_FORMAT_B8G8R8A8_UNORM;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            // sRGB data would need to be linearized; that isn't done here.
+            return srgb ? DXGI_FORMAT_UNKNOWN : DXGI_FORMAT_R16G16B16A16_FLOAT;
+        default:
+            break;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+/// @summary Decompress a single block. BC4 decodes to (R, 0, 0, 255), and BC5 decodes to (R, G, 0, 255).
+/// @param format One of dxgi_format_e specifying the block-compressed format. See bc_decoder_target_format().
+/// @param src The compressed block.
+/// @param pixels On return, the sixteen pixels of the block, in row-major order. RGBA16F (128 bytes) for BC6H, and RGBA8 (64 bytes) for all other formats.
+/// @return The number of bytes written to pixels, or zero if the format is not supported.
+public_function size_t bc_decode_block(uint32_t format, void const *src, void *pixels)
+{
+    if (!bc_decode_any(format, (uint8_t const*) src, pixels))
+        return 0;
+    if (format == DXGI_FORMAT_BC6H_UF16 || format == DXGI_FORMAT_BC6H_SF16)
+        return BC_BLOCK_PIXELS * 8;
+    else
+        return BC_BLOCK_RGBA_SIZE;
+}
+
+/// @summary Decompress a rectangular region of a block-compressed surface. Only the blocks overlapping the region are decoded.
+/// @param format One of dxgi_format_e specifying the block-compressed source format.
+/// @param dst_format The output format, as returned by bc_decoder_target_format().
+/// @param src The address of the first block of the surface.
+/// @param src_pitch The number of bytes between rows of blocks.
+/// @param x The x-coordinate of the left edge of the region, in pixels.
+/// @param y The y-coordinate of the top edge of the region, in pixels.
+/// @param width The width of the region, in pixels. The region must lie within the blocks of the surface.
+/// @param height The height of the region, in pixels.
+/// @param dst The address of the output pixel corresponding to (x, y).
+/// @param dst_pitch The number of bytes between output rows.
+/// @return true if the region was decoded, or false if the conversion is not supported.
+public_function bool bc_decode_rect(uint32_t format, uint32_t dst_format, void const *src, size_t src_pitch, size_t x, size_t y, size_t width, size_t height, void *dst, size_t dst_pitch)
+{
+    size_t  blocksz = dxgi_bytes_per_block(format);
+    bool    hdr     =(format == DXGI_FORMAT_BC6H_UF16 || format == DXGI_FORMAT_BC6H_SF16);
+    size_t  dstpp   =(dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT) ? 8 : 4;
+    uint8_t block[BC_BLOCK_PIXELS * 8];
+    if (bc_decoder_target_format(format, dst_format) != dst_format)
+    {   // the conversion is not supported.
+        return false;
+    }
+    for (size_t py = y, end_y = y + height; py < end_y; )
+    {
+        size_t         by    = py / BC_BLOCK_DIMENSION;
+        size_t         row0  = py % BC_BLOCK_DIMENSION;
+        size_t         rows  = image_min2<size_t>(BC_BLOCK_DIMENSION - row0, end_y - py);
+        uint8_t const *srow  =(uint8_t const*) src + by * src_pitch;
+        uint8_t       *drow  =(uint8_t*) dst + (py - y) * dst_pitch;
+        for (size_t px = x, end_x = x + width; px < end_x; )
+        {
+            size_t bx    = px / BC_BLOCK_DIMENSION;
+            size_t col0  = px % BC_BLOCK_DIMENSION;
+            size_t cols  = image_min2<size_t>(BC_BLOCK_DIMENSION - col0, end_x - px);
+            bc_decode_any(format, srow + bx * blocksz, block);
+            for (size_t r = 0; r < rows; ++r)
+            {
+                bc_store_block_row(block, hdr, row0 + r, col0, cols, dst_format, drow + r * dst_pitch + (px - x) * dstpp);
+            }
+            px += cols;
+        }
+        py += rows;
+    }
+    return true;
+}
+
+/// @summary Measure the throughput of the block-compression decoder. A synthetic image is first compressed with IMAGE_ENCODER_QUALITY_FAST.
+/// @param format The block-compressed format to decode. BC6H is measured with BC6H_UF16 data.
+/// @param dst_format The output format. See bc_decoder_target_format().
+/// @param width The width of the synthetic image, in pixels.
+/// @param height The height of the synthetic image, in pixels.
+/// @param iterations The number of times to decode the image.
+/// @return The decoder throughput, in millions of output pixels per-second, or zero if the conversion is not supported or memory allocation fails.
+public_function double bc_decoder_benchmark(uint32_t format, uint32_t dst_format, size_t width, size_t height, size_t iterations)
+{
+    bool     hdr       = (format == DXGI_FORMAT_BC6H_UF16 || format == DXGI_FORMAT_BC6H_SF16);
+    uint32_t enc_format=  hdr ? DXGI_FORMAT_BC6H_UF16 : format;
+    size_t   src_pitch = dxgi_pitch(enc_format, width);
+    size_t   dst_pitch = width * ((dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT) ? 8 : 4);
+    size_t   nrows     =(height + 3) / 4;
+    uint8_t *src       =(uint8_t*) calloc(nrows, src_pitch);
+    uint8_t *dst       =(uint8_t*) malloc(dst_pitch * height);
+    uint32_t seed      = 0x2545F491U;
+    double   rate      = 0.0;
+    if (src == NULL || dst == NULL || width == 0 || height == 0 || iterations == 0 || src_pitch == 0)
+    {   // nothing to measure.
+        free(dst); free(src);
+        return 0.0;
+    }
+    if (bc_decoder_target_format(enc_format, dst_format) != dst_format)
+    {   // the conversion is not supported.
+        free(dst); free(src);
+        return 0.0;
+    }
+    uint32_t src_format = hdr ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+    size_t   raw_pitch  = width * (hdr ? 8 : 4);
+    uint8_t *raw        = (uint8_t*) malloc(raw_pitch * BC_BLOCK_DIMENSION);
+    if (raw == NULL)
+    {   // unable to allocate the staging buffer.
+        free(dst); free(src);
+        return 0.0;
+    }
+    for (size_t y = 0; y < height; y += BC_BLOCK_DIMENSION)
+    {
+        size_t rows = image_min2<size_t>(BC_BLOCK_DIMENSION, height - y);
+        for (size_t r = 0; r < rows; ++r)
+        {
+            uint8_t *row = raw + r * raw_pitch;
+            for (size_t x = 0; x < width; ++x)
+            {
+                seed = seed * 1664525U + 1013904223U;
+                uint32_t noise = (seed >> 24) & 15;
+                uint8_t  rgba[4];
+                rgba[0] = uint8_t((x * 255) / width);
+                rgba[1] = uint8_t((((y + r) * 255) / height + noise) & 0xFF);
+                rgba[2] = uint8_t(((x / 16 + (y + r) / 16) & 1) ? 224 : 32);
+                rgba[3] = uint8_t(((x + y + r) * 4) & 0xFF);
+                if (hdr)
+                {
+                    uint16_t *h = (uint16_t*)(row + x * 8);
+                    for (size_t c = 0; c < 4; ++c)
+                        h[c] = image_float_to_half(float(rgba[c]) / 16.0f);
+                }
+                else memcpy(row + x * 4, rgba, 4);
+            }
+        }
+        bc_encode_block_row(enc_format, IMAGE_ENCODER_QUALITY_FAST, src_format, raw, raw_pitch, width, rows, src + (y / 4) * src_pitch);
+    }
+    free(raw);
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        bc_decode_rect(enc_format, dst_format, src, src_pitch, 0, 0, width, height, dst, dst_pitch);
+    }
+    QueryPerformanceCounter(&end);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(frequency.QuadPart);
+    if (seconds > 0.0)
+    {
+        rate = (double(width) * double(height) * double(iterations)) / (seconds * 1000000.0);
+    }
+    free(dst); free(src);
+    return rate;
+}
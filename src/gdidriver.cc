@@ -23,6 +23,9 @@
 /// @summary Define the maximum number of in-flight frames per-driver.
 static uint32_t const PRESENT_DRIVER_GDI_MAX_FRAMES = 4;
 
+/// @summary Define the maximum number of LZ-encoded image frames that can be decoded and locked at once.
+static size_t   const PRESENT_DRIVER_GDI_MAX_DECODED = 64;
+
 /*///////////////////
 //   Local Types   //
 ///////////////////*/
@@ -51,10 +54,11 @@ struct gdi_image_data_t
     uint32_t                SourceCompression; /// One of image_compression_e defining the source data storage compression.
     uint32_t                SourceEncoding;    /// One of image_encoding_e defining the source data storage encoding.
     thread_image_cache_t   *SourceCache;       /// The image cache that manages the source image data.
+    image_memory_t         *SourceMemory;      /// The image memory holding the pinned source data, or NULL if the data is locked through the image cache.
     size_t                  SourceWidth;       /// The width of the source image, in pixels.
     size_t                  SourceHeight;      /// The height of the source image, in pixels.
     size_t                  SourcePitch;       /// The number of bytes per-row in the source image data.
-    uint8_t                *SourceData;        /// Pointer to the start of the locked image data on the host.
+    uint8_t                *SourceData;        /// Pointer to the start of the locked image data on the host. LZ-encoded frames point into the driver scratch pool.
     size_t                  SourceSize;        /// The number of bytes of source data.
 };
 
@@ -93,6 +97,7 @@ struct present_driver_gdi_t
     size_t                  CacheCount;        /// The number of thread-local cache writers.
     size_t                  CacheCapacity;     /// The maximum capacity of the presentation thread image cache list.
     thread_image_cache_t   *CacheList;         /// The list of interfaces used to access image caches from the presentation thread.
+    image_memory_t        **CacheMemory;       /// The image memory backing each image cache, as reported by completed locks, or NULL.
 
     size_t                  ImageCount;        /// The number of locked images.
     size_t                  ImageCapacity;     /// The maximum capacity of the locked image list.
@@ -100,6 +105,8 @@ struct present_driver_gdi_t
     gdi_image_data_t       *ImageData;         /// The list of locked image data descriptors.
     size_t                 *ImageRefs;         /// The list of reference counts for each locked image.
 
+    image_scratch_pool_t    ImageScratch;      /// The scratch buffers holding decoded copies of locked LZ-encoded frames.
+
     image_lock_queue_t      ImageLockQueue;    /// The MPSC unbounded FIFO where completed image lock requests are stored.
     image_error_queue_t     ImageErrorQueue;   /// The MPSC unbounded FIFO where failed image lock requests are stored.
 
@@ -152,6 +159,38 @@ internal_function inline size_t frame_count(present_driver_gdi_t *driver)
     return size_t(driver->FrameTail - driver->FrameHead);
 }
 
+/// @summary Attempt to pin a frame that is already resident in image memory, bypassing the image cache lock round-trip.
+/// Only RAW-encoded frames are pinned; encoded frames go through the image cache so they can be decoded on lock completion.
+/// @param mem The image memory backing the image cache, or NULL if it is not yet known.
+/// @param image_id The application-defined image identifier.
+/// @param frame_index The zero-based index of the frame to pin.
+/// @param data The image data descriptor to populate if the frame is pinned.
+/// @return true if the frame was pinned and @a data is ready for use.
+internal_function bool pin_image(image_memory_t *mem, uintptr_t image_id, size_t frame_index, gdi_image_data_t &data)
+{
+    dds_level_desc_t     desc;
+    image_storage_info_t storage;
+    if (mem == NULL || !image_memory_storage_info(mem, image_id, desc, storage) || storage.Encoding != IMAGE_ENCODING_RAW)
+    {   // the frame must be locked through the image cache.
+        return false;
+    }
+    void *element_data = image_memory_pin_element(mem, image_id, frame_index, NULL, storage);
+    if (element_data == NULL)
+    {   // the frame isn't resident, or is being evicted.
+        return false;
+    }
+    data.SourceFormat      = storage.ImageFormat;
+    data.SourceCompression = uint32_t(storage.Compression);
+    data.SourceEncoding    = uint32_t(storage.Encoding);
+    data.SourceMemory      = mem;
+    data.SourceWidth       = desc.Width;
+    data.SourceHeight      = desc.Height;
+    data.SourcePitch       = desc.BytesPerRow;
+    data.SourceData        =(uint8_t*) element_data;
+    data.SourceSize        = storage.BytesReserved;
+    return true;
+}
+
 /// @summary Prepare an image for use by locking its data in host memory. The lock request completes asynchronously.
 /// @param driver The presentation driver handling the request.
 /// @param frame The in-flight frame state requiring the image data.
@@ -227,18 +266,21 @@ internal_function void prepare_image(present_driver_gdi_t *driver, gdi_frame_t *
             driver->ImageData[global_index].SourceCompression = IMAGE_COMPRESSION_NONE;
             driver->ImageData[global_index].SourceEncoding    = IMAGE_ENCODING_RAW;
             driver->ImageData[global_index].SourceCache       = NULL;
+            driver->ImageData[global_index].SourceMemory      = NULL;
             driver->ImageData[global_index].SourceWidth       = 0;
             driver->ImageData[global_index].SourceHeight      = 0;
             driver->ImageData[global_index].SourcePitch       = 0;
             driver->ImageData[global_index].SourceData        = NULL;
             driver->ImageData[global_index].SourceSize        = 0;
             // locate the presentation thread cache interface for the source data:
-            bool found_cache = false;
+            bool   found_cache = false;
+            size_t cache_index = 0;
             for (size_t ci = 0, cn = driver->CacheCount; ci < cn; ++ci)
             {
                 if (driver->CacheList[ci].Cache == image->ImageSource)
                 {
                     driver->ImageData[global_index].SourceCache = &driver->CacheList[ci];
+                    cache_index = ci;
                     found_cache = true;
                     break;
                 }
@@ -249,19 +291,23 @@ internal_function void prepare_image(present_driver_gdi_t *driver, gdi_frame_t *
                 {   // increase the capacity of the image cache list.
                     size_t old_amount   = driver->CacheCapacity;
                     size_t new_amount   = calculate_capacity(old_amount, old_amount+1, 16, 16);
-                    thread_image_cache_t *cl = (thread_image_cache_t*)   realloc(driver->CacheList, new_amount * sizeof(thread_image_cache_t));
-                    if (cl != NULL)
-                    {
-                        driver->CacheList     = cl;
-                        driver->CacheCapacity = new_amount;
-                    }
+                    thread_image_cache_t *cl = (thread_image_cache_t*)   realloc(driver->CacheList  , new_amount * sizeof(thread_image_cache_t));
+                    image_memory_t      **ml = (image_memory_t     **)   realloc(driver->CacheMemory, new_amount * sizeof(image_memory_t*));
+                    if (cl != NULL) driver->CacheList   = cl;
+                    if (ml != NULL) driver->CacheMemory = ml;
+                    if (cl != NULL && ml != NULL) driver->CacheCapacity = new_amount;
                 }
-                thread_image_cache_t *cache = &driver->CacheList[driver->CacheCount++];
+                cache_index = driver->CacheCount++;
+                thread_image_cache_t *cache = &driver->CacheList[cache_index];
+                driver->CacheMemory[cache_index] = NULL;
                 driver->ImageData[global_index].SourceCache = cache;
                 cache->initialize(image->ImageSource);
             }
-            // finally, submit a lock request for the frame.
-            driver->ImageData[global_index].SourceCache->lock( image_id, frame_index, frame_index, &driver->ImageLockQueue, &driver->ImageErrorQueue, 0);
+            // finally, pin the frame if it's already resident, or submit a lock request for it.
+            if (!pin_image(driver->CacheMemory[cache_index], image_id, frame_index, driver->ImageData[global_index]))
+            {
+                driver->ImageData[global_index].SourceCache->lock(image_id, frame_index, frame_index, &driver->ImageLockQueue, &driver->ImageErrorQueue, 0);
+            }
         }
     }
 }
@@ -337,7 +383,15 @@ internal_function void retire_frame(present_driver_gdi_t *driver)
                 {   // the image reference count has dropped to zero.
                     // unlock the image data, and delete the entry from the global list.
                     size_t  last_index  = driver->ImageCount - 1;
-                    driver->ImageData[gi].SourceCache->unlock(gid.ImageId, gid.FrameIndex, gid.FrameIndex);
+                    if (driver->ImageData[gi].SourceMemory != NULL)
+                    {   // the frame was pinned in image memory by prepare_image.
+                        image_memory_unpin_element(driver->ImageData[gi].SourceMemory, gid.ImageId, gid.FrameIndex);
+                    }
+                    else driver->ImageData[gi].SourceCache->unlock(gid.ImageId, gid.FrameIndex, gid.FrameIndex);
+                    if (driver->ImageData[gi].SourceEncoding != IMAGE_ENCODING_RAW)
+                    {   // the decoded copy is no longer referenced by any in-flight frame.
+                        image_scratch_release(&driver->ImageScratch, gid.ImageId, gid.FrameIndex);
+                    }
                     driver->ImageIds [gi] = driver->ImageIds [last_index];
                     driver->ImageData[gi] = driver->ImageData[last_index];
                     driver->ImageRefs[gi] = driver->ImageRefs[last_index];
@@ -380,12 +434,14 @@ uintptr_t __cdecl PrDisplayDriverOpen(HWND window)
     driver->CacheCount    = 0;
     driver->CacheCapacity = 0;
     driver->CacheList     = NULL;
+    driver->CacheMemory   = NULL;
     
     driver->ImageCount    = 0;
     driver->ImageCapacity = 0;
     driver->ImageIds      = NULL;
     driver->ImageData     = NULL;
     driver->ImageRefs     = NULL;
+    ZeroMemory(&driver->ImageScratch, sizeof(image_scratch_pool_t));
     
     driver->FrameHead     = 0;
     driver->FrameTail     = 0;
@@ -449,6 +505,7 @@ uintptr_t __cdecl PrDisplayDriverOpen(HWND window)
     // image cache control commands from the presentation thread.
     driver->CacheCapacity = 4;
     driver->CacheList     =(thread_image_cache_t*) malloc(4 * sizeof(thread_image_cache_t));
+    driver->CacheMemory   =(image_memory_t     **) malloc(4 * sizeof(image_memory_t*));
 
     // initialize a dynamic list of images referenced by in-flight frames.
     driver->ImageCapacity = 8;
@@ -456,6 +513,9 @@ uintptr_t __cdecl PrDisplayDriverOpen(HWND window)
     driver->ImageData     =(gdi_image_data_t    *) malloc(8 * sizeof(gdi_image_data_t));
     driver->ImageRefs     =(size_t              *) malloc(8 * sizeof(size_t));
 
+    // initialize the scratch buffers into which LZ-encoded frames are decoded.
+    image_scratch_pool_create(&driver->ImageScratch, PRESENT_DRIVER_GDI_MAX_DECODED);
+
     // initialize queues for receiving image data from the host:
     mpsc_fifo_u_init(&driver->ImageLockQueue);
     mpsc_fifo_u_init(&driver->ImageErrorQueue);
@@ -620,16 +680,21 @@ void __cdecl PrPresentFrameToWindow(uintptr_t drv)
         {
             if (driver->ImageIds [gi].ImageId    == lock_result.ImageId && 
                 driver->ImageIds [gi].FrameIndex == lock_result.FrameIndex)
-            {   // save the image metadata and host memory pointer.
-                driver->ImageData[gi].ErrorCode         = ERROR_SUCCESS;
+            {   // save the image metadata and host memory pointer. LZ-encoded frames are decoded here.
+                uint32_t error     = ERROR_SUCCESS;
+                size_t   data_size = 0;
+                void    *data      = image_scratch_acquire(&driver->ImageScratch, lock_result.ImageId, lock_result.FrameIndex, lock_result.Encoding, lock_result.LevelInfo, lock_result.LevelCount, lock_result.BaseAddress, lock_result.BytesReserved, data_size, error);
+                driver->ImageData[gi].ErrorCode         = error;
                 driver->ImageData[gi].SourceFormat      = lock_result.ImageFormat;
                 driver->ImageData[gi].SourceCompression = lock_result.Compression;
                 driver->ImageData[gi].SourceEncoding    = lock_result.Encoding;
                 driver->ImageData[gi].SourceWidth       = lock_result.LevelInfo[0].Width;
                 driver->ImageData[gi].SourceHeight      = lock_result.LevelInfo[0].Height;
                 driver->ImageData[gi].SourcePitch       = lock_result.LevelInfo[0].BytesPerRow;
-                driver->ImageData[gi].SourceData        =(uint8_t*) lock_result.BaseAddress;
-                driver->ImageData[gi].SourceSize        = lock_result.BytesReserved;
+                driver->ImageData[gi].SourceData        =(uint8_t*) data;
+                driver->ImageData[gi].SourceSize        = data_size;
+                // remember the image memory, so later requests for resident frames of this cache can be pinned.
+                driver->CacheMemory[driver->ImageData[gi].SourceCache - driver->CacheList] = (image_memory_t*) lock_result.Context;
                 break;
             }
         }
@@ -812,9 +877,11 @@ void __cdecl PrDisplayDriverClose(uintptr_t drv)
     {   // free memory allocated for each in-flight frame.
         free(driver->FrameQueue[i].ImageIds);
     }
+    image_scratch_pool_delete(&driver->ImageScratch);
     free(driver->ImageRefs);
     free(driver->ImageData);
     free(driver->ImageIds );
+    free(driver->CacheMemory);
     free(driver->CacheList);
     free(driver);
 }
@@ -249,6 +249,7 @@ struct gl_pixel_transfer_h2d_t
     size_t                 SourceZ;           /// The upper-left-front corner on the source image.
     size_t                 SourceWidth;       /// The width of the full source image, in pixels.
     size_t                 SourceHeight;      /// The height of the full source image, in pixels.
+    size_t                 SourcePitch;       /// The number of bytes between rows of an uncompressed source image, or 0 if rows follow GL_UNPACK_ALIGNMENT.
     size_t                 TransferWidth;     /// The width of the region to transfer, in pixels.
     size_t                 TransferHeight;    /// The height of the region to transfer, in pixels.
     size_t                 TransferSlices;    /// The number of slices to transfer.
@@ -2547,11 +2548,28 @@ public_function void gl_transfer_pixels_h2d(gl_display_t *display, gl_pixel_tran
         // select the client memory as the source of the unpack operation.
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     }
-    if (transfer->SourceWidth != transfer->TransferWidth)
+    size_t row_length   = transfer->SourceWidth;
+    GLint  unpack_align = 0;
+    if (transfer->SourcePitch != 0 && gl_bytes_per_block(transfer->Format) == 0)
     {
-        // transferring a sub-rectangle of the image; tell GL how many
-        // pixels are in a single row of the source image.
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(transfer->SourceWidth));
+        // the source rows have an explicit pitch, for example, image memory 
+        // with padded rows. express the pitch as a row length and alignment 
+        // so that GL reads the rows in place, without a staging copy.
+        size_t bpp  = gl_bytes_per_row(transfer->Format, transfer->DataType, 1, 1);
+        GLint align = 8;
+        while (transfer->SourcePitch & size_t(align - 1)) align >>= 1;
+        if (bpp > 0 && (transfer->SourcePitch % bpp) == 0)
+        {
+            row_length = transfer->SourcePitch / bpp;
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_align);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, align);
+        }
+    }
+    if (row_length != transfer->TransferWidth)
+    {
+        // transferring a sub-rectangle of the image, or the rows are padded; 
+        // tell GL how many pixels are in a single row of the source image.
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(row_length));
     }
     if (transfer->TransferSlices > 1)
     {
@@ -2637,8 +2655,10 @@ public_function void gl_transfer_pixels_h2d(gl_display_t *display, gl_pixel_tran
     // restore the unpack state values to their defaults.
     if (transfer->UnpackBuffer  != 0)
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER,  0);
-    if (transfer->SourceWidth   != transfer->TransferWidth)
+    if (row_length              != transfer->TransferWidth)
         glPixelStorei(GL_UNPACK_ROW_LENGTH,   0);
+    if (unpack_align            != 0)
+        glPixelStorei(GL_UNPACK_ALIGNMENT,    unpack_align);
     if (transfer->TransferSlices > 1)
         glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
     if (transfer->SourceX != 0)
@@ -14,6 +14,9 @@
 /// @summary Define the maximum number of in-flight frames per-driver.
 static uint32_t const GLRC_MAX_FRAMES   = 4;
 
+/// @summary Define the maximum number of LZ-encoded image frames that can be decoded and locked at once.
+static size_t   const GLRC_MAX_DECODED  = 64;
+
 /*///////////////////
 //   Local Types   //
 ///////////////////*/
@@ -53,7 +56,7 @@ struct gl_image_data_t
     size_t                  SourceWidth;       /// The width of the source image, in pixels.
     size_t                  SourceHeight;      /// The height of the source image, in pixels.
     size_t                  SourcePitch;       /// The number of bytes per-row in the source image data.
-    uint8_t                *SourceData;        /// Pointer to the start of the locked image data on the host.
+    uint8_t                *SourceData;        /// Pointer to the start of the locked image data on the host. LZ-encoded frames point into the driver scratch pool.
     size_t                  SourceSize;        /// The number of bytes of source data.
 };
 
@@ -95,6 +98,8 @@ struct gl3_renderer_t
     gl_image_data_t        *ImageData;         /// The list of locked image data descriptors.
     size_t                 *ImageRefs;         /// The list of reference counts for each locked image.
 
+    image_scratch_pool_t    ImageScratch;      /// The scratch buffers holding decoded copies of locked LZ-encoded frames.
+
     image_lock_queue_t      ImageLockQueue;    /// The MPSC unbounded FIFO where completed image lock requests are stored.
     image_error_queue_t     ImageErrorQueue;   /// The MPSC unbounded FIFO where failed image lock requests are stored.
 
@@ -327,6 +332,10 @@ internal_function void retire_frame(gl3_renderer_t *gl)
                     size_t frame_index = global_id.FrameIndex;
                     size_t  last_index = gl->ImageCount - 1;
                     gl->ImageData[global_index].SourceCache->unlock(global_id.ImageId, frame_index, frame_index);
+                    if (gl->ImageData[global_index].SourceEncoding != IMAGE_ENCODING_RAW)
+                    {   // the decoded copy is no longer referenced by any in-flight frame.
+                        image_scratch_release(&gl->ImageScratch, global_id.ImageId, frame_index);
+                    }
                     gl->ImageIds [global_index] = gl->ImageIds [last_index];
                     gl->ImageData[global_index] = gl->ImageData[last_index];
                     gl->ImageRefs[global_index] = gl->ImageRefs[last_index];
@@ -395,6 +404,9 @@ public_function uintptr_t create_renderer(gl_display_t *display, HWND window)
     gl->ImageData     =(gl_image_data_t     *) malloc(8 * sizeof(gl_image_data_t));
     gl->ImageRefs     =(size_t              *) malloc(8 * sizeof(size_t));
 
+    // initialize the scratch buffers into which LZ-encoded frames are decoded.
+    image_scratch_pool_create(&gl->ImageScratch, GLRC_MAX_DECODED);
+
     // initialize queues for receiving image data from the host:
     mpsc_fifo_u_init(&gl->ImageLockQueue);
     mpsc_fifo_u_init(&gl->ImageErrorQueue);
@@ -497,6 +509,9 @@ public_function uintptr_t create_renderer(gl_display_t *display, size_t target_w
     gl->ImageData     =(gl_image_data_t     *) malloc(8 * sizeof(gl_image_data_t));
     gl->ImageRefs     =(size_t              *) malloc(8 * sizeof(size_t));
 
+    // initialize the scratch buffers into which LZ-encoded frames are decoded.
+    image_scratch_pool_create(&gl->ImageScratch, GLRC_MAX_DECODED);
+
     // initialize queues for receiving image data from the host:
     mpsc_fifo_u_init(&gl->ImageLockQueue);
     mpsc_fifo_u_init(&gl->ImageErrorQueue);
@@ -680,16 +695,19 @@ public_function void update_drawable(uintptr_t handle)
         {
             if (gl->ImageIds [gi].ImageId    == lock_result.ImageId && 
                 gl->ImageIds [gi].FrameIndex == lock_result.FrameIndex)
-            {   // save the image metadata and host memory pointer.
-                gl->ImageData[gi].ErrorCode         = ERROR_SUCCESS;
+            {   // save the image metadata and host memory pointer. LZ-encoded frames are decoded here.
+                uint32_t error     = ERROR_SUCCESS;
+                size_t   data_size = 0;
+                void    *data      = image_scratch_acquire(&gl->ImageScratch, lock_result.ImageId, lock_result.FrameIndex, lock_result.Encoding, lock_result.LevelInfo, lock_result.LevelCount, lock_result.BaseAddress, lock_result.BytesReserved, data_size, error);
+                gl->ImageData[gi].ErrorCode         = error;
                 gl->ImageData[gi].SourceFormat      = lock_result.ImageFormat;
                 gl->ImageData[gi].SourceCompression = lock_result.Compression;
                 gl->ImageData[gi].SourceEncoding    = lock_result.Encoding;
                 gl->ImageData[gi].SourceWidth       = lock_result.LevelInfo[0].Width;
                 gl->ImageData[gi].SourceHeight      = lock_result.LevelInfo[0].Height;
                 gl->ImageData[gi].SourcePitch       = lock_result.LevelInfo[0].BytesPerRow;
-                gl->ImageData[gi].SourceData        =(uint8_t*) lock_result.BaseAddress;
-                gl->ImageData[gi].SourceSize        = lock_result.BytesReserved;
+                gl->ImageData[gi].SourceData        =(uint8_t*) data;
+                gl->ImageData[gi].SourceSize        = data_size;
                 break;
             }
         }
@@ -842,6 +860,7 @@ public_function void delete_renderer(uintptr_t handle)
     mpsc_fifo_u_delete(&gl->ImageLockQueue);
 
     // free resources associated with the global image list:
+    image_scratch_pool_delete(&gl->ImageScratch);
     free(gl->ImageRefs);
     free(gl->ImageData);
     free(gl->ImageIds);
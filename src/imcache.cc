@@ -41,6 +41,7 @@ enum image_cache_command_option_e      : uint32_t
     IMAGE_CACHE_COMMAND_OPTION_NONE    =(0 << 0), /// No special behavior is requested.
     IMAGE_CACHE_COMMAND_OPTION_EVICT   =(1 << 0), /// Valid on unlock. If the lock count after unlock is zero, drop the image.
     IMAGE_CACHE_COMMAND_OPTION_PRELOAD =(1 << 1), /// Valid on lock. Load the image into image memory, but don't lock it.
+    IMAGE_CACHE_COMMAND_OPTION_PARTIAL =(1 << 2), /// Valid on lock. Also post a result each time a loading frame becomes displayable at a higher resolution.
 };
 
 /// @summary Defines status flags that can be set on cache entries.
@@ -49,6 +50,7 @@ enum image_cache_entry_flag_e          : uint32_t
     IMAGE_CACHE_ENTRY_FLAG_NONE        =(0 << 0), /// No special status flags are set.
     IMAGE_CACHE_ENTRY_FLAG_EVICT       =(1 << 0), /// The frame(s) should be dropped when its lock count reaches zero.
     IMAGE_CACHE_ENTRY_FLAG_DROP        =(1 << 1), /// All information about the image should be deleted when it falls out of cache.
+    IMAGE_CACHE_ENTRY_FLAG_PARTIAL     =(1 << 2), /// Only the lower-resolution levels of the frame are resident; the frame is still loading.
 };
 
 /// @summary Defines the supported victim selection behaviors of the image cache.
@@ -93,6 +95,8 @@ struct image_cache_result_t
     dds_level_desc_t    *LevelInfo;               /// An array of LevelCount entries describing the levels in the mipmap chain.
     void                *BaseAddress;             /// The base address of the frame data, if it was locked.
     size_t               BytesReserved;           /// The number of bytes of frame data, if the frame was locked.
+    size_t               FirstLevel;              /// The zero-based index of the highest-resolution level resident. Non-zero only for partial results.
+    uintptr_t            Context;                 /// The opaque data supplied with the frame placement. For frames placed by an image_memory_t, the image memory.
 };
 typedef fifo_allocator_table_t<image_cache_result_t>  image_cache_result_alloc_table_t;
 typedef fifo_allocator_t      <image_cache_result_t>  image_cache_result_alloc_t;
@@ -185,6 +189,7 @@ struct image_loads_data_t
     uint32_t            *LockCounts;              /// The set of pending lock counts. Preload-only commands don't increment the lock count.
     error_queues_t      *ErrorQueues;             /// The set of frame load error queues.
     result_queues_t     *ResultQueues;            /// The set of frame load result queues.
+    result_queues_t     *PartialQueues;           /// The set of frame partial result queues, for lock commands with IMAGE_CACHE_COMMAND_OPTION_PARTIAL.
 };
 
 /// @summary Defines the metadata maintained for each logical image.
@@ -217,6 +222,7 @@ struct image_frame_info_t
     uintptr_t            Context;                 /// Opaque data used to locate the image.
     void                *BaseAddress;             /// The address at which the frame data begins.
     size_t               BytesReserved;           /// The number of bytes of cache memory reserved for the frame.
+    size_t               FirstLevel;              /// The zero-based index of the highest-resolution level resident, or 0 if the frame is complete.
 };
 
 /// @summary Defines the data used when deciding which frames to evict from the cache.
@@ -262,6 +268,7 @@ struct image_cache_t
     typedef image_eviction_queue_t                    eviction_queue_t;
     typedef image_command_alloc_t                     command_alloc_t;
     typedef image_command_queue_t                     command_queue_t;
+    typedef image_load_error_queue_t                  load_error_queue_t;
 
     LARGE_INTEGER          ClockFrequency;        /// The tick frequency of the system high-resolution timer.
 
@@ -297,6 +304,7 @@ struct image_cache_t
     definition_queue_t     DefinitionQueue;       /// The MPSC input queue for image definition requests.
     location_queue_t       LocationQueue;         /// The MPSC input queue for cache memory location updates.
     command_queue_t        CommandQueue;          /// The MPSC input queue for cache control commands.
+    load_error_queue_t     LoadErrorQueue;        /// The MPSC input queue for failed image loads.
 
     error_alloc_table_t    ErrorAlloc;            /// The table of FIFO node allocators for posting error results to client queues.
     result_alloc_table_t   ResultAlloc;           /// The table of FIFO node allocators for posting lock results to client queues.
@@ -357,7 +365,8 @@ struct thread_image_cache_t
         size_t             final_frame, 
         result_queue_t    *result_queue, 
         error_queue_t     *error_queue, 
-        uint8_t            priority
+        uint8_t            priority, 
+        uint32_t           options      = IMAGE_CACHE_COMMAND_OPTION_NONE
     );                                            /// Asynchronously lock one or more frames into cache memory.
 
     void unlock
@@ -583,14 +592,16 @@ internal_function void image_cache_process_pending_evict_and_drop(image_cache_t
     for (size_t i = 0; i < entry.FrameCount; /* empty */)
     {   // we can only drop frames with a lock count of zero.
         if ((entry.FrameState[i].LockCount == 0) && 
-            (entry.FrameState[i].Attributes & IMAGE_CACHE_ENTRY_FLAG_EVICT) != 0)
-        {   // evict this frame from cache memory.
+            (entry.FrameState[i].Attributes & IMAGE_CACHE_ENTRY_FLAG_EVICT  ) != 0 && 
+            (entry.FrameState[i].Attributes & IMAGE_CACHE_ENTRY_FLAG_PARTIAL) == 0)
+        {   // evict this frame from cache memory. frames still loading are evicted once complete.
             fifo_node_t<image_location_t>*n = fifo_allocator_get(&cache->EvictAlloc);
             n->Item.ImageId       = entry.ImageId;
             n->Item.FrameIndex    = entry.FrameList[i];
             n->Item.BaseAddress   = entry.FrameData[i].BaseAddress;
             n->Item.BytesReserved = entry.FrameData[i].BytesReserved;
             n->Item.Context       = entry.FrameData[i].Context;
+            n->Item.FirstLevel    = 0;
             spsc_fifo_u_produce(&cache->EvictQueue, n);
             // consider the frame to have been immediately evicted.
             bytes_dropped += entry.FrameData[i].BytesReserved;
@@ -754,6 +765,8 @@ internal_function uint32_t image_cache_complete_lock(image_cache_t *cache, image
         n->Item.LevelInfo      = meta.LevelInfo;
         n->Item.BaseAddress    = loc.BaseAddress;
         n->Item.BytesReserved  = loc.BytesReserved;
+        n->Item.FirstLevel     = loc.FirstLevel;
+        n->Item.Context        = loc.Context;
         mpsc_fifo_u_produce(result_queue, n);
     }
     return ERROR_SUCCESS;
@@ -780,6 +793,27 @@ internal_function uint32_t image_cache_complete_error(image_cache_t *cache, imag
     return error;
 }
 
+/// @summary Generates an error event for a lock command waiting on a frame whose load failed.
+/// @param cache The image cache that processed the lock command.
+/// @param error_queue The error queue to which the error event will be posted.
+/// @param image_id The application-defined identifier of the logical image.
+/// @param frame_index The zero-based index of the frame that failed to load.
+/// @param error The system error code to return to the application.
+internal_function void image_cache_complete_load_error(image_cache_t *cache, image_cache_command_t::error_queue_t *error_queue, uintptr_t image_id, size_t frame_index, uint32_t error)
+{
+    if (error_queue != NULL)
+    {   // get the producer allocator from the table. one will be created if necessary.
+        image_cache_error_alloc_t     *alloc = fifo_allocator_table_get(&cache->ErrorAlloc, error_queue);
+        fifo_node_t<image_cache_error_t>  *n = fifo_allocator_get(alloc);
+        n->Item.CommandId  = IMAGE_CACHE_COMMAND_LOCK;
+        n->Item.ErrorCode  = error;
+        n->Item.ImageId    = image_id;
+        n->Item.FirstFrame = frame_index;
+        n->Item.FinalFrame = frame_index;
+        mpsc_fifo_u_produce(error_queue, n);
+    }
+}
+
 /// @summary Initializes a new cache entry for a given image.
 /// @param cache The image cache managing the image.
 /// @param image_id The application-defined identifier of the image associated with the cache entry.
@@ -870,12 +904,14 @@ internal_function size_t image_cache_frame_load_list_put(image_loads_data_t &loa
         uint32_t       *nl =(uint32_t*)realloc (load.LockCounts  , new_amount * sizeof(uint32_t));
         equeue_t       *ne =(equeue_t*)realloc (load.ErrorQueues , new_amount * sizeof(equeue_t));
         rqueue_t       *nr =(rqueue_t*)realloc (load.ResultQueues, new_amount * sizeof(rqueue_t));
+        rqueue_t       *np =(rqueue_t*)realloc (load.PartialQueues,new_amount * sizeof(rqueue_t));
         if (nf != NULL) load.FrameList      = nf;
         if (nt != NULL) load.RequestTime    = nt;
         if (nl != NULL) load.LockCounts     = nl;
         if (ne != NULL) load.ErrorQueues    = ne;
         if (nr != NULL) load.ResultQueues   = nr;
-        if (nf != NULL && nt != NULL && nl != NULL && ne != NULL && nr != NULL)
+        if (np != NULL) load.PartialQueues  = np;
+        if (nf != NULL && nt != NULL && nl != NULL && ne != NULL && nr != NULL && np != NULL)
         {   // all lists reallocated successfully. update capacity.
             load.FrameCapacity = new_amount;
             // initialize any new queue lists.
@@ -885,6 +921,7 @@ internal_function size_t image_cache_frame_load_list_put(image_loads_data_t &loa
             {
                 frame_load_queue_list_create(&load.ErrorQueues [i], 1);
                 frame_load_queue_list_create(&load.ResultQueues[i], 8);
+                frame_load_queue_list_create(&load.PartialQueues[i], 0);
             }
         }
         else
@@ -898,6 +935,7 @@ internal_function size_t image_cache_frame_load_list_put(image_loads_data_t &loa
         size_t index = load.FrameCount;
         frame_load_queue_list_clear(&load.ErrorQueues [index]);
         frame_load_queue_list_clear(&load.ResultQueues[index]);
+        frame_load_queue_list_clear(&load.PartialQueues[index]);
     }
     new_item = true;
     error    = ERROR_SUCCESS;
@@ -989,6 +1027,10 @@ internal_function uint32_t image_cache_load_frame(image_cache_t *cache, image_lo
     // add the queues to the notify lists.
     frame_load_queue_list_put(&load.ErrorQueues [list_index], cmd.ErrorQueue);
     frame_load_queue_list_put(&load.ResultQueues[list_index], cmd.ResultQueue);
+    if (cmd.Options & IMAGE_CACHE_COMMAND_OPTION_PARTIAL)
+    {   // the caller also wants to see the frame as its levels arrive.
+        frame_load_queue_list_put(&load.PartialQueues[list_index], cmd.ResultQueue);
+    }
     return ERROR_SUCCESS;
 }
 
@@ -1130,6 +1172,21 @@ internal_function uint32_t image_cache_process_lock(image_cache_t *cache, image_
             // the frame index list is unordered, so check every element.
             for (size_t i = 0, n = entry.FrameCount; i < n; ++i)
             {
+                if (entry.FrameList[i] == frame_index && (entry.FrameState[i].Attributes & IMAGE_CACHE_ENTRY_FLAG_PARTIAL) != 0)
+                {   // the frame is still loading; the lock joins the pending load below.
+                    if ((cmd.Options & IMAGE_CACHE_COMMAND_OPTION_PARTIAL) != 0 && (cmd.Options & IMAGE_CACHE_COMMAND_OPTION_PRELOAD) == 0)
+                    {   // report the levels that are already resident.
+                        image_location_t loc;
+                        loc.ImageId        = cmd.ImageId;
+                        loc.FrameIndex     = frame_index;
+                        loc.BaseAddress    = entry.FrameData[i].BaseAddress;
+                        loc.BytesReserved  = entry.FrameData[i].BytesReserved;
+                        loc.Context        = entry.FrameData[i].Context;
+                        loc.FirstLevel     = entry.FrameData[i].FirstLevel;
+                        image_cache_complete_lock(cache, cmd.ResultQueue, loc, image_info);
+                    }
+                    break;
+                }
                 if (entry.FrameList[i] == frame_index)
                 {   
                     if (cmd.Options & IMAGE_CACHE_COMMAND_OPTION_PRELOAD)
@@ -1150,6 +1207,7 @@ internal_function uint32_t image_cache_process_lock(image_cache_t *cache, image_
                         loc.BaseAddress    = entry.FrameData[i].BaseAddress;
                         loc.BytesReserved  = entry.FrameData[i].BytesReserved;
                         loc.Context        = entry.FrameData[i].Context;
+                        loc.FirstLevel     = 0;
                         image_cache_complete_lock(cache, cmd.ResultQueue, loc, image_info);
                     }
                     // no need to re-load this frame into cache.
@@ -1400,6 +1458,12 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
                             &load.ResultQueues[list_index], 
                              load.ResultQueues[all_frames_ix].QueueList[j]);
                     }
+                    for (size_t j = 0, m = load.PartialQueues[all_frames_ix].QueueCount; j < m; ++j)
+                    {  
+                        frame_load_queue_list_put(
+                            &load.PartialQueues[list_index], 
+                             load.PartialQueues[all_frames_ix].QueueList[j]);
+                    }
                 }
             }
         }
@@ -1407,6 +1471,14 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
         // complete the load for the specified frame.
         for (size_t frame_index = 0, frame_count = load.FrameCount; frame_index < frame_count; ++frame_index)
         {
+            if (load.FrameList[frame_index] == pos.FrameIndex && pos.FirstLevel != 0)
+            {   // only some levels are resident. report them, but keep the load pending.
+                for (size_t i = 0, n = load.PartialQueues[frame_index].QueueCount; i < n; ++i)
+                {
+                    image_cache_complete_lock(cache, load.PartialQueues[frame_index].QueueList[i], pos, image_info);
+                }
+                break;
+            }
             if (load.FrameList[frame_index] == pos.FrameIndex)
             {   // save off the number of pending locks.
                 lock_count = load.LockCounts[frame_index];
@@ -1423,6 +1495,7 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
                 // the frame has finished loading, so remove it from the list.
                 frame_load_queue_list_clear(&load.ErrorQueues [frame_index]);
                 frame_load_queue_list_clear(&load.ResultQueues[frame_index]);
+                frame_load_queue_list_clear(&load.PartialQueues[frame_index]);
                 // remove from the list by swapping the last item into place.
                 size_t this_frame = frame_index;
                 size_t last_frame = load.FrameCount - 1;
@@ -1431,6 +1504,7 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
                 array_swap(load.LockCounts  , this_frame, last_frame);
                 array_swap(load.ErrorQueues , this_frame, last_frame);
                 array_swap(load.ResultQueues, this_frame, last_frame);
+                array_swap(load.PartialQueues,this_frame, last_frame);
                 load.FrameCount--;
                 // if there are no frames remaining to load, remove the record.
                 if (load.FrameCount == 0)
@@ -1468,6 +1542,7 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
             entry.FrameData[i].BaseAddress   = pos.BaseAddress;
             entry.FrameData[i].BytesReserved = pos.BytesReserved;
             entry.FrameData[i].Context       = pos.Context;
+            entry.FrameData[i].FirstLevel    = pos.FirstLevel;
             // update the cache data of the entry, if it was just loaded.
             if (loaded_frame)
             {
@@ -1476,6 +1551,14 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
                 entry.FrameState[i].LastRequestTime = now_time;
                 entry.FrameState[i].TimeToLoad      = now_time - t_start;
             }
+            else if (pos.FirstLevel != 0)
+            {   // more levels of a loading frame are resident.
+                entry.FrameState[i].Attributes     |= IMAGE_CACHE_ENTRY_FLAG_PARTIAL;
+            }
+            else
+            {   // the frame finished loading, but no load was pending for it.
+                entry.FrameState[i].Attributes     &=~IMAGE_CACHE_ENTRY_FLAG_PARTIAL;
+            }
             found_frame = true;
             break;
         }
@@ -1498,8 +1581,9 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
         entry.FrameData [frame_index].BaseAddress     = pos.BaseAddress;
         entry.FrameData [frame_index].BytesReserved   = pos.BytesReserved;
         entry.FrameData [frame_index].Context         = pos.Context;
+        entry.FrameData [frame_index].FirstLevel      = pos.FirstLevel;
         entry.FrameState[frame_index].LockCount       = lock_count;
-        entry.FrameState[frame_index].Attributes      = IMAGE_CACHE_ENTRY_FLAG_NONE;
+        entry.FrameState[frame_index].Attributes      =(pos.FirstLevel != 0) ? IMAGE_CACHE_ENTRY_FLAG_PARTIAL : IMAGE_CACHE_ENTRY_FLAG_NONE;
         entry.FrameState[frame_index].LastRequestTime = now_time;
         entry.FrameState[frame_index].TimeToLoad      = now_time - t_start;
         entry.FrameCount++;
@@ -1539,6 +1623,85 @@ internal_function uint32_t image_cache_update_location(image_cache_t *cache, ima
     return ERROR_SUCCESS;
 }
 
+/// @summary Retires the frames of a failed image load. Lock commands waiting on the frames complete with an error, 
+/// and frames left partially resident by a progressive load are marked for eviction, so that their memory is 
+/// released and the next lock reloads them. Only frames still marked as loading are evicted; complete frames 
+/// within the range are left alone.
+/// @param cache The image cache to update.
+/// @param err The load error reported by the image loader.
+internal_function void image_cache_process_load_error(image_cache_t *cache, image_load_error_t const &err)
+{
+    uint32_t error = (err.OSError != ERROR_SUCCESS) ? err.OSError : ERROR_INVALID_DATA;
+    size_t   load_index;
+    size_t   entry_index;
+
+    // complete any lock commands waiting on the frames of the load.
+    if (id_table_get(&cache->LoadIds, err.ImageId, &load_index))
+    {
+        image_loads_data_t &load = cache->LoadList[load_index];
+        for (size_t frame_index = 0; frame_index < load.FrameCount; /* empty */)
+        {
+            size_t frame = load.FrameList[frame_index];
+            if (frame != IMAGE_ALL_FRAMES && (frame < err.FirstFrame || frame > err.FinalFrame))
+            {   // this frame isn't part of the failed load.
+                frame_index++;
+                continue;
+            }
+            for (size_t i = 0, n = load.ErrorQueues[frame_index].QueueCount; i < n; ++i)
+            {
+                image_cache_complete_load_error(cache, load.ErrorQueues[frame_index].QueueList[i], err.ImageId, frame, error);
+            }
+            frame_load_queue_list_clear(&load.ErrorQueues  [frame_index]);
+            frame_load_queue_list_clear(&load.ResultQueues [frame_index]);
+            frame_load_queue_list_clear(&load.PartialQueues[frame_index]);
+            // remove from the list by swapping the last item into place.
+            size_t this_frame = frame_index;
+            size_t last_frame = load.FrameCount - 1;
+            array_swap(load.FrameList   , this_frame, last_frame);
+            array_swap(load.RequestTime , this_frame, last_frame);
+            array_swap(load.LockCounts  , this_frame, last_frame);
+            array_swap(load.ErrorQueues , this_frame, last_frame);
+            array_swap(load.ResultQueues, this_frame, last_frame);
+            array_swap(load.PartialQueues,this_frame, last_frame);
+            load.FrameCount--;
+        }
+        if (load.FrameCount == 0)
+        {   // remove from the list by swapping the last item into place.
+            size_t this_load = load_index;
+            size_t last_load = cache->LoadCount - 1;
+            if (this_load != last_load)
+            {   // update the ID look up table so it can find the relocated item.
+                id_table_update(&cache->LoadIds, cache->LoadList[last_load].ImageId, load_index, NULL);
+                cache->LoadList[this_load]     = cache->LoadList[last_load];
+            }
+            // remove the unused item from the ID look up table.
+            id_table_remove(&cache->LoadIds, err.ImageId, NULL);
+            cache->LoadCount--;
+        }
+    }
+
+    // frames that will never complete must not stay in the cache marked as loading.
+    if (id_table_get(&cache->EntryIds, err.ImageId, &entry_index))
+    {
+        image_cache_entry_t &entry = cache->EntryList[entry_index];
+        bool           evict_frames = false;
+        for (size_t i = 0, n = entry.FrameCount; i < n; ++i)
+        {
+            if (entry.FrameList[i] >= err.FirstFrame && entry.FrameList[i] <= err.FinalFrame && 
+               (entry.FrameState[i].Attributes & IMAGE_CACHE_ENTRY_FLAG_PARTIAL) != 0)
+            {   // the frame is evicted like any other once its lock count drops to zero.
+                entry.FrameState[i].Attributes &=~IMAGE_CACHE_ENTRY_FLAG_PARTIAL;
+                entry.FrameState[i].Attributes |= IMAGE_CACHE_ENTRY_FLAG_EVICT;
+                evict_frames = true;
+            }
+        }
+        if (evict_frames)
+        {
+            image_cache_process_pending_evict_and_drop(cache, entry_index);
+        }
+    }
+}
+
 /*////////////////////////
 //   Public Functions   //
 ////////////////////////*/
@@ -1588,6 +1751,7 @@ public_function void image_cache_create(image_cache_t *cache, size_t expected_im
     mpsc_fifo_u_init(&cache->DefinitionQueue);
     mpsc_fifo_u_init(&cache->LocationQueue);
     mpsc_fifo_u_init(&cache->CommandQueue);
+    mpsc_fifo_u_init(&cache->LoadErrorQueue);
 
     fifo_allocator_table_create(&cache->ErrorAlloc, 1);
     fifo_allocator_table_create(&cache->ResultAlloc, 8);
@@ -1600,6 +1764,7 @@ public_function void image_cache_delete(image_cache_t *cache)
     fifo_allocator_table_delete(&cache->ResultAlloc);
     fifo_allocator_table_delete(&cache->ErrorAlloc);
 
+    mpsc_fifo_u_delete(&cache->LoadErrorQueue);
     mpsc_fifo_u_delete(&cache->CommandQueue);
     mpsc_fifo_u_delete(&cache->LocationQueue);
     mpsc_fifo_u_delete(&cache->DefinitionQueue);
@@ -1617,9 +1782,11 @@ public_function void image_cache_delete(image_cache_t *cache)
         {
             frame_load_queue_list_delete(&cache->LoadList[i].ErrorQueues [j]);
             frame_load_queue_list_delete(&cache->LoadList[i].ResultQueues[j]);
+            frame_load_queue_list_delete(&cache->LoadList[i].PartialQueues[j]);
         }
         free(cache->LoadList[i].ErrorQueues);
         free(cache->LoadList[i].ResultQueues);
+        free(cache->LoadList[i].PartialQueues);
         free(cache->LoadList[i].RequestTime);
         free(cache->LoadList[i].FrameList);
     }
@@ -1786,13 +1953,14 @@ public_function bool image_cache_image_attributes(image_cache_t *cache, uintptr_
 /// @param result_queue The queue where results will be placed for each frame when available.
 /// @param error_queue The queue where errors will be placed for each frame.
 /// @param priority The priority value to use if a frame needs to be re-loaded into cache memory.
+/// @param options IMAGE_CACHE_COMMAND_OPTION_NONE, or IMAGE_CACHE_COMMAND_OPTION_PARTIAL to also receive results for frames that are only partially resident.
 /// @param thread_alloc The allocator used to submit cache control commands from the calling thread.
-public_function void image_cache_lock_frames(image_cache_t *cache, uintptr_t id, size_t first_frame, size_t final_frame, image_cache_result_queue_t *result_queue, image_cache_error_queue_t *error_queue, uint8_t priority, image_command_alloc_t *thread_alloc)
+public_function void image_cache_lock_frames(image_cache_t *cache, uintptr_t id, size_t first_frame, size_t final_frame, image_cache_result_queue_t *result_queue, image_cache_error_queue_t *error_queue, uint8_t priority, uint32_t options, image_command_alloc_t *thread_alloc)
 {
     fifo_node_t<image_cache_command_t> *n = fifo_allocator_get(thread_alloc);
     n->Item.CommandId   = IMAGE_CACHE_COMMAND_LOCK;
     n->Item.ImageId     = id;
-    n->Item.Options     = IMAGE_CACHE_COMMAND_OPTION_NONE;
+    n->Item.Options     = options;
     n->Item.FirstFrame  = first_frame;
     n->Item.FinalFrame  = final_frame;
     n->Item.ErrorQueue  = error_queue;
@@ -1842,6 +2010,19 @@ public_function void image_cache_preload_frames(image_cache_t *cache, uintptr_t
     mpsc_fifo_u_produce(&cache->CommandQueue, n);
 }
 
+/// @summary Reports a failed image load to the cache. Lock commands waiting on the frames of the load complete with an 
+/// error, and frames left partially resident are marked for eviction. The error is applied during the next cache update, 
+/// after any frame placements posted by the loader before the error.
+/// @param cache The image cache managing the image.
+/// @param err The load error reported by the image loader. The file path is not used.
+/// @param thread_alloc The allocator used to report load errors from the calling thread.
+public_function void image_cache_load_failed(image_cache_t *cache, image_load_error_t const &err, image_load_error_alloc_t *thread_alloc)
+{
+    fifo_node_t<image_load_error_t> *n = fifo_allocator_get(thread_alloc);
+    n->Item = err;
+    mpsc_fifo_u_produce(&cache->LoadErrorQueue, n);
+}
+
 /// @summary Executes a single update tick for an image cache.
 /// @param cache The image cache to update.
 public_function void image_cache_update(image_cache_t *cache)
@@ -1877,6 +2058,14 @@ public_function void image_cache_update(image_cache_t *cache)
         image_cache_update_location(cache, imgpos, now_time);
     }
 
+    // retire the frames of failed loads. a loader reports the error after the
+    // last placement of the load, so the placements above are never stale.
+    image_load_error_t loaderr;
+    while (mpsc_fifo_u_consume(&cache->LoadErrorQueue, loaderr))
+    {
+        image_cache_process_load_error(cache, loaderr);
+    }
+
     // process all newly received commands. unlock commands and lock 
     // commands for in-cache frames will complete immediately. lock 
     // commands that are not in-cache generate load commands and 
@@ -1968,9 +2157,10 @@ bool thread_image_cache_t::image_attributes(uintptr_t id, image_basic_data_t &at
 /// @param result_queue The queue where results will be placed for each frame when available.
 /// @param error_queue The queue where errors will be placed for each frame.
 /// @param priority The priority value to use if a frame needs to be re-loaded into cache memory.
-void thread_image_cache_t::lock(uintptr_t id, size_t first_frame, size_t final_frame, image_cache_result_queue_t *result_queue, image_cache_error_queue_t *error_queue, uint8_t priority)
+/// @param options IMAGE_CACHE_COMMAND_OPTION_NONE, or IMAGE_CACHE_COMMAND_OPTION_PARTIAL to also receive results for frames that are only partially resident.
+void thread_image_cache_t::lock(uintptr_t id, size_t first_frame, size_t final_frame, image_cache_result_queue_t *result_queue, image_cache_error_queue_t *error_queue, uint8_t priority, uint32_t options)
 {
-    image_cache_lock_frames(Cache, id, first_frame, final_frame, result_queue, error_queue, priority, &CommandAlloc);
+    image_cache_lock_frames(Cache, id, first_frame, final_frame, result_queue, error_queue, priority, options, &CommandAlloc);
 }
 
 /// @summary Request that one or more frames of an image be unlocked in cache memory, allowing them to be evicted.
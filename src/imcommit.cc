@@ -0,0 +1,186 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a background committer that commits and pre-faults the
+/// pages of an address range on a helper thread, so that the thread writing
+/// image data does not take a demand-zero page fault on every page it touches.
+/// Requests may be produced by any thread; posts are serialized by a lock,
+/// and consumed by the committer thread. Each request names a status
+/// word and a set of bits that the committer clears once the range is ready;
+/// the producer must not touch or release the range while the bits are set.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Defines a single request to commit and pre-fault a range of reserved address space.
+struct image_commit_request_t
+{
+    void                  *Address;         /// The address of the first byte to commit. Must be page-aligned.
+    size_t                 Size;            /// The number of bytes to commit. Must be a multiple of the page size.
+    uint32_t               NumaNode;        /// The NUMA node from which pages are committed, or NUMA_NO_PREFERRED_NODE.
+    uint32_t               ClearBits;       /// The bits to clear in *Status once the range has been committed and faulted.
+    std::atomic<uint32_t> *Status;          /// The status word signaled on completion. Must remain valid until the bits are cleared.
+};
+typedef fifo_allocator_t<image_commit_request_t> image_commit_alloc_t;
+typedef spsc_fifo_u_t   <image_commit_request_t> image_commit_queue_t;
+
+/// @summary Defines the state associated with a background committer thread.
+struct image_committer_t
+{
+    HANDLE                 Thread;          /// The handle of the committer thread.
+    HANDLE                 Wakeup;          /// An auto-reset event signaled when requests are posted.
+    HANDLE                 Shutdown;        /// A manual-reset event signaled to terminate the committer thread.
+    size_t                 PageSize;        /// The operating system page size, in bytes.
+    SRWLOCK                ProducerLock;    /// Serializes posts, so the queue and allocator only ever see one producer at a time.
+    image_commit_queue_t   RequestQueue;    /// The queue of pending requests, written by one producer at a time.
+    image_commit_alloc_t   RequestAlloc;    /// The node allocator used by the producer, accessed under ProducerLock.
+    std::atomic<uint64_t>  RequestCount;    /// The number of requests completed.
+    std::atomic<uint64_t>  BytesPrefaulted; /// The number of bytes committed and faulted by the committer thread.
+    uint32_t               CommitFailures;  /// The number of requests for which the commit failed. Written by the committer thread only.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Commits and pre-faults all pending requests. Bits are cleared even if the commit fails,
+/// in which case the producer takes the faults (or the failure) itself when it writes to the range.
+/// @param committer The background committer.
+internal_function void image_committer_drain(image_committer_t *committer)
+{
+    image_commit_request_t req;
+    while (spsc_fifo_u_consume(&committer->RequestQueue, req))
+    {
+        uint8_t *base = (uint8_t*) win32_numa_virtual_alloc(req.Address, req.Size, MEM_COMMIT, PAGE_READWRITE, req.NumaNode);
+        if (base != NULL)
+        {   // touch one byte per-page. the pages are demand-zero, so writing zero doesn't change their contents.
+            for (size_t offset = 0; offset < req.Size; offset += committer->PageSize)
+            {
+                ((uint8_t volatile*) base)[offset] = 0;
+            }
+            committer->BytesPrefaulted.fetch_add(req.Size, std::memory_order_relaxed);
+        }
+        else committer->CommitFailures++;
+        committer->RequestCount.fetch_add(1, std::memory_order_relaxed);
+        req.Status->fetch_and(~req.ClearBits, std::memory_order_release);
+    }
+}
+
+/// @summary Implements the main loop of the committer thread.
+/// @param args The image_committer_t instance.
+/// @return Zero if the thread has terminated normally.
+internal_function unsigned __stdcall image_committer_thread(void *args)
+{
+    image_committer_t *committer  = (image_committer_t*) args;
+    HANDLE             wait_list[]= { committer->Shutdown, committer->Wakeup };
+    for ( ; ; )
+    {
+        DWORD result = WaitForMultipleObjects(2, wait_list, FALSE, INFINITE);
+        // always drain the queue, even when shutting down, so no producer waits forever.
+        image_committer_drain(committer);
+        if (result != (WAIT_OBJECT_0 + 1))
+        {   // shutdown was signaled, or the wait failed.
+            break;
+        }
+    }
+    return 0;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize a background committer and launch its thread.
+/// @param committer The background committer to initialize.
+/// @return true if the committer thread was launched.
+public_function bool image_committer_create(image_committer_t *committer)
+{
+    SYSTEM_INFO sysinfo = {};
+    GetNativeSystemInfo(&sysinfo);
+    committer->Thread         = NULL;
+    committer->Wakeup         = CreateEvent(NULL, FALSE, FALSE, NULL);
+    committer->Shutdown       = CreateEvent(NULL, TRUE , FALSE, NULL);
+    committer->PageSize       =(size_t) sysinfo.dwPageSize;
+    committer->CommitFailures = 0;
+    committer->RequestCount.store(0, std::memory_order_relaxed);
+    committer->BytesPrefaulted.store(0, std::memory_order_relaxed);
+    InitializeSRWLock(&committer->ProducerLock);
+    spsc_fifo_u_init(&committer->RequestQueue);
+    fifo_allocator_init(&committer->RequestAlloc);
+    if (committer->Wakeup == NULL || committer->Shutdown == NULL)
+    {   // unable to create the synchronization objects.
+        return false;
+    }
+    committer->Thread = (HANDLE) _beginthreadex(NULL, 0, image_committer_thread, committer, 0, NULL);
+    return (committer->Thread != NULL);
+}
+
+/// @summary Stop the committer thread and free all resources associated with a background committer.
+/// Any requests still queued are completed before the thread exits.
+/// @param committer The background committer to delete.
+public_function void image_committer_delete(image_committer_t *committer)
+{
+    if (committer->Thread != NULL)
+    {   // signal the thread to exit, and wait for it to finish.
+        SetEvent(committer->Shutdown);
+        WaitForSingleObject(committer->Thread, INFINITE);
+        CloseHandle(committer->Thread);
+        committer->Thread = NULL;
+    }
+    else
+    {   // the thread was never launched; complete any requests here.
+        image_committer_drain(committer);
+    }
+    if (committer->Shutdown != NULL) CloseHandle(committer->Shutdown);
+    if (committer->Wakeup   != NULL) CloseHandle(committer->Wakeup);
+    committer->Shutdown = NULL;
+    committer->Wakeup   = NULL;
+    spsc_fifo_u_delete(&committer->RequestQueue);
+    fifo_allocator_reinit(&committer->RequestAlloc);
+}
+
+/// @summary Queue a range of reserved address space to be committed and pre-faulted. This function may be
+/// called from any thread. The caller must set clear_bits in *status before posting.
+/// @param committer The background committer.
+/// @param address The page-aligned address of the first byte to commit.
+/// @param size The number of bytes to commit, a multiple of the page size.
+/// @param numa_node The NUMA node from which pages are committed, or NUMA_NO_PREFERRED_NODE.
+/// @param status The status word signaled on completion.
+/// @param clear_bits The bits to clear in *status once the range is ready.
+public_function void image_committer_post(image_committer_t *committer, void *address, size_t size, uint32_t numa_node, std::atomic<uint32_t> *status, uint32_t clear_bits)
+{   // parser threads writing different images post concurrently; the queue has a single-producer interface.
+    AcquireSRWLockExclusive(&committer->ProducerLock);
+    fifo_node_t<image_commit_request_t> *n = fifo_allocator_get(&committer->RequestAlloc);
+    n->Item.Address   = address;
+    n->Item.Size      = size;
+    n->Item.NumaNode  = numa_node;
+    n->Item.ClearBits = clear_bits;
+    n->Item.Status    = status;
+    spsc_fifo_u_produce(&committer->RequestQueue, n);
+    ReleaseSRWLockExclusive(&committer->ProducerLock);
+    SetEvent(committer->Wakeup);
+}
+
+/// @summary Wait for the committer to finish with a range. Returns immediately if the bits are already clear.
+/// @param status The status word specified when the request was posted.
+/// @param clear_bits The bits specified when the request was posted.
+public_function void image_committer_wait(std::atomic<uint32_t> const &status, uint32_t clear_bits)
+{
+    while (status.load(std::memory_order_acquire) & clear_bits)
+    {   // the committer has not reached this request yet; give up the timeslice.
+        SwitchToThread();
+    }
+}
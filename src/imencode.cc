@@ -16,6 +16,9 @@
 /*/////////////////
 //   Constants   //
 /////////////////*/
+/// @summary The number of staged bands an encoder may have in flight on its worker pool.
+/// While the pool works on one band, the loader thread fills the staging buffer of the next.
+#define IMAGE_ENCODER_MAX_BANDS   2
 
 /*///////////////////
 //   Local Types   //
@@ -46,6 +49,15 @@ struct image_encoder_t
         size_t                   src_size
     ) = 0;                                       /// Encode and append data to an image element.
 
+    virtual uint32_t          encode_rows
+    (
+        size_t                   element,
+        size_t                   first_row,
+        void const              *src_data,
+        size_t                   row_count
+    );                                           /// Write whole rows of the current level at their final offsets.
+                                                 /// Returns ERROR_NOT_SUPPORTED if the encoder can only append.
+
     virtual uint32_t          mark_level
     (
         size_t                   element
@@ -74,7 +86,9 @@ private: // non-copyable
     image_encoder_t& operator =(image_encoder_t const&);
 };
 
-/// @summary Defines an image encoder type that performs no transformation to the source data.
+/// @summary Defines an image encoder type that performs no transformation to the source data. 
+/// If the image memory manager specifies a row alignment, the rows of uncompressed levels are 
+/// padded to the aligned pitch as they are written; otherwise the data is copied unchanged.
 struct image_encoder_identity_t final : public image_encoder_t
 {
     image_encoder_identity_t(void);
@@ -97,6 +111,425 @@ struct image_encoder_identity_t final : public image_encoder_t
         size_t                   src_size
     ) override;                                  /// Encode and append data to the current level.
 
+    uint32_t                  encode_rows
+    (
+        size_t                   element,
+        size_t                   first_row,
+        void const              *src_data,
+        size_t                   row_count
+    ) override;                                  /// Write whole rows of the current level at their final offsets.
+
+    uint32_t                  mark_level
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current level.
+
+    uint32_t                  mark_element
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current element.
+
+    bool                      define_target      /// Build the padded target image definition from the source metadata.
+    (
+        void
+    );
+
+    image_definition_t        Target;            /// The image definition describing the padded output. Valid only if RowsPadded is true.
+    bool                      TargetDefined;     /// true if the row layout has been determined.
+    bool                      RowsPadded;        /// true if one or more levels are stored with a padded row pitch.
+    size_t                    ElementIndex;      /// The zero-based index of the element being encoded.
+    size_t                    LevelIndex;        /// The zero-based index of the level being encoded.
+    size_t                    RowFill;           /// The number of bytes of the current source row written so far.
+    size_t                    BytesWritten;      /// The number of bytes written to the element since the most recent call to reset_element.
+    size_t                    LevelStart;        /// The value of BytesWritten at the start of the current level.
+    uint8_t                  *LevelData;         /// The committed storage for the current level, if it is being written with encode_rows, or NULL.
+};
+
+/// @summary Describes a band of block rows being compressed on a worker pool. Each work item compresses one block row.
+struct image_encoder_bcn_band_t
+{
+    uint32_t                  TargetFormat;      /// One of dxgi_format_e specifying the block-compressed format.
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the format of the source data.
+    int                       Quality;           /// One of image_encoder_quality_e.
+    dds_level_desc_t const   *Source;            /// The source level descriptor.
+    uint8_t                  *Staging;           /// Storage for up to BandRows * 4 rows of level 0 source data.
+    uint8_t                  *Target;            /// The final location of the first block row of the band in image memory.
+    size_t                    TargetPitch;       /// The number of bytes in one row of compressed blocks at the current level.
+    size_t                    Rows;              /// The number of valid source rows in the band.
+    std::atomic<size_t>       Failures;          /// The number of block rows that could not be compressed.
+    work_pool_batch_t         Batch;             /// The worker pool batch compressing the band.
+    bool                      Busy;              /// true if Batch has been submitted and not yet waited on.
+};
+
+/// @summary Defines an image encoder type that block-compresses RGBA8 or BGRA8 
+/// source data to BC1, BC3, BC4, BC5 or BC7, or RGBA16F or RGBA32F source data 
+/// to BC6H. Source rows are staged until a band of block rows is available. The 
+/// output for the band is committed in image memory, and the rows of the band 
+/// are compressed directly to their final offsets on a worker pool, if one was 
+/// supplied, while the next band is staged. mark_level and mark_element wait for 
+/// every outstanding band. One element is encoded at a time.
+struct image_encoder_bcn_t final : public image_encoder_t
+{
+    image_encoder_bcn_t(void);
+    ~image_encoder_bcn_t(void);
+
+    uint32_t                  define_image
+    (
+        image_definition_t const *def
+    ) override;                                  /// Reserve address space, if required.
+
+    uint32_t                  reset_element
+    (
+        size_t                   element
+    ) override;                                  /// Start writing data to an image element.
+
+    uint32_t                  encode
+    (
+        size_t                   element,
+        void const              *src_data, 
+        size_t                   src_size
+    ) override;                                  /// Encode and append data to the current level.
+
+    uint32_t                  mark_level
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current level.
+
+    uint32_t                  mark_element
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current element.
+
+    bool                      define_target      /// Build the target image definition from the source metadata.
+    (
+        void
+    );
+
+    uint32_t                  flush_rows         /// Commit the output for the staged band of block rows and start compressing it.
+    (
+        size_t                   rows
+    );
+
+    uint32_t                  wait_band          /// Wait for a band to finish compressing.
+    (
+        size_t                   index
+    );
+
+    uint32_t                  wait_bands         /// Wait for every band to finish compressing.
+    (
+        void
+    );
+
+    image_definition_t        Target;            /// The image definition describing the block-compressed output.
+    bool                      TargetDefined;     /// true if Target has been initialized.
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the format of the source data. Constant.
+    int                       Quality;           /// One of image_encoder_quality_e. Constant.
+    work_pool_t              *WorkPool;          /// The worker pool used to compress block rows, or NULL. Constant.
+    size_t                    BandRows;          /// The maximum number of block rows compressed per-flush.
+    size_t                    BandCount;         /// The number of entries in Bands that are in use.
+    size_t                    BandIndex;         /// The zero-based index of the band being staged.
+    size_t                    ElementIndex;      /// The zero-based index of the element being encoded.
+    size_t                    LevelIndex;        /// The zero-based index of the level being encoded.
+    size_t                    SliceIndex;        /// The zero-based index of the slice being encoded within the current level.
+    size_t                    RowIndex;          /// The zero-based index of the first source row in the staging buffer, within the current slice.
+    size_t                    BytesWritten;      /// The number of bytes committed to the element since the most recent call to reset_element.
+    size_t                    StagingSize;       /// The number of source bytes in the staging buffer of the current band.
+    image_encoder_bcn_band_t  Bands[IMAGE_ENCODER_MAX_BANDS]; /// The staging buffers and worker pool batches.
+};
+
+/// @summary Describes a band of block rows being decoded on a worker pool. Each work item decodes one block row.
+struct image_encoder_bcn_decode_band_t
+{
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the block-compressed source format.
+    uint32_t                  TargetFormat;      /// One of dxgi_format_e specifying the decoded format.
+    uint8_t                  *Staging;           /// Storage for up to BandRows rows of level 0 compressed blocks.
+    uint8_t                  *Target;            /// The final location of the first pixel row of the band in image memory.
+    size_t                    SourcePitch;       /// The number of bytes in one row of compressed blocks at the current level.
+    size_t                    TargetPitch;       /// The number of bytes in one row of decoded pixels at the current level.
+    size_t                    Width;             /// The width of the current level, in pixels.
+    size_t                    Rows;              /// The number of valid pixel rows in the band.
+    std::atomic<size_t>       Failures;          /// The number of block rows that could not be decoded.
+    work_pool_batch_t         Batch;             /// The worker pool batch decoding the band.
+    bool                      Busy;              /// true if Batch has been submitted and not yet waited on.
+};
+
+/// @summary Defines an image encoder type that decompresses BC1-BC7 source data 
+/// to RGBA8, BGRA8 or RGBA16F, so that block-compressed images can be used by 
+/// consumers that read pixels on the CPU. Source block rows are staged until a 
+/// band is available. The output for the band is committed in image memory, and 
+/// the rows of the band are decoded directly to their final offsets on a worker 
+/// pool, if one was supplied, while the next band is staged. mark_level and 
+/// mark_element wait for every outstanding band. One element is encoded at a time.
+struct image_encoder_bcn_decode_t final : public image_encoder_t
+{
+    image_encoder_bcn_decode_t(void);
+    ~image_encoder_bcn_decode_t(void);
+
+    uint32_t                  define_image
+    (
+        image_definition_t const *def
+    ) override;                                  /// Reserve address space, if required.
+
+    uint32_t                  reset_element
+    (
+        size_t                   element
+    ) override;                                  /// Start writing data to an image element.
+
+    uint32_t                  encode
+    (
+        size_t                   element,
+        void const              *src_data, 
+        size_t                   src_size
+    ) override;                                  /// Decode and append data to the current level.
+
+    uint32_t                  mark_level
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current level.
+
+    uint32_t                  mark_element
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current element.
+
+    bool                      define_target      /// Build the target image definition from the source metadata.
+    (
+        void
+    );
+
+    uint32_t                  flush_rows         /// Commit the output for the staged band of block rows and start decoding it.
+    (
+        size_t                   block_rows
+    );
+
+    uint32_t                  wait_band          /// Wait for a band to finish decoding.
+    (
+        size_t                   index
+    );
+
+    uint32_t                  wait_bands         /// Wait for every band to finish decoding.
+    (
+        void
+    );
+
+    image_definition_t        Target;            /// The image definition describing the decoded output.
+    bool                      TargetDefined;     /// true if Target has been initialized.
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the block-compressed source format. Constant.
+    work_pool_t              *WorkPool;          /// The worker pool used to decode block rows, or NULL. Constant.
+    size_t                    BandRows;          /// The maximum number of block rows decoded per-flush.
+    size_t                    BandCount;         /// The number of entries in Bands that are in use.
+    size_t                    BandIndex;         /// The zero-based index of the band being staged.
+    size_t                    ElementIndex;      /// The zero-based index of the element being encoded.
+    size_t                    LevelIndex;        /// The zero-based index of the level being encoded.
+    size_t                    SliceIndex;        /// The zero-based index of the slice being encoded within the current level.
+    size_t                    RowIndex;          /// The zero-based index of the first block row in the staging buffer, within the current slice.
+    size_t                    BytesWritten;      /// The number of bytes committed to the element since the most recent call to reset_element.
+    size_t                    StagingSize;       /// The number of source bytes in the staging buffer of the current band.
+    image_encoder_bcn_decode_band_t Bands[IMAGE_ENCODER_MAX_BANDS]; /// The staging buffers and worker pool batches.
+};
+
+/// @summary Defines an image encoder type that converts uncompressed source data 
+/// from one pixel format to another; for example, BGRA8 to RGBA8, R10G10B10A2 to 
+/// RGBA16F or RGBA32F to RGBA16F. The color stages, such as premultiplication and 
+/// sRGB decoding, are applied here, so the converted frame is stored ready for 
+/// blending and nothing is reconverted when it is presented. Each chunk of source data passed to encode() is 
+/// converted directly into the committed image memory, without staging, so the 
+/// only buffered data is a pixel split across two chunks.
+struct image_encoder_convert_t final : public image_encoder_t
+{
+    image_encoder_convert_t(void);
+    ~image_encoder_convert_t(void);
+
+    uint32_t                  define_image
+    (
+        image_definition_t const *def
+    ) override;                                  /// Reserve address space, if required.
+
+    uint32_t                  reset_element
+    (
+        size_t                   element
+    ) override;                                  /// Start writing data to an image element.
+
+    uint32_t                  encode
+    (
+        size_t                   element,
+        void const              *src_data, 
+        size_t                   src_size
+    ) override;                                  /// Convert and append data to the current level.
+
+    uint32_t                  mark_level
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current level.
+
+    uint32_t                  mark_element
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current element.
+
+    bool                      define_target      /// Build the target image definition from the source metadata.
+    (
+        void
+    );
+
+    uint32_t                  write_pixels       /// Convert whole source pixels and append them to the current level.
+    (
+        uint8_t const           *src, 
+        size_t                   count
+    );
+
+    image_definition_t        Target;            /// The image definition describing the converted output.
+    bool                      TargetDefined;     /// true if Target has been initialized.
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the format of the source data. Constant.
+    uint32_t                  ColorFlags;        /// The IMAGE_ENCODER_FLAGS_COLOR_STAGES flags applied during conversion. Constant.
+    pixel_convert_t           Convert;           /// The conversion kernel and pixel sizes.
+    size_t                    ElementIndex;      /// The zero-based index of the element being encoded.
+    size_t                    BytesWritten;      /// The number of bytes written to the element since the most recent call to reset_element.
+    size_t                    CarrySize;         /// The number of bytes of a partial source pixel held in Carry.
+    uint8_t                   Carry[PIXEL_CONVERT_MAX_SIZE]; /// Storage for a source pixel split across two calls to encode.
+};
+
+/// @summary Defines an image encoder type that converts AYUV, YUY2, NV12 or P010 
+/// source data to RGBA8, BGRA8 or RGBA16F. 4:2:0 chroma for a row is taken from 
+/// rows of the chroma plane that follow the whole luma plane, so each level is 
+/// staged in full, and converted when the level is marked complete. Bands of 
+/// rows are converted in parallel on the worker pool, if there is one. One 
+/// element is encoded at a time.
+struct image_encoder_yuv_t final : public image_encoder_t
+{
+    image_encoder_yuv_t(void);
+    ~image_encoder_yuv_t(void);
+
+    uint32_t                  define_image
+    (
+        image_definition_t const *def
+    ) override;                                  /// Reserve address space, if required.
+
+    uint32_t                  reset_element
+    (
+        size_t                   element
+    ) override;                                  /// Start writing data to an image element.
+
+    uint32_t                  encode
+    (
+        size_t                   element,
+        void const              *src_data, 
+        size_t                   src_size
+    ) override;                                  /// Stage data for the current level.
+
+    uint32_t                  mark_level
+    (
+        size_t                   element
+    ) override;                                  /// Convert the staged level and mark the end of the current level.
+
+    uint32_t                  mark_element
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current element.
+
+    bool                      define_target      /// Build the target image definition from the source metadata.
+    (
+        void
+    );
+
+    image_definition_t        Target;            /// The image definition describing the converted output.
+    bool                      TargetDefined;     /// true if Target has been initialized.
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the format of the source data. Constant.
+    uint32_t                  YuvFlags;          /// The matrix, range and chroma filter flags from image_encoder_flags_e. Constant.
+    yuv_convert_t             Convert;           /// The conversion descriptor.
+    work_pool_t              *WorkPool;          /// The worker pool used to convert bands of rows, or NULL. Constant.
+    size_t                    ElementIndex;      /// The zero-based index of the element being encoded.
+    size_t                    LevelIndex;        /// The zero-based index of the level being encoded.
+    size_t                    BytesWritten;      /// The number of bytes written to the element since the most recent call to reset_element.
+    size_t                    StagingSize;       /// The number of source bytes of the current level in the staging buffer.
+    uint8_t                  *Staging;           /// Storage for the largest source level.
+};
+
+/// @summary Defines an image encoder type that stores source data without any 
+/// format conversion, using IMAGE_ENCODING_LZ. Source data is staged in chunks 
+/// of IMAGE_LZ_CHUNK_SIZE bytes; each chunk is compressed with the LZ codec and 
+/// appended to the current level. Chunks never span levels, so each level can 
+/// be decoded independently. Consumers decode the data with image_lz_decode(), 
+/// usually through an image_scratch_pool_t. One element is encoded at a time.
+struct image_encoder_lz_t final : public image_encoder_t
+{
+    image_encoder_lz_t(void);
+    ~image_encoder_lz_t(void);
+
+    uint32_t                  define_image
+    (
+        image_definition_t const *def
+    ) override;                                  /// Reserve address space, if required.
+
+    uint32_t                  reset_element
+    (
+        size_t                   element
+    ) override;                                  /// Start writing data to an image element.
+
+    uint32_t                  encode
+    (
+        size_t                   element,
+        void const              *src_data, 
+        size_t                   src_size
+    ) override;                                  /// Compress and append data to the current level.
+
+    uint32_t                  mark_level
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current level.
+
+    uint32_t                  mark_element
+    (
+        size_t                   element
+    ) override;                                  /// Mark the end of the current element.
+
+    bool                      define_target      /// Build the target image definition from the source metadata.
+    (
+        void
+    );
+
+    uint32_t                  flush_chunk        /// Compress and write the staged chunk.
+    (
+        void
+    );
+
+    image_definition_t        Target;            /// The image definition describing the LZ-encoded output.
+    bool                      TargetDefined;     /// true if Target has been initialized.
+    size_t                    ElementIndex;      /// The zero-based index of the element being encoded.
+    size_t                    ChunkSize;         /// The number of bytes of source data in Chunk.
+    uint8_t                  *Chunk;             /// Storage for IMAGE_LZ_CHUNK_SIZE bytes of source data.
+    uint8_t                  *Packed;            /// Storage for one chunk header and IMAGE_LZ_CHUNK_SIZE bytes of chunk data.
+};
+
+/// @summary Defines an image encoder stage that generates a complete mipmap 
+/// chain for images that supply only level 0. All data is passed through to 
+/// an inner encoder, which performs any format conversion and writes to image 
+/// memory. Level 0 rows are staged in bands and reduced to level 1 as they are 
+/// received; the remaining levels are produced from level 1 after level 0 is 
+/// marked complete. The inner encoder is given the extended image definition, 
+/// so the definition it posts describes every generated level.
+struct image_encoder_mipmap_t final : public image_encoder_t
+{
+    image_encoder_mipmap_t(image_encoder_t *inner);
+    ~image_encoder_mipmap_t(void);
+
+    uint32_t                  define_image
+    (
+        image_definition_t const *def
+    ) override;                                  /// Reserve address space, if required.
+
+    uint32_t                  reset_element
+    (
+        size_t                   element
+    ) override;                                  /// Start writing data to an image element.
+
+    uint32_t                  encode
+    (
+        size_t                   element,
+        void const              *src_data, 
+        size_t                   src_size
+    ) override;                                  /// Encode and append data to the current level.
+
     uint32_t                  mark_level
     (
         size_t                   element
@@ -106,6 +539,32 @@ struct image_encoder_identity_t final : public image_encoder_t
     (
         size_t                   element
     ) override;                                  /// Mark the end of the current element.
+
+    bool                      define_chain       /// Build the extended image definition from the source metadata.
+    (
+        void
+    );
+
+    void                      reduce_rows        /// Reduce the staged band of level 0 rows into level 1.
+    (
+        size_t                   rows
+    );
+
+    image_encoder_t          *Inner;             /// The encoder receiving every level. Owned by this stage. Constant.
+    image_definition_t        Chain;             /// The image definition extended with the generated levels.
+    bool                      ChainDefined;      /// true if define_chain has completed.
+    bool                      Generate;          /// true if levels are generated, or false if all data is passed through.
+    work_pool_t              *WorkPool;          /// The worker pool used to reduce rows, or NULL. Constant.
+    image_mipmap_t            Filter;            /// The box filter description for the source format.
+    size_t                    BandRows;          /// The maximum number of level 1 rows produced per-band.
+    size_t                    ElementIndex;      /// The zero-based index of the element being encoded.
+    size_t                    LevelIndex;        /// The zero-based index of the level being encoded.
+    size_t                    RowIndex;          /// The zero-based index of the first level 0 row in the staging buffer.
+    size_t                    TargetRows;        /// The number of level 1 rows produced for the current element.
+    size_t                    StagingSize;       /// The number of source bytes in the staging buffer.
+    uint8_t                  *Staging;           /// Storage for up to BandRows * 2 rows of level 0.
+    uint8_t                  *LevelRows;         /// Storage for level 1, and then odd levels.
+    uint8_t                  *Scratch;           /// Storage for level 2, and then even levels.
 };
 
 /*///////////////
@@ -115,11 +574,8 @@ struct image_encoder_identity_t final : public image_encoder_t
 /*///////////////////////
 //   Local Functions   //
 ///////////////////////*/
-
-/*////////////////////////
-//   Public Functions   //
-////////////////////////*/
-/// @summary Allocate and initialize a new image encoder implementing the given transformation.
+/// @summary Initialize the fields common to all image encoder types.
+/// @param enc The image encoder to initialize.
 /// @param image_id The application-defined image identifier.
 /// @param mem The image memory manager to which the output data will be written.
 /// @param src_comp One of image_compression_e specifying the source data compression type.
@@ -131,70 +587,277 @@ struct image_encoder_identity_t final : public image_encoder_t
 /// @param defa The FIFO node allocator used to write to the image definition queue from the encoder thread.
 /// @param locq The unbounded MPSC queue to which image placement data will be posted.
 /// @param loca The FIFO node allocator used to write to the image placement queue from the encoder thread.
-/// @return The image encoder, or NULL if no encoder type can perform the specified conversion.
-public_function image_encoder_t* create_image_encoder(uintptr_t image_id, image_memory_t *mem, int src_comp, int src_enc, int dst_comp, int dst_enc, int access_type, image_definition_queue_t *defq=NULL, image_definition_alloc_t *defa=NULL, image_location_queue_t *locq=NULL, image_location_alloc_t *loca=NULL)
-{
-    if (src_comp == dst_comp && src_enc == dst_enc)
-    {   // use the most common encoder type - the identity encoder.
-        image_encoder_identity_t *enc = new image_encoder_identity_t();
-        enc->Memory            =  mem;
-        enc->DefinitionQueue   =  defq;
-        enc->DefinitionAlloc   =  defa;
-        enc->PlacementQueue    =  locq;
-        enc->PlacementAlloc    =  loca;
-        enc->ImageId           =  image_id;
-        enc->AccessType        =  access_type;
-        enc->SourceCompression =  src_comp;
-        enc->SourceEncoding    =  src_enc;
-        enc->TargetCompression =  dst_comp;
-        enc->TargetEncoding    =  dst_enc;
-        enc->Metadata          =  NULL;
-        return enc;
-    }
-    return NULL;
-}
-
-/// @summary Default constructor. Doesn't initialize any fields, because all fields should instead be initialized by the create_image_encoder() factory function.
-image_encoder_t::image_encoder_t(void)
-{
-    /* empty */
-}
-
-/// @summary Default destructor. Does nothing because there are no resources to free.
-image_encoder_t::~image_encoder_t(void)
+/// @return The image encoder.
+internal_function image_encoder_t* image_encoder_setup(image_encoder_t *enc, uintptr_t image_id, image_memory_t *mem, int src_comp, int src_enc, int dst_comp, int dst_enc, int access_type, image_definition_queue_t *defq, image_definition_alloc_t *defa, image_location_queue_t *locq, image_location_alloc_t *loca)
 {
-    /* empty */
+    enc->Memory            =  mem;
+    enc->DefinitionQueue   =  defq;
+    enc->DefinitionAlloc   =  defa;
+    enc->PlacementQueue    =  locq;
+    enc->PlacementAlloc    =  loca;
+    enc->ImageId           =  image_id;
+    enc->AccessType        =  access_type;
+    enc->SourceCompression =  src_comp;
+    enc->SourceEncoding    =  src_enc;
+    enc->TargetCompression =  dst_comp;
+    enc->TargetEncoding    =  dst_enc;
+    enc->Metadata          =  NULL;
+    return enc;
 }
 
-/// @summary Constructs a new identity encoder, which performs no transformation on the source data.
-image_encoder_identity_t::image_encoder_identity_t(void)
+/// @summary Compresses one block row of a staged band directly into image memory. Called on a worker pool thread.
+/// @param context The image_encoder_bcn_band_t describing the band.
+/// @param index The zero-based index of the block row within the band.
+internal_function void image_encoder_bcn_band_row(void *context, size_t index)
 {
-    /* empty */
+    image_encoder_bcn_band_t *band = (image_encoder_bcn_band_t*) context;
+    size_t                    y    =  index * 4;
+    size_t                    rows =  image_min2<size_t>(4, band->Rows - y);
+    uint8_t const            *src  =  band->Staging + y * band->Source->BytesPerRow;
+    uint8_t                  *dst  =  band->Target  + index * band->TargetPitch;
+    if (bc_encode_block_row(band->TargetFormat, band->Quality, band->SourceFormat, src, band->Source->BytesPerRow, band->Source->Width, rows, dst) == 0)
+    {   // the format is not supported; this is not expected.
+        band->Failures.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
-/// @summary Frees any resources associated with the identity encoder.
-image_encoder_identity_t::~image_encoder_identity_t(void)
+/// @summary Decodes one block row of a staged band directly into image memory. Called on a worker pool thread.
+/// @param context The image_encoder_bcn_decode_band_t describing the band.
+/// @param index The zero-based index of the block row within the band.
+internal_function void image_encoder_bcn_decode_band_row(void *context, size_t index)
 {
-    /* empty */
+    image_encoder_bcn_decode_band_t *band = (image_encoder_bcn_decode_band_t*) context;
+    size_t                           y    =  index * 4;
+    size_t                           rows =  image_min2<size_t>(4, band->Rows - y);
+    uint8_t const                   *src  =  band->Staging + index * band->SourcePitch;
+    uint8_t                         *dst  =  band->Target  + y * band->TargetPitch;
+    if (!bc_decode_rect(band->SourceFormat, band->TargetFormat, src, band->SourcePitch, 0, 0, band->Width, rows, dst, band->TargetPitch))
+    {   // the format is not supported; this is not expected.
+        band->Failures.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
-/// @summary Defines the complete attributes of an image and reserves process address space for image storage.
-/// @param def The image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
-/// @return ERROR_SUCCESS, or a system error code.
-uint32_t image_encoder_identity_t::define_image(image_definition_t const *def)
-{   // save a reference to the metadata for later access.
-    Metadata = def;
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Allocate and initialize a new image encoder implementing the given transformation.
+/// @param image_id The application-defined image identifier.
+/// @param mem The image memory manager to which the output data will be written.
+/// @param src_comp One of image_compression_e specifying the source data compression type.
+/// @param src_enc One of image_encoding_e specifying the source data encoding type.
+/// @param dst_comp One of image_compression_e specifying the target data compression type.
+/// @param dst_enc One of image_encoding_e specifying the target data encoding type.
+/// @param access_type One of image_access_type_e specifying how the data will be accessed.
+/// @param defq The unbounded MPSC queue to which image definitions will be posted.
+/// @param defa The FIFO node allocator used to write to the image definition queue from the encoder thread.
+/// @param locq The unbounded MPSC queue to which image placement data will be posted.
+/// @param loca The FIFO node allocator used to write to the image placement queue from the encoder thread.
+/// @param src_format One of dxgi_format_e specifying the format of the source pixel data.
+/// @param dst_format One of dxgi_format_e specifying the format of the stored pixel data, or DXGI_FORMAT_UNKNOWN to store the source format.
+/// @param quality One of image_encoder_quality_e, used by encoders that trade quality for speed.
+/// @param pool The worker pool used by encoders that process data in parallel, or NULL to encode on the calling thread.
+/// @param flags A combination of image_encoder_flags_e enabling optional encoder stages.
+/// @return The image encoder, or NULL if no encoder type can perform the specified conversion.
+public_function image_encoder_t* create_image_encoder(uintptr_t image_id, image_memory_t *mem, int src_comp, int src_enc, int dst_comp, int dst_enc, int access_type, image_definition_queue_t *defq=NULL, image_definition_alloc_t *defa=NULL, image_location_queue_t *locq=NULL, image_location_alloc_t *loca=NULL, uint32_t src_format=DXGI_FORMAT_UNKNOWN, uint32_t dst_format=DXGI_FORMAT_UNKNOWN, int quality=IMAGE_ENCODER_QUALITY_NORMAL, work_pool_t *pool=NULL, uint32_t flags=IMAGE_ENCODER_FLAGS_NONE)
+{
+    image_encoder_t *enc = NULL;
+    uint32_t color   = flags & IMAGE_ENCODER_FLAGS_COLOR_STAGES;
+    uint32_t bc_fmt  = bc_encoder_target_format  (src_format, dst_format);
+    uint32_t raw_fmt = bc_decoder_target_format  (src_format, dst_format);
+    uint32_t px_fmt  = pixel_convert_target_format(src_format, dst_format, color);
+    uint32_t yuv_fmt = yuv_convert_target_format  (src_format, dst_format);
+    bool     same_fmt=(color == 0) && (dst_format == DXGI_FORMAT_UNKNOWN || dst_format == src_format || px_fmt == src_format);
+    if (src_comp != dst_comp)
+    {   // no encoder types currently change the compression.
+        return NULL;
+    }
+    if (src_enc != dst_enc)
+    {   // the only supported change of encoding is RAW to LZ, without format conversion.
+        if (src_enc != IMAGE_ENCODING_RAW || dst_enc != IMAGE_ENCODING_LZ || !same_fmt)
+            return NULL;
+        enc = new image_encoder_lz_t();
+    }
+    else if (same_fmt)
+    {   // use the most common encoder type - the identity encoder. 
+        // the requested format may differ from the source only in sRGB-ness, which is preserved.
+        enc = new image_encoder_identity_t();
+    }
+    else if (yuv_fmt != DXGI_FORMAT_UNKNOWN)
+    {   // convert YUV source data to RGB. the color stages aren't applied to YUV data.
+        if (color != 0)
+            return NULL;
+        image_encoder_yuv_t *yuv = new image_encoder_yuv_t();
+        yuv->Target.ImageFormat  = yuv_fmt;
+        yuv->SourceFormat        = src_format;
+        yuv->YuvFlags            = flags & IMAGE_ENCODER_FLAGS_YUV_STAGES;
+        yuv->WorkPool            = pool;
+        enc = yuv;
+    }
+    else if (color != 0)
+    {   // the color stages are applied by the conversion encoder, and can't be combined with block compression.
+        if (px_fmt == DXGI_FORMAT_UNKNOWN)
+            return NULL;
+        image_encoder_convert_t *cvt = new image_encoder_convert_t();
+        cvt->Target.ImageFormat  = px_fmt;
+        cvt->SourceFormat        = src_format;
+        cvt->ColorFlags          = color;
+        enc = cvt;
+    }
+    else if (bc_fmt != DXGI_FORMAT_UNKNOWN)
+    {   // block-compress RGBA8, BGRA8 or floating-point source data.
+        image_encoder_bcn_t *bcn = new image_encoder_bcn_t();
+        bcn->Target.ImageFormat  = bc_fmt;
+        bcn->SourceFormat        = src_format;
+        bcn->Quality             = quality;
+        bcn->WorkPool            = pool;
+        enc = bcn;
+    }
+    else if (raw_fmt != DXGI_FORMAT_UNKNOWN)
+    {   // decompress block-compressed source data.
+        image_encoder_bcn_decode_t *dec = new image_encoder_bcn_decode_t();
+        dec->Target.ImageFormat  = raw_fmt;
+        dec->SourceFormat        = src_format;
+        dec->WorkPool            = pool;
+        enc = dec;
+    }
+    else if (px_fmt != DXGI_FORMAT_UNKNOWN)
+    {   // swizzle, expand or unpack uncompressed source data.
+        image_encoder_convert_t *cvt = new image_encoder_convert_t();
+        cvt->Target.ImageFormat  = px_fmt;
+        cvt->SourceFormat        = src_format;
+        enc = cvt;
+    }
+    else return NULL;
+
+    image_encoder_setup(enc, image_id, mem, src_comp, src_enc, dst_comp, dst_enc, access_type, defq, defa, locq, loca);
+    if (flags & IMAGE_ENCODER_FLAGS_GENERATE_MIPMAPS)
+    {   // generate missing levels from the source data, ahead of any conversion.
+        image_encoder_mipmap_t *mip = new image_encoder_mipmap_t(enc);
+        mip->WorkPool = pool;
+        return image_encoder_setup(mip, image_id, mem, src_comp, src_enc, dst_comp, dst_enc, access_type, defq, defa, locq, loca);
+    }
+    return enc;
+}
+
+/// @summary Default constructor. Doesn't initialize any fields, because all fields should instead be initialized by the create_image_encoder() factory function.
+image_encoder_t::image_encoder_t(void)
+{
+    /* empty */
+}
+
+/// @summary Default destructor. Does nothing because there are no resources to free.
+image_encoder_t::~image_encoder_t(void)
+{
+    /* empty */
+}
+
+/// @summary Default implementation for encoders that can only append data in order.
+/// @param element The zero-based index of the element to write.
+/// @param first_row The zero-based index of the first row to write.
+/// @param src_data The source rows, packed at the source row pitch.
+/// @param row_count The number of rows to write.
+/// @return ERROR_NOT_SUPPORTED.
+uint32_t image_encoder_t::encode_rows(size_t element, size_t first_row, void const *src_data, size_t row_count)
+{
+    UNREFERENCED_PARAMETER(element);
+    UNREFERENCED_PARAMETER(first_row);
+    UNREFERENCED_PARAMETER(src_data);
+    UNREFERENCED_PARAMETER(row_count);
+    return ERROR_NOT_SUPPORTED;
+}
+
+/// @summary Constructs a new identity encoder, which performs no transformation on the source data.
+image_encoder_identity_t::image_encoder_identity_t(void)
+    :
+    TargetDefined(false), 
+    RowsPadded(false), 
+    ElementIndex(0), 
+    LevelIndex(0), 
+    RowFill(0), 
+    BytesWritten(0), 
+    LevelStart(0), 
+    LevelData(NULL)
+{
+    memset(&Target, 0, sizeof(image_definition_t));
+}
+
+/// @summary Frees any resources associated with the identity encoder.
+image_encoder_identity_t::~image_encoder_identity_t(void)
+{
+    if (RowsPadded) image_definition_free(&Target);
+}
+
+/// @summary Determines whether the image memory pads the rows of the source image levels, and if so, builds the definition of the padded output image.
+/// @return true if the row layout was determined, or false if the metadata is not available or memory allocation failed.
+bool image_encoder_identity_t::define_target(void)
+{
+    if (TargetDefined)
+    {   // the row layout has already been determined.
+        return true;
+    }
+    if (Metadata == NULL || Metadata->LevelCount == 0)
+    {   // the source image attributes are not known.
+        return false;
+    }
+    for (size_t i = 0, n = Metadata->LevelCount; i < n; ++i)
+    {
+        dds_level_desc_t const &src = Metadata->LevelInfo[i];
+        if (image_memory_row_pitch(Memory, src.Format, src.Width) != src.BytesPerRow)
+        {   // at least one level has padded rows.
+            RowsPadded = true;
+            break;
+        }
+    }
+    if (RowsPadded)
+    {   // only the row and slice pitch of each level change.
+        image_definition_copy(&Target, Metadata);
+        if (Target.LevelInfo == NULL)
+        {   // unable to allocate the level descriptors.
+            image_definition_free(&Target);
+            RowsPadded = false;
+            return false;
+        }
+        for (size_t i = 0, n = Target.LevelCount; i < n; ++i)
+        {
+            dds_level_desc_t &dst = Target.LevelInfo[i];
+            size_t levelp         = image_memory_row_pitch(Memory, dst.Format, dst.Width);
+            dst.BytesPerRow       = levelp;
+            dst.BytesPerSlice     = levelp * dst.Height;
+            dst.DataSize          = dst.BytesPerSlice * dst.Slices;
+        }
+        Target.DDSHeader.Pitch = uint32_t(Target.LevelInfo[0].BytesPerRow);
+    }
+    TargetDefined = true;
+    return true;
+}
+
+/// @summary Defines the complete attributes of an image and reserves process address space for image storage.
+/// If rows are padded, the padded image definition is posted to the definition queue, rather than the source definition.
+/// @param def The image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_OUTOFMEMORY, or a system error code.
+uint32_t image_encoder_identity_t::define_image(image_definition_t const *def)
+{   // save a reference to the metadata for later access.
+    Metadata = def;
+    if (!define_target())
+    {
+        return (def->LevelCount == 0) ? ERROR_INVALID_PARAMETER : ERROR_OUTOFMEMORY;
+    }
     // no additional transformation will be performed, so the size won't change as long as the image dimension attributes are the same. 
-    size_t base_element_size  = image_memory_base_element_size(def);
+    image_definition_t const *out = RowsPadded ? &Target : def;
+    size_t base_element_size  = image_memory_base_element_size(out);
     // TODO(rlk): determine scale factor for base_element_size using source compression/encoding.
-    return image_memory_reserve_image(Memory,base_element_size,def, TargetEncoding, AccessType, DefinitionQueue, DefinitionAlloc);
+    return image_memory_reserve_image(Memory,base_element_size,out, TargetEncoding, AccessType, DefinitionQueue, DefinitionAlloc);
 }
 
 /// @summary Decommits all memory associated with an image array element or frame. Subsequent encode calls targeting the element will begin writing data to level 0.
 /// @param element The zero-based index of the image array element or frame to reset.
-/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
 uint32_t image_encoder_identity_t::reset_element(size_t element)
 {
+    if (!define_target())
+    {   // the image was already defined, but the metadata wasn't supplied.
+        return ERROR_INVALID_PARAMETER;
+    }
     if (image_memory_reset_element_storage(Memory, ImageId, element) == NULL)
     {
         uint32_t err  = GetLastError();
@@ -207,21 +870,160 @@ uint32_t image_encoder_identity_t::reset_element(size_t element)
             return err;
         }
     }
+    ElementIndex = element;
+    LevelIndex   = 0;
+    RowFill      = 0;
+    BytesWritten = 0;
+    LevelStart   = 0;
+    LevelData    = NULL;
     return ERROR_SUCCESS;
 }
 
 /// @summary Performs the encoding transformation to the source data and appends it to the current mipmap level of the specified image element.
+/// If rows are padded, each completed source row is followed by zero bytes up to the padded pitch.
 /// @param element The zero-based index of the element to write.
+/// @param src_data The source data. The data may be split across calls at any byte boundary.
+/// @param src_size The number of bytes of source data.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
 uint32_t image_encoder_identity_t::encode(size_t element, void const *src_data, size_t src_size)
 {   // TODO(rlk): if this were an asynchronous encoder, it must synchronously copy the src_data here.
-    return image_memory_write(Memory, ImageId, element, src_data, src_size);
+    if (LevelData != NULL)
+    {   // the current level is being written with encode_rows.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (!RowsPadded)
+    {   // the source layout is the storage layout.
+        uint32_t res  = image_memory_write(Memory, ImageId, element, src_data, src_size);
+        if (res == ERROR_SUCCESS) BytesWritten += src_size;
+        return res;
+    }
+    if (element != ElementIndex || LevelIndex >= Target.LevelCount)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    uint8_t const *src   = (uint8_t const*) src_data;
+    size_t  const  row   = Metadata->LevelInfo[LevelIndex].BytesPerRow;
+    size_t  const  pad   = Target.LevelInfo[LevelIndex].BytesPerRow - row;
+    size_t  const  rows  =(RowFill + src_size) / row;
+    size_t  const  size  = src_size + rows * pad;
+    uint8_t       *dst   = (uint8_t*) image_memory_increase_commit(Memory, ImageId, element, BytesWritten + size);
+    if (dst == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    while (src_size > 0)
+    {   // copy up to the end of the current row, then pad it.
+        size_t count = image_min2<size_t>(src_size, row - RowFill);
+        memcpy(dst, src, count);
+        RowFill     += count;
+        src_size    -= count;
+        src         += count;
+        dst         += count;
+        if (RowFill == row)
+        {
+            memset(dst, 0, pad);
+            dst     += pad;
+            RowFill  = 0;
+        }
+    }
+    BytesWritten += size;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Copies whole rows of the current mipmap level of the specified image element to their final offsets, so that rows can be written in any order. 
+/// On the first call for a level, the storage for the entire level is committed.
+/// The level must be written either with encode_rows or with encode, but not both.
+/// @param element The zero-based index of the element to write.
+/// @param first_row The zero-based index of the first row to write. For block-compressed formats, rows are rows of blocks.
+/// @param src_data The source rows, packed at the source row pitch.
+/// @param row_count The number of rows to write.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_identity_t::encode_rows(size_t element, size_t first_row, void const *src_data, size_t row_count)
+{
+    if (!define_target() || element != ElementIndex || LevelIndex >= Metadata->LevelCount)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    dds_level_desc_t const &src   = Metadata->LevelInfo[LevelIndex];
+    size_t           const  row   = src.BytesPerRow;
+    size_t           const  pitch = RowsPadded ? Target.LevelInfo[LevelIndex].BytesPerRow : row;
+    size_t           const  rows  = src.DataSize / row;
+    if (first_row + row_count > rows || BytesWritten != LevelStart + (LevelData != NULL ? pitch * rows : 0))
+    {   // the rows are outside the level, or the level was partially written with encode.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (LevelData == NULL)
+    {   // commit the entire level, so rows can be written in any order.
+        if ((LevelData = (uint8_t*) image_memory_increase_commit(Memory, ImageId, element, BytesWritten + pitch * rows)) == NULL)
+        {
+            uint32_t err  = GetLastError();
+            if (SUCCEEDED(err))
+            {   // no OS error, so we couldn't find the image.
+                return ERROR_NOT_FOUND;
+            }
+            else
+            {   // return the OS error.
+                return err;
+            }
+        }
+        BytesWritten += pitch * rows;
+    }
+    uint8_t const *srcp = (uint8_t const*) src_data;
+    uint8_t       *dstp =  LevelData + first_row * pitch;
+    for (size_t i = 0; i < row_count; ++i)
+    {
+        memcpy(dstp, srcp, row);
+        if (pitch > row) memset(dstp + row, 0, pitch - row);
+        srcp += row;
+        dstp += pitch;
+    }
+    return ERROR_SUCCESS;
 }
 
 /// @summary Indicates that all data for the current mipmap level of an image element has been written. Subsequent encode calls targeting the element will begin writing data to the next mipmap level.
+/// If rows are padded and the source data ended partway through a row, the row is zero-filled.
 /// @param element The zero-based index of the image element being written.
-/// @return ERROR_SUCCESS, ERROR_NOT_FOUND, or a system error code.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND, or a system error code.
 uint32_t image_encoder_identity_t::mark_level(size_t element)
 {
+    if (RowsPadded)
+    {
+        if (element != ElementIndex || LevelIndex >= Target.LevelCount)
+        {   // reset_element must be called first; only one element is encoded at a time.
+            return ERROR_INVALID_PARAMETER;
+        }
+        if (RowFill > 0)
+        {   // the source data ended partway through a row.
+            size_t size = Target.LevelInfo[LevelIndex].BytesPerRow - RowFill;
+            void   *dst = image_memory_increase_commit(Memory, ImageId, element, BytesWritten + size);
+            if (dst == NULL)
+            {
+                uint32_t err  = GetLastError();
+                if (SUCCEEDED(err))
+                {   // no OS error, so we couldn't find the image.
+                    return ERROR_NOT_FOUND;
+                }
+                else
+                {   // return the OS error.
+                    return err;
+                }
+            }
+            memset(dst, 0, size);
+            BytesWritten += size;
+            RowFill       = 0;
+        }
+    }
+    LevelIndex++;
+    LevelStart = BytesWritten;
+    LevelData  = NULL;
     return image_memory_mark_level_end(Memory, ImageId, element);
 }
 
@@ -232,3 +1034,1455 @@ uint32_t image_encoder_identity_t::mark_element(size_t element)
 {   // do not increment the element index here. pick it up during the encode call.
     return image_memory_mark_element_end(Memory, ImageId, element, PlacementQueue, PlacementAlloc);
 }
+
+/// @summary Constructs a new block-compression encoder. The target format is set by the create_image_encoder() factory function.
+image_encoder_bcn_t::image_encoder_bcn_t(void)
+    :
+    TargetDefined(false), 
+    SourceFormat(DXGI_FORMAT_UNKNOWN),
+    Quality(IMAGE_ENCODER_QUALITY_NORMAL),
+    WorkPool(NULL),
+    BandRows(1),
+    BandCount(0),
+    BandIndex(0),
+    ElementIndex(0), 
+    LevelIndex(0), 
+    SliceIndex(0), 
+    RowIndex(0), 
+    BytesWritten(0), 
+    StagingSize(0)
+{
+    memset(&Target, 0, sizeof(image_definition_t));
+    for (size_t i = 0; i < IMAGE_ENCODER_MAX_BANDS; ++i)
+    {
+        Bands[i].Staging    = NULL;
+        Bands[i].Batch.Done = NULL;
+        Bands[i].Busy       = false;
+    }
+}
+
+/// @summary Waits for any bands still being compressed, then frees the target image definition and the staging buffers.
+image_encoder_bcn_t::~image_encoder_bcn_t(void)
+{
+    wait_bands();
+    if (TargetDefined) image_definition_free(&Target);
+    for (size_t i = 0; i < BandCount; ++i)
+    {
+        work_pool_batch_delete(&Bands[i].Batch);
+        free(Bands[i].Staging);
+    }
+}
+
+/// @summary Builds the definition of the block-compressed output image from the source image metadata, and allocates the staging buffers.
+/// @return true if the target definition was built, or false if the metadata is not available or memory allocation failed.
+bool image_encoder_bcn_t::define_target(void)
+{
+    if (TargetDefined)
+    {   // the target definition has already been built.
+        return true;
+    }
+    if (Metadata == NULL || Metadata->LevelCount == 0)
+    {   // the source image attributes are not known.
+        return false;
+    }
+    uint32_t format = Target.ImageFormat;
+    size_t   blocksz= dxgi_bytes_per_block(format);
+    image_definition_copy(&Target, Metadata);
+    if (Target.LevelInfo == NULL)
+    {   // unable to allocate the level descriptors.
+        image_definition_free(&Target);
+        Target.ImageFormat = format;
+        return false;
+    }
+    Target.ImageFormat     = format;
+    Target.Compression     = TargetCompression;
+    Target.Encoding        = TargetEncoding;
+    Target.BytesPerPixel   = dxgi_bits_per_pixel(format);
+    Target.BytesPerBlock   = blocksz;
+    // the format is now specified by the DX10 header.
+    Target.DX10Header.Format       = format;
+    Target.DDSHeader.Flags         =(Target.DDSHeader.Flags & ~DDSD_PITCH) | DDSD_LINEARSIZE;
+    Target.DDSHeader.Format.Flags  = DDPF_FOURCC;
+    Target.DDSHeader.Format.FourCC = image_fourcc_le('D','X','1','0');
+    for (size_t i = 0, n = Target.LevelCount; i < n; ++i)
+    {
+        dds_level_desc_t &dst = Target.LevelInfo[i];
+        size_t levelw         = image_level_dimension(Metadata->Width , i);
+        size_t levelh         = image_level_dimension(Metadata->Height, i);
+        size_t levelp         = dxgi_pitch(format, levelw);
+        size_t blockh         = image_max2<size_t>(1, (levelh + 3) / 4);
+        dst.Width             = dxgi_image_dimension(format, levelw);
+        dst.Height            = dxgi_image_dimension(format, levelh);
+        dst.BytesPerElement   = blocksz;
+        dst.BytesPerRow       = levelp;
+        dst.BytesPerSlice     = levelp * blockh;
+        dst.DataSize          = dst.BytesPerSlice * dst.Slices;
+        dst.Format            = format;
+    }
+    Target.DDSHeader.Pitch = uint32_t(Target.LevelInfo[0].BytesPerSlice);
+    if (WorkPool != NULL && WorkPool->ThreadCount > 0)
+    {   // stage enough block rows to keep every thread busy, with some slack for uneven rows.
+        size_t block_rows = image_max2<size_t>(1, (Metadata->Height + 3) / 4);
+        BandRows = image_min2<size_t>(block_rows, 2 * (WorkPool->ThreadCount + 1));
+    }
+    else BandRows = 1;
+    // without worker threads, bands are compressed as they are submitted, so one staging buffer is enough.
+    size_t band_count = (WorkPool != NULL && WorkPool->ThreadCount > 0) ? IMAGE_ENCODER_MAX_BANDS : 1;
+    for (BandCount = 0; BandCount < band_count; ++BandCount)
+    {   // level 0 is the largest, so staging buffers sized for it work for every level.
+        image_encoder_bcn_band_t &band = Bands[BandCount];
+        band.TargetFormat = format;
+        band.SourceFormat = SourceFormat;
+        band.Quality      = Quality;
+        band.Busy         = false;
+        band.Staging      = (uint8_t*) malloc(BandRows * 4 * Metadata->LevelInfo[0].BytesPerRow);
+        if (band.Staging == NULL || !work_pool_batch_create(&band.Batch))
+            break;
+    }
+    if (BandCount < band_count)
+    {   // unable to allocate the staging buffers.
+        free(Bands[BandCount].Staging);
+        Bands[BandCount].Staging = NULL;
+        while (BandCount > 0)
+        {
+            image_encoder_bcn_band_t &band = Bands[--BandCount];
+            work_pool_batch_delete(&band.Batch);
+            free(band.Staging); band.Staging = NULL;
+        }
+        image_definition_free(&Target);
+        Target.ImageFormat = format;
+        return false;
+    }
+    BandIndex     = 0;
+    TargetDefined = true;
+    return true;
+}
+
+/// @summary Commits image memory for the block rows of the staged band, and submits the band to the worker pool, which compresses each block row directly to its final offset.
+/// The call returns without waiting for the band to complete, unless the staging buffer of the next band is still in use.
+/// @param rows The number of valid source rows in the staging buffer, in [1, BandRows * 4].
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_t::flush_rows(size_t rows)
+{
+    dds_level_desc_t const   &src = Metadata->LevelInfo[LevelIndex];
+    image_encoder_bcn_band_t &band= Bands[BandIndex];
+    size_t block_rows = (rows + 3) / 4;
+    size_t pitch      = Target.LevelInfo[LevelIndex].BytesPerRow;
+    void  *dst        = image_memory_increase_commit(Memory, ImageId, ElementIndex, BytesWritten + block_rows * pitch);
+    if (dst == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    band.Source      =&src;
+    band.Target      = (uint8_t*) dst;
+    band.TargetPitch = pitch;
+    band.Rows        = rows;
+    band.Busy        = true;
+    band.Failures.store(0, std::memory_order_relaxed);
+    work_pool_submit(WorkPool, &band.Batch, image_encoder_bcn_band_row, &band, block_rows);
+    BytesWritten += block_rows * pitch;
+    StagingSize   = 0;
+    RowIndex     += rows;
+    if (RowIndex >= src.Height)
+    {   // move to the first row of the next slice.
+        RowIndex  = 0;
+        SliceIndex++;
+    }
+    // the next band's staging buffer may still be read by the workers.
+    BandIndex = (BandIndex + 1) % BandCount;
+    return wait_band(BandIndex);
+}
+
+/// @summary Waits for a submitted band to finish compressing, so that its staging buffer can be reused.
+/// @param index The zero-based index of the band.
+/// @return ERROR_SUCCESS or ERROR_INVALID_PARAMETER.
+uint32_t image_encoder_bcn_t::wait_band(size_t index)
+{
+    image_encoder_bcn_band_t &band = Bands[index];
+    if (!band.Busy)
+    {   // the band is not in flight.
+        return ERROR_SUCCESS;
+    }
+    work_pool_wait(WorkPool, &band.Batch);
+    band.Busy = false;
+    if (band.Failures.load(std::memory_order_relaxed) > 0)
+    {   // the source and target formats are not compatible.
+        return ERROR_INVALID_PARAMETER;
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Waits for every submitted band to finish compressing.
+/// @return ERROR_SUCCESS or ERROR_INVALID_PARAMETER.
+uint32_t image_encoder_bcn_t::wait_bands(void)
+{
+    uint32_t result = ERROR_SUCCESS;
+    for (size_t i = 0; i < BandCount; ++i)
+    {   // wait for every band, even if an earlier band failed, so no worker touches the buffers afterwards.
+        uint32_t err = wait_band(i);
+        if (err != ERROR_SUCCESS)
+            result = err;
+    }
+    return result;
+}
+
+/// @summary Defines the complete attributes of an image and reserves process address space for the block-compressed image storage.
+/// The block-compressed image definition is posted to the definition queue, rather than the source definition.
+/// @param def The source image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_OUTOFMEMORY, or a system error code.
+uint32_t image_encoder_bcn_t::define_image(image_definition_t const *def)
+{   // save a reference to the source metadata for later access.
+    Metadata = def;
+    if (!define_target())
+    {
+        return (def->LevelCount == 0) ? ERROR_INVALID_PARAMETER : ERROR_OUTOFMEMORY;
+    }
+    size_t base_element_size = image_memory_base_element_size(&Target);
+    return image_memory_reserve_image(Memory, base_element_size, &Target, TargetEncoding, AccessType, DefinitionQueue, DefinitionAlloc);
+}
+
+/// @summary Decommits all memory associated with an image array element or frame, and resets the encoder to the start of level 0 of the element.
+/// @param element The zero-based index of the image array element or frame to reset.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_t::reset_element(size_t element)
+{
+    if (!define_target())
+    {   // the image was already defined, but the metadata wasn't supplied.
+        return ERROR_INVALID_PARAMETER;
+    }
+    // the element storage is about to be decommitted, so no band may still be writing to it.
+    wait_bands();
+    if (image_memory_reset_element_storage(Memory, ImageId, element) == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    ElementIndex = element;
+    LevelIndex   = 0;
+    SliceIndex   = 0;
+    RowIndex     = 0;
+    BytesWritten = 0;
+    StagingSize  = 0;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Buffers source rows and compresses each complete band of block rows, appending it to the current mipmap level of the specified image element.
+/// @param element The zero-based index of the element to write. This must be the element specified in the most recent call to reset_element.
+/// @param src_data The source pixel data. The data may be split across calls at any byte boundary.
+/// @param src_size The number of bytes of source pixel data.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_t::encode(size_t element, void const *src_data, size_t src_size)
+{
+    uint8_t const *src = (uint8_t const*) src_data;
+    if (!TargetDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    while (src_size > 0)
+    {
+        if (LevelIndex >= Target.LevelCount || SliceIndex >= Metadata->LevelInfo[LevelIndex].Slices)
+        {   // more data was supplied than the level holds.
+            return ERROR_INVALID_PARAMETER;
+        }
+        dds_level_desc_t const &level = Metadata->LevelInfo[LevelIndex];
+        size_t rows  = image_min2<size_t>(BandRows * 4, level.Height - RowIndex);
+        size_t need  = rows * level.BytesPerRow;
+        size_t count = image_min2<size_t>(src_size, need - StagingSize);
+        memcpy(Bands[BandIndex].Staging + StagingSize, src, count);
+        StagingSize += count;
+        src_size    -= count;
+        src         += count;
+        if (StagingSize == need)
+        {   // a complete band of block rows is available.
+            uint32_t err = flush_rows(rows);
+            if (err != ERROR_SUCCESS)
+                return err;
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Indicates that all data for the current mipmap level of an image element has been supplied. Any partial band of block rows is padded and flushed, 
+/// and the call returns after every band of the level has been written.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND, or a system error code.
+uint32_t image_encoder_bcn_t::mark_level(size_t element)
+{
+    if (!TargetDefined || element != ElementIndex || LevelIndex >= Target.LevelCount)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (StagingSize > 0)
+    {   // the source data ended partway through a band; zero-fill the last partial row.
+        size_t pitch = Metadata->LevelInfo[LevelIndex].BytesPerRow;
+        size_t rows  =(StagingSize + pitch - 1) / pitch;
+        memset(Bands[BandIndex].Staging + StagingSize, 0, rows * pitch - StagingSize);
+        uint32_t err = flush_rows(rows);
+        if (err != ERROR_SUCCESS)
+            return err;
+    }
+    uint32_t err = wait_bands();
+    if (err != ERROR_SUCCESS)
+    {   // at least one band of the level could not be encoded.
+        return err;
+    }
+    LevelIndex++;
+    SliceIndex = 0;
+    RowIndex   = 0;
+    return image_memory_mark_level_end(Memory, ImageId, element);
+}
+
+/// @summary Indicates that all data for an image element has been encoded. The element is not published until every band has been written.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_t::mark_element(size_t element)
+{
+    uint32_t err = wait_bands();
+    if (err != ERROR_SUCCESS)
+    {   // at least one band of the element could not be encoded.
+        return err;
+    }
+    return image_memory_mark_element_end(Memory, ImageId, element, PlacementQueue, PlacementAlloc);
+}
+
+/// @summary Constructs a new block-decompression encoder. The target format is set by the create_image_encoder() factory function.
+image_encoder_bcn_decode_t::image_encoder_bcn_decode_t(void)
+    :
+    TargetDefined(false), 
+    SourceFormat(DXGI_FORMAT_UNKNOWN),
+    WorkPool(NULL),
+    BandRows(1),
+    BandCount(0),
+    BandIndex(0),
+    ElementIndex(0), 
+    LevelIndex(0), 
+    SliceIndex(0), 
+    RowIndex(0), 
+    BytesWritten(0), 
+    StagingSize(0)
+{
+    memset(&Target, 0, sizeof(image_definition_t));
+    for (size_t i = 0; i < IMAGE_ENCODER_MAX_BANDS; ++i)
+    {
+        Bands[i].Staging    = NULL;
+        Bands[i].Batch.Done = NULL;
+        Bands[i].Busy       = false;
+    }
+}
+
+/// @summary Waits for any bands still being decoded, then frees the target image definition and the staging buffers.
+image_encoder_bcn_decode_t::~image_encoder_bcn_decode_t(void)
+{
+    wait_bands();
+    if (TargetDefined) image_definition_free(&Target);
+    for (size_t i = 0; i < BandCount; ++i)
+    {
+        work_pool_batch_delete(&Bands[i].Batch);
+        free(Bands[i].Staging);
+    }
+}
+
+/// @summary Builds the definition of the decoded output image from the source image metadata, and allocates the staging buffers.
+/// @return true if the target definition was built, or false if the metadata is not available or memory allocation failed.
+bool image_encoder_bcn_decode_t::define_target(void)
+{
+    if (TargetDefined)
+    {   // the target definition has already been built.
+        return true;
+    }
+    if (Metadata == NULL || Metadata->LevelCount == 0)
+    {   // the source image attributes are not known.
+        return false;
+    }
+    uint32_t format = Target.ImageFormat;
+    size_t   bitspp = dxgi_bits_per_pixel(format);
+    image_definition_copy(&Target, Metadata);
+    if (Target.LevelInfo == NULL)
+    {   // unable to allocate the level descriptors.
+        image_definition_free(&Target);
+        Target.ImageFormat = format;
+        return false;
+    }
+    Target.ImageFormat     = format;
+    Target.Compression     = TargetCompression;
+    Target.Encoding        = TargetEncoding;
+    Target.BytesPerPixel   = bitspp;
+    Target.BytesPerBlock   = 0;
+    // the format is now specified by the DX10 header.
+    Target.DX10Header.Format       = format;
+    Target.DDSHeader.Flags         =(Target.DDSHeader.Flags & ~DDSD_LINEARSIZE) | DDSD_PITCH;
+    Target.DDSHeader.Format.Flags  = DDPF_FOURCC;
+    Target.DDSHeader.Format.FourCC = image_fourcc_le('D','X','1','0');
+    for (size_t i = 0, n = Target.LevelCount; i < n; ++i)
+    {
+        dds_level_desc_t &dst = Target.LevelInfo[i];
+        size_t levelw         = image_level_dimension(Metadata->Width , i);
+        size_t levelh         = image_level_dimension(Metadata->Height, i);
+        size_t levelp         = dxgi_pitch(format, levelw);
+        dst.Width             = levelw;
+        dst.Height            = levelh;
+        dst.BytesPerElement   = bitspp / 8;
+        dst.BytesPerRow       = levelp;
+        dst.BytesPerSlice     = levelp * levelh;
+        dst.DataSize          = dst.BytesPerSlice * dst.Slices;
+        dst.Format            = format;
+    }
+    Target.DDSHeader.Pitch = uint32_t(Target.LevelInfo[0].BytesPerRow);
+    if (WorkPool != NULL && WorkPool->ThreadCount > 0)
+    {   // stage enough block rows to keep every thread busy, with some slack for uneven rows.
+        size_t block_rows = image_max2<size_t>(1, (Metadata->Height + 3) / 4);
+        BandRows = image_min2<size_t>(block_rows, 2 * (WorkPool->ThreadCount + 1));
+    }
+    else BandRows = 1;
+    // without worker threads, bands are decoded as they are submitted, so one staging buffer is enough.
+    size_t band_count = (WorkPool != NULL && WorkPool->ThreadCount > 0) ? IMAGE_ENCODER_MAX_BANDS : 1;
+    for (BandCount = 0; BandCount < band_count; ++BandCount)
+    {   // level 0 is the largest, so staging buffers sized for it work for every level.
+        image_encoder_bcn_decode_band_t &band = Bands[BandCount];
+        band.SourceFormat = SourceFormat;
+        band.TargetFormat = format;
+        band.Busy         = false;
+        band.Staging      = (uint8_t*) malloc(BandRows * Metadata->LevelInfo[0].BytesPerRow);
+        if (band.Staging == NULL || !work_pool_batch_create(&band.Batch))
+            break;
+    }
+    if (BandCount < band_count)
+    {   // unable to allocate the staging buffers.
+        free(Bands[BandCount].Staging);
+        Bands[BandCount].Staging = NULL;
+        while (BandCount > 0)
+        {
+            image_encoder_bcn_decode_band_t &band = Bands[--BandCount];
+            work_pool_batch_delete(&band.Batch);
+            free(band.Staging); band.Staging = NULL;
+        }
+        image_definition_free(&Target);
+        Target.ImageFormat = format;
+        return false;
+    }
+    BandIndex     = 0;
+    TargetDefined = true;
+    return true;
+}
+
+/// @summary Commits image memory for the pixel rows of the staged band, and submits the band to the worker pool, which decodes each block row directly to its final offset.
+/// The call returns without waiting for the band to complete, unless the staging buffer of the next band is still in use.
+/// @param block_rows The number of block rows in the staging buffer, in [1, BandRows].
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_decode_t::flush_rows(size_t block_rows)
+{
+    dds_level_desc_t const          &lvl  = Target.LevelInfo[LevelIndex];
+    image_encoder_bcn_decode_band_t &band = Bands[BandIndex];
+    size_t total_rows = (lvl.Height + 3) / 4;
+    size_t rows       = image_min2<size_t>(block_rows * 4, lvl.Height - RowIndex * 4);
+    void  *dst        = image_memory_increase_commit(Memory, ImageId, ElementIndex, BytesWritten + rows * lvl.BytesPerRow);
+    if (dst == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    band.Target      = (uint8_t*) dst;
+    band.SourcePitch = Metadata->LevelInfo[LevelIndex].BytesPerRow;
+    band.TargetPitch = lvl.BytesPerRow;
+    band.Width       = lvl.Width;
+    band.Rows        = rows;
+    band.Busy        = true;
+    band.Failures.store(0, std::memory_order_relaxed);
+    work_pool_submit(WorkPool, &band.Batch, image_encoder_bcn_decode_band_row, &band, block_rows);
+    BytesWritten += rows * lvl.BytesPerRow;
+    StagingSize   = 0;
+    RowIndex     += block_rows;
+    if (RowIndex >= total_rows)
+    {   // move to the first row of the next slice.
+        RowIndex  = 0;
+        SliceIndex++;
+    }
+    // the next band's staging buffer may still be read by the workers.
+    BandIndex = (BandIndex + 1) % BandCount;
+    return wait_band(BandIndex);
+}
+
+/// @summary Waits for a submitted band to finish decoding, so that its staging buffer can be reused.
+/// @param index The zero-based index of the band.
+/// @return ERROR_SUCCESS or ERROR_INVALID_PARAMETER.
+uint32_t image_encoder_bcn_decode_t::wait_band(size_t index)
+{
+    image_encoder_bcn_decode_band_t &band = Bands[index];
+    if (!band.Busy)
+    {   // the band is not in flight.
+        return ERROR_SUCCESS;
+    }
+    work_pool_wait(WorkPool, &band.Batch);
+    band.Busy = false;
+    if (band.Failures.load(std::memory_order_relaxed) > 0)
+    {   // the source and target formats are not compatible.
+        return ERROR_INVALID_PARAMETER;
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Waits for every submitted band to finish decoding.
+/// @return ERROR_SUCCESS or ERROR_INVALID_PARAMETER.
+uint32_t image_encoder_bcn_decode_t::wait_bands(void)
+{
+    uint32_t result = ERROR_SUCCESS;
+    for (size_t i = 0; i < BandCount; ++i)
+    {   // wait for every band, even if an earlier band failed, so no worker touches the buffers afterwards.
+        uint32_t err = wait_band(i);
+        if (err != ERROR_SUCCESS)
+            result = err;
+    }
+    return result;
+}
+
+/// @summary Defines the complete attributes of an image and reserves process address space for the decoded image storage.
+/// The decoded image definition is posted to the definition queue, rather than the source definition.
+/// @param def The source image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_OUTOFMEMORY, or a system error code.
+uint32_t image_encoder_bcn_decode_t::define_image(image_definition_t const *def)
+{   // save a reference to the source metadata for later access.
+    Metadata = def;
+    if (!define_target())
+    {
+        return (def->LevelCount == 0) ? ERROR_INVALID_PARAMETER : ERROR_OUTOFMEMORY;
+    }
+    size_t base_element_size = image_memory_base_element_size(&Target);
+    return image_memory_reserve_image(Memory, base_element_size, &Target, TargetEncoding, AccessType, DefinitionQueue, DefinitionAlloc);
+}
+
+/// @summary Decommits all memory associated with an image array element or frame, and resets the encoder to the start of level 0 of the element.
+/// @param element The zero-based index of the image array element or frame to reset.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_decode_t::reset_element(size_t element)
+{
+    if (!define_target())
+    {   // the image was already defined, but the metadata wasn't supplied.
+        return ERROR_INVALID_PARAMETER;
+    }
+    // the element storage is about to be decommitted, so no band may still be writing to it.
+    wait_bands();
+    if (image_memory_reset_element_storage(Memory, ImageId, element) == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    ElementIndex = element;
+    LevelIndex   = 0;
+    SliceIndex   = 0;
+    RowIndex     = 0;
+    BytesWritten = 0;
+    StagingSize  = 0;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Buffers source block rows and decodes each complete band, appending the pixel rows to the current mipmap level of the specified image element.
+/// @param element The zero-based index of the element to write. This must be the element specified in the most recent call to reset_element.
+/// @param src_data The block-compressed source data. The data may be split across calls at any byte boundary.
+/// @param src_size The number of bytes of source data.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_decode_t::encode(size_t element, void const *src_data, size_t src_size)
+{
+    uint8_t const *src = (uint8_t const*) src_data;
+    if (!TargetDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    while (src_size > 0)
+    {
+        if (LevelIndex >= Target.LevelCount || SliceIndex >= Target.LevelInfo[LevelIndex].Slices)
+        {   // more data was supplied than the level holds.
+            return ERROR_INVALID_PARAMETER;
+        }
+        size_t pitch = Metadata->LevelInfo[LevelIndex].BytesPerRow;
+        size_t total = (Target.LevelInfo[LevelIndex].Height + 3) / 4;
+        size_t rows  = image_min2<size_t>(BandRows, total - RowIndex);
+        size_t need  = rows * pitch;
+        size_t count = image_min2<size_t>(src_size, need - StagingSize);
+        memcpy(Bands[BandIndex].Staging + StagingSize, src, count);
+        StagingSize += count;
+        src_size    -= count;
+        src         += count;
+        if (StagingSize == need)
+        {   // a complete band of block rows is available.
+            uint32_t err = flush_rows(rows);
+            if (err != ERROR_SUCCESS)
+                return err;
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Indicates that all data for the current mipmap level of an image element has been supplied. Any partial band of block rows is padded and flushed, 
+/// and the call returns after every band of the level has been written.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND, or a system error code.
+uint32_t image_encoder_bcn_decode_t::mark_level(size_t element)
+{
+    if (!TargetDefined || element != ElementIndex || LevelIndex >= Target.LevelCount)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (StagingSize > 0)
+    {   // the source data ended partway through a band; zero-fill the last partial row of blocks.
+        size_t pitch = Metadata->LevelInfo[LevelIndex].BytesPerRow;
+        size_t rows  =(StagingSize + pitch - 1) / pitch;
+        memset(Bands[BandIndex].Staging + StagingSize, 0, rows * pitch - StagingSize);
+        uint32_t err = flush_rows(rows);
+        if (err != ERROR_SUCCESS)
+            return err;
+    }
+    uint32_t err = wait_bands();
+    if (err != ERROR_SUCCESS)
+    {   // at least one band of the level could not be encoded.
+        return err;
+    }
+    LevelIndex++;
+    SliceIndex = 0;
+    RowIndex   = 0;
+    return image_memory_mark_level_end(Memory, ImageId, element);
+}
+
+/// @summary Indicates that all data for an image element has been encoded. The element is not published until every band has been written.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_bcn_decode_t::mark_element(size_t element)
+{
+    uint32_t err = wait_bands();
+    if (err != ERROR_SUCCESS)
+    {   // at least one band of the element could not be decoded.
+        return err;
+    }
+    return image_memory_mark_element_end(Memory, ImageId, element, PlacementQueue, PlacementAlloc);
+}
+
+/// @summary Constructs a new pixel-format conversion encoder. The target format is set by the create_image_encoder() factory function.
+image_encoder_convert_t::image_encoder_convert_t(void)
+    :
+    TargetDefined(false), 
+    SourceFormat(DXGI_FORMAT_UNKNOWN),
+    ColorFlags(IMAGE_ENCODER_FLAGS_NONE),
+    ElementIndex(0), 
+    BytesWritten(0), 
+    CarrySize(0)
+{
+    memset(&Target , 0, sizeof(image_definition_t));
+    memset(&Convert, 0, sizeof(pixel_convert_t));
+}
+
+/// @summary Frees the target image definition.
+image_encoder_convert_t::~image_encoder_convert_t(void)
+{
+    if (TargetDefined) image_definition_free(&Target);
+}
+
+/// @summary Builds the definition of the converted output image from the source image metadata, and selects the conversion kernel.
+/// @return true if the target definition was built, or false if the metadata is not available, the conversion is not supported or memory allocation failed.
+bool image_encoder_convert_t::define_target(void)
+{
+    if (TargetDefined)
+    {   // the target definition has already been built.
+        return true;
+    }
+    if (Metadata == NULL || Metadata->LevelCount == 0)
+    {   // the source image attributes are not known.
+        return false;
+    }
+    uint32_t format = Target.ImageFormat;
+    size_t   bitspp = dxgi_bits_per_pixel(format);
+    if (!pixel_convert_setup(&Convert, SourceFormat, format, ColorFlags))
+    {   // the conversion is not supported; this is not expected.
+        return false;
+    }
+    if (Metadata->DX10Header.Flags2 == DDS_ALPHA_MODE_PREMULTIPLIED || Metadata->DX10Header.Flags2 == DDS_ALPHA_MODE_OPAQUE)
+    {   // the source alpha is already premultiplied, or is ignored.
+        Convert.Options &= ~PIXEL_CONVERT_OPTION_PREMULTIPLY;
+    }
+    image_definition_copy(&Target, Metadata);
+    if (Target.LevelInfo == NULL)
+    {   // unable to allocate the level descriptors.
+        image_definition_free(&Target);
+        Target.ImageFormat = format;
+        return false;
+    }
+    Target.ImageFormat     = format;
+    Target.Compression     = TargetCompression;
+    Target.Encoding        = TargetEncoding;
+    Target.BytesPerPixel   = bitspp;
+    Target.BytesPerBlock   = 0;
+    // the format is now specified by the DX10 header.
+    Target.DX10Header.Format       = format;
+    Target.DDSHeader.Flags         =(Target.DDSHeader.Flags & ~DDSD_LINEARSIZE) | DDSD_PITCH;
+    Target.DDSHeader.Format.Flags  = DDPF_FOURCC;
+    Target.DDSHeader.Format.FourCC = image_fourcc_le('D','X','1','0');
+    if (Convert.Options & PIXEL_CONVERT_OPTION_PREMULTIPLY)
+        Target.DX10Header.Flags2   = DDS_ALPHA_MODE_PREMULTIPLIED;
+    for (size_t i = 0, n = Target.LevelCount; i < n; ++i)
+    {
+        dds_level_desc_t &dst = Target.LevelInfo[i];
+        size_t levelp         = dxgi_pitch(format, dst.Width);
+        dst.BytesPerElement   = bitspp / 8;
+        dst.BytesPerRow       = levelp;
+        dst.BytesPerSlice     = levelp * dst.Height;
+        dst.DataSize          = dst.BytesPerSlice * dst.Slices;
+        dst.Format            = format;
+    }
+    Target.DDSHeader.Pitch = uint32_t(Target.LevelInfo[0].BytesPerRow);
+    TargetDefined = true;
+    return true;
+}
+
+/// @summary Converts whole source pixels directly into the committed memory of the current element.
+/// @param src The source pixels.
+/// @param count The number of source pixels to convert.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_convert_t::write_pixels(uint8_t const *src, size_t count)
+{
+    size_t size = count * Convert.TargetSize;
+    void   *dst = image_memory_increase_commit(Memory, ImageId, ElementIndex, BytesWritten + size);
+    if (dst == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    pixel_convert(&Convert, src, dst, count);
+    BytesWritten += size;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Defines the complete attributes of an image and reserves process address space for the converted image storage.
+/// The converted image definition is posted to the definition queue, rather than the source definition.
+/// @param def The source image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_OUTOFMEMORY, or a system error code.
+uint32_t image_encoder_convert_t::define_image(image_definition_t const *def)
+{   // save a reference to the source metadata for later access.
+    Metadata = def;
+    if (!define_target())
+    {
+        return (def->LevelCount == 0) ? ERROR_INVALID_PARAMETER : ERROR_OUTOFMEMORY;
+    }
+    size_t base_element_size = image_memory_base_element_size(&Target);
+    return image_memory_reserve_image(Memory, base_element_size, &Target, TargetEncoding, AccessType, DefinitionQueue, DefinitionAlloc);
+}
+
+/// @summary Decommits all memory associated with an image array element or frame, and resets the encoder to the start of level 0 of the element.
+/// @param element The zero-based index of the image array element or frame to reset.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_convert_t::reset_element(size_t element)
+{
+    if (!define_target())
+    {   // the image was already defined, but the metadata wasn't supplied.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (image_memory_reset_element_storage(Memory, ImageId, element) == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    ElementIndex = element;
+    BytesWritten = 0;
+    CarrySize    = 0;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Converts source pixels and appends them to the current mipmap level of the specified image element.
+/// @param element The zero-based index of the element to write. This must be the element specified in the most recent call to reset_element.
+/// @param src_data The source pixel data. The data may be split across calls at any byte boundary.
+/// @param src_size The number of bytes of source pixel data.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_convert_t::encode(size_t element, void const *src_data, size_t src_size)
+{
+    uint8_t const *src = (uint8_t const*) src_data;
+    size_t const   spp = Convert.SourceSize;
+    if (!TargetDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (CarrySize > 0)
+    {   // complete the pixel split across the previous call.
+        size_t count = image_min2<size_t>(src_size, spp - CarrySize);
+        memcpy(Carry + CarrySize, src, count);
+        CarrySize   += count;
+        src_size    -= count;
+        src         += count;
+        if (CarrySize < spp)
+            return ERROR_SUCCESS;
+        CarrySize    = 0;
+        uint32_t err = write_pixels(Carry, 1);
+        if (err != ERROR_SUCCESS)
+            return err;
+    }
+    size_t pixels = src_size / spp;
+    if (pixels > 0)
+    {   // convert every whole pixel in place in the image memory.
+        uint32_t err = write_pixels(src, pixels);
+        if (err != ERROR_SUCCESS)
+            return err;
+    }
+    CarrySize = src_size - pixels * spp;
+    memcpy(Carry, src + pixels * spp, CarrySize);
+    return ERROR_SUCCESS;
+}
+
+/// @summary Indicates that all data for the current mipmap level of an image element has been supplied. Any partial pixel is zero-filled and written.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND, or a system error code.
+uint32_t image_encoder_convert_t::mark_level(size_t element)
+{
+    if (!TargetDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (CarrySize > 0)
+    {   // the source data ended partway through a pixel.
+        memset(Carry + CarrySize, 0, Convert.SourceSize - CarrySize);
+        CarrySize    = 0;
+        uint32_t err = write_pixels(Carry, 1);
+        if (err != ERROR_SUCCESS)
+            return err;
+    }
+    return image_memory_mark_level_end(Memory, ImageId, element);
+}
+
+/// @summary Indicates that all data for an image element has been encoded.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_convert_t::mark_element(size_t element)
+{
+    return image_memory_mark_element_end(Memory, ImageId, element, PlacementQueue, PlacementAlloc);
+}
+
+/// @summary Constructs a new YUV conversion encoder. The target format is set by the create_image_encoder() factory function.
+image_encoder_yuv_t::image_encoder_yuv_t(void)
+    :
+    TargetDefined(false), 
+    SourceFormat(DXGI_FORMAT_UNKNOWN),
+    YuvFlags(IMAGE_ENCODER_FLAGS_NONE),
+    WorkPool(NULL), 
+    ElementIndex(0), 
+    LevelIndex(0), 
+    BytesWritten(0), 
+    StagingSize(0), 
+    Staging(NULL)
+{
+    memset(&Target , 0, sizeof(image_definition_t));
+    memset(&Convert, 0, sizeof(yuv_convert_t));
+}
+
+/// @summary Frees the target image definition and the staging buffer.
+image_encoder_yuv_t::~image_encoder_yuv_t(void)
+{
+    if (TargetDefined) image_definition_free(&Target);
+    free(Staging);
+}
+
+/// @summary Builds the definition of the converted output image from the source image metadata, and allocates the staging buffer.
+/// @return true if the target definition was built, or false if the metadata is not available, the conversion is not supported or memory allocation failed.
+bool image_encoder_yuv_t::define_target(void)
+{
+    if (TargetDefined)
+    {   // the target definition has already been built.
+        return true;
+    }
+    if (Metadata == NULL || Metadata->LevelCount == 0)
+    {   // the source image attributes are not known.
+        return false;
+    }
+    uint32_t format = Target.ImageFormat;
+    size_t   bitspp = dxgi_bits_per_pixel(format);
+    size_t   stage  = 0;
+    if (!yuv_convert_setup(&Convert, SourceFormat, format, YuvFlags))
+    {   // the conversion is not supported; this is not expected.
+        return false;
+    }
+    for (size_t i = 0, n = Metadata->LevelCount; i < n; ++i)
+    {   // the staging buffer holds the largest source level.
+        stage = image_max2<size_t>(stage, Metadata->LevelInfo[i].DataSize);
+    }
+    if ((Staging = (uint8_t*) malloc(stage)) == NULL)
+    {   // unable to allocate the staging buffer.
+        return false;
+    }
+    image_definition_copy(&Target, Metadata);
+    if (Target.LevelInfo == NULL)
+    {   // unable to allocate the level descriptors.
+        image_definition_free(&Target);
+        Target.ImageFormat = format;
+        free(Staging); Staging = NULL;
+        return false;
+    }
+    Target.ImageFormat     = format;
+    Target.Compression     = TargetCompression;
+    Target.Encoding        = TargetEncoding;
+    Target.BytesPerPixel   = bitspp;
+    Target.BytesPerBlock   = 0;
+    // the format is now specified by the DX10 header.
+    Target.DX10Header.Format       = format;
+    Target.DDSHeader.Flags         =(Target.DDSHeader.Flags & ~DDSD_LINEARSIZE) | DDSD_PITCH;
+    Target.DDSHeader.Format.Flags  = DDPF_FOURCC;
+    Target.DDSHeader.Format.FourCC = image_fourcc_le('D','X','1','0');
+    if (SourceFormat != DXGI_FORMAT_AYUV)
+        Target.DX10Header.Flags2   = DDS_ALPHA_MODE_OPAQUE;
+    for (size_t i = 0, n = Target.LevelCount; i < n; ++i)
+    {
+        dds_level_desc_t &dst = Target.LevelInfo[i];
+        size_t levelp         = dxgi_pitch(format, dst.Width);
+        dst.BytesPerElement   = bitspp / 8;
+        dst.BytesPerRow       = levelp;
+        dst.BytesPerSlice     = levelp * dst.Height;
+        dst.DataSize          = dst.BytesPerSlice * dst.Slices;
+        dst.Format            = format;
+    }
+    Target.DDSHeader.Pitch = uint32_t(Target.LevelInfo[0].BytesPerRow);
+    TargetDefined = true;
+    return true;
+}
+
+/// @summary Defines the complete attributes of an image and reserves process address space for the converted image storage.
+/// The converted image definition is posted to the definition queue, rather than the source definition.
+/// @param def The source image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_OUTOFMEMORY, or a system error code.
+uint32_t image_encoder_yuv_t::define_image(image_definition_t const *def)
+{   // save a reference to the source metadata for later access.
+    Metadata = def;
+    if (!define_target())
+    {
+        return (def->LevelCount == 0) ? ERROR_INVALID_PARAMETER : ERROR_OUTOFMEMORY;
+    }
+    size_t base_element_size = image_memory_base_element_size(&Target);
+    return image_memory_reserve_image(Memory, base_element_size, &Target, TargetEncoding, AccessType, DefinitionQueue, DefinitionAlloc);
+}
+
+/// @summary Decommits all memory associated with an image array element or frame, and resets the encoder to the start of level 0 of the element.
+/// @param element The zero-based index of the image array element or frame to reset.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_yuv_t::reset_element(size_t element)
+{
+    if (!define_target())
+    {   // the image was already defined, but the metadata wasn't supplied.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (image_memory_reset_element_storage(Memory, ImageId, element) == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    ElementIndex = element;
+    LevelIndex   = 0;
+    BytesWritten = 0;
+    StagingSize  = 0;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Stages source data for the current mipmap level of the specified image element. Data past the end of the level is ignored.
+/// @param element The zero-based index of the element to write. This must be the element specified in the most recent call to reset_element.
+/// @param src_data The source pixel data. The data may be split across calls at any byte boundary.
+/// @param src_size The number of bytes of source pixel data.
+/// @return ERROR_SUCCESS or ERROR_INVALID_PARAMETER.
+uint32_t image_encoder_yuv_t::encode(size_t element, void const *src_data, size_t src_size)
+{
+    if (!TargetDefined || element != ElementIndex || LevelIndex >= Metadata->LevelCount)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    size_t count = image_min2<size_t>(src_size, Metadata->LevelInfo[LevelIndex].DataSize - StagingSize);
+    memcpy(Staging + StagingSize, src_data, count);
+    StagingSize += count;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Indicates that all data for the current mipmap level of an image element has been supplied. Missing source data is 
+/// zero-filled, and the level is converted directly into the committed memory of the element.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND, or a system error code.
+uint32_t image_encoder_yuv_t::mark_level(size_t element)
+{
+    if (!TargetDefined || element != ElementIndex || LevelIndex >= Metadata->LevelCount)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    dds_level_desc_t const &src = Metadata->LevelInfo[LevelIndex];
+    dds_level_desc_t const &dst = Target.LevelInfo[LevelIndex];
+    if (StagingSize < src.DataSize)
+    {   // the source data ended early; don't convert uninitialized memory.
+        memset(Staging + StagingSize, 0, src.DataSize - StagingSize);
+    }
+    uint8_t *out = (uint8_t*) image_memory_increase_commit(Memory, ImageId, ElementIndex, BytesWritten + dst.DataSize);
+    if (out == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    for (size_t i = 0; i < src.Slices; ++i)
+    {
+        uint8_t const *s = Staging + i * src.BytesPerSlice;
+        uint8_t       *d = out     + i * dst.BytesPerSlice;
+        yuv_convert_slice(&Convert, WorkPool, s, src.BytesPerRow, src.Width, src.Height, d, dst.BytesPerRow);
+    }
+    BytesWritten += dst.DataSize;
+    StagingSize   = 0;
+    LevelIndex++;
+    return image_memory_mark_level_end(Memory, ImageId, element);
+}
+
+/// @summary Indicates that all data for an image element has been encoded.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_yuv_t::mark_element(size_t element)
+{
+    return image_memory_mark_element_end(Memory, ImageId, element, PlacementQueue, PlacementAlloc);
+}
+
+/// @summary Constructs a new LZ encoder.
+image_encoder_lz_t::image_encoder_lz_t(void)
+    :
+    TargetDefined(false), 
+    ElementIndex(0), 
+    ChunkSize(0), 
+    Chunk(NULL), 
+    Packed(NULL)
+{
+    memset(&Target, 0, sizeof(image_definition_t));
+}
+
+/// @summary Frees the target image definition and the chunk buffers.
+image_encoder_lz_t::~image_encoder_lz_t(void)
+{
+    if (TargetDefined) image_definition_free(&Target);
+    free(Packed);
+    free(Chunk);
+}
+
+/// @summary Builds the definition of the LZ-encoded output image from the source image metadata, and allocates the chunk buffers.
+/// The level descriptors continue to describe the uncompressed data, which is what consumers see after decoding.
+/// @return true if the target definition was built, or false if the metadata is not available or memory allocation failed.
+bool image_encoder_lz_t::define_target(void)
+{
+    if (TargetDefined)
+    {   // the target definition has already been built.
+        return true;
+    }
+    if (Metadata == NULL || Metadata->LevelCount == 0)
+    {   // the source image attributes are not known.
+        return false;
+    }
+    image_definition_copy(&Target, Metadata);
+    Chunk  = (uint8_t*) malloc(IMAGE_LZ_CHUNK_SIZE);
+    Packed = (uint8_t*) malloc(IMAGE_LZ_CHUNK_SIZE + sizeof(image_lz_chunk_t));
+    if (Target.LevelInfo == NULL || Chunk == NULL || Packed == NULL)
+    {   // unable to allocate the level descriptors or chunk buffers.
+        free(Packed); Packed = NULL;
+        free(Chunk);  Chunk  = NULL;
+        image_definition_free(&Target);
+        return false;
+    }
+    Target.Compression = TargetCompression;
+    Target.Encoding    = TargetEncoding;
+    TargetDefined      = true;
+    return true;
+}
+
+/// @summary Compresses the staged chunk and appends it to the current level.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_lz_t::flush_chunk(void)
+{
+    size_t size = image_lz_encode_chunk(Packed, Chunk, ChunkSize);
+    ChunkSize   = 0;
+    return image_memory_write(Memory, ImageId, ElementIndex, Packed, size);
+}
+
+/// @summary Defines the complete attributes of an image and reserves process address space for the LZ-encoded image storage.
+/// Enough address space is reserved to store every chunk uncompressed; only the space actually used is committed.
+/// @param def The source image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_OUTOFMEMORY, or a system error code.
+uint32_t image_encoder_lz_t::define_image(image_definition_t const *def)
+{   // save a reference to the source metadata for later access.
+    Metadata = def;
+    if (!define_target())
+    {
+        return (def->LevelCount == 0) ? ERROR_INVALID_PARAMETER : ERROR_OUTOFMEMORY;
+    }
+    size_t max_element_size = image_lz_element_bound(&Target);
+    return image_memory_reserve_image(Memory, max_element_size, &Target, TargetEncoding, AccessType, DefinitionQueue, DefinitionAlloc);
+}
+
+/// @summary Decommits all memory associated with an image array element or frame, and resets the encoder to the start of level 0 of the element.
+/// @param element The zero-based index of the image array element or frame to reset.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_lz_t::reset_element(size_t element)
+{
+    if (!define_target())
+    {   // the image was already defined, but the metadata wasn't supplied.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (image_memory_reset_element_storage(Memory, ImageId, element) == NULL)
+    {
+        uint32_t err  = GetLastError();
+        if (SUCCEEDED(err))
+        {   // no OS error, so we couldn't find the image.
+            return ERROR_NOT_FOUND;
+        }
+        else
+        {   // return the OS error.
+            return err;
+        }
+    }
+    ElementIndex = element;
+    ChunkSize    = 0;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Stages source data and compresses each complete chunk, appending it to the current mipmap level of the specified image element.
+/// @param element The zero-based index of the element to write. This must be the element specified in the most recent call to reset_element.
+/// @param src_data The source data. The data may be split across calls at any byte boundary.
+/// @param src_size The number of bytes of source data.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_lz_t::encode(size_t element, void const *src_data, size_t src_size)
+{
+    uint8_t const *src = (uint8_t const*) src_data;
+    if (!TargetDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    while (src_size > 0)
+    {
+        size_t count = image_min2<size_t>(src_size, IMAGE_LZ_CHUNK_SIZE - ChunkSize);
+        memcpy(Chunk + ChunkSize, src, count);
+        ChunkSize   += count;
+        src_size    -= count;
+        src         += count;
+        if (ChunkSize == IMAGE_LZ_CHUNK_SIZE)
+        {   // a complete chunk is available.
+            uint32_t err = flush_chunk();
+            if (err != ERROR_SUCCESS)
+                return err;
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Indicates that all data for the current mipmap level of an image element has been supplied. Any partial chunk is compressed and written.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND, or a system error code.
+uint32_t image_encoder_lz_t::mark_level(size_t element)
+{
+    if (!TargetDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (ChunkSize > 0)
+    {   // chunks don't span levels.
+        uint32_t err = flush_chunk();
+        if (err != ERROR_SUCCESS)
+            return err;
+    }
+    return image_memory_mark_level_end(Memory, ImageId, element);
+}
+
+/// @summary Indicates that all data for an image element has been encoded.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_lz_t::mark_element(size_t element)
+{
+    return image_memory_mark_element_end(Memory, ImageId, element, PlacementQueue, PlacementAlloc);
+}
+
+/// @summary Constructs a new mipmap generation stage that passes all data through to another encoder.
+/// @param inner The encoder that receives every level. The stage takes ownership of the encoder.
+image_encoder_mipmap_t::image_encoder_mipmap_t(image_encoder_t *inner)
+    :
+    Inner(inner), 
+    ChainDefined(false), 
+    Generate(false), 
+    WorkPool(NULL), 
+    BandRows(1), 
+    ElementIndex(0), 
+    LevelIndex(0), 
+    RowIndex(0), 
+    TargetRows(0), 
+    StagingSize(0), 
+    Staging(NULL), 
+    LevelRows(NULL), 
+    Scratch(NULL)
+{
+    memset(&Chain , 0, sizeof(image_definition_t));
+    memset(&Filter, 0, sizeof(image_mipmap_t));
+}
+
+/// @summary Frees the extended image definition, the level buffers and the inner encoder.
+image_encoder_mipmap_t::~image_encoder_mipmap_t(void)
+{
+    if (Generate) image_definition_free(&Chain);
+    free(Scratch);
+    free(LevelRows);
+    free(Staging);
+    delete Inner;
+}
+
+/// @summary Determines whether levels will be generated for the image and, if so, builds the extended image definition and allocates the level buffers.
+/// Levels are generated for two-dimensional images with a single level in a format supported by the box filter; all other images pass through unchanged.
+/// @return true if the stage is ready, or false if the metadata is not available or memory allocation failed.
+bool image_encoder_mipmap_t::define_chain(void)
+{
+    if (ChainDefined)
+    {   // the extended definition has already been built.
+        return true;
+    }
+    if (Metadata == NULL || Metadata->LevelCount == 0)
+    {   // the source image attributes are not known.
+        return false;
+    }
+    size_t levels = image_mipmap_level_count(Metadata->Width, Metadata->Height);
+    Generate      =(Metadata->LevelCount == 1 && levels > 1 && Metadata->LevelInfo[0].Slices == 1 && image_mipmap_init(&Filter, Metadata->ImageFormat));
+    if (!Generate)
+    {   // pass the source definition through unchanged.
+        Inner->Metadata = Metadata;
+        ChainDefined    = true;
+        return true;
+    }
+    uint32_t format   = Metadata->ImageFormat;
+    Chain             =*Metadata;
+    Chain.LevelInfo   = NULL;
+    Chain.BlockOffsets= NULL;
+    image_definition_init(&Chain, Metadata->ElementCount, levels);
+    for (size_t i = 0; i < Metadata->ElementCount; ++i)
+    {   // only level 0 is read from the source file.
+        Chain.BlockOffsets[i * levels] = Metadata->BlockOffsets[i];
+    }
+    for (size_t i = 0; i < levels; ++i)
+    {
+        dds_level_desc_t &dst = Chain.LevelInfo[i];
+        size_t levelw         = image_level_dimension(Metadata->Width , i);
+        size_t levelh         = image_level_dimension(Metadata->Height, i);
+        size_t levelp         = dxgi_pitch(format, levelw);
+        dst.Index             = i;
+        dst.Width             = levelw;
+        dst.Height            = levelh;
+        dst.Slices            = 1;
+        dst.BytesPerElement   = Filter.PixelSize;
+        dst.BytesPerRow       = levelp;
+        dst.BytesPerSlice     = levelp * levelh;
+        dst.DataSize          = dst.BytesPerSlice;
+        dst.Format            = format;
+    }
+    Chain.DDSHeader.Flags |= DDSD_MIPMAPCOUNT;
+    Chain.DDSHeader.Caps  |= DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+    Chain.DDSHeader.Levels = uint32_t(levels);
+    if (WorkPool != NULL && WorkPool->ThreadCount > 0)
+    {   // stage enough rows that every thread reduces at least one band.
+        BandRows = image_min2<size_t>(Chain.LevelInfo[1].Height, 2 * IMAGE_MIPMAP_BAND_ROWS * (WorkPool->ThreadCount + 1));
+    }
+    else BandRows = image_min2<size_t>(Chain.LevelInfo[1].Height, IMAGE_MIPMAP_BAND_ROWS);
+    // levels 3 and up are reduced into the buffers for levels 1 and 2, alternately.
+    Staging   = (uint8_t*) malloc(BandRows * 2 * Metadata->LevelInfo[0].BytesPerRow);
+    LevelRows = (uint8_t*) malloc(Chain.LevelInfo[1].DataSize);
+    Scratch   = (levels > 2) ? (uint8_t*) malloc(Chain.LevelInfo[2].DataSize) : NULL;
+    if (Staging == NULL || LevelRows == NULL || (levels > 2 && Scratch == NULL))
+    {   // unable to allocate the level buffers.
+        free(Scratch);   Scratch   = NULL;
+        free(LevelRows); LevelRows = NULL;
+        free(Staging);   Staging   = NULL;
+        image_definition_free(&Chain);
+        Generate = false;
+        return false;
+    }
+    Inner->Metadata = &Chain;
+    ChainDefined    =  true;
+    return true;
+}
+
+/// @summary Reduces the rows in the staging buffer to the corresponding rows of level 1. The rows are reduced in parallel on the worker pool, if there is one.
+/// @param rows The number of valid level 0 rows in the staging buffer, in [1, BandRows * 2].
+void image_encoder_mipmap_t::reduce_rows(size_t rows)
+{
+    dds_level_desc_t const &src = Metadata->LevelInfo[0];
+    dds_level_desc_t const &dst = Chain.LevelInfo[1];
+    size_t first = RowIndex / 2;
+    if (first < dst.Height)
+    {   // an odd final row of level 0 is not sampled, unless it is the only row.
+        size_t count = image_min2<size_t>(image_max2<size_t>(1, rows / 2), dst.Height - first);
+        image_mipmap_reduce(&Filter, WorkPool, Staging, src.Width, rows, src.BytesPerRow, LevelRows + first * dst.BytesPerRow, dst.Width, count, dst.BytesPerRow);
+        TargetRows = first + count;
+    }
+    RowIndex   += rows;
+    StagingSize = 0;
+}
+
+/// @summary Defines the complete attributes of an image. The inner encoder is given the definition extended with the generated levels, which it posts to the definition queue.
+/// @param def The source image definition. The ElementCount field must be set to the total number of array elements or frames in the image.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_OUTOFMEMORY, or a system error code.
+uint32_t image_encoder_mipmap_t::define_image(image_definition_t const *def)
+{   // save a reference to the source metadata for later access.
+    Metadata = def;
+    if (!define_chain())
+    {
+        return (def->LevelCount == 0) ? ERROR_INVALID_PARAMETER : ERROR_OUTOFMEMORY;
+    }
+    return Inner->define_image(Generate ? &Chain : def);
+}
+
+/// @summary Resets the inner encoder to the start of level 0 of an image element.
+/// @param element The zero-based index of the image array element or frame to reset.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_mipmap_t::reset_element(size_t element)
+{
+    if (!define_chain())
+    {   // the image was already defined, but the metadata wasn't supplied.
+        return ERROR_INVALID_PARAMETER;
+    }
+    ElementIndex = element;
+    LevelIndex   = 0;
+    RowIndex     = 0;
+    TargetRows   = 0;
+    StagingSize  = 0;
+    return Inner->reset_element(element);
+}
+
+/// @summary Passes source data through to the inner encoder. Level 0 data is also staged, and each complete band of rows is reduced to level 1.
+/// @param element The zero-based index of the element to write. This must be the element specified in the most recent call to reset_element.
+/// @param src_data The source pixel data. The data may be split across calls at any byte boundary.
+/// @param src_size The number of bytes of source pixel data.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_mipmap_t::encode(size_t element, void const *src_data, size_t src_size)
+{
+    uint8_t const *src = (uint8_t const*) src_data;
+    if (!ChainDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    uint32_t err = Inner->encode(element, src_data, src_size);
+    if (err != ERROR_SUCCESS || !Generate || LevelIndex > 0)
+    {   // there is nothing to stage.
+        return err;
+    }
+    dds_level_desc_t const &level = Metadata->LevelInfo[0];
+    while (src_size > 0 && RowIndex < level.Height)
+    {
+        size_t rows  = image_min2<size_t>(BandRows * 2, level.Height - RowIndex);
+        size_t need  = rows * level.BytesPerRow;
+        size_t count = image_min2<size_t>(src_size, need - StagingSize);
+        memcpy(Staging + StagingSize, src, count);
+        StagingSize += count;
+        src_size    -= count;
+        src         += count;
+        if (StagingSize == need)
+        {   // a complete band of rows is available.
+            reduce_rows(rows);
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Indicates that all data for the current mipmap level of an image element has been supplied. When level 0 is 
+/// complete, the remaining levels are generated and passed to the inner encoder before this function returns.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER, ERROR_NOT_FOUND, or a system error code.
+uint32_t image_encoder_mipmap_t::mark_level(size_t element)
+{
+    if (!ChainDefined || element != ElementIndex)
+    {   // reset_element must be called first; only one element is encoded at a time.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (!Generate || LevelIndex > 0)
+    {   // the level was supplied by the source.
+        LevelIndex++;
+        return Inner->mark_level(element);
+    }
+    if (StagingSize > 0)
+    {   // the source data ended partway through a band; zero-fill the last partial row.
+        size_t pitch = Metadata->LevelInfo[0].BytesPerRow;
+        size_t rows  =(StagingSize + pitch - 1) / pitch;
+        memset(Staging + StagingSize, 0, rows * pitch - StagingSize);
+        reduce_rows(rows);
+    }
+    dds_level_desc_t const &first = Chain.LevelInfo[1];
+    if (TargetRows < first.Height)
+    {   // the source data ended early; don't filter uninitialized memory into the smaller levels.
+        memset(LevelRows + TargetRows * first.BytesPerRow, 0, (first.Height - TargetRows) * first.BytesPerRow);
+    }
+    uint32_t err = Inner->mark_level(element);
+    if (err != ERROR_SUCCESS)
+        return err;
+
+    uint8_t *prev = LevelRows;
+    uint8_t *next = Scratch;
+    for (LevelIndex = 1; LevelIndex < Chain.LevelCount; ++LevelIndex)
+    {
+        dds_level_desc_t const &dst = Chain.LevelInfo[LevelIndex];
+        if (LevelIndex > 1)
+        {   // reduce the previous level, and swap the buffers.
+            dds_level_desc_t const &src = Chain.LevelInfo[LevelIndex - 1];
+            image_mipmap_reduce(&Filter, WorkPool, prev, src.Width, src.Height, src.BytesPerRow, next, dst.Width, dst.Height, dst.BytesPerRow);
+            uint8_t *temp = prev; prev = next; next = temp;
+        }
+        if ((err = Inner->encode(element, prev, dst.DataSize)) != ERROR_SUCCESS)
+            return err;
+        if ((err = Inner->mark_level(element)) != ERROR_SUCCESS)
+            return err;
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Indicates that all data for an image element has been encoded.
+/// @param element The zero-based index of the image element being written.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
+uint32_t image_encoder_mipmap_t::mark_element(size_t element)
+{
+    return Inner->mark_element(element);
+}
@@ -0,0 +1,554 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a persisted block-offset index. The index is a compact
+/// sidecar file, which may be stored on disk or as a member of a tarball, that
+/// records the headers and the byte offset of every level of every element of
+/// a set of image files, along with the size and modification time of each
+/// file at the time the index was built. The loader consults the index when a
+/// file is opened, and if the file is unchanged, skips the synchronous header
+/// read and issues range reads directly. Indexes are generated for a tree or a
+/// list of files with image_index_build().
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The current version of the index file format.
+static uint32_t const IMAGE_INDEX_VERSION        = 1;
+
+/// @summary The maximum number of bytes of file header data stored for an entry.
+/// This is large enough for the DDS magic, base header and DX10 header.
+#define IMAGE_INDEX_MAX_HEADER_SIZE                (sizeof(uint32_t) + sizeof(dds_header_t) + sizeof(dds_header_dxt10_t))
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define the source file formats that can be described by an index entry.
+/// Only formats whose pixel data can be located without decoding are indexed.
+enum image_index_format_e : uint32_t
+{
+    IMAGE_INDEX_FORMAT_UNKNOWN   = 0,          /// The entry format is not known.
+    IMAGE_INDEX_FORMAT_DDS       = 1,          /// The entry describes a Microsoft DDS file.
+};
+
+/// @summary Define the header at the start of an index file. The header is followed by
+/// EntryCount image_index_record_t, sorted by PathHash, then OffsetCount 64-bit byte
+/// offsets, then StringBytes bytes of NULL-terminated UTF-8 virtual paths.
+#pragma pack(push, 1)
+struct image_index_header_t
+{
+    uint32_t                  Magic;           /// The file identifier, 'SIDX'.
+    uint32_t                  Version;         /// The file format version, IMAGE_INDEX_VERSION.
+    uint32_t                  EntryCount;      /// The number of entry records.
+    uint32_t                  OffsetCount;     /// The number of values in the offset table.
+    uint32_t                  StringBytes;     /// The size of the path string table, in bytes.
+    uint32_t                  Reserved;        /// Reserved for future use. Set to zero.
+};
+#pragma pack(pop)
+
+/// @summary Define the record describing a single indexed file. Records are 8-byte aligned in the file.
+#pragma pack(push, 1)
+struct image_index_record_t
+{
+    uint32_t                  PathHash;        /// The hash of the normalized virtual path of the file.
+    uint32_t                  PathOffset;      /// The byte offset of the virtual path in the string table.
+    uint32_t                  FileFormat;      /// One of image_index_format_e.
+    uint32_t                  HeaderSize;      /// The number of bytes of Header data that are valid.
+    int64_t                   FileSize;        /// The size of the file data, in bytes, when the index was built.
+    uint64_t                  FileTime;        /// The last write time of the file data, as a UNIX timestamp, when the index was built.
+    uint32_t                  ElementCount;    /// The number of array elements or cubemap faces in the file.
+    uint32_t                  LevelCount;      /// The number of levels in the mipmap chain of each element.
+    uint32_t                  FirstOffset;     /// The index of the first value in the offset table for this file.
+    uint32_t                  OffsetCount;     /// The number of offsets, ElementCount * LevelCount, ordered by element, then level.
+    uint8_t                   Header[IMAGE_INDEX_MAX_HEADER_SIZE]; /// The raw file header data, starting at the beginning of the file.
+    uint32_t                  Reserved;        /// Reserved for future use. Set to zero.
+};
+#pragma pack(pop)
+
+/// @summary Define the in-memory representation of a loaded index. The index is loaded in
+/// place, so Entries, Offsets and Strings all point into the single Storage allocation.
+/// A loaded index is never modified, so it may be read from any number of threads.
+struct image_index_t
+{
+    size_t                    EntryCount;      /// The number of indexed files.
+    image_index_record_t const*Entries;        /// The entry records, sorted by PathHash.
+    size_t                    OffsetCount;     /// The number of values in the offset table.
+    uint64_t const           *Offsets;         /// The byte offset of each level, relative to the start of the file data.
+    size_t                    StringBytes;     /// The size of the path string table, in bytes.
+    char const               *Strings;         /// The NULL-terminated UTF-8 virtual paths of the indexed files.
+    void                     *Storage;         /// The contents of the index file.
+};
+
+/// @summary Define the growable state used while generating an index.
+struct image_index_builder_t
+{
+    size_t                    EntryCount;      /// The number of records in Entries.
+    size_t                    EntryCapacity;   /// The number of records that can be stored in Entries.
+    image_index_record_t     *Entries;         /// The records generated so far, in the order the files were visited.
+    size_t                    OffsetCount;     /// The number of values in Offsets.
+    size_t                    OffsetCapacity;  /// The number of values that can be stored in Offsets.
+    uint64_t                 *Offsets;         /// The offset table generated so far.
+    size_t                    StringBytes;     /// The number of bytes used in Strings.
+    size_t                    StringCapacity;  /// The number of bytes that can be stored in Strings.
+    char                     *Strings;         /// The path string table generated so far.
+    size_t                   *Scratch;         /// Scratch storage for the level offsets returned by dds_describe().
+    size_t                    ScratchCapacity; /// The number of values that can be stored in Scratch.
+};
+
+/// @summary Functor used to sort index records by path hash.
+struct image_index_record_order_t
+{
+    bool operator()(image_index_record_t const &a, image_index_record_t const &b) const
+    {
+        return a.PathHash < b.PathHash;
+    }
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Normalize a single character for path comparisons.
+/// @param ch The character to normalize.
+/// @return If ch specifies an upper-case ASCII character, it is converted to lower case. If ch specifies a backslash, it is converted to a forward slash.
+internal_function inline char image_index_path_normalize(char ch)
+{
+    return ((ch >= 'A' && ch <= 'Z') ? ((ch - 'A') + 'a') : ((ch == '\\') ? '/' : ch));
+}
+
+/// @summary Calculates the hash of a normalized path, so that paths differing only in case or separator hash equal.
+/// @param path A NULL-terminated UTF-8 path string.
+/// @return The 32-bit hash of the normalized path.
+internal_function uint32_t image_index_path_hash(char const *path)
+{
+    uint32_t hash = 0;
+    while (*path)
+    {
+        hash = _lrotl(hash, 7) + uint8_t(image_index_path_normalize(*path++));
+    }
+    return hash;
+}
+
+/// @summary Compares two path strings for equality, ignoring case and separator differences.
+/// @param a A NULL-terminated path string.
+/// @param b A NULL-terminated path string.
+/// @return true if paths a and b represent the same entity.
+internal_function bool image_index_path_match(char const *a, char const *b)
+{
+    char ca, cb;
+    do
+    {
+        ca = image_index_path_normalize(*a++);
+        cb = image_index_path_normalize(*b++);
+    }
+    while  (ca == cb && ca != 0);
+    return (ca == cb);
+}
+
+/// @summary Ensures that a growable builder array can hold at least the specified number of items.
+/// @param list The array to grow.
+/// @param capacity The current capacity of the array, in items. Updated on return.
+/// @param required The number of items that must fit.
+/// @return true if the array can hold the required number of items.
+template <typename T>
+internal_function bool image_index_builder_ensure(T *&list, size_t &capacity, size_t required)
+{
+    if (required <= capacity)
+    {   // no need to grow the array.
+        return true;
+    }
+    size_t new_amount = calculate_capacity(capacity, required, 4096, 1024);
+    T     *new_list   = (T*) realloc(list, new_amount * sizeof(T));
+    if (new_list == NULL)
+    {   // unable to grow the array; the existing contents are unchanged.
+        return false;
+    }
+    list     = new_list;
+    capacity = new_amount;
+    return true;
+}
+
+/// @summary Frees all storage owned by an index builder.
+/// @param builder The index builder to delete.
+internal_function void image_index_builder_delete(image_index_builder_t *builder)
+{
+    free(builder->Scratch);
+    free(builder->Strings);
+    free(builder->Offsets);
+    free(builder->Entries);
+    ZeroMemory(builder, sizeof(image_index_builder_t));
+}
+
+/// @summary Reads the headers of a DDS file and appends its record, offsets and path to an index builder.
+/// @param builder The index builder.
+/// @param io The I/O interface of the calling thread.
+/// @param path The NULL-terminated UTF-8 virtual path of the file.
+/// @return ERROR_SUCCESS, ERROR_BAD_FORMAT, ERROR_OUTOFMEMORY or the system error code.
+internal_function DWORD image_index_builder_add_dds(image_index_builder_t *builder, thread_io_t *io, char const *path)
+{
+    vfs_file_t         file;
+    dds_header_t       dds;
+    dds_header_dxt10_t dx10;
+    size_t             nread = 0;
+    uint8_t            header[IMAGE_INDEX_MAX_HEADER_SIZE];
+    DWORD              error = io->open_file_mapping(path, &file);
+    if (error != ERROR_SUCCESS)
+    {   // the file doesn't exist or can't be opened.
+        return error;
+    }
+    if ((error = io->read_sync(&file, file.BaseOffset, header, sizeof(header), nread)) != ERROR_SUCCESS)
+    {   // the headers can't be read.
+        io->close_file(&file);
+        return error;
+    }
+    io->close_file(&file);
+    if (int64_t(nread) > file.BaseSize) nread = size_t(file.BaseSize);
+    if (!dds_header(header, nread, &dds))
+    {   // the file is not a DDS file, or is truncated.
+        return ERROR_BAD_FORMAT;
+    }
+
+    bool   has_dx10    = dds_header_dxt10(header, nread, &dx10);
+    size_t header_size = sizeof(uint32_t) + sizeof(dds_header_t) + (has_dx10 ? sizeof(dds_header_dxt10_t) : 0);
+    size_t nitems      = dxgi_array_count(&dds, has_dx10 ? &dx10 : NULL);
+    size_t nlevels     = dxgi_level_count(&dds, has_dx10 ? &dx10 : NULL);
+    size_t noffsets    = nitems * nlevels;
+    size_t path_bytes  = strlen(path) + 1;
+    if (noffsets == 0 || builder->OffsetCount + noffsets > UINT32_MAX || builder->StringBytes + path_bytes > UINT32_MAX)
+    {   // the file is empty, or the index would exceed the limits of the file format.
+        return ERROR_BAD_FORMAT;
+    }
+    if (!image_index_builder_ensure(builder->Entries, builder->EntryCapacity , builder->EntryCount  + 1)         ||
+        !image_index_builder_ensure(builder->Offsets, builder->OffsetCapacity, builder->OffsetCount + noffsets)  ||
+        !image_index_builder_ensure(builder->Strings, builder->StringCapacity, builder->StringBytes + path_bytes) ||
+        !image_index_builder_ensure(builder->Scratch, builder->ScratchCapacity, noffsets))
+    {   // unable to grow the builder storage.
+        return ERROR_OUTOFMEMORY;
+    }
+
+    // the level descriptors are discarded; only the offsets are recorded.
+    dds_level_desc_t *levels = (dds_level_desc_t*) malloc(nlevels * sizeof(dds_level_desc_t));
+    if (levels == NULL)
+    {   // unable to allocate the level descriptors.
+        return ERROR_OUTOFMEMORY;
+    }
+    dds_describe(header, nread, &dds, has_dx10 ? &dx10 : NULL, levels, builder->Scratch, nlevels);
+    free(levels);
+
+    image_index_record_t &rec = builder->Entries[builder->EntryCount++];
+    ZeroMemory(&rec, sizeof(image_index_record_t));
+    rec.PathHash     = image_index_path_hash(path);
+    rec.PathOffset   = uint32_t(builder->StringBytes);
+    rec.FileFormat   = IMAGE_INDEX_FORMAT_DDS;
+    rec.HeaderSize   = uint32_t(header_size);
+    rec.FileSize     = file.FileSize;
+    rec.FileTime     = file.FileTime;
+    rec.ElementCount = uint32_t(nitems);
+    rec.LevelCount   = uint32_t(nlevels);
+    rec.FirstOffset  = uint32_t(builder->OffsetCount);
+    rec.OffsetCount  = uint32_t(noffsets);
+    memcpy(rec.Header, header, header_size);
+    for (size_t i = 0; i < noffsets; ++i)
+    {
+        builder->Offsets[builder->OffsetCount++] = uint64_t(builder->Scratch[i]);
+    }
+    memcpy(&builder->Strings[builder->StringBytes], path, path_bytes);
+    builder->StringBytes += path_bytes;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Validates the contents of an index file and sets the in-memory pointers into it.
+/// @param index The index to initialize. The Storage field must point to the file contents.
+/// @param size The size of the file contents, in bytes.
+/// @return true if the file contents describe a valid index.
+internal_function bool image_index_bind(image_index_t *index, size_t size)
+{
+    uint8_t const              *base = (uint8_t const*) index->Storage;
+    image_index_header_t const *head = (image_index_header_t const*) base;
+    if (size < sizeof(image_index_header_t) || head->Magic != image_fourcc_le('S','I','D','X') || head->Version != IMAGE_INDEX_VERSION)
+    {   // this is not an index file, or was written by an incompatible version.
+        return false;
+    }
+    size_t records_size = size_t(head->EntryCount ) * sizeof(image_index_record_t);
+    size_t offsets_size = size_t(head->OffsetCount) * sizeof(uint64_t);
+    if (size != sizeof(image_index_header_t) + records_size + offsets_size + head->StringBytes)
+    {   // the file is truncated, or has trailing data.
+        return false;
+    }
+    index->EntryCount  = head->EntryCount;
+    index->Entries     =(image_index_record_t const*)(base + sizeof(image_index_header_t));
+    index->OffsetCount = head->OffsetCount;
+    index->Offsets     =(uint64_t const*)(base + sizeof(image_index_header_t) + records_size);
+    index->StringBytes = head->StringBytes;
+    index->Strings     =(char const*)(base + sizeof(image_index_header_t) + records_size + offsets_size);
+    if (index->StringBytes == 0 || index->Strings[index->StringBytes - 1] != 0)
+    {   // the path string table must be NULL-terminated.
+        return false;
+    }
+    for (size_t i = 0, n = index->EntryCount; i < n; ++i)
+    {
+        image_index_record_t const &rec = index->Entries[i];
+        if (rec.PathOffset >= index->StringBytes || rec.HeaderSize > IMAGE_INDEX_MAX_HEADER_SIZE ||
+            size_t(rec.FirstOffset) + rec.OffsetCount > index->OffsetCount ||
+            size_t(rec.ElementCount) * rec.LevelCount != rec.OffsetCount ||
+           (i > 0 && index->Entries[i-1].PathHash > rec.PathHash))
+        {   // the record references data outside of the file, or the records are not sorted.
+            return false;
+        }
+    }
+    return true;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initializes an index to the empty state. An empty index never matches any file.
+/// @param index The index to initialize.
+public_function void image_index_init(image_index_t *index)
+{
+    index->EntryCount  = 0;
+    index->Entries     = NULL;
+    index->OffsetCount = 0;
+    index->Offsets     = NULL;
+    index->StringBytes = 0;
+    index->Strings     = NULL;
+    index->Storage     = NULL;
+}
+
+/// @summary Synchronously loads an index file. The file may be a regular file or a member of a mounted tarball.
+/// @param index The index to initialize. On failure, the index is left empty.
+/// @param io The I/O interface of the calling thread.
+/// @param path The NULL-terminated UTF-8 virtual path of the index file.
+/// @return ERROR_SUCCESS, ERROR_BAD_FORMAT, ERROR_OUTOFMEMORY or the system error code.
+public_function DWORD image_index_load(image_index_t *index, thread_io_t *io, char const *path)
+{
+    vfs_file_t file;
+    size_t     nread = 0;
+    DWORD      error = ERROR_SUCCESS;
+    image_index_init(index);
+    if ((error = io->open_file_mapping(path, &file)) != ERROR_SUCCESS)
+    {   // the index file doesn't exist or can't be opened.
+        return error;
+    }
+    if (file.FileSize < int64_t(sizeof(image_index_header_t)) || file.FileSize > int64_t(UINT32_MAX))
+    {   // the file is too small or too large to be an index file.
+        io->close_file(&file);
+        return ERROR_BAD_FORMAT;
+    }
+    if ((index->Storage = malloc(size_t(file.FileSize))) == NULL)
+    {   // unable to allocate storage for the file contents.
+        io->close_file(&file);
+        return ERROR_OUTOFMEMORY;
+    }
+    error = io->read_sync(&file, file.BaseOffset, index->Storage, size_t(file.FileSize), nread);
+    io->close_file(&file);
+    if (error != ERROR_SUCCESS || nread != size_t(file.FileSize) || !image_index_bind(index, nread))
+    {   // the file couldn't be read, or isn't a valid index.
+        free(index->Storage);
+        image_index_init(index);
+        return error != ERROR_SUCCESS ? error : ERROR_BAD_FORMAT;
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Frees all resources associated with an index.
+/// @param index The index to delete.
+public_function void image_index_delete(image_index_t *index)
+{
+    free(index->Storage);
+    image_index_init(index);
+}
+
+/// @summary Searches an index for the entry describing an open file. The entry is only returned if the file is unchanged since the index was built.
+/// @param index The index to search, or NULL.
+/// @param path The NULL-terminated UTF-8 virtual path used to open the file.
+/// @param file The open file. The FileSize and FileTime fields are compared against the entry.
+/// @return The index entry for the file, or NULL if the file is not indexed or has been modified.
+public_function image_index_record_t const* image_index_find(image_index_t const *index, char const *path, vfs_file_t const *file)
+{
+    if (index == NULL || index->EntryCount == 0 || path == NULL)
+    {   // no index was supplied.
+        return NULL;
+    }
+    uint32_t hash = image_index_path_hash(path);
+    size_t   lo   = 0;
+    size_t   hi   = index->EntryCount;
+    while (lo < hi)
+    {   // find the first record with a matching hash.
+        size_t mid = lo + ((hi - lo) / 2);
+        if (index->Entries[mid].PathHash < hash) lo = mid + 1;
+        else hi = mid;
+    }
+    for ( ; lo < index->EntryCount && index->Entries[lo].PathHash == hash; ++lo)
+    {
+        image_index_record_t const &rec = index->Entries[lo];
+        if (image_index_path_match(&index->Strings[rec.PathOffset], path))
+        {   // found the entry; it's only usable if the file hasn't changed.
+            if (rec.FileSize == file->FileSize && rec.FileTime == file->FileTime)
+                return &rec;
+            else
+                return NULL;
+        }
+    }
+    return NULL;
+}
+
+/// @summary Retrieves the DDS headers stored in an index entry.
+/// @param rec The index entry returned by image_index_find().
+/// @param dds On return, the base DDS header.
+/// @param dx10 On return, the extended DX10 header, if present.
+/// @param has_dx10 On return, set to true if the file has an extended DX10 header.
+/// @return true if the entry describes a DDS file and its headers are valid.
+public_function bool image_index_dds_header(image_index_record_t const *rec, dds_header_t *dds, dds_header_dxt10_t *dx10, bool &has_dx10)
+{
+    if (rec->FileFormat != IMAGE_INDEX_FORMAT_DDS || !dds_header(rec->Header, rec->HeaderSize, dds))
+    {   // the entry doesn't describe a DDS file.
+        return false;
+    }
+    has_dx10 = dds_header_dxt10(rec->Header, rec->HeaderSize, dx10);
+    return true;
+}
+
+/// @summary Copies the level offsets stored in an index entry into the BlockOffsets of an image definition.
+/// @param index The index containing the entry.
+/// @param rec The index entry returned by image_index_find().
+/// @param meta The image definition, with the BlockOffsets array allocated.
+/// @return true if the entry layout matches the definition and the offsets were copied.
+public_function bool image_index_block_offsets(image_index_t const *index, image_index_record_t const *rec, image_definition_t *meta)
+{
+    if (meta->BlockOffsets == NULL || rec->ElementCount != meta->ElementCount || rec->LevelCount != meta->LevelCount)
+    {   // the definition doesn't match the layout recorded in the index.
+        return false;
+    }
+    uint64_t const *src = &index->Offsets[rec->FirstOffset];
+    for (size_t i = 0, n = rec->OffsetCount; i < n; ++i)
+    {
+        meta->BlockOffsets[i].FileOffset   = int64_t(src[i]);
+        meta->BlockOffsets[i].DecodeOffset = 0;
+    }
+    return true;
+}
+
+/// @summary Generates an index describing a set of image files and writes it to a file. Files that aren't DDS files are skipped.
+/// The index file may be written to a directory mount and later packed into a tarball alongside the files it describes.
+/// @param io The I/O interface of the calling thread.
+/// @param paths The NULL-terminated UTF-8 virtual paths of the files to index. These are the paths the loader will receive.
+/// @param count The number of paths.
+/// @param index_path The NULL-terminated UTF-8 virtual path of the index file to write.
+/// @param num_indexed If non-NULL, on return, set to the number of files that were added to the index.
+/// @return ERROR_SUCCESS, ERROR_OUTOFMEMORY, or ERROR_WRITE_FAULT if the index file couldn't be written.
+public_function DWORD image_index_build(thread_io_t *io, char const **paths, size_t count, char const *index_path, size_t *num_indexed)
+{
+    image_index_builder_t builder;
+    ZeroMemory(&builder, sizeof(image_index_builder_t));
+    if (num_indexed != NULL) *num_indexed = 0;
+    for (size_t i = 0; i < count; ++i)
+    {   // files that can't be opened or parsed aren't indexed; the loader reads their headers as usual.
+        if (image_index_builder_add_dds(&builder, io, paths[i]) == ERROR_OUTOFMEMORY)
+        {
+            image_index_builder_delete(&builder);
+            return ERROR_OUTOFMEMORY;
+        }
+    }
+    if (builder.StringBytes == 0 && !image_index_builder_ensure(builder.Strings, builder.StringCapacity, 1))
+    {   // the string table always contains at least one byte.
+        image_index_builder_delete(&builder);
+        return ERROR_OUTOFMEMORY;
+    }
+    if (builder.StringBytes == 0)
+    {   // an index with no entries is still valid.
+        builder.Strings[builder.StringBytes++] = 0;
+    }
+    std::sort(builder.Entries, builder.Entries + builder.EntryCount, image_index_record_order_t());
+
+    // serialize the header, records, offsets and strings into a single buffer.
+    size_t   records_size = builder.EntryCount  * sizeof(image_index_record_t);
+    size_t   offsets_size = builder.OffsetCount * sizeof(uint64_t);
+    size_t   total_size   = sizeof(image_index_header_t) + records_size + offsets_size + builder.StringBytes;
+    uint8_t *data         =(uint8_t*) malloc(total_size);
+    if (data == NULL)
+    {   // unable to allocate the output buffer.
+        image_index_builder_delete(&builder);
+        return ERROR_OUTOFMEMORY;
+    }
+    image_index_header_t *head = (image_index_header_t*) data;
+    head->Magic       = image_fourcc_le('S','I','D','X');
+    head->Version     = IMAGE_INDEX_VERSION;
+    head->EntryCount  = uint32_t(builder.EntryCount);
+    head->OffsetCount = uint32_t(builder.OffsetCount);
+    head->StringBytes = uint32_t(builder.StringBytes);
+    head->Reserved    = 0;
+    memcpy(data + sizeof(image_index_header_t), builder.Entries, records_size);
+    memcpy(data + sizeof(image_index_header_t) + records_size, builder.Offsets, offsets_size);
+    memcpy(data + sizeof(image_index_header_t) + records_size + offsets_size, builder.Strings, builder.StringBytes);
+    bool written = io->put_file(index_path, data, int64_t(total_size));
+    if (num_indexed != NULL) *num_indexed = builder.EntryCount;
+    image_index_builder_delete(&builder);
+    free(data);
+    return written ? ERROR_SUCCESS : ERROR_WRITE_FAULT;
+}
+
+/// @summary Generates an index describing every DDS file in a directory tree and writes it to a file.
+/// @param io The I/O interface of the calling thread.
+/// @param native_root The NULL-terminated UTF-8 native path of the root directory to search.
+/// @param mount_path The NULL-terminated UTF-8 virtual path at which native_root is mounted. Indexed paths are relative to this.
+/// @param index_path The NULL-terminated UTF-8 virtual path of the index file to write.
+/// @param num_indexed If non-NULL, on return, set to the number of files that were added to the index.
+/// @return ERROR_SUCCESS, ERROR_PATH_NOT_FOUND, ERROR_OUTOFMEMORY, or ERROR_WRITE_FAULT if the index file couldn't be written.
+public_function DWORD image_index_build_tree(thread_io_t *io, char const *native_root, char const *mount_path, char const *index_path, size_t *num_indexed)
+{
+    file_list_t files;
+    if (num_indexed != NULL) *num_indexed = 0;
+    if (!create_file_list(&files, 1024, 1024 * MAX_PATH))
+    {   // unable to allocate the file list.
+        return ERROR_OUTOFMEMORY;
+    }
+    if (!enumerate_files(&files, native_root, "*.dds", true))
+    {   // the root directory doesn't exist or can't be searched.
+        delete_file_list(&files);
+        return ERROR_PATH_NOT_FOUND;
+    }
+
+    // map each native path under native_root to its virtual path under mount_path.
+    size_t   root_len  = strlen(native_root);
+    size_t   mount_len = strlen(mount_path);
+    size_t   path_max  = mount_len + 1 + files.MaxPathBytes + 1;
+    char   **paths     = (char**) malloc(files.PathCount * sizeof(char*));
+    char    *pathbuf   = (char *) malloc(files.PathCount * path_max);
+    if (files.PathCount > 0 && (paths == NULL || pathbuf == NULL))
+    {   // unable to allocate the virtual path list.
+        free(pathbuf); free(paths);
+        delete_file_list(&files);
+        return ERROR_OUTOFMEMORY;
+    }
+    for (size_t i = 0, n = files.PathCount; i < n; ++i)
+    {
+        char const *rel = file_list_path(&files, i) + root_len;
+        char       *dst = pathbuf + (i * path_max);
+        size_t      len = mount_len;
+        while (*rel == '\\' || *rel == '/') ++rel;
+        memcpy(dst, mount_path, mount_len);
+        if (len > 0 && dst[len - 1] != '/') dst[len++] = '/';
+        for ( ; *rel; ++rel)
+        {   // virtual paths always use forward slashes.
+            dst[len++] = (*rel == '\\') ? '/' : *rel;
+        }
+        dst[len] = 0;
+        paths[i] = dst;
+    }
+    DWORD result = image_index_build(io, (char const**) paths, files.PathCount, index_path, num_indexed);
+    free(pathbuf);
+    free(paths);
+    delete_file_list(&files);
+    return result;
+}
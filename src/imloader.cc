@@ -17,6 +17,10 @@
 /// @summary Define the number of images per hash-bucket for the image loader.
 #define IMAGE_LOADER_BUCKET_SIZE    128
 
+/// @summary Define the maximum number of level reads a single progressive DDS load may issue. 
+/// Requests spanning more frames are streamed as a single byte range instead.
+#define IMAGE_LOADER_MAX_LEVEL_READS 64
+
 /*///////////////////
 //   Local Types   //
 ///////////////////*/
@@ -25,6 +29,11 @@ enum image_file_format_e : int
 {
     IMAGE_FILE_FORMAT_UNKNOWN     = 0,         /// The source file format is not known.
     IMAGE_FILE_FORMAT_DDS         = 1,         /// The source file format follows the Microsoft DDS specification.
+    IMAGE_FILE_FORMAT_PNG         = 2,         /// The source file format follows the W3C PNG specification.
+    IMAGE_FILE_FORMAT_KTX         = 3,         /// The source file format follows the Khronos KTX or KTX2 specification.
+    IMAGE_FILE_FORMAT_JPEG        = 4,         /// The source file format follows the ITU T.81 JPEG specification.
+    IMAGE_FILE_FORMAT_TGA         = 5,         /// The source file format follows the Truevision TGA specification.
+    IMAGE_FILE_FORMAT_BMP         = 6,         /// The source file format is a Windows device-independent bitmap.
     /// ...
 };
 
@@ -38,9 +47,18 @@ enum image_load_error_e : int
     IMAGE_LOAD_ERROR_NO_MEMORY    = 4,         /// The image could not be loaded because there is not enough image memory.
     IMAGE_LOAD_ERROR_OSERROR      = 5,         /// The image could not be loaded. Check to OSError field.
     IMAGE_LOAD_ERROR_NO_PARSER    = 6,         /// THe image could not be loaded because there is no parser for the specified container format.
+    IMAGE_LOAD_ERROR_UNSUPPORTED  = 7,         /// The image could not be loaded because the file uses a feature the parser doesn't support.
     /// ...
 };
 
+/// @summary Define the supported methods of making pixel data resident in image memory.
+enum image_residency_e : int
+{
+    IMAGE_RESIDENCY_COPY          = 0,         /// Pixel data is streamed from the file and copied into committed image memory.
+    IMAGE_RESIDENCY_MAPPED        = 1,         /// Pixel data stored in its final layout is mapped read-only from the file. Other data is copied.
+    IMAGE_RESIDENCY_PROGRESSIVE   = 2,         /// Pixel data stored in its final layout is read one level at a time, lowest resolution first, so frames can be displayed before level 0 arrives. Other data is copied.
+};
+
 /// @summary Defines the data associated with a request to load image data from a file.
 /// For images where the frame data is spread across multiple files (like a PNG sequence), 
 /// one load request is generated for each file.
@@ -80,6 +98,71 @@ typedef mpsc_fifo_u_t   <image_load_error_t>       image_load_error_queue_t;
 
 /// @summary Typedefs for lists maintaining parse state for each supported container format.
 typedef image_parser_list_t<dds_parser_state_t>    dds_parser_list_t;
+typedef image_parser_list_t<png_parser_state_t>    png_parser_list_t;
+typedef image_parser_list_t<ktx_parser_state_t>    ktx_parser_list_t;
+typedef image_parser_list_t<jpeg_parser_state_t>   jpeg_parser_list_t;
+typedef image_parser_list_t<tga_parser_state_t>    tga_parser_list_t;
+typedef image_parser_list_t<bmp_parser_state_t>    bmp_parser_list_t;
+typedef image_parser_list_t<dds_level_reader_t>    dds_level_list_t;
+
+/// @summary Defines the state shared by the level readers started for a single progressive DDS load. 
+/// All of the readers are placed in the same partition, so the state is only accessed by one thread at a time.
+/// The structure is followed in the same allocation by one byte per reader. The I/O driver matches streams by 
+/// identifier, so each byte range is opened with the address of its reader's byte as a unique stream identifier; 
+/// the reader configuration keeps the image identifier.
+struct image_loader_level_group_t
+{
+    size_t                    Outstanding;     /// The number of level readers that have not yet finished.
+    bool                      Failed;          /// true if any level reader finished with an error.
+    int                       ErrorCode;       /// One of image_load_error_e for the first level reader that failed.
+    uint32_t                  OSError;         /// The system error code for the first level reader that failed, or ERROR_SUCCESS.
+};
+
+/// @summary Defines a parser that finished during a partition update. Completions are collected by each
+/// partition and resolved against the in-flight load table on the loader thread after the update.
+struct image_loader_completion_t
+{
+    uintptr_t                 ImageId;         /// The application-defined logical image identifier of the load.
+    char const               *FilePath;        /// The NULL-terminated UTF-8 virtual file path of the load.
+    size_t                    FirstFrame;      /// The zero-based index of the first frame requested.
+    size_t                    FinalFrame;      /// The zero-based index of the last frame requested, or IMAGE_ALL_FRAMES.
+    bool                      Succeeded;       /// true if the parser completed without error.
+};
+
+/// @summary Defines a load that has been started and has not yet completed. Requests for the same normalized 
+/// path and byte range that arrive while the load is in flight attach to it instead of starting another load.
+struct image_loader_flight_t
+{
+    uint32_t                  PathHash;        /// The hash of the normalized virtual file path.
+    image_load_t              Request;         /// The request that started the load.
+    size_t                    FollowerCount;   /// The number of attached requests for other images.
+    size_t                    FollowerCapacity;/// The capacity of the Followers list.
+    image_load_t             *Followers;       /// Attached requests for other images, completed by copying the loaded frames.
+    bool                      Prefaulted;      /// true once the requested frames have been offered to the background committer.
+};
+
+/// @summary Define the state owned by one partition of the active parsers. A partition is updated
+/// by exactly one thread at a time, so the parsers and FIFO node allocators it owns need no locks.
+struct image_loader_partition_t
+{
+    dds_parser_list_t         ActiveDDS;       /// The set of active parsers for DDS files.
+    png_parser_list_t         ActivePNG;       /// The set of active parsers for PNG files.
+    ktx_parser_list_t         ActiveKTX;       /// The set of active parsers for KTX and KTX2 files.
+    jpeg_parser_list_t        ActiveJPEG;      /// The set of active parsers for JPEG files.
+    tga_parser_list_t         ActiveTGA;       /// The set of active parsers for TGA files.
+    bmp_parser_list_t         ActiveBMP;       /// The set of active parsers for BMP files.
+    dds_level_list_t          ActiveLevels;    /// The set of active level readers for progressive DDS loads.
+    // ...
+
+    uint32_t                  NumaNode;        /// The NUMA node the updating thread was bound to during this update, or NUMA_NO_PREFERRED_NODE.
+    GROUP_AFFINITY            SavedAffinity;   /// The group affinity of the updating thread before it was first bound during this update. The Mask is 0 if not bound.
+    image_definition_alloc_t  DefinitionAlloc; /// The FIFO node allocator used by the partition's parsers to write to the definition queue.
+    image_location_alloc_t    PlacementAlloc;  /// The FIFO node allocator used by the partition's parsers to write to the location queue.
+    image_load_error_alloc_t  ErrorAlloc;      /// The FIFO node allocator used by the partition's parsers to write to the error queue.
+    size_t                    CompletionCount; /// The number of parsers that finished during the current update.
+    size_t                    CompletionCapacity; /// The capacity of the Completions list.
+    image_loader_completion_t*Completions;     /// The parsers that finished during the current update.
+};
 
 /// @summary Define the information used to configure image loading.
 struct image_loader_config_t
@@ -94,12 +177,30 @@ struct image_loader_config_t
     size_t                    ImageCapacity;   /// The number of images expected to be loaded through this instance.
     int                       Compression;     /// The compression type used to store pixel data in memory.
     int                       Encoding;        /// The encoding type used to store pixel data in memory.
+    int                       Residency;       /// One of image_residency_e specifying how pixel data is made resident.
+    uint32_t                  Format;          /// One of dxgi_format_e specifying the storage format, or DXGI_FORMAT_UNKNOWN to keep the source format.
+    int                       Quality;         /// One of image_encoder_quality_e, used when pixel data is converted to Format.
+    work_pool_t              *WorkPool;        /// The worker pool used to convert pixel data in parallel, or NULL. Not owned by the loader.
+    uint32_t                  EncoderFlags;    /// A combination of image_encoder_flags_e enabling optional encoder stages.
+    work_pool_t              *ParserPool;      /// The worker pool used to update parsers in parallel, or NULL to update them on the loader thread. May be WorkPool. Not owned by the loader.
+    size_t                    ParserCount;     /// The number of parser partitions, or zero for one per ParserPool thread plus one for the loader thread.
+    image_index_t const      *Index;           /// The block-offset index used to skip header reads for unchanged files, or NULL. Not owned by the loader.
+};
+
+/// @summary Define the load statistics reported by an image loader.
+struct image_loader_stats_t
+{
+    size_t                    LoadsStarted;    /// The number of loads that started a parser.
+    size_t                    LoadsInFlight;   /// The number of loads that have started a parser and not yet completed.
+    size_t                    DuplicateLoads;  /// The number of requests that attached to an identical in-flight load instead of starting their own.
+    size_t                    DuplicateCopies; /// The number of frames delivered to attached requests for other images by copying the loaded data.
 };
 
 /// @summary Define the data associated with the image loader. This is the 
 /// application-facing interface used to request that images be loaded. It
 /// receives load requests from a thread, and on each tick, updates the 
-/// current state of all active parsers.
+/// current state of all active parsers. The parsers are divided between 
+/// partitions, which are updated in parallel on the ParserPool threads.
 struct image_loader_t
 {
     image_load_queue_t        RequestQueue;    /// The MPSC unbounded FIFO for receiving image load requests.
@@ -109,6 +210,12 @@ struct image_loader_t
     image_load_error_queue_t *ErrorQueue;      /// The queue where error information for unsuccessful loads should be placed.
     int                       Compression;     /// The compression used to store pixel data in memory.
     int                       Encoding;        /// The encoding used to store pixel data in memory.
+    int                       Residency;       /// One of image_residency_e specifying how pixel data is made resident.
+    uint32_t                  Format;          /// One of dxgi_format_e specifying the storage format, or DXGI_FORMAT_UNKNOWN to keep the source format.
+    int                       Quality;         /// One of image_encoder_quality_e, used when pixel data is converted to Format.
+    work_pool_t              *WorkPool;        /// The worker pool used to convert pixel data in parallel, or NULL.
+    uint32_t                  EncoderFlags;    /// A combination of image_encoder_flags_e enabling optional encoder stages.
+    image_index_t const      *Index;           /// The block-offset index consulted before reading file headers, or NULL.
 
     SRWLOCK                   ImageLock;       /// Reader-Writer lock protecting the image list.
     size_t                    ImageCount;      /// The number of images loaded through this loader.
@@ -117,12 +224,22 @@ struct image_loader_t
     image_definition_t       *ImageMetadata;   /// The set of metadata for all images loaded via this loader.
 
     thread_io_t               io;              /// The system I/O interface for the loader thread.
-    dds_parser_list_t         ActiveDDS;       /// The set of active parsers for DDS files.
-    // ...
+    work_pool_t              *ParserPool;      /// The worker pool used to update the parser partitions, or NULL.
+    work_pool_batch_t         ParserBatch;     /// The batch used to dispatch partition updates to the ParserPool.
+    size_t                    PartitionCount;  /// The number of parser partitions.
+    image_loader_partition_t *Partitions;      /// The parser partitions. Every parser for a given image is placed in the same partition.
 
-    image_definition_alloc_t  DefinitionAlloc; /// The FIFO node allocator used to write to the definition queue.
-    image_location_alloc_t    PlacementAlloc;  /// The FIFO node allocator used to write to the location queue.
-    image_load_error_alloc_t  ErrorAlloc;      /// The FIFO node allocator used to write to the error queue.
+    size_t                    FlightCount;     /// The number of loads currently in flight.
+    size_t                    FlightCapacity;  /// The capacity of the Flights list.
+    image_loader_flight_t    *Flights;         /// The loads currently in flight. Only accessed from the loader thread.
+    std::atomic<size_t>       LoadsStarted;    /// The number of loads that started a parser.
+    std::atomic<size_t>       LoadsInFlight;   /// The number of loads in the Flights list.
+    std::atomic<size_t>       DuplicateLoads;  /// The number of requests attached to an in-flight load.
+    std::atomic<size_t>       DuplicateCopies; /// The number of frames copied to attached requests for other images.
+
+    image_definition_alloc_t  DefinitionAlloc; /// The FIFO node allocator used to write to the definition queue from the loader thread.
+    image_location_alloc_t    PlacementAlloc;  /// The FIFO node allocator used to write to the location queue from the loader thread.
+    image_load_error_alloc_t  ErrorAlloc;      /// The FIFO node allocator used to write to the error queue from the loader thread.
 };
 
 /// @summary Encapsulates all of the thread-local data required to access an image loader.
@@ -152,6 +269,148 @@ struct thread_image_loader_t
 /*///////////////////////
 //   Local Functions   //
 ///////////////////////*/
+/// @summary Selects the parser partition for an image. All loads of an image are placed in the same 
+/// partition, so its definition and placement notifications are posted in the order they were produced.
+/// @param loader The image loader.
+/// @param image_id The application-defined logical image identifier.
+/// @return The parser partition that owns all parsers for the image.
+internal_function inline image_loader_partition_t* image_loader_partition(image_loader_t *loader, uintptr_t image_id)
+{   // image identifiers are often sequential or aligned pointers; mix the bits before reducing.
+    uint64_t hash = (uint64_t(image_id) * 0x9E3779B97F4A7C15ULL) >> 32;
+    return &loader->Partitions[size_t(hash % loader->PartitionCount)];
+}
+
+/// @summary Normalize a single character for path comparisons.
+/// @param ch The character to normalize.
+/// @return If ch specifies an upper-case ASCII character, it is converted to lower case. If ch specifies a backslash, it is converted to a forward slash.
+internal_function inline char image_loader_path_normalize(char ch)
+{
+    return ((ch >= 'A' && ch <= 'Z') ? ((ch - 'A') + 'a') : ((ch == '\\') ? '/' : ch));
+}
+
+/// @summary Calculates the hash of a normalized path, so that paths differing only in case or separator hash equal.
+/// @param path A NULL-terminated UTF-8 path string.
+/// @return The 32-bit hash of the normalized path.
+internal_function uint32_t image_loader_path_hash(char const *path)
+{
+    uint32_t hash = 0;
+    while (*path)
+    {
+        hash = _lrotl(hash, 7) + uint8_t(image_loader_path_normalize(*path++));
+    }
+    return hash;
+}
+
+/// @summary Compares two path strings for equality, ignoring case and separator differences.
+/// @param a A NULL-terminated path string.
+/// @param b A NULL-terminated path string.
+/// @return true if paths a and b represent the same file.
+internal_function bool image_loader_path_match(char const *a, char const *b)
+{
+    if (a == b)
+    {   // easy out.
+        return true;
+    }
+    char ca, cb;
+    do
+    {
+        ca = image_loader_path_normalize(*a++);
+        cb = image_loader_path_normalize(*b++);
+    }
+    while  (ca == cb && ca != 0);
+    return (ca == cb);
+}
+
+/// @summary Searches the in-flight load table for a load of the same file and byte range as a request.
+/// The byte range read by a load is determined by its start position and frame range.
+/// @param loader The image loader that received the request.
+/// @param path_hash The normalized path hash of the request, from image_loader_path_hash().
+/// @param request The image load request.
+/// @return The in-flight load, or NULL if no identical load is in flight.
+internal_function image_loader_flight_t* image_loader_find_flight(image_loader_t *loader, uint32_t path_hash, image_load_t const &request)
+{
+    for (size_t i = 0, n = loader->FlightCount; i < n; ++i)
+    {
+        image_loader_flight_t &f = loader->Flights[i];
+        if (f.PathHash             == path_hash            && 
+            f.Request.FirstFrame   == request.FirstFrame   && 
+            f.Request.FinalFrame   == request.FinalFrame   && 
+            f.Request.FileOffset   == request.FileOffset   && 
+            f.Request.DecodeOffset == request.DecodeOffset && 
+            image_loader_path_match(f.Request.FilePath, request.FilePath))
+        {
+            return &f;
+        }
+    }
+    return NULL;
+}
+
+/// @summary Attaches a request to an identical in-flight load. A request for the same image needs nothing more, 
+/// since the load posts its notifications for that image. A request for another image is completed by copying 
+/// the loaded frames when the load finishes.
+/// @param loader The image loader that received the request.
+/// @param flight The in-flight load.
+/// @param request The image load request.
+/// @return true if the request was attached, or false if it must be loaded independently.
+internal_function bool image_loader_attach_flight(image_loader_t *loader, image_loader_flight_t *flight, image_load_t const &request)
+{
+    if (request.ImageId == flight->Request.ImageId)
+    {   // the request is satisfied by the in-flight load as-is.
+        loader->DuplicateLoads.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    for (size_t i = 0, n = flight->FollowerCount; i < n; ++i)
+    {
+        if (flight->Followers[i].ImageId == request.ImageId)
+        {   // the request is already attached.
+            loader->DuplicateLoads.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    if (flight->FollowerCount == flight->FollowerCapacity)
+    {   // grow the follower list capacity.
+        size_t        new_amount = calculate_capacity(flight->FollowerCapacity, flight->FollowerCapacity+1, 16, 4);
+        image_load_t *new_list   =(image_load_t*) realloc(flight->Followers, new_amount * sizeof(image_load_t));
+        if (new_list == NULL)
+        {   // the request can't be tracked; the caller starts a separate load for it.
+            return false;
+        }
+        flight->Followers        = new_list;
+        flight->FollowerCapacity = new_amount;
+    }
+    flight->Followers[flight->FollowerCount++] = request;
+    loader->DuplicateLoads.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/// @summary Adds a load to the in-flight load table after its parser has been started.
+/// @param loader The image loader that received the request.
+/// @param path_hash The normalized path hash of the request, from image_loader_path_hash().
+/// @param request The image load request.
+internal_function void image_loader_begin_flight(image_loader_t *loader, uint32_t path_hash, image_load_t const &request)
+{
+    if (loader->FlightCount == loader->FlightCapacity)
+    {   // grow the flight list capacity.
+        size_t                 new_amount = calculate_capacity(loader->FlightCapacity, loader->FlightCapacity+1, 256, 64);
+        image_loader_flight_t *new_list   =(image_loader_flight_t*) realloc(loader->Flights, new_amount * sizeof(image_loader_flight_t));
+        if (new_list == NULL)
+        {   // the load proceeds, but duplicates of it can't be suppressed.
+            return;
+        }
+        loader->Flights        = new_list;
+        loader->FlightCapacity = new_amount;
+    }
+    image_loader_flight_t &f = loader->Flights[loader->FlightCount++];
+    f.PathHash         = path_hash;
+    f.Request          = request;
+    f.FollowerCount    = 0;
+    f.FollowerCapacity = 0;
+    f.Followers        = NULL;
+    f.Prefaulted       = false;
+    loader->LoadsStarted.fetch_add(1, std::memory_order_relaxed);
+    loader->LoadsInFlight.fetch_add(1, std::memory_order_relaxed);
+}
+
 /// @summary Adds an image definition to the loader, growing the image list if necessary.
 /// @param loader The image loader that received the load request.
 /// @param load The image load request.
@@ -182,19 +441,162 @@ internal_function size_t image_loader_add_image(image_loader_t *loader, image_lo
     return image_index;
 }
 
-/// @summary Enqueue a DDS stream to be loaded into image memory.
+/// @summary Attempts to satisfy a load request from the compressed tier of the image memory, without any file I/O.
+/// The request is only satisfied if every requested frame is retained by the tier.
+/// @param loader The image loader that received the request.
+/// @param request The image load request.
+/// @return true if all requested frames were restored and placement notifications were posted.
+internal_function bool image_loader_restore_frames(image_loader_t *loader, image_load_t const &request)
+{
+    dds_level_desc_t     desc;
+    image_storage_info_t storage;
+    if (!image_memory_storage_info(loader->ImageMemory, request.ImageId, desc, storage))
+    {   // the image hasn't been defined yet, so nothing can have been evicted.
+        return false;
+    }
+    size_t first_frame = request.FirstFrame;
+    size_t final_frame = request.FinalFrame;
+    if (final_frame == IMAGE_ALL_FRAMES) final_frame = storage.ElementCount - 1;
+    if (first_frame > final_frame || final_frame >= storage.ElementCount)
+    {   // the frame range is not valid; let the parser report the error.
+        return false;
+    }
+    for (size_t i = first_frame; i <= final_frame; ++i)
+    {
+        if (!image_memory_element_restorable(loader->ImageMemory, request.ImageId, i))
+            return false;
+    }
+    for (size_t i = first_frame; i <= final_frame; ++i)
+    {   // if a restore fails, the request falls back to loading from the file.
+        if (image_memory_restore_element(loader->ImageMemory, request.ImageId, i, loader->PlacementQueue, &loader->PlacementAlloc) != ERROR_SUCCESS)
+            return false;
+    }
+    return true;
+}
+
+/// @summary Retrieves the headers at the start of a DDS file. If the loader has an index entry for the unchanged file, 
+/// the headers are taken from the index; otherwise, they are read synchronously.
+/// @param loader The image loader that received the request.
+/// @param path The virtual path used to open the file.
+/// @param file The file, opened with thread_io_t::open_file_mapping().
+/// @param dds On return, the base DDS header.
+/// @param dx10 On return, the extended DX10 header, if present.
+/// @param has_dx10 On return, set to true if the file has an extended DX10 header.
+/// @param entry On return, the index entry for the file, or NULL if the headers were read from the file.
+/// @return true if the headers were read and the file appears to be a valid DDS file.
+internal_function bool image_loader_read_dds_header(image_loader_t *loader, char const *path, vfs_file_t *file, dds_header_t *dds, dds_header_dxt10_t *dx10, bool &has_dx10, image_index_record_t const *&entry)
+{
+    size_t  nread = 0;
+    uint8_t header[sizeof(uint32_t) + sizeof(dds_header_t) + sizeof(dds_header_dxt10_t)];
+    if ((entry = image_index_find(loader->Index, path, file)) != NULL)
+    {   // the file is unchanged since the index was built, so skip the read.
+        if (image_index_dds_header(entry, dds, dx10, has_dx10))
+            return true;
+        entry = NULL;
+    }
+    if (loader->io.read_sync(file, file->BaseOffset, header, sizeof(header), nread) != ERROR_SUCCESS || !dds_header(header, nread, dds))
+    {   // the headers can't be read.
+        return false;
+    }
+    has_dx10 = dds_header_dxt10(header, nread, dx10);
+    return true;
+}
+
+/// @summary Attempts to satisfy a DDS load request by mapping the requested frames directly from the file, without streaming or copying the pixel data.
+/// This is only possible if the loader is configured for mapped residency and stores pixel data uncompressed, with raw encoding, in the source format with tightly packed rows, since the file data is then already in its final layout.
 /// @param loader The image loader that received the request.
 /// @param image_index The zero-based index of the image record in the loader's image list.
 /// @param request The image load request.
-/// @return true if the request was accepted and the load was started.
-internal_function bool image_loader_start_dds(image_loader_t *loader, size_t image_index, image_load_t const &request)
+/// @return true if all requested frames were mapped and placement notifications were posted.
+internal_function bool image_loader_map_dds(image_loader_t *loader, size_t image_index, image_load_t const &request)
 {
-    dds_parser_list_t *ddsp=&loader->ActiveDDS;
-    image_parser_list_ensure(ddsp, ddsp->Count + 1);
-    size_t parser_index    = ddsp->Count;
-    stream_decoder_t  *dds = NULL; // ...
-    uint32_t         flags = IMAGE_PARSER_FLAGS_READ_PIXELS | IMAGE_PARSER_FLAGS_START_AT_OFFSET;
+    if (loader->Residency   != IMAGE_RESIDENCY_MAPPED   || 
+        loader->Compression != IMAGE_COMPRESSION_NONE   || 
+        loader->Encoding    != IMAGE_ENCODING_RAW       || 
+        loader->Format      != DXGI_FORMAT_UNKNOWN      || 
+        loader->EncoderFlags!= IMAGE_ENCODER_FLAGS_NONE)
+    {   // the pixel data must be transformed, so it can't be mapped.
+        return false;
+    }
 
+    vfs_file_t                  file;
+    dds_header_t                dds;
+    dds_header_dxt10_t          dx10;
+    image_index_record_t const *entry    = NULL;
+    bool                        has_dx10 = false;
+    if (loader->io.open_file_mapping(request.FilePath, &file) != ERROR_SUCCESS)
+    {   // the mount point may not support mapping; fall back to streaming.
+        return false;
+    }
+    if (!image_loader_read_dds_header(loader, request.FilePath, &file, &dds, &dx10, has_dx10, entry))
+    {   // the headers can't be read; let the streaming parser report the error.
+        loader->io.close_file(&file);
+        return false;
+    }
+
+    // the pixel data immediately follows the headers, with the levels of each element tightly packed.
+    image_definition_t &meta         = loader->ImageMetadata[image_index];
+    size_t              data_offset  = sizeof(uint32_t) + sizeof(dds_header_t) + (has_dx10 ? sizeof(dds_header_dxt10_t) : 0);
+    size_t              element_size = 0;
+    if (meta.LevelInfo == NULL)
+    {   // this is the first load of the image; build the metadata from the headers.
+        if (!dds_image_definition(&meta, request.ImageId, &dds, has_dx10 ? &dx10 : NULL, loader->Compression, loader->Encoding))
+        {
+            loader->io.close_file(&file);
+            return false;
+        }
+        if (entry != NULL)
+        {   // publish the level offsets with the definition, so frames can be located without parsing.
+            image_index_block_offsets(loader->Index, entry, &meta);
+        }
+    }
+    for (size_t i = 0, n = meta.LevelCount; i < n; ++i)
+    {   // if image memory pads the rows, the file layout can't be used directly.
+        if (image_memory_row_pitch(loader->ImageMemory, meta.ImageFormat, meta.LevelInfo[i].Width) != meta.LevelInfo[i].BytesPerRow)
+        {
+            loader->io.close_file(&file);
+            return false;
+        }
+        element_size += meta.LevelInfo[i].DataSize;
+    }
+    size_t first_frame = request.FirstFrame;
+    size_t final_frame = request.FinalFrame == IMAGE_ALL_FRAMES ? meta.ElementCount - 1 : request.FinalFrame;
+    if (first_frame > final_frame || final_frame >= meta.ElementCount || 
+        file.FileSize < int64_t(data_offset + (final_frame + 1) * element_size))
+    {   // the frame range isn't valid or the file is truncated; let the streaming parser report the error.
+        loader->io.close_file(&file);
+        return false;
+    }
+
+    dds_level_desc_t     desc;
+    image_storage_info_t storage;
+    if (!image_memory_storage_info(loader->ImageMemory, request.ImageId, desc, storage))
+    {   // the image hasn't been defined yet; reserve the raw layout and publish the definition.
+        if (image_memory_reserve_image(loader->ImageMemory, &meta, dds_access_type(&meta), loader->DefinitionQueue, &loader->DefinitionAlloc) != ERROR_SUCCESS)
+        {
+            loader->io.close_file(&file);
+            return false;
+        }
+    }
+    for (size_t i = first_frame; i <= final_frame; ++i)
+    {   // views hold their own reference to the file, so it can be closed afterwards.
+        int64_t offset = file.BaseOffset + int64_t(data_offset + i * element_size);
+        if (image_memory_map_element(loader->ImageMemory, request.ImageId, i, file.Fildes, offset, loader->PlacementQueue, &loader->PlacementAlloc) != ERROR_SUCCESS)
+        {   // the remaining frames are loaded by the streaming parser, which replaces any mapped frames.
+            loader->io.close_file(&file);
+            return false;
+        }
+    }
+    loader->io.close_file(&file);
+    return true;
+}
+
+/// @summary Determines the parser flags for a load request.
+/// @param request The image load request.
+/// @return A combination of image_parser_flags_e.
+internal_function uint32_t image_loader_parser_flags(image_load_t const &request)
+{
+    uint32_t flags = IMAGE_PARSER_FLAGS_READ_PIXELS | IMAGE_PARSER_FLAGS_START_AT_OFFSET;
     if (request.Metadata.ImageFormat == DXGI_FORMAT_UNKNOWN)
     {   // image data is not known, so be sure to read the metadata.
         flags |= IMAGE_PARSER_FLAGS_READ_METADATA;
@@ -218,38 +620,197 @@ internal_function bool image_loader_start_dds(image_loader_t *loader, size_t ima
     {   // reading a defined range of frames.
         flags |= IMAGE_PARSER_FLAGS_FRAME_RANGE;
     }
+    return flags;
+}
+
+/// @summary Builds the parser configuration for a load request.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @param stream The stream decoder for the file.
+/// @param config On return, the parser configuration.
+internal_function void image_loader_parser_config(image_loader_t *loader, size_t image_index, image_load_t const &request, stream_decoder_t *stream, image_parser_config_t &config)
+{   // the parser posts notifications from whichever thread updates its partition.
+    image_loader_partition_t *part = image_loader_partition(loader, request.ImageId);
+    config.ImageId                  = request.ImageId;
+    config.FirstFrame               = request.FirstFrame;
+    config.FinalFrame               = request.FinalFrame;
+    config.Memory                   = loader->ImageMemory;
+    config.Decoder                  = stream;
+    config.Metadata                 =&loader->ImageMetadata[image_index];
+    config.DefinitionQueue          = loader->DefinitionQueue;
+    config.DefinitionAlloc          =&part->DefinitionAlloc;
+    config.PlacementQueue           = loader->PlacementQueue;
+    config.PlacementAlloc           =&part->PlacementAlloc;
+    config.ParseFlags               = image_loader_parser_flags(request);
+    config.Compression              = loader->Compression;
+    config.Encoding                 = loader->Encoding;
+    config.Format                   = loader->Format;
+    config.Quality                  = loader->Quality;
+    config.WorkPool                 = loader->WorkPool;
+    config.EncoderFlags             = loader->EncoderFlags;
+    config.StartOffset.DecodeOffset = request.DecodeOffset;
+    config.StartOffset.FileOffset   = request.FileOffset;
+}
+
+/// @summary Opens the stream for a load request and builds the configuration for its parser.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @param config On return, the parser configuration.
+/// @return The stream decoder for the file, or NULL if the file could not be opened.
+internal_function stream_decoder_t* image_loader_open_stream(image_loader_t *loader, size_t image_index, image_load_t const &request, image_parser_config_t &config)
+{
+    stream_decoder_t *stream = NULL;
 
     // stream the file data in from beginning to end.
-    // TODO(rlk): something more efficient if only reading a small portion?
-    // if reading metadata, must go from beginning to end.
-    // otherwise, only read the portion we're interested in.
-    // currently, we lack a mechanism to do this in the I/O layer.
-    if ((dds = loader->io.load_file(request.FilePath, request.FileHints, request.DecoderHint, request.ImageId, request.Priority, NULL)) == NULL)
+    // formats that can locate their frames without parsing 
+    // the whole file open a byte range instead; see image_loader_open_dds_range().
+    if ((stream = loader->io.load_file(request.FilePath, request.FileHints, request.DecoderHint, request.ImageId, request.Priority, NULL)) == NULL)
     {   // unable to load the file - not found?
-        return false;
+        return NULL;
     }
     if (request.FileOffset != 0)
     {   // seek the stream to the specified location.
         loader->io.seek_stream(request.ImageId, request.FileOffset);
     }
 
-    // configure the DDS file parser. parsing doesn't begin until the next update.
+    // configure the file parser. parsing doesn't begin until the next update.
+    image_loader_parser_config(loader, image_index, request, stream, config);
+    return stream;
+}
+
+/// @summary Computes the byte range of a DDS file containing the pixel data for the requested frames. 
+/// The levels of each element are tightly packed after the headers, so the range follows from the image layout.
+/// @param meta The image definition, with the DDSHeader and LevelInfo fields set.
+/// @param request The image load request.
+/// @param range_offset On return, the byte offset of the first level of the first requested frame.
+/// @param range_size On return, the number of bytes spanned by the requested frames.
+/// @return true if the frame range is valid for the image.
+internal_function bool image_loader_dds_range(image_definition_t const &meta, image_load_t const &request, int64_t &range_offset, int64_t &range_size)
+{
+    bool   has_dx10     =(meta.DDSHeader.Format.Flags & DDPF_FOURCC) != 0 && meta.DDSHeader.Format.FourCC == image_fourcc_le('D','X','1','0');
+    size_t data_offset  = sizeof(uint32_t) + sizeof(dds_header_t) + (has_dx10 ? sizeof(dds_header_dxt10_t) : 0);
+    size_t element_size = 0;
+    size_t first_frame  = request.FirstFrame;
+    size_t final_frame  = request.FinalFrame;
+    for (size_t i = 0, n = meta.LevelCount; i < n; ++i)
+    {
+        element_size += meta.LevelInfo[i].DataSize;
+    }
+    if (final_frame >= meta.ElementCount) final_frame = meta.ElementCount - 1;
+    if (meta.ElementCount == 0 || first_frame > final_frame || element_size == 0)
+    {   // the frame range is not valid; let the parser report the error.
+        return false;
+    }
+    range_offset = int64_t(data_offset + first_frame * element_size);
+    range_size   = int64_t((final_frame - first_frame + 1) * element_size);
+    return true;
+}
+
+/// @summary Builds the metadata for a DDS image from the file headers, if it isn't known yet. 
+/// The headers are taken from the loader's index or read synchronously.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the DDSHeader and LevelInfo fields of the image metadata are set.
+internal_function bool image_loader_dds_metadata(image_loader_t *loader, size_t image_index, image_load_t const &request)
+{
+    image_definition_t         &meta     = loader->ImageMetadata[image_index];
+    vfs_file_t                  file;
+    dds_header_t                dds;
+    dds_header_dxt10_t          dx10;
+    image_index_record_t const *entry    = NULL;
+    bool                        has_dx10 = false;
+    if (meta.LevelInfo != NULL)
+    {   // the image has been loaded before.
+        return true;
+    }
+    if (loader->io.open_file_mapping(request.FilePath, &file) != ERROR_SUCCESS)
+    {   // unable to open the file - not found?
+        return false;
+    }
+    if (!image_loader_read_dds_header(loader, request.FilePath, &file, &dds, &dx10, has_dx10, entry))
+    {   // the headers can't be read.
+        loader->io.close_file(&file);
+        return false;
+    }
+    loader->io.close_file(&file);
+    if (!dds_image_definition(&meta, request.ImageId, &dds, has_dx10 ? &dx10 : NULL, loader->Compression, loader->Encoding))
+    {   // unable to allocate the mip-level descriptors and offsets.
+        return false;
+    }
+    if (entry != NULL)
+    {   // publish the level offsets with the definition, so frames can be located without parsing.
+        image_index_block_offsets(loader->Index, entry, &meta);
+    }
+    return true;
+}
+
+/// @summary Opens a stream covering only the requested frames of a DDS file and builds the configuration for its parser.
+/// If the image layout isn't known yet, the headers are taken from the loader's index or read synchronously first, so a request for one element of a large array reads only that element.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @param config On return, the parser configuration.
+/// @return The stream decoder for the byte range, or NULL if the range could not be determined or opened.
+internal_function stream_decoder_t* image_loader_open_dds_range(image_loader_t *loader, size_t image_index, image_load_t const &request, image_parser_config_t &config)
+{
+    image_definition_t &meta = loader->ImageMetadata[image_index];
+    stream_decoder_t *stream = NULL;
+    int64_t     range_offset = 0;
+    int64_t     range_size   = 0;
+    int64_t     read_offset  = 0;
+
+    if (request.FileOffset != 0 || request.DecodeOffset != 0)
+    {   // the caller supplied an explicit start position.
+        return NULL;
+    }
+    if (request.FirstFrame == 0 && request.FinalFrame == IMAGE_ALL_FRAMES)
+    {   // the entire file is needed anyway.
+        return NULL;
+    }
+    if (!image_loader_dds_metadata(loader, image_index, request))
+    {   // let the streaming parser read the headers and report any error.
+        return NULL;
+    }
+    if (!image_loader_dds_range(meta, request, range_offset, range_size))
+    {   // let the streaming parser report the error.
+        return NULL;
+    }
+    if ((stream = loader->io.load_file_range(request.FilePath, request.FileHints, request.DecoderHint, request.ImageId, request.Priority, range_offset, range_size, read_offset, NULL)) == NULL)
+    {   // unable to load the file - not found?
+        return NULL;
+    }
+
+    // the stream starts at a sector boundary at or before the first requested frame.
+    // the headers aren't streamed, so the parser uses the metadata set above.
+    image_loader_parser_config(loader, image_index, request, stream, config);
+    config.ParseFlags              |= IMAGE_PARSER_FLAGS_METADATA_SET;
+    config.StartOffset.FileOffset   = read_offset;
+    config.StartOffset.DecodeOffset = size_t(range_offset - read_offset);
+    return stream;
+}
+
+/// @summary Enqueue a DDS stream to be loaded into image memory.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the request was accepted and the load was started.
+internal_function bool image_loader_start_dds(image_loader_t *loader, size_t image_index, image_load_t const &request)
+{
+    image_loader_partition_t *part = image_loader_partition(loader, request.ImageId);
+    dds_parser_list_t    *ddsp=&part->ActiveDDS;
+    image_parser_list_ensure(ddsp, ddsp->Count + 1);
+    size_t                parser_index = ddsp->Count;
+    stream_decoder_t     *dds = NULL;
     image_parser_config_t parse_config;
-    parse_config.ImageId                  = request.ImageId;
-    parse_config.FirstFrame               = request.FirstFrame;
-    parse_config.FinalFrame               = request.FinalFrame;
-    parse_config.Memory                   = loader->ImageMemory;
-    parse_config.Decoder                  = dds;
-    parse_config.Metadata                 =&loader->ImageMetadata[image_index];
-    parse_config.DefinitionQueue          = loader->DefinitionQueue;
-    parse_config.DefinitionAlloc          =&loader->DefinitionAlloc;
-    parse_config.PlacementQueue           = loader->PlacementQueue;
-    parse_config.PlacementAlloc           =&loader->PlacementAlloc;
-    parse_config.ParseFlags               = flags;
-    parse_config.Compression              = loader->Compression;
-    parse_config.Encoding                 = loader->Encoding;
-    parse_config.StartOffset.DecodeOffset = request.DecodeOffset;
-    parse_config.StartOffset.FileOffset   = request.FileOffset;
+
+    if ((dds = image_loader_open_dds_range(loader, image_index, request, parse_config)) == NULL && 
+        (dds = image_loader_open_stream   (loader, image_index, request, parse_config)) == NULL)
+    {   // unable to load the file - not found?
+        return false;
+    }
     dds_parser_state_init(&ddsp->ParseState[parser_index], parse_config);
 
     // mark the parser as 'live':
@@ -259,89 +820,770 @@ internal_function bool image_loader_start_dds(image_loader_t *loader, size_t ima
     return true;
 }
 
-/// @summary Update the state of all active DDS parsers.
-/// @param loader The image loader managing the active DDS parser list.
-internal_function void image_loader_update_dds(image_loader_t *loader)
-{   dds_parser_list_t *ddsp=&loader->ActiveDDS;
-    size_t index = 0;
-    while (index < ddsp->Count)
+/// @summary Attempts to start a progressive load of a DDS request. Each mipmap level of each requested frame is read 
+/// as a separate byte range directly into its final location, and the reads are issued lowest resolution first. Level 
+/// offsets are taken from the BlockOffsets of the image definition where known, and otherwise follow from the layout. 
+/// A placement notification is posted each time a frame becomes displayable at a higher resolution. This is only possible 
+/// if the loader is configured for progressive residency and stores pixel data uncompressed, with raw encoding, in the 
+/// source format with tightly packed rows, since the file data is then already in its final layout.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the level readers were started.
+internal_function bool image_loader_start_dds_levels(image_loader_t *loader, size_t image_index, image_load_t const &request)
+{
+    if (loader->Residency   != IMAGE_RESIDENCY_PROGRESSIVE || 
+        loader->Compression != IMAGE_COMPRESSION_NONE      || 
+        loader->Encoding    != IMAGE_ENCODING_RAW          || 
+        loader->Format      != DXGI_FORMAT_UNKNOWN         || 
+        loader->EncoderFlags!= IMAGE_ENCODER_FLAGS_NONE)
+    {   // the pixel data must be transformed, so levels can't be placed as they arrive.
+        return false;
+    }
+    if (!image_loader_dds_metadata(loader, image_index, request))
+    {   // let the streaming parser read the headers and report any error.
+        return false;
+    }
+
+    image_definition_t &meta         = loader->ImageMetadata[image_index];
+    size_t              element_size = 0;
+    int64_t             range_offset = 0;
+    int64_t             range_size   = 0;
+    if (meta.LevelCount < 2 || meta.LevelCount > 32)
+    {   // there's no coarser level to show first, or too many to track.
+        return false;
+    }
+    for (size_t i = 0, n = meta.LevelCount; i < n; ++i)
+    {   // if image memory pads the rows, the file layout can't be used directly.
+        if (image_memory_row_pitch(loader->ImageMemory, meta.ImageFormat, meta.LevelInfo[i].Width) != meta.LevelInfo[i].BytesPerRow)
+            return false;
+        element_size += meta.LevelInfo[i].DataSize;
+    }
+    if (!image_loader_dds_range(meta, request, range_offset, range_size))
+    {   // the frame range isn't valid; let the streaming parser report the error.
+        return false;
+    }
+    size_t first_frame = request.FirstFrame;
+    size_t frame_count = size_t(range_size) / element_size;
+    size_t read_count  = frame_count * meta.LevelCount;
+    if (read_count > IMAGE_LOADER_MAX_LEVEL_READS)
+    {   // too many reads; stream the frames as a single range instead.
+        return false;
+    }
+
+    dds_level_desc_t     desc;
+    image_storage_info_t storage;
+    if (!image_memory_storage_info(loader->ImageMemory, request.ImageId, desc, storage))
+    {   // the image hasn't been defined yet; reserve the raw layout and publish the definition.
+        if (image_memory_reserve_image(loader->ImageMemory, &meta, dds_access_type(&meta), loader->DefinitionQueue, &loader->DefinitionAlloc) != ERROR_SUCCESS)
+            return false;
+    }
+    for (size_t i = first_frame, e = first_frame + frame_count; i < e; ++i)
+    {   // lay out and commit each frame, so levels can be written as they arrive.
+        if (image_memory_begin_levels(loader->ImageMemory, request.ImageId, i) == NULL)
+            return false;
+    }
+
+    image_loader_partition_t   *part  = image_loader_partition(loader, request.ImageId);
+    dds_level_list_t           *lvlp  =&part->ActiveLevels;
+    image_loader_level_group_t *group = NULL;
+    image_parser_list_ensure(lvlp, lvlp->Count + read_count);
+    if (lvlp->Capacity < lvlp->Count + read_count)
+    {   // unable to grow the reader list.
+        return false;
+    }
+    if ((group = (image_loader_level_group_t*) malloc(sizeof(image_loader_level_group_t) + read_count)) == NULL)
+    {   // unable to allocate the shared reader state.
+        return false;
+    }
+    group->Outstanding = read_count;
+    group->Failed      = false;
+    group->ErrorCode   = IMAGE_LOAD_ERROR_SUCCESS;
+    group->OSError     = ERROR_SUCCESS;
+
+    // open every range before any reader is made live, so the request can still fall back to streaming.
+    size_t reader_index = lvlp->Count;
+    for (size_t level = meta.LevelCount; level-- > 0; )
     {
-        int res  = dds_parser_update(&ddsp->ParseState[index]);
-        if (res == DDS_PARSE_RESULT_CONTINUE)
-        {   // not finished parsing this stream yet.
-            index++; continue;
+        size_t level_base = 0;
+        for (size_t i = 0; i < level; ++i)
+        {
+            level_base += meta.LevelInfo[i].DataSize;
         }
-        if (res == DDS_PARSE_RESULT_ERROR && loader->ErrorQueue != NULL)
-        {   // post the error to the error queue.
-            fifo_node_t<image_load_error_t> *n = fifo_allocator_get(&loader->ErrorAlloc);
-            n->Item.ImageId            = ddsp->SourceStream[index]->Identifier;
-            n->Item.FilePath           = ddsp->SourceFile  [index];
-            n->Item.FirstFrame         = ddsp->ParseState  [index].Config.FirstFrame;
-            n->Item.FinalFrame         = ddsp->ParseState  [index].Config.FinalFrame;
-            n->Item.DstCompression     = loader->Compression;
-            n->Item.DstEncoding        = loader->Encoding;
-            if (ddsp->ParseState[index].Encoder != NULL)
-            {   // pick up the source data attributes from the encoder.
-                n->Item.SrcCompression = ddsp->ParseState[index].Encoder->TargetCompression;
-                n->Item.SrcEncoding    = ddsp->ParseState[index].Encoder->TargetEncoding;
+        for (size_t frame = first_frame, e = first_frame + frame_count; frame < e; ++frame)
+        {
+            image_parser_config_t   config;
+            stream_decoder_t       *stream      = NULL;
+            uintptr_t               stream_id   =(uintptr_t)((uint8_t*)(group + 1) + (reader_index - lvlp->Count));
+            int64_t                 read_offset = 0;
+            int64_t                 level_offset= 0;
+            if (meta.BlockOffsets  != NULL)
+            {   // offsets recorded by a parser or the index are absolute; the headers precede every level.
+                stream_decode_pos_t const &pos = meta.BlockOffsets[(frame * meta.LevelCount) + level];
+                level_offset = pos.FileOffset + int64_t(pos.DecodeOffset);
             }
-            else
-            {   // if there's no encoder, we don't know what the compression was.
-                n->Item.SrcCompression = IMAGE_COMPRESSION_NONE;
-                n->Item.SrcEncoding    = IMAGE_ENCODING_RAW;
+            if (level_offset == 0)
+            {   // the level hasn't been located by a parser or the index; it follows from the layout.
+                level_offset = range_offset + int64_t((frame - first_frame) * element_size + level_base);
             }
-            // determine the appropriate high-level error code.
-            switch (ddsp->ParseState[index].ParserError)
-            {
-            case DDS_PARSE_ERROR_DECODER:
-                n->Item.ErrorCode      = IMAGE_LOAD_ERROR_BAD_DATA;
-                n->Item.OSError        = GetLastError();
-                break;
-            case DDS_PARSE_ERROR_NOMEMORY:
-                n->Item.ErrorCode      = IMAGE_LOAD_ERROR_NO_MEMORY;
-                n->Item.OSError        = GetLastError();
-                break;
-            case DDS_PARSE_ERROR_NOENCODER:
-                n->Item.ErrorCode      = IMAGE_LOAD_ERROR_NO_ENCODER;
-                n->Item.OSError        = ERROR_SUCCESS;
-                break;
-            case DDS_PARSE_ERROR_ENCODER:
-                n->Item.ErrorCode      = IMAGE_LOAD_ERROR_BAD_DATA;
-                n->Item.OSError        = ERROR_SUCCESS;
-                break;
-            default:
-                n->Item.ErrorCode      = IMAGE_LOAD_ERROR_OSERROR;
-                n->Item.OSError        = GetLastError();
-                break;
+            if ((stream = loader->io.load_file_range(request.FilePath, request.FileHints, request.DecoderHint, stream_id, request.Priority, level_offset, int64_t(meta.LevelInfo[level].DataSize), read_offset, NULL)) == NULL)
+            {   // release the ranges opened so far.
+                for (size_t i = lvlp->Count; i < reader_index; ++i)
+                {
+                    lvlp->SourceStream[i]->release();
+                }
+                free(group);
+                return false;
             }
-            // post the result to the target queue.
-            mpsc_fifo_u_produce(loader->ErrorQueue, n);
+            image_loader_parser_config(loader, image_index, request, stream, config);
+            config.ParseFlags |= IMAGE_PARSER_FLAGS_METADATA_SET;
+            config.Context     =(uintptr_t) group;
+            dds_level_reader_init(&lvlp->ParseState[reader_index], config, frame, level, size_t(level_offset - read_offset), meta.LevelInfo[level].DataSize);
+            lvlp->SourceStream[reader_index] = stream;
+            lvlp->SourceFile  [reader_index] = request.FilePath;
+            reader_index++;
         }
-        // perform any parser state cleanup (delete the encoder, etc.)
-        dds_parser_state_cleanup(&ddsp->ParseState[index]);
-        // release the reference to the stream decoder.
-        ddsp->SourceStream[index]->release();
-        // remove the parser from the active list by swapping.
-        size_t last_index = ddsp->Count - 1;
-        ddsp->SourceStream[index] = ddsp->SourceStream[last_index];
-        ddsp->SourceFile  [index] = ddsp->SourceFile  [last_index];
-        ddsp->ParseState  [index] = ddsp->ParseState  [last_index];
-        ddsp->Count--;
     }
+
+    // mark the readers as 'live':
+    lvlp->Count = reader_index;
+    return true;
 }
 
-/*////////////////////////
-//   Public Functions   //
-////////////////////////*/
-/// @summary Examines the file extension portion of a path string to determine the correct image_file_format_e.
-/// @param path A NULL-terminated UTF-8 string specifying a filename.
-/// @return One of image_file_format_e.
-public_function int image_file_format_from_extension(char const *path)
+/// @summary Enqueue a PNG stream to be loaded into image memory.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the request was accepted and the load was started.
+internal_function bool image_loader_start_png(image_loader_t *loader, size_t image_index, image_load_t const &request)
 {
-    size_t      len = strlen(path);
-    char const *ext = path + len - 1;
-    while (ext >= path)
-    {
+    image_loader_partition_t *part = image_loader_partition(loader, request.ImageId);
+    png_parser_list_t    *pngp=&part->ActivePNG;
+    image_parser_list_ensure(pngp, pngp->Count + 1);
+    size_t                parser_index = pngp->Count;
+    stream_decoder_t     *png = NULL;
+    image_parser_config_t parse_config;
+
+    if ((png = image_loader_open_stream(loader, image_index, request, parse_config)) == NULL)
+    {   // unable to load the file - not found?
+        return false;
+    }
+    png_parser_state_init(&pngp->ParseState[parser_index], parse_config);
+
+    // mark the parser as 'live':
+    pngp->SourceStream[parser_index] = png;
+    pngp->SourceFile  [parser_index] = request.FilePath;
+    pngp->Count++;
+    return true;
+}
+
+/// @summary Enqueue a KTX or KTX2 stream to be loaded into image memory.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the request was accepted and the load was started.
+internal_function bool image_loader_start_ktx(image_loader_t *loader, size_t image_index, image_load_t const &request)
+{
+    image_loader_partition_t *part = image_loader_partition(loader, request.ImageId);
+    ktx_parser_list_t    *ktxp=&part->ActiveKTX;
+    image_parser_list_ensure(ktxp, ktxp->Count + 1);
+    size_t                parser_index = ktxp->Count;
+    stream_decoder_t     *ktx = NULL;
+    image_parser_config_t parse_config;
+
+    if ((ktx = image_loader_open_stream(loader, image_index, request, parse_config)) == NULL)
+    {   // unable to load the file - not found?
+        return false;
+    }
+    ktx_parser_state_init(&ktxp->ParseState[parser_index], parse_config);
+
+    // mark the parser as 'live':
+    ktxp->SourceStream[parser_index] = ktx;
+    ktxp->SourceFile  [parser_index] = request.FilePath;
+    ktxp->Count++;
+    return true;
+}
+
+/// @summary Enqueue a JPEG stream to be loaded into image memory.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the request was accepted and the load was started.
+internal_function bool image_loader_start_jpeg(image_loader_t *loader, size_t image_index, image_load_t const &request)
+{
+    image_loader_partition_t *part = image_loader_partition(loader, request.ImageId);
+    jpeg_parser_list_t   *jpgp=&part->ActiveJPEG;
+    image_parser_list_ensure(jpgp, jpgp->Count + 1);
+    size_t                parser_index = jpgp->Count;
+    stream_decoder_t     *jpg = NULL;
+    image_parser_config_t parse_config;
+
+    if ((jpg = image_loader_open_stream(loader, image_index, request, parse_config)) == NULL)
+    {   // unable to load the file - not found?
+        return false;
+    }
+    jpeg_parser_state_init(&jpgp->ParseState[parser_index], parse_config);
+
+    // mark the parser as 'live':
+    jpgp->SourceStream[parser_index] = jpg;
+    jpgp->SourceFile  [parser_index] = request.FilePath;
+    jpgp->Count++;
+    return true;
+}
+
+/// @summary Enqueue a TGA stream to be loaded into image memory.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the request was accepted and the load was started.
+internal_function bool image_loader_start_tga(image_loader_t *loader, size_t image_index, image_load_t const &request)
+{
+    image_loader_partition_t *part = image_loader_partition(loader, request.ImageId);
+    tga_parser_list_t    *tgap=&part->ActiveTGA;
+    image_parser_list_ensure(tgap, tgap->Count + 1);
+    size_t                parser_index = tgap->Count;
+    stream_decoder_t     *tga = NULL;
+    image_parser_config_t parse_config;
+
+    if ((tga = image_loader_open_stream(loader, image_index, request, parse_config)) == NULL)
+    {   // unable to load the file - not found?
+        return false;
+    }
+    tga_parser_state_init(&tgap->ParseState[parser_index], parse_config);
+
+    // mark the parser as 'live':
+    tgap->SourceStream[parser_index] = tga;
+    tgap->SourceFile  [parser_index] = request.FilePath;
+    tgap->Count++;
+    return true;
+}
+
+/// @summary Enqueue a BMP stream to be loaded into image memory.
+/// @param loader The image loader that received the request.
+/// @param image_index The zero-based index of the image record in the loader's image list.
+/// @param request The image load request.
+/// @return true if the request was accepted and the load was started.
+internal_function bool image_loader_start_bmp(image_loader_t *loader, size_t image_index, image_load_t const &request)
+{
+    image_loader_partition_t *part = image_loader_partition(loader, request.ImageId);
+    bmp_parser_list_t    *bmpp=&part->ActiveBMP;
+    image_parser_list_ensure(bmpp, bmpp->Count + 1);
+    size_t                parser_index = bmpp->Count;
+    stream_decoder_t     *bmp = NULL;
+    image_parser_config_t parse_config;
+
+    if ((bmp = image_loader_open_stream(loader, image_index, request, parse_config)) == NULL)
+    {   // unable to load the file - not found?
+        return false;
+    }
+    bmp_parser_state_init(&bmpp->ParseState[parser_index], parse_config);
+
+    // mark the parser as 'live':
+    bmpp->SourceStream[parser_index] = bmp;
+    bmpp->SourceFile  [parser_index] = request.FilePath;
+    bmpp->Count++;
+    return true;
+}
+
+/// @summary Moves the thread updating a parser partition onto the NUMA node from which an image's memory 
+/// is committed, so that the pixel data is written from a processor local to the memory. The thread is only 
+/// rebound when the node changes, since changing the affinity requires a system call. The affinity the thread 
+/// had before the first bind is saved, and restored by image_loader_restore_affinity() when the update returns.
+/// @param loader The image loader whose parser is being updated.
+/// @param part The parser partition being updated on the calling thread.
+/// @param image_id The application-defined identifier of the image about to be written.
+internal_function void image_loader_bind_to_image_node(image_loader_t *loader, image_loader_partition_t *part, uintptr_t image_id)
+{
+    uint32_t node = image_memory_image_node(loader->ImageMemory, image_id);
+    if (node != NUMA_NO_PREFERRED_NODE && node != part->NumaNode)
+    {   // only remember the node if the affinity mask was actually changed.
+        GROUP_AFFINITY old_affinity;
+        if (win32_numa_bind_thread(GetCurrentThread(), node, &old_affinity))
+        {
+            if (part->SavedAffinity.Mask == 0) part->SavedAffinity = old_affinity;
+            part->NumaNode = node;
+        }
+    }
+}
+
+/// @summary Restores the affinity the calling thread had before it was bound to a NUMA node during a 
+/// partition update. Pool threads run other work between loader updates, and must not stay bound to a node.
+/// @param part The parser partition that was updated on the calling thread.
+internal_function void image_loader_restore_affinity(image_loader_partition_t *part)
+{
+    if (part->SavedAffinity.Mask != 0)
+    {   // the thread was bound to a node during this update.
+        win32_restore_thread_affinity(GetCurrentThread(), part->SavedAffinity);
+        ZeroMemory(&part->SavedAffinity, sizeof(GROUP_AFFINITY));
+    }
+    part->NumaNode = NUMA_NO_PREFERRED_NODE;
+}
+
+/// @summary Posts an error for a failed parser to the loader's error queue, if it has one.
+/// @param loader The image loader managing the parser.
+/// @param part The parser partition that owns the parser.
+/// @param path The NULL-terminated UTF-8 virtual file path of the source file.
+/// @param config The parser configuration. The error is reported for config.ImageId, which may differ from the stream identifier.
+/// @param encoder The parser's image encoder, or NULL if it wasn't created.
+/// @param error_code One of image_load_error_e.
+/// @param os_error The system error code, or ERROR_SUCCESS.
+internal_function void image_loader_post_error(image_loader_t *loader, image_loader_partition_t *part, char const *path, image_parser_config_t const &config, image_encoder_t const *encoder, int error_code, uint32_t os_error)
+{
+    if (loader->ErrorQueue == NULL)
+    {   // the application doesn't want error notifications.
+        return;
+    }
+    fifo_node_t<image_load_error_t> *n = fifo_allocator_get(&part->ErrorAlloc);
+    n->Item.ImageId            = config.ImageId;
+    n->Item.FilePath           = path;
+    n->Item.FirstFrame         = config.FirstFrame;
+    n->Item.FinalFrame         = config.FinalFrame;
+    n->Item.DstCompression     = loader->Compression;
+    n->Item.DstEncoding        = loader->Encoding;
+    if (encoder != NULL)
+    {   // pick up the source data attributes from the encoder.
+        n->Item.SrcCompression = encoder->TargetCompression;
+        n->Item.SrcEncoding    = encoder->TargetEncoding;
+    }
+    else
+    {   // if there's no encoder, we don't know what the compression was.
+        n->Item.SrcCompression = IMAGE_COMPRESSION_NONE;
+        n->Item.SrcEncoding    = IMAGE_ENCODING_RAW;
+    }
+    n->Item.ErrorCode          = error_code;
+    n->Item.OSError            = os_error;
+    // post the result to the target queue.
+    mpsc_fifo_u_produce(loader->ErrorQueue, n);
+}
+
+/// @summary Records that a parser has finished, so that any requests attached to its load can be completed after the update.
+/// @param part The parser partition that owns the parser.
+/// @param path The NULL-terminated UTF-8 virtual file path of the source file.
+/// @param config The parser configuration. The completion is recorded for config.ImageId, which may differ from the stream identifier.
+/// @param succeeded true if the parser completed without error.
+internal_function void image_loader_record_completion(image_loader_partition_t *part, char const *path, image_parser_config_t const &config, bool succeeded)
+{   // the list was sized for every active parser before the update started; see image_loader_update().
+    assert(part->CompletionCount < part->CompletionCapacity);
+    image_loader_completion_t &c = part->Completions[part->CompletionCount++];
+    c.ImageId    = config.ImageId;
+    c.FilePath   = path;
+    c.FirstFrame = config.FirstFrame;
+    c.FinalFrame = config.FinalFrame;
+    c.Succeeded  = succeeded;
+}
+
+/// @summary Update the state of all active DDS parsers in a partition.
+/// @param loader The image loader managing the parser partition.
+/// @param part The parser partition owning the active DDS parser list.
+internal_function void image_loader_update_dds(image_loader_t *loader, image_loader_partition_t *part)
+{   dds_parser_list_t *ddsp=&part->ActiveDDS;
+    size_t index = 0;
+    while (index < ddsp->Count)
+    {
+        image_loader_bind_to_image_node(loader, part, ddsp->ParseState[index].Config.ImageId);
+        int res  = dds_parser_update(&ddsp->ParseState[index]);
+        if (res == DDS_PARSE_RESULT_CONTINUE)
+        {   // not finished parsing this stream yet.
+            index++; continue;
+        }
+        if (res == DDS_PARSE_RESULT_ERROR)
+        {   // determine the appropriate high-level error code.
+            dds_parser_state_t &state = ddsp->ParseState[index];
+            switch (state.ParserError)
+            {
+            case DDS_PARSE_ERROR_DECODER:
+                image_loader_post_error(loader, part, ddsp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, GetLastError());
+                break;
+            case DDS_PARSE_ERROR_NOMEMORY:
+                image_loader_post_error(loader, part, ddsp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_MEMORY, GetLastError());
+                break;
+            case DDS_PARSE_ERROR_NOENCODER:
+                image_loader_post_error(loader, part, ddsp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_ENCODER, ERROR_SUCCESS);
+                break;
+            case DDS_PARSE_ERROR_ENCODER:
+                image_loader_post_error(loader, part, ddsp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, ERROR_SUCCESS);
+                break;
+            default:
+                image_loader_post_error(loader, part, ddsp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_OSERROR, GetLastError());
+                break;
+            }
+        }
+        // let any requests attached to this load complete once the update has finished.
+        image_loader_record_completion(part, ddsp->SourceFile[index], ddsp->ParseState[index].Config, res != DDS_PARSE_RESULT_ERROR);
+        // perform any parser state cleanup (delete the encoder, etc.)
+        dds_parser_state_cleanup(&ddsp->ParseState[index]);
+        // release the reference to the stream decoder.
+        ddsp->SourceStream[index]->release();
+        // remove the parser from the active list by swapping.
+        size_t last_index = ddsp->Count - 1;
+        ddsp->SourceStream[index] = ddsp->SourceStream[last_index];
+        ddsp->SourceFile  [index] = ddsp->SourceFile  [last_index];
+        ddsp->ParseState  [index] = ddsp->ParseState  [last_index];
+        ddsp->Count--;
+    }
+}
+
+/// @summary Update the state of all active DDS level readers in a partition. When the last reader of a progressive 
+/// load finishes, the load is recorded as complete, or the error of the first reader to fail is reported. The error 
+/// is held until then so that it follows every placement posted by the load, and the image cache can retire the 
+/// partially resident frames without a later placement marking them as loading again.
+/// @param loader The image loader managing the parser partition.
+/// @param part The parser partition owning the active level reader list.
+internal_function void image_loader_update_dds_levels(image_loader_t *loader, image_loader_partition_t *part)
+{   dds_level_list_t *lvlp=&part->ActiveLevels;
+    size_t index = 0;
+    while (index < lvlp->Count)
+    {
+        image_loader_bind_to_image_node(loader, part, lvlp->ParseState[index].Config.ImageId);
+        int res  = dds_level_reader_update(&lvlp->ParseState[index]);
+        if (res == DDS_PARSE_RESULT_CONTINUE)
+        {   // not finished reading this level yet.
+            index++; continue;
+        }
+        dds_level_reader_t         &state = lvlp->ParseState[index];
+        image_loader_level_group_t *group =(image_loader_level_group_t*) state.Config.Context;
+        if (res == DDS_PARSE_RESULT_ERROR && !group->Failed)
+        {   // keep only the first failure; the other levels of the load still finish, but the frame is never completed.
+            switch (state.ReaderError)
+            {
+            case DDS_PARSE_ERROR_DECODER:
+                group->ErrorCode = IMAGE_LOAD_ERROR_BAD_DATA;
+                break;
+            case DDS_PARSE_ERROR_NOMEMORY:
+                group->ErrorCode = IMAGE_LOAD_ERROR_NO_MEMORY;
+                break;
+            default:
+                group->ErrorCode = IMAGE_LOAD_ERROR_OSERROR;
+                break;
+            }
+            group->OSError = GetLastError();
+            group->Failed  = true;
+        }
+        if (--group->Outstanding == 0)
+        {   // every level of the load has finished; let any attached requests complete after the update.
+            if (group->Failed)
+            {   // no further placements will be posted for the load.
+                image_loader_post_error(loader, part, lvlp->SourceFile[index], state.Config, NULL, group->ErrorCode, group->OSError);
+            }
+            image_loader_record_completion(part, lvlp->SourceFile[index], state.Config, !group->Failed);
+            free(group);
+        }
+        // release the reference to the stream decoder.
+        lvlp->SourceStream[index]->release();
+        // remove the reader from the active list by swapping.
+        size_t last_index = lvlp->Count - 1;
+        lvlp->SourceStream[index] = lvlp->SourceStream[last_index];
+        lvlp->SourceFile  [index] = lvlp->SourceFile  [last_index];
+        lvlp->ParseState  [index] = lvlp->ParseState  [last_index];
+        lvlp->Count--;
+    }
+}
+
+/// @summary Update the state of all active PNG parsers in a partition.
+/// @param loader The image loader managing the parser partition.
+/// @param part The parser partition owning the active PNG parser list.
+internal_function void image_loader_update_png(image_loader_t *loader, image_loader_partition_t *part)
+{   png_parser_list_t *pngp=&part->ActivePNG;
+    size_t index = 0;
+    while (index < pngp->Count)
+    {
+        image_loader_bind_to_image_node(loader, part, pngp->ParseState[index].Config.ImageId);
+        int res  = png_parser_update(&pngp->ParseState[index]);
+        if (res == PNG_PARSE_RESULT_CONTINUE)
+        {   // not finished parsing this stream yet.
+            index++; continue;
+        }
+        if (res == PNG_PARSE_RESULT_ERROR)
+        {   // determine the appropriate high-level error code.
+            png_parser_state_t &state = pngp->ParseState[index];
+            switch (state.ParserError)
+            {
+            case PNG_PARSE_ERROR_DECODER:
+                image_loader_post_error(loader, part, pngp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, GetLastError());
+                break;
+            case PNG_PARSE_ERROR_NOMEMORY:
+                image_loader_post_error(loader, part, pngp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_MEMORY, GetLastError());
+                break;
+            case PNG_PARSE_ERROR_NOENCODER:
+                image_loader_post_error(loader, part, pngp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_ENCODER, ERROR_SUCCESS);
+                break;
+            case PNG_PARSE_ERROR_ENCODER:
+            case PNG_PARSE_ERROR_BAD_DATA:
+                image_loader_post_error(loader, part, pngp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, ERROR_SUCCESS);
+                break;
+            case PNG_PARSE_ERROR_UNSUPPORTED:
+                image_loader_post_error(loader, part, pngp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_UNSUPPORTED, ERROR_SUCCESS);
+                break;
+            default:
+                image_loader_post_error(loader, part, pngp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_OSERROR, GetLastError());
+                break;
+            }
+        }
+        // let any requests attached to this load complete once the update has finished.
+        image_loader_record_completion(part, pngp->SourceFile[index], pngp->ParseState[index].Config, res != PNG_PARSE_RESULT_ERROR);
+        // perform any parser state cleanup (delete the encoder, etc.)
+        png_parser_state_cleanup(&pngp->ParseState[index]);
+        // release the reference to the stream decoder.
+        pngp->SourceStream[index]->release();
+        // remove the parser from the active list by swapping.
+        size_t last_index = pngp->Count - 1;
+        pngp->SourceStream[index] = pngp->SourceStream[last_index];
+        pngp->SourceFile  [index] = pngp->SourceFile  [last_index];
+        pngp->ParseState  [index] = pngp->ParseState  [last_index];
+        pngp->Count--;
+    }
+}
+
+/// @summary Update the state of all active KTX parsers in a partition.
+/// @param loader The image loader managing the parser partition.
+/// @param part The parser partition owning the active KTX parser list.
+internal_function void image_loader_update_ktx(image_loader_t *loader, image_loader_partition_t *part)
+{   ktx_parser_list_t *ktxp=&part->ActiveKTX;
+    size_t index = 0;
+    while (index < ktxp->Count)
+    {
+        image_loader_bind_to_image_node(loader, part, ktxp->ParseState[index].Config.ImageId);
+        int res  = ktx_parser_update(&ktxp->ParseState[index]);
+        if (res == KTX_PARSE_RESULT_CONTINUE)
+        {   // not finished parsing this stream yet.
+            index++; continue;
+        }
+        if (res == KTX_PARSE_RESULT_ERROR)
+        {   // determine the appropriate high-level error code.
+            ktx_parser_state_t &state = ktxp->ParseState[index];
+            switch (state.ParserError)
+            {
+            case KTX_PARSE_ERROR_DECODER:
+                image_loader_post_error(loader, part, ktxp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, GetLastError());
+                break;
+            case KTX_PARSE_ERROR_NOMEMORY:
+                image_loader_post_error(loader, part, ktxp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_MEMORY, GetLastError());
+                break;
+            case KTX_PARSE_ERROR_NOENCODER:
+                image_loader_post_error(loader, part, ktxp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_ENCODER, ERROR_SUCCESS);
+                break;
+            case KTX_PARSE_ERROR_ENCODER:
+            case KTX_PARSE_ERROR_BAD_DATA:
+                image_loader_post_error(loader, part, ktxp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, ERROR_SUCCESS);
+                break;
+            case KTX_PARSE_ERROR_UNSUPPORTED:
+                image_loader_post_error(loader, part, ktxp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_UNSUPPORTED, ERROR_SUCCESS);
+                break;
+            default:
+                image_loader_post_error(loader, part, ktxp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_OSERROR, GetLastError());
+                break;
+            }
+        }
+        // let any requests attached to this load complete once the update has finished.
+        image_loader_record_completion(part, ktxp->SourceFile[index], ktxp->ParseState[index].Config, res != KTX_PARSE_RESULT_ERROR);
+        // perform any parser state cleanup (delete the encoder, etc.)
+        ktx_parser_state_cleanup(&ktxp->ParseState[index]);
+        // release the reference to the stream decoder.
+        ktxp->SourceStream[index]->release();
+        // remove the parser from the active list by swapping.
+        size_t last_index = ktxp->Count - 1;
+        ktxp->SourceStream[index] = ktxp->SourceStream[last_index];
+        ktxp->SourceFile  [index] = ktxp->SourceFile  [last_index];
+        ktxp->ParseState  [index] = ktxp->ParseState  [last_index];
+        ktxp->Count--;
+    }
+}
+
+/// @summary Update the state of all active JPEG parsers in a partition.
+/// @param loader The image loader managing the parser partition.
+/// @param part The parser partition owning the active JPEG parser list.
+internal_function void image_loader_update_jpeg(image_loader_t *loader, image_loader_partition_t *part)
+{   jpeg_parser_list_t *jpgp=&part->ActiveJPEG;
+    size_t index = 0;
+    while (index < jpgp->Count)
+    {
+        image_loader_bind_to_image_node(loader, part, jpgp->ParseState[index].Config.ImageId);
+        int res  = jpeg_parser_update(&jpgp->ParseState[index]);
+        if (res == JPEG_PARSE_RESULT_CONTINUE)
+        {   // not finished parsing this stream yet.
+            index++; continue;
+        }
+        if (res == JPEG_PARSE_RESULT_ERROR)
+        {   // determine the appropriate high-level error code.
+            jpeg_parser_state_t &state = jpgp->ParseState[index];
+            switch (state.ParserError)
+            {
+            case JPEG_PARSE_ERROR_DECODER:
+                image_loader_post_error(loader, part, jpgp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, GetLastError());
+                break;
+            case JPEG_PARSE_ERROR_NOMEMORY:
+                image_loader_post_error(loader, part, jpgp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_MEMORY, GetLastError());
+                break;
+            case JPEG_PARSE_ERROR_NOENCODER:
+                image_loader_post_error(loader, part, jpgp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_ENCODER, ERROR_SUCCESS);
+                break;
+            case JPEG_PARSE_ERROR_ENCODER:
+            case JPEG_PARSE_ERROR_BAD_DATA:
+                image_loader_post_error(loader, part, jpgp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, ERROR_SUCCESS);
+                break;
+            case JPEG_PARSE_ERROR_UNSUPPORTED:
+                image_loader_post_error(loader, part, jpgp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_UNSUPPORTED, ERROR_SUCCESS);
+                break;
+            default:
+                image_loader_post_error(loader, part, jpgp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_OSERROR, GetLastError());
+                break;
+            }
+        }
+        // let any requests attached to this load complete once the update has finished.
+        image_loader_record_completion(part, jpgp->SourceFile[index], jpgp->ParseState[index].Config, res != JPEG_PARSE_RESULT_ERROR);
+        // perform any parser state cleanup (delete the encoder, etc.)
+        jpeg_parser_state_cleanup(&jpgp->ParseState[index]);
+        // release the reference to the stream decoder.
+        jpgp->SourceStream[index]->release();
+        // remove the parser from the active list by swapping.
+        size_t last_index = jpgp->Count - 1;
+        jpgp->SourceStream[index] = jpgp->SourceStream[last_index];
+        jpgp->SourceFile  [index] = jpgp->SourceFile  [last_index];
+        jpgp->ParseState  [index] = jpgp->ParseState  [last_index];
+        jpgp->Count--;
+    }
+}
+
+/// @summary Update the state of all active TGA parsers in a partition.
+/// @param loader The image loader managing the parser partition.
+/// @param part The parser partition owning the active TGA parser list.
+internal_function void image_loader_update_tga(image_loader_t *loader, image_loader_partition_t *part)
+{   tga_parser_list_t *tgap=&part->ActiveTGA;
+    size_t index = 0;
+    while (index < tgap->Count)
+    {
+        image_loader_bind_to_image_node(loader, part, tgap->ParseState[index].Config.ImageId);
+        int res  = tga_parser_update(&tgap->ParseState[index]);
+        if (res == TGA_PARSE_RESULT_CONTINUE)
+        {   // not finished parsing this stream yet.
+            index++; continue;
+        }
+        if (res == TGA_PARSE_RESULT_ERROR)
+        {   // determine the appropriate high-level error code.
+            tga_parser_state_t &state = tgap->ParseState[index];
+            switch (state.ParserError)
+            {
+            case TGA_PARSE_ERROR_DECODER:
+                image_loader_post_error(loader, part, tgap->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, GetLastError());
+                break;
+            case TGA_PARSE_ERROR_NOMEMORY:
+                image_loader_post_error(loader, part, tgap->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_MEMORY, GetLastError());
+                break;
+            case TGA_PARSE_ERROR_NOENCODER:
+                image_loader_post_error(loader, part, tgap->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_ENCODER, ERROR_SUCCESS);
+                break;
+            case TGA_PARSE_ERROR_ENCODER:
+            case TGA_PARSE_ERROR_BAD_DATA:
+                image_loader_post_error(loader, part, tgap->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, ERROR_SUCCESS);
+                break;
+            case TGA_PARSE_ERROR_UNSUPPORTED:
+                image_loader_post_error(loader, part, tgap->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_UNSUPPORTED, ERROR_SUCCESS);
+                break;
+            default:
+                image_loader_post_error(loader, part, tgap->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_OSERROR, GetLastError());
+                break;
+            }
+        }
+        // let any requests attached to this load complete once the update has finished.
+        image_loader_record_completion(part, tgap->SourceFile[index], tgap->ParseState[index].Config, res != TGA_PARSE_RESULT_ERROR);
+        // perform any parser state cleanup (delete the encoder, etc.)
+        tga_parser_state_cleanup(&tgap->ParseState[index]);
+        // release the reference to the stream decoder.
+        tgap->SourceStream[index]->release();
+        // remove the parser from the active list by swapping.
+        size_t last_index = tgap->Count - 1;
+        tgap->SourceStream[index] = tgap->SourceStream[last_index];
+        tgap->SourceFile  [index] = tgap->SourceFile  [last_index];
+        tgap->ParseState  [index] = tgap->ParseState  [last_index];
+        tgap->Count--;
+    }
+}
+
+/// @summary Update the state of all active BMP parsers in a partition.
+/// @param loader The image loader managing the parser partition.
+/// @param part The parser partition owning the active BMP parser list.
+internal_function void image_loader_update_bmp(image_loader_t *loader, image_loader_partition_t *part)
+{   bmp_parser_list_t *bmpp=&part->ActiveBMP;
+    size_t index = 0;
+    while (index < bmpp->Count)
+    {
+        image_loader_bind_to_image_node(loader, part, bmpp->ParseState[index].Config.ImageId);
+        int res  = bmp_parser_update(&bmpp->ParseState[index]);
+        if (res == BMP_PARSE_RESULT_CONTINUE)
+        {   // not finished parsing this stream yet.
+            index++; continue;
+        }
+        if (res == BMP_PARSE_RESULT_ERROR)
+        {   // determine the appropriate high-level error code.
+            bmp_parser_state_t &state = bmpp->ParseState[index];
+            switch (state.ParserError)
+            {
+            case BMP_PARSE_ERROR_DECODER:
+                image_loader_post_error(loader, part, bmpp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, GetLastError());
+                break;
+            case BMP_PARSE_ERROR_NOMEMORY:
+                image_loader_post_error(loader, part, bmpp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_MEMORY, GetLastError());
+                break;
+            case BMP_PARSE_ERROR_NOENCODER:
+                image_loader_post_error(loader, part, bmpp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_NO_ENCODER, ERROR_SUCCESS);
+                break;
+            case BMP_PARSE_ERROR_ENCODER:
+            case BMP_PARSE_ERROR_BAD_DATA:
+                image_loader_post_error(loader, part, bmpp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_BAD_DATA, ERROR_SUCCESS);
+                break;
+            case BMP_PARSE_ERROR_UNSUPPORTED:
+                image_loader_post_error(loader, part, bmpp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_UNSUPPORTED, ERROR_SUCCESS);
+                break;
+            default:
+                image_loader_post_error(loader, part, bmpp->SourceFile[index], state.Config, state.Encoder, IMAGE_LOAD_ERROR_OSERROR, GetLastError());
+                break;
+            }
+        }
+        // let any requests attached to this load complete once the update has finished.
+        image_loader_record_completion(part, bmpp->SourceFile[index], bmpp->ParseState[index].Config, res != BMP_PARSE_RESULT_ERROR);
+        // perform any parser state cleanup (delete the encoder, etc.)
+        bmp_parser_state_cleanup(&bmpp->ParseState[index]);
+        // release the reference to the stream decoder.
+        bmpp->SourceStream[index]->release();
+        // remove the parser from the active list by swapping.
+        size_t last_index = bmpp->Count - 1;
+        bmpp->SourceStream[index] = bmpp->SourceStream[last_index];
+        bmpp->SourceFile  [index] = bmpp->SourceFile  [last_index];
+        bmpp->ParseState  [index] = bmpp->ParseState  [last_index];
+        bmpp->Count--;
+    }
+}
+
+/// @summary Updates the state of every active parser in a partition. This is the work item function 
+/// executed on the ParserPool; each item updates one partition, so no partition is updated by two 
+/// threads at once, and no locks are needed inside the parsers.
+/// @param context The image_loader_t being updated.
+/// @param index The zero-based index of the partition to update.
+internal_function void image_loader_update_partition(void *context, size_t index)
+{
+    image_loader_t           *loader = (image_loader_t*) context;
+    image_loader_partition_t *part   =&loader->Partitions[index];
+    // the thread starts with its own affinity mask, since any binding is undone when the last update returned.
+    image_loader_update_dds (loader, part);
+    image_loader_update_dds_levels(loader, part);
+    image_loader_update_png (loader, part);
+    image_loader_update_ktx (loader, part);
+    image_loader_update_jpeg(loader, part);
+    image_loader_update_tga (loader, part);
+    image_loader_update_bmp (loader, part);
+    // ...
+    image_loader_restore_affinity(part);
+}
+
+/// @summary Examines the file extension portion of a path string to determine the correct image_file_format_e.
+/// @param path A NULL-terminated UTF-8 string specifying a filename.
+/// @return One of image_file_format_e.
+public_function int image_file_format_from_extension(char const *path)
+{
+    size_t      len = strlen(path);
+    char const *ext = path + len - 1;
+    while (ext >= path)
+    {
         if (*ext == '.')
         {
             ext++; // skip '.'
@@ -357,16 +1599,228 @@ public_function int image_file_format_from_extension(char const *path)
     {
         return IMAGE_FILE_FORMAT_DDS;
     }
+    else if (_stricmp(ext, "png") == 0)
+    {
+        return IMAGE_FILE_FORMAT_PNG;
+    }
+    else if (_stricmp(ext, "ktx") == 0 || _stricmp(ext, "ktx2") == 0)
+    {
+        return IMAGE_FILE_FORMAT_KTX;
+    }
+    else if (_stricmp(ext, "jpg") == 0 || _stricmp(ext, "jpeg") == 0)
+    {
+        return IMAGE_FILE_FORMAT_JPEG;
+    }
+    else if (_stricmp(ext, "tga") == 0)
+    {
+        return IMAGE_FILE_FORMAT_TGA;
+    }
+    else if (_stricmp(ext, "bmp") == 0)
+    {
+        return IMAGE_FILE_FORMAT_BMP;
+    }
     else
     {
         return IMAGE_FILE_FORMAT_UNKNOWN;
     }
 }
 
+/// @summary Starts loading the frames specified by a request. Frames are restored from the compressed tier or mapped 
+/// from the file when possible; otherwise, a parser is started for the file.
+/// @param loader The image loader that received the request.
+/// @param load_info The image load request.
+/// @return true if a parser was started, or false if the request completed immediately or could not be started.
+internal_function bool image_loader_start_request(image_loader_t *loader, image_load_t const &load_info)
+{
+    int fmt  = image_file_format_from_extension(load_info.FilePath);
+    if (image_loader_restore_frames(loader, load_info))
+    {   // all requested frames were restored from the compressed tier.
+        return false;
+    }
+    if (fmt == IMAGE_FILE_FORMAT_DDS)
+    {
+        size_t index = image_loader_add_image(loader, load_info);
+        if (image_loader_map_dds(loader, index, load_info))
+        {   // all requested frames were mapped directly from the file.
+            return false;
+        }
+        if (image_loader_start_dds_levels(loader, index, load_info))
+        {   // the levels of the requested frames are being read lowest resolution first.
+            return true;
+        }
+        return image_loader_start_dds(loader, index, load_info);
+    }
+    else if (fmt == IMAGE_FILE_FORMAT_PNG)
+    {
+        size_t index = image_loader_add_image(loader, load_info);
+        return image_loader_start_png(loader, index, load_info);
+    }
+    else if (fmt == IMAGE_FILE_FORMAT_KTX)
+    {
+        size_t index = image_loader_add_image(loader, load_info);
+        return image_loader_start_ktx(loader, index, load_info);
+    }
+    else if (fmt == IMAGE_FILE_FORMAT_JPEG)
+    {
+        size_t index = image_loader_add_image(loader, load_info);
+        return image_loader_start_jpeg(loader, index, load_info);
+    }
+    else if (fmt == IMAGE_FILE_FORMAT_TGA)
+    {
+        size_t index = image_loader_add_image(loader, load_info);
+        return image_loader_start_tga(loader, index, load_info);
+    }
+    else if (fmt == IMAGE_FILE_FORMAT_BMP)
+    {
+        size_t index = image_loader_add_image(loader, load_info);
+        return image_loader_start_bmp(loader, index, load_info);
+    }
+    // else if (fmt == ...)
+    else if (loader->ErrorQueue != NULL)
+    {   // the loader doesn't recognize this container format. complete with an error.
+        fifo_node_t<image_load_error_t> *n = fifo_allocator_get(&loader->ErrorAlloc);
+        n->Item.ImageId        = load_info.ImageId;
+        n->Item.FilePath       = load_info.FilePath;
+        n->Item.FirstFrame     = load_info.FirstFrame;
+        n->Item.FinalFrame     = load_info.FinalFrame;
+        n->Item.SrcCompression = IMAGE_COMPRESSION_NONE;
+        n->Item.SrcEncoding    = IMAGE_ENCODING_RAW;
+        n->Item.DstCompression = IMAGE_COMPRESSION_NONE;
+        n->Item.DstEncoding    = IMAGE_ENCODING_RAW;
+        n->Item.ErrorCode      = IMAGE_LOAD_ERROR_NO_PARSER;
+        n->Item.OSError        = ERROR_SUCCESS;
+        mpsc_fifo_u_produce(loader->ErrorQueue, n);
+    }
+    return false;
+}
+
+/// @summary Accepts a load request. If an identical load is already in flight, the request attaches to it; 
+/// otherwise, or if the request can't be attached, the load is started and added to the in-flight load table.
+/// @param loader The image loader that received the request.
+/// @param load_info The image load request.
+internal_function void image_loader_submit(image_loader_t *loader, image_load_t const &load_info)
+{
+    uint32_t               hash   = image_loader_path_hash(load_info.FilePath);
+    image_loader_flight_t *flight = image_loader_find_flight(loader, hash, load_info);
+    if (flight != NULL && image_loader_attach_flight(loader, flight, load_info))
+    {   // share the result of the load that's already in progress.
+        return;
+    }
+    if (image_loader_start_request(loader, load_info))
+    {   // a parser is running; suppress duplicates until it finishes.
+        image_loader_begin_flight(loader, hash, load_info);
+    }
+}
+
+/// @summary Completes a request attached to a finished load for another image, by defining the image with the 
+/// same storage layout and copying the loaded frames into it. No file I/O or decoding is performed.
+/// @param loader The image loader that received the request.
+/// @param leader The request that started the load.
+/// @param follower The request attached to the load.
+/// @return true if every requested frame was copied and placement notifications were posted.
+internal_function bool image_loader_copy_frames(image_loader_t *loader, image_load_t const &leader, image_load_t const &follower)
+{
+    dds_level_desc_t           desc;
+    image_storage_info_t       storage;
+    stream_decode_pos_t const *offsets = NULL;
+    size_t                     index   = 0;
+    if (!image_memory_storage_info(loader->ImageMemory, leader.ImageId, desc, storage))
+    {   // the load didn't define the image.
+        return false;
+    }
+    size_t first_frame = follower.FirstFrame;
+    size_t final_frame = follower.FinalFrame == IMAGE_ALL_FRAMES ? storage.ElementCount - 1 : follower.FinalFrame;
+    if (first_frame > final_frame || final_frame >= storage.ElementCount)
+    {   // the frame range is not valid; let a parser report the error.
+        return false;
+    }
+    if (id_table_get(&loader->ImageIds, leader.ImageId, &index))
+    {   // both images come from the same file, so the source offsets are shared. 
+        // no parser is running, so the image list can be read without the lock.
+        image_definition_t const &meta = loader->ImageMetadata[index];
+        if (meta.BlockOffsets != NULL && meta.ElementCount == storage.ElementCount && meta.LevelCount == storage.LevelCount)
+            offsets = meta.BlockOffsets;
+    }
+    if (image_memory_clone_image(loader->ImageMemory, leader.ImageId, follower.ImageId, offsets, loader->DefinitionQueue, &loader->DefinitionAlloc) != ERROR_SUCCESS)
+    {   // the image already exists with a different layout, or memory is exhausted.
+        return false;
+    }
+    for (size_t i = first_frame; i <= final_frame; ++i)
+    {   // if a frame was evicted since it was loaded, the follower loads the file itself.
+        if (image_memory_copy_element(loader->ImageMemory, leader.ImageId, follower.ImageId, i, loader->PlacementQueue, &loader->PlacementAlloc) != ERROR_SUCCESS)
+            return false;
+        loader->DuplicateCopies.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+/// @summary Resolves the parsers that finished during the last update against the in-flight load table. 
+/// Each finished load is removed from the table, and the requests attached to it are completed.
+/// @param loader The image loader to update. No partition may be updating.
+internal_function void image_loader_resolve_completions(image_loader_t *loader)
+{
+    for (size_t p = 0, np = loader->PartitionCount; p < np; ++p)
+    {
+        image_loader_partition_t *part = &loader->Partitions[p];
+        for (size_t c = 0, nc = part->CompletionCount; c < nc; ++c)
+        {
+            image_loader_completion_t const &done = part->Completions[c];
+            for (size_t i = 0; i < loader->FlightCount; ++i)
+            {
+                image_loader_flight_t &f = loader->Flights[i];
+                if (f.Request.ImageId    != done.ImageId    || f.Request.FilePath   != done.FilePath || 
+                    f.Request.FirstFrame != done.FirstFrame || f.Request.FinalFrame != done.FinalFrame)
+                    continue;
+
+                // retire the flight before completing its followers, since a follower may start a new load.
+                image_loader_flight_t flight = f;
+                loader->Flights[i] = loader->Flights[--loader->FlightCount];
+                loader->LoadsInFlight.fetch_sub(1, std::memory_order_relaxed);
+                for (size_t j = 0; j < flight.FollowerCount; ++j)
+                {   // if the load failed or the frames can't be copied, load the file for the follower.
+                    if (!done.Succeeded || !image_loader_copy_frames(loader, flight.Request, flight.Followers[j]))
+                        image_loader_submit(loader, flight.Followers[j]);
+                }
+                free(flight.Followers);
+                break;
+            }
+        }
+        part->CompletionCount = 0;
+    }
+}
+
+/// @summary Asks image memory to pre-fault the requested frames of each in-flight load, so that the pages are 
+/// committed before the parser writes them. A load is skipped until its image has been reserved, and is only 
+/// pre-faulted once. Frames outside of the requested range are never pre-faulted.
+/// @param loader The image loader to update. No partition may be updating.
+internal_function void image_loader_prefault_flights(image_loader_t *loader)
+{
+    for (size_t i = 0, n = loader->FlightCount; i < n; ++i)
+    {
+        image_loader_flight_t &f = loader->Flights[i];
+        if (!f.Prefaulted)
+            f.Prefaulted = image_memory_prefault_elements(loader->ImageMemory, f.Request.ImageId, f.Request.FirstFrame, f.Request.FinalFrame);
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
 /// @summary Initializes a new image loader instance.
 /// @param loader The image loader instance to initialize.
+/// @param config The image loader configuration.
 public_function void image_loader_create(image_loader_t *loader, image_loader_config_t const &config)
 {
+    size_t partitions = config.ParserCount;
+    if (config.ParserPool == NULL)
+    {   // every parser is updated on the loader thread.
+        partitions = 1;
+    }
+    else if (partitions == 0)
+    {   // one partition per-worker, plus one for the loader thread, which also executes items.
+        partitions = config.ParserPool->ThreadCount + 1;
+    }
+
     size_t capacity = config.ImageCapacity;
     if (capacity < IMAGE_LOADER_BUCKET_SIZE)
     {   // we need at least one bucket. enforce a minimum limit.
@@ -381,6 +1835,12 @@ public_function void image_loader_create(image_loader_t *loader, image_loader_co
     loader->ErrorQueue      = config.ErrorQueue;
     loader->Compression     = config.Compression;
     loader->Encoding        = config.Encoding;
+    loader->Residency       = config.Residency;
+    loader->Format          = config.Format;
+    loader->Quality         = config.Quality;
+    loader->WorkPool        = config.WorkPool;
+    loader->EncoderFlags    = config.EncoderFlags;
+    loader->Index           = config.Index;
 
     InitializeSRWLock(&loader->ImageLock);
     loader->ImageCount      = 0;
@@ -389,7 +1849,40 @@ public_function void image_loader_create(image_loader_t *loader, image_loader_co
     id_table_create(&loader->ImageIds, bucket_count);
 
     loader->io.initialize(config.VFSDriver);
-    image_parser_list_create(&loader->ActiveDDS, 16);
+    loader->ParserPool      = (partitions > 1) ? config.ParserPool : NULL;
+    loader->PartitionCount  = partitions;
+    loader->Partitions      =(image_loader_partition_t*) malloc(partitions * sizeof(image_loader_partition_t));
+    if (loader->ParserPool != NULL && !work_pool_batch_create(&loader->ParserBatch))
+    {   // the partitions are still used, but they're all updated on the loader thread.
+        loader->ParserPool  = NULL;
+    }
+    for (size_t i = 0; i < partitions; ++i)
+    {
+        image_loader_partition_t *part = &loader->Partitions[i];
+        image_parser_list_create(&part->ActiveDDS, 16);
+        image_parser_list_create(&part->ActivePNG, 16);
+        image_parser_list_create(&part->ActiveKTX, 16);
+        image_parser_list_create(&part->ActiveJPEG, 16);
+        image_parser_list_create(&part->ActiveTGA, 16);
+        image_parser_list_create(&part->ActiveBMP, 16);
+        image_parser_list_create(&part->ActiveLevels, 16);
+        fifo_allocator_init(&part->DefinitionAlloc);
+        fifo_allocator_init(&part->PlacementAlloc);
+        fifo_allocator_init(&part->ErrorAlloc);
+        part->NumaNode           = NUMA_NO_PREFERRED_NODE;
+        ZeroMemory(&part->SavedAffinity, sizeof(GROUP_AFFINITY));
+        part->CompletionCount    = 0;
+        part->CompletionCapacity = 0;
+        part->Completions        = NULL;
+    }
+
+    loader->FlightCount     = 0;
+    loader->FlightCapacity  = 0;
+    loader->Flights         = NULL;
+    loader->LoadsStarted    = 0;
+    loader->LoadsInFlight   = 0;
+    loader->DuplicateLoads  = 0;
+    loader->DuplicateCopies = 0;
 
     fifo_allocator_init(&loader->DefinitionAlloc);
     fifo_allocator_init(&loader->PlacementAlloc);
@@ -404,7 +1897,38 @@ public_function void image_loader_delete(image_loader_t *loader)
     fifo_allocator_reinit(&loader->PlacementAlloc);
     fifo_allocator_reinit(&loader->DefinitionAlloc);
 
-    image_parser_list_delete(&loader->ActiveDDS);
+    for (size_t i = 0, n = loader->PartitionCount; i < n; ++i)
+    {
+        image_loader_partition_t *part = &loader->Partitions[i];
+        fifo_allocator_reinit(&part->ErrorAlloc);
+        fifo_allocator_reinit(&part->PlacementAlloc);
+        fifo_allocator_reinit(&part->DefinitionAlloc);
+        free(part->Completions);
+        image_parser_list_delete(&part->ActiveLevels);
+        image_parser_list_delete(&part->ActiveBMP);
+        image_parser_list_delete(&part->ActiveTGA);
+        image_parser_list_delete(&part->ActiveJPEG);
+        image_parser_list_delete(&part->ActiveKTX);
+        image_parser_list_delete(&part->ActivePNG);
+        image_parser_list_delete(&part->ActiveDDS);
+    }
+    if (loader->ParserPool != NULL)
+    {   // the batch is only created when partitions are dispatched to the pool.
+        work_pool_batch_delete(&loader->ParserBatch);
+    }
+    free(loader->Partitions);
+    loader->Partitions     = NULL;
+    loader->PartitionCount = 0;
+    loader->ParserPool     = NULL;
+
+    for (size_t i = 0, n = loader->FlightCount; i < n; ++i)
+    {
+        free(loader->Flights[i].Followers);
+    }
+    free(loader->Flights);
+    loader->Flights        = NULL;
+    loader->FlightCount    = 0;
+    loader->FlightCapacity = 0;
 
     for (size_t i = 0, n = loader->ImageCount; i < n; ++i)
     {
@@ -438,33 +1962,63 @@ public_function void image_loader_update(image_loader_t *loader)
     image_load_t load_info;
     while  (mpsc_fifo_u_consume(&loader->RequestQueue, load_info))
     {
-        int fmt  = image_file_format_from_extension(load_info.FilePath);
-        if (fmt == IMAGE_FILE_FORMAT_DDS)
+        image_loader_submit(loader, load_info);
+    }
+
+    // update the state of all active parsers. each partition is updated by a single 
+    // thread, and the call doesn't return until every partition has been updated, so
+    // requests are never started while parsers are running on the pool threads.
+    size_t active_count = 0;
+    for (size_t i = 0, n = loader->PartitionCount; i < n; ++i)
+    {
+        image_loader_partition_t *part  = &loader->Partitions[i];
+        size_t                    count = part->ActiveDDS.Count + part->ActivePNG.Count + part->ActiveKTX.Count + 
+                                          part->ActiveJPEG.Count + part->ActiveTGA.Count + part->ActiveBMP.Count + 
+                                          part->ActiveLevels.Count;
+        if (count > part->CompletionCapacity)
+        {   // every active parser may finish during this update, so the completion list never grows on a pool thread.
+            size_t                     new_amount = calculate_capacity(part->CompletionCapacity, count, 256, 64);
+            image_loader_completion_t *new_list   =(image_loader_completion_t*) realloc(part->Completions, new_amount * sizeof(image_loader_completion_t));
+            if (new_list == NULL)
+            {   // try again on the next update.
+                return;
+            }
+            part->Completions        = new_list;
+            part->CompletionCapacity = new_amount;
+        }
+        active_count += count;
+    }
+    if (active_count == 0)
+    {   // don't wake the pool threads when there's nothing to parse.
+        return;
+    }
+    // commit pages for the frames the parsers are about to write.
+    image_loader_prefault_flights(loader);
+    if (loader->ParserPool != NULL)
+    {
+        work_pool_submit(loader->ParserPool, &loader->ParserBatch, image_loader_update_partition, loader, loader->PartitionCount);
+        work_pool_wait  (loader->ParserPool, &loader->ParserBatch);
+    }
+    else
+    {
+        for (size_t i = 0, n = loader->PartitionCount; i < n; ++i)
         {
-            size_t index = image_loader_add_image(loader, load_info);
-            image_loader_start_dds(loader, index, load_info);
-        }
-        // else if (fmt == ...)
-        else if (loader->ErrorQueue != NULL)
-        {   // the loader doesn't recognize this container format. complete with an error.
-            fifo_node_t<image_load_error_t> *n = fifo_allocator_get(&loader->ErrorAlloc);
-            n->Item.ImageId        = load_info.ImageId;
-            n->Item.FilePath       = load_info.FilePath;
-            n->Item.FirstFrame     = load_info.FirstFrame;
-            n->Item.FinalFrame     = load_info.FinalFrame;
-            n->Item.SrcCompression = IMAGE_COMPRESSION_NONE;
-            n->Item.SrcEncoding    = IMAGE_ENCODING_RAW;
-            n->Item.DstCompression = IMAGE_COMPRESSION_NONE;
-            n->Item.DstEncoding    = IMAGE_ENCODING_RAW;
-            n->Item.ErrorCode      = IMAGE_LOAD_ERROR_NO_PARSER;
-            n->Item.OSError        = ERROR_SUCCESS;
-            mpsc_fifo_u_produce(loader->ErrorQueue, n);
-        }
-    }
-
-    // update the state of all active parsers:
-    image_loader_update_dds(loader);
-    // ...
+            image_loader_update_partition(loader, i);
+        }
+    }
+    // complete any requests attached to the loads that just finished.
+    image_loader_resolve_completions(loader);
+}
+
+/// @summary Retrieves load statistics for an image loader. This function may be called from any thread.
+/// @param loader The image loader to query.
+/// @param stats On return, the current load statistics.
+public_function void image_loader_stats(image_loader_t *loader, image_loader_stats_t &stats)
+{
+    stats.LoadsStarted    = loader->LoadsStarted.load(std::memory_order_relaxed);
+    stats.LoadsInFlight   = loader->LoadsInFlight.load(std::memory_order_relaxed);
+    stats.DuplicateLoads  = loader->DuplicateLoads.load(std::memory_order_relaxed);
+    stats.DuplicateCopies = loader->DuplicateCopies.load(std::memory_order_relaxed);
 }
 
 /// @summary Construct a new image loader instance for the calling thread.
@@ -37,6 +37,9 @@
 #define IMAGE_MEMORY_BUCKET_SIZE    128U
 #endif
 
+/// @summary The per-node lock counter value at which all of an image's node lock counters are halved.
+#define IMAGE_MEMORY_NODE_LOCK_MAX  0x00100000U
+
 /*///////////////////
 //   Local Types   //
 ///////////////////*/
@@ -46,7 +49,17 @@ enum image_memory_flags_e : uint32_t
     IMAGE_MEMORY_FLAG_NONE        = (0 << 0), /// The level memory is reserved, but not committed.
     IMAGE_MEMORY_FLAG_COMMITTED   = (1 << 0), /// The level memory is committed.
     IMAGE_MEMORY_FLAG_EVICT       = (1 << 1), /// The level memory should be decommitted when the lock count drops to zero.
-    IMAGE_MEMORY_FLAG_DROP        = (1 << 2)  /// The image memory should be decommitted and released.
+    IMAGE_MEMORY_FLAG_DROP        = (1 << 2), /// The image memory should be decommitted and released.
+    IMAGE_MEMORY_FLAG_MAPPED      = (1 << 3), /// The element data is a read-only view of the source file, not committed memory.
+    IMAGE_MEMORY_FLAG_PREFAULT    = (1 << 4), /// The element pages are being committed and faulted by the background committer.
+    IMAGE_MEMORY_FLAG_WRITING     = (1 << 5)  /// The element data is being written, or its pages are committed ahead of a write. The data is not valid.
+};
+
+/// @summary Define the supported policies for selecting the NUMA node from which image memory is committed.
+enum image_memory_numa_policy_e : int
+{
+    IMAGE_MEMORY_NUMA_POLICY_HINT   = 0,      /// Commit from the node hint of the image or manager, or the first-touch node if none is specified.
+    IMAGE_MEMORY_NUMA_POLICY_LOCKER = 1       /// Commit from the node whose threads lock the image most often.
 };
 
 /// @summary Define the data describing a single level of the mipmap-chain.
@@ -67,6 +80,15 @@ struct image_memory_block_t
     size_t                StoredSize;         /// The size of the data as stored in memory.
 };
 
+/// @summary Defines a read-only view of a file range backing an image element/frame.
+/// The view starts on an allocation granularity boundary, so the element data may begin partway into the view.
+struct image_memory_view_t
+{
+    void                 *ViewBase;           /// The address returned by MapViewOfFile, or NULL if the element is not mapped.
+    uint8_t              *ElementData;        /// The address of the first byte of element data within the view.
+    size_t                ViewSize;           /// The number of bytes mapped, including the leading alignment bytes.
+};
+
 /// @summary Defines the commit size and actual usage for an image element/frame.
 struct image_memory_size_t
 {
@@ -75,6 +97,8 @@ struct image_memory_size_t
     size_t                LevelsEmitted;      /// The number of mip-levels written (index of the current level.)
     size_t                LevelOffset;        /// The byte offset of the start of the current level, from the start of the element.
     size_t                LevelSize;          /// The number of bytes written to the current level so far.
+    size_t                BytesPrefaulted;    /// The number of bytes committed ahead of the first write by the background committer.
+    uint32_t              LevelsResident;     /// A bitmask of the levels written with image_memory_write_level() that are complete.
 };
 
 /// @summary Define the data describing a single logical image. Each image reserves enough 
@@ -92,10 +116,15 @@ struct image_memory_info_t
     size_t                BytesPerBlock;      /// The number of bytes allocated per-block, or 0 if not block compressed.
     size_t                BytesPerElement;    /// The number of bytes reserved per-element. Always a multiple of allocation granularity.
     size_t                BytesPerElementMax; /// The maximum number of bytes that can be committed per-element. Always a multiple of the system page size.
-    uint32_t             *ElementStatus;      /// ElementCount items, lock count and image_memory_flags_e.
+    std::atomic<uint32_t>*ElementStatus;      /// ElementCount items, lock count and image_memory_flags_e. Updated with CAS.
+    std::atomic<uint32_t>*ElementPins;        /// ElementCount items, the number of outstanding pins. Changed only under the shared ImageLock, so stable under the exclusive lock.
     image_memory_size_t  *ElementCommit;      /// ElementCount items, bytes used and committed.
     image_memory_level_t *LevelDimension;     /// LevelCount descriptions of each mip-level (0 = highest resolution).
     image_memory_block_t *ImageBlocks;        /// ElementCount * LevelCount items specifying location and storage size.
+    uint32_t             *NodeLocks;          /// NumaNodeCount lock counters, one per NUMA node, or NULL if not tracked.
+    image_memory_view_t  *ElementViews;       /// ElementCount file views, or NULL if no element of the image has been mapped.
+    dds_header_t          DDSHeader;          /// The base DDS header of the definition the image was reserved with.
+    dds_header_dxt10_t    DX10Header;         /// The extended DX10 header of the definition the image was reserved with.
 };
 
 /// @summary Define the memory allocation data for a single logical image.
@@ -104,17 +133,33 @@ struct image_memory_addr_t
     void                 *BaseAddress;        /// The base address of the reserved page range.
     size_t                BytesReserved;      /// The number of bytes reserved, rounded to the allocation granularity.
     size_t                BytesCommitted;     /// The number of bytes actually committed, a multiple of the page size.
+    size_t                BytesMapped;        /// The number of bytes of file data mapped for elements of the image.
     uint32_t              ImageStatus;        /// Either IMAGE_MEMORY_FLAG_NONE or IMAGE_MEMORY_FLAG_DROP.
+    uint32_t              NumaNode;           /// The NUMA node from which pages are committed, or NUMA_NO_PREFERRED_NODE.
 };
 
 /// @summary Defines all of the state associated with a virtual-memory based image memory manager.
 struct image_memory_t
 {
-    size_t                BytesReserved;      /// The total number of bytes of address space reserved for all images.
-    size_t                BytesCommitted;     /// The number of bytes actually committed for all images.
+    std::atomic<size_t>   BytesReserved;      /// The total number of bytes of address space reserved for all images.
+    std::atomic<size_t>   BytesCommitted;     /// The number of bytes actually committed for all images.
+    std::atomic<size_t>   BytesMapped;        /// The number of bytes of file data mapped for all images.
 
     size_t                PageSize;           /// The operating system page size, in bytes.
     size_t                Granularity;        /// The operating system virtual memory allocation granularity, in bytes.
+    size_t                RowAlignment;       /// The byte alignment of the row pitch of uncompressed levels, or 1 to store rows tightly packed.
+
+    int                   NumaPolicy;         /// One of image_memory_numa_policy_e specifying how images are placed.
+    uint32_t              NumaNode;           /// The default NUMA node for new images, or NUMA_NO_PREFERRED_NODE.
+    size_t                NumaNodeCount;      /// The number of NUMA nodes in the system.
+
+    image_tier_t         *Tier;               /// The optional compressed tier receiving evicted elements, or NULL.
+    image_committer_t    *Committer;          /// The optional background committer that pre-faults elements ahead of writes, or NULL.
+
+    SRWLOCK               ImageLock;          /// Reader-writer lock protecting the image lists against pin/unpin and writes from other threads.
+    SRWLOCK               WriterLock;         /// Serializes image reservation by threads writing image data.
+    SRWLOCK               TierLock;           /// Serializes access to the compressed tier. Acquired last, after either of the other locks.
+    std::atomic<size_t>   EvictPending;       /// The number of unpins that left an element waiting to be evicted.
 
     size_t                ImageCount;         /// The number of images known to the image memory.
     size_t                ImageCapacity;      /// The number of image records that can be stored without reallocating lists.
@@ -172,11 +217,12 @@ struct image_location_t
     void                *BaseAddress;             /// The address of the start of the frame data.
     size_t               BytesReserved;           /// The number of bytes reserved for the frame data.
     uintptr_t            Context;                 /// Opaque information associated with the frame.
+    size_t               FirstLevel;              /// The zero-based index of the highest-resolution level resident. Levels FirstLevel..LevelCount-1 are valid. 0 if the frame is complete.
 };
 typedef fifo_allocator_t<image_location_t>            image_location_alloc_t;
 typedef mpsc_fifo_u_t   <image_location_t>            image_location_queue_t;
 #define IMAGE_LOCATION_STATIC_INIT(iid, fid)      \
-    { (iid), (fid), NULL, 0, 0 }
+    { (iid), (fid), NULL, 0, 0, 0 }
 
 /*///////////////
 //   Globals   //
@@ -210,6 +256,133 @@ internal_function inline uint32_t image_memory_make_element_status(uint32_t stat
     return (((status_bits << IMAGE_ELEMENT_STATUS_SHIFT) & IMAGE_ELEMENT_STATUS_MASK) | uint32_t(lock_count & IMAGE_ELEMENT_LOCK_MASK));
 }
 
+/// @summary Atomically sets and clears status flags on an element, preserving the lock count.
+/// @param status The packed element status to update.
+/// @param set_flags A combination of image_memory_flags_e to set.
+/// @param clear_flags A combination of image_memory_flags_e to clear. Flags are cleared before any are set.
+/// @param clear_locks Specify true to also reset the lock count to zero.
+/// @return The packed element status value prior to the update.
+internal_function inline uint32_t image_memory_update_element_flags(std::atomic<uint32_t> &status, uint32_t set_flags, uint32_t clear_flags, bool clear_locks=false)
+{
+    uint32_t old_status = status.load(std::memory_order_relaxed);
+    uint32_t new_status;
+    do
+    {
+        uint32_t flags  =(image_memory_element_status_flags(old_status) & ~clear_flags) | set_flags;
+        size_t   locks  = clear_locks ? 0 : image_memory_element_lock_count(old_status);
+        new_status      = image_memory_make_element_status(flags, locks);
+    } while (!status.compare_exchange_weak(old_status, new_status, std::memory_order_acq_rel, std::memory_order_relaxed));
+    return old_status;
+}
+
+/// @summary Atomically increases the lock count on an element. The lock count saturates at IMAGE_ELEMENT_LOCK_MASK.
+/// @param status The packed element status to update.
+/// @param set_flags A combination of image_memory_flags_e to set along with the new locks.
+/// @param lock_count The number of locks to add.
+/// @return The packed element status value after the update.
+internal_function inline uint32_t image_memory_add_element_locks(std::atomic<uint32_t> &status, uint32_t set_flags, size_t lock_count)
+{
+    uint32_t old_status = status.load(std::memory_order_relaxed);
+    uint32_t new_status;
+    do
+    {
+        uint32_t flags  = image_memory_element_status_flags(old_status) | set_flags;
+        size_t   locks  = image_memory_element_lock_count  (old_status) + lock_count;
+        if (locks > IMAGE_ELEMENT_LOCK_MASK) locks = IMAGE_ELEMENT_LOCK_MASK;
+        new_status      = image_memory_make_element_status(flags, locks);
+    } while (!status.compare_exchange_weak(old_status, new_status, std::memory_order_acq_rel, std::memory_order_relaxed));
+    return new_status;
+}
+
+/// @summary Atomically decreases the lock count on an element. The lock count does not drop below zero.
+/// @param status The packed element status to update.
+/// @param lock_count The number of locks to remove.
+/// @return The packed element status value after the update.
+internal_function inline uint32_t image_memory_remove_element_locks(std::atomic<uint32_t> &status, size_t lock_count)
+{
+    uint32_t old_status = status.load(std::memory_order_relaxed);
+    uint32_t new_status;
+    do
+    {
+        uint32_t flags  = image_memory_element_status_flags(old_status);
+        size_t   locks  = image_memory_element_lock_count  (old_status);
+        locks           =(locks >= lock_count) ? (locks - lock_count) : 0;
+        new_status      = image_memory_make_element_status(flags, locks);
+    } while (!status.compare_exchange_weak(old_status, new_status, std::memory_order_acq_rel, std::memory_order_relaxed));
+    return new_status;
+}
+
+/// @summary Atomically adds a lock to an element, but only if the element data is resident and not waiting to be evicted.
+/// Unlike image_memory_add_element_locks(), this never causes memory to be committed, so it is safe from any thread.
+/// @param status The packed element status to update.
+/// @param lock_count The number of locks to add.
+/// @return true if the locks were added, or false if the element is not resident or is marked for eviction.
+internal_function inline bool image_memory_try_pin_element(std::atomic<uint32_t> &status, size_t lock_count)
+{
+    uint32_t old_status = status.load(std::memory_order_acquire);
+    uint32_t new_status;
+    do
+    {
+        uint32_t flags  = image_memory_element_status_flags(old_status);
+        size_t   locks  = image_memory_element_lock_count  (old_status) + lock_count;
+        if ((flags & IMAGE_MEMORY_FLAG_COMMITTED) == 0 || (flags & (IMAGE_MEMORY_FLAG_EVICT | IMAGE_MEMORY_FLAG_WRITING)) != 0 || locks > IMAGE_ELEMENT_LOCK_MASK)
+            return false;
+        new_status      = image_memory_make_element_status(flags, locks);
+    } while (!status.compare_exchange_weak(old_status, new_status, std::memory_order_acq_rel, std::memory_order_acquire));
+    return true;
+}
+
+/// @summary Atomically moves an element from the evict-pending state to the non-resident state. The transition 
+/// succeeds only if the element is committed, marked for eviction and has no outstanding locks, and once it 
+/// succeeds no other thread can pin the element, so the caller owns its storage until it is committed again.
+/// @param status The packed element status to update.
+/// @param flags On return, stores the element status flags prior to the transition.
+/// @return true if the caller should decommit or unmap the element storage.
+internal_function inline bool image_memory_try_begin_evict(std::atomic<uint32_t> &status, uint32_t &flags)
+{
+    uint32_t old_status = status.load(std::memory_order_acquire);
+    uint32_t new_status;
+    do
+    {
+        flags           = image_memory_element_status_flags(old_status);
+        if ((flags & IMAGE_MEMORY_FLAG_EVICT    ) == 0 || 
+            (flags & IMAGE_MEMORY_FLAG_COMMITTED) == 0 || 
+            (image_memory_element_lock_count(old_status) != 0))
+            return false;
+        new_status      = image_memory_make_element_status(flags & ~(IMAGE_MEMORY_FLAG_EVICT | IMAGE_MEMORY_FLAG_COMMITTED | IMAGE_MEMORY_FLAG_MAPPED | IMAGE_MEMORY_FLAG_WRITING), 0);
+    } while (!status.compare_exchange_weak(old_status, new_status, std::memory_order_acq_rel, std::memory_order_acquire));
+    return true;
+}
+
+/// @summary Atomically sets status flags on an element and replaces its lock count.
+/// @param status The packed element status to update.
+/// @param set_flags A combination of image_memory_flags_e to set.
+/// @param lock_count The new lock count.
+/// @return The packed element status value after the update.
+internal_function inline uint32_t image_memory_force_element_locks(std::atomic<uint32_t> &status, uint32_t set_flags, size_t lock_count)
+{
+    uint32_t old_status = status.load(std::memory_order_relaxed);
+    uint32_t new_status;
+    do
+    {
+        uint32_t flags  = image_memory_element_status_flags(old_status) | set_flags;
+        new_status      = image_memory_make_element_status(flags, lock_count);
+    } while (!status.compare_exchange_weak(old_status, new_status, std::memory_order_acq_rel, std::memory_order_relaxed));
+    return new_status;
+}
+
+/// @summary Determine the highest-resolution level of an element such that it and every lower-resolution level are resident.
+/// @param levels_resident The bitmask of resident levels, from image_memory_size_t::LevelsResident.
+/// @param level_count The number of levels in the mipmap chain.
+/// @return The zero-based index of the first level of the resident suffix, or level_count if the lowest-resolution level is not resident.
+internal_function inline size_t image_memory_first_resident_level(uint32_t levels_resident, size_t level_count)
+{
+    size_t first_level = level_count;
+    while (first_level > 0 && (levels_resident & (1U << (first_level - 1))) != 0)
+        first_level--;
+    return first_level;
+}
+
 /// @summary Calculate the size of a single image element (array item, frame, or cube face) stored in an uncompressed, unencoded form.
 /// @param def The image definition.
 /// @param page_size The size of a system virtual memory page, in bytes.
@@ -230,6 +403,168 @@ internal_function size_t image_memory_element_size(image_definition_t const *def
     return align_up(s_base, page_size);
 }
 
+/// @summary Commits a range of pages within an image's reserved address space, taking physical memory from the image's preferred NUMA node.
+/// @param addr The memory allocation record for the image.
+/// @param address The address of the first byte to commit.
+/// @param size The number of bytes to commit.
+/// @return The address of the committed range, or NULL.
+internal_function inline void* image_memory_commit(image_memory_addr_t const &addr, void *address, size_t size)
+{
+    return win32_numa_virtual_alloc(address, size, MEM_COMMIT, PAGE_READWRITE, addr.NumaNode);
+}
+
+/// @summary Atomically adjusts the number of bytes committed for an image and for the image memory manager.
+/// Threads holding the ImageLock in shared mode may commit and decommit elements of the same image concurrently.
+/// @param mem The image memory manager that owns the image data.
+/// @param addr The memory allocation record for the image.
+/// @param delta The number of bytes committed (positive) or decommitted (negative).
+internal_function inline void image_memory_count_committed(image_memory_t *mem, image_memory_addr_t &addr, ptrdiff_t delta)
+{
+    InterlockedExchangeAddSizeT((SIZE_T volatile*) &addr.BytesCommitted, SIZE_T(delta));
+    mem->BytesCommitted.fetch_add(size_t(delta), std::memory_order_relaxed);
+}
+
+/// @summary Atomically adjusts the number of bytes of file data mapped for an image and for the image memory manager.
+/// @param mem The image memory manager that owns the image data.
+/// @param addr The memory allocation record for the image.
+/// @param delta The number of bytes mapped (positive) or unmapped (negative).
+internal_function inline void image_memory_count_mapped(image_memory_t *mem, image_memory_addr_t &addr, ptrdiff_t delta)
+{
+    InterlockedExchangeAddSizeT((SIZE_T volatile*) &addr.BytesMapped, SIZE_T(delta));
+    mem->BytesMapped.fetch_add(size_t(delta), std::memory_order_relaxed);
+}
+
+/// @summary Records a lock against an image from the NUMA node of the calling thread. 
+/// Under IMAGE_MEMORY_NUMA_POLICY_LOCKER, the image's preferred node is updated to be the node
+/// with the most locks; the new node applies to pages committed after the update.
+/// @param mem The image memory manager that owns the image data.
+/// @param image_index The zero-based index of the image in the image list.
+/// @param lock_count The number of locks being acquired.
+internal_function void image_memory_record_lock_node(image_memory_t *mem, size_t image_index, size_t lock_count)
+{
+    image_memory_addr_t &addr = mem->AddressList  [image_index];
+    image_memory_info_t &info = mem->AttributeList[image_index];
+    uint32_t             node = win32_numa_current_node();
+    if (info.NodeLocks == NULL || node >= mem->NumaNodeCount)
+    {   // not tracking locks, or the node of the current thread is unknown.
+        return;
+    }
+    info.NodeLocks[node] += uint32_t(lock_count);
+    if (info.NodeLocks[node] >= IMAGE_MEMORY_NODE_LOCK_MAX)
+    {   // age the counters so that changes in access pattern are picked up.
+        for (size_t i = 0, n = mem->NumaNodeCount; i < n; ++i)
+        {
+            info.NodeLocks[i] >>= 1;
+        }
+    }
+    if (addr.NumaNode >= mem->NumaNodeCount || info.NodeLocks[node] > info.NodeLocks[addr.NumaNode])
+    {   // this node now locks the image most often.
+        addr.NumaNode = node;
+    }
+}
+
+/// @summary Retrieve the address of the first byte of data for an image element, which is either within the reserved range or within a mapped file view.
+/// @param addr The memory allocation record for the image.
+/// @param info The attribute record for the image.
+/// @param element The zero-based index of the element.
+/// @return The address of the element data. The memory is not guaranteed to be committed.
+internal_function inline uint8_t* image_memory_element_address(image_memory_addr_t const &addr, image_memory_info_t const &info, size_t element)
+{
+    if (info.ElementViews != NULL && info.ElementViews[element].ViewBase != NULL)
+    {   // the element data is a view of the source file.
+        return info.ElementViews[element].ElementData;
+    }
+    return ((uint8_t*) addr.BaseAddress) + (info.BytesPerElement * element);
+}
+
+/// @summary Populates the level and storage descriptors returned when an entire image element is locked or pinned.
+/// @param info The attribute record for the image.
+/// @param element The zero-based index of the element.
+/// @param element_flags The image_memory_flags_e of the element.
+/// @param levels If non-NULL, points to an array of LevelCount items to populate with information about the element mipmap levels.
+/// @param storage On return, this structure is populated with image storage attributes for the image element.
+internal_function void image_memory_describe_element(image_memory_info_t const &info, size_t element, uint32_t element_flags, dds_level_desc_t *levels, image_storage_info_t &storage)
+{
+    size_t first_block = info.LevelCount * element;
+    for (size_t i = 0, n = info.LevelCount; levels != NULL && i < n; ++i)
+    {
+        levels[i].Index           = i;
+        levels[i].Width           = info.LevelDimension[i].LevelWidth;
+        levels[i].Height          = info.LevelDimension[i].LevelHeight;
+        levels[i].Slices          = info.LevelDimension[i].LevelSlices;
+        levels[i].BytesPerElement = info.LevelDimension[i].BytesPerElement;
+        levels[i].BytesPerRow     = info.LevelDimension[i].BytesPerRow;
+        levels[i].BytesPerSlice   = info.LevelDimension[i].BytesPerSlice;
+        levels[i].DataSize        = info.ImageBlocks[first_block+i].StoredSize;
+        levels[i].Format          = info.Format;
+    }
+    storage.ImageFormat   = info.Format;
+    storage.Compression   = info.Compression;
+    storage.Encoding      = info.Encoding;
+    storage.AccessType    = info.AccessType;
+    storage.ElementCount  = 1;
+    storage.LevelCount    = info.LevelCount;
+    storage.BytesReserved =(element_flags & IMAGE_MEMORY_FLAG_MAPPED) ? info.ElementCommit[element].BytesUsed : info.ElementCommit[element].BytesCommitted;
+}
+
+/// @summary Unmaps the file view backing an image element, if any. The element status flags are not modified.
+/// @param mem The image memory manager that owns the image data.
+/// @param image_index The zero-based index of the image in the image list.
+/// @param element The zero-based index of the element to unmap.
+internal_function void image_memory_unmap_element(image_memory_t *mem, size_t image_index, size_t element)
+{
+    image_memory_addr_t &addr = mem->AddressList  [image_index];
+    image_memory_info_t &info = mem->AttributeList[image_index];
+    if (info.ElementViews != NULL && info.ElementViews[element].ViewBase != NULL)
+    {
+        image_memory_view_t &view = info.ElementViews[element];
+        UnmapViewOfFile(view.ViewBase);
+        image_memory_count_mapped(mem, addr, -ptrdiff_t(view.ViewSize));
+        view.ViewBase     = NULL;
+        view.ElementData  = NULL;
+        view.ViewSize     = 0;
+    }
+}
+
+/// @summary Waits for the background committer to finish with an element, if a pre-fault request is outstanding.
+/// This must be called before the element pages are written, decommitted or released.
+/// @param info The attribute record for the image.
+/// @param element The zero-based index of the element.
+internal_function inline void image_memory_wait_prefault(image_memory_info_t const &info, size_t element)
+{
+    image_committer_wait(info.ElementStatus[element], IMAGE_MEMORY_FLAG_PREFAULT << IMAGE_ELEMENT_STATUS_SHIFT);
+}
+
+/// @summary Asks the background committer to commit and pre-fault the pages of an element that is about to be written.
+/// The pages are counted as committed, and the element is marked committed but not yet written, so that it can be 
+/// evicted like any other element until the write starts, but can't be pinned. Nothing is done if no committer is attached, or if the element already 
+/// has backing storage.
+/// @param mem The image memory manager that owns the image data.
+/// @param image_index The zero-based index of the image in the image list.
+/// @param element The zero-based index of the element to pre-fault.
+internal_function void image_memory_prefault_element(image_memory_t *mem, size_t image_index, size_t element)
+{
+    image_memory_addr_t &addr = mem->AddressList  [image_index];
+    image_memory_info_t &info = mem->AttributeList[image_index];
+    if (mem->Committer == NULL || element >= info.ElementCount)
+    {   // there's no committer, or the element doesn't exist.
+        return;
+    }
+    image_memory_size_t &size = info.ElementCommit[element];
+    uint32_t            flags = image_memory_element_status_flags(info.ElementStatus[element].load(std::memory_order_acquire));
+    if ((flags & (IMAGE_MEMORY_FLAG_COMMITTED | IMAGE_MEMORY_FLAG_MAPPED | IMAGE_MEMORY_FLAG_PREFAULT | IMAGE_MEMORY_FLAG_WRITING)) != 0 || size.BytesCommitted != 0)
+    {   // the element already has storage, is being written, or a request is outstanding.
+        return;
+    }
+    // the pages are counted as committed now; writers wait on the flag before touching them.
+    uint8_t   *element_data = ((uint8_t*) addr.BaseAddress) + (info.BytesPerElement * element);
+    size.BytesCommitted     = info.BytesPerElement;
+    size.BytesPrefaulted    = info.BytesPerElement;
+    image_memory_count_committed(mem, addr, ptrdiff_t(info.BytesPerElement));
+    image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_COMMITTED | IMAGE_MEMORY_FLAG_WRITING | IMAGE_MEMORY_FLAG_PREFAULT, IMAGE_MEMORY_FLAG_NONE);
+    image_committer_post(mem->Committer, element_data, info.BytesPerElement, addr.NumaNode, &info.ElementStatus[element], IMAGE_MEMORY_FLAG_PREFAULT << IMAGE_ELEMENT_STATUS_SHIFT);
+}
+
 /// @summary Evicts an element, decommitting its memory, if the element is marked for eviction and there are no active locks.
 /// @param mem The image memory manager that owns the image data.
 /// @param image_index The zero-based index of the image in the image list.
@@ -238,39 +573,93 @@ internal_function void image_memory_process_pending_evict(image_memory_t *mem, s
 {
     image_memory_addr_t &addr = mem->AddressList  [image_index];
     image_memory_info_t &info = mem->AttributeList[image_index];
-    uint32_t            flags = image_memory_element_status_flags(info.ElementStatus[element]);
-    size_t              locks = image_memory_element_lock_count  (info.ElementStatus[element]);
-    if ((flags  & IMAGE_MEMORY_FLAG_EVICT    ) != 0 && 
-        (flags  & IMAGE_MEMORY_FLAG_COMMITTED) != 0 && 
-        (locks == 0))
-    {
-        flags &=~(IMAGE_MEMORY_FLAG_EVICT | IMAGE_MEMORY_FLAG_COMMITTED);
+    uint32_t            flags = IMAGE_MEMORY_FLAG_NONE;
+    if (info.ElementPins[element].load(std::memory_order_acquire) != 0)
+    {   // a forced eviction may have discarded the locks of the owning thread, but never those of a pin.
+        return;
+    }
+    if (image_memory_try_begin_evict(info.ElementStatus[element], flags))
+    {   // the status is already updated; pinning threads now see the element as non-resident.
+        if (flags & IMAGE_MEMORY_FLAG_MAPPED)
+        {   // the data can be mapped again cheaply, so it isn't offered to the compressed tier.
+            image_memory_unmap_element(mem, image_index, element);
+            return;
+        }
         uint8_t    *element_data    =((uint8_t*)addr.BaseAddress) + (info.BytesPerElement * element);
+        if (mem->Tier != NULL && info.ElementCommit[element].BytesUsed > 0 && (flags & IMAGE_MEMORY_FLAG_WRITING) == 0)
+        {   // keep a compressed copy, if possible, so a reload doesn't have to go back to disk.
+            AcquireSRWLockExclusive(&mem->TierLock);
+            image_tier_admit(mem->Tier, info.ImageId, element, info.Format, element_data, info.ElementCommit[element].BytesUsed);
+            ReleaseSRWLockExclusive(&mem->TierLock);
+        }
+        image_memory_wait_prefault(info, element);
         VirtualFree(element_data, info.BytesPerElement, MEM_DECOMMIT);
-        addr.BytesCommitted        -= info.ElementCommit[element].BytesCommitted;
-        mem->BytesCommitted        -= info.ElementCommit[element].BytesCommitted;
-        info.ElementStatus[element] = image_memory_make_element_status(flags, locks);
+        image_memory_count_committed(mem, addr, -ptrdiff_t(info.ElementCommit[element].BytesCommitted));
         info.ElementCommit[element].BytesCommitted = 0;
+        info.ElementCommit[element].BytesPrefaulted= 0;
     }
 }
 
+/// @summary Marks an element for eviction, discarding all locks except those held by pins. If the element is 
+/// pinned, it is evicted by image_memory_update() after the last pin is released. The caller must hold the 
+/// ImageLock in exclusive mode, so that no pin can be acquired or released during the update.
+/// @param mem The image memory manager that owns the image data.
+/// @param image_index The zero-based index of the image in the image list.
+/// @param element The zero-based index of the element to evict.
+/// @return true if the element is not pinned.
+internal_function bool image_memory_force_evict(image_memory_t *mem, size_t image_index, size_t element)
+{
+    image_memory_info_t &info = mem->AttributeList[image_index];
+    size_t              pins  = size_t(info.ElementPins[element].load(std::memory_order_relaxed));
+    image_memory_force_element_locks(info.ElementStatus[element], IMAGE_MEMORY_FLAG_EVICT, pins * info.LevelCount);
+    return (pins == 0);
+}
+
 /// @summary Drops an image if the image is marked to be dropped and there are no active locks.
 /// @param mem The image memory manager that owns the image data.
 /// @param image_index The zero-based index of the image within the image list.
 internal_function void image_memory_process_pending_drop(image_memory_t *mem, size_t image_index)
-{
-    image_memory_addr_t &addr = mem->AddressList  [image_index];
-    image_memory_info_t &info = mem->AttributeList[image_index];
-    // process any pending drop if all elements are unlocked.
-    if ((addr.BytesCommitted == 0) && (addr.ImageStatus & IMAGE_MEMORY_FLAG_DROP) != 0)
-    {   // save the identifiers of the image records we're working with.
+{   // the image lists may be reallocated by a reservation on another thread, so they're only read under the lock.
+    bool drop_pending;
+    AcquireSRWLockShared(&mem->ImageLock);
+    {   // process any pending drop if all elements are unlocked.
+        image_memory_addr_t const &addr = mem->AddressList[image_index];
+        drop_pending = (addr.BytesCommitted == 0) && (addr.BytesMapped == 0) && (addr.ImageStatus & IMAGE_MEMORY_FLAG_DROP) != 0;
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    if (drop_pending)
+    {   // pinning threads must not read the image lists while records are moved.
+        AcquireSRWLockExclusive(&mem->ImageLock);
+        image_memory_addr_t &addr = mem->AddressList  [image_index];
+        image_memory_info_t &info = mem->AttributeList[image_index];
+        if (addr.BytesCommitted != 0 || addr.BytesMapped != 0)
+        {   // an element was locked again before the lock was acquired.
+            ReleaseSRWLockExclusive(&mem->ImageLock);
+            return;
+        }
+        // save the identifiers of the image records we're working with.
         size_t    last_index  = mem->ImageCount - 1;
         uintptr_t this_id     = info.ImageId;
         uintptr_t last_id     = mem->AttributeList[last_index].ImageId;
+        // any compressed copies of the image elements are no longer needed.
+        if (mem->Tier != NULL)
+        {
+            AcquireSRWLockExclusive(&mem->TierLock);
+            image_tier_discard_image(mem->Tier, this_id);
+            ReleaseSRWLockExclusive(&mem->TierLock);
+        }
+        // the committer may still be touching pages of elements that were never written.
+        for (size_t i = 0, n = info.ElementCount; i < n; ++i)
+        {
+            image_memory_wait_prefault(info, i);
+        }
         // free internal descriptor memory for the image.
+        free(info.ElementViews);   info.ElementViews   = NULL;
+        free(info.NodeLocks);      info.NodeLocks      = NULL;
         free(info.ImageBlocks);    info.ImageBlocks    = NULL;
         free(info.LevelDimension); info.LevelDimension = NULL; info.LevelCount   = 0;
         free(info.ElementCommit);  info.ElementCommit  = NULL;
+        free(info.ElementPins);    info.ElementPins    = NULL;
         free(info.ElementStatus);  info.ElementStatus  = NULL; info.ElementCount = 0;
         // decommit and release the entire reserved range for the image.
         VirtualFree(addr.BaseAddress, 0, MEM_RELEASE);
@@ -289,6 +678,7 @@ internal_function void image_memory_process_pending_drop(image_memory_t *mem, si
         // delete the removed item from the image ID => index table.
         id_table_remove(&mem->ImageIds, this_id, NULL);
         mem->ImageCount--;
+        ReleaseSRWLockExclusive(&mem->ImageLock);
     }
 }
 
@@ -379,7 +769,9 @@ public_function void image_definition_free(image_definition_t *def)
 /// @summary Initializes a new image memory manager.
 /// @param mem The image memory manager.
 /// @param expected_image_count The maximum number of images expected to be loaded at any one time.
-public_function void image_memory_create(image_memory_t *mem, size_t expected_image_count)
+/// @param numa_policy One of image_memory_numa_policy_e specifying how image memory is placed on NUMA systems.
+/// @param numa_node The default NUMA node for images reserved without a node hint, or NUMA_NO_PREFERRED_NODE.
+public_function void image_memory_create(image_memory_t *mem, size_t expected_image_count, int numa_policy=IMAGE_MEMORY_NUMA_POLICY_HINT, uint32_t numa_node=NUMA_NO_PREFERRED_NODE)
 {   // retrieve the system page size and allocation granularity.
     SYSTEM_INFO sysinfo = {};
     GetNativeSystemInfo(&sysinfo);
@@ -391,8 +783,20 @@ public_function void image_memory_create(image_memory_t *mem, size_t expected_im
     size_t bucket_count = expected_image_count / IMAGE_MEMORY_BUCKET_SIZE;
     mem->BytesReserved  = 0;
     mem->BytesCommitted = 0;
+    mem->BytesMapped    = 0;
     mem->PageSize       =(size_t) sysinfo.dwPageSize;
     mem->Granularity    =(size_t) sysinfo.dwAllocationGranularity;
+    mem->RowAlignment   = 1;
+
+    mem->NumaPolicy     = numa_policy;
+    mem->NumaNode       = numa_node;
+    mem->NumaNodeCount  = win32_numa_node_count();
+    mem->Tier           = NULL;
+    mem->Committer      = NULL;
+    mem->EvictPending.store(0, std::memory_order_relaxed);
+    InitializeSRWLock(&mem->ImageLock);
+    InitializeSRWLock(&mem->WriterLock);
+    InitializeSRWLock(&mem->TierLock);
 
     mem->ImageCount     = 0;
     mem->ImageCapacity  = 0;
@@ -411,14 +815,22 @@ public_function void image_memory_delete(image_memory_t *mem)
 {   // decommit and release all reserved memory immediately.
     for (size_t i = 0, n = mem->ImageCount; i < n; ++i)
     {
+        for (size_t j = 0, m = mem->AttributeList[i].ElementCount; j < m; ++j)
+        {   // unmap any file views backing image elements, and wait for any pre-faulting to finish.
+            image_memory_unmap_element(mem, i, j);
+            image_memory_wait_prefault(mem->AttributeList[i], j);
+        }
         VirtualFree(mem->AddressList[i].BaseAddress, 0, MEM_RELEASE);
     }
     // free the image list data.
     for (size_t i = 0, n = mem->ImageCount; i < n; ++i)
     {
+        free(mem->AttributeList[i].ElementViews);
+        free(mem->AttributeList[i].NodeLocks);
         free(mem->AttributeList[i].ImageBlocks);
         free(mem->AttributeList[i].LevelDimension);
         free(mem->AttributeList[i].ElementCommit);
+        free(mem->AttributeList[i].ElementPins);
         free(mem->AttributeList[i].ElementStatus);
     }
     id_table_delete(&mem->ImageIds);
@@ -427,6 +839,7 @@ public_function void image_memory_delete(image_memory_t *mem)
     // clear counts and NULL pointers.
     mem->BytesReserved  = 0;
     mem->BytesCommitted = 0;
+    mem->BytesMapped    = 0;
     mem->ImageCount     = 0;
     mem->ImageCapacity  = 0;
     mem->AddressList    = NULL;
@@ -442,6 +855,7 @@ public_function void image_memory_delete(image_memory_t *mem)
 public_function bool image_memory_storage_info(image_memory_t *mem, uintptr_t image_id, dds_level_desc_t &desc, image_storage_info_t &storage)
 {
     size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds , image_id, &image_index))
     {   // copy the image information into the output structure.
         image_memory_addr_t   &addr = mem->AddressList  [image_index];
@@ -463,6 +877,7 @@ public_function bool image_memory_storage_info(image_memory_t *mem, uintptr_t im
         storage.LevelCount    = info.LevelCount;
         storage.BytesReserved = addr.BytesReserved;
         storage.BaseAddress   = addr.BaseAddress;
+        ReleaseSRWLockShared(&mem->ImageLock);
         return true;
     }
     else
@@ -484,6 +899,7 @@ public_function bool image_memory_storage_info(image_memory_t *mem, uintptr_t im
         storage.LevelCount    = 0;
         storage.BytesReserved = 0;
         storage.BaseAddress   = NULL;
+        ReleaseSRWLockShared(&mem->ImageLock);
         return false;
     }
 }
@@ -498,6 +914,7 @@ public_function bool image_memory_storage_info(image_memory_t *mem, uintptr_t im
 public_function bool image_memory_element_info(image_memory_t *mem, uintptr_t image_id, size_t element, dds_level_desc_t &desc, image_storage_info_t &storage)
 {
     size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds , image_id, &image_index))
     {   // copy the image information into the output structure.
         image_memory_addr_t   &addr = mem->AddressList  [image_index];
@@ -518,7 +935,8 @@ public_function bool image_memory_element_info(image_memory_t *mem, uintptr_t im
         storage.ElementCount  = info.ElementCount;
         storage.LevelCount    = info.LevelCount;
         storage.BytesReserved = info.BytesPerElement;
-        storage.BaseAddress   =((uint8_t*) addr.BaseAddress) + (info.BytesPerElement * element);
+        storage.BaseAddress   = image_memory_element_address(addr, info, element);
+        ReleaseSRWLockShared(&mem->ImageLock);
         return true;
     }
     else
@@ -540,6 +958,7 @@ public_function bool image_memory_element_info(image_memory_t *mem, uintptr_t im
         storage.LevelCount    = 0;
         storage.BytesReserved = 0;
         storage.BaseAddress   = NULL;
+        ReleaseSRWLockShared(&mem->ImageLock);
         return false;
     }
 }
@@ -555,6 +974,7 @@ public_function bool image_memory_element_info(image_memory_t *mem, uintptr_t im
 public_function bool image_memory_level_info(image_memory_t *mem, uintptr_t image_id, size_t element, size_t level, dds_level_desc_t &desc, image_storage_info_t &storage)
 {
     size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds , image_id, &image_index))
     {   // copy the image information into the output structure.
         image_memory_addr_t   &addr = mem->AddressList  [image_index];
@@ -576,7 +996,8 @@ public_function bool image_memory_level_info(image_memory_t *mem, uintptr_t imag
         storage.ElementCount  = info.ElementCount;
         storage.LevelCount    = info.LevelCount;
         storage.BytesReserved = info.BytesPerElement;
-        storage.BaseAddress   =((uint8_t*) addr.BaseAddress) + (info.BytesPerElement * element) + info.ImageBlocks[block].ByteOffset;
+        storage.BaseAddress   = image_memory_element_address(addr, info, element) + info.ImageBlocks[block].ByteOffset;
+        ReleaseSRWLockShared(&mem->ImageLock);
         return true;
     }
     else
@@ -598,22 +1019,25 @@ public_function bool image_memory_level_info(image_memory_t *mem, uintptr_t imag
         storage.LevelCount    = 0;
         storage.BytesReserved = 0;
         storage.BaseAddress   = NULL;
+        ReleaseSRWLockShared(&mem->ImageLock);
         return false;
     }
 }
 
-/// @summary Reserves process address space for image storage. The image may be stored compressed or encoded.
+/// @summary Reserves process address space for image storage and creates the image record. The image may be stored compressed or encoded.
 /// @param mem The image memory manager.
 /// @param element_size The maximum size of a single array item or frame, in bytes. The actual size may be less than this value.
 /// @param def Image dimension attributes used to deteremine how much address space to reserve.
 /// @param encoding One of image_encoding_e specifying the pixel data encoding.
 /// @param access_type One of image_access_type_e specifying how the image data will be accessed.
-/// @param definition_queue The unbounded MPSC queue to post the image attributes to.
-/// @param thread_alloc The FIFO node allocator used to write to the target queue from the calling thread.
+/// @param numa_node The NUMA node from which image memory should be committed, or NUMA_NO_PREFERRED_NODE to use the manager default.
+/// @param raw_layout Specify true to initialize the level blocks and element sizes from the level sizes in the definition, for data stored without compression or encoding.
 /// @return ERROR_SUCCESS, ERROR_ALREADY_EXISTS, or ERROR_OUTOFMEMORY.
-public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t element_size, image_definition_t const *def, int encoding, int access_type, image_definition_queue_t *definition_queue=NULL, image_definition_alloc_t *thread_alloc=NULL)
-{
+internal_function uint32_t image_memory_reserve_record(image_memory_t *mem, size_t element_size, image_definition_t const *def, int encoding, int access_type, uint32_t numa_node, bool raw_layout)
+{   // parsers on several threads may define images at the same time.
+    // the lookup, slot assignment and list growth happen under WriterLock.
     size_t image_index;
+    AcquireSRWLockExclusive(&mem->WriterLock);
     if (id_table_get(&mem->ImageIds, def->ImageId, &image_index))
     {   // this image is already defined. is this definition identical?
         image_memory_info_t const &existing = mem->AttributeList[image_index];
@@ -624,19 +1048,23 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t
                  encoding       == existing.Encoding                       && 
             def->Width          == existing.LevelDimension[0].LevelWidth   && 
             def->Height         == existing.LevelDimension[0].LevelHeight  && 
-            def->SliceCount     == existing.LevelDimension[0].LevelSlices)
+            def->SliceCount     == existing.LevelDimension[0].LevelSlices  && 
+            def->LevelInfo[0].BytesPerRow == existing.LevelDimension[0].BytesPerRow)
         {   // the definitions are identical; we're done.
+            ReleaseSRWLockExclusive(&mem->WriterLock);
             return ERROR_SUCCESS;
         }
         // else, the image exists with non-resolvable differences.
         // even if it's only the element count that changes, buffers 
         // could be locked which would prevent relocation.
+        ReleaseSRWLockExclusive(&mem->WriterLock);
         return ERROR_ALREADY_EXISTS;
     }
     else
     {   // this image is not currently known, so create a new record.
         if (mem->ImageCount  == mem->ImageCapacity)
-        {   // grow the capacity of the image list.
+        {   // grow the capacity of the image list. the lists may move.
+            AcquireSRWLockExclusive(&mem->ImageLock);
             size_t old_amount = mem->ImageCapacity;
             size_t new_amount = calculate_capacity(old_amount, old_amount+1, 1024, 1024);
             image_memory_addr_t *new_addr =(image_memory_addr_t*) realloc(mem->AddressList  , new_amount * sizeof(image_memory_addr_t));
@@ -644,13 +1072,19 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t
             if (new_addr != NULL) mem->AddressList   = new_addr;
             if (new_info != NULL) mem->AttributeList = new_info;
             if (new_addr != NULL && new_info != NULL)  mem->ImageCapacity = new_amount;
-            else return ERROR_OUTOFMEMORY;
+            else
+            {   // the lists are left at their current capacity.
+                ReleaseSRWLockExclusive(&mem->ImageLock);
+                ReleaseSRWLockExclusive(&mem->WriterLock);
+                return ERROR_OUTOFMEMORY;
+            }
 
             // initialize the newly allocated elements.
             size_t new_index  = old_amount;
             size_t new_count  = new_amount - old_amount;
             memset(&mem->AddressList  [new_index], 0, new_count * sizeof(image_memory_addr_t));
             memset(&mem->AttributeList[new_index], 0, new_count * sizeof(image_memory_info_t));
+            ReleaseSRWLockExclusive(&mem->ImageLock);
         }
         // reserve the slot for the new image.
         image_index = mem->ImageCount;
@@ -665,14 +1099,22 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t
     size_t element_reserved   = align_up(element_size, mem->PageSize);
     size_t reserve_bytes      = def->ElementCount * element_reserved;
     void  *reserve_buffer     = VirtualAlloc(NULL , reserve_bytes, MEM_RESERVE, PAGE_READWRITE);
-    uint32_t              *es =(uint32_t            *) malloc(def->ElementCount * sizeof(uint32_t));
+    std::atomic<uint32_t> *es =(std::atomic<uint32_t>*)malloc(def->ElementCount * sizeof(std::atomic<uint32_t>));
+    std::atomic<uint32_t> *ep =(std::atomic<uint32_t>*)malloc(def->ElementCount * sizeof(std::atomic<uint32_t>));
     image_memory_size_t   *ec =(image_memory_size_t *) malloc(def->ElementCount * sizeof(image_memory_size_t));
     image_memory_level_t  *la =(image_memory_level_t*) malloc(def->LevelCount   * sizeof(image_memory_level_t));
     image_memory_block_t  *ib =(image_memory_block_t*) malloc(def->ElementCount * def->LevelCount * sizeof(image_memory_block_t));
-    if (reserve_buffer == NULL || es == NULL || ec == NULL || la == NULL || ib == NULL)
+    uint32_t              *nl = NULL;
+    if (mem->NumaPolicy == IMAGE_MEMORY_NUMA_POLICY_LOCKER && mem->NumaNodeCount > 1)
+    {   // per-node lock counters are only needed if the image can follow its lockers.
+        nl =(uint32_t*) malloc(mem->NumaNodeCount * sizeof(uint32_t));
+        if (nl != NULL) memset(nl, 0, mem->NumaNodeCount * sizeof(uint32_t));
+    }
+    if (reserve_buffer == NULL || es == NULL || ep == NULL || ec == NULL || la == NULL || ib == NULL)
     {   // memory allocation failed. 
-        free(ib); free(la); free(ec); free(es); 
+        free(nl); free(ib); free(la); free(ec); free(ep); free(es); 
         VirtualFree(reserve_buffer, 0, MEM_RELEASE);
+        ReleaseSRWLockExclusive(&mem->WriterLock);
         return ERROR_OUTOFMEMORY;
     }
 
@@ -680,7 +1122,9 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t
     addr.BaseAddress          = reserve_buffer;
     addr.BytesReserved        = reserve_bytes;
     addr.BytesCommitted       = 0;
+    addr.BytesMapped          = 0;
     addr.ImageStatus          = IMAGE_MEMORY_FLAG_NONE;
+    addr.NumaNode             =(numa_node != NUMA_NO_PREFERRED_NODE) ? numa_node : mem->NumaNode;
     
     // initialize the image attribute block.
     info.ImageId              = def->ImageId;
@@ -695,12 +1139,21 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t
     info.BytesPerElement      = element_reserved;
     info.BytesPerElementMax   = element_max_used;
     info.ElementStatus        = es;
+    info.ElementPins          = ep;
     info.ElementCommit        = ec;
     info.LevelDimension       = la;
     info.ImageBlocks          = ib;
+    info.NodeLocks            = nl;
+    info.ElementViews         = NULL;
+    info.DDSHeader            = def->DDSHeader;
+    info.DX10Header           = def->DX10Header;
 
     // element status start out as zero (no locks, no commits):
-    memset(info.ElementStatus, 0, def->ElementCount * sizeof(uint32_t));
+    for (size_t i = 0, n = def->ElementCount; i < n; ++i)
+    {
+        info.ElementStatus[i].store(0, std::memory_order_relaxed);
+        info.ElementPins  [i].store(0, std::memory_order_relaxed);
+    }
 
     // element commit starts out as zero (no bytes used, no bytes committed):
     memset(info.ElementCommit, 0, def->ElementCount * sizeof(image_memory_size_t));
@@ -719,17 +1172,47 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t
     // block (offset, size) pairs start out as zero (undefined).
     memset(info.ImageBlocks, 0 , def->ElementCount * def->LevelCount * sizeof(image_memory_block_t));
 
+    // unencoded levels are stored back-to-back, so the layout is known up front.
+    for (size_t element_index = 0, block_index = 0; raw_layout && element_index < def->ElementCount; ++element_index)
+    {
+        size_t      level_offset= 0; // byte offset relative to the start of the element.
+        for (size_t level_index = 0, level_count = def->LevelCount; level_index < level_count; ++level_index, ++block_index)
+        {
+            info.ImageBlocks[block_index].ByteOffset = level_offset;
+            info.ImageBlocks[block_index].StoredSize = def->LevelInfo[level_index].DataSize;
+            level_offset += def->LevelInfo[level_index].DataSize;
+        }
+        info.ElementCommit[element_index].BytesUsed  = level_offset;
+    }
+
     // make the image visible to the rest of the system.
+    AcquireSRWLockExclusive(&mem->ImageLock);
     id_table_put(&mem->ImageIds, def->ImageId, image_index);
     mem->BytesReserved += reserve_bytes;
     mem->ImageCount++;
+    ReleaseSRWLockExclusive(&mem->ImageLock);
+    ReleaseSRWLockExclusive(&mem->WriterLock);
+    return ERROR_SUCCESS;
+}
 
-    // publish the image definition, if requested.
-    if (definition_queue != NULL)
-    {
+/// @summary Reserves process address space for image storage. The image may be stored compressed or encoded.
+/// @param mem The image memory manager.
+/// @param element_size The maximum size of a single array item or frame, in bytes. The actual size may be less than this value.
+/// @param def Image dimension attributes used to deteremine how much address space to reserve.
+/// @param encoding One of image_encoding_e specifying the pixel data encoding.
+/// @param access_type One of image_access_type_e specifying how the image data will be accessed.
+/// @param definition_queue The unbounded MPSC queue to post the image attributes to.
+/// @param thread_alloc The FIFO node allocator used to write to the target queue from the calling thread.
+/// @param numa_node The NUMA node from which image memory should be committed, or NUMA_NO_PREFERRED_NODE to use the manager default.
+/// @return ERROR_SUCCESS, ERROR_ALREADY_EXISTS, or ERROR_OUTOFMEMORY.
+public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t element_size, image_definition_t const *def, int encoding, int access_type, image_definition_queue_t *definition_queue=NULL, image_definition_alloc_t *thread_alloc=NULL, uint32_t numa_node=NUMA_NO_PREFERRED_NODE)
+{
+    uint32_t result = image_memory_reserve_record(mem, element_size, def, encoding, access_type, numa_node, false);
+    if (result == ERROR_SUCCESS && definition_queue != NULL)
+    {   // publish the image definition.
         image_definition_post(def, definition_queue, thread_alloc);
     }
-    return ERROR_SUCCESS;
+    return result;
 }
 
 /// @summary Reserves address space for all elements of an image stored without compression or encoding.
@@ -738,33 +1221,16 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, size_t
 /// @param access_type One of image_access_type_e specifying the storage access type of the image data.
 /// @param definition_queue The unbounded MPSC queue to post the image attributes to.
 /// @param thread_alloc The FIFO node allocator used to write to the target queue from the calling thread.
+/// @param numa_node The NUMA node from which image memory should be committed, or NUMA_NO_PREFERRED_NODE to use the manager default.
 /// @return ERROR_SUCCESS or a system error code.
-public_function uint32_t image_memory_reserve_image(image_memory_t *mem, image_definition_t const *def, int access_type, image_definition_queue_t *definition_queue=NULL, image_definition_alloc_t *thread_alloc=NULL)
-{
-    size_t   image_index  = mem->ImageCount;
-    size_t   block_index  = 0;
+public_function uint32_t image_memory_reserve_image(image_memory_t *mem, image_definition_t const *def, int access_type, image_definition_queue_t *definition_queue=NULL, image_definition_alloc_t *thread_alloc=NULL, uint32_t numa_node=NUMA_NO_PREFERRED_NODE)
+{   // the block layout is written before the image becomes visible, while the slot is still owned by this thread.
+    // an identical existing definition is accepted, and its layout is left alone.
     size_t   element_used = 0;
     size_t   element_size = image_memory_element_size (def, mem->PageSize, element_used);
-    uint32_t make_result  = image_memory_reserve_image(mem, element_used, def, IMAGE_ENCODING_RAW, access_type, NULL, NULL);
-    if (SUCCEEDED(make_result))
-    {   // initialize the block offsets and sizes.
-        image_memory_info_t &info = mem->AttributeList[image_index];
-        for (size_t element_index = 0, element_count = def->ElementCount; element_index < element_count; element_index++)
-        {
-            size_t      level_offset= 0; // byte offset relative to the start of the element.
-            for (size_t level_index = 0, level_count = def->LevelCount; level_index < level_count; ++level_index, ++block_index)
-            {
-                info.ImageBlocks[block_index].ByteOffset = level_offset;
-                info.ImageBlocks[block_index].StoredSize = def->LevelInfo[level_index].DataSize;
-                level_offset += def->LevelInfo[level_index].DataSize;
-            }
-            info.ElementCommit[element_index].BytesUsed  = level_offset;
-            info.ElementCommit[element_index].BytesCommitted = 0;
-        }
-
-    }
-    if (definition_queue != NULL)
-    {
+    uint32_t make_result  = image_memory_reserve_record(mem, element_used, def, IMAGE_ENCODING_RAW, access_type, numa_node, true);
+    if (make_result == ERROR_SUCCESS && definition_queue != NULL)
+    {   // publish the image definition.
         image_definition_post(def, definition_queue, thread_alloc);
     }
     UNREFERENCED_PARAMETER(element_size);
@@ -780,59 +1246,51 @@ public_function uint32_t image_memory_reserve_image(image_memory_t *mem, image_d
 /// @return A pointer to the start of the image element data for miplevel 0, or NULL.
 public_function void* image_memory_lock_element(image_memory_t *mem, uintptr_t image_id, size_t element, dds_level_desc_t *levels, image_storage_info_t &storage)
 {
+    void  *lock_data = NULL;
     size_t image_index;
+    // the image lists may be reallocated by a reservation on another thread.
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t   &addr  = mem->AddressList  [image_index];
         image_memory_info_t   &info  = mem->AttributeList[image_index];
-        uint8_t       *element_data  = ((uint8_t*)  addr.BaseAddress) + (info.BytesPerElement * element);
-        uint32_t       element_flags = image_memory_element_status_flags(info.ElementStatus    [element]);
-        size_t         element_locks = image_memory_element_lock_count  (info.ElementStatus    [element]);
-        size_t           first_block = info.LevelCount * element;
+        uint8_t       *element_data  = image_memory_element_address(addr, info, element);
+        image_memory_wait_prefault(info, element);
+        uint32_t       element_flags = image_memory_element_status_flags(info.ElementStatus[element].load(std::memory_order_acquire));
         
         if ((element_flags & IMAGE_MEMORY_FLAG_COMMITTED) == 0)
         {   // the memory region hasn't been committed yet. do so now.
-            if (VirtualAlloc(element_data, info.ElementCommit[element].BytesUsed, MEM_COMMIT, PAGE_READWRITE) == NULL)
+            if (image_memory_commit(addr, element_data, info.ElementCommit[element].BytesUsed) == NULL)
             {   // unable to commit the memory region; the lock fails.
+                ReleaseSRWLockShared(&mem->ImageLock);
                 return NULL;
             }
+            if (mem->Tier != NULL)
+            {   // if the element was evicted into the compressed tier, restore it.
+                AcquireSRWLockExclusive(&mem->TierLock);
+                image_tier_restore(mem->Tier, image_id, element, element_data, info.ElementCommit[element].BytesUsed);
+                ReleaseSRWLockExclusive(&mem->TierLock);
+            }
             element_flags        = IMAGE_MEMORY_FLAG_COMMITTED;
+            image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_NONE, IMAGE_MEMORY_FLAG_EVICT);
             size_t commit_size   = align_up(info.ElementCommit[element].BytesUsed, mem->PageSize);
             info.ElementCommit[element].BytesCommitted = commit_size;
-            addr.BytesCommitted += commit_size;
-            mem->BytesCommitted += commit_size;
+            info.ElementCommit[element].BytesPrefaulted= 0;
+            image_memory_count_committed(mem, addr, ptrdiff_t(commit_size));
         }
         
         // update the packed element status with any new flags, and increase the lock count by the number of levels.
-        info.ElementStatus[element] = image_memory_make_element_status(element_flags, element_locks+info.LevelCount);
-
-        // populate the mip-level descriptors, if the caller wants that information.
-        for (size_t i = 0, n = info.LevelCount; levels != NULL && i < n; ++i)
-        {
-            levels[i].Index           = i;
-            levels[i].Width           = info.LevelDimension[i].LevelWidth;
-            levels[i].Height          = info.LevelDimension[i].LevelHeight;
-            levels[i].Slices          = info.LevelDimension[i].LevelSlices;
-            levels[i].BytesPerElement = info.LevelDimension[i].BytesPerElement;
-            levels[i].BytesPerRow     = info.LevelDimension[i].BytesPerRow;
-            levels[i].BytesPerSlice   = info.LevelDimension[i].BytesPerSlice;
-            levels[i].DataSize        = info.ImageBlocks[first_block+i].StoredSize;
-            levels[i].Format          = info.Format;
-        }
+        element_flags = image_memory_element_status_flags(image_memory_add_element_locks(info.ElementStatus[element], element_flags, info.LevelCount));
+        image_memory_record_lock_node(mem, image_index, info.LevelCount);
 
-        // populate the storage descriptor.
-        storage.ImageFormat   = info.Format;
-        storage.Compression   = info.Compression;
-        storage.Encoding      = info.Encoding;
-        storage.AccessType    = info.AccessType;
-        storage.ElementCount  = 1;
-        storage.LevelCount    = info.LevelCount;
-        storage.BytesReserved = info.ElementCommit[element].BytesCommitted;
+        // populate the mip-level and storage descriptors.
+        image_memory_describe_element(info, element, element_flags, levels, storage);
 
         // return a pointer to the start of the first level:
-        return element_data;
+        lock_data = element_data;
     }
-    else return NULL; // the image is not known.
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return lock_data;
 }
 
 /// @summary Lock a single mipmap level of an image element to read or write the data.
@@ -845,32 +1303,44 @@ public_function void* image_memory_lock_element(image_memory_t *mem, uintptr_t i
 /// @return A pointer to the start of the level data, or NULL.
 public_function void* image_memory_lock_level(image_memory_t *mem, uintptr_t image_id, size_t element, size_t level, dds_level_desc_t &desc, image_storage_info_t &storage)
 {
+    void  *lock_data = NULL;
     size_t image_index;
+    // the image lists may be reallocated by a reservation on another thread.
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t   &addr  = mem->AddressList   [image_index];
         image_memory_info_t   &info  = mem->AttributeList [image_index];
         image_memory_level_t  &attr  = info.LevelDimension[level];
         size_t          first_block  = info.LevelCount * element;
-        uint8_t       *element_data  = ((uint8_t*)  addr.BaseAddress) + (info.BytesPerElement * element);
-        uint32_t       element_flags = image_memory_element_status_flags(info.ElementStatus    [element]);
-        size_t         element_locks = image_memory_element_lock_count  (info.ElementStatus    [element]);
+        uint8_t       *element_data  = image_memory_element_address(addr, info, element);
+        image_memory_wait_prefault(info, element);
+        uint32_t       element_flags = image_memory_element_status_flags(info.ElementStatus[element].load(std::memory_order_acquire));
         
         if ((element_flags & IMAGE_MEMORY_FLAG_COMMITTED) == 0)
         {   // the memory region hasn't been committed yet. do so now.
-            if (VirtualAlloc(element_data, info.ElementCommit[element].BytesUsed, MEM_COMMIT, PAGE_READWRITE) == NULL)
+            if (image_memory_commit(addr, element_data, info.ElementCommit[element].BytesUsed) == NULL)
             {   // unable to commit the memory region; the lock fails.
+                ReleaseSRWLockShared(&mem->ImageLock);
                 return NULL;
             }
+            if (mem->Tier != NULL)
+            {   // if the element was evicted into the compressed tier, restore it.
+                AcquireSRWLockExclusive(&mem->TierLock);
+                image_tier_restore(mem->Tier, image_id, element, element_data, info.ElementCommit[element].BytesUsed);
+                ReleaseSRWLockExclusive(&mem->TierLock);
+            }
             element_flags        = IMAGE_MEMORY_FLAG_COMMITTED;
+            image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_NONE, IMAGE_MEMORY_FLAG_EVICT);
             size_t commit_size   = align_up(info.ElementCommit[element].BytesUsed, mem->PageSize);
             info.ElementCommit[element].BytesCommitted = commit_size;
-            addr.BytesCommitted += commit_size;
-            mem->BytesCommitted += commit_size;
+            info.ElementCommit[element].BytesPrefaulted= 0;
+            image_memory_count_committed(mem, addr, ptrdiff_t(commit_size));
         }
         
         // update the packed element status with any new flags, and increase the lock count by one.
-        info.ElementStatus[element] = image_memory_make_element_status(element_flags, element_locks+1);
+        image_memory_add_element_locks(info.ElementStatus[element], element_flags, 1);
+        image_memory_record_lock_node(mem, image_index, 1);
         
         // populate the mip-level descriptor.
         desc.Index            = level;
@@ -893,9 +1363,10 @@ public_function void* image_memory_lock_level(image_memory_t *mem, uintptr_t ima
         storage.BytesReserved = info.ImageBlocks[first_block+level].StoredSize;
         
         // return a pointer to the start of the requested level.
-        return (element_data  + info.ImageBlocks[first_block+level].ByteOffset);
+        lock_data = element_data + info.ImageBlocks[first_block+level].ByteOffset;
     }
-    else return NULL; // the image is not known.
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return lock_data;
 }
 
 /// @summary Unlock a single mipmap level of an image element.
@@ -906,15 +1377,14 @@ public_function void* image_memory_lock_level(image_memory_t *mem, uintptr_t ima
 public_function void image_memory_unlock_level(image_memory_t *mem, uintptr_t image_id, size_t element, size_t level)
 {
     size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_info_t &i   = mem->AttributeList[image_index];
-        uint32_t element_flags   = image_memory_element_status_flags(i.ElementStatus[element]);
-        size_t   element_locks   = image_memory_element_lock_count  (i.ElementStatus[element]);
-        if (element_locks > 0)     element_locks--;
-        i.ElementStatus[element] = image_memory_make_element_status (element_flags, element_locks);
+        image_memory_remove_element_locks(i.ElementStatus[element], 1);
         image_memory_process_pending_evict(mem, image_index, element);
     }
+    ReleaseSRWLockShared(&mem->ImageLock);
     UNREFERENCED_PARAMETER(level);
 }
 
@@ -925,24 +1395,18 @@ public_function void image_memory_unlock_level(image_memory_t *mem, uintptr_t im
 public_function void image_memory_unlock_element(image_memory_t *mem, uintptr_t image_id, size_t element)
 {
     size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_info_t &i = mem->AttributeList[image_index];
-        uint32_t element_flags = image_memory_element_status_flags(i.ElementStatus[element]);
-        size_t   element_locks = image_memory_element_lock_count  (i.ElementStatus[element]);
-        if (element_locks >= i.LevelCount)
-        {   // image_memory_lock_element increased the lock count by i.LevelCount.
-            element_locks -= i.LevelCount;
-        }
-        else
-        {   // clear the lock count. this may or may not indicate an error, as the
-            // user might want to just lock one level and then somewhere else unlock
-            // the entire element without keeping track of the level index...
-            element_locks  = 0;
-        }
-        i.ElementStatus[element] = image_memory_make_element_status(element_flags, element_locks);
+        // image_memory_lock_element increased the lock count by i.LevelCount. if fewer 
+        // locks are held, the count is cleared. this may or may not indicate an error, as 
+        // the user might want to just lock one level and then somewhere else unlock the 
+        // entire element without keeping track of the level index...
+        image_memory_remove_element_locks(i.ElementStatus[element], i.LevelCount);
         image_memory_process_pending_evict(mem, image_index, element);
     }
+    ReleaseSRWLockShared(&mem->ImageLock);
 }
 
 /// @summary Marks an image element (including all of its mipmap levels) for eviction.
@@ -950,10 +1414,13 @@ public_function void image_memory_unlock_element(image_memory_t *mem, uintptr_t
 /// @param image_id The application-defined image identifier.
 /// @param eptr The pointer to level 0 of the image element data.
 /// @param size The size of the image element data, in bytes (unused).
-/// @param force_evict Specify true to decommit the image element memory immediately, regardless of any outstanding locks.
+/// @param force_evict Specify true to decommit the image element memory immediately, regardless of any outstanding locks. If the element is pinned, it is evicted after the last pin is released.
 public_function void image_memory_evict_element(image_memory_t *mem, uintptr_t image_id, void *eptr, size_t size, bool force_evict=false)
 {
     size_t image_index;
+    // a forced eviction must see a stable pin count.
+    if (force_evict) AcquireSRWLockExclusive(&mem->ImageLock);
+    else AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t  &addr = mem->AddressList  [image_index];
@@ -961,12 +1428,23 @@ public_function void image_memory_evict_element(image_memory_t *mem, uintptr_t i
         uint8_t const        *elem =(uint8_t const*)    eptr;
         uint8_t const        *base =(uint8_t const*)    addr.BaseAddress;
         size_t       element_index =(elem   -  base) /  info.BytesPerElement;
-        uint32_t     element_flags = image_memory_element_status_flags(info.ElementStatus[element_index]);
-        size_t       element_locks = image_memory_element_lock_count  (info.ElementStatus[element_index]);
-        if (force_evict)   element_locks  = 0;
-        info.ElementStatus[element_index] = image_memory_make_element_status(element_flags | IMAGE_MEMORY_FLAG_EVICT, element_locks);
-        image_memory_process_pending_evict(mem, image_index, element_index);
+        if (elem < base || elem >= base + addr.BytesReserved)
+        {   // the pointer isn't within the reserved range; it may reference a mapped view.
+            for (element_index = 0; element_index < info.ElementCount; ++element_index)
+            {
+                if (info.ElementViews != NULL && info.ElementViews[element_index].ElementData == elem)
+                    break;
+            }
+        }
+        if (element_index < info.ElementCount)
+        {
+            if (force_evict) image_memory_force_evict(mem, image_index, element_index);
+            else image_memory_update_element_flags(info.ElementStatus[element_index], IMAGE_MEMORY_FLAG_EVICT, IMAGE_MEMORY_FLAG_NONE);
+            image_memory_process_pending_evict(mem, image_index, element_index);
+        }
     }
+    if (force_evict) ReleaseSRWLockExclusive(&mem->ImageLock);
+    else ReleaseSRWLockShared(&mem->ImageLock);
     UNREFERENCED_PARAMETER(size);
 }
 
@@ -974,19 +1452,22 @@ public_function void image_memory_evict_element(image_memory_t *mem, uintptr_t i
 /// @param mem The image memory manager.
 /// @param image_id The application-defined image identifier.
 /// @param element The zero-based index of the image element (array item or frame) to evict.
-/// @param force_evict Specify true to decommit the image element memory immediately, regardless of any outstanding locks.
+/// @param force_evict Specify true to decommit the image element memory immediately, regardless of any outstanding locks. If the element is pinned, it is evicted after the last pin is released.
 public_function void image_memory_evict_element(image_memory_t *mem, uintptr_t image_id, size_t element, bool force_evict=false)
 {
     size_t image_index;
+    // a forced eviction must see a stable pin count.
+    if (force_evict) AcquireSRWLockExclusive(&mem->ImageLock);
+    else AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_info_t  &info  = mem->AttributeList[image_index];
-        uint32_t     element_flags  = image_memory_element_status_flags(info.ElementStatus[element]);
-        size_t       element_locks  = image_memory_element_lock_count  (info.ElementStatus[element]);
-        if (force_evict)              element_locks = 0;
-        info.ElementStatus[element] = image_memory_make_element_status (element_flags | IMAGE_MEMORY_FLAG_EVICT, element_locks);
+        if (force_evict) image_memory_force_evict(mem, image_index, element);
+        else image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_EVICT, IMAGE_MEMORY_FLAG_NONE);
         image_memory_process_pending_evict(mem, image_index, element);
     }
+    if (force_evict) ReleaseSRWLockExclusive(&mem->ImageLock);
+    else ReleaseSRWLockShared(&mem->ImageLock);
 }
 
 /// @summary Marks all image elements and mipmap levels for eviction. Image elements are not evicted until their lock count drops to zero.
@@ -995,50 +1476,72 @@ public_function void image_memory_evict_element(image_memory_t *mem, uintptr_t i
 public_function void image_memory_evict_image(image_memory_t *mem, uintptr_t image_id)
 {
     size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_info_t  &info = mem->AttributeList[image_index];
         for (size_t i = 0, n = info.ElementCount; i < n; ++i)
         {
-            uint32_t element_flags = image_memory_element_status_flags(info.ElementStatus[i]);
-            size_t   element_locks = image_memory_element_lock_count  (info.ElementStatus[i]);
-            info.ElementStatus[i]  = image_memory_make_element_status (element_flags | IMAGE_MEMORY_FLAG_EVICT, element_locks);
+            image_memory_update_element_flags(info.ElementStatus[i], IMAGE_MEMORY_FLAG_EVICT, IMAGE_MEMORY_FLAG_NONE);
             image_memory_process_pending_evict(mem, image_index, i);
         }
     }
+    ReleaseSRWLockShared(&mem->ImageLock);
 }
 
 /// @summary Marks all image elements and mipmap levels for eviction, and releases all reserved address space. Image elements are not evicted until their lock count drops to zero.
 /// @param mem The image memory manager.
 /// @param image_id The application-defined image identifier.
-/// @param force_drop Specify true to drop the image immediately, regardless of any outstanding locks.
+/// @param force_drop Specify true to drop the image immediately, regardless of any outstanding locks. If any element is pinned, the image is dropped after the last pin is released.
 public_function void image_memory_drop_image(image_memory_t *mem, uintptr_t image_id, bool force_drop=false)
 {
     size_t image_index;
+    bool   drop_now = false;
+    // a forced drop must see a stable pin count.
+    if (force_drop) AcquireSRWLockExclusive(&mem->ImageLock);
+    else AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t  &addr = mem->AddressList  [image_index];
         image_memory_info_t  &info = mem->AttributeList[image_index];
-        if (force_drop)
+        bool                pinned = false;
+        for (size_t i = 0, n = info.ElementCount; force_drop && i < n; ++i)
+        {
+            if (info.ElementPins[i].load(std::memory_order_relaxed) != 0)
+            {   // the storage of a pinned element can't be released.
+                pinned = true;
+                break;
+            }
+        }
+        if (force_drop && !pinned)
         {   // force the image to be dropped by setting BytesCommitted to 0.
             // this decommits and releases the entire reserved range at once.
-            mem->BytesCommitted -= addr.BytesCommitted;
-            addr.BytesCommitted  = 0;
+            for (size_t i = 0, n = info.ElementCount; i < n; ++i)
+            {   // clear the residency flags, so that no thread can pin the element once the lock is released.
+                image_memory_update_element_flags(info.ElementStatus[i], IMAGE_MEMORY_FLAG_NONE, IMAGE_MEMORY_FLAG_COMMITTED | IMAGE_MEMORY_FLAG_MAPPED | IMAGE_MEMORY_FLAG_EVICT, true);
+                // file views must be unmapped individually.
+                image_memory_unmap_element(mem, image_index, i);
+            }
+            image_memory_count_committed(mem, addr, -ptrdiff_t(addr.BytesCommitted));
             addr.ImageStatus     = IMAGE_MEMORY_FLAG_DROP;
-            image_memory_process_pending_drop(mem, image_index);
         }
         else
-        {   // mark each image element for eviction.
+        {   // mark each image element for eviction. pinned elements are evicted when unpinned.
             for (size_t i = 0, n = info.ElementCount; i < n; ++i)
             {
-                uint32_t element_flags = image_memory_element_status_flags(info.ElementStatus[i]);
-                size_t   element_locks = image_memory_element_lock_count  (info.ElementStatus[i]);
-                info.ElementStatus[i]  = image_memory_make_element_status (element_flags | IMAGE_MEMORY_FLAG_EVICT, element_locks);
+                if (force_drop) image_memory_force_evict(mem, image_index, i);
+                else image_memory_update_element_flags(info.ElementStatus[i], IMAGE_MEMORY_FLAG_EVICT, IMAGE_MEMORY_FLAG_NONE);
                 image_memory_process_pending_evict(mem, image_index, i);
             }
             addr.ImageStatus|= IMAGE_MEMORY_FLAG_DROP;
-            image_memory_process_pending_drop(mem, image_index);
         }
+        drop_now = true;
+    }
+    if (force_drop) ReleaseSRWLockExclusive(&mem->ImageLock);
+    else ReleaseSRWLockShared(&mem->ImageLock);
+    if (drop_now)
+    {   // the drop takes the lock in exclusive mode itself. only this thread drops images, so the index is still valid.
+        image_memory_process_pending_drop(mem, image_index);
     }
 }
 
@@ -1049,28 +1552,64 @@ public_function void image_memory_drop_image(image_memory_t *mem, uintptr_t imag
 /// @return The base address of the image element data (level 0 in the mipmap chain.) 
 /// Do not write any data without calling image_memory_increase_commit(), or use image_memory_write().
 /// The address space has been reserved, but is not backed by memory or the system page file.
+/// If the return value is NULL and GetLastError() returns ERROR_LOCKED, the element is pinned and its storage can't be released.
 public_function void* image_memory_reset_element_storage(image_memory_t *mem, uintptr_t image_id, size_t element)
 {
+    void  *element_base = NULL;
     size_t image_index;
+    if (mem->Tier != NULL)
+    {   // any compressed copy of the element is about to become stale.
+        AcquireSRWLockExclusive(&mem->TierLock);
+        image_tier_discard_element(mem->Tier, image_id, element);
+        ReleaseSRWLockExclusive(&mem->TierLock);
+    }
+    // the pin count is only stable while the lock is held in exclusive mode.
+    AcquireSRWLockExclusive(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t &addr  = mem->AddressList  [image_index];
         image_memory_info_t &info  = mem->AttributeList[image_index];
         image_memory_size_t &size  = info.ElementCommit[element];
         uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
-        if (size.BytesCommitted > 0)
+        size_t       prefaulted    = 0;
+        if (info.ElementPins[element].load(std::memory_order_relaxed) != 0)
+        {   // another thread is reading the current element data.
+            ReleaseSRWLockExclusive(&mem->ImageLock);
+            SetLastError(ERROR_LOCKED);
+            return NULL;
+        }
+        image_memory_wait_prefault(info, element);
+        // clear the residency flags first, so that no thread can pin the element while its storage is released.
+        uint32_t     element_flags = image_memory_element_status_flags(image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_WRITING, IMAGE_MEMORY_FLAG_MAPPED | IMAGE_MEMORY_FLAG_COMMITTED));
+        if (element_flags & IMAGE_MEMORY_FLAG_MAPPED)
+        {   // the data will be written to committed memory instead of the file view.
+            image_memory_unmap_element(mem, image_index, element);
+            element_flags &=~IMAGE_MEMORY_FLAG_COMMITTED;
+        }
+        if (size.BytesPrefaulted > 0)
+        {   // the pages were committed and faulted ahead of this write, and are still clean. keep them.
+            prefaulted = size.BytesPrefaulted;
+        }
+        else if (size.BytesCommitted > 0)
         {   // free any currently committed address space.
             VirtualFree(element_data, size.BytesCommitted, MEM_DECOMMIT);
         }
+        if (element_flags & IMAGE_MEMORY_FLAG_COMMITTED)
+        {   // the committed size was counted against the image and manager totals.
+            image_memory_count_committed(mem, addr, -ptrdiff_t(size.BytesCommitted));
+        }
         // (re-)initialize the per-element write data:
         size.BytesUsed      = 0;
-        size.BytesCommitted = 0;
+        size.BytesCommitted = prefaulted;
         size.LevelsEmitted  = 0;
         size.LevelOffset    = 0;
         size.LevelSize      = 0;
-        return element_data;
+        size.BytesPrefaulted= prefaulted;
+        size.LevelsResident = 0;
+        element_base        = element_data;
     }
-    else return NULL;
+    ReleaseSRWLockExclusive(&mem->ImageLock);
+    return element_base;
 }
 
 /// @summary Increases the number of bytes of memory committed for an image element.
@@ -1081,7 +1620,9 @@ public_function void* image_memory_reset_element_storage(image_memory_t *mem, ui
 /// @return A pointer to the current write position.
 public_function void* image_memory_increase_commit(image_memory_t *mem, uintptr_t image_id, size_t element, size_t new_commit)
 {
+    void  *write_addr = NULL;
     size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t &addr  = mem->AddressList  [image_index];
@@ -1089,20 +1630,24 @@ public_function void* image_memory_increase_commit(image_memory_t *mem, uintptr_
         image_memory_size_t &size  = info.ElementCommit[element];
         uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
         uint8_t      *write_ptr    = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element) + size.BytesUsed;
+        image_memory_wait_prefault(info, element);
+        size.BytesPrefaulted       = 0;
         if (new_commit > size.BytesCommitted)
         {
             size_t bytes_committed = align_up(new_commit, mem->PageSize);
-            if (VirtualAlloc(element_data, bytes_committed, MEM_COMMIT, PAGE_READWRITE) == NULL)
+            if (image_memory_commit(addr, element_data, bytes_committed) == NULL)
             {   // failed to increase the number of bytes committed.
+                ReleaseSRWLockShared(&mem->ImageLock);
                 return NULL;
             }
             size.BytesCommitted = bytes_committed;
         }
         size.LevelSize +=(new_commit - size.BytesUsed);
         size.BytesUsed  = new_commit;
-        return write_ptr;
+        write_addr      = write_ptr;
     }
-    else return NULL;
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return write_addr;
 }
 
 /// @summary Writes data into the current level of an image element. If necessary, the commit size is increased.
@@ -1114,7 +1659,9 @@ public_function void* image_memory_increase_commit(image_memory_t *mem, uintptr_
 /// @return ERROR_SUCCESS, ERROR_NOT_FOUND or a system error code.
 public_function uint32_t image_memory_write(image_memory_t *mem, uintptr_t image_id, size_t element, void const *data, size_t data_size)
 {
-    size_t image_index;
+    uint32_t result = ERROR_NOT_FOUND;
+    size_t   image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t &addr  = mem->AddressList  [image_index];
@@ -1123,21 +1670,26 @@ public_function uint32_t image_memory_write(image_memory_t *mem, uintptr_t image
         uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
         uint8_t      *write_ptr    = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element) + size.BytesUsed;
         size_t        new_commit   = size.BytesUsed  +  data_size;
+        image_memory_wait_prefault(info, element);
+        size.BytesPrefaulted       = 0;
         if (new_commit > size.BytesCommitted)
         {
             size_t bytes_committed = align_up(new_commit, mem->PageSize);
-            if (VirtualAlloc(element_data, bytes_committed, MEM_COMMIT, PAGE_READWRITE) == NULL)
+            if (image_memory_commit(addr, element_data, bytes_committed) == NULL)
             {   // failed to increase the number of bytes committed.
-                return GetLastError();
+                result = GetLastError();
+                ReleaseSRWLockShared(&mem->ImageLock);
+                return result;
             }
             size.BytesCommitted = bytes_committed;
         }
         size.LevelSize += data_size;
         size.BytesUsed += data_size;
         memcpy(write_ptr, data, data_size);
-        return ERROR_SUCCESS;
+        result = ERROR_SUCCESS;
     }
-    else return ERROR_NOT_FOUND;
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return result;
 }
 
 /// @summary Marks the end of the current mipmap level. Subsequent writes will target the next level in the mipmap chain.
@@ -1147,7 +1699,9 @@ public_function uint32_t image_memory_write(image_memory_t *mem, uintptr_t image
 /// @return ERROR_SUCCESS or ERROR_NOT_FOUND.
 public_function uint32_t image_memory_mark_level_end(image_memory_t *mem, uintptr_t image_id, size_t element)
 {
-    size_t image_index;
+    uint32_t result = ERROR_NOT_FOUND;
+    size_t   image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_info_t &info  = mem->AttributeList[image_index];
@@ -1159,9 +1713,11 @@ public_function uint32_t image_memory_mark_level_end(image_memory_t *mem, uintpt
         info.ImageBlocks[first_block+level_index].StoredSize = size.LevelSize;
         size.LevelOffset  += size.LevelSize;
         size.LevelSize     = 0;
-        return ERROR_SUCCESS;
+        size.LevelsEmitted++;
+        result = ERROR_SUCCESS;
     }
-    else return ERROR_NOT_FOUND;
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return result;
 }
 
 /// @summary Marks the end of an image element, indicating that all data has been written.
@@ -1174,19 +1730,28 @@ public_function uint32_t image_memory_mark_level_end(image_memory_t *mem, uintpt
 /// @return ERROR_SUCCESS or ERROR_NOT_FOUND.
 public_function uint32_t image_memory_mark_element_end(image_memory_t *mem, uintptr_t image_id, size_t element, image_location_queue_t *placement_queue=NULL, image_location_alloc_t *thread_alloc=NULL)
 {
-    size_t image_index;
+    uint32_t result = ERROR_NOT_FOUND;
+    size_t   image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
     if (id_table_get(&mem->ImageIds, image_id, &image_index))
     {
         image_memory_addr_t &addr  = mem->AddressList  [image_index];
         image_memory_info_t &info  = mem->AttributeList[image_index];
         image_memory_size_t &size  = info.ElementCommit[element];
         uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
+        uint32_t     element_flags = image_memory_element_status_flags(info.ElementStatus[element].load(std::memory_order_acquire));
         if ((size.BytesCommitted   - size.BytesUsed) >  mem->PageSize)
         {   // decommit any whole unused pages. 
             size_t      bytes_used = align_up(size.BytesUsed, mem->PageSize);
             VirtualFree(element_data+bytes_used, size.BytesCommitted-bytes_used, MEM_DECOMMIT);
             size.BytesCommitted    = bytes_used;
         }
+        if ((element_flags & IMAGE_MEMORY_FLAG_COMMITTED) == 0)
+        {   // the element is now resident; count it so that it can be evicted.
+            image_memory_count_committed(mem, addr, ptrdiff_t(size.BytesCommitted));
+        }
+        // publish the element data written on this thread to any thread that pins it.
+        image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_COMMITTED, IMAGE_MEMORY_FLAG_WRITING);
         if (placement_queue != NULL)
         {   // post the placement notification to the target queue.
             fifo_node_t<image_location_t> *n = fifo_allocator_get(thread_alloc);
@@ -1195,11 +1760,13 @@ public_function uint32_t image_memory_mark_element_end(image_memory_t *mem, uint
             n->Item.BaseAddress    = element_data;
             n->Item.BytesReserved  = size.BytesCommitted;
             n->Item.Context        =(uintptr_t) mem;
+            n->Item.FirstLevel     = 0;
             mpsc_fifo_u_produce(placement_queue, n);
         }
-        return ERROR_SUCCESS;
+        result = ERROR_SUCCESS;
     }
-    else return ERROR_NOT_FOUND;
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return result;
 }
 
 /// @summary Helper function to calculate the size of an image element when stored with no compression (except for DXGI compression) and raw encoding.
@@ -1210,3 +1777,721 @@ public_function size_t image_memory_base_element_size(image_definition_t const *
     size_t element_used = 0; UNREFERENCED_PARAMETER(element_used);
     return image_memory_element_size(def, 1, element_used);
 }
+
+/// @summary Calculate the number of bytes between rows of an image level as stored in image memory. Rows of uncompressed 
+/// formats are padded to the row alignment of the memory manager; block-compressed and packed formats, and formats whose 
+/// pixel size does not divide the alignment, are always stored tightly packed.
+/// @param mem The image memory manager.
+/// @param format One of dxgi_format_e specifying the storage format.
+/// @param width The width of the level, in pixels.
+/// @return The row pitch, in bytes.
+public_function size_t image_memory_row_pitch(image_memory_t const *mem, uint32_t format, size_t width)
+{
+    size_t pitch = dxgi_pitch(format, width);
+    size_t bitspp= dxgi_bits_per_pixel(format);
+    if (mem->RowAlignment <= 1 || dxgi_block_compressed(format) || dxgi_packed(format) || dxgi_planar(format) ||
+       (bitspp & 7) != 0 || bitspp == 0 || (mem->RowAlignment % (bitspp / 8)) != 0)
+    {   // the rows are stored tightly packed.
+        return pitch;
+    }
+    return align_up(pitch, mem->RowAlignment);
+}
+
+/// @summary Set the byte alignment of the row pitch used when storing uncompressed image levels, so that 
+/// consumers such as texture uploads can read rows directly from image memory. Only images defined after 
+/// the call are affected. Mapped elements require tightly packed rows, so images with padded rows are streamed.
+/// @param mem The image memory manager.
+/// @param alignment The row alignment, in bytes. This must be a power of two; specify 1 to store rows tightly packed.
+/// @return ERROR_SUCCESS or ERROR_INVALID_PARAMETER.
+public_function uint32_t image_memory_set_row_alignment(image_memory_t *mem, size_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment > mem->PageSize)
+    {   // the alignment must be a power of two no larger than a page.
+        return ERROR_INVALID_PARAMETER;
+    }
+    mem->RowAlignment = alignment;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Retrieve the NUMA node from which an image's memory is committed. 
+/// Threads that write or read the image data should prefer to run on this node.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @return The zero-based NUMA node number, or NUMA_NO_PREFERRED_NODE. If the image is not known, the manager default is returned.
+public_function uint32_t image_memory_image_node(image_memory_t *mem, uintptr_t image_id)
+{
+    uint32_t node = mem->NumaNode;
+    size_t   image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index))
+    {
+        node = mem->AddressList[image_index].NumaNode;
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return node;
+}
+
+/// @summary Set the NUMA node from which an image's memory is committed. Pages already committed are not migrated.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param numa_node The zero-based NUMA node number, or NUMA_NO_PREFERRED_NODE.
+/// @return ERROR_SUCCESS or ERROR_NOT_FOUND.
+public_function uint32_t image_memory_set_image_node(image_memory_t *mem, uintptr_t image_id, uint32_t numa_node)
+{
+    uint32_t result = ERROR_NOT_FOUND;
+    size_t   image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index))
+    {
+        mem->AddressList[image_index].NumaNode = numa_node;
+        result = ERROR_SUCCESS;
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return result;
+}
+
+/// @summary Attach a compressed tier to an image memory manager. Elements evicted after this call may be 
+/// retained in compressed form, and restored by image_memory_restore_element() or a subsequent lock.
+/// @param mem The image memory manager.
+/// @param tier The compressed tier, or NULL to detach the current tier. The tier is managed by the caller.
+public_function void image_memory_attach_tier(image_memory_t *mem, image_tier_t *tier)
+{
+    mem->Tier = tier;
+}
+
+/// @summary Attach a background committer to an image memory manager. The pages of the elements named in calls to 
+/// image_memory_prefault_elements() are committed and pre-faulted on the committer thread.
+/// Requests may be posted from any thread that writes image data; the committer serializes them.
+/// @param mem The image memory manager.
+/// @param committer The background committer, or NULL to detach the current committer. The committer is managed by the caller, and must outlive the image memory.
+public_function void image_memory_attach_committer(image_memory_t *mem, image_committer_t *committer)
+{
+    mem->Committer = committer;
+}
+
+/// @summary Asks the background committer to commit and pre-fault the pages of a range of elements that are about 
+/// to be written. The pages are counted against the committed totals of the image and manager immediately, and are 
+/// decommitted if the element is evicted before it is written. Elements that already have storage are skipped.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param first_element The zero-based index of the first element to pre-fault.
+/// @param final_element The zero-based index of the last element to pre-fault, or IMAGE_ALL_FRAMES.
+/// @return true if the image is known, or false if it has not been reserved yet.
+public_function bool image_memory_prefault_elements(image_memory_t *mem, uintptr_t image_id, size_t first_element, size_t final_element)
+{
+    bool   result = false;
+    size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index))
+    {
+        size_t element_count = mem->AttributeList[image_index].ElementCount;
+        if (final_element >= element_count)
+            final_element = element_count - 1;
+        for (size_t i = first_element; mem->Committer != NULL && i <= final_element; ++i)
+        {
+            image_memory_prefault_element(mem, image_index, i);
+        }
+        result = true;
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return result;
+}
+
+/// @summary Determine whether an evicted image element can be restored without reloading it from the source file.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame.
+/// @return true if the element is retained by the compressed tier.
+public_function bool image_memory_element_restorable(image_memory_t *mem, uintptr_t image_id, size_t element)
+{
+    bool   result = false;
+    size_t image_index;
+    size_t raw_size;
+    if (mem->Tier == NULL)
+    {   // there's no compressed tier.
+        return false;
+    }
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index) && element < mem->AttributeList[image_index].ElementCount)
+    {   // the image and element are known; ask the tier.
+        AcquireSRWLockExclusive(&mem->TierLock);
+        result = image_tier_contains(mem->Tier, image_id, element, raw_size);
+        ReleaseSRWLockExclusive(&mem->TierLock);
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return result;
+}
+
+/// @summary Restores an evicted image element from the compressed tier, committing its memory and notifying the placement queue as if it had been loaded.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame to restore.
+/// @param placement_queue The unbounded MPSC queue to notify with the location of the element in memory.
+/// @param thread_alloc The FIFO node allocator used to write to the placement queue from the calling thread.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND if the element is not retained by the tier, or a system error code.
+public_function uint32_t image_memory_restore_element(image_memory_t *mem, uintptr_t image_id, size_t element, image_location_queue_t *placement_queue=NULL, image_location_alloc_t *thread_alloc=NULL)
+{
+    size_t image_index;
+    size_t raw_size;
+    if (mem->Tier == NULL)
+    {   // there's no compressed tier.
+        return ERROR_NOT_FOUND;
+    }
+    // the image lists may be reallocated by a reservation on another thread.
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (!id_table_get(&mem->ImageIds, image_id, &image_index))
+    {   // the image is not known.
+        ReleaseSRWLockShared(&mem->ImageLock);
+        return ERROR_NOT_FOUND;
+    }
+    image_memory_addr_t &addr  = mem->AddressList  [image_index];
+    image_memory_info_t &info  = mem->AttributeList[image_index];
+    image_memory_size_t &size  = info.ElementCommit[element];
+    uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
+    uint32_t     element_flags = image_memory_element_status_flags(info.ElementStatus[element].load(std::memory_order_acquire));
+    size_t       commit_size   = align_up(size.BytesUsed, mem->PageSize);
+    image_memory_wait_prefault(info, element);
+    AcquireSRWLockExclusive(&mem->TierLock);
+    if (!image_tier_contains(mem->Tier, image_id, element, raw_size))
+    {   // the element was not retained by the tier.
+        ReleaseSRWLockExclusive(&mem->TierLock);
+        ReleaseSRWLockShared(&mem->ImageLock);
+        return ERROR_NOT_FOUND;
+    }
+    if (raw_size != size.BytesUsed || (element_flags & (IMAGE_MEMORY_FLAG_COMMITTED | IMAGE_MEMORY_FLAG_WRITING)) == IMAGE_MEMORY_FLAG_COMMITTED)
+    {   // the retained copy doesn't match the current element layout, or the element is already resident.
+        image_tier_discard_element(mem->Tier, image_id, element);
+        ReleaseSRWLockExclusive(&mem->TierLock);
+        ReleaseSRWLockShared(&mem->ImageLock);
+        return ERROR_NOT_FOUND;
+    }
+    if (image_memory_commit(addr, element_data, commit_size) == NULL)
+    {   // unable to commit memory for the element.
+        uint32_t error = GetLastError();
+        ReleaseSRWLockExclusive(&mem->TierLock);
+        ReleaseSRWLockShared(&mem->ImageLock);
+        return error;
+    }
+    if (!image_tier_restore(mem->Tier, image_id, element, element_data, size.BytesUsed))
+    {   // the compressed data could not be restored.
+        if ((element_flags & IMAGE_MEMORY_FLAG_COMMITTED) == 0)
+            VirtualFree(element_data, commit_size, MEM_DECOMMIT);
+        ReleaseSRWLockExclusive(&mem->TierLock);
+        ReleaseSRWLockShared(&mem->ImageLock);
+        return ERROR_NOT_FOUND;
+    }
+    ReleaseSRWLockExclusive(&mem->TierLock);
+    if (element_flags & IMAGE_MEMORY_FLAG_COMMITTED)
+    {   // the pre-faulted pages were already counted; the element size replaces them.
+        image_memory_count_committed(mem, addr, -ptrdiff_t(size.BytesCommitted));
+        if (commit_size < size.BytesCommitted)
+            VirtualFree(element_data + commit_size, size.BytesCommitted - commit_size, MEM_DECOMMIT);
+    }
+    size.BytesCommitted         = commit_size;
+    size.BytesPrefaulted        = 0;
+    image_memory_count_committed(mem, addr, ptrdiff_t(commit_size));
+    image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_COMMITTED, IMAGE_MEMORY_FLAG_EVICT | IMAGE_MEMORY_FLAG_WRITING);
+    if (placement_queue != NULL)
+    {   // post the placement notification to the target queue.
+        fifo_node_t<image_location_t> *n = fifo_allocator_get(thread_alloc);
+        n->Item.ImageId        = image_id;
+        n->Item.FrameIndex     = element;
+        n->Item.BaseAddress    = element_data;
+        n->Item.BytesReserved  = size.BytesCommitted;
+        n->Item.Context        =(uintptr_t) mem;
+        n->Item.FirstLevel     = 0;
+        mpsc_fifo_u_produce(placement_queue, n);
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return ERROR_SUCCESS;
+}
+
+/// @summary Maps a range of a file into the address space as the data for an image element, so that the element 
+/// is backed by the system file cache and no data is copied. The mapped data is read-only. The image must be stored 
+/// without compression using raw encoding, and the file range must contain the mipmap levels of the element tightly 
+/// packed, highest resolution first, exactly as they would be laid out in committed memory. Existing data is discarded.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame to map.
+/// @param fildes The handle of the source file, opened with at least GENERIC_READ access. The handle may be closed after the call returns.
+/// @param file_offset The absolute byte offset of the first byte of element data within the file. The offset need not be aligned.
+/// @param placement_queue The unbounded MPSC queue to notify with the location of the element in memory.
+/// @param thread_alloc The FIFO node allocator used to write to the placement queue from the calling thread.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND, ERROR_NOT_SUPPORTED, ERROR_LOCKED or a system error code.
+public_function uint32_t image_memory_map_element(image_memory_t *mem, uintptr_t image_id, size_t element, HANDLE fildes, int64_t file_offset, image_location_queue_t *placement_queue=NULL, image_location_alloc_t *thread_alloc=NULL)
+{
+    size_t image_index;
+    size_t element_size = 0;
+    // the image lists may be reallocated by a reservation on another thread.
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (!id_table_get(&mem->ImageIds, image_id, &image_index))
+    {   // the image is not known.
+        ReleaseSRWLockShared(&mem->ImageLock);
+        return ERROR_NOT_FOUND;
+    }
+    else
+    {   // validate the storage layout against the file layout.
+        image_memory_info_t &info = mem->AttributeList[image_index];
+        if (info.Compression != IMAGE_COMPRESSION_NONE || info.Encoding != IMAGE_ENCODING_RAW)
+        {   // the in-memory layout differs from the file layout.
+            ReleaseSRWLockShared(&mem->ImageLock);
+            return ERROR_NOT_SUPPORTED;
+        }
+        if (image_memory_element_lock_count(info.ElementStatus[element].load(std::memory_order_acquire)) > 0)
+        {   // the current element data is in use and cannot be replaced.
+            ReleaseSRWLockShared(&mem->ImageLock);
+            return ERROR_LOCKED;
+        }
+        for (size_t i = 0, n = info.LevelCount; i < n; ++i)
+        {   // the levels of the element are tightly packed, but rows may be padded.
+            if (info.LevelDimension[i].BytesPerRow != dxgi_pitch(info.Format, info.LevelDimension[i].LevelWidth))
+            {
+                ReleaseSRWLockShared(&mem->ImageLock);
+                return ERROR_NOT_SUPPORTED;
+            }
+            element_size += info.LevelDimension[i].BytesPerSlice * info.LevelDimension[i].LevelSlices;
+        }
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    if (element_size == 0)
+    {   // a zero-length view would map the remainder of the file.
+        return ERROR_NOT_SUPPORTED;
+    }
+
+    // views must start on an allocation granularity boundary, which is also page-aligned.
+    int64_t  view_offset =  file_offset & ~int64_t(mem->Granularity - 1);
+    size_t   view_skew   =  size_t(file_offset - view_offset);
+    size_t   view_size   =  view_skew + element_size;
+    DWORD    offset_hi   =  DWORD(uint64_t(view_offset) >> 32);
+    DWORD    offset_lo   =  DWORD(uint64_t(view_offset) & 0xFFFFFFFFULL);
+    HANDLE   section     =  CreateFileMapping(fildes, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (section == NULL)
+    {   // the file cannot be mapped.
+        return GetLastError();
+    }
+    void    *view_base   =  MapViewOfFile(section, FILE_MAP_READ, offset_hi, offset_lo, view_size);
+    DWORD    map_error   =  GetLastError();
+    CloseHandle(section);   // the view holds its own reference to the section.
+    if (view_base == NULL)
+    {   // the range could not be mapped; it may extend past the end of the file.
+        return map_error;
+    }
+
+    // discard any existing data. this unmaps or decommits the element, and takes the locks itself.
+    if (image_memory_reset_element_storage(mem, image_id, element) == NULL)
+    {   // the element was pinned after the lock count was checked.
+        UnmapViewOfFile(view_base);
+        return ERROR_LOCKED;
+    }
+    // the view records may be allocated here, and pinning threads read them, so hold the lock exclusively.
+    AcquireSRWLockExclusive(&mem->ImageLock);
+    if (!id_table_get(&mem->ImageIds, image_id, &image_index))
+    {   // the image was dropped after its storage was reset.
+        ReleaseSRWLockExclusive(&mem->ImageLock);
+        UnmapViewOfFile(view_base);
+        return ERROR_NOT_FOUND;
+    }
+    image_memory_addr_t &addr  = mem->AddressList  [image_index];
+    image_memory_info_t &info  = mem->AttributeList[image_index];
+    image_memory_size_t &size  = info.ElementCommit[element];
+    size_t       first_block   = info.LevelCount * element;
+    if (info.ElementViews == NULL)
+    {   // allocate the view records the first time an element of the image is mapped.
+        if ((info.ElementViews = (image_memory_view_t*) malloc(info.ElementCount * sizeof(image_memory_view_t))) == NULL)
+        {
+            ReleaseSRWLockExclusive(&mem->ImageLock);
+            UnmapViewOfFile(view_base);
+            return ERROR_OUTOFMEMORY;
+        }
+        memset(info.ElementViews, 0, info.ElementCount * sizeof(image_memory_view_t));
+    }
+    if (size.BytesCommitted > 0)
+    {   // pages pre-faulted for a copy are not needed; the view replaces them.
+        VirtualFree(((uint8_t*) addr.BaseAddress) + (info.BytesPerElement * element), size.BytesCommitted, MEM_DECOMMIT);
+    }
+    for (size_t i = 0, n = info.LevelCount, offset = 0; i < n; ++i)
+    {
+        info.ImageBlocks[first_block+i].ByteOffset = offset;
+        info.ImageBlocks[first_block+i].StoredSize = info.LevelDimension[i].BytesPerSlice * info.LevelDimension[i].LevelSlices;
+        offset += info.ImageBlocks[first_block+i].StoredSize;
+    }
+    size.BytesUsed          = element_size;
+    size.BytesCommitted     = 0;
+    size.LevelsEmitted      = info.LevelCount;
+    size.LevelOffset        = element_size;
+    size.LevelSize          = 0;
+    size.BytesPrefaulted    = 0;
+
+    // the element is resident as soon as the view exists; pages are faulted in from the file cache on access.
+    image_memory_view_t &view = info.ElementViews[element];
+    view.ViewBase             = view_base;
+    view.ElementData          =((uint8_t*) view_base) + view_skew;
+    view.ViewSize             = view_size;
+    image_memory_count_mapped(mem, addr, ptrdiff_t(view_size));
+    image_memory_update_element_flags(info.ElementStatus[element], IMAGE_MEMORY_FLAG_COMMITTED | IMAGE_MEMORY_FLAG_MAPPED, IMAGE_MEMORY_FLAG_EVICT | IMAGE_MEMORY_FLAG_WRITING, true);
+    if (placement_queue != NULL)
+    {   // post the placement notification to the target queue.
+        fifo_node_t<image_location_t> *n = fifo_allocator_get(thread_alloc);
+        n->Item.ImageId        = image_id;
+        n->Item.FrameIndex     = element;
+        n->Item.BaseAddress    = view.ElementData;
+        n->Item.BytesReserved  = element_size;
+        n->Item.Context        =(uintptr_t) mem;
+        n->Item.FirstLevel     = 0;
+        mpsc_fifo_u_produce(placement_queue, n);
+    }
+    ReleaseSRWLockExclusive(&mem->ImageLock);
+    return ERROR_SUCCESS;
+}
+
+/// @summary Pins a resident image element, including all mipmap levels, so that it can be read from any thread. 
+/// Unlike image_memory_lock_element(), this function never commits memory or restores data; if the element 
+/// is not resident, or is marked for eviction, the call fails and the caller should request the frame through 
+/// the image cache instead. An element that is marked for eviction while pinned is evicted by image_memory_update() 
+/// after the last pin is released.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame to pin.
+/// @param levels If non-NULL, points to an array of LevelCount items to populate with information about the element mipmap levels.
+/// @param storage On return, this structure is populated with image storage attributes for the image element.
+/// @return A pointer to the start of the image element data for miplevel 0, or NULL.
+public_function void* image_memory_pin_element(image_memory_t *mem, uintptr_t image_id, size_t element, dds_level_desc_t *levels, image_storage_info_t &storage)
+{
+    void  *element_data = NULL;
+    size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index) && element < mem->AttributeList[image_index].ElementCount)
+    {
+        image_memory_addr_t &addr = mem->AddressList  [image_index];
+        image_memory_info_t &info = mem->AttributeList[image_index];
+        if (image_memory_try_pin_element(info.ElementStatus[element], info.LevelCount))
+        {   // the element cannot be decommitted or unmapped until it is unpinned.
+            // forced evictions and resets hold the lock exclusively, so they see both updates or neither.
+            info.ElementPins[element].fetch_add(1, std::memory_order_relaxed);
+            uint32_t  element_flags = image_memory_element_status_flags(info.ElementStatus[element].load(std::memory_order_acquire));
+            image_memory_describe_element(info, element, element_flags, levels, storage);
+            element_data = image_memory_element_address(addr, info, element);
+        }
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return element_data;
+}
+
+/// @summary Releases a pin acquired with image_memory_pin_element(). This function may be called from any thread. 
+/// If the element was marked for eviction while pinned, the eviction is deferred to the next image_memory_update().
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame to unpin.
+public_function void image_memory_unpin_element(image_memory_t *mem, uintptr_t image_id, size_t element)
+{
+    size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index) && element < mem->AttributeList[image_index].ElementCount)
+    {
+        image_memory_info_t &info = mem->AttributeList[image_index];
+        info.ElementPins[element].fetch_sub(1, std::memory_order_relaxed);
+        uint32_t element_status   = image_memory_remove_element_locks(info.ElementStatus[element], info.LevelCount);
+        if (image_memory_element_lock_count  (element_status) == 0 && 
+           (image_memory_element_status_flags(element_status) &  IMAGE_MEMORY_FLAG_EVICT) != 0)
+        {   // the storage can only be released on the thread that manages the image memory.
+            mem->EvictPending.fetch_add(1, std::memory_order_release);
+        }
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+}
+
+/// @summary Processes evictions and drops deferred by image_memory_unpin_element(). This function must be called 
+/// from the thread that manages the image memory, typically once per-tick after processing eviction requests.
+/// @param mem The image memory manager.
+public_function void image_memory_update(image_memory_t *mem)
+{
+    if (mem->EvictPending.exchange(0, std::memory_order_acquire) == 0)
+    {   // no element was left waiting for eviction.
+        return;
+    }
+    // walk the list in reverse, since a drop moves the last image into the dropped slot.
+    // only this thread drops images, but other threads may grow the lists at any time.
+    for (size_t i = mem->ImageCount; i > 0; --i)
+    {
+        AcquireSRWLockShared(&mem->ImageLock);
+        for (size_t j = 0, n = mem->AttributeList[i-1].ElementCount; j < n; ++j)
+        {
+            image_memory_process_pending_evict(mem, i-1, j);
+        }
+        ReleaseSRWLockShared(&mem->ImageLock);
+        image_memory_process_pending_drop(mem, i-1);
+    }
+}
+
+/// @summary Defines an image with the same storage layout as an existing image, and publishes its definition. 
+/// Together with image_memory_copy_element(), this allows one decoded copy of a file to satisfy loads for several images.
+/// @param mem The image memory manager.
+/// @param src_id The application-defined identifier of the existing image.
+/// @param dst_id The application-defined identifier of the image to define.
+/// @param block_offsets If non-NULL, an array of ElementCount * LevelCount source file offsets to publish with the definition.
+/// @param definition_queue The unbounded MPSC queue to post the image attributes to.
+/// @param thread_alloc The FIFO node allocator used to write to the target queue from the calling thread.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND, ERROR_ALREADY_EXISTS or ERROR_OUTOFMEMORY.
+public_function uint32_t image_memory_clone_image(image_memory_t *mem, uintptr_t src_id, uintptr_t dst_id, stream_decode_pos_t const *block_offsets, image_definition_queue_t *definition_queue=NULL, image_definition_alloc_t *thread_alloc=NULL)
+{
+    image_definition_t def;
+    size_t             element_size = 0;
+    int                encoding     = IMAGE_ENCODING_RAW;
+    int                access_type  = IMAGE_ACCESS_UNKNOWN;
+    uint32_t           numa_node    = NUMA_NO_PREFERRED_NODE;
+    size_t             image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (!id_table_get(&mem->ImageIds, src_id, &image_index))
+    {   // the source image isn't defined.
+        ReleaseSRWLockShared(&mem->ImageLock);
+        return ERROR_NOT_FOUND;
+    }
+    image_memory_addr_t const &addr = mem->AddressList  [image_index];
+    image_memory_info_t const &info = mem->AttributeList[image_index];
+    image_definition_init(&def, info.ElementCount, info.LevelCount);
+    if (def.LevelInfo == NULL || def.BlockOffsets == NULL)
+    {   // unable to allocate the level descriptors and offsets.
+        ReleaseSRWLockShared(&mem->ImageLock);
+        image_definition_free(&def);
+        return ERROR_OUTOFMEMORY;
+    }
+    def.ImageId       = dst_id;
+    def.ImageFormat   = info.Format;
+    def.Compression   = info.Compression;
+    def.Encoding      = info.Encoding;
+    def.Width         = info.LevelDimension[0].LevelWidth;
+    def.Height        = info.LevelDimension[0].LevelHeight;
+    def.SliceCount    = info.LevelDimension[0].LevelSlices;
+    def.ElementIndex  = 0;
+    def.BytesPerPixel = info.BytesPerPixel;
+    def.BytesPerBlock = info.BytesPerBlock;
+    def.DDSHeader     = info.DDSHeader;
+    def.DX10Header    = info.DX10Header;
+    for (size_t i = 0, n = info.LevelCount; i < n; ++i)
+    {
+        def.LevelInfo[i].Index           = i;
+        def.LevelInfo[i].Width           = info.LevelDimension[i].LevelWidth;
+        def.LevelInfo[i].Height          = info.LevelDimension[i].LevelHeight;
+        def.LevelInfo[i].Slices          = info.LevelDimension[i].LevelSlices;
+        def.LevelInfo[i].BytesPerElement = info.LevelDimension[i].BytesPerElement;
+        def.LevelInfo[i].BytesPerRow     = info.LevelDimension[i].BytesPerRow;
+        def.LevelInfo[i].BytesPerSlice   = info.LevelDimension[i].BytesPerSlice;
+        def.LevelInfo[i].DataSize        = info.LevelDimension[i].BytesPerSlice * info.LevelDimension[i].LevelSlices;
+        def.LevelInfo[i].Format          = info.Format;
+    }
+    if (block_offsets != NULL)
+    {   // both images are loaded from the same file.
+        memcpy(def.BlockOffsets, block_offsets, info.ElementCount * info.LevelCount * sizeof(stream_decode_pos_t));
+    }
+    element_size = info.BytesPerElementMax;
+    encoding     = info.Encoding;
+    access_type  = info.AccessType;
+    numa_node    = addr.NumaNode;
+    ReleaseSRWLockShared(&mem->ImageLock);
+
+    // an identical definition of dst_id is accepted, so a clone can be repeated.
+    uint32_t result = image_memory_reserve_image(mem, element_size, &def, encoding, access_type, definition_queue, thread_alloc, numa_node);
+    image_definition_free(&def);
+    return result;
+}
+
+/// @summary Copies the stored data of a resident element from one image into another image with the same storage layout, 
+/// and posts a placement notification for the destination element. The source element is pinned during the copy.
+/// @param mem The image memory manager.
+/// @param src_id The application-defined identifier of the image to copy from.
+/// @param dst_id The application-defined identifier of the image to copy to, defined with image_memory_clone_image().
+/// @param element The zero-based index of the array item or frame to copy.
+/// @param placement_queue The unbounded MPSC queue to notify with the location of the destination element in memory.
+/// @param thread_alloc The FIFO node allocator used to write to the placement queue from the calling thread.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND if the source element isn't resident, ERROR_OUTOFMEMORY, or a system error code.
+public_function uint32_t image_memory_copy_element(image_memory_t *mem, uintptr_t src_id, uintptr_t dst_id, size_t element, image_location_queue_t *placement_queue=NULL, image_location_alloc_t *thread_alloc=NULL)
+{
+    dds_level_desc_t     desc;
+    image_storage_info_t storage;
+    if (!image_memory_storage_info(mem, src_id, desc, storage) || element >= storage.ElementCount)
+    {   // the source image or element doesn't exist.
+        return ERROR_NOT_FOUND;
+    }
+    dds_level_desc_t *levels = (dds_level_desc_t*) malloc(storage.LevelCount * sizeof(dds_level_desc_t));
+    if (levels == NULL)
+    {   // unable to allocate the level descriptors.
+        return ERROR_OUTOFMEMORY;
+    }
+    uint8_t const *src = (uint8_t const*) image_memory_pin_element(mem, src_id, element, levels, storage);
+    if (src == NULL)
+    {   // the source element isn't resident.
+        free(levels);
+        return ERROR_NOT_FOUND;
+    }
+    uint32_t result = ERROR_NOT_FOUND;
+    if (image_memory_reset_element_storage(mem, dst_id, element) != NULL)
+    {   // levels are stored back-to-back, so copy them in order.
+        result = ERROR_SUCCESS;
+        for (size_t i = 0, n = storage.LevelCount; i < n && result == ERROR_SUCCESS; ++i)
+        {
+            if ((result = image_memory_write(mem, dst_id, element, src, levels[i].DataSize)) == ERROR_SUCCESS)
+                 result = image_memory_mark_level_end(mem, dst_id, element);
+            src += levels[i].DataSize;
+        }
+        if (result == ERROR_SUCCESS)
+        {
+            result = image_memory_mark_element_end(mem, dst_id, element, placement_queue, thread_alloc);
+        }
+    }
+    image_memory_unpin_element(mem, src_id, element);
+    free(levels);
+    return result;
+}
+
+/// @summary Begin specifying the data stored in an image element one level at a time, in any order. Any existing data is overwritten.
+/// The levels are laid out back-to-back, highest resolution first, and storage for the entire element is committed up front.
+/// The image must be stored without compression using raw encoding, and may have at most 32 levels.
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame to start writing.
+/// @return The base address of the image element data, or NULL. If the return value is NULL and GetLastError() returns ERROR_SUCCESS, the image is not known or cannot be written by level.
+public_function void* image_memory_begin_levels(image_memory_t *mem, uintptr_t image_id, size_t element)
+{
+    dds_level_desc_t     desc;
+    image_storage_info_t storage;
+    if (!image_memory_storage_info(mem, image_id, desc, storage) || element >= storage.ElementCount)
+    {   // the image or element doesn't exist.
+        SetLastError(ERROR_SUCCESS);
+        return NULL;
+    }
+    if (storage.Compression != IMAGE_COMPRESSION_NONE || storage.Encoding != IMAGE_ENCODING_RAW || storage.LevelCount > 32)
+    {   // level offsets are not known until the preceding levels have been encoded.
+        SetLastError(ERROR_SUCCESS);
+        return NULL;
+    }
+    if (image_memory_reset_element_storage(mem, image_id, element) == NULL)
+    {   // the image was dropped, or the element is pinned.
+        if (GetLastError() != ERROR_LOCKED) SetLastError(ERROR_SUCCESS);
+        return NULL;
+    }
+
+    void  *element_base = NULL;
+    size_t image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index))
+    {
+        image_memory_addr_t &addr  = mem->AddressList  [image_index];
+        image_memory_info_t &info  = mem->AttributeList[image_index];
+        image_memory_size_t &size  = info.ElementCommit[element];
+        uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
+        size_t       first_block   = info.LevelCount * element;
+        size_t       element_size  = 0;
+        for (size_t i = 0, n = info.LevelCount; i < n; ++i)
+        {
+            info.ImageBlocks[first_block+i].ByteOffset = element_size;
+            info.ImageBlocks[first_block+i].StoredSize = info.LevelDimension[i].BytesPerSlice * info.LevelDimension[i].LevelSlices;
+            element_size += info.ImageBlocks[first_block+i].StoredSize;
+        }
+        if (element_size > size.BytesCommitted)
+        {
+            size_t bytes_committed = align_up(element_size, mem->PageSize);
+            if (image_memory_commit(addr, element_data, bytes_committed) == NULL)
+            {   // failed to commit storage for the element.
+                ReleaseSRWLockShared(&mem->ImageLock);
+                return NULL;
+            }
+            size.BytesCommitted = bytes_committed;
+        }
+        size.BytesUsed      = element_size;
+        size.LevelsEmitted  = info.LevelCount;
+        size.LevelOffset    = element_size;
+        size.LevelSize      = 0;
+        size.BytesPrefaulted= 0;
+        size.LevelsResident = 0;
+        element_base        = element_data;
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    if (element_base == NULL) SetLastError(ERROR_SUCCESS);
+    return element_base;
+}
+
+/// @summary Copies data into a level of an image element started with image_memory_begin_levels().
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame being written.
+/// @param level The zero-based index of the mipmap level being written.
+/// @param offset The byte offset within the level at which to start writing.
+/// @param data The data to copy into the level.
+/// @param data_size The number of bytes to read from data and copy into the level.
+/// @return ERROR_SUCCESS, ERROR_NOT_FOUND or ERROR_INVALID_PARAMETER.
+public_function uint32_t image_memory_write_level(image_memory_t *mem, uintptr_t image_id, size_t element, size_t level, size_t offset, void const *data, size_t data_size)
+{
+    uint32_t result = ERROR_NOT_FOUND;
+    size_t   image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index))
+    {
+        image_memory_addr_t &addr  = mem->AddressList  [image_index];
+        image_memory_info_t &info  = mem->AttributeList[image_index];
+        uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
+        result = ERROR_INVALID_PARAMETER;
+        if (level < info.LevelCount)
+        {
+            image_memory_block_t const &block = info.ImageBlocks[info.LevelCount * element + level];
+            if (offset + data_size <= block.StoredSize)
+            {   // the level storage was committed by image_memory_begin_levels().
+                memcpy(element_data + block.ByteOffset + offset, data, data_size);
+                result = ERROR_SUCCESS;
+            }
+        }
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    return result;
+}
+
+/// @summary Marks a level of an image element started with image_memory_begin_levels() as completely written. 
+/// Whenever the run of resident levels ending at the lowest-resolution level grows, a placement notification 
+/// is posted with FirstLevel set to the highest-resolution level of the run, so that the frame can be displayed 
+/// at reduced resolution. Once every level is resident, the element is finished with image_memory_mark_element_end().
+/// @param mem The image memory manager.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the array item or frame being written.
+/// @param level The zero-based index of the completed mipmap level.
+/// @param placement_queue The unbounded MPSC queue to notify with the location of the element in memory.
+/// @param thread_alloc The FIFO node allocator used to write to the placement queue from the calling thread.
+/// @return ERROR_SUCCESS or ERROR_NOT_FOUND.
+public_function uint32_t image_memory_mark_level_resident(image_memory_t *mem, uintptr_t image_id, size_t element, size_t level, image_location_queue_t *placement_queue=NULL, image_location_alloc_t *thread_alloc=NULL)
+{
+    uint32_t result   = ERROR_NOT_FOUND;
+    bool     complete = false;
+    size_t   image_index;
+    AcquireSRWLockShared(&mem->ImageLock);
+    if (id_table_get(&mem->ImageIds, image_id, &image_index))
+    {
+        image_memory_addr_t &addr  = mem->AddressList  [image_index];
+        image_memory_info_t &info  = mem->AttributeList[image_index];
+        image_memory_size_t &size  = info.ElementCommit[element];
+        uint8_t     *element_data  = ((uint8_t*)   addr.BaseAddress) + (info.BytesPerElement * element);
+        size_t       prev_first    = image_memory_first_resident_level(size.LevelsResident, info.LevelCount);
+        assert(level < info.LevelCount);
+        size.LevelsResident       |= 1U << level;
+        size_t       first_level   = image_memory_first_resident_level(size.LevelsResident, info.LevelCount);
+        if (first_level == 0)
+        {   // the element is complete; publish it the same way as an element written in order.
+            complete = true;
+        }
+        else if (first_level < prev_first && placement_queue != NULL)
+        {   // post the partial placement notification to the target queue.
+            fifo_node_t<image_location_t> *n = fifo_allocator_get(thread_alloc);
+            n->Item.ImageId        = image_id;
+            n->Item.FrameIndex     = element;
+            n->Item.BaseAddress    = element_data;
+            n->Item.BytesReserved  = size.BytesCommitted;
+            n->Item.Context        =(uintptr_t) mem;
+            n->Item.FirstLevel     = first_level;
+            mpsc_fifo_u_produce(placement_queue, n);
+        }
+        result = ERROR_SUCCESS;
+    }
+    ReleaseSRWLockShared(&mem->ImageLock);
+    if (complete)
+    {   // the shared lock is not recursive, so finish the element after releasing it.
+        result = image_memory_mark_element_end(mem, image_id, element, placement_queue, thread_alloc);
+    }
+    return result;
+}
@@ -0,0 +1,371 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements mipmap level generation for uncompressed images using a
+/// 2x2 box filter. Each target pixel is the average of the four source pixels
+/// it covers; when a source dimension is odd, the last row or column is not
+/// sampled, and a dimension of one is clamped. sRGB color channels are averaged
+/// in linear space and re-encoded with exact rounding. Target rows depend only
+/// on two source rows, so a level is reduced in bands of rows on a worker pool.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The number of target rows reduced by one work item.
+#define IMAGE_MIPMAP_BAND_ROWS    8
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define the channel types supported by the box filter.
+enum image_mipmap_type_e : int
+{
+    IMAGE_MIPMAP_TYPE_NONE         = 0,  /// The format is not supported.
+    IMAGE_MIPMAP_TYPE_UNORM8       = 1,  /// 8-bit unsigned normalized channels.
+    IMAGE_MIPMAP_TYPE_FLOAT16      = 2,  /// 16-bit floating-point channels.
+    IMAGE_MIPMAP_TYPE_FLOAT32      = 3,  /// 32-bit floating-point channels.
+};
+
+/// @summary Describes how pixels of a given format are filtered, as initialized by image_mipmap_init().
+struct image_mipmap_t
+{
+    int                       Type;              /// One of image_mipmap_type_e.
+    size_t                    Channels;          /// The number of channels per-pixel.
+    size_t                    PixelSize;         /// The size of one pixel, in bytes.
+    bool                      SRGB;              /// true if the first three channels are sRGB-encoded.
+    float                     ToLinear[256];     /// Maps an sRGB-encoded 8-bit value to linear intensity.
+    float                     Threshold[256];    /// Threshold[i] is the smallest linear intensity that encodes to sRGB value i. Threshold[0] is unused.
+};
+
+/// @summary Describes a level reduction executed on a worker pool. Each work item reduces IMAGE_MIPMAP_BAND_ROWS target rows.
+struct image_mipmap_band_t
+{
+    image_mipmap_t const     *Filter;            /// The filter description.
+    uint8_t const            *Source;            /// The first source row.
+    size_t                    SourceWidth;       /// The width of the source rows, in pixels.
+    size_t                    SourceHeight;      /// The number of source rows available.
+    size_t                    SourcePitch;       /// The number of bytes between source rows.
+    uint8_t                  *Target;            /// The first target row.
+    size_t                    TargetWidth;       /// The width of the target rows, in pixels.
+    size_t                    TargetHeight;      /// The number of target rows to produce.
+    size_t                    TargetPitch;       /// The number of bytes between target rows.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Convert an sRGB-encoded intensity to linear intensity.
+/// @param c The sRGB-encoded intensity, in [0, 1].
+/// @return The linear intensity, in [0, 1].
+internal_function inline float image_srgb_to_linear(float c)
+{
+    return (c <= 0.04045f) ? (c / 12.92f) : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+/// @summary Encode a linear intensity as the nearest 8-bit sRGB value, using a binary search of the table thresholds.
+/// @param mip The filter description, with the sRGB tables initialized.
+/// @param v The linear intensity.
+/// @return The 8-bit sRGB value.
+internal_function inline uint8_t image_mipmap_encode_srgb(image_mipmap_t const *mip, float v)
+{
+    size_t i = 0;
+    for (size_t step = 128; step > 0; step >>= 1)
+    {
+        if (v >= mip->Threshold[i + step])
+            i += step;
+    }
+    return uint8_t(i);
+}
+
+/// @summary Reduce one target row of 8-bit unsigned normalized pixels.
+/// @param mip The filter description.
+/// @param a The first source row.
+/// @param b The second source row. May be the same as a.
+/// @param dst The target row.
+/// @param src_w The width of the source row, in pixels.
+/// @param dst_w The width of the target row, in pixels.
+internal_function void image_mipmap_row_unorm8(image_mipmap_t const *mip, uint8_t const *a, uint8_t const *b, uint8_t *dst, size_t src_w, size_t dst_w)
+{
+    size_t const n = mip->Channels;
+    size_t       x = 0;
+    if (mip->SRGB)
+    {   // average the color channels in linear space; alpha is linear.
+        for ( ; x < dst_w; ++x)
+        {
+            size_t  x0 = (x * 2);
+            size_t  x1 = image_min2<size_t>(x0 + 1, src_w - 1);
+            uint8_t const *p[4] = { a + x0 * 4, a + x1 * 4, b + x0 * 4, b + x1 * 4 };
+            __m128  sum = _mm_setzero_ps();
+            for (size_t i = 0; i < 4; ++i)
+            {
+                sum = _mm_add_ps(sum, _mm_setr_ps(mip->ToLinear[p[i][0]], mip->ToLinear[p[i][1]], mip->ToLinear[p[i][2]], 0.0f));
+            }
+            float lin[4];
+            _mm_storeu_ps(lin, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+            dst[x * 4 + 0] = image_mipmap_encode_srgb(mip, lin[0]);
+            dst[x * 4 + 1] = image_mipmap_encode_srgb(mip, lin[1]);
+            dst[x * 4 + 2] = image_mipmap_encode_srgb(mip, lin[2]);
+            dst[x * 4 + 3] = uint8_t((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) >> 2);
+        }
+        return;
+    }
+    if (n == 4)
+    {   // two target pixels per-iteration while all four source pixels are in the row.
+        __m128i zero = _mm_setzero_si128();
+        __m128i half = _mm_set1_epi16(2);
+        for ( ; (x + 2) * 2 <= src_w && x + 2 <= dst_w; x += 2)
+        {
+            __m128i ra = _mm_loadu_si128((__m128i const*)(a + x * 8));
+            __m128i rb = _mm_loadu_si128((__m128i const*)(b + x * 8));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(ra, zero), _mm_unpacklo_epi8(rb, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(ra, zero), _mm_unpackhi_epi8(rb, zero));
+            __m128i s  = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+            s = _mm_srli_epi16(_mm_add_epi16(s, half), 2);
+            _mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(s, s));
+        }
+    }
+    for ( ; x < dst_w; ++x)
+    {
+        size_t x0 = (x * 2);
+        size_t x1 = image_min2<size_t>(x0 + 1, src_w - 1);
+        for (size_t c = 0; c < n; ++c)
+        {
+            dst[x * n + c] = uint8_t((a[x0 * n + c] + a[x1 * n + c] + b[x0 * n + c] + b[x1 * n + c] + 2) >> 2);
+        }
+    }
+}
+
+/// @summary Reduce one target row of 16-bit floating-point pixels.
+/// @param mip The filter description.
+/// @param a The first source row.
+/// @param b The second source row. May be the same as a.
+/// @param dst The target row.
+/// @param src_w The width of the source row, in pixels.
+/// @param dst_w The width of the target row, in pixels.
+internal_function void image_mipmap_row_float16(image_mipmap_t const *mip, uint16_t const *a, uint16_t const *b, uint16_t *dst, size_t src_w, size_t dst_w)
+{
+    size_t const n = mip->Channels;
+    if (n == 4)
+    {   // one pixel fills one register.
+        __m128i zero = _mm_setzero_si128();
+        __m128  qtr  = _mm_set1_ps(0.25f);
+        for (size_t x = 0; x < dst_w; ++x)
+        {
+            size_t  x0 = (x * 2);
+            size_t  x1 = image_min2<size_t>(x0 + 1, src_w - 1);
+            __m128  s0 = pixel_half_to_float_sse2(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(a + x0 * 4)), zero));
+            __m128  s1 = pixel_half_to_float_sse2(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(a + x1 * 4)), zero));
+            __m128  s2 = pixel_half_to_float_sse2(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(b + x0 * 4)), zero));
+            __m128  s3 = pixel_half_to_float_sse2(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(b + x1 * 4)), zero));
+            __m128i h  = pixel_float_to_half_sse2(_mm_mul_ps(_mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)), qtr));
+            _mm_storel_epi64((__m128i*)(dst + x * 4), pixel_pack_half(h, h));
+        }
+        return;
+    }
+    for (size_t x = 0; x < dst_w; ++x)
+    {
+        size_t x0 = (x * 2);
+        size_t x1 = image_min2<size_t>(x0 + 1, src_w - 1);
+        for (size_t c = 0; c < n; ++c)
+        {
+            float sum = image_half_to_float(a[x0 * n + c]) + image_half_to_float(a[x1 * n + c]) +
+                        image_half_to_float(b[x0 * n + c]) + image_half_to_float(b[x1 * n + c]);
+            dst[x * n + c] = image_float_to_half(sum * 0.25f);
+        }
+    }
+}
+
+/// @summary Reduce one target row of 32-bit floating-point pixels.
+/// @param mip The filter description.
+/// @param a The first source row.
+/// @param b The second source row. May be the same as a.
+/// @param dst The target row.
+/// @param src_w The width of the source row, in pixels.
+/// @param dst_w The width of the target row, in pixels.
+internal_function void image_mipmap_row_float32(image_mipmap_t const *mip, float const *a, float const *b, float *dst, size_t src_w, size_t dst_w)
+{
+    size_t const n = mip->Channels;
+    if (n == 4)
+    {   // one pixel fills one register.
+        __m128 qtr = _mm_set1_ps(0.25f);
+        for (size_t x = 0; x < dst_w; ++x)
+        {
+            size_t x0  = (x * 2);
+            size_t x1  = image_min2<size_t>(x0 + 1, src_w - 1);
+            __m128 top = _mm_add_ps(_mm_loadu_ps(a + x0 * 4), _mm_loadu_ps(a + x1 * 4));
+            __m128 bot = _mm_add_ps(_mm_loadu_ps(b + x0 * 4), _mm_loadu_ps(b + x1 * 4));
+            _mm_storeu_ps(dst + x * 4, _mm_mul_ps(_mm_add_ps(top, bot), qtr));
+        }
+        return;
+    }
+    for (size_t x = 0; x < dst_w; ++x)
+    {
+        size_t x0 = (x * 2);
+        size_t x1 = image_min2<size_t>(x0 + 1, src_w - 1);
+        for (size_t c = 0; c < n; ++c)
+        {
+            dst[x * n + c] = (a[x0 * n + c] + a[x1 * n + c] + b[x0 * n + c] + b[x1 * n + c]) * 0.25f;
+        }
+    }
+}
+
+/// @summary Reduces one band of target rows. Called on a worker pool thread.
+/// @param context The image_mipmap_band_t describing the level.
+/// @param index The zero-based index of the band.
+internal_function void image_mipmap_reduce_band(void *context, size_t index)
+{
+    image_mipmap_band_t *band  = (image_mipmap_band_t*) context;
+    size_t               first =  index * IMAGE_MIPMAP_BAND_ROWS;
+    size_t               last  =  image_min2<size_t>(first + IMAGE_MIPMAP_BAND_ROWS, band->TargetHeight);
+    for (size_t y = first; y < last; ++y)
+    {
+        size_t         y0 = (y * 2);
+        size_t         y1 = image_min2<size_t>(y0 + 1, band->SourceHeight - 1);
+        uint8_t const *a  = band->Source + y0 * band->SourcePitch;
+        uint8_t const *b  = band->Source + y1 * band->SourcePitch;
+        uint8_t       *d  = band->Target + y  * band->TargetPitch;
+        switch (band->Filter->Type)
+        {
+            case IMAGE_MIPMAP_TYPE_UNORM8:
+                image_mipmap_row_unorm8 (band->Filter, a, b, d, band->SourceWidth, band->TargetWidth);
+                break;
+            case IMAGE_MIPMAP_TYPE_FLOAT16:
+                image_mipmap_row_float16(band->Filter, (uint16_t const*) a, (uint16_t const*) b, (uint16_t*) d, band->SourceWidth, band->TargetWidth);
+                break;
+            case IMAGE_MIPMAP_TYPE_FLOAT32:
+                image_mipmap_row_float32(band->Filter, (float const*) a, (float const*) b, (float*) d, band->SourceWidth, band->TargetWidth);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Calculate the number of levels in a complete mipmap chain.
+/// @param width The width of level 0, in pixels.
+/// @param height The height of level 0, in pixels.
+/// @return The number of levels, down to and including the 1x1 level.
+public_function size_t image_mipmap_level_count(size_t width, size_t height)
+{
+    size_t dim    = image_max2<size_t>(width, height);
+    size_t levels = 1;
+    while (dim > 1)
+    {
+        dim >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+/// @summary Initialize a filter description for a pixel format.
+/// @param mip The filter description to initialize.
+/// @param format One of dxgi_format_e specifying the pixel format.
+/// @return true if mipmap levels can be generated for the format.
+public_function bool image_mipmap_init(image_mipmap_t *mip, uint32_t format)
+{
+    mip->Type      = IMAGE_MIPMAP_TYPE_NONE;
+    mip->Channels  = 0;
+    mip->PixelSize = 0;
+    mip->SRGB      = false;
+    switch (format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            mip->SRGB     = true;
+            // fallthrough
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+            mip->Type     = IMAGE_MIPMAP_TYPE_UNORM8;
+            mip->Channels = 4;
+            break;
+        case DXGI_FORMAT_R8G8_UNORM:
+            mip->Type     = IMAGE_MIPMAP_TYPE_UNORM8;
+            mip->Channels = 2;
+            break;
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_A8_UNORM:
+            mip->Type     = IMAGE_MIPMAP_TYPE_UNORM8;
+            mip->Channels = 1;
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            mip->Type     = IMAGE_MIPMAP_TYPE_FLOAT16;
+            mip->Channels = 4;
+            break;
+        case DXGI_FORMAT_R16G16_FLOAT:
+            mip->Type     = IMAGE_MIPMAP_TYPE_FLOAT16;
+            mip->Channels = 2;
+            break;
+        case DXGI_FORMAT_R16_FLOAT:
+            mip->Type     = IMAGE_MIPMAP_TYPE_FLOAT16;
+            mip->Channels = 1;
+            break;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            mip->Type     = IMAGE_MIPMAP_TYPE_FLOAT32;
+            mip->Channels = 4;
+            break;
+        case DXGI_FORMAT_R32G32_FLOAT:
+            mip->Type     = IMAGE_MIPMAP_TYPE_FLOAT32;
+            mip->Channels = 2;
+            break;
+        case DXGI_FORMAT_R32_FLOAT:
+            mip->Type     = IMAGE_MIPMAP_TYPE_FLOAT32;
+            mip->Channels = 1;
+            break;
+        default:
+            return false;
+    }
+    mip->PixelSize = dxgi_bits_per_pixel(format) / 8;
+    if (mip->SRGB)
+    {   // build the decode table, and the linear midpoints between adjacent encoded values.
+        mip->Threshold[0] = -FLT_MAX;
+        for (size_t i = 0; i < 256; ++i)
+        {
+            mip->ToLinear[i] = image_srgb_to_linear(float(i) / 255.0f);
+            if (i > 0) mip->Threshold[i] = image_srgb_to_linear((float(i) - 0.5f) / 255.0f);
+        }
+    }
+    return true;
+}
+
+/// @summary Produce the rows of a mipmap level from the rows of the next-larger level. Target row y is
+/// the average of source rows 2y and 2y+1; the second is clamped to the last available source row.
+/// @param mip The filter description, initialized by image_mipmap_init().
+/// @param pool The worker pool used to reduce bands of rows in parallel, or NULL.
+/// @param src The first source row.
+/// @param src_width The width of the source level, in pixels.
+/// @param src_height The number of source rows available at src.
+/// @param src_pitch The number of bytes between source rows.
+/// @param dst The first target row.
+/// @param dst_width The width of the target level, in pixels.
+/// @param dst_height The number of target rows to produce.
+/// @param dst_pitch The number of bytes between target rows.
+public_function void image_mipmap_reduce(image_mipmap_t const *mip, work_pool_t *pool, void const *src, size_t src_width, size_t src_height, size_t src_pitch, void *dst, size_t dst_width, size_t dst_height, size_t dst_pitch)
+{
+    image_mipmap_band_t band;
+    band.Filter       = mip;
+    band.Source       =(uint8_t const*) src;
+    band.SourceWidth  = src_width;
+    band.SourceHeight = src_height;
+    band.SourcePitch  = src_pitch;
+    band.Target       =(uint8_t*) dst;
+    band.TargetWidth  = dst_width;
+    band.TargetHeight = dst_height;
+    band.TargetPitch  = dst_pitch;
+    work_pool_run(pool, image_mipmap_reduce_band, &band, (dst_height + IMAGE_MIPMAP_BAND_ROWS - 1) / IMAGE_MIPMAP_BAND_ROWS);
+}
@@ -65,6 +65,28 @@ struct image_parser_config_t
     uint32_t                  ParseFlags;          /// A combination image_parser_flags_e controlling parser behavior.
     int                       Compression;         /// One of image_compression_e specifying the destination storage compression format.
     int                       Encoding;            /// One of image_encoding_e specifying the destination storage encoding.
+    uint32_t                  Format;              /// One of dxgi_format_e specifying the destination storage format, or DXGI_FORMAT_UNKNOWN to keep the source format.
+    int                       Quality;             /// One of image_encoder_quality_e, used when the destination format differs from the source format.
+    work_pool_t              *WorkPool;            /// The worker pool used to convert pixel data in parallel, or NULL.
+    uint32_t                  EncoderFlags;        /// A combination of image_encoder_flags_e enabling optional encoder stages.
+};
+
+/// @summary Define the ways in which the rows of a single-level image are written to the encoder.
+enum image_row_order_e : int
+{
+    IMAGE_ROW_ORDER_TOP_DOWN           = 0,        /// The source rows are stored top-down, and are appended in order.
+    IMAGE_ROW_ORDER_PLACED             = 1,        /// The source rows are stored bottom-up, and each is written to its flipped offset with encode_rows.
+    IMAGE_ROW_ORDER_BUFFERED           = 2,        /// The source rows are stored bottom-up, but the encoder can only append, so the level is buffered.
+};
+
+/// @summary Tracks the rows written by a parser for a format that may store rows bottom-up, such as TGA or BMP.
+struct image_row_writer_t
+{
+    int                       Order;               /// One of image_row_order_e.
+    size_t                    Pitch;               /// The number of bytes in each output row.
+    size_t                    Height;              /// The number of rows in the image.
+    size_t                    RowIndex;            /// The number of rows written so far, in source order.
+    uint8_t                  *Buffer;              /// Storage for the entire level, for IMAGE_ROW_ORDER_BUFFERED only.
 };
 
 /*///////////////
@@ -137,3 +159,124 @@ void image_parser_list_delete(image_parser_list_t<T> *ipsl)
     ipsl->SourceStream = NULL;
     ipsl->ParseState   = NULL;
 }
+
+/// @summary Initialize a row writer for a single-level image.
+/// @param writer The row writer to initialize.
+/// @param pitch The number of bytes in each output row.
+/// @param height The number of rows in the image.
+/// @param bottom_up true if the source rows are stored bottom-up.
+public_function void image_row_writer_init(image_row_writer_t *writer, size_t pitch, size_t height, bool bottom_up)
+{
+    writer->Order    = bottom_up ? IMAGE_ROW_ORDER_PLACED : IMAGE_ROW_ORDER_TOP_DOWN;
+    writer->Pitch    = pitch;
+    writer->Height   = height;
+    writer->RowIndex = 0;
+    writer->Buffer   = NULL;
+}
+
+/// @summary Write rows to the image encoder in source order. Rows of a bottom-up image are written directly to their flipped offsets in image memory if the encoder supports it; otherwise they are buffered until image_row_writer_finish() is called.
+/// @param writer The row writer.
+/// @param encoder The image encoder.
+/// @param rows The output rows, packed at the output row pitch, in source order.
+/// @param count The number of rows.
+/// @return ERROR_SUCCESS, ERROR_OUTOFMEMORY, or an error code returned by the encoder.
+public_function uint32_t image_row_writer_write(image_row_writer_t *writer, image_encoder_t *encoder, void const *rows, size_t count)
+{
+    uint8_t const *src = (uint8_t const*) rows;
+    if (count > writer->Height - writer->RowIndex)
+    {   // more rows than the image contains.
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (writer->Order == IMAGE_ROW_ORDER_TOP_DOWN)
+    {
+        writer->RowIndex += count;
+        return encoder->encode(0, src, count * writer->Pitch);
+    }
+    if (writer->Order == IMAGE_ROW_ORDER_PLACED)
+    {
+        for (size_t i = 0; i < count; ++i, ++writer->RowIndex, src += writer->Pitch)
+        {
+            uint32_t res  = encoder->encode_rows(0, writer->Height - 1 - writer->RowIndex, src, 1);
+            if (res == ERROR_NOT_SUPPORTED && writer->RowIndex == 0)
+            {   // the encoder can only append, so fall back to buffering the level.
+                if ((writer->Buffer = (uint8_t*) malloc(writer->Height * writer->Pitch)) == NULL)
+                    return ERROR_OUTOFMEMORY;
+                writer->Order = IMAGE_ROW_ORDER_BUFFERED;
+                return image_row_writer_write(writer, encoder, src, count - i);
+            }
+            if (res != ERROR_SUCCESS)
+                return res;
+        }
+        return ERROR_SUCCESS;
+    }
+    for (size_t i = 0; i < count; ++i, ++writer->RowIndex, src += writer->Pitch)
+    {
+        memcpy(writer->Buffer + (writer->Height - 1 - writer->RowIndex) * writer->Pitch, src, writer->Pitch);
+    }
+    return ERROR_SUCCESS;
+}
+
+/// @summary Complete the level once all rows have been written, appending the buffered level to the encoder if necessary. The caller marks the end of the level and element.
+/// @param writer The row writer.
+/// @param encoder The image encoder.
+/// @return ERROR_SUCCESS, or an error code returned by the encoder.
+public_function uint32_t image_row_writer_finish(image_row_writer_t *writer, image_encoder_t *encoder)
+{
+    uint32_t res = ERROR_SUCCESS;
+    if (writer->Order == IMAGE_ROW_ORDER_BUFFERED && writer->Buffer != NULL)
+    {
+        res = encoder->encode(0, writer->Buffer, writer->Height * writer->Pitch);
+    }
+    free(writer->Buffer);
+    writer->Buffer = NULL;
+    return res;
+}
+
+/// @summary Free any storage held by a row writer.
+/// @param writer The row writer.
+public_function void image_row_writer_free(image_row_writer_t *writer)
+{
+    free(writer->Buffer);
+    writer->Buffer = NULL;
+}
+
+/// @summary Initialize a parser configuration that reads every frame of a file held in memory into image memory, 
+/// without going through the I/O system. No definition or placement notifications are posted. This is used to 
+/// measure parser throughput independently of the storage device.
+/// @param config On return, the parser configuration.
+/// @param decoder The stream decoder to point at the file data. The decoder reports end-of-stream after the final byte.
+/// @param data The contents of the file. The data must remain valid until the parser has finished.
+/// @param size The size of the file, in bytes.
+/// @param mem The image memory where pixel data will be stored.
+/// @param meta The image definition to fill with the metadata read from the file.
+/// @param image_id The application-defined logical image identifier.
+public_function void image_parser_memory_config(image_parser_config_t &config, stream_decoder_t *decoder, void const *data, size_t size, image_memory_t *mem, image_definition_t *meta, uintptr_t image_id)
+{
+    decoder->refill                 = stream_refill_error;
+    decoder->FirstByte              =(uint8_t*) data;
+    decoder->FinalByte              =(uint8_t*) data + size;
+    decoder->ReadCursor             =(uint8_t*) data;
+    decoder->StatusFlags            = STREAM_DECODE_STATUS_ENDOFSTREAM;
+    decoder->FileOffset             = 0;
+    decoder->DecodeOffset           = 0;
+    config.ImageId                  = image_id;
+    config.Context                  = 0;
+    config.FirstFrame               = 0;
+    config.FinalFrame               = IMAGE_ALL_FRAMES;
+    config.Decoder                  = decoder;
+    config.Memory                   = mem;
+    config.Metadata                 = meta;
+    config.DefinitionQueue          = NULL;
+    config.DefinitionAlloc          = NULL;
+    config.PlacementQueue           = NULL;
+    config.PlacementAlloc           = NULL;
+    config.StartOffset.FileOffset   = 0;
+    config.StartOffset.DecodeOffset = 0;
+    config.ParseFlags               = IMAGE_PARSER_FLAGS_READ_ALL | IMAGE_PARSER_FLAGS_START_AT_OFFSET;
+    config.Compression              = IMAGE_COMPRESSION_NONE;
+    config.Encoding                 = IMAGE_ENCODING_RAW;
+    config.Format                   = DXGI_FORMAT_UNKNOWN;
+    config.Quality                  = IMAGE_ENCODER_QUALITY_FAST;
+    config.WorkPool                 = NULL;
+    config.EncoderFlags             = IMAGE_ENCODER_FLAGS_NONE;
+}
@@ -0,0 +1,863 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a streaming parser for Windows BMP files. The parser
+/// consumes the file in whatever chunks the stream decoder produces; only the
+/// headers and palette are buffered. Uncompressed, bit-field and RLE4/RLE8
+/// encoded rows are converted to an 8-bit DXGI format as soon as they are
+/// complete. Rows of bottom-up images are written directly to their flipped
+/// offsets in image memory, so no second pass over the image is required.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The size of the BITMAPFILEHEADER at the start of the file, in bytes.
+#define BMP_FILE_HEADER_SIZE      14
+
+/// @summary The size of the largest DIB header, BITMAPV5HEADER, in bytes.
+#define BMP_MAX_DIB_HEADER_SIZE   124
+
+/// @summary The size of the buffer used for the DIB header, bit masks and palette.
+#define BMP_HEADER_BUFFER_SIZE   (BMP_MAX_DIB_HEADER_SIZE + 16 + 256 * 4)
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define identifiers for the recognized parser states.
+enum bmp_parser_state_e : int
+{
+    BMP_PARSE_STATE_SEEK_OFFSET          = 0,   /// The parser is looking for a known byte offset.
+    BMP_PARSE_STATE_FILE_HEADER          = 1,   /// The parser is receiving the BITMAPFILEHEADER.
+    BMP_PARSE_STATE_BUFFER_HEADER        = 2,   /// The parser is receiving the DIB header, bit masks and palette.
+    BMP_PARSE_STATE_SKIP_TO_PIXELS       = 3,   /// The parser is skipping data between the headers and the pixel data.
+    BMP_PARSE_STATE_PIXEL_DATA           = 4,   /// The parser is receiving uncompressed pixel data.
+    BMP_PARSE_STATE_RLE_DATA             = 5,   /// The parser is receiving RLE4 or RLE8 encoded pixel data.
+    BMP_PARSE_STATE_COMPLETE             = 6,   /// The parser has processed the entire file contents.
+    BMP_PARSE_STATE_ERROR                = 7    /// The parser has encountered a fatal error.
+};
+
+/// @summary Define identifiers for the recognized parser errors.
+enum bmp_parser_error_e : int
+{
+    BMP_PARSE_ERROR_SUCCESS              = 0,   /// No error has occurred.
+    BMP_PARSE_ERROR_NOMEMORY             = 1,   /// Required memory could not be allocated.
+    BMP_PARSE_ERROR_DECODER              = 2,   /// The underlying stream decoder returned an error.
+    BMP_PARSE_ERROR_NOENCODER            = 3,   /// No encoder was found that supports the required transcoding.
+    BMP_PARSE_ERROR_ENCODER              = 4,   /// The image encoder returned an error.
+    BMP_PARSE_ERROR_BAD_DATA             = 5,   /// The file is not a valid BMP, or is truncated.
+    BMP_PARSE_ERROR_UNSUPPORTED          = 6,   /// The file uses a feature the parser doesn't support.
+};
+
+/// @summary Define the possible return codes from the top-level streaming parser update function.
+enum bmp_parser_result_e : int
+{
+    BMP_PARSE_RESULT_CONTINUE            = 0,   /// The parser is yielding, waiting for more data.
+    BMP_PARSE_RESULT_COMPLETE            = 1,   /// Stop parsing. All data was parsed successfully.
+    BMP_PARSE_RESULT_ERROR               = 2    /// Stop parsing. An error was encountered.
+};
+
+/// @summary Define the BMP compression types specified in the DIB header.
+enum bmp_compression_e : uint32_t
+{
+    BMP_COMPRESSION_RGB                  = 0,   /// Uncompressed pixels or palette indices.
+    BMP_COMPRESSION_RLE8                 = 1,   /// Run-length encoded 8-bit palette indices.
+    BMP_COMPRESSION_RLE4                 = 2,   /// Run-length encoded 4-bit palette indices.
+    BMP_COMPRESSION_BITFIELDS            = 3,   /// Uncompressed pixels with red, green and blue bit masks.
+    BMP_COMPRESSION_ALPHABITFIELDS       = 6,   /// Uncompressed pixels with red, green, blue and alpha bit masks.
+};
+
+/// @summary Define the conversions from BMP pixels to DXGI formats.
+enum bmp_convert_e : int
+{
+    BMP_CONVERT_COPY                     = 0,   /// 32-bit BGRX or BGRA pixels are written as-is.
+    BMP_CONVERT_PALETTE                  = 1,   /// 1, 4 or 8-bit indices are expanded through the palette.
+    BMP_CONVERT_BGR8                     = 2,   /// 24-bit BGR pixels are expanded to BGRX.
+    BMP_CONVERT_MASKS                    = 3,   /// 16 or 32-bit pixels are unpacked using the channel bit masks.
+};
+
+/// @summary Define the RLE escape codes, which follow a zero count byte.
+enum bmp_rle_escape_e : uint8_t
+{
+    BMP_RLE_END_OF_LINE                  = 0,   /// The remainder of the row is left unset.
+    BMP_RLE_END_OF_BITMAP                = 1,   /// The remainder of the image is left unset.
+    BMP_RLE_DELTA                        = 2,   /// The next two bytes move the position right and up.
+};
+
+/// @summary Define the state data associated with a streaming BMP file parser.
+struct bmp_parser_state_t
+{
+    int                   CurrentState;         /// One of bmp_parser_state_e.
+    int                   ParserError;          /// One of bmp_parser_error_e.
+    image_parser_config_t Config;               /// The input parser configuration.
+    image_encoder_t      *Encoder;              /// The local image encoder. Deleted on error or completion.
+    image_definition_t   *Metadata;             /// Pointer to the image metadata block.
+    image_row_writer_t    Rows;                 /// Writes converted rows to the encoder, flipping bottom-up images.
+    size_t                HeaderWritePos;       /// The current write position in HeaderBuffer.
+    size_t                HeaderSize;           /// The number of bytes of HeaderBuffer to receive.
+    size_t                SkipRemain;           /// The number of bytes remaining to be skipped before the pixel data.
+    uint32_t              Compression;          /// One of bmp_compression_e.
+    uint16_t              PixelBits;            /// The number of bits per pixel or palette index.
+    bool                  BottomUp;             /// true if rows are stored bottom-up.
+    int                   Conversion;           /// One of bmp_convert_e.
+    uint32_t              Format;               /// One of dxgi_format_e specifying the format of the encoded pixel data.
+    size_t                Width;                /// The image width, in pixels.
+    size_t                Height;               /// The image height, in pixels.
+    size_t                RowSize;              /// The size of a stored row, including padding to a four-byte boundary.
+    size_t                RowFill;              /// The number of bytes of the current row received, or the current column for RLE data.
+    size_t                OutputRowSize;        /// The size of a converted row, in bytes.
+    uint32_t              ChannelMask [4];      /// The bit masks of the red, green, blue and alpha channels.
+    uint32_t              ChannelShift[4];      /// The right shift applied to each masked channel value before scaling.
+    size_t                RleLiteral;           /// The number of literal indices remaining in the current absolute-mode run.
+    size_t                RlePadding;           /// The number of padding bytes remaining after the current absolute-mode run.
+    size_t                RleCodeFill;          /// The number of bytes received in RleCode.
+    bool                  RleDelta;             /// true if RleCode is receiving the offsets of a delta escape.
+    uint8_t               RleCode[2];           /// The count and value, or escape code, being received.
+    uint8_t              *RowMemory;            /// The allocation containing the row buffers.
+    uint8_t              *CurrentRow;           /// The stored row being received, or the palette indices for RLE data.
+    uint8_t              *OutputRow;            /// The converted row.
+    uint32_t              Palette[256];         /// The palette as B8G8R8A8 values.
+    uint8_t               ChannelScale[4][256]; /// Tables mapping shifted channel values to 8 bits.
+    uint8_t               HeaderBuffer[BMP_HEADER_BUFFER_SIZE]; /// Internal buffer for the file header, then the DIB header, bit masks and palette.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Reads a little-endian 16-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint16_t bmp_u16(uint8_t const *p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+/// @summary Reads a little-endian 32-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint32_t bmp_u32(uint8_t const *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/// @summary Builds the shift and scale table used to expand a channel bit mask to 8 bits.
+/// @param bmpp The BMP parser state.
+/// @param channel The zero-based channel index, 0-3 for red, green, blue and alpha.
+/// @return false if the mask bits are not contiguous.
+internal_function bool bmp_setup_channel(bmp_parser_state_t *bmpp, size_t channel)
+{
+    uint32_t mask  = bmpp->ChannelMask[channel];
+    uint32_t shift = 0;
+    uint32_t bits  = 0;
+    if (mask == 0)
+    {   // a missing color channel reads as zero; a missing alpha channel as opaque.
+        bmpp->ChannelShift[channel] = 0;
+        memset(bmpp->ChannelScale[channel], channel == 3 ? 0xFF : 0x00, 256);
+        return true;
+    }
+    while ((mask & (1U << shift)) == 0) ++shift;
+    while (shift + bits < 32 && (mask & (1U << (shift + bits))) != 0) ++bits;
+    if (((mask >> shift) + 1) & (mask >> shift))
+    {   // there's a gap in the mask.
+        return false;
+    }
+    if (bits > 8)
+    {   // keep the most significant eight bits.
+        shift += bits - 8;
+        bits   = 8;
+    }
+    uint32_t max_value = (1U << bits) - 1;
+    bmpp->ChannelShift[channel] = shift;
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t v = i & max_value;
+        bmpp->ChannelScale[channel][i] = uint8_t((v * 255 + max_value / 2) / max_value);
+    }
+    return true;
+}
+
+/// @summary Converts a complete row of palette indices or pixels to the output format and writes it to the encoder.
+/// @param bmpp The BMP parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @param src The stored row. For RLE data, this is one 8-bit palette index per pixel.
+/// @return true if the row was written, or false if the encoder returned an error.
+internal_function bool bmp_emit_row(bmp_parser_state_t *bmpp, image_encoder_t *encoder, uint8_t const *src)
+{
+    size_t   const width = bmpp->Width;
+    uint8_t const *row   = src;
+    uint8_t       *dst   = bmpp->OutputRow;
+    switch (bmpp->Conversion)
+    {
+    case BMP_CONVERT_COPY:
+        break;
+    case BMP_CONVERT_PALETTE:
+        {
+            size_t const bits = bmpp->Compression == BMP_COMPRESSION_RGB ? bmpp->PixelBits : 8;
+            size_t const mask =(size_t(1) << bits) - 1;
+            for (size_t i = 0; i < width; ++i)
+            {   // indices are packed most-significant bits first.
+                size_t bit   = i * bits;
+                size_t index =(src[bit >> 3] >> (8 - bits - (bit & 7))) & mask;
+                memcpy(dst + i * 4, &bmpp->Palette[index], sizeof(uint32_t));
+            }
+            row = dst;
+        }
+        break;
+    case BMP_CONVERT_BGR8:
+        for (size_t i = 0; i < width; ++i)
+        {
+            dst[i * 4 + 0] = src[i * 3 + 0];
+            dst[i * 4 + 1] = src[i * 3 + 1];
+            dst[i * 4 + 2] = src[i * 3 + 2];
+            dst[i * 4 + 3] = 0xFF;
+        }
+        row = dst;
+        break;
+    case BMP_CONVERT_MASKS:
+        for (size_t i = 0; i < width; ++i)
+        {
+            uint32_t v = bmpp->PixelBits == 16 ? bmp_u16(src + i * 2) : bmp_u32(src + i * 4);
+            dst[i * 4 + 0] = bmpp->ChannelScale[2][((v & bmpp->ChannelMask[2]) >> bmpp->ChannelShift[2]) & 0xFF];
+            dst[i * 4 + 1] = bmpp->ChannelScale[1][((v & bmpp->ChannelMask[1]) >> bmpp->ChannelShift[1]) & 0xFF];
+            dst[i * 4 + 2] = bmpp->ChannelScale[0][((v & bmpp->ChannelMask[0]) >> bmpp->ChannelShift[0]) & 0xFF];
+            dst[i * 4 + 3] = bmpp->ChannelScale[3][((v & bmpp->ChannelMask[3]) >> bmpp->ChannelShift[3]) & 0xFF];
+        }
+        row = dst;
+        break;
+    }
+    uint32_t res = image_row_writer_write(&bmpp->Rows, encoder, row, 1);
+    if (res != ERROR_SUCCESS)
+    {
+        bmpp->ParserError = res == ERROR_OUTOFMEMORY ? BMP_PARSE_ERROR_NOMEMORY : BMP_PARSE_ERROR_ENCODER;
+        return false;
+    }
+    return true;
+}
+
+/// @summary Completes the image once all rows have been written.
+/// @param bmpp The BMP parser state.
+/// @param encoder The image encoder to which pixel data was written.
+/// @return The new parser state.
+internal_function int bmp_finish_image(bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{
+    if (image_row_writer_finish(&bmpp->Rows, encoder) != ERROR_SUCCESS)
+    {
+        bmpp->ParserError = BMP_PARSE_ERROR_ENCODER;
+        return BMP_PARSE_STATE_ERROR;
+    }
+    encoder->mark_level(0);
+    encoder->mark_element(0);
+    return BMP_PARSE_STATE_COMPLETE;
+}
+
+/// @summary Validates the DIB header, reads the bit masks and palette, and determines the format of the encoded pixel data.
+/// @param bmpp The BMP parser state, with the DIB header, bit masks and palette in HeaderBuffer.
+/// @return The new parser state.
+internal_function int bmp_process_header(bmp_parser_state_t *bmpp)
+{
+    uint8_t const *data  = bmpp->HeaderBuffer;
+    size_t  const  size  = bmpp->HeaderSize;
+    size_t  const  dib   = bmp_u32(data);
+    size_t         entry = 4;
+    size_t         count = 0;
+    int32_t        w     = 0;
+    int32_t        h     = 0;
+    if (dib == 12 && size >= 12)
+    {   // BITMAPCOREHEADER, with 16-bit dimensions and 3-byte palette entries.
+        w = int32_t(bmp_u16(data + 4));
+        h = int32_t(bmp_u16(data + 6));
+        bmpp->PixelBits   = bmp_u16(data + 10);
+        bmpp->Compression = BMP_COMPRESSION_RGB;
+        entry = 3;
+    }
+    else if (dib >= 40 && dib <= BMP_MAX_DIB_HEADER_SIZE && dib <= size)
+    {   // BITMAPINFOHEADER or one of its extensions.
+        w = int32_t(bmp_u32(data + 4));
+        h = int32_t(bmp_u32(data + 8));
+        bmpp->PixelBits   = bmp_u16(data + 14);
+        bmpp->Compression = bmp_u32(data + 16);
+        count = bmp_u32(data + 32);
+    }
+    else
+    {   // not a known DIB header, or the pixel data overlaps the header.
+        bmpp->ParserError = BMP_PARSE_ERROR_BAD_DATA;
+        return BMP_PARSE_STATE_ERROR;
+    }
+    if (w <= 0 || h == 0 || h == INT32_MIN)
+    {   // invalid dimensions.
+        bmpp->ParserError = BMP_PARSE_ERROR_BAD_DATA;
+        return BMP_PARSE_STATE_ERROR;
+    }
+    bmpp->Width    = size_t(w);
+    bmpp->Height   = size_t(h < 0 ? -int64_t(h) : int64_t(h));
+    bmpp->BottomUp = h > 0;
+
+    // the bit masks follow a BITMAPINFOHEADER, and are part of the later headers.
+    size_t palette = dib;
+    if (bmpp->Compression == BMP_COMPRESSION_BITFIELDS || bmpp->Compression == BMP_COMPRESSION_ALPHABITFIELDS)
+    {
+        size_t masks =(bmpp->Compression == BMP_COMPRESSION_ALPHABITFIELDS || dib >= 56) ? 4 : 3;
+        if (dib == 40) palette += masks * 4;
+        if (dib == 64)
+        {   // in an OS/2 2.x header, compression type 3 is Huffman 1D.
+            bmpp->ParserError = BMP_PARSE_ERROR_UNSUPPORTED;
+            return BMP_PARSE_STATE_ERROR;
+        }
+        if (palette > size || (bmpp->PixelBits != 16 && bmpp->PixelBits != 32))
+        {
+            bmpp->ParserError = BMP_PARSE_ERROR_BAD_DATA;
+            return BMP_PARSE_STATE_ERROR;
+        }
+        for (size_t i = 0; i < masks; ++i)
+            bmpp->ChannelMask[i] = bmp_u32(data + 40 + i * 4);
+    }
+
+    bool valid = false;
+    switch (bmpp->Compression)
+    {
+    case BMP_COMPRESSION_RGB:
+        valid = bmpp->PixelBits == 1 || bmpp->PixelBits == 4 || bmpp->PixelBits == 8 || bmpp->PixelBits == 16 || bmpp->PixelBits == 24 || bmpp->PixelBits == 32;
+        if (bmpp->PixelBits <= 8)
+        {
+            bmpp->Conversion = BMP_CONVERT_PALETTE;
+        }
+        else if (bmpp->PixelBits == 16)
+        {   // X1R5G5B5.
+            bmpp->Conversion = BMP_CONVERT_MASKS;
+            bmpp->ChannelMask[0] = 0x7C00;
+            bmpp->ChannelMask[1] = 0x03E0;
+            bmpp->ChannelMask[2] = 0x001F;
+        }
+        else
+        {   // the fourth byte of 32-bit pixels is unused.
+            bmpp->Conversion = bmpp->PixelBits == 24 ? BMP_CONVERT_BGR8 : BMP_CONVERT_COPY;
+        }
+        bmpp->Format = DXGI_FORMAT_B8G8R8X8_UNORM;
+        break;
+    case BMP_COMPRESSION_RLE8:
+        valid = bmpp->PixelBits == 8;
+        bmpp->Conversion = BMP_CONVERT_PALETTE;
+        bmpp->Format     = DXGI_FORMAT_B8G8R8X8_UNORM;
+        break;
+    case BMP_COMPRESSION_RLE4:
+        valid = bmpp->PixelBits == 4;
+        bmpp->Conversion = BMP_CONVERT_PALETTE;
+        bmpp->Format     = DXGI_FORMAT_B8G8R8X8_UNORM;
+        break;
+    case BMP_COMPRESSION_BITFIELDS:
+    case BMP_COMPRESSION_ALPHABITFIELDS:
+        valid = true;
+        if (bmpp->PixelBits == 32 && bmpp->ChannelMask[0] == 0x00FF0000 && bmpp->ChannelMask[1] == 0x0000FF00 && bmpp->ChannelMask[2] == 0x000000FF &&
+           (bmpp->ChannelMask[3] == 0xFF000000 || bmpp->ChannelMask[3] == 0))
+        {   // the pixels are already stored as BGRA or BGRX.
+            bmpp->Conversion = BMP_CONVERT_COPY;
+        }
+        else
+        {
+            bmpp->Conversion = BMP_CONVERT_MASKS;
+        }
+        bmpp->Format = bmpp->ChannelMask[3] != 0 ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8X8_UNORM;
+        break;
+    default:
+        break;
+    }
+    if (!valid || (h < 0 && (bmpp->Compression == BMP_COMPRESSION_RLE8 || bmpp->Compression == BMP_COMPRESSION_RLE4)))
+    {   // the compression type or bit depth isn't supported, or RLE data is stored top-down.
+        bmpp->ParserError = BMP_PARSE_ERROR_UNSUPPORTED;
+        return BMP_PARSE_STATE_ERROR;
+    }
+    if (bmpp->Conversion == BMP_CONVERT_MASKS)
+    {
+        for (size_t i = 0; i < 4; ++i)
+        {
+            if (!bmp_setup_channel(bmpp, i))
+            {
+                bmpp->ParserError = BMP_PARSE_ERROR_UNSUPPORTED;
+                return BMP_PARSE_STATE_ERROR;
+            }
+        }
+    }
+    if (bmpp->Conversion == BMP_CONVERT_PALETTE)
+    {   // the palette follows the headers and bit masks.
+        size_t max_count = size_t(1) << bmpp->PixelBits;
+        if (count == 0 || count > max_count) count = max_count;
+        if (palette + count * entry > size)
+        {   // some writers store a shorter palette than the header claims; missing entries are black.
+            count = palette < size ? (size - palette) / entry : 0;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint8_t const *p = data + palette + i * entry;
+            bmpp->Palette[i] = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | 0xFF000000U;
+        }
+    }
+    bmpp->RowSize       =((bmpp->Width * bmpp->PixelBits + 31) / 32) * 4;
+    bmpp->OutputRowSize = dxgi_pitch(bmpp->Format, bmpp->Width);
+    return BMP_PARSE_STATE_SKIP_TO_PIXELS;
+}
+
+/// @summary Calculates all of the static data and allocates the row buffers once the start of the pixel data is reached.
+/// @param bmpp The parser state to update.
+/// @return The new parser state.
+internal_function int bmp_parser_setup_image_info(bmp_parser_state_t *bmpp)
+{
+    image_definition_t *meta  = bmpp->Metadata;
+    uint32_t            alpha =(bmpp->Format == DXGI_FORMAT_B8G8R8A8_UNORM) ? DDS_ALPHA_MODE_STRAIGHT : DDS_ALPHA_MODE_OPAQUE;
+    if (bmpp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // completely initialize the metadata block with information we've read.
+        dds_header_t       dds;
+        dds_header_dxt10_t dx10;
+        dds_headers_for_image(&dds, &dx10, bmpp->Format, bmpp->Width, bmpp->Height, alpha);
+        if (!dds_image_definition(meta, bmpp->Config.ImageId, &dds, &dx10, bmpp->Config.Compression, bmpp->Config.Encoding))
+        {   // unable to allocate storage for the mip-level descriptors and offsets.
+            bmpp->ParserError = BMP_PARSE_ERROR_NOMEMORY;
+            return BMP_PARSE_STATE_ERROR;
+        }
+    }
+
+    // create the image encoder instance.
+    bmpp->Encoder = create_image_encoder(
+        bmpp->Config.ImageId,
+        bmpp->Config.Memory,
+        IMAGE_COMPRESSION_NONE,
+        IMAGE_ENCODING_RAW,
+        bmpp->Config.Compression,
+        bmpp->Config.Encoding,
+        dds_access_type(meta),
+        bmpp->Config.DefinitionQueue,
+        bmpp->Config.DefinitionAlloc,
+        bmpp->Config.PlacementQueue,
+        bmpp->Config.PlacementAlloc,
+        meta->ImageFormat,
+        bmpp->Config.Format,
+        bmpp->Config.Quality,
+        bmpp->Config.WorkPool,
+        bmpp->Config.EncoderFlags);
+    if (bmpp->Encoder == NULL)
+    {   // unable to create the encoder to write to image memory.
+        bmpp->ParserError = BMP_PARSE_ERROR_NOENCODER;
+        return BMP_PARSE_STATE_ERROR;
+    }
+    if (bmpp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // notify the encoder of the image attributes:
+        if (bmpp->Encoder->define_image(meta) != ERROR_SUCCESS)
+        {
+            bmpp->ParserError = BMP_PARSE_ERROR_ENCODER;
+            return BMP_PARSE_STATE_ERROR;
+        }
+    }
+    else
+    {   // the image is already defined, but encoders that change the format need the source attributes.
+        bmpp->Encoder->Metadata = meta;
+    }
+
+    // a BMP file stores a single image element.
+    if ((bmpp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_PIXELS) == 0 || bmpp->Config.FirstFrame >= meta->ElementCount)
+    {   // not reading any pixel data, so we're done.
+        return BMP_PARSE_STATE_COMPLETE;
+    }
+
+    // allocate the stored row and converted row buffers. RLE data is expanded to one index per pixel.
+    bool   rle        = bmpp->Compression == BMP_COMPRESSION_RLE8 || bmpp->Compression == BMP_COMPRESSION_RLE4;
+    size_t row_bytes  = rle ? bmpp->Width : bmpp->RowSize;
+    size_t row_stride =(row_bytes + 15) & ~size_t(15);
+    if ((bmpp->RowMemory = (uint8_t*) malloc(row_stride + bmpp->OutputRowSize)) == NULL)
+    {
+        bmpp->ParserError = BMP_PARSE_ERROR_NOMEMORY;
+        return BMP_PARSE_STATE_ERROR;
+    }
+    bmpp->CurrentRow = bmpp->RowMemory;
+    bmpp->OutputRow  = bmpp->RowMemory + row_stride;
+    bmpp->RowFill    = 0;
+    if (rle)
+    {   // pixels skipped by escape codes use the first palette entry.
+        memset(bmpp->CurrentRow, 0, row_bytes);
+    }
+    image_row_writer_init(&bmpp->Rows, bmpp->OutputRowSize, bmpp->Height, bmpp->BottomUp);
+    bmpp->Encoder->reset_element(0);
+    return rle ? BMP_PARSE_STATE_RLE_DATA : BMP_PARSE_STATE_PIXEL_DATA;
+}
+
+/// @summary Implements the parser logic for the BMP_PARSE_STATE_SEEK_OFFSET.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param bmpp The BMP parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int bmp_seek_offset(stream_decoder_t *decoder, bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    stream_decode_pos_t &target  = bmpp->Config.StartOffset;
+    stream_decode_pos_t  current;  decoder->pos(current);
+    if (current.FileOffset      >= target.FileOffset &&
+        current.FileOffset      <= target.FileOffset)
+    {   // this encoded data chunk contains the start of the data we're looking for.
+        size_t available         = decoder->amount();
+        size_t consume           =(target.DecodeOffset >= available) ? available : target.DecodeOffset;
+        decoder->ReadCursor     += consume; // consume from available decoded input
+        target.DecodeOffset     -= consume; // decrement bytes remaining to consume
+        if (decoder->ReadCursor != decoder->FinalByte)
+        {   // the headers describe the pixel layout, so they're always read.
+            return BMP_PARSE_STATE_FILE_HEADER;
+        }
+        // else, refill the decoded data buffer and remain in the same state.
+    }
+    return BMP_PARSE_STATE_SEEK_OFFSET;
+}
+
+/// @summary Implements the parser logic for the BMP_PARSE_STATE_FILE_HEADER.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param bmpp The BMP parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int bmp_file_header(stream_decoder_t *decoder, bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = BMP_FILE_HEADER_SIZE - bmpp->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&bmpp->HeaderBuffer[bmpp->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    bmpp->HeaderWritePos    += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (bmpp->HeaderWritePos < BMP_FILE_HEADER_SIZE)
+    {   // this is a partial read; wait for more data.
+        return BMP_PARSE_STATE_FILE_HEADER;
+    }
+    size_t offset = bmp_u32(&bmpp->HeaderBuffer[10]);
+    if (bmpp->HeaderBuffer[0] != 'B' || bmpp->HeaderBuffer[1] != 'M' || offset < BMP_FILE_HEADER_SIZE + 12)
+    {   // this isn't a BMP file, or there's no room for a DIB header.
+        bmpp->ParserError = BMP_PARSE_ERROR_BAD_DATA;
+        return BMP_PARSE_STATE_ERROR;
+    }
+    // buffer everything up to the pixel data, which may include unused gaps.
+    bmpp->HeaderSize     = offset - BMP_FILE_HEADER_SIZE;
+    bmpp->SkipRemain     = 0;
+    if (bmpp->HeaderSize > BMP_HEADER_BUFFER_SIZE)
+    {
+        bmpp->SkipRemain = bmpp->HeaderSize - BMP_HEADER_BUFFER_SIZE;
+        bmpp->HeaderSize = BMP_HEADER_BUFFER_SIZE;
+    }
+    bmpp->HeaderWritePos = 0;
+    return BMP_PARSE_STATE_BUFFER_HEADER;
+}
+
+/// @summary Implements the parser logic for the BMP_PARSE_STATE_BUFFER_HEADER.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param bmpp The BMP parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int bmp_buffer_header(stream_decoder_t *decoder, bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = bmpp->HeaderSize - bmpp->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&bmpp->HeaderBuffer[bmpp->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    bmpp->HeaderWritePos    += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (bmpp->HeaderWritePos < bmpp->HeaderSize)
+    {   // this is a partial read; wait for more data.
+        return BMP_PARSE_STATE_BUFFER_HEADER;
+    }
+    return bmp_process_header(bmpp);
+}
+
+/// @summary Implements the parser logic for the BMP_PARSE_STATE_SKIP_TO_PIXELS.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param bmpp The BMP parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int bmp_skip_to_pixels(stream_decoder_t *decoder, bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_skip     =(bmpp->SkipRemain < bytes_available) ? bmpp->SkipRemain : bytes_available;
+    decoder->ReadCursor     += bytes_to_skip;
+    bmpp->SkipRemain        -= bytes_to_skip;
+    if (bmpp->SkipRemain > 0)
+    {   // wait for more data.
+        return BMP_PARSE_STATE_SKIP_TO_PIXELS;
+    }
+    return bmp_parser_setup_image_info(bmpp);
+}
+
+/// @summary Implements the parser logic for the BMP_PARSE_STATE_PIXEL_DATA. Complete rows that need no conversion are written directly from the stream decoder buffer.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param bmpp The BMP parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int bmp_pixel_data(stream_decoder_t *decoder, bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{
+    bool const direct = bmpp->Conversion == BMP_CONVERT_COPY;
+    while (bmpp->Rows.RowIndex < bmpp->Height && decoder->ReadCursor != decoder->FinalByte)
+    {
+        size_t bytes_available = decoder->amount();
+        if (direct && bmpp->RowFill == 0 && bytes_available >= bmpp->RowSize)
+        {   // 32-bit rows have no padding, so pass as many complete rows as possible straight through.
+            size_t   rows = bytes_available / bmpp->RowSize;
+            size_t   left = bmpp->Height - bmpp->Rows.RowIndex;
+            if (rows > left) rows = left;
+            uint32_t res  = image_row_writer_write(&bmpp->Rows, encoder, decoder->ReadCursor, rows);
+            if (res != ERROR_SUCCESS)
+            {
+                bmpp->ParserError = res == ERROR_OUTOFMEMORY ? BMP_PARSE_ERROR_NOMEMORY : BMP_PARSE_ERROR_ENCODER;
+                return BMP_PARSE_STATE_ERROR;
+            }
+            decoder->ReadCursor += rows * bmpp->RowSize;
+            continue;
+        }
+        size_t bytes_to_copy   = bmpp->RowSize - bmpp->RowFill;
+        if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+        memcpy(bmpp->CurrentRow + bmpp->RowFill, decoder->ReadCursor, bytes_to_copy);
+        bmpp->RowFill         += bytes_to_copy;
+        decoder->ReadCursor   += bytes_to_copy;
+        if (bmpp->RowFill == bmpp->RowSize)
+        {   // the row is complete.
+            if (!bmp_emit_row(bmpp, encoder, bmpp->CurrentRow))
+                return BMP_PARSE_STATE_ERROR;
+            bmpp->RowFill = 0;
+        }
+    }
+    if (bmpp->Rows.RowIndex < bmpp->Height)
+    {   // wait for more data.
+        return BMP_PARSE_STATE_PIXEL_DATA;
+    }
+    return bmp_finish_image(bmpp, encoder);
+}
+
+/// @summary Writes the current RLE row and starts the next one.
+/// @param bmpp The BMP parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return true if the row was written, or false if the encoder returned an error.
+internal_function bool bmp_rle_next_row(bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{
+    if (!bmp_emit_row(bmpp, encoder, bmpp->CurrentRow))
+        return false;
+    memset(bmpp->CurrentRow, 0, bmpp->Width);
+    return true;
+}
+
+/// @summary Stores a run of RLE palette indices in the current row, discarding any that fall past the end of the row.
+/// @param bmpp The BMP parser state. RowFill specifies the current column.
+/// @param count The number of pixels.
+/// @param value The index byte. For RLE4 data, the pixels alternate between the high and low nibbles.
+internal_function void bmp_rle_store(bmp_parser_state_t *bmpp, size_t count, uint8_t value)
+{
+    size_t column = bmpp->RowFill;
+    size_t end    =(column + count < bmpp->Width) ? column + count : bmpp->Width;
+    if (bmpp->Compression == BMP_COMPRESSION_RLE8)
+    {
+        if (column < end) memset(bmpp->CurrentRow + column, value, end - column);
+    }
+    else
+    {
+        uint8_t pair[2] = { uint8_t(value >> 4), uint8_t(value & 0x0F) };
+        for (size_t i = column; i < end; ++i)
+            bmpp->CurrentRow[i] = pair[(i - column) & 1];
+    }
+    bmpp->RowFill = column + count;
+}
+
+/// @summary Implements the parser logic for the BMP_PARSE_STATE_RLE_DATA. Runs and escape codes may cross stream decoder chunks.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param bmpp The BMP parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int bmp_rle_data(stream_decoder_t *decoder, bmp_parser_state_t *bmpp, image_encoder_t *encoder)
+{
+    bool const rle4 = bmpp->Compression == BMP_COMPRESSION_RLE4;
+    while (bmpp->Rows.RowIndex < bmpp->Height && decoder->ReadCursor != decoder->FinalByte)
+    {
+        uint8_t byte = *decoder->ReadCursor++;
+        if (bmpp->RleLiteral > 0)
+        {   // absolute mode; each byte stores one RLE8 index or two RLE4 indices.
+            size_t count = (rle4 && bmpp->RleLiteral > 1) ? 2 : 1;
+            bmp_rle_store(bmpp, count, byte);
+            bmpp->RleLiteral -= count;
+            continue;
+        }
+        if (bmpp->RlePadding > 0)
+        {   // absolute runs are padded to a 16-bit boundary.
+            bmpp->RlePadding--;
+            continue;
+        }
+        bmpp->RleCode[bmpp->RleCodeFill++] = byte;
+        if (bmpp->RleCodeFill < 2)
+            continue;
+
+        bmpp->RleCodeFill = 0;
+        uint8_t n = bmpp->RleCode[0];
+        uint8_t v = bmpp->RleCode[1];
+        if (bmpp->RleDelta)
+        {   // move right by n pixels, and up by v rows.
+            bmpp->RleDelta = false;
+            for (size_t i = 0; i < v && bmpp->Rows.RowIndex < bmpp->Height; ++i)
+            {
+                if (!bmp_rle_next_row(bmpp, encoder))
+                    return BMP_PARSE_STATE_ERROR;
+            }
+            bmpp->RowFill += n;
+        }
+        else if (n > 0)
+        {   // encoded mode; repeat the index, or pair of indices.
+            bmp_rle_store(bmpp, n, v);
+        }
+        else if (v == BMP_RLE_END_OF_LINE)
+        {
+            if (!bmp_rle_next_row(bmpp, encoder))
+                return BMP_PARSE_STATE_ERROR;
+            bmpp->RowFill = 0;
+        }
+        else if (v == BMP_RLE_END_OF_BITMAP)
+        {   // the remaining rows are left as the first palette entry.
+            while (bmpp->Rows.RowIndex < bmpp->Height)
+            {
+                if (!bmp_rle_next_row(bmpp, encoder))
+                    return BMP_PARSE_STATE_ERROR;
+            }
+        }
+        else if (v == BMP_RLE_DELTA)
+        {
+            bmpp->RleDelta = true;
+        }
+        else
+        {   // absolute mode; v indices follow, padded to a 16-bit boundary.
+            bmpp->RleLiteral = v;
+            bmpp->RlePadding =(rle4 ? ((v + 1) / 2) : v) & 1;
+        }
+    }
+    if (bmpp->Rows.RowIndex < bmpp->Height)
+    {   // wait for more data.
+        return BMP_PARSE_STATE_RLE_DATA;
+    }
+    return bmp_finish_image(bmpp, encoder);
+}
+
+/// @summary Implements the primary update tick for a streaming BMP parser.
+/// @param bmpp The BMP parser state to update.
+/// @return One of bmp_parser_result_e.
+internal_function int bmp_parser_update(bmp_parser_state_t *bmpp)
+{
+    stream_decoder_t *decoder   = bmpp->Config.Decoder;
+    while (bmpp->CurrentState  != BMP_PARSE_STATE_COMPLETE)
+    {
+        if (bmpp->CurrentState == BMP_PARSE_STATE_ERROR)
+        {   // return from the error state immediately.
+            return BMP_PARSE_RESULT_ERROR;
+        }
+        if (decoder->ReadCursor == decoder->FinalByte && !decoder->atend())
+        {   // attempt to obtain additional input data.
+            switch (decoder->refill(decoder))
+            {
+            case STREAM_REFILL_RESULT_START:
+                break;
+            case STREAM_REFILL_RESULT_YIELD:
+                return BMP_PARSE_RESULT_CONTINUE;
+            case STREAM_REFILL_RESULT_ERROR:
+                bmpp->CurrentState = BMP_PARSE_STATE_ERROR;
+                bmpp->ParserError  = BMP_PARSE_ERROR_DECODER;
+                return BMP_PARSE_RESULT_ERROR;
+            }
+        }
+        // perform a state update, which may consume zero or more bytes.
+        uint8_t *cursor = decoder->ReadCursor;
+        int      s      = bmpp->CurrentState;
+        switch (bmpp->CurrentState)
+        {
+        case BMP_PARSE_STATE_SEEK_OFFSET:
+            s = bmp_seek_offset(decoder, bmpp, bmpp->Encoder);
+            break;
+        case BMP_PARSE_STATE_FILE_HEADER:
+            s = bmp_file_header(decoder, bmpp, bmpp->Encoder);
+            break;
+        case BMP_PARSE_STATE_BUFFER_HEADER:
+            s = bmp_buffer_header(decoder, bmpp, bmpp->Encoder);
+            break;
+        case BMP_PARSE_STATE_SKIP_TO_PIXELS:
+            s = bmp_skip_to_pixels(decoder, bmpp, bmpp->Encoder);
+            break;
+        case BMP_PARSE_STATE_PIXEL_DATA:
+            s = bmp_pixel_data(decoder, bmpp, bmpp->Encoder);
+            break;
+        case BMP_PARSE_STATE_RLE_DATA:
+            s = bmp_rle_data(decoder, bmpp, bmpp->Encoder);
+            break;
+        default:
+            break;
+        }
+        if (s == bmpp->CurrentState && cursor == decoder->ReadCursor && decoder->atend())
+        {   // the state needs more data, but the stream has ended.
+            s = BMP_PARSE_STATE_ERROR;
+            bmpp->ParserError = BMP_PARSE_ERROR_BAD_DATA;
+        }
+        bmpp->CurrentState = s;
+    }
+    return BMP_PARSE_RESULT_COMPLETE;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initializes or resets the state of a streaming BMP parser.
+/// @param bmpp The streaming BMP parser state to initialize.
+/// @param config Parser configuration data indicating what portions of the file to parse.
+public_function void bmp_parser_state_init(bmp_parser_state_t *bmpp, image_parser_config_t const &config)
+{
+    bmpp->CurrentState     = BMP_PARSE_STATE_SEEK_OFFSET;
+    bmpp->ParserError      = BMP_PARSE_ERROR_SUCCESS;
+    bmpp->Config           = config;
+    bmpp->Encoder          = NULL;
+    bmpp->Metadata         = config.Metadata;
+    bmpp->HeaderWritePos   = 0;
+    bmpp->HeaderSize       = 0;
+    bmpp->SkipRemain       = 0;
+    bmpp->Compression      = BMP_COMPRESSION_RGB;
+    bmpp->PixelBits        = 0;
+    bmpp->BottomUp         = true;
+    bmpp->Conversion       = BMP_CONVERT_COPY;
+    bmpp->Format           = DXGI_FORMAT_UNKNOWN;
+    bmpp->Width            = 0;
+    bmpp->Height           = 0;
+    bmpp->RowSize          = 0;
+    bmpp->RowFill          = 0;
+    bmpp->OutputRowSize    = 0;
+    bmpp->RleLiteral       = 0;
+    bmpp->RlePadding       = 0;
+    bmpp->RleCodeFill      = 0;
+    bmpp->RleDelta         = false;
+    bmpp->RowMemory        = NULL;
+    bmpp->CurrentRow       = NULL;
+    bmpp->OutputRow        = NULL;
+    image_row_writer_init(&bmpp->Rows, 0, 0, false);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        bmpp->ChannelMask [i] = 0;
+        bmpp->ChannelShift[i] = 0;
+    }
+    for (size_t i = 0; i < 256; ++i)
+    {   // indices outside of the palette decode as opaque black.
+        bmpp->Palette[i]   = 0xFF000000U;
+    }
+}
+
+/// @summary Frees any locally-allocated resources for a parser instance.
+/// @param bmpp The streaming BMP parser state to clean up.
+public_function void bmp_parser_state_cleanup(bmp_parser_state_t *bmpp)
+{
+    image_row_writer_free(&bmpp->Rows);
+    if (bmpp->RowMemory != NULL)
+    {
+        free(bmpp->RowMemory);
+        bmpp->RowMemory = NULL;
+    }
+    if (bmpp->Encoder != NULL)
+    {
+        delete  bmpp->Encoder;
+        bmpp->Encoder  = NULL;
+    }
+}
@@ -27,6 +27,12 @@
 /// @summary Define the size 
 #define DDS_HEADER10_BUFFER_SIZE  sizeof(dds_header_dxt10_t)
 
+/// @summary Define to N > 0 to fail every Nth mipmap level read by a DDS level reader with ERROR_READ_FAULT, after its 
+/// data has been copied but before it is marked resident. This exercises the failure path of progressive loads.
+#ifndef DDS_LEVEL_READER_FAULT_INTERVAL
+#define DDS_LEVEL_READER_FAULT_INTERVAL 0
+#endif
+
 /*///////////////////
 //   Local Types   //
 ///////////////////*/
@@ -91,113 +97,155 @@ struct dds_parser_state_t
     #undef  BUF_DDSH
 };
 
+/// @summary Define the state data associated with a reader that copies a single mipmap level of one DDS array element 
+/// from a byte-range stream directly to its final location in image memory. Several readers can fill the levels of 
+/// an element in any order; the element must have been started with image_memory_begin_levels().
+struct dds_level_reader_t
+{
+    int                   ReaderError;          /// One of dds_parser_error_e.
+    image_parser_config_t Config;               /// The input parser configuration. Context is owned by the caller.
+    size_t                ElementIndex;         /// The zero-based index of the face or array element being read.
+    size_t                LevelIndex;           /// The zero-based index of the level being read.
+    size_t                SkipBytes;            /// The number of bytes remaining to skip before the first byte of level data.
+    size_t                LevelWrite;           /// The current write position in the level data.
+    size_t                LevelSize;            /// The size of the level data, in bytes.
+};
+
 /*///////////////
 //   Globals   //
 ///////////////*/
+#if DDS_LEVEL_READER_FAULT_INTERVAL > 0
+/// @summary The number of levels read by all DDS level readers, used to select the reads that fail.
+global_variable std::atomic<uint32_t> DDS_LEVEL_READER_FAULT_COUNT(0);
+#endif
 
 /*///////////////////////
 //   Local Functions   //
 ///////////////////////*/
-/// @summary Calculates all of the static data once the DDS header(s) have been received and validated.
-/// @param ddsp The parser state to update.
-/// @param encoder The encoder used to write data to image memory and specify image attributes.
-/// @return The new parser state.
-internal_function int dds_parser_setup_image_info(dds_parser_state_t *ddsp)
+/// @summary Initializes an image definition from the DDS file headers. The LevelInfo and BlockOffsets arrays are allocated and must be freed with image_definition_free(); the block offsets are zeroed.
+/// @param meta The image definition to initialize.
+/// @param image_id The application-defined logical image identifier.
+/// @param dds The base DDS header.
+/// @param dx10 The extended DX10 header, or NULL if the file does not have one.
+/// @param compression One of image_compression_e specifying the storage compression of the image.
+/// @param encoding One of image_encoding_e specifying the storage encoding of the image.
+/// @return true if the definition was initialized, or false if memory allocation failed.
+internal_function bool dds_image_definition(image_definition_t *meta, uintptr_t image_id, dds_header_t const *dds, dds_header_dxt10_t const *dx10, int compression, int encoding)
 {
-    image_definition_t    *meta = ddsp->Metadata;
-    if (ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
-    {   // completely initialize the metadata block with information we've read.
-        dds_header_t        *dds      = ddsp->DDSHeader;
-        dds_header_dxt10_t  *dx10     = ddsp->DX10Header;
-        uint32_t             format   = dxgi_format(dds, dx10);
-        size_t               basew    =(dds->Flags & DDSD_WIDTH ) ? dds->Width  : 0;
-        size_t               baseh    =(dds->Flags & DDSD_HEIGHT) ? dds->Height : 0;
-        size_t               based    = dxgi_volume(dds, dx10)    ? dds->Depth  : 1;
-        size_t               bitspp   = dxgi_bits_per_pixel(format);
-        size_t               blocksz  = dxgi_bytes_per_block(format);
-        size_t               nitems   = dxgi_array_count(dds, dx10);
-        size_t               nlevels  = dxgi_level_count(dds, dx10);
-        bool                 blockcf  =(blocksz > 0);
-        dds_level_desc_t    *levels   = NULL;
-        stream_decode_pos_t *offsets  = NULL;
-
-        // allocate storage for the mipmap level descriptors and byte offsets.
-        if ((levels = (dds_level_desc_t*) malloc(nlevels * sizeof(dds_level_desc_t))) == NULL)
-        {   // unable to allocate the necessary storage for mip-level descriptors.
-            ddsp->ParserError = DDS_PARSE_ERROR_NOMEMORY;
-            return DDS_PARSE_STATE_ERROR;
-        }
-        if ((offsets = (stream_decode_pos_t*) malloc(nitems * nlevels * sizeof(stream_decode_pos_t))) == NULL)
-        {   // unable to allocate the necessary storage for mip-level byte offsets.
-            free(levels); ddsp->ParserError = DDS_PARSE_ERROR_NOMEMORY;
-            return DDS_PARSE_STATE_ERROR;
-        }
-
-        // initialize basic metadata attributes:
-        meta->ImageId      = ddsp->Config.ImageId;
-        meta->ImageFormat  = format;
-        meta->Compression  = ddsp->Config.Compression;
-        meta->Encoding     = ddsp->Config.Encoding;
-        meta->Width        = basew;
-        meta->Height       = baseh;
-        meta->SliceCount   = based;
-        meta->ElementIndex = 0;
-        meta->ElementCount = nitems;
-        meta->LevelCount   = nlevels;
-        meta->BytesPerPixel= bitspp;
-        meta->BytesPerBlock= blocksz;
-        meta->DDSHeader    =*dds;
-        meta->DX10Header   =*dx10;
-        meta->LevelInfo    = levels;
-        meta->BlockOffsets = offsets;
-
-        // initialize mipmap chain attributes:
-        for (size_t i = 0; i < nlevels; ++i)
-        {
-            dds_level_desc_t &dst = levels[i];
-            size_t levelw         = image_level_dimension(basew, i);
-            size_t levelh         = image_level_dimension(baseh, i);
-            size_t leveld         = image_level_dimension(based, i);
-            size_t levelp         = dxgi_pitch(format, levelw);
-            size_t blockh         = image_max2<size_t>(1, (levelh + 3) / 4);
-            dst.Index             = i;
-            dst.Width             = dxgi_image_dimension(format, levelw);
-            dst.Height            = dxgi_image_dimension(format, levelh);
-            dst.Slices            = leveld;
-            dst.BytesPerElement   = blockcf ? blocksz : (bitspp / 8); // DXGI_FORMAT_R1_UNORM...?
-            dst.BytesPerRow       = levelp;
-            dst.BytesPerSlice     = blockcf ? levelp  *  blockh : levelp * levelh;
-            dst.DataSize          = dst.BytesPerSlice *  leveld;
-            dst.Format            = format;
-        }
+    uint32_t             format   = dxgi_format(dds, dx10);
+    size_t               basew    =(dds->Flags & DDSD_WIDTH ) ? dds->Width  : 0;
+    size_t               baseh    =(dds->Flags & DDSD_HEIGHT) ? dds->Height : 0;
+    size_t               based    = dxgi_volume(dds, dx10)    ? dds->Depth  : 1;
+    size_t               bitspp   = dxgi_bits_per_pixel(format);
+    size_t               blocksz  = dxgi_bytes_per_block(format);
+    size_t               nitems   = dxgi_array_count(dds, dx10);
+    size_t               nlevels  = dxgi_level_count(dds, dx10);
+    bool                 blockcf  =(blocksz > 0);
+    dds_level_desc_t    *levels   = NULL;
+    stream_decode_pos_t *offsets  = NULL;
+
+    // allocate storage for the mipmap level descriptors and byte offsets.
+    if ((levels = (dds_level_desc_t*) malloc(nlevels * sizeof(dds_level_desc_t))) == NULL)
+    {   // unable to allocate the necessary storage for mip-level descriptors.
+        return false;
+    }
+    if ((offsets = (stream_decode_pos_t*) malloc(nitems * nlevels * sizeof(stream_decode_pos_t))) == NULL)
+    {   // unable to allocate the necessary storage for mip-level byte offsets.
+        free(levels);
+        return false;
+    }
 
-        // zero out all of the offset data. it will be set as the container is parsed.
-        memset(offsets, 0, nitems * nlevels * sizeof(stream_decode_pos_t));
+    // initialize basic metadata attributes:
+    meta->ImageId      = image_id;
+    meta->ImageFormat  = format;
+    meta->Compression  = compression;
+    meta->Encoding     = encoding;
+    meta->Width        = basew;
+    meta->Height       = baseh;
+    meta->SliceCount   = based;
+    meta->ElementIndex = 0;
+    meta->ElementCount = nitems;
+    meta->LevelCount   = nlevels;
+    meta->BytesPerPixel= bitspp;
+    meta->BytesPerBlock= blocksz;
+    meta->DDSHeader    =*dds;
+    meta->LevelInfo    = levels;
+    meta->BlockOffsets = offsets;
+    if (dx10 != NULL)  meta->DX10Header = *dx10;
+    else dx10_header_for_dds(&meta->DX10Header, dds);
+
+    // initialize mipmap chain attributes:
+    for (size_t i = 0; i < nlevels; ++i)
+    {
+        dds_level_desc_t &dst = levels[i];
+        size_t levelw         = image_level_dimension(basew, i);
+        size_t levelh         = image_level_dimension(baseh, i);
+        size_t leveld         = image_level_dimension(based, i);
+        size_t levelp         = dxgi_pitch(format, levelw);
+        size_t blockh         = image_max2<size_t>(1, (levelh + 3) / 4);
+        dst.Index             = i;
+        dst.Width             = dxgi_image_dimension(format, levelw);
+        dst.Height            = dxgi_image_dimension(format, levelh);
+        dst.Slices            = leveld;
+        dst.BytesPerElement   = blockcf ? blocksz : (bitspp / 8); // DXGI_FORMAT_R1_UNORM...?
+        dst.BytesPerRow       = levelp;
+        dst.BytesPerSlice     = blockcf ? levelp  *  blockh : levelp * dxgi_plane_rows(format, levelh);
+        dst.DataSize          = dst.BytesPerSlice *  leveld;
+        dst.Format            = format;
     }
 
-    // create the image encoder instance.
-    int access_type = IMAGE_ACCESS_UNKNOWN;
+    // zero out all of the offset data. it will be set as the container is parsed.
+    memset(offsets, 0, nitems * nlevels * sizeof(stream_decode_pos_t));
+    return true;
+}
+
+/// @summary Determines how the data of a DDS image is accessed based on its metadata.
+/// @param meta The image definition, with the DDSHeader and DX10Header fields set.
+/// @return One of image_access_type_e.
+internal_function int dds_access_type(image_definition_t const *meta)
+{
     if (dxgi_array(&meta->DDSHeader, &meta->DX10Header))
     {   // this is an image array - determine whether it's 1D, 2D or cubemap.
         // note that DDS does not support arrays of 3D image data.
         if (dxgi_cubemap(&meta->DDSHeader, &meta->DX10Header))
-            access_type = IMAGE_ACCESS_CUBEMAP_ARRAY;
+            return IMAGE_ACCESS_CUBEMAP_ARRAY;
         else if (meta->Width > 1 && meta->Height > 1)
-            access_type = IMAGE_ACCESS_2D_ARRAY;
+            return IMAGE_ACCESS_2D_ARRAY;
         else
-            access_type = IMAGE_ACCESS_1D_ARRAY;
+            return IMAGE_ACCESS_1D_ARRAY;
     }
     else
     {   // this is a single-element image.
         if (dxgi_cubemap(&meta->DDSHeader, &meta->DX10Header))
-            access_type = IMAGE_ACCESS_CUBEMAP;
+            return IMAGE_ACCESS_CUBEMAP;
         else if (meta->SliceCount > 1)
-            access_type = IMAGE_ACCESS_3D;
+            return IMAGE_ACCESS_3D;
         else if (meta->Width > 1 && meta->Height > 1)
-            access_type = IMAGE_ACCESS_2D;
+            return IMAGE_ACCESS_2D;
         else
-            access_type = IMAGE_ACCESS_1D;
+            return IMAGE_ACCESS_1D;
+    }
+}
+
+/// @summary Calculates all of the static data once the DDS header(s) have been received and validated.
+/// @param ddsp The parser state to update.
+/// @param encoder The encoder used to write data to image memory and specify image attributes.
+/// @return The new parser state.
+internal_function int dds_parser_setup_image_info(dds_parser_state_t *ddsp)
+{
+    image_definition_t    *meta = ddsp->Metadata;
+    if ((ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA) != 0 && 
+        (ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_METADATA_SET ) == 0)
+    {   // completely initialize the metadata block with information we've read.
+        if (!dds_image_definition(meta, ddsp->Config.ImageId, ddsp->DDSHeader, ddsp->DX10Header, ddsp->Config.Compression, ddsp->Config.Encoding))
+        {   // unable to allocate storage for the mip-level descriptors and offsets.
+            ddsp->ParserError = DDS_PARSE_ERROR_NOMEMORY;
+            return DDS_PARSE_STATE_ERROR;
+        }
     }
+
+    // create the image encoder instance.
+    int access_type = dds_access_type(meta);
     ddsp->Encoder = create_image_encoder(
         ddsp->Config.ImageId, 
         ddsp->Config.Memory, 
@@ -209,7 +257,12 @@ internal_function int dds_parser_setup_image_info(dds_parser_state_t *ddsp)
         ddsp->Config.DefinitionQueue, 
         ddsp->Config.DefinitionAlloc, 
         ddsp->Config.PlacementQueue, 
-        ddsp->Config.PlacementAlloc);
+        ddsp->Config.PlacementAlloc, 
+        meta->ImageFormat, 
+        ddsp->Config.Format, 
+        ddsp->Config.Quality, 
+        ddsp->Config.WorkPool, 
+        ddsp->Config.EncoderFlags);
     if (ddsp->Encoder == NULL)
     {   // unable to create the encoder to write to image memory.
         ddsp->ParserError = DDS_PARSE_ERROR_NOENCODER;
@@ -223,21 +276,26 @@ internal_function int dds_parser_setup_image_info(dds_parser_state_t *ddsp)
             return DDS_PARSE_STATE_ERROR;
         }
     }
+    else
+    {   // the image is already defined, but encoders that change the format need the source attributes.
+        ddsp->Encoder->Metadata = meta;
+    }
 
     // initialize internal state based on parser flags and image metadata.
-    if (ddsp->Config.FinalFrame > meta->ElementCount)
+    // ElementFinal is one past the last element to read.
+    if (ddsp->Config.FinalFrame >= meta->ElementCount)
     {   // read all elements starting from the specified frame to the end.
-        ddsp->Config.FinalFrame = meta->ElementCount;
+        ddsp->Config.FinalFrame  = meta->ElementCount - 1;
     }
     ddsp->ElementIndex = ddsp->Config.FirstFrame;
-    ddsp->ElementFinal = ddsp->Config.FinalFrame;
+    ddsp->ElementFinal = ddsp->Config.FinalFrame + 1;
     ddsp->LevelIndex   = 0;
     ddsp->LevelCount   = meta->LevelCount;
     ddsp->LevelInfo    = meta->LevelInfo;
     ddsp->BlockOffsets = meta->BlockOffsets;
 
     // transition to the appropriate state based on parser configuration.
-    if ((ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_PIXELS) == 0)
+    if ((ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_PIXELS) == 0 || ddsp->Config.FirstFrame >= ddsp->ElementFinal)
     {   // not reading any pixel data, so we're done.
         return DDS_PARSE_STATE_COMPLETE;
     }
@@ -265,12 +323,13 @@ internal_function int dds_seek_offset(stream_decoder_t *decoder, dds_parser_stat
         target.DecodeOffset     -= consume; // decrement bytes remaining to consume
         if (decoder->ReadCursor != decoder->FinalByte)
         {   // ReadCursor is positioned on the first byte to read.
-            if (ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+            if ((ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA) != 0 && 
+                (ddsp->Config.ParseFlags & IMAGE_PARSER_FLAGS_METADATA_SET ) == 0)
             {   // proceed with reading the image metadata.
                 return DDS_PARSE_STATE_FIND_MAGIC;
             }
             else
-            {   // skip metadata, reading pixels only.
+            {   // the headers aren't in the stream; ReadCursor is on the first pixel of FirstFrame.
                 return dds_parser_setup_image_info(ddsp);
             }
         }
@@ -488,6 +547,77 @@ internal_function int dds_parser_update(dds_parser_state_t *ddsp)
     return DDS_PARSE_RESULT_COMPLETE;
 }
 
+/// @summary Implements the update tick for a DDS level reader. Level data is copied as it arrives, and the level is 
+/// marked resident, posting a placement notification if the element can now be displayed at a higher resolution.
+/// @param reader The DDS level reader to update.
+/// @return One of dds_parser_result_e. On DDS_PARSE_RESULT_ERROR, GetLastError() returns the system error code for the failure.
+internal_function int dds_level_reader_update(dds_level_reader_t *reader)
+{
+    stream_decoder_t *decoder = reader->Config.Decoder;
+    while (reader->LevelWrite < reader->LevelSize)
+    {
+        if (reader->ReaderError != DDS_PARSE_ERROR_SUCCESS)
+        {   // return from the error state immediately.
+            return DDS_PARSE_RESULT_ERROR;
+        }
+        if (decoder->ReadCursor == decoder->FinalByte)
+        {
+            if (decoder->atend())
+            {   // the range ended before the level data was complete.
+                reader->ReaderError = DDS_PARSE_ERROR_DECODER;
+                SetLastError(ERROR_HANDLE_EOF);
+                return DDS_PARSE_RESULT_ERROR;
+            }
+            switch (decoder->refill(decoder))
+            {
+            case STREAM_REFILL_RESULT_START:
+                break;
+            case STREAM_REFILL_RESULT_YIELD:
+                return DDS_PARSE_RESULT_CONTINUE;
+            case STREAM_REFILL_RESULT_ERROR:
+                reader->ReaderError = DDS_PARSE_ERROR_DECODER;
+                SetLastError(decoder->ErrorCode);
+                return DDS_PARSE_RESULT_ERROR;
+            }
+            continue;
+        }
+        size_t bytes_available = decoder->amount();
+        if (reader->SkipBytes  > 0)
+        {   // the range was aligned down to a sector boundary; skip the leading bytes.
+            size_t skip          = image_min2<size_t>(bytes_available, reader->SkipBytes);
+            decoder->ReadCursor += skip;
+            reader->SkipBytes   -= skip;
+            continue;
+        }
+        size_t   bytes_to_copy = image_min2<size_t>(bytes_available, reader->LevelSize - reader->LevelWrite);
+        uint32_t result        = image_memory_write_level(reader->Config.Memory, reader->Config.ImageId, reader->ElementIndex, reader->LevelIndex, reader->LevelWrite, decoder->ReadCursor, bytes_to_copy);
+        if (result != ERROR_SUCCESS)
+        {   // the element wasn't started with image_memory_begin_levels(), or the image was dropped.
+            reader->ReaderError = DDS_PARSE_ERROR_ENCODER;
+            SetLastError(result);
+            return DDS_PARSE_RESULT_ERROR;
+        }
+        decoder->ReadCursor += bytes_to_copy;
+        reader->LevelWrite  += bytes_to_copy;
+    }
+#if DDS_LEVEL_READER_FAULT_INTERVAL > 0
+    if (((DDS_LEVEL_READER_FAULT_COUNT.fetch_add(1, std::memory_order_relaxed) + 1) % DDS_LEVEL_READER_FAULT_INTERVAL) == 0)
+    {   // simulate a read error for this level.
+        reader->ReaderError = DDS_PARSE_ERROR_DECODER;
+        SetLastError(ERROR_READ_FAULT);
+        return DDS_PARSE_RESULT_ERROR;
+    }
+#endif
+    uint32_t result = image_memory_mark_level_resident(reader->Config.Memory, reader->Config.ImageId, reader->ElementIndex, reader->LevelIndex, reader->Config.PlacementQueue, reader->Config.PlacementAlloc);
+    if (result != ERROR_SUCCESS)
+    {   // the image was dropped while the level was being read.
+        reader->ReaderError = DDS_PARSE_ERROR_ENCODER;
+        SetLastError(result);
+        return DDS_PARSE_RESULT_ERROR;
+    }
+    return DDS_PARSE_RESULT_COMPLETE;
+}
+
 /*////////////////////////
 //   Public Functions   //
 ////////////////////////*/
@@ -617,7 +747,7 @@ public_function size_t dds_describe(void const *data, size_t data_size, dds_head
         dst.Slices            = leveld;
         dst.BytesPerElement   = blockcf ? blocksz : (bitspp / 8); // DXGI_FORMAT_R1_UNORM...?
         dst.BytesPerRow       = levelp;
-        dst.BytesPerSlice     = blockcf ? levelp  *  blockh : levelp * levelh;
+        dst.BytesPerSlice     = blockcf ? levelp  *  blockh : levelp * dxgi_plane_rows(format, levelh);
         dst.DataSize          = dst.BytesPerSlice *  leveld;
         dst.Format            = format;
         stride               += dst.DataSize;
@@ -671,3 +801,63 @@ public_function void dds_parser_state_cleanup(dds_parser_state_t *ddsp)
         ddsp->Encoder  = NULL;
     }
 }
+
+/// @summary Initializes the state of a DDS level reader.
+/// @param reader The DDS level reader state to initialize.
+/// @param config Parser configuration data. The Decoder must cover the level data of the specified element and level.
+/// @param element The zero-based index of the face or array element to read.
+/// @param level The zero-based index of the mipmap level to read.
+/// @param skip_bytes The number of bytes between the start of the stream and the first byte of level data.
+/// @param level_size The size of the level data, in bytes.
+public_function void dds_level_reader_init(dds_level_reader_t *reader, image_parser_config_t const &config, size_t element, size_t level, size_t skip_bytes, size_t level_size)
+{
+    reader->ReaderError  = DDS_PARSE_ERROR_SUCCESS;
+    reader->Config       = config;
+    reader->ElementIndex = element;
+    reader->LevelIndex   = level;
+    reader->SkipBytes    = skip_bytes;
+    reader->LevelWrite   = 0;
+    reader->LevelSize    = level_size;
+}
+
+/// @summary Measure the throughput of the streaming DDS parser on a file held in memory, from the first byte of the file to the last 
+/// element being marked resident in image memory. Compare with png_parser_benchmark() on the same image stored as a PNG file.
+/// @param data The contents of a DDS file.
+/// @param size The size of the file, in bytes.
+/// @param iterations The number of times to load the file.
+/// @return The load throughput, in millions of level 0 pixels per-second, or zero if the file can't be loaded.
+public_function double dds_parser_benchmark(void const *data, size_t size, size_t iterations)
+{
+    LARGE_INTEGER  frequency, start, end;
+    image_memory_t memory;
+    double         pixels = 0.0;
+    double         rate   = 0.0;
+    bool           failed = false;
+    image_memory_create(&memory, 1);
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (size_t i = 0; i < iterations && !failed; ++i)
+    {
+        stream_decoder_t      stream;
+        image_definition_t    meta;
+        image_parser_config_t config;
+        dds_parser_state_t    ddsp;
+        image_definition_init(&meta);
+        image_parser_memory_config(config, &stream, data, size, &memory, &meta, 1);
+        dds_parser_state_init(&ddsp, config);
+        if (dds_parser_update(&ddsp) == DDS_PARSE_RESULT_COMPLETE)
+            pixels += double(meta.Width) * double(meta.Height) * double(meta.ElementCount);
+        else failed = true;
+        dds_parser_state_cleanup(&ddsp);
+        image_memory_drop_image(&memory, 1, true);
+        image_definition_free(&meta);
+    }
+    QueryPerformanceCounter(&end);
+    image_memory_delete(&memory);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(frequency.QuadPart);
+    if (seconds > 0.0 && !failed)
+    {
+        rate = pixels / (seconds * 1000000.0);
+    }
+    return rate;
+}
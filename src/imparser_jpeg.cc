@@ -0,0 +1,2251 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a streaming parser for baseline, extended sequential and
+/// progressive JPEG files with 8-bit samples and Huffman coding. Marker
+/// segments are buffered as they arrive. Entropy-coded data is unstuffed into
+/// a scan buffer, and the position of each restart marker is recorded; when
+/// the scan ends, the restart intervals are decoded in parallel on the worker
+/// pool into per-component coefficient buffers. Once the EOI marker has been
+/// received, the blocks are dequantized and transformed with a floating-point
+/// AAN IDCT, chroma is upsampled with the same triangle filter as libjpeg for
+/// 2:1 subsampling in either direction, and YCbCr is converted to RGBA8 in bands of rows, using
+/// AVX2 when the processor and operating system support it, or SSE2. Each band
+/// is then written to the image encoder. Arithmetic coding, lossless and
+/// hierarchical modes, 12-bit samples and CMYK are not supported.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <intrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The maximum number of components in a frame.
+#define JPEG_MAX_COMPONENTS       4
+
+/// @summary The number of bits resolved by a single Huffman table lookup. Longer codes take the slow path.
+#define JPEG_HUFFMAN_LOOKUP_BITS  9
+
+/// @summary The size of the buffer for a marker segment, which is limited to 65535 bytes including the length field.
+#define JPEG_SEGMENT_BUFFER_SIZE  65536
+
+/// @summary The number of zero bytes kept after the unstuffed scan data, so the bit reader can load eight bytes at a time.
+#define JPEG_SCAN_PADDING         16
+
+/// @summary The initial capacity of the scan buffer, in bytes.
+#define JPEG_SCAN_INITIAL_SIZE    65536
+
+/// @summary The number of block rows transformed by one IDCT work item.
+#define JPEG_IDCT_BAND_ROWS       4
+
+/// @summary The number of output rows converted by one color conversion work item.
+#define JPEG_CONVERT_BAND_ROWS    16
+
+/// @summary The number of work items per thread used to decode the restart intervals of a scan.
+#define JPEG_SCAN_ITEMS_PER_THREAD 4
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define identifiers for the recognized parser states.
+enum jpeg_parser_state_e : int
+{
+    JPEG_PARSE_STATE_SEEK_OFFSET         = 0,   /// The parser is looking for a known byte offset.
+    JPEG_PARSE_STATE_BUFFER_SOI          = 1,   /// The parser is receiving the start-of-image marker.
+    JPEG_PARSE_STATE_MARKER              = 2,   /// The parser is looking for the next marker.
+    JPEG_PARSE_STATE_SEGMENT_LENGTH      = 3,   /// The parser is receiving the length of a marker segment.
+    JPEG_PARSE_STATE_BUFFER_SEGMENT      = 4,   /// The parser is receiving the data of a marker segment.
+    JPEG_PARSE_STATE_SKIP_SEGMENT        = 5,   /// The parser is skipping the data of an unused marker segment.
+    JPEG_PARSE_STATE_SCAN_DATA           = 6,   /// The parser is receiving entropy-coded data.
+    JPEG_PARSE_STATE_COMPLETE            = 7,   /// The parser has processed the entire file contents.
+    JPEG_PARSE_STATE_ERROR               = 8    /// The parser has encountered a fatal error.
+};
+
+/// @summary Define identifiers for the recognized parser errors.
+enum jpeg_parser_error_e : int
+{
+    JPEG_PARSE_ERROR_SUCCESS             = 0,   /// No error has occurred.
+    JPEG_PARSE_ERROR_NOMEMORY            = 1,   /// Required memory could not be allocated.
+    JPEG_PARSE_ERROR_DECODER             = 2,   /// The underlying stream decoder returned an error.
+    JPEG_PARSE_ERROR_NOENCODER           = 3,   /// No encoder was found that supports the required transcoding.
+    JPEG_PARSE_ERROR_ENCODER             = 4,   /// The image encoder returned an error.
+    JPEG_PARSE_ERROR_BAD_DATA            = 5,   /// The file is not a valid JPEG, or is truncated.
+    JPEG_PARSE_ERROR_UNSUPPORTED         = 6,   /// The file uses a feature the parser doesn't support.
+};
+
+/// @summary Define the possible return codes from the top-level streaming parser update function.
+enum jpeg_parser_result_e : int
+{
+    JPEG_PARSE_RESULT_CONTINUE           = 0,   /// The parser is yielding, waiting for more data.
+    JPEG_PARSE_RESULT_COMPLETE           = 1,   /// Stop parsing. All data was parsed successfully.
+    JPEG_PARSE_RESULT_ERROR              = 2    /// Stop parsing. An error was encountered.
+};
+
+/// @summary Define the marker codes examined by the parser. Each marker is preceded by an 0xFF byte.
+enum jpeg_marker_e : uint8_t
+{
+    JPEG_MARKER_TEM                      = 0x01,/// Temporary use in arithmetic coding. Has no segment.
+    JPEG_MARKER_SOF0                     = 0xC0,/// Start of frame, baseline DCT.
+    JPEG_MARKER_SOF1                     = 0xC1,/// Start of frame, extended sequential DCT.
+    JPEG_MARKER_SOF2                     = 0xC2,/// Start of frame, progressive DCT.
+    JPEG_MARKER_DHT                      = 0xC4,/// Define Huffman tables.
+    JPEG_MARKER_DAC                      = 0xCC,/// Define arithmetic coding conditioning.
+    JPEG_MARKER_RST0                     = 0xD0,/// The first of eight restart markers. Has no segment.
+    JPEG_MARKER_RST7                     = 0xD7,/// The last of eight restart markers. Has no segment.
+    JPEG_MARKER_SOI                      = 0xD8,/// Start of image. Has no segment.
+    JPEG_MARKER_EOI                      = 0xD9,/// End of image. Has no segment.
+    JPEG_MARKER_SOS                      = 0xDA,/// Start of scan.
+    JPEG_MARKER_DQT                      = 0xDB,/// Define quantization tables.
+    JPEG_MARKER_DNL                      = 0xDC,/// Define number of lines.
+    JPEG_MARKER_DRI                      = 0xDD,/// Define restart interval.
+    JPEG_MARKER_APP0                     = 0xE0,/// Application segment 0, used by JFIF.
+    JPEG_MARKER_APP14                    = 0xEE,/// Application segment 14, used by Adobe to specify the color transform.
+};
+
+/// @summary Define the color conversions applied to the decoded components.
+enum jpeg_color_e : int
+{
+    JPEG_COLOR_GRAY                      = 0,   /// A single luminance component, written as R8.
+    JPEG_COLOR_YCBCR                     = 1,   /// Three YCbCr components, converted to RGBA8.
+    JPEG_COLOR_RGB                       = 2,   /// Three RGB components, interleaved into RGBA8.
+};
+
+/// @summary Define the ways a component is upsampled to the full image resolution.
+enum jpeg_upsample_e : int
+{
+    JPEG_UPSAMPLE_NONE                   = 0,   /// The component is stored at full resolution.
+    JPEG_UPSAMPLE_H2V1                   = 1,   /// The component is subsampled 2:1 horizontally, and upsampled with a triangle filter.
+    JPEG_UPSAMPLE_H2V2                   = 2,   /// The component is subsampled 2:1 in both directions, and upsampled with a triangle filter.
+    JPEG_UPSAMPLE_H1V2                   = 3,   /// The component is subsampled 2:1 vertically, and upsampled with a triangle filter.
+    JPEG_UPSAMPLE_REPLICATE              = 4,   /// The component is subsampled by some other integral factor, and samples are replicated.
+};
+
+/// @summary Describes a Huffman table as used by the decoder.
+struct jpeg_huffman_t
+{
+    uint16_t                  Lookup[1 << JPEG_HUFFMAN_LOOKUP_BITS]; /// Maps the next JPEG_HUFFMAN_LOOKUP_BITS bits to (length << 8) | symbol, or 0 if the code is longer.
+    int16_t                   FastAC[1 << JPEG_HUFFMAN_LOOKUP_BITS]; /// For AC tables, maps the next JPEG_HUFFMAN_LOOKUP_BITS bits to (value << 8) | (run << 4) | total length, or 0 if the code and value don't fit.
+    int32_t                   MaxCode[18];       /// The largest code of each length, or -1 if there are no codes of that length.
+    int32_t                   ValOffset[18];     /// Added to a code of each length to give the index of its symbol.
+    uint8_t                   Symbols[256];      /// The symbols, in order of increasing code length.
+    bool                      Defined;           /// true if the table has been defined by a DHT segment.
+};
+
+/// @summary Describes one component of the frame, and stores its coefficients and decoded samples.
+struct jpeg_component_t
+{
+    uint8_t                   Id;                /// The component identifier from the frame header.
+    uint8_t                   H;                 /// The horizontal sampling factor.
+    uint8_t                   V;                 /// The vertical sampling factor.
+    uint8_t                   Tq;                /// The quantization table selector.
+    uint8_t                   Td;                /// The DC Huffman table selector for the current scan.
+    uint8_t                   Ta;                /// The AC Huffman table selector for the current scan.
+    int                       Upsample;          /// One of jpeg_upsample_e.
+    size_t                    Width;             /// The number of samples in each row of the component.
+    size_t                    Height;            /// The number of sample rows in the component.
+    size_t                    BlocksW;           /// The number of blocks in each block row, padded to a whole number of MCUs.
+    size_t                    BlocksH;           /// The number of block rows, padded to a whole number of MCUs.
+    size_t                    ScanBlocksW;       /// The number of blocks in each block row of a non-interleaved scan.
+    size_t                    ScanBlocksH;       /// The number of block rows of a non-interleaved scan.
+    int16_t                  *Coefficients;      /// BlocksW * BlocksH blocks of 64 coefficients, in natural order.
+    uint8_t                  *Plane;             /// The decoded samples, BlocksW * 8 samples wide and BlocksH * 8 rows high.
+    float                     Quant[64];         /// The dequantization multipliers, scaled for the AAN IDCT, in natural order.
+};
+
+/// @summary Stores the state of the JPEG decoder that is independent of the stream: tables, frame and scan parameters, and the decoded data.
+struct jpeg_decoder_t
+{
+    work_pool_t              *WorkPool;          /// The worker pool used to decode, transform and convert in parallel, or NULL.
+    bool                      UseAVX2;           /// true if the AVX2 kernels may be used.
+    bool                      HaveFrame;         /// true if a frame header has been received.
+    bool                      Progressive;       /// true if the frame uses progressive DCT.
+    bool                      HaveAdobe;         /// true if an Adobe APP14 segment has been received.
+    uint8_t                   AdobeTransform;    /// The color transform from the Adobe APP14 segment: 0 for RGB, 1 for YCbCr.
+    int                       Color;             /// One of jpeg_color_e.
+    size_t                    Width;             /// The image width, in pixels.
+    size_t                    Height;            /// The image height, in pixels.
+    size_t                    ComponentCount;    /// The number of components in the frame.
+    size_t                    Hmax;              /// The largest horizontal sampling factor.
+    size_t                    Vmax;              /// The largest vertical sampling factor.
+    size_t                    McusX;             /// The number of MCUs in each MCU row of an interleaved scan.
+    size_t                    McusY;             /// The number of MCU rows of an interleaved scan.
+    size_t                    RestartInterval;   /// The number of MCUs between restart markers, or 0.
+    size_t                    ScanCount;         /// The number of scans decoded.
+    size_t                    ScanComponentCount;/// The number of components in the current scan.
+    size_t                    ScanComponents[JPEG_MAX_COMPONENTS]; /// The frame component index of each component in the current scan.
+    uint8_t                   Ss;                /// The first coefficient of the spectral selection of the current scan.
+    uint8_t                   Se;                /// The last coefficient of the spectral selection of the current scan.
+    uint8_t                   Ah;                /// The successive approximation bit position of the previous scan of the band.
+    uint8_t                   Al;                /// The successive approximation bit position of the current scan.
+    bool                      PendingFF;         /// true if the last byte given to jpeg_scan_append() was 0xFF.
+    uint8_t                  *ScanData;          /// The unstuffed entropy-coded data of the current scan.
+    size_t                    ScanSize;          /// The number of bytes of data in ScanData.
+    size_t                    ScanCapacity;      /// The capacity of ScanData, in bytes, not including the padding.
+    size_t                   *Restarts;          /// The offsets in ScanData at which each restart interval after the first begins.
+    size_t                    RestartCount;      /// The number of restart markers in the current scan.
+    size_t                    RestartCapacity;   /// The capacity of the Restarts array.
+    jpeg_component_t          Components[JPEG_MAX_COMPONENTS]; /// The frame components.
+    jpeg_huffman_t            DCTables[4];       /// The DC Huffman tables.
+    jpeg_huffman_t            ACTables[4];       /// The AC Huffman tables.
+    uint16_t                  QuantTables[4][64];/// The quantization tables, in natural order.
+    bool                      QuantDefined[4];   /// true if the corresponding quantization table has been defined.
+    uint8_t                   Segment[JPEG_SEGMENT_BUFFER_SIZE]; /// The data of the marker segment being received.
+};
+
+/// @summary Stores the bit reader state used to decode one restart interval.
+struct jpeg_bits_t
+{
+    uint8_t const            *Cursor;            /// The next byte to load.
+    uint8_t const            *End;               /// One past the last byte of the restart interval.
+    uint64_t                  Buffer;            /// The unconsumed bits, aligned to the most significant bit.
+    uint32_t                  Count;             /// The number of valid bits in Buffer.
+};
+
+/// @summary Describes a scan decoded on the worker pool. Each work item decodes a run of restart intervals.
+struct jpeg_scan_job_t
+{
+    jpeg_decoder_t           *JPEG;              /// The decoder state.
+    size_t                    McuCount;          /// The number of MCUs in the scan.
+    size_t                    Interval;          /// The number of MCUs in each restart interval.
+    size_t                    IntervalCount;     /// The number of restart intervals.
+    size_t                    ItemCount;         /// The number of work items.
+    std::atomic<bool>         Failed;            /// Set if any restart interval contained an invalid code.
+};
+
+/// @summary Describes the IDCT of every component on the worker pool. Each work item transforms JPEG_IDCT_BAND_ROWS block rows of one component.
+struct jpeg_idct_job_t
+{
+    jpeg_decoder_t           *JPEG;              /// The decoder state.
+    size_t                    FirstItem[JPEG_MAX_COMPONENTS + 1]; /// The index of the first work item of each component.
+};
+
+/// @summary Describes the color conversion of a run of output rows on the worker pool. Each work item converts JPEG_CONVERT_BAND_ROWS rows.
+struct jpeg_convert_job_t
+{
+    jpeg_decoder_t           *JPEG;              /// The decoder state.
+    size_t                    FirstRow;          /// The zero-based index of the first output row.
+    size_t                    RowCount;          /// The number of output rows.
+    uint8_t                  *Target;            /// The first output row.
+    size_t                    TargetPitch;       /// The number of bytes between output rows.
+    uint8_t                  *Scratch;           /// Upsampling buffers, ScratchSize bytes for each work item.
+    size_t                    ScratchSize;       /// The size of the upsampling buffers of one work item, in bytes.
+};
+
+/// @summary Define the state data associated with a streaming JPEG file parser.
+struct jpeg_parser_state_t
+{
+    int                   CurrentState;         /// One of jpeg_parser_state_e.
+    int                   ParserError;          /// One of jpeg_parser_error_e.
+    image_parser_config_t Config;               /// The input parser configuration.
+    image_encoder_t      *Encoder;              /// The local image encoder. Deleted on error or completion.
+    image_definition_t   *Metadata;             /// Pointer to the image metadata block.
+    jpeg_decoder_t       *JPEG;                 /// The decoder state, allocated when the SOI marker is received.
+    uint32_t              Format;               /// One of dxgi_format_e specifying the format of the decoded pixels.
+    uint8_t               Marker;               /// The code of the current marker.
+    bool                  SeenFF;               /// true if the last byte examined while looking for a marker was 0xFF.
+    size_t                SegmentSize;          /// The size of the data of the current marker segment, in bytes.
+    size_t                SegmentRemain;        /// The number of bytes of segment data remaining to be consumed or skipped.
+    size_t                HeaderWritePos;       /// The current write position in HeaderBuffer.
+    uint8_t               HeaderBuffer[2];      /// Storage for the SOI marker or a segment length field.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary Maps the zig-zag order of the entropy-coded coefficients to natural order. The extra entries absorb overruns in corrupt progressive refinement scans.
+global_variable uint8_t const JPEG_NATURAL_ORDER[64 + 16] =
+{
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63,
+    63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63
+};
+
+/// @summary The AAN IDCT scale factors: 1 for k = 0, and cos(k * pi / 16) * sqrt(2) otherwise.
+global_variable float const JPEG_AAN_SCALE[8] =
+{
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+    1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Determine whether the processor and operating system support the AVX2 instructions.
+/// @return true if the AVX2 kernels may be used.
+internal_function bool jpeg_cpu_has_avx2(void)
+{
+    int info[4] = {0};
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+    {   // OSXSAVE and AVX are required as well.
+        return false;
+    }
+    if ((_xgetbv(0) & 0x6) != 0x6)
+    {   // the XMM and YMM register state must be saved and restored by the OS.
+        return false;
+    }
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+/// @summary Reads a big-endian 16-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint16_t jpeg_u16(uint8_t const *p)
+{
+    return uint16_t((p[0] << 8) | p[1]);
+}
+
+/// @summary Load bits into the bit buffer so that at least 57 bits are available. Past the end of the restart interval, zero bits are loaded.
+/// @param bits The bit reader to refill.
+internal_function inline void jpeg_bits_refill(jpeg_bits_t *bits)
+{
+    if (bits->End - bits->Cursor >= 8)
+    {   // load eight bytes; only the whole bytes that fit are consumed, and the rest are reloaded next time.
+        uint64_t next; memcpy(&next, bits->Cursor, sizeof(uint64_t));
+        bits->Buffer  |= _byteswap_uint64(next) >> bits->Count;
+        bits->Cursor  +=(63 - bits->Count) >> 3;
+        bits->Count   |= 56;
+    }
+    else
+    {   // near the end of the interval; load one byte at a time.
+        while (bits->Count <= 56)
+        {
+            uint64_t next  =(bits->Cursor < bits->End) ? *bits->Cursor++ : 0;
+            bits->Buffer  |= next << (56 - bits->Count);
+            bits->Count   += 8;
+        }
+    }
+}
+
+/// @summary Remove bits from the bit buffer. The caller must ensure that enough bits are available.
+/// @param bits The bit reader.
+/// @param n The number of bits to consume, 0 to 32.
+internal_function inline void jpeg_bits_consume(jpeg_bits_t *bits, uint32_t n)
+{
+    bits->Buffer <<= n;
+    bits->Count   -= n;
+}
+
+/// @summary Read an unsigned value from the bit buffer. The caller must ensure that enough bits are available.
+/// @param bits The bit reader.
+/// @param n The number of bits to read, 0 to 16.
+/// @return The value.
+internal_function inline uint32_t jpeg_bits_get(jpeg_bits_t *bits, uint32_t n)
+{
+    if (n == 0) return 0;
+    uint32_t value = uint32_t(bits->Buffer >> (64 - n));
+    jpeg_bits_consume(bits, n);
+    return value;
+}
+
+/// @summary Read an n-bit value from the bit buffer and sign-extend it as specified by the JPEG EXTEND procedure.
+/// @param bits The bit reader.
+/// @param n The number of bits in the value, 0 to 16.
+/// @return The signed value.
+internal_function inline int32_t jpeg_bits_extend(jpeg_bits_t *bits, uint32_t n)
+{
+    if (n == 0) return 0;
+    int32_t value = int32_t(bits->Buffer >> (64 - n));
+    jpeg_bits_consume(bits, n);
+    return (value < (1 << (n - 1))) ? value - ((1 << n) - 1) : value;
+}
+
+/// @summary Decode a Huffman-coded symbol. The caller must ensure that at least 16 bits are available.
+/// @param bits The bit reader.
+/// @param table The Huffman table.
+/// @return The symbol, or -1 if the code is not in the table.
+internal_function inline int32_t jpeg_huffman_decode(jpeg_bits_t *bits, jpeg_huffman_t const *table)
+{
+    uint32_t entry = table->Lookup[bits->Buffer >> (64 - JPEG_HUFFMAN_LOOKUP_BITS)];
+    if (entry != 0)
+    {   // the common case: a code of JPEG_HUFFMAN_LOOKUP_BITS bits or less.
+        jpeg_bits_consume(bits, entry >> 8);
+        return int32_t(entry & 0xFF);
+    }
+    int32_t code16 = int32_t(bits->Buffer >> 48);
+    for (uint32_t length = JPEG_HUFFMAN_LOOKUP_BITS + 1; length <= 16; ++length)
+    {
+        int32_t code = code16 >> (16 - length);
+        if (code  <= table->MaxCode[length])
+        {
+            jpeg_bits_consume(bits, length);
+            return table->Symbols[code + table->ValOffset[length]];
+        }
+    }
+    return -1;
+}
+
+/// @summary Build a Huffman table from the code counts and symbols of a DHT segment.
+/// @param table The table to initialize.
+/// @param counts The number of codes of each length from 1 to 16.
+/// @param symbols The symbols, in order of increasing code length.
+/// @return true if the table is valid.
+internal_function bool jpeg_huffman_build(jpeg_huffman_t *table, uint8_t const *counts, uint8_t const *symbols)
+{
+    int32_t code  = 0;
+    int32_t index = 0;
+    memset(table->Lookup, 0, sizeof(table->Lookup));
+    table->Defined = false;
+    for (int32_t length = 1; length <= 16; ++length)
+    {
+        int32_t count = counts[length - 1];
+        table->ValOffset[length] = index - code;
+        for (int32_t i = 0; i < count; ++i, ++code, ++index)
+        {
+            if (code >= (1 << length))
+            {   // there are more codes of this length than will fit.
+                return false;
+            }
+            table->Symbols[index] = symbols[index];
+            if (length <= JPEG_HUFFMAN_LOOKUP_BITS)
+            {   // every lookup index that starts with this code decodes to the symbol.
+                int32_t  shift = JPEG_HUFFMAN_LOOKUP_BITS - length;
+                uint16_t entry = uint16_t((length << 8) | symbols[index]);
+                for (int32_t j = 0; j < (1 << shift); ++j)
+                    table->Lookup[(code << shift) + j] = entry;
+            }
+        }
+        table->MaxCode[length] = (count > 0) ? code - 1 : -1;
+        code <<= 1;
+    }
+    table->MaxCode[0]  = -1;
+    table->MaxCode[17] = INT32_MAX;
+    table->Defined     = true;
+    for (int32_t i = 0; i < (1 << JPEG_HUFFMAN_LOOKUP_BITS); ++i)
+    {   // resolve AC symbols whose code and value bits fit in the lookup, with small values.
+        int32_t entry  = table->Lookup[i];
+        int32_t length = entry >> 8;
+        int32_t run    =(entry >> 4) & 15;
+        int32_t size   = entry & 15;
+        table->FastAC[i] = 0;
+        if (entry != 0 && size != 0 && length + size <= JPEG_HUFFMAN_LOOKUP_BITS)
+        {
+            int32_t value = ((i << length) & ((1 << JPEG_HUFFMAN_LOOKUP_BITS) - 1)) >> (JPEG_HUFFMAN_LOOKUP_BITS - size);
+            if (value < (1 << (size - 1))) value -= (1 << size) - 1;
+            if (value >= -128 && value <= 127)
+                table->FastAC[i] = int16_t((value * 256) + (run * 16) + length + size);
+        }
+    }
+    return true;
+}
+
+/// @summary Decode one block of a sequential scan.
+/// @param bits The bit reader.
+/// @param dc The DC Huffman table.
+/// @param ac The AC Huffman table.
+/// @param block The 64 coefficients of the block, in natural order. Must be zeroed.
+/// @param pred The DC predictor of the component, updated on return.
+/// @return true if the block was decoded, or false if it contains an invalid code.
+internal_function bool jpeg_decode_block(jpeg_bits_t *bits, jpeg_huffman_t const *dc, jpeg_huffman_t const *ac, int16_t *block, int32_t *pred)
+{
+    jpeg_bits_refill(bits);
+    int32_t s = jpeg_huffman_decode(bits, dc);
+    if (s < 0 || s > 16) return false;
+    *pred    = int32_t(uint32_t(*pred) + uint32_t(jpeg_bits_extend(bits, uint32_t(s))));
+    block[0] = int16_t(*pred);
+    for (uint32_t k = 1; k < 64; ++k)
+    {
+        if (bits->Count < 32)
+            jpeg_bits_refill(bits);
+        int32_t fast = ac->FastAC[bits->Buffer >> (64 - JPEG_HUFFMAN_LOOKUP_BITS)];
+        if (fast != 0)
+        {   // the run, value and code length are all given by the lookup.
+            k += (fast >> 4) & 15;
+            jpeg_bits_consume(bits, uint32_t(fast & 15));
+            if (k > 63) return false;
+            block[JPEG_NATURAL_ORDER[k]] = int16_t(fast >> 8);
+            continue;
+        }
+        int32_t rs = jpeg_huffman_decode(bits, ac);
+        if (rs < 0) return false;
+        uint32_t r = uint32_t(rs) >> 4;
+        s = rs & 15;
+        if (s == 0)
+        {
+            if (r != 15) break; // end of block.
+            k += 15;            // a run of sixteen zeros.
+            continue;
+        }
+        k += r;
+        if (k > 63) return false;
+        block[JPEG_NATURAL_ORDER[k]] = int16_t(jpeg_bits_extend(bits, uint32_t(s)));
+    }
+    return true;
+}
+
+/// @summary Decode the DC coefficient of one block in the first scan of a progressive DC band.
+/// @param bits The bit reader.
+/// @param dc The DC Huffman table.
+/// @param block The 64 coefficients of the block, in natural order.
+/// @param pred The DC predictor of the component, updated on return.
+/// @param al The successive approximation bit position.
+/// @return true if the coefficient was decoded, or false if it is an invalid code.
+internal_function bool jpeg_decode_dc_first(jpeg_bits_t *bits, jpeg_huffman_t const *dc, int16_t *block, int32_t *pred, uint32_t al)
+{
+    jpeg_bits_refill(bits);
+    int32_t s = jpeg_huffman_decode(bits, dc);
+    if (s < 0 || s > 16) return false;
+    *pred    = int32_t(uint32_t(*pred) + uint32_t(jpeg_bits_extend(bits, uint32_t(s))));
+    block[0] = int16_t(uint32_t(*pred) << al);
+    return true;
+}
+
+/// @summary Decode the refinement bit of the DC coefficient of one block in a progressive scan.
+/// @param bits The bit reader.
+/// @param block The 64 coefficients of the block, in natural order.
+/// @param al The successive approximation bit position.
+internal_function void jpeg_decode_dc_refine(jpeg_bits_t *bits, int16_t *block, uint32_t al)
+{
+    jpeg_bits_refill(bits);
+    if (jpeg_bits_get(bits, 1))
+        block[0] |= int16_t(1 << al);
+}
+
+/// @summary Decode the AC coefficients of one block in the first scan of a progressive AC band.
+/// @param bits The bit reader.
+/// @param ac The AC Huffman table.
+/// @param block The 64 coefficients of the block, in natural order.
+/// @param ss The first coefficient of the band.
+/// @param se The last coefficient of the band.
+/// @param al The successive approximation bit position.
+/// @param eobrun The number of blocks remaining in the current end-of-band run, updated on return.
+/// @return true if the coefficients were decoded, or false if the block contains an invalid code.
+internal_function bool jpeg_decode_ac_first(jpeg_bits_t *bits, jpeg_huffman_t const *ac, int16_t *block, uint32_t ss, uint32_t se, uint32_t al, uint32_t *eobrun)
+{
+    if (*eobrun > 0)
+    {   // this block is part of a run of blocks with no coefficients in the band.
+        (*eobrun)--;
+        return true;
+    }
+    for (uint32_t k = ss; k <= se; ++k)
+    {
+        jpeg_bits_refill(bits);
+        int32_t rs = jpeg_huffman_decode(bits, ac);
+        if (rs < 0) return false;
+        uint32_t r = uint32_t(rs) >> 4;
+        uint32_t s = uint32_t(rs) & 15;
+        if (s == 0)
+        {
+            if (r < 15)
+            {   // an end-of-band run, including this block.
+                *eobrun = (1U << r) - 1;
+                if (r > 0) *eobrun += jpeg_bits_get(bits, r);
+                break;
+            }
+            k += 15;
+            continue;
+        }
+        k += r;
+        if (k > 63) return false;
+        block[JPEG_NATURAL_ORDER[k]] = int16_t(uint32_t(jpeg_bits_extend(bits, s)) << al);
+    }
+    return true;
+}
+
+/// @summary Decode the AC coefficients of one block in a refinement scan of a progressive AC band.
+/// @param bits The bit reader.
+/// @param ac The AC Huffman table.
+/// @param block The 64 coefficients of the block, in natural order.
+/// @param ss The first coefficient of the band.
+/// @param se The last coefficient of the band.
+/// @param al The successive approximation bit position.
+/// @param eobrun The number of blocks remaining in the current end-of-band run, updated on return.
+/// @return true if the coefficients were decoded, or false if the block contains an invalid code.
+internal_function bool jpeg_decode_ac_refine(jpeg_bits_t *bits, jpeg_huffman_t const *ac, int16_t *block, uint32_t ss, uint32_t se, uint32_t al, uint32_t *eobrun)
+{
+    int32_t  p1 =  1 << al;
+    int32_t  m1 = -1 * p1;
+    uint32_t k  = ss;
+    if (*eobrun == 0)
+    {
+        for ( ; k <= se; ++k)
+        {
+            jpeg_bits_refill(bits);
+            int32_t rs = jpeg_huffman_decode(bits, ac);
+            if (rs < 0) return false;
+            int32_t r = rs >> 4;
+            int32_t s = rs & 15;
+            if (s != 0)
+            {   // a newly non-zero coefficient of magnitude 1, with its sign.
+                s = jpeg_bits_get(bits, 1) ? p1 : m1;
+            }
+            else if (r != 15)
+            {   // an end-of-band run, including this block; the rest of the band is refined below.
+                *eobrun = 1U << r;
+                if (r > 0) *eobrun += jpeg_bits_get(bits, uint32_t(r));
+                break;
+            }
+            // skip r zero coefficients, refining the non-zero coefficients passed over.
+            do
+            {
+                int16_t *coef = &block[JPEG_NATURAL_ORDER[k]];
+                if (*coef != 0)
+                {
+                    jpeg_bits_refill(bits);
+                    if (jpeg_bits_get(bits, 1) && (*coef & p1) == 0)
+                        *coef = int16_t(*coef + (*coef >= 0 ? p1 : m1));
+                }
+                else
+                {
+                    if (--r < 0) break;
+                }
+                k++;
+            } while (k <= se);
+            if (s != 0)
+            {
+                block[JPEG_NATURAL_ORDER[k]] = int16_t(s);
+            }
+        }
+    }
+    if (*eobrun > 0)
+    {   // refine the non-zero coefficients in the rest of the band.
+        for ( ; k <= se; ++k)
+        {
+            int16_t *coef = &block[JPEG_NATURAL_ORDER[k]];
+            if (*coef != 0)
+            {
+                jpeg_bits_refill(bits);
+                if (jpeg_bits_get(bits, 1) && (*coef & p1) == 0)
+                    *coef = int16_t(*coef + (*coef >= 0 ? p1 : m1));
+            }
+        }
+        (*eobrun)--;
+    }
+    return true;
+}
+
+/// @summary Perform the one-dimensional AAN IDCT on eight rows or columns of eight values at once.
+/// @param v The eight input vectors, overwritten with the output vectors.
+internal_function inline void jpeg_idct_1d_avx2(__m256 v[8])
+{
+    __m256 sqrt2 = _mm256_set1_ps(1.414213562f);
+    // even part.
+    __m256 tmp10 = _mm256_add_ps(v[0], v[4]);
+    __m256 tmp11 = _mm256_sub_ps(v[0], v[4]);
+    __m256 tmp13 = _mm256_add_ps(v[2], v[6]);
+    __m256 tmp12 = _mm256_sub_ps(_mm256_mul_ps(_mm256_sub_ps(v[2], v[6]), sqrt2), tmp13);
+    __m256 tmp0  = _mm256_add_ps(tmp10, tmp13);
+    __m256 tmp3  = _mm256_sub_ps(tmp10, tmp13);
+    __m256 tmp1  = _mm256_add_ps(tmp11, tmp12);
+    __m256 tmp2  = _mm256_sub_ps(tmp11, tmp12);
+    // odd part.
+    __m256 z13   = _mm256_add_ps(v[5], v[3]);
+    __m256 z10   = _mm256_sub_ps(v[5], v[3]);
+    __m256 z11   = _mm256_add_ps(v[1], v[7]);
+    __m256 z12   = _mm256_sub_ps(v[1], v[7]);
+    __m256 tmp7  = _mm256_add_ps(z11, z13);
+    __m256 z5    = _mm256_mul_ps(_mm256_add_ps(z10, z12), _mm256_set1_ps(1.847759065f));
+    __m256 tmp4  = _mm256_sub_ps(z5, _mm256_mul_ps(z12, _mm256_set1_ps(1.082392200f)));
+    __m256 tmp6  = _mm256_sub_ps(_mm256_sub_ps(z5, _mm256_mul_ps(z10, _mm256_set1_ps(2.613125930f))), tmp7);
+    __m256 tmp5  = _mm256_sub_ps(_mm256_mul_ps(_mm256_sub_ps(z11, z13), sqrt2), tmp6);
+    tmp4         = _mm256_sub_ps(tmp4, tmp5);
+    v[0] = _mm256_add_ps(tmp0, tmp7);
+    v[7] = _mm256_sub_ps(tmp0, tmp7);
+    v[1] = _mm256_add_ps(tmp1, tmp6);
+    v[6] = _mm256_sub_ps(tmp1, tmp6);
+    v[2] = _mm256_add_ps(tmp2, tmp5);
+    v[5] = _mm256_sub_ps(tmp2, tmp5);
+    v[3] = _mm256_add_ps(tmp3, tmp4);
+    v[4] = _mm256_sub_ps(tmp3, tmp4);
+}
+
+/// @summary Transpose an 8x8 matrix of single-precision values held in eight vectors.
+/// @param v The rows of the matrix, overwritten with the columns.
+internal_function inline void jpeg_transpose_avx2(__m256 v[8])
+{
+    __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+    __m256 t1 = _mm256_unpackhi_ps(v[0], v[1]);
+    __m256 t2 = _mm256_unpacklo_ps(v[2], v[3]);
+    __m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+    __m256 t4 = _mm256_unpacklo_ps(v[4], v[5]);
+    __m256 t5 = _mm256_unpackhi_ps(v[4], v[5]);
+    __m256 t6 = _mm256_unpacklo_ps(v[6], v[7]);
+    __m256 t7 = _mm256_unpackhi_ps(v[6], v[7]);
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    v[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    v[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    v[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    v[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    v[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    v[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    v[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    v[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+/// @summary Dequantize and transform one block with AVX2, writing 8x8 samples.
+/// @param block The 64 coefficients of the block, in natural order.
+/// @param quant The 64 dequantization multipliers, in natural order.
+/// @param dst The top-left sample of the block.
+/// @param pitch The number of bytes between rows of samples.
+internal_function void jpeg_idct_avx2(int16_t const *block, float const *quant, uint8_t *dst, size_t pitch)
+{
+    __m256 v[8];
+    for (size_t i = 0; i < 8; ++i)
+    {
+        __m256i c = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i const*)(block + i * 8)));
+        v[i] = _mm256_mul_ps(_mm256_cvtepi32_ps(c), _mm256_loadu_ps(quant + i * 8));
+    }
+    jpeg_idct_1d_avx2(v);   // columns.
+    jpeg_transpose_avx2(v);
+    jpeg_idct_1d_avx2(v);   // rows, held as columns.
+    jpeg_transpose_avx2(v);
+    __m256 center = _mm256_set1_ps(128.0f);
+    for (size_t i = 0; i < 8; i += 4)
+    {   // round, level shift and saturate four rows at a time.
+        __m256i r0  = _mm256_cvtps_epi32(_mm256_add_ps(v[i + 0], center));
+        __m256i r1  = _mm256_cvtps_epi32(_mm256_add_ps(v[i + 1], center));
+        __m256i r2  = _mm256_cvtps_epi32(_mm256_add_ps(v[i + 2], center));
+        __m256i r3  = _mm256_cvtps_epi32(_mm256_add_ps(v[i + 3], center));
+        __m256i r01 = _mm256_permute4x64_epi64(_mm256_packs_epi32(r0, r1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i r23 = _mm256_permute4x64_epi64(_mm256_packs_epi32(r2, r3), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i p   = _mm256_packus_epi16(r01, r23); // lane 0: rows 0, 2; lane 1: rows 1, 3.
+        __m128i lo  = _mm256_castsi256_si128(p);
+        __m128i hi  = _mm256_extracti128_si256(p, 1);
+        _mm_storel_epi64((__m128i*)(dst + (i + 0) * pitch), lo);
+        _mm_storel_epi64((__m128i*)(dst + (i + 1) * pitch), hi);
+        _mm_storel_epi64((__m128i*)(dst + (i + 2) * pitch), _mm_srli_si128(lo, 8));
+        _mm_storel_epi64((__m128i*)(dst + (i + 3) * pitch), _mm_srli_si128(hi, 8));
+    }
+}
+
+/// @summary Perform the one-dimensional AAN IDCT on four rows or columns of eight values at once.
+/// @param v The eight input vectors, overwritten with the output vectors.
+internal_function inline void jpeg_idct_1d_sse2(__m128 v[8])
+{
+    __m128 sqrt2 = _mm_set1_ps(1.414213562f);
+    // even part.
+    __m128 tmp10 = _mm_add_ps(v[0], v[4]);
+    __m128 tmp11 = _mm_sub_ps(v[0], v[4]);
+    __m128 tmp13 = _mm_add_ps(v[2], v[6]);
+    __m128 tmp12 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(v[2], v[6]), sqrt2), tmp13);
+    __m128 tmp0  = _mm_add_ps(tmp10, tmp13);
+    __m128 tmp3  = _mm_sub_ps(tmp10, tmp13);
+    __m128 tmp1  = _mm_add_ps(tmp11, tmp12);
+    __m128 tmp2  = _mm_sub_ps(tmp11, tmp12);
+    // odd part.
+    __m128 z13   = _mm_add_ps(v[5], v[3]);
+    __m128 z10   = _mm_sub_ps(v[5], v[3]);
+    __m128 z11   = _mm_add_ps(v[1], v[7]);
+    __m128 z12   = _mm_sub_ps(v[1], v[7]);
+    __m128 tmp7  = _mm_add_ps(z11, z13);
+    __m128 z5    = _mm_mul_ps(_mm_add_ps(z10, z12), _mm_set1_ps(1.847759065f));
+    __m128 tmp4  = _mm_sub_ps(z5, _mm_mul_ps(z12, _mm_set1_ps(1.082392200f)));
+    __m128 tmp6  = _mm_sub_ps(_mm_sub_ps(z5, _mm_mul_ps(z10, _mm_set1_ps(2.613125930f))), tmp7);
+    __m128 tmp5  = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(z11, z13), sqrt2), tmp6);
+    tmp4         = _mm_sub_ps(tmp4, tmp5);
+    v[0] = _mm_add_ps(tmp0, tmp7);
+    v[7] = _mm_sub_ps(tmp0, tmp7);
+    v[1] = _mm_add_ps(tmp1, tmp6);
+    v[6] = _mm_sub_ps(tmp1, tmp6);
+    v[2] = _mm_add_ps(tmp2, tmp5);
+    v[5] = _mm_sub_ps(tmp2, tmp5);
+    v[3] = _mm_add_ps(tmp3, tmp4);
+    v[4] = _mm_sub_ps(tmp3, tmp4);
+}
+
+/// @summary Transpose an 8x8 matrix of single-precision values held as left and right halves.
+/// @param l The left four columns of each row, overwritten with the first four rows of each column.
+/// @param r The right four columns of each row, overwritten with the last four rows of each column.
+internal_function inline void jpeg_transpose_sse2(__m128 l[8], __m128 r[8])
+{
+    __m128 a0 = l[0], a1 = l[1], a2 = l[2], a3 = l[3]; // rows 0-3, columns 0-3.
+    __m128 b0 = r[0], b1 = r[1], b2 = r[2], b3 = r[3]; // rows 0-3, columns 4-7.
+    __m128 c0 = l[4], c1 = l[5], c2 = l[6], c3 = l[7]; // rows 4-7, columns 0-3.
+    __m128 d0 = r[4], d1 = r[5], d2 = r[6], d3 = r[7]; // rows 4-7, columns 4-7.
+    _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+    _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+    l[0] = a0; l[1] = a1; l[2] = a2; l[3] = a3;
+    r[0] = c0; r[1] = c1; r[2] = c2; r[3] = c3;
+    l[4] = b0; l[5] = b1; l[6] = b2; l[7] = b3;
+    r[4] = d0; r[5] = d1; r[6] = d2; r[7] = d3;
+}
+
+/// @summary Dequantize and transform one block with SSE2, writing 8x8 samples.
+/// @param block The 64 coefficients of the block, in natural order.
+/// @param quant The 64 dequantization multipliers, in natural order.
+/// @param dst The top-left sample of the block.
+/// @param pitch The number of bytes between rows of samples.
+internal_function void jpeg_idct_sse2(int16_t const *block, float const *quant, uint8_t *dst, size_t pitch)
+{
+    __m128 l[8], r[8];
+    for (size_t i = 0; i < 8; ++i)
+    {
+        __m128i c  = _mm_loadu_si128((__m128i const*)(block + i * 8));
+        __m128i cl = _mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16);
+        __m128i ch = _mm_srai_epi32(_mm_unpackhi_epi16(c, c), 16);
+        l[i] = _mm_mul_ps(_mm_cvtepi32_ps(cl), _mm_loadu_ps(quant + i * 8));
+        r[i] = _mm_mul_ps(_mm_cvtepi32_ps(ch), _mm_loadu_ps(quant + i * 8 + 4));
+    }
+    jpeg_idct_1d_sse2(l);   // columns.
+    jpeg_idct_1d_sse2(r);
+    jpeg_transpose_sse2(l, r);
+    jpeg_idct_1d_sse2(l);   // rows, held as columns.
+    jpeg_idct_1d_sse2(r);
+    jpeg_transpose_sse2(l, r);
+    __m128 center = _mm_set1_ps(128.0f);
+    for (size_t i = 0; i < 8; i += 2)
+    {   // round, level shift and saturate two rows at a time.
+        __m128i r0 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_add_ps(l[i + 0], center)), _mm_cvtps_epi32(_mm_add_ps(r[i + 0], center)));
+        __m128i r1 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_add_ps(l[i + 1], center)), _mm_cvtps_epi32(_mm_add_ps(r[i + 1], center)));
+        __m128i p  = _mm_packus_epi16(r0, r1);
+        _mm_storel_epi64((__m128i*)(dst + (i + 0) * pitch), p);
+        _mm_storel_epi64((__m128i*)(dst + (i + 1) * pitch), _mm_srli_si128(p, 8));
+    }
+}
+
+/// @summary Dequantize and transform one block, writing 8x8 samples. Blocks with only a DC coefficient, which are common at high compression, are filled directly.
+/// @param jpg The decoder state.
+/// @param block The 64 coefficients of the block, in natural order.
+/// @param quant The 64 dequantization multipliers, in natural order.
+/// @param dst The top-left sample of the block.
+/// @param pitch The number of bytes between rows of samples.
+internal_function inline void jpeg_idct_block(jpeg_decoder_t const *jpg, int16_t const *block, float const *quant, uint8_t *dst, size_t pitch)
+{
+    __m128i ac = _mm_and_si128(_mm_loadu_si128((__m128i const*) block), _mm_set_epi16(-1, -1, -1, -1, -1, -1, -1, 0));
+    for (size_t i = 1; i < 8; ++i)
+        ac = _mm_or_si128(ac, _mm_loadu_si128((__m128i const*)(block + i * 8)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(ac, _mm_setzero_si128())) == 0xFFFF)
+    {   // every sample has the value of the DC term.
+        int32_t value = _mm_cvtss_si32(_mm_set_ss(float(block[0]) * quant[0] + 128.0f));
+        uint8_t fill  = uint8_t(value < 0 ? 0 : (value > 255 ? 255 : value));
+        for (size_t i = 0; i < 8; ++i)
+            memset(dst + i * pitch, fill, 8);
+        return;
+    }
+    if (jpg->UseAVX2) jpeg_idct_avx2(block, quant, dst, pitch);
+    else jpeg_idct_sse2(block, quant, dst, pitch);
+}
+
+/// @summary Decode one block of the current scan, using the decoding procedure for the scan type. In a sequential frame, each block is complete after its only scan, so it is transformed into the sample plane immediately; in a progressive frame, the coefficients are accumulated until the EOI marker.
+/// @param jpg The decoder state.
+/// @param bits The bit reader.
+/// @param comp The component to which the block belongs.
+/// @param bx The zero-based index of the block column within the component.
+/// @param by The zero-based index of the block row within the component.
+/// @param pred The DC predictor of the component.
+/// @param eobrun The end-of-band run counter of the restart interval.
+/// @return true if the block was decoded, or false if it contains an invalid code.
+internal_function inline bool jpeg_decode_scan_block(jpeg_decoder_t const *jpg, jpeg_bits_t *bits, jpeg_component_t const *comp, size_t bx, size_t by, int32_t *pred, uint32_t *eobrun)
+{
+    if (!jpg->Progressive)
+    {
+        int16_t block[64];
+        size_t pitch = comp->BlocksW * 8;
+        memset(block, 0, sizeof(block));
+        if (!jpeg_decode_block(bits, &jpg->DCTables[comp->Td], &jpg->ACTables[comp->Ta], block, pred))
+            return false;
+        jpeg_idct_block(jpg, block, comp->Quant, comp->Plane + (by * pitch + bx) * 8, pitch);
+        return true;
+    }
+    int16_t *block = comp->Coefficients + (by * comp->BlocksW + bx) * 64;
+    if (jpg->Ss == 0)
+    {
+        if (jpg->Ah == 0) return jpeg_decode_dc_first(bits, &jpg->DCTables[comp->Td], block, pred, jpg->Al);
+        jpeg_decode_dc_refine(bits, block, jpg->Al);
+        return true;
+    }
+    if (jpg->Ah == 0) return jpeg_decode_ac_first (bits, &jpg->ACTables[comp->Ta], block, jpg->Ss, jpg->Se, jpg->Al, eobrun);
+    else return jpeg_decode_ac_refine(bits, &jpg->ACTables[comp->Ta], block, jpg->Ss, jpg->Se, jpg->Al, eobrun);
+}
+
+/// @summary Decode one restart interval of the current scan.
+/// @param jpg The decoder state.
+/// @param interval The zero-based index of the restart interval.
+/// @param first_mcu The zero-based index of the first MCU of the interval.
+/// @param mcu_count The number of MCUs in the interval.
+/// @return true if the interval was decoded, or false if it contains an invalid code.
+internal_function bool jpeg_decode_interval(jpeg_decoder_t const *jpg, size_t interval, size_t first_mcu, size_t mcu_count)
+{
+    jpeg_bits_t bits;
+    int32_t     pred[JPEG_MAX_COMPONENTS] = { 0, 0, 0, 0 };
+    uint32_t    eobrun = 0;
+    size_t      begin  =(interval == 0) ? 0 : jpg->Restarts[interval - 1];
+    size_t      end    =(interval < jpg->RestartCount) ? jpg->Restarts[interval] : jpg->ScanSize;
+    bits.Cursor = jpg->ScanData + begin;
+    bits.End    = jpg->ScanData + end;
+    bits.Buffer = 0;
+    bits.Count  = 0;
+    if (jpg->ScanComponentCount == 1)
+    {   // a non-interleaved scan: each MCU is a single block, in raster order over the component.
+        jpeg_component_t const *comp = &jpg->Components[jpg->ScanComponents[0]];
+        size_t bx = first_mcu % comp->ScanBlocksW;
+        size_t by = first_mcu / comp->ScanBlocksW;
+        for (size_t i = 0; i < mcu_count; ++i)
+        {
+            if (!jpeg_decode_scan_block(jpg, &bits, comp, bx, by, &pred[0], &eobrun))
+                return false;
+            if (++bx == comp->ScanBlocksW)
+            {
+                bx = 0;
+                by++;
+            }
+        }
+        return true;
+    }
+    size_t mx = first_mcu % jpg->McusX;
+    size_t my = first_mcu / jpg->McusX;
+    for (size_t i = 0; i < mcu_count; ++i)
+    {   // an interleaved scan: each MCU contains H * V blocks of each component.
+        for (size_t c = 0; c < jpg->ScanComponentCount; ++c)
+        {
+            jpeg_component_t const *comp = &jpg->Components[jpg->ScanComponents[c]];
+            for (size_t v = 0; v < comp->V; ++v)
+            {
+                for (size_t h = 0; h < comp->H; ++h)
+                {
+                    if (!jpeg_decode_scan_block(jpg, &bits, comp, mx * comp->H + h, my * comp->V + v, &pred[c], &eobrun))
+                        return false;
+                }
+            }
+        }
+        if (++mx == jpg->McusX)
+        {
+            mx = 0;
+            my++;
+        }
+    }
+    return true;
+}
+
+/// @summary Decode a run of restart intervals of the current scan. Called on the worker pool.
+/// @param context The jpeg_scan_job_t.
+/// @param index The zero-based index of the work item.
+internal_function void jpeg_decode_scan_item(void *context, size_t index)
+{
+    jpeg_scan_job_t *job   = (jpeg_scan_job_t*) context;
+    size_t           first = (index * job->IntervalCount) / job->ItemCount;
+    size_t           final =((index + 1) * job->IntervalCount) / job->ItemCount;
+    for (size_t i = first; i < final; ++i)
+    {
+        size_t first_mcu = i * job->Interval;
+        size_t mcu_count = image_min2<size_t>(job->Interval, job->McuCount - first_mcu);
+        if (!jpeg_decode_interval(job->JPEG, i, first_mcu, mcu_count))
+        {
+            job->Failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+/// @summary Decode the buffered data of the current scan into the coefficient buffers.
+/// @param jpg The decoder state.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_decode_scan(jpeg_decoder_t *jpg)
+{
+    jpeg_scan_job_t job;
+    if (jpg->ScanComponentCount == 1)
+    {
+        jpeg_component_t const *comp = &jpg->Components[jpg->ScanComponents[0]];
+        job.McuCount = comp->ScanBlocksW * comp->ScanBlocksH;
+    }
+    else job.McuCount = jpg->McusX * jpg->McusY;
+    job.JPEG          = jpg;
+    job.Interval      =(jpg->RestartInterval > 0) ? jpg->RestartInterval : job.McuCount;
+    job.IntervalCount =(job.McuCount + job.Interval - 1) / job.Interval;
+    job.Failed.store(false, std::memory_order_relaxed);
+    if (jpg->RestartInterval == 0)
+    {   // restart markers are meaningless without a restart interval.
+        jpg->RestartCount = 0;
+    }
+    else if (jpg->RestartCount + 1 < job.IntervalCount)
+    {   // restart markers are missing, so the intervals can't be located.
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    }
+    memset(jpg->ScanData + jpg->ScanSize, 0, JPEG_SCAN_PADDING);
+
+    // intervals are independent, since the predictors and end-of-band runs are reset at each restart marker.
+    size_t threads = (jpg->WorkPool != NULL) ? jpg->WorkPool->ThreadCount + 1 : 1;
+    job.ItemCount  = image_min2<size_t>(job.IntervalCount, threads * JPEG_SCAN_ITEMS_PER_THREAD);
+    work_pool_run(jpg->WorkPool, jpeg_decode_scan_item, &job, job.ItemCount);
+    jpg->ScanCount++;
+    jpg->ScanSize     = 0;
+    jpg->RestartCount = 0;
+    return job.Failed.load(std::memory_order_relaxed) ? JPEG_PARSE_ERROR_BAD_DATA : JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Transform a band of block rows of one component. Called on the worker pool.
+/// @param context The jpeg_idct_job_t.
+/// @param index The zero-based index of the work item.
+internal_function void jpeg_idct_item(void *context, size_t index)
+{
+    jpeg_idct_job_t *job = (jpeg_idct_job_t*) context;
+    jpeg_decoder_t  *jpg =  job->JPEG;
+    size_t           c   =  0;
+    while (index >= job->FirstItem[c + 1]) c++;
+    jpeg_component_t *comp  = &jpg->Components[c];
+    size_t            pitch =  comp->BlocksW * 8;
+    size_t            first = (index - job->FirstItem[c]) * JPEG_IDCT_BAND_ROWS;
+    size_t            final =  image_min2<size_t>(first + JPEG_IDCT_BAND_ROWS, comp->BlocksH);
+    for (size_t by = first; by < final; ++by)
+    {
+        int16_t const *block = comp->Coefficients + by * comp->BlocksW * 64;
+        uint8_t       *dst   = comp->Plane + by * 8 * pitch;
+        for (size_t bx = 0; bx < comp->BlocksW; ++bx, block += 64, dst += 8)
+        {
+            jpeg_idct_block(jpg, block, comp->Quant, dst, pitch);
+        }
+    }
+}
+
+/// @summary Upsample one row of a component subsampled 2:1 horizontally, using the libjpeg triangle filter.
+/// @param src The component row, with count samples.
+/// @param count The number of samples in the component row.
+/// @param dst The output row, with space for count * 2 samples.
+internal_function void jpeg_upsample_h2v1(uint8_t const *src, size_t count, uint8_t *dst)
+{
+    if (count == 1)
+    {
+        dst[0] = dst[1] = src[0];
+        return;
+    }
+    dst[0] = src[0];
+    dst[1] = uint8_t((src[0] * 3 + src[1] + 2) >> 2);
+    for (size_t i = 1; i < count - 1; ++i)
+    {
+        uint32_t mid  = src[i] * 3;
+        dst[i * 2 + 0] = uint8_t((mid + src[i - 1] + 1) >> 2);
+        dst[i * 2 + 1] = uint8_t((mid + src[i + 1] + 2) >> 2);
+    }
+    dst[count * 2 - 2] = uint8_t((src[count - 1] * 3 + src[count - 2] + 1) >> 2);
+    dst[count * 2 - 1] = src[count - 1];
+}
+
+/// @summary Upsample one row of a component subsampled 2:1 in both directions, using the libjpeg triangle filter.
+/// @param row0 The nearer component row, with count samples.
+/// @param row1 The farther component row, with count samples.
+/// @param count The number of samples in each component row.
+/// @param sums Scratch space for count column sums.
+/// @param dst The output row, with space for count * 2 samples.
+internal_function void jpeg_upsample_h2v2(uint8_t const *row0, uint8_t const *row1, size_t count, uint16_t *sums, uint8_t *dst)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        sums[i] = uint16_t(row0[i] * 3 + row1[i]);
+    }
+    if (count == 1)
+    {
+        dst[0] = uint8_t((sums[0] * 4 + 8) >> 4);
+        dst[1] = uint8_t((sums[0] * 4 + 7) >> 4);
+        return;
+    }
+    dst[0] = uint8_t((sums[0] * 4 + 8) >> 4);
+    dst[1] = uint8_t((sums[0] * 3 + sums[1] + 7) >> 4);
+    for (size_t i = 1; i < count - 1; ++i)
+    {
+        uint32_t mid = sums[i] * 3;
+        dst[i * 2 + 0] = uint8_t((mid + sums[i - 1] + 8) >> 4);
+        dst[i * 2 + 1] = uint8_t((mid + sums[i + 1] + 7) >> 4);
+    }
+    dst[count * 2 - 2] = uint8_t((sums[count - 1] * 3 + sums[count - 2] + 8) >> 4);
+    dst[count * 2 - 1] = uint8_t((sums[count - 1] * 4 + 7) >> 4);
+}
+
+/// @summary Upsample one row of a component subsampled 2:1 vertically, using the libjpeg triangle filter.
+/// @param row0 The nearer component row, with count samples.
+/// @param row1 The farther component row, with count samples.
+/// @param count The number of samples in each component row.
+/// @param bias The rounding bias, 1 for rows nearer the top and 2 for rows nearer the bottom of the component row.
+/// @param dst The output row, with space for count samples.
+internal_function void jpeg_upsample_h1v2(uint8_t const *row0, uint8_t const *row1, size_t count, uint32_t bias, uint8_t *dst)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        dst[i] = uint8_t((row0[i] * 3 + row1[i] + bias) >> 2);
+    }
+}
+
+/// @summary Retrieve one row of a component at the full image resolution.
+/// @param jpg The decoder state.
+/// @param comp The component.
+/// @param y The zero-based index of the image row.
+/// @param scratch Scratch space for the upsampled row and column sums.
+/// @return A pointer to the row, which may point into the component plane or into scratch.
+internal_function uint8_t const* jpeg_component_row(jpeg_decoder_t const *jpg, jpeg_component_t const *comp, size_t y, uint8_t *scratch)
+{
+    size_t         pitch = comp->BlocksW * 8;
+    size_t         hf    = jpg->Hmax / comp->H;
+    size_t         vf    = jpg->Vmax / comp->V;
+    size_t         cy    = y / vf;
+    uint8_t const *row   = comp->Plane + cy * pitch;
+    switch (comp->Upsample)
+    {
+    case JPEG_UPSAMPLE_NONE:
+        return row;
+    case JPEG_UPSAMPLE_H2V1:
+        jpeg_upsample_h2v1(row, comp->Width, scratch);
+        return scratch;
+    case JPEG_UPSAMPLE_H2V2:
+        {   // the farther row is above for even rows and below for odd rows, replicating the edge rows.
+            size_t fy = (y & 1) ? image_min2<size_t>(cy + 1, comp->Height - 1) : (cy > 0 ? cy - 1 : 0);
+            uint16_t *sums = (uint16_t*)(scratch + ((comp->Width * 2 + 15) & ~size_t(15)));
+            jpeg_upsample_h2v2(row, comp->Plane + fy * pitch, comp->Width, sums, scratch);
+        }
+        return scratch;
+    case JPEG_UPSAMPLE_H1V2:
+        {
+            size_t fy = (y & 1) ? image_min2<size_t>(cy + 1, comp->Height - 1) : (cy > 0 ? cy - 1 : 0);
+            jpeg_upsample_h1v2(row, comp->Plane + fy * pitch, comp->Width, (y & 1) ? 2 : 1, scratch);
+        }
+        return scratch;
+    default:
+        for (size_t x = 0; x < jpg->Width; ++x)
+            scratch[x] = row[x / hf];
+        return scratch;
+    }
+}
+
+/// @summary Convert YCbCr samples to RGBA8 pixels, sixteen at a time with AVX2. Uses the same fixed-point arithmetic as jpeg_ycc_rgba_sse2().
+/// @param y The luma samples.
+/// @param cb The blue-difference chroma samples.
+/// @param cr The red-difference chroma samples.
+/// @param dst The RGBA8 output pixels.
+/// @param count The number of pixels to convert. Must be a multiple of 16.
+internal_function void jpeg_ycc_rgba_avx2(uint8_t const *y, uint8_t const *cb, uint8_t const *cr, uint8_t *dst, size_t count)
+{
+    __m256i cr_r  = _mm256_set1_epi16( 5743);  //  1.40200 * 4096
+    __m256i cr_g  = _mm256_set1_epi16(-2925);  // -0.71414 * 4096
+    __m256i cb_g  = _mm256_set1_epi16(-1410);  // -0.34414 * 4096
+    __m256i cb_b  = _mm256_set1_epi16( 7258);  //  1.77200 * 4096
+    __m256i bias  = _mm256_set1_epi16(128);
+    __m256i round = _mm256_set1_epi16(8);
+    __m256i alpha = _mm256_set1_epi16(255);
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __m256i yw  = _mm256_add_epi16(_mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)(y + i))), 4), round);
+        __m256i cbw = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)(cb + i))), bias), 8);
+        __m256i crw = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)(cr + i))), bias), 8);
+        __m256i r   = _mm256_srai_epi16(_mm256_add_epi16(yw, _mm256_mulhi_epi16(crw, cr_r)), 4);
+        __m256i g   = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yw, _mm256_mulhi_epi16(cbw, cb_g)), _mm256_mulhi_epi16(crw, cr_g)), 4);
+        __m256i b   = _mm256_srai_epi16(_mm256_add_epi16(yw, _mm256_mulhi_epi16(cbw, cb_b)), 4);
+        __m256i rb  = _mm256_packus_epi16(r, b);     // per lane: 8 R, 8 B.
+        __m256i ga  = _mm256_packus_epi16(g, alpha); // per lane: 8 G, 8 A.
+        __m256i rg  = _mm256_unpacklo_epi8(rb, ga);  // per lane: RG pairs.
+        __m256i ba  = _mm256_unpackhi_epi8(rb, ga);  // per lane: BA pairs.
+        __m256i p0  = _mm256_unpacklo_epi16(rg, ba); // pixels 0-3 | 8-11.
+        __m256i p1  = _mm256_unpackhi_epi16(rg, ba); // pixels 4-7 | 12-15.
+        _mm256_storeu_si256((__m256i*)(dst + i * 4 +  0), _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4 + 32), _mm256_permute2x128_si256(p0, p1, 0x31));
+    }
+}
+
+/// @summary Convert YCbCr samples to RGBA8 pixels, eight at a time with SSE2.
+/// @param y The luma samples.
+/// @param cb The blue-difference chroma samples.
+/// @param cr The red-difference chroma samples.
+/// @param dst The RGBA8 output pixels.
+/// @param count The number of pixels to convert. Must be a multiple of 8.
+internal_function void jpeg_ycc_rgba_sse2(uint8_t const *y, uint8_t const *cb, uint8_t const *cr, uint8_t *dst, size_t count)
+{
+    __m128i cr_r  = _mm_set1_epi16( 5743);
+    __m128i cr_g  = _mm_set1_epi16(-2925);
+    __m128i cb_g  = _mm_set1_epi16(-1410);
+    __m128i cb_b  = _mm_set1_epi16( 7258);
+    __m128i bias  = _mm_set1_epi16(128);
+    __m128i round = _mm_set1_epi16(8);
+    __m128i alpha = _mm_set1_epi16(255);
+    __m128i zero  = _mm_setzero_si128();
+    for (size_t i = 0; i < count; i += 8)
+    {
+        __m128i yw  = _mm_add_epi16(_mm_slli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const*)(y + i)), zero), 4), round);
+        __m128i cbw = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const*)(cb + i)), zero), bias), 8);
+        __m128i crw = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const*)(cr + i)), zero), bias), 8);
+        __m128i r   = _mm_srai_epi16(_mm_add_epi16(yw, _mm_mulhi_epi16(crw, cr_r)), 4);
+        __m128i g   = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(yw, _mm_mulhi_epi16(cbw, cb_g)), _mm_mulhi_epi16(crw, cr_g)), 4);
+        __m128i b   = _mm_srai_epi16(_mm_add_epi16(yw, _mm_mulhi_epi16(cbw, cb_b)), 4);
+        __m128i rb  = _mm_packus_epi16(r, b);
+        __m128i ga  = _mm_packus_epi16(g, alpha);
+        __m128i rg  = _mm_unpacklo_epi8(rb, ga);
+        __m128i ba  = _mm_unpackhi_epi8(rb, ga);
+        _mm_storeu_si128((__m128i*)(dst + i * 4 +  0), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128((__m128i*)(dst + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+    }
+}
+
+/// @summary Convert YCbCr samples to RGBA8 pixels one at a time, matching the results of the SIMD kernels.
+/// @param y The luma samples.
+/// @param cb The blue-difference chroma samples.
+/// @param cr The red-difference chroma samples.
+/// @param dst The RGBA8 output pixels.
+/// @param count The number of pixels to convert.
+internal_function void jpeg_ycc_rgba_scalar(uint8_t const *y, uint8_t const *cb, uint8_t const *cr, uint8_t *dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        int32_t yw  =(y[i] << 4) + 8;
+        int32_t cbw =(cb[i] - 128) * 256;
+        int32_t crw =(cr[i] - 128) * 256;
+        int32_t r   =(yw + ((crw * 5743) >> 16)) >> 4;
+        int32_t g   =(yw + ((cbw * -1410) >> 16) + ((crw * -2925) >> 16)) >> 4;
+        int32_t b   =(yw + ((cbw * 7258) >> 16)) >> 4;
+        dst[i * 4 + 0] = uint8_t(r < 0 ? 0 : (r > 255 ? 255 : r));
+        dst[i * 4 + 1] = uint8_t(g < 0 ? 0 : (g > 255 ? 255 : g));
+        dst[i * 4 + 2] = uint8_t(b < 0 ? 0 : (b > 255 ? 255 : b));
+        dst[i * 4 + 3] = 255;
+    }
+}
+
+/// @summary Convert a band of output rows. Called on the worker pool.
+/// @param context The jpeg_convert_job_t.
+/// @param index The zero-based index of the work item.
+internal_function void jpeg_convert_item(void *context, size_t index)
+{
+    jpeg_convert_job_t *job     = (jpeg_convert_job_t*) context;
+    jpeg_decoder_t     *jpg     =  job->JPEG;
+    size_t              first   =  index * JPEG_CONVERT_BAND_ROWS;
+    size_t              final   =  image_min2<size_t>(first + JPEG_CONVERT_BAND_ROWS, job->RowCount);
+    size_t              width   =  jpg->Width;
+    size_t              simd    =  width & ~size_t(jpg->UseAVX2 ? 15 : 7);
+    size_t              part    =  job->ScratchSize / JPEG_MAX_COMPONENTS;
+    uint8_t            *scratch =  job->Scratch + index * job->ScratchSize;
+    for (size_t i = first; i < final; ++i)
+    {
+        size_t         y   = job->FirstRow + i;
+        uint8_t       *dst = job->Target + i * job->TargetPitch;
+        uint8_t const *c0  = jpeg_component_row(jpg, &jpg->Components[0], y, scratch);
+        if (jpg->Color == JPEG_COLOR_GRAY)
+        {
+            memcpy(dst, c0, width);
+            continue;
+        }
+        uint8_t const *c1  = jpeg_component_row(jpg, &jpg->Components[1], y, scratch + part);
+        uint8_t const *c2  = jpeg_component_row(jpg, &jpg->Components[2], y, scratch + part * 2);
+        if (jpg->Color == JPEG_COLOR_RGB)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                dst[x * 4 + 0] = c0[x];
+                dst[x * 4 + 1] = c1[x];
+                dst[x * 4 + 2] = c2[x];
+                dst[x * 4 + 3] = 255;
+            }
+            continue;
+        }
+        if (jpg->UseAVX2) jpeg_ycc_rgba_avx2(c0, c1, c2, dst, simd);
+        else jpeg_ycc_rgba_sse2(c0, c1, c2, dst, simd);
+        jpeg_ycc_rgba_scalar(c0 + simd, c1 + simd, c2 + simd, dst + simd * 4, width - simd);
+    }
+}
+
+/// @summary Grow the scan buffer so that it can hold a given number of additional bytes, plus the padding.
+/// @param jpg The decoder state.
+/// @param size The number of bytes to be appended.
+/// @return true if the buffer has enough space, or false if memory allocation failed.
+internal_function bool jpeg_scan_reserve(jpeg_decoder_t *jpg, size_t size)
+{
+    if (jpg->ScanSize + size <= jpg->ScanCapacity)
+        return true;
+    size_t   capacity = image_max2<size_t>(jpg->ScanCapacity * 2, image_max2<size_t>(jpg->ScanSize + size, JPEG_SCAN_INITIAL_SIZE));
+    uint8_t *data     = (uint8_t*) realloc(jpg->ScanData, capacity + JPEG_SCAN_PADDING);
+    if (data == NULL) return false;
+    jpg->ScanData     = data;
+    jpg->ScanCapacity = capacity;
+    return true;
+}
+
+/// @summary Record the position of a restart marker in the scan data.
+/// @param jpg The decoder state.
+/// @return true if the position was recorded, or false if memory allocation failed.
+internal_function bool jpeg_scan_restart(jpeg_decoder_t *jpg)
+{
+    if (jpg->RestartCount == jpg->RestartCapacity)
+    {
+        size_t  capacity = image_max2<size_t>(jpg->RestartCapacity * 2, 256);
+        size_t *restarts = (size_t*) realloc(jpg->Restarts, capacity * sizeof(size_t));
+        if (restarts == NULL) return false;
+        jpg->Restarts        = restarts;
+        jpg->RestartCapacity = capacity;
+    }
+    jpg->Restarts[jpg->RestartCount++] = jpg->ScanSize;
+    return true;
+}
+
+/// @summary Append entropy-coded data to the scan buffer, removing the stuffed zero bytes and recording the positions of restart markers. Stops at the first other marker.
+/// @param jpg The decoder state.
+/// @param data The entropy-coded data.
+/// @param size The number of bytes of data.
+/// @param marker On return, the code of the marker that ends the scan, or 0 if all of the data was consumed.
+/// @param error On return, one of jpeg_parser_error_e.
+/// @return The number of bytes consumed, including the marker that ends the scan.
+internal_function size_t jpeg_scan_append(jpeg_decoder_t *jpg, uint8_t const *data, size_t size, uint8_t *marker, int *error)
+{
+    size_t pos = 0;
+    *marker    = 0;
+    *error     = JPEG_PARSE_ERROR_SUCCESS;
+    if (!jpeg_scan_reserve(jpg, size))
+    {
+        *error = JPEG_PARSE_ERROR_NOMEMORY;
+        return 0;
+    }
+    while (pos < size)
+    {
+        if (jpg->PendingFF)
+        {   // the previous byte was 0xFF.
+            uint8_t code = data[pos++];
+            if (code == 0xFF)
+            {   // a fill byte; the next byte may be the marker code.
+                continue;
+            }
+            jpg->PendingFF = false;
+            if (code == 0x00)
+            {   // a stuffed zero byte following a 0xFF data byte.
+                jpg->ScanData[jpg->ScanSize++] = 0xFF;
+                continue;
+            }
+            if (code >= JPEG_MARKER_RST0 && code <= JPEG_MARKER_RST7)
+            {   // the end of a restart interval.
+                if (!jpeg_scan_restart(jpg))
+                {
+                    *error = JPEG_PARSE_ERROR_NOMEMORY;
+                    return pos;
+                }
+                continue;
+            }
+            *marker = code;
+            return pos;
+        }
+        uint8_t const *ff  = (uint8_t const*) memchr(data + pos, 0xFF, size - pos);
+        size_t         run =  (ff != NULL) ? size_t(ff - (data + pos)) : size - pos;
+        memcpy(jpg->ScanData + jpg->ScanSize, data + pos, run);
+        jpg->ScanSize += run;
+        pos           += run;
+        if (ff != NULL)
+        {
+            jpg->PendingFF = true;
+            pos++;
+        }
+    }
+    return pos;
+}
+
+/// @summary Process the data of a DQT marker segment.
+/// @param jpg The decoder state.
+/// @param data The segment data, not including the length field.
+/// @param size The size of the segment data, in bytes.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_process_dqt(jpeg_decoder_t *jpg, uint8_t const *data, size_t size)
+{
+    size_t pos = 0;
+    while (pos < size)
+    {
+        uint32_t pq = data[pos] >> 4;
+        uint32_t tq = data[pos] & 15;
+        size_t   n  =(pq != 0) ? 128 : 64;
+        if (tq > 3 || pq > 1 || pos + 1 + n > size)
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        for (size_t k = 0; k < 64; ++k)
+        {
+            uint16_t q = (pq != 0) ? jpeg_u16(data + pos + 1 + k * 2) : data[pos + 1 + k];
+            jpg->QuantTables[tq][JPEG_NATURAL_ORDER[k]] = q;
+        }
+        jpg->QuantDefined[tq] = true;
+        pos += 1 + n;
+    }
+    return JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Process the data of a DHT marker segment.
+/// @param jpg The decoder state.
+/// @param data The segment data, not including the length field.
+/// @param size The size of the segment data, in bytes.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_process_dht(jpeg_decoder_t *jpg, uint8_t const *data, size_t size)
+{
+    size_t pos = 0;
+    while (pos < size)
+    {
+        uint32_t tc    = data[pos] >> 4;
+        uint32_t th    = data[pos] & 15;
+        size_t   total = 0;
+        if (tc > 1 || th > 3 || pos + 17 > size)
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        for (size_t i = 0; i < 16; ++i)
+            total += data[pos + 1 + i];
+        if (total > 256 || pos + 17 + total > size)
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        jpeg_huffman_t *table = (tc == 0) ? &jpg->DCTables[th] : &jpg->ACTables[th];
+        if (!jpeg_huffman_build(table, data + pos + 1, data + pos + 17))
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        pos += 17 + total;
+    }
+    return JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Process the data of a SOF0, SOF1 or SOF2 marker segment. The coefficient and sample buffers are allocated by jpeg_allocate_frame().
+/// @param jpg The decoder state.
+/// @param marker The SOFn marker code.
+/// @param data The segment data, not including the length field.
+/// @param size The size of the segment data, in bytes.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_process_sof(jpeg_decoder_t *jpg, uint8_t marker, uint8_t const *data, size_t size)
+{
+    if (jpg->HaveFrame || size < 6)
+    {   // a second frame, or a truncated header.
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    }
+    size_t count = data[5];
+    if (data[0] != 8)
+    {   // 12-bit samples.
+        return JPEG_PARSE_ERROR_UNSUPPORTED;
+    }
+    if (count == 0 || size < 6 + count * 3)
+    {
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    }
+    if (count != 1 && count != 3)
+    {   // CMYK, YCCK and other component counts.
+        return JPEG_PARSE_ERROR_UNSUPPORTED;
+    }
+    jpg->Height         = jpeg_u16(data + 1);
+    jpg->Width          = jpeg_u16(data + 3);
+    jpg->ComponentCount = count;
+    jpg->Progressive    =(marker == JPEG_MARKER_SOF2);
+    jpg->Hmax           = 1;
+    jpg->Vmax           = 1;
+    if (jpg->Height == 0)
+    {   // the height is specified by a DNL marker after the first scan.
+        return JPEG_PARSE_ERROR_UNSUPPORTED;
+    }
+    if (jpg->Width == 0)
+    {
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        jpeg_component_t *comp = &jpg->Components[i];
+        comp->Id = data[6 + i * 3 + 0];
+        comp->H  = data[6 + i * 3 + 1] >> 4;
+        comp->V  = data[6 + i * 3 + 1] & 15;
+        comp->Tq = data[6 + i * 3 + 2];
+        if (comp->H < 1 || comp->H > 4 || comp->V < 1 || comp->V > 4 || comp->Tq > 3)
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        jpg->Hmax = image_max2<size_t>(jpg->Hmax, comp->H);
+        jpg->Vmax = image_max2<size_t>(jpg->Vmax, comp->V);
+    }
+    jpg->McusX = (jpg->Width  + jpg->Hmax * 8 - 1) / (jpg->Hmax * 8);
+    jpg->McusY = (jpg->Height + jpg->Vmax * 8 - 1) / (jpg->Vmax * 8);
+    for (size_t i = 0; i < count; ++i)
+    {
+        jpeg_component_t *comp = &jpg->Components[i];
+        size_t hf = jpg->Hmax / comp->H;
+        size_t vf = jpg->Vmax / comp->V;
+        if (jpg->Hmax % comp->H != 0 || jpg->Vmax % comp->V != 0)
+        {   // only integral subsampling factors are supported.
+            return JPEG_PARSE_ERROR_UNSUPPORTED;
+        }
+        comp->Width       = (jpg->Width  * comp->H + jpg->Hmax - 1) / jpg->Hmax;
+        comp->Height      = (jpg->Height * comp->V + jpg->Vmax - 1) / jpg->Vmax;
+        comp->BlocksW     =  jpg->McusX  * comp->H;
+        comp->BlocksH     =  jpg->McusY  * comp->V;
+        comp->ScanBlocksW = (comp->Width  + 7) / 8;
+        comp->ScanBlocksH = (comp->Height + 7) / 8;
+        if (hf == 1 && vf == 1) comp->Upsample = JPEG_UPSAMPLE_NONE;
+        else if (comp->Width <= 2) comp->Upsample = JPEG_UPSAMPLE_REPLICATE; // as libjpeg does, since the filter needs three samples.
+        else if (hf == 2 && vf == 1) comp->Upsample = JPEG_UPSAMPLE_H2V1;
+        else if (hf == 2 && vf == 2) comp->Upsample = JPEG_UPSAMPLE_H2V2;
+        else if (hf == 1 && vf == 2) comp->Upsample = JPEG_UPSAMPLE_H1V2;
+        else comp->Upsample = JPEG_UPSAMPLE_REPLICATE;
+    }
+    if (count == 1)
+    {
+        jpg->Color = JPEG_COLOR_GRAY;
+    }
+    else if (jpg->HaveAdobe)
+    {
+        jpg->Color = (jpg->AdobeTransform == 0) ? JPEG_COLOR_RGB : JPEG_COLOR_YCBCR;
+    }
+    else
+    {   // without an Adobe segment, only the component identifiers can indicate RGB.
+        bool rgb   = jpg->Components[0].Id == 'R' && jpg->Components[1].Id == 'G' && jpg->Components[2].Id == 'B';
+        jpg->Color = rgb ? JPEG_COLOR_RGB : JPEG_COLOR_YCBCR;
+    }
+    jpg->HaveFrame = true;
+    return JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Allocate the coefficient and sample buffers of each component once the frame header has been processed.
+/// @param jpg The decoder state.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_allocate_frame(jpeg_decoder_t *jpg)
+{
+    for (size_t i = 0; i < jpg->ComponentCount; ++i)
+    {
+        jpeg_component_t *comp   = &jpg->Components[i];
+        size_t            blocks =  comp->BlocksW * comp->BlocksH;
+        if (jpg->Progressive && (comp->Coefficients = (int16_t*) calloc(blocks, 64 * sizeof(int16_t))) == NULL)
+        {   // sequential frames transform each block as it is decoded, and don't need the coefficients.
+            return JPEG_PARSE_ERROR_NOMEMORY;
+        }
+        if ((comp->Plane = (uint8_t*) calloc(blocks, 64)) == NULL)
+            return JPEG_PARSE_ERROR_NOMEMORY;
+    }
+    return JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Process the data of a SOS marker segment, preparing to receive the scan data.
+/// @param jpg The decoder state.
+/// @param data The segment data, not including the length field.
+/// @param size The size of the segment data, in bytes.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_process_sos(jpeg_decoder_t *jpg, uint8_t const *data, size_t size)
+{
+    if (!jpg->HaveFrame || size < 1)
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    size_t count = data[0];
+    if (count < 1 || count > jpg->ComponentCount || size < 4 + count * 2)
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t id    = data[1 + i * 2 + 0];
+        uint8_t td    = data[1 + i * 2 + 1] >> 4;
+        uint8_t ta    = data[1 + i * 2 + 1] & 15;
+        size_t  index = 0;
+        while (index < jpg->ComponentCount && jpg->Components[index].Id != id)
+            index++;
+        if (index == jpg->ComponentCount || td > 3 || ta > 3)
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        jpeg_component_t *comp = &jpg->Components[index];
+        comp->Td = td;
+        comp->Ta = ta;
+        jpg->ScanComponents[i] = index;
+    }
+    jpg->ScanComponentCount = count;
+    jpg->Ss = data[1 + count * 2 + 0];
+    jpg->Se = data[1 + count * 2 + 1];
+    jpg->Ah = data[1 + count * 2 + 2] >> 4;
+    jpg->Al = data[1 + count * 2 + 2] & 15;
+    if (jpg->Progressive)
+    {   // DC scans may be interleaved; AC scans cover one component and don't include the DC coefficient.
+        if (jpg->Ss > jpg->Se || jpg->Se > 63 || jpg->Al > 13 || (jpg->Ss == 0 && jpg->Se != 0) || (jpg->Ss != 0 && count != 1))
+            return JPEG_PARSE_ERROR_BAD_DATA;
+    }
+    else
+    {   // sequential scans code all 64 coefficients.
+        jpg->Ss = 0;
+        jpg->Se = 63;
+        jpg->Ah = 0;
+        jpg->Al = 0;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {   // check that the tables used by the scan have been defined, and latch the dequantization multipliers.
+        jpeg_component_t *comp = &jpg->Components[jpg->ScanComponents[i]];
+        bool need_dc = jpg->Ss == 0 && jpg->Ah == 0;
+        bool need_ac = jpg->Se != 0;
+        if ((need_dc && !jpg->DCTables[comp->Td].Defined) || (need_ac && !jpg->ACTables[comp->Ta].Defined) || !jpg->QuantDefined[comp->Tq])
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        for (size_t k = 0; k < 64; ++k)
+        {   // fold the AAN scale factors and the final division by eight into the multipliers.
+            comp->Quant[k] = float(jpg->QuantTables[comp->Tq][k]) * JPEG_AAN_SCALE[k >> 3] * JPEG_AAN_SCALE[k & 7] * 0.125f;
+        }
+    }
+    jpg->ScanSize     = 0;
+    jpg->RestartCount = 0;
+    jpg->PendingFF    = false;
+    return JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Process the data of a marker segment other than SOS.
+/// @param jpg The decoder state.
+/// @param marker The marker code.
+/// @param data The segment data, not including the length field.
+/// @param size The size of the segment data, in bytes.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_process_segment(jpeg_decoder_t *jpg, uint8_t marker, uint8_t const *data, size_t size)
+{
+    switch (marker)
+    {
+    case JPEG_MARKER_DQT:
+        return jpeg_process_dqt(jpg, data, size);
+    case JPEG_MARKER_DHT:
+        return jpeg_process_dht(jpg, data, size);
+    case JPEG_MARKER_SOF0:
+    case JPEG_MARKER_SOF1:
+    case JPEG_MARKER_SOF2:
+        return jpeg_process_sof(jpg, marker, data, size);
+    case JPEG_MARKER_DRI:
+        if (size < 2) return JPEG_PARSE_ERROR_BAD_DATA;
+        jpg->RestartInterval = jpeg_u16(data);
+        return JPEG_PARSE_ERROR_SUCCESS;
+    case JPEG_MARKER_APP14:
+        if (size >= 12 && memcmp(data, "Adobe", 5) == 0)
+        {   // the transform byte is the last field.
+            jpg->HaveAdobe      = true;
+            jpg->AdobeTransform = data[11];
+        }
+        return JPEG_PARSE_ERROR_SUCCESS;
+    default:
+        break;
+    }
+    if ((marker >= 0xC3 && marker <= 0xCF) || marker == JPEG_MARKER_DNL)
+    {   // lossless, hierarchical and arithmetic-coded frames, and DNL.
+        return JPEG_PARSE_ERROR_UNSUPPORTED;
+    }
+    return JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Determine whether the data of a marker segment is needed by the decoder.
+/// @param marker The marker code.
+/// @return true if the segment must be buffered, or false if it can be skipped.
+internal_function inline bool jpeg_segment_needed(uint8_t marker)
+{
+    return (marker >= 0xC0 && marker <= 0xCF) || marker == JPEG_MARKER_SOS || marker == JPEG_MARKER_DQT || marker == JPEG_MARKER_DNL || marker == JPEG_MARKER_DRI || marker == JPEG_MARKER_APP14;
+}
+
+/// @summary Transform every block of every component into the sample planes once all scans of a progressive frame have been decoded.
+/// @param jpg The decoder state.
+internal_function void jpeg_transform_frame(jpeg_decoder_t *jpg)
+{
+    jpeg_idct_job_t job;
+    if (!jpg->Progressive)
+    {   // the blocks of a sequential frame were transformed as they were decoded.
+        return;
+    }
+    job.JPEG         = jpg;
+    job.FirstItem[0] = 0;
+    for (size_t i = 0; i < jpg->ComponentCount; ++i)
+    {
+        size_t bands = (jpg->Components[i].BlocksH + JPEG_IDCT_BAND_ROWS - 1) / JPEG_IDCT_BAND_ROWS;
+        job.FirstItem[i + 1] = job.FirstItem[i] + bands;
+    }
+    for (size_t i = jpg->ComponentCount; i < JPEG_MAX_COMPONENTS; ++i)
+    {
+        job.FirstItem[i + 1] = job.FirstItem[i];
+    }
+    work_pool_run(jpg->WorkPool, jpeg_idct_item, &job, job.FirstItem[jpg->ComponentCount]);
+    for (size_t i = 0; i < jpg->ComponentCount; ++i)
+    {   // the coefficients aren't needed any more.
+        free(jpg->Components[i].Coefficients);
+        jpg->Components[i].Coefficients = NULL;
+    }
+}
+
+/// @summary Determine the size of the scratch space needed by each color conversion work item.
+/// @param jpg The decoder state.
+/// @return The size of the scratch space, in bytes.
+internal_function size_t jpeg_convert_scratch_size(jpeg_decoder_t const *jpg)
+{
+    size_t row = (jpg->McusX * jpg->Hmax * 8 * 2 + 15) & ~size_t(15);
+    return row * 2 * JPEG_MAX_COMPONENTS;
+}
+
+/// @summary Convert a run of output rows from the sample planes, on the worker pool.
+/// @param jpg The decoder state.
+/// @param first_row The zero-based index of the first row to convert.
+/// @param row_count The number of rows to convert.
+/// @param dst The first output row.
+/// @param dst_pitch The number of bytes between output rows.
+/// @param scratch Scratch space for each work item, as given by jpeg_convert_scratch_size().
+internal_function void jpeg_convert_rows(jpeg_decoder_t *jpg, size_t first_row, size_t row_count, uint8_t *dst, size_t dst_pitch, uint8_t *scratch)
+{
+    jpeg_convert_job_t job;
+    job.JPEG        = jpg;
+    job.FirstRow    = first_row;
+    job.RowCount    = row_count;
+    job.Target      = dst;
+    job.TargetPitch = dst_pitch;
+    job.Scratch     = scratch;
+    job.ScratchSize = jpeg_convert_scratch_size(jpg);
+    work_pool_run(jpg->WorkPool, jpeg_convert_item, &job, (row_count + JPEG_CONVERT_BAND_ROWS - 1) / JPEG_CONVERT_BAND_ROWS);
+}
+
+/// @summary Determine the number of rows converted in each call to jpeg_convert_rows(), so that every worker has a band.
+/// @param jpg The decoder state.
+/// @return The number of rows, a multiple of JPEG_CONVERT_BAND_ROWS.
+internal_function size_t jpeg_convert_chunk_rows(jpeg_decoder_t const *jpg)
+{
+    size_t threads = (jpg->WorkPool != NULL) ? jpg->WorkPool->ThreadCount + 1 : 1;
+    return JPEG_CONVERT_BAND_ROWS * 2 * threads;
+}
+
+/// @summary Allocate and initialize the decoder state.
+/// @param pool The worker pool used to decode in parallel, or NULL.
+/// @return The decoder state, or NULL if memory allocation failed.
+internal_function jpeg_decoder_t* jpeg_decoder_create(work_pool_t *pool)
+{
+    jpeg_decoder_t *jpg = (jpeg_decoder_t*) malloc(sizeof(jpeg_decoder_t));
+    if (jpg == NULL) return NULL;
+    memset(jpg, 0, offsetof(jpeg_decoder_t, Segment));
+    jpg->WorkPool = pool;
+    jpg->UseAVX2  = jpeg_cpu_has_avx2();
+    jpg->Color    = JPEG_COLOR_GRAY;
+    return jpg;
+}
+
+/// @summary Free the decoder state and all of the buffers it owns.
+/// @param jpg The decoder state, or NULL.
+internal_function void jpeg_decoder_delete(jpeg_decoder_t *jpg)
+{
+    if (jpg == NULL) return;
+    for (size_t i = 0; i < JPEG_MAX_COMPONENTS; ++i)
+    {
+        free(jpg->Components[i].Coefficients);
+        free(jpg->Components[i].Plane);
+    }
+    free(jpg->Restarts);
+    free(jpg->ScanData);
+    free(jpg);
+}
+
+/// @summary Decode a complete JPEG file held in memory, up to the point where the rows can be converted. Used by the benchmark.
+/// @param jpg The decoder state.
+/// @param data The file data.
+/// @param size The size of the file data, in bytes.
+/// @return One of jpeg_parser_error_e.
+internal_function int jpeg_decode_memory(jpeg_decoder_t *jpg, uint8_t const *data, size_t size)
+{
+    size_t  pos    = 2;
+    uint8_t marker = 0;
+    int     error  = JPEG_PARSE_ERROR_SUCCESS;
+    if (size < 2 || data[0] != 0xFF || data[1] != JPEG_MARKER_SOI)
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    for ( ; ; )
+    {
+        if (marker == 0)
+        {   // find the next marker, skipping any fill bytes.
+            while (pos < size && data[pos] != 0xFF) pos++;
+            while (pos < size && data[pos] == 0xFF) pos++;
+            if (pos >= size) return JPEG_PARSE_ERROR_BAD_DATA;
+            marker = data[pos++];
+        }
+        if (marker == JPEG_MARKER_EOI)
+            break;
+        if (marker == JPEG_MARKER_TEM || (marker >= JPEG_MARKER_RST0 && marker <= JPEG_MARKER_RST7))
+        {   // markers without a segment.
+            marker = 0;
+            continue;
+        }
+        if (pos + 2 > size || jpeg_u16(data + pos) < 2 || pos + jpeg_u16(data + pos) > size)
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        uint8_t const *segment = data + pos + 2;
+        size_t         length  = jpeg_u16(data + pos) - 2;
+        pos += length + 2;
+        if (marker != JPEG_MARKER_SOS)
+        {
+            bool sof = !jpg->HaveFrame;
+            if ((error = jpeg_process_segment(jpg, marker, segment, length)) != JPEG_PARSE_ERROR_SUCCESS)
+                return error;
+            if (sof && jpg->HaveFrame && (error = jpeg_allocate_frame(jpg)) != JPEG_PARSE_ERROR_SUCCESS)
+                return error;
+            marker = 0;
+            continue;
+        }
+        if ((error = jpeg_process_sos(jpg, segment, length)) != JPEG_PARSE_ERROR_SUCCESS)
+            return error;
+        pos += jpeg_scan_append(jpg, data + pos, size - pos, &marker, &error);
+        if (error != JPEG_PARSE_ERROR_SUCCESS)
+            return error;
+        if (marker == 0)
+            return JPEG_PARSE_ERROR_BAD_DATA;
+        if ((error = jpeg_decode_scan(jpg)) != JPEG_PARSE_ERROR_SUCCESS)
+            return error;
+    }
+    if (jpg->ScanCount == 0)
+        return JPEG_PARSE_ERROR_BAD_DATA;
+    jpeg_transform_frame(jpg);
+    return JPEG_PARSE_ERROR_SUCCESS;
+}
+
+/// @summary Calculates all of the static data and allocates the frame buffers once the frame header has been received.
+/// @param jpegp The parser state to update.
+/// @return The new parser state.
+internal_function int jpeg_parser_setup_image_info(jpeg_parser_state_t *jpegp)
+{
+    jpeg_decoder_t     *jpg  = jpegp->JPEG;
+    image_definition_t *meta = jpegp->Metadata;
+    jpegp->Format = (jpg->Color == JPEG_COLOR_GRAY) ? DXGI_FORMAT_R8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+    if (jpegp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // completely initialize the metadata block with information we've read.
+        dds_header_t       dds;
+        dds_header_dxt10_t dx10;
+        dds_headers_for_image(&dds, &dx10, jpegp->Format, jpg->Width, jpg->Height, DDS_ALPHA_MODE_OPAQUE);
+        if (!dds_image_definition(meta, jpegp->Config.ImageId, &dds, &dx10, jpegp->Config.Compression, jpegp->Config.Encoding))
+        {   // unable to allocate storage for the mip-level descriptors and offsets.
+            jpegp->ParserError = JPEG_PARSE_ERROR_NOMEMORY;
+            return JPEG_PARSE_STATE_ERROR;
+        }
+    }
+
+    // create the image encoder instance.
+    jpegp->Encoder = create_image_encoder(
+        jpegp->Config.ImageId,
+        jpegp->Config.Memory,
+        IMAGE_COMPRESSION_NONE,
+        IMAGE_ENCODING_RAW,
+        jpegp->Config.Compression,
+        jpegp->Config.Encoding,
+        dds_access_type(meta),
+        jpegp->Config.DefinitionQueue,
+        jpegp->Config.DefinitionAlloc,
+        jpegp->Config.PlacementQueue,
+        jpegp->Config.PlacementAlloc,
+        meta->ImageFormat,
+        jpegp->Config.Format,
+        jpegp->Config.Quality,
+        jpegp->Config.WorkPool,
+        jpegp->Config.EncoderFlags);
+    if (jpegp->Encoder == NULL)
+    {   // unable to create the encoder to write to image memory.
+        jpegp->ParserError = JPEG_PARSE_ERROR_NOENCODER;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    if (jpegp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // notify the encoder of the image attributes:
+        if (jpegp->Encoder->define_image(meta) != ERROR_SUCCESS)
+        {
+            jpegp->ParserError = JPEG_PARSE_ERROR_ENCODER;
+            return JPEG_PARSE_STATE_ERROR;
+        }
+    }
+    else
+    {   // the image is already defined, but encoders that change the format need the source attributes.
+        jpegp->Encoder->Metadata = meta;
+    }
+
+    // a JPEG file stores a single image element.
+    if ((jpegp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_PIXELS) == 0 || jpegp->Config.FirstFrame >= meta->ElementCount)
+    {   // not reading any pixel data, so we're done.
+        return JPEG_PARSE_STATE_COMPLETE;
+    }
+    if ((jpegp->ParserError = jpeg_allocate_frame(jpg)) != JPEG_PARSE_ERROR_SUCCESS)
+    {
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    jpegp->Encoder->reset_element(0);
+    return JPEG_PARSE_STATE_MARKER;
+}
+
+/// @summary Transforms and converts the decoded image once the EOI marker has been received, and writes the rows to the image encoder.
+/// @param jpegp The parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The new parser state.
+internal_function int jpeg_parser_finish_image(jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{
+    jpeg_decoder_t *jpg = jpegp->JPEG;
+    if (!jpg->HaveFrame || jpg->ScanCount == 0 || encoder == NULL)
+    {   // the file ended before any image data.
+        jpegp->ParserError = JPEG_PARSE_ERROR_BAD_DATA;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    jpeg_transform_frame(jpg);
+
+    // convert a run of rows on the worker pool, then pass them to the encoder on this thread.
+    size_t   pixel_size = (jpg->Color == JPEG_COLOR_GRAY) ? 1 : 4;
+    size_t   pitch      =  jpg->Width * pixel_size;
+    size_t   chunk_rows =  jpeg_convert_chunk_rows(jpg);
+    size_t   bands      =  chunk_rows / JPEG_CONVERT_BAND_ROWS;
+    size_t   scratch_sz =  jpeg_convert_scratch_size(jpg);
+    uint8_t *rows       = (uint8_t*) malloc(chunk_rows * pitch);
+    uint8_t *scratch    = (uint8_t*) malloc(bands * scratch_sz);
+    if (rows == NULL || scratch == NULL)
+    {
+        free(scratch); free(rows);
+        jpegp->ParserError = JPEG_PARSE_ERROR_NOMEMORY;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    for (size_t y = 0; y < jpg->Height; y += chunk_rows)
+    {
+        size_t count = image_min2<size_t>(chunk_rows, jpg->Height - y);
+        jpeg_convert_rows(jpg, y, count, rows, pitch, scratch);
+        if (encoder->encode(0, rows, count * pitch) != ERROR_SUCCESS)
+        {
+            free(scratch); free(rows);
+            jpegp->ParserError = JPEG_PARSE_ERROR_ENCODER;
+            return JPEG_PARSE_STATE_ERROR;
+        }
+    }
+    free(scratch); free(rows);
+    encoder->mark_level(0);
+    encoder->mark_element(0);
+    return JPEG_PARSE_STATE_COMPLETE;
+}
+
+/// @summary Determines the parser state that follows a marker.
+/// @param jpegp The parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @param marker The marker code.
+/// @return The new parser state.
+internal_function int jpeg_parser_marker(jpeg_parser_state_t *jpegp, image_encoder_t *encoder, uint8_t marker)
+{
+    jpegp->Marker = marker;
+    if (marker == JPEG_MARKER_EOI)
+    {
+        return jpeg_parser_finish_image(jpegp, encoder);
+    }
+    if (marker == JPEG_MARKER_SOI)
+    {   // a second start of image.
+        jpegp->ParserError = JPEG_PARSE_ERROR_BAD_DATA;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    if (marker == JPEG_MARKER_TEM || (marker >= JPEG_MARKER_RST0 && marker <= JPEG_MARKER_RST7))
+    {   // markers without a segment.
+        return JPEG_PARSE_STATE_MARKER;
+    }
+    jpegp->HeaderWritePos = 0;
+    return JPEG_PARSE_STATE_SEGMENT_LENGTH;
+}
+
+/// @summary Implements the parser logic for the JPEG_PARSE_STATE_SEEK_OFFSET.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param jpegp The JPEG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int jpeg_seek_offset(stream_decoder_t *decoder, jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    stream_decode_pos_t &target  = jpegp->Config.StartOffset;
+    stream_decode_pos_t  current;  decoder->pos(current);
+    if (current.FileOffset      >= target.FileOffset &&
+        current.FileOffset      <= target.FileOffset)
+    {   // this encoded data chunk contains the start of the data we're looking for.
+        size_t available         = decoder->amount();
+        size_t consume           =(target.DecodeOffset >= available) ? available : target.DecodeOffset;
+        decoder->ReadCursor     += consume; // consume from available decoded input
+        target.DecodeOffset     -= consume; // decrement bytes remaining to consume
+        if (decoder->ReadCursor != decoder->FinalByte)
+        {   // the image data can only be decoded from the start of the file.
+            return JPEG_PARSE_STATE_BUFFER_SOI;
+        }
+        // else, refill the decoded data buffer and remain in the same state.
+    }
+    return JPEG_PARSE_STATE_SEEK_OFFSET;
+}
+
+/// @summary Implements the parser logic for the JPEG_PARSE_STATE_BUFFER_SOI.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param jpegp The JPEG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int jpeg_buffer_soi(stream_decoder_t *decoder, jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = 2 - jpegp->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&jpegp->HeaderBuffer[jpegp->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    jpegp->HeaderWritePos   += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (jpegp->HeaderWritePos < 2)
+    {   // this is a partial read; wait for more data.
+        return JPEG_PARSE_STATE_BUFFER_SOI;
+    }
+    if (jpegp->HeaderBuffer[0] != 0xFF || jpegp->HeaderBuffer[1] != JPEG_MARKER_SOI)
+    {   // this isn't a JPEG file.
+        jpegp->ParserError = JPEG_PARSE_ERROR_BAD_DATA;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    if ((jpegp->JPEG = jpeg_decoder_create(jpegp->Config.WorkPool)) == NULL)
+    {
+        jpegp->ParserError = JPEG_PARSE_ERROR_NOMEMORY;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    jpegp->SeenFF = false;
+    return JPEG_PARSE_STATE_MARKER;
+}
+
+/// @summary Implements the parser logic for the JPEG_PARSE_STATE_MARKER.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param jpegp The JPEG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int jpeg_find_marker(stream_decoder_t *decoder, jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{
+    while (decoder->ReadCursor != decoder->FinalByte)
+    {
+        uint8_t byte = *decoder->ReadCursor++;
+        if (byte == 0xFF)
+        {   // the marker prefix, or a fill byte.
+            jpegp->SeenFF = true;
+            continue;
+        }
+        if (jpegp->SeenFF)
+        {
+            jpegp->SeenFF = false;
+            if (byte != 0x00)
+                return jpeg_parser_marker(jpegp, encoder, byte);
+        }
+        // else, skip bytes between segments.
+    }
+    return JPEG_PARSE_STATE_MARKER;
+}
+
+/// @summary Implements the parser logic for the JPEG_PARSE_STATE_SEGMENT_LENGTH.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param jpegp The JPEG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int jpeg_segment_length(stream_decoder_t *decoder, jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = 2 - jpegp->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&jpegp->HeaderBuffer[jpegp->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    jpegp->HeaderWritePos   += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (jpegp->HeaderWritePos < 2)
+    {   // this is a partial read; wait for more data.
+        return JPEG_PARSE_STATE_SEGMENT_LENGTH;
+    }
+    size_t length = jpeg_u16(jpegp->HeaderBuffer);
+    if (length < 2)
+    {   // the length includes the length field itself.
+        jpegp->ParserError = JPEG_PARSE_ERROR_BAD_DATA;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    jpegp->SegmentSize    = length - 2;
+    jpegp->SegmentRemain  = length - 2;
+    jpegp->HeaderWritePos = 0;
+    return jpeg_segment_needed(jpegp->Marker) ? JPEG_PARSE_STATE_BUFFER_SEGMENT : JPEG_PARSE_STATE_SKIP_SEGMENT;
+}
+
+/// @summary Implements the parser logic for the JPEG_PARSE_STATE_BUFFER_SEGMENT.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param jpegp The JPEG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int jpeg_buffer_segment(stream_decoder_t *decoder, jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    jpeg_decoder_t *jpg      = jpegp->JPEG;
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     =(jpegp->SegmentRemain < bytes_available) ? jpegp->SegmentRemain : bytes_available;
+    memcpy(&jpg->Segment[jpegp->SegmentSize - jpegp->SegmentRemain], decoder->ReadCursor, bytes_to_copy);
+    jpegp->SegmentRemain    -= bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (jpegp->SegmentRemain > 0)
+    {   // this is a partial read; wait for more data.
+        return JPEG_PARSE_STATE_BUFFER_SEGMENT;
+    }
+    if (jpegp->Marker == JPEG_MARKER_SOS)
+    {
+        if (jpegp->Encoder == NULL)
+        {   // the scan can't be decoded without a frame.
+            jpegp->ParserError = JPEG_PARSE_ERROR_BAD_DATA;
+            return JPEG_PARSE_STATE_ERROR;
+        }
+        if ((jpegp->ParserError = jpeg_process_sos(jpg, jpg->Segment, jpegp->SegmentSize)) != JPEG_PARSE_ERROR_SUCCESS)
+            return JPEG_PARSE_STATE_ERROR;
+        return JPEG_PARSE_STATE_SCAN_DATA;
+    }
+    bool sof = !jpg->HaveFrame;
+    if ((jpegp->ParserError = jpeg_process_segment(jpg, jpegp->Marker, jpg->Segment, jpegp->SegmentSize)) != JPEG_PARSE_ERROR_SUCCESS)
+    {
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    if (sof && jpg->HaveFrame)
+    {   // the frame header defines the image.
+        return jpeg_parser_setup_image_info(jpegp);
+    }
+    return JPEG_PARSE_STATE_MARKER;
+}
+
+/// @summary Implements the parser logic for the JPEG_PARSE_STATE_SKIP_SEGMENT.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param jpegp The JPEG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int jpeg_skip_segment(stream_decoder_t *decoder, jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_skip     =(jpegp->SegmentRemain < bytes_available) ? jpegp->SegmentRemain : bytes_available;
+    decoder->ReadCursor     += bytes_to_skip;
+    jpegp->SegmentRemain    -= bytes_to_skip;
+    return (jpegp->SegmentRemain == 0) ? JPEG_PARSE_STATE_MARKER : JPEG_PARSE_STATE_SKIP_SEGMENT;
+}
+
+/// @summary Implements the parser logic for the JPEG_PARSE_STATE_SCAN_DATA.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param jpegp The JPEG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int jpeg_scan_data(stream_decoder_t *decoder, jpeg_parser_state_t *jpegp, image_encoder_t *encoder)
+{
+    uint8_t marker = 0;
+    int     error  = JPEG_PARSE_ERROR_SUCCESS;
+    decoder->ReadCursor += jpeg_scan_append(jpegp->JPEG, decoder->ReadCursor, decoder->amount(), &marker, &error);
+    if (error != JPEG_PARSE_ERROR_SUCCESS)
+    {
+        jpegp->ParserError = error;
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    if (marker == 0)
+    {   // the scan continues in the next chunk.
+        return JPEG_PARSE_STATE_SCAN_DATA;
+    }
+    if ((jpegp->ParserError = jpeg_decode_scan(jpegp->JPEG)) != JPEG_PARSE_ERROR_SUCCESS)
+    {
+        return JPEG_PARSE_STATE_ERROR;
+    }
+    return jpeg_parser_marker(jpegp, encoder, marker);
+}
+
+/// @summary Implements the primary update tick for a streaming JPEG parser.
+/// @param jpegp The JPEG parser state to update.
+/// @return One of jpeg_parser_result_e.
+internal_function int jpeg_parser_update(jpeg_parser_state_t *jpegp)
+{
+    stream_decoder_t *decoder    = jpegp->Config.Decoder;
+    while (jpegp->CurrentState  != JPEG_PARSE_STATE_COMPLETE)
+    {
+        if (jpegp->CurrentState == JPEG_PARSE_STATE_ERROR)
+        {   // return from the error state immediately.
+            return JPEG_PARSE_RESULT_ERROR;
+        }
+        if (decoder->ReadCursor == decoder->FinalByte && !decoder->atend())
+        {   // attempt to obtain additional input data.
+            switch (decoder->refill(decoder))
+            {
+            case STREAM_REFILL_RESULT_START:
+                break;
+            case STREAM_REFILL_RESULT_YIELD:
+                return JPEG_PARSE_RESULT_CONTINUE;
+            case STREAM_REFILL_RESULT_ERROR:
+                jpegp->CurrentState = JPEG_PARSE_STATE_ERROR;
+                jpegp->ParserError  = JPEG_PARSE_ERROR_DECODER;
+                return JPEG_PARSE_RESULT_ERROR;
+            }
+        }
+        // perform a state update, which may consume zero or more bytes.
+        uint8_t *cursor = decoder->ReadCursor;
+        int      s      = jpegp->CurrentState;
+        switch (jpegp->CurrentState)
+        {
+        case JPEG_PARSE_STATE_SEEK_OFFSET:
+            s = jpeg_seek_offset(decoder, jpegp, jpegp->Encoder);
+            break;
+        case JPEG_PARSE_STATE_BUFFER_SOI:
+            s = jpeg_buffer_soi(decoder, jpegp, jpegp->Encoder);
+            break;
+        case JPEG_PARSE_STATE_MARKER:
+            s = jpeg_find_marker(decoder, jpegp, jpegp->Encoder);
+            break;
+        case JPEG_PARSE_STATE_SEGMENT_LENGTH:
+            s = jpeg_segment_length(decoder, jpegp, jpegp->Encoder);
+            break;
+        case JPEG_PARSE_STATE_BUFFER_SEGMENT:
+            s = jpeg_buffer_segment(decoder, jpegp, jpegp->Encoder);
+            break;
+        case JPEG_PARSE_STATE_SKIP_SEGMENT:
+            s = jpeg_skip_segment(decoder, jpegp, jpegp->Encoder);
+            break;
+        case JPEG_PARSE_STATE_SCAN_DATA:
+            s = jpeg_scan_data(decoder, jpegp, jpegp->Encoder);
+            break;
+        default:
+            break;
+        }
+        if (s == jpegp->CurrentState && cursor == decoder->ReadCursor && decoder->atend())
+        {   // the state needs more data, but the stream has ended.
+            s = JPEG_PARSE_STATE_ERROR;
+            jpegp->ParserError = JPEG_PARSE_ERROR_BAD_DATA;
+        }
+        jpegp->CurrentState = s;
+    }
+    return JPEG_PARSE_RESULT_COMPLETE;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initializes or resets the state of a streaming JPEG parser.
+/// @param jpegp The streaming JPEG parser state to initialize.
+/// @param config Parser configuration data indicating what portions of the file to parse.
+public_function void jpeg_parser_state_init(jpeg_parser_state_t *jpegp, image_parser_config_t const &config)
+{
+    jpegp->CurrentState   = JPEG_PARSE_STATE_SEEK_OFFSET;
+    jpegp->ParserError    = JPEG_PARSE_ERROR_SUCCESS;
+    jpegp->Config         = config;
+    jpegp->Encoder        = NULL;
+    jpegp->Metadata       = config.Metadata;
+    jpegp->JPEG           = NULL;
+    jpegp->Format         = DXGI_FORMAT_UNKNOWN;
+    jpegp->Marker         = 0;
+    jpegp->SeenFF         = false;
+    jpegp->SegmentSize    = 0;
+    jpegp->SegmentRemain  = 0;
+    jpegp->HeaderWritePos = 0;
+}
+
+/// @summary Frees any locally-allocated resources for a parser instance.
+/// @param jpegp The streaming JPEG parser state to clean up.
+public_function void jpeg_parser_state_cleanup(jpeg_parser_state_t *jpegp)
+{
+    jpeg_decoder_delete(jpegp->JPEG);
+    jpegp->JPEG = NULL;
+    if (jpegp->Encoder != NULL)
+    {
+        delete  jpegp->Encoder;
+        jpegp->Encoder  = NULL;
+    }
+}
+
+/// @summary Measure the throughput of the JPEG decoder on a file held in memory, including the IDCT and color conversion but not the image encoder.
+/// @param data The contents of a JPEG file.
+/// @param size The size of the file, in bytes.
+/// @param pool The worker pool used to decode in parallel, or NULL to decode on the calling thread.
+/// @param iterations The number of times to decode the file.
+/// @return The decoder throughput, in millions of output pixels per-second, or zero if the file can't be decoded or memory allocation fails.
+public_function double jpeg_decoder_benchmark(void const *data, size_t size, work_pool_t *pool, size_t iterations)
+{
+    LARGE_INTEGER frequency, start, end;
+    double        pixels = 0.0;
+    double        rate   = 0.0;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        jpeg_decoder_t *jpg = jpeg_decoder_create(pool);
+        if (jpg == NULL || jpeg_decode_memory(jpg, (uint8_t const*) data, size) != JPEG_PARSE_ERROR_SUCCESS)
+        {   // the file can't be decoded.
+            jpeg_decoder_delete(jpg);
+            return 0.0;
+        }
+        size_t   pitch      = jpg->Width * ((jpg->Color == JPEG_COLOR_GRAY) ? 1 : 4);
+        size_t   chunk_rows = jpeg_convert_chunk_rows(jpg);
+        size_t   scratch_sz = jpeg_convert_scratch_size(jpg) * (chunk_rows / JPEG_CONVERT_BAND_ROWS);
+        uint8_t *rows       = (uint8_t*) malloc(chunk_rows * pitch);
+        uint8_t *scratch    = (uint8_t*) malloc(scratch_sz);
+        if (rows == NULL || scratch == NULL)
+        {
+            free(scratch); free(rows);
+            jpeg_decoder_delete(jpg);
+            return 0.0;
+        }
+        for (size_t y = 0; y < jpg->Height; y += chunk_rows)
+        {
+            jpeg_convert_rows(jpg, y, image_min2<size_t>(chunk_rows, jpg->Height - y), rows, pitch, scratch);
+        }
+        pixels += double(jpg->Width) * double(jpg->Height);
+        free(scratch); free(rows);
+        jpeg_decoder_delete(jpg);
+    }
+    QueryPerformanceCounter(&end);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(frequency.QuadPart);
+    if (seconds > 0.0)
+    {
+        rate = pixels / (seconds * 1000000.0);
+    }
+    return rate;
+}
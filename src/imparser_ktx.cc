@@ -0,0 +1,1239 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a streaming parser for KTX and KTX2 files. The headers
+/// and the KTX2 level index are buffered; level data is consumed in file
+/// order, which for KTX2 is usually the smallest level first. KTX2 levels
+/// that are supercompressed with Zstandard are buffered and decompressed in
+/// one pass, and ZLIB levels are inflated as they arrive. The image encoder
+/// expects each element's levels in order, so subresources that arrive ahead
+/// of the encoder are staged until it catches up. Only formats that have a
+/// DXGI equivalent are supported; ASTC, ETC and Basis Universal are not.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The size of the file identifier at the start of KTX and KTX2 files, in bytes.
+#define KTX_IDENTIFIER_SIZE       12
+
+/// @summary The size of the KTX header, including the identifier, in bytes.
+#define KTX1_HEADER_SIZE          64
+
+/// @summary The size of the KTX2 header, including the identifier, in bytes.
+#define KTX2_HEADER_SIZE          80
+
+/// @summary The size of a single entry in the KTX2 level index, in bytes.
+#define KTX2_LEVEL_ENTRY_SIZE     24
+
+/// @summary The number of bytes of the KTX2 data format descriptor read by the parser: the total size, the basic descriptor block header and the color model fields, through the flags.
+#define KTX2_DFD_PREFIX_SIZE      16
+
+/// @summary The maximum number of levels in a mipmap chain.
+#define KTX_MAX_LEVELS            32
+
+/// @summary The maximum width, height or depth of the first level, in pixels.
+#define KTX_MAX_DIMENSION         65536
+
+/// @summary The maximum number of array layers.
+#define KTX_MAX_LAYERS            2048
+
+/// @summary The value of the KTX endianness field when the file was written on a little-endian machine.
+#define KTX1_ENDIAN_REF           0x04030201U
+
+/// @summary The flag in the basic data format descriptor indicating that color values are premultiplied by alpha.
+#define KTX2_DF_FLAG_PREMULTIPLIED 0x01U
+
+/// @summary The OpenGL pixel format values checked by the KTX format mapping.
+#define KTX_GL_BGRA               0x80E1U
+#define KTX_GL_UNSIGNED_SHORT_565 0x8363U
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define identifiers for the recognized parser states.
+enum ktx_parser_state_e : int
+{
+    KTX_PARSE_STATE_SEEK_OFFSET          = 0,   /// The parser is looking for a known byte offset.
+    KTX_PARSE_STATE_BUFFER_IDENTIFIER    = 1,   /// The parser is receiving the file identifier.
+    KTX_PARSE_STATE_BUFFER_HEADER        = 2,   /// The parser is receiving the remainder of the KTX or KTX2 header.
+    KTX_PARSE_STATE_BUFFER_LEVEL_INDEX   = 3,   /// The parser is receiving the KTX2 level index.
+    KTX_PARSE_STATE_BUFFER_DFD           = 4,   /// The parser is receiving the start of the KTX2 data format descriptor.
+    KTX_PARSE_STATE_SKIP_DATA            = 5,   /// The parser is skipping to a known file offset.
+    KTX_PARSE_STATE_LEVEL_SIZE           = 6,   /// The parser is receiving the size field in front of a KTX level.
+    KTX_PARSE_STATE_LEVEL_DATA           = 7,   /// The parser is receiving the data of a level.
+    KTX_PARSE_STATE_COMPLETE             = 8,   /// The parser has received all of the requested data.
+    KTX_PARSE_STATE_ERROR                = 9    /// The parser has encountered a fatal error.
+};
+
+/// @summary Define identifiers for the recognized parser errors.
+enum ktx_parser_error_e : int
+{
+    KTX_PARSE_ERROR_SUCCESS              = 0,   /// No error has occurred.
+    KTX_PARSE_ERROR_NOMEMORY             = 1,   /// Required memory could not be allocated.
+    KTX_PARSE_ERROR_DECODER              = 2,   /// The underlying stream decoder returned an error.
+    KTX_PARSE_ERROR_NOENCODER            = 3,   /// No encoder was found that supports the required transcoding.
+    KTX_PARSE_ERROR_ENCODER              = 4,   /// The image encoder returned an error.
+    KTX_PARSE_ERROR_BAD_DATA             = 5,   /// The file is not a valid KTX or KTX2 file, or is truncated.
+    KTX_PARSE_ERROR_UNSUPPORTED          = 6,   /// The file uses a format or feature the parser doesn't support.
+};
+
+/// @summary Define the possible return codes from the top-level streaming parser update function.
+enum ktx_parser_result_e : int
+{
+    KTX_PARSE_RESULT_CONTINUE            = 0,   /// The parser is yielding, waiting for more data.
+    KTX_PARSE_RESULT_COMPLETE            = 1,   /// Stop parsing. All data was parsed successfully.
+    KTX_PARSE_RESULT_ERROR               = 2    /// Stop parsing. An error was encountered.
+};
+
+/// @summary Define the KTX2 supercompression schemes.
+enum ktx_supercompression_e : uint32_t
+{
+    KTX_SUPERCOMPRESSION_NONE            = 0,   /// Level data is stored as-is.
+    KTX_SUPERCOMPRESSION_BASISLZ         = 1,   /// Level data is Basis Universal ETC1S. Not supported.
+    KTX_SUPERCOMPRESSION_ZSTD            = 2,   /// Each level is a Zstandard frame.
+    KTX_SUPERCOMPRESSION_ZLIB            = 3,   /// Each level is a zlib stream.
+};
+
+/// @summary Maps a Vulkan format or an OpenGL internal format to the equivalent DXGI format.
+struct ktx_format_map_t
+{
+    uint32_t              Source;               /// The VkFormat or OpenGL internal format value.
+    uint32_t              Format;               /// One of dxgi_format_e.
+};
+
+/// @summary Describes the location of a single level within a KTX2 file, as read from the level index.
+struct ktx_level_t
+{
+    uint64_t              ByteOffset;           /// The offset of the level data from the start of the file.
+    uint64_t              ByteLength;           /// The size of the level data in the file, in bytes.
+    uint64_t              UncompressedLength;   /// The size of the level data once any supercompression is removed, in bytes.
+};
+
+/// @summary Define the state data associated with a streaming KTX or KTX2 file parser.
+struct ktx_parser_state_t
+{
+    #define BUF_INDEX     (KTX_MAX_LEVELS * KTX2_LEVEL_ENTRY_SIZE)
+    int                   CurrentState;         /// One of ktx_parser_state_e.
+    int                   ParserError;          /// One of ktx_parser_error_e.
+    image_parser_config_t Config;               /// The input parser configuration.
+    image_encoder_t      *Encoder;              /// The local image encoder. Deleted on error or completion.
+    image_definition_t   *Metadata;             /// Pointer to the image metadata block.
+    zstd_decoder_t        Zstd;                 /// The decoder for Zstandard-supercompressed levels.
+    inflate_t             Inflate;              /// The decoder for the zlib stream of the current ZLIB-supercompressed level.
+    bool                  ZstdReady;            /// true if the Zstd buffers have been allocated.
+    bool                  InflateReady;         /// true if the Inflate buffers have been allocated.
+    int                   Version;              /// 1 for a KTX file, or 2 for a KTX2 file.
+    uint32_t              Format;               /// One of dxgi_format_e specifying the format of the level data.
+    uint32_t              AlphaMode;            /// One of dds_alpha_mode_e.
+    uint32_t              Supercompression;     /// One of ktx_supercompression_e.
+    size_t                Width;                /// The width of the first level, in pixels.
+    size_t                Height;               /// The height of the first level, in pixels.
+    size_t                Depth;                /// The number of slices in the first level.
+    size_t                LayerCount;           /// The number of array layers, at least 1.
+    size_t                FaceCount;            /// The number of cubemap faces, 1 or 6.
+    size_t                LevelCount;           /// The number of levels in the mipmap chain.
+    size_t                ElementCount;         /// The number of image elements, LayerCount * FaceCount.
+    size_t                KeyValueSize;         /// The size of the KTX key/value data, in bytes.
+    bool                  FaceImageSize;        /// For KTX, true if each level's size field covers a single cubemap face.
+    uint64_t              DFDOffset;            /// The file offset of the KTX2 data format descriptor.
+    uint64_t              DFDSize;              /// The size of the KTX2 data format descriptor, in bytes.
+    uint64_t              FilePos;              /// The number of bytes consumed from the start of the file.
+    uint64_t              SkipRemain;           /// The number of bytes remaining to be skipped in KTX_PARSE_STATE_SKIP_DATA.
+    int                   SkipState;            /// The state entered when SkipRemain reaches zero.
+    size_t                HeaderWritePos;       /// The current write position in HeaderBuffer or IndexBuffer.
+    size_t                ElementFirst;         /// The zero-based index of the first element to encode.
+    size_t                ElementFinal;         /// One past the zero-based index of the last element to encode.
+    size_t                ElementIndex;         /// The zero-based index of the element the encoder is writing.
+    size_t                LevelIndex;           /// The zero-based index of the level the encoder is writing.
+    dds_level_desc_t     *LevelInfo;            /// Mipmap level descriptors. Owned by the image blob.
+    size_t                ReceiveRank;          /// The position in LevelOrder of the level being received.
+    size_t                ReceiveLevel;         /// The zero-based index of the level being received.
+    size_t                ReceiveElement;       /// The zero-based index of the element being received within the level.
+    size_t                ReceiveOffset;        /// The number of bytes of the element received.
+    uint64_t              LevelRemain;          /// The number of bytes of the current level's file data remaining to be consumed.
+    size_t                LevelFill;            /// The number of bytes of compressed level data in LevelBuffer.
+    size_t                LevelBufferSize;      /// The capacity of LevelBuffer, in bytes.
+    size_t                LevelOutputSize;      /// The capacity of LevelOutput, in bytes.
+    uint8_t              *LevelBuffer;          /// Staging for a Zstandard-compressed level that arrives in pieces.
+    uint8_t              *LevelOutput;          /// The decompressed data of a Zstandard-compressed level.
+    size_t                RowSize;              /// For KTX, the size of a row of the current level, in bytes.
+    size_t                RowPitch;             /// For KTX, the distance between rows of the current level in the file, RowSize rounded up to four bytes.
+    uint64_t              RowPos;               /// For KTX, the number of padded bytes of the current level consumed.
+    uint8_t               LevelOrder[KTX_MAX_LEVELS]; /// The level indices, in the order that the levels appear in the file.
+    uint8_t               LevelRank [KTX_MAX_LEVELS]; /// The position of each level in LevelOrder.
+    ktx_level_t           Levels    [KTX_MAX_LEVELS]; /// The KTX2 level index.
+    uint8_t              *Stage     [KTX_MAX_LEVELS]; /// For each level, the elements received before the encoder reached them, or NULL.
+    uint8_t               HeaderBuffer[KTX2_HEADER_SIZE]; /// Internal buffer for the identifier, header and DFD prefix.
+    uint8_t               IndexBuffer [BUF_INDEX];        /// Internal buffer for the KTX2 level index.
+    #undef  BUF_INDEX
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The identifier at the start of every KTX file.
+global_variable uint8_t const KTX1_IDENTIFIER[KTX_IDENTIFIER_SIZE] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+/// @summary The identifier at the start of every KTX2 file.
+global_variable uint8_t const KTX2_IDENTIFIER[KTX_IDENTIFIER_SIZE] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+/// @summary The VkFormat values that have a DXGI equivalent.
+global_variable ktx_format_map_t const KTX2_FORMATS[] =
+{
+    {   4, DXGI_FORMAT_B5G6R5_UNORM        }, // VK_FORMAT_R5G6B5_UNORM_PACK16
+    {   8, DXGI_FORMAT_B5G5R5A1_UNORM      }, // VK_FORMAT_A1R5G5B5_UNORM_PACK16
+    {   9, DXGI_FORMAT_R8_UNORM            }, // VK_FORMAT_R8_UNORM
+    {  10, DXGI_FORMAT_R8_SNORM            }, // VK_FORMAT_R8_SNORM
+    {  13, DXGI_FORMAT_R8_UINT             }, // VK_FORMAT_R8_UINT
+    {  14, DXGI_FORMAT_R8_SINT             }, // VK_FORMAT_R8_SINT
+    {  16, DXGI_FORMAT_R8G8_UNORM          }, // VK_FORMAT_R8G8_UNORM
+    {  17, DXGI_FORMAT_R8G8_SNORM          }, // VK_FORMAT_R8G8_SNORM
+    {  20, DXGI_FORMAT_R8G8_UINT           }, // VK_FORMAT_R8G8_UINT
+    {  21, DXGI_FORMAT_R8G8_SINT           }, // VK_FORMAT_R8G8_SINT
+    {  37, DXGI_FORMAT_R8G8B8A8_UNORM      }, // VK_FORMAT_R8G8B8A8_UNORM
+    {  38, DXGI_FORMAT_R8G8B8A8_SNORM      }, // VK_FORMAT_R8G8B8A8_SNORM
+    {  41, DXGI_FORMAT_R8G8B8A8_UINT       }, // VK_FORMAT_R8G8B8A8_UINT
+    {  42, DXGI_FORMAT_R8G8B8A8_SINT       }, // VK_FORMAT_R8G8B8A8_SINT
+    {  43, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB }, // VK_FORMAT_R8G8B8A8_SRGB
+    {  44, DXGI_FORMAT_B8G8R8A8_UNORM      }, // VK_FORMAT_B8G8R8A8_UNORM
+    {  50, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB }, // VK_FORMAT_B8G8R8A8_SRGB
+    {  64, DXGI_FORMAT_R10G10B10A2_UNORM   }, // VK_FORMAT_A2B10G10R10_UNORM_PACK32
+    {  68, DXGI_FORMAT_R10G10B10A2_UINT    }, // VK_FORMAT_A2B10G10R10_UINT_PACK32
+    {  70, DXGI_FORMAT_R16_UNORM           }, // VK_FORMAT_R16_UNORM
+    {  71, DXGI_FORMAT_R16_SNORM           }, // VK_FORMAT_R16_SNORM
+    {  74, DXGI_FORMAT_R16_UINT            }, // VK_FORMAT_R16_UINT
+    {  75, DXGI_FORMAT_R16_SINT            }, // VK_FORMAT_R16_SINT
+    {  76, DXGI_FORMAT_R16_FLOAT           }, // VK_FORMAT_R16_SFLOAT
+    {  77, DXGI_FORMAT_R16G16_UNORM        }, // VK_FORMAT_R16G16_UNORM
+    {  78, DXGI_FORMAT_R16G16_SNORM        }, // VK_FORMAT_R16G16_SNORM
+    {  81, DXGI_FORMAT_R16G16_UINT         }, // VK_FORMAT_R16G16_UINT
+    {  82, DXGI_FORMAT_R16G16_SINT         }, // VK_FORMAT_R16G16_SINT
+    {  83, DXGI_FORMAT_R16G16_FLOAT        }, // VK_FORMAT_R16G16_SFLOAT
+    {  91, DXGI_FORMAT_R16G16B16A16_UNORM  }, // VK_FORMAT_R16G16B16A16_UNORM
+    {  92, DXGI_FORMAT_R16G16B16A16_SNORM  }, // VK_FORMAT_R16G16B16A16_SNORM
+    {  95, DXGI_FORMAT_R16G16B16A16_UINT   }, // VK_FORMAT_R16G16B16A16_UINT
+    {  96, DXGI_FORMAT_R16G16B16A16_SINT   }, // VK_FORMAT_R16G16B16A16_SINT
+    {  97, DXGI_FORMAT_R16G16B16A16_FLOAT  }, // VK_FORMAT_R16G16B16A16_SFLOAT
+    {  98, DXGI_FORMAT_R32_UINT            }, // VK_FORMAT_R32_UINT
+    {  99, DXGI_FORMAT_R32_SINT            }, // VK_FORMAT_R32_SINT
+    { 100, DXGI_FORMAT_R32_FLOAT           }, // VK_FORMAT_R32_SFLOAT
+    { 101, DXGI_FORMAT_R32G32_UINT         }, // VK_FORMAT_R32G32_UINT
+    { 102, DXGI_FORMAT_R32G32_SINT         }, // VK_FORMAT_R32G32_SINT
+    { 103, DXGI_FORMAT_R32G32_FLOAT        }, // VK_FORMAT_R32G32_SFLOAT
+    { 104, DXGI_FORMAT_R32G32B32_UINT      }, // VK_FORMAT_R32G32B32_UINT
+    { 105, DXGI_FORMAT_R32G32B32_SINT      }, // VK_FORMAT_R32G32B32_SINT
+    { 106, DXGI_FORMAT_R32G32B32_FLOAT     }, // VK_FORMAT_R32G32B32_SFLOAT
+    { 107, DXGI_FORMAT_R32G32B32A32_UINT   }, // VK_FORMAT_R32G32B32A32_UINT
+    { 108, DXGI_FORMAT_R32G32B32A32_SINT   }, // VK_FORMAT_R32G32B32A32_SINT
+    { 109, DXGI_FORMAT_R32G32B32A32_FLOAT  }, // VK_FORMAT_R32G32B32A32_SFLOAT
+    { 122, DXGI_FORMAT_R11G11B10_FLOAT     }, // VK_FORMAT_B10G11R11_UFLOAT_PACK32
+    { 123, DXGI_FORMAT_R9G9B9E5_SHAREDEXP  }, // VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+    { 124, DXGI_FORMAT_D16_UNORM           }, // VK_FORMAT_D16_UNORM
+    { 126, DXGI_FORMAT_D32_FLOAT           }, // VK_FORMAT_D32_SFLOAT
+    { 131, DXGI_FORMAT_BC1_UNORM           }, // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+    { 132, DXGI_FORMAT_BC1_UNORM_SRGB      }, // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+    { 133, DXGI_FORMAT_BC1_UNORM           }, // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+    { 134, DXGI_FORMAT_BC1_UNORM_SRGB      }, // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+    { 135, DXGI_FORMAT_BC2_UNORM           }, // VK_FORMAT_BC2_UNORM_BLOCK
+    { 136, DXGI_FORMAT_BC2_UNORM_SRGB      }, // VK_FORMAT_BC2_SRGB_BLOCK
+    { 137, DXGI_FORMAT_BC3_UNORM           }, // VK_FORMAT_BC3_UNORM_BLOCK
+    { 138, DXGI_FORMAT_BC3_UNORM_SRGB      }, // VK_FORMAT_BC3_SRGB_BLOCK
+    { 139, DXGI_FORMAT_BC4_UNORM           }, // VK_FORMAT_BC4_UNORM_BLOCK
+    { 140, DXGI_FORMAT_BC4_SNORM           }, // VK_FORMAT_BC4_SNORM_BLOCK
+    { 141, DXGI_FORMAT_BC5_UNORM           }, // VK_FORMAT_BC5_UNORM_BLOCK
+    { 142, DXGI_FORMAT_BC5_SNORM           }, // VK_FORMAT_BC5_SNORM_BLOCK
+    { 143, DXGI_FORMAT_BC6H_UF16           }, // VK_FORMAT_BC6H_UFLOAT_BLOCK
+    { 144, DXGI_FORMAT_BC6H_SF16           }, // VK_FORMAT_BC6H_SFLOAT_BLOCK
+    { 145, DXGI_FORMAT_BC7_UNORM           }, // VK_FORMAT_BC7_UNORM_BLOCK
+    { 146, DXGI_FORMAT_BC7_UNORM_SRGB      }, // VK_FORMAT_BC7_SRGB_BLOCK
+};
+
+/// @summary The OpenGL sized internal formats that have a DXGI equivalent.
+global_variable ktx_format_map_t const KTX1_FORMATS[] =
+{
+    { 0x8229, DXGI_FORMAT_R8_UNORM            }, // GL_R8
+    { 0x8F94, DXGI_FORMAT_R8_SNORM            }, // GL_R8_SNORM
+    { 0x8232, DXGI_FORMAT_R8_UINT             }, // GL_R8UI
+    { 0x8231, DXGI_FORMAT_R8_SINT             }, // GL_R8I
+    { 0x822B, DXGI_FORMAT_R8G8_UNORM          }, // GL_RG8
+    { 0x8F95, DXGI_FORMAT_R8G8_SNORM          }, // GL_RG8_SNORM
+    { 0x8238, DXGI_FORMAT_R8G8_UINT           }, // GL_RG8UI
+    { 0x8237, DXGI_FORMAT_R8G8_SINT           }, // GL_RG8I
+    { 0x8058, DXGI_FORMAT_R8G8B8A8_UNORM      }, // GL_RGBA8
+    { 0x8C43, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB }, // GL_SRGB8_ALPHA8
+    { 0x8F97, DXGI_FORMAT_R8G8B8A8_SNORM      }, // GL_RGBA8_SNORM
+    { 0x8D7C, DXGI_FORMAT_R8G8B8A8_UINT       }, // GL_RGBA8UI
+    { 0x8D8E, DXGI_FORMAT_R8G8B8A8_SINT       }, // GL_RGBA8I
+    { 0x93A1, DXGI_FORMAT_B8G8R8A8_UNORM      }, // GL_BGRA8_EXT
+    { 0x8059, DXGI_FORMAT_R10G10B10A2_UNORM   }, // GL_RGB10_A2
+    { 0x906F, DXGI_FORMAT_R10G10B10A2_UINT    }, // GL_RGB10_A2UI
+    { 0x822A, DXGI_FORMAT_R16_UNORM           }, // GL_R16
+    { 0x8F98, DXGI_FORMAT_R16_SNORM           }, // GL_R16_SNORM
+    { 0x8234, DXGI_FORMAT_R16_UINT            }, // GL_R16UI
+    { 0x8233, DXGI_FORMAT_R16_SINT            }, // GL_R16I
+    { 0x822D, DXGI_FORMAT_R16_FLOAT           }, // GL_R16F
+    { 0x822C, DXGI_FORMAT_R16G16_UNORM        }, // GL_RG16
+    { 0x8F99, DXGI_FORMAT_R16G16_SNORM        }, // GL_RG16_SNORM
+    { 0x823A, DXGI_FORMAT_R16G16_UINT         }, // GL_RG16UI
+    { 0x8239, DXGI_FORMAT_R16G16_SINT         }, // GL_RG16I
+    { 0x822F, DXGI_FORMAT_R16G16_FLOAT        }, // GL_RG16F
+    { 0x805B, DXGI_FORMAT_R16G16B16A16_UNORM  }, // GL_RGBA16
+    { 0x8F9B, DXGI_FORMAT_R16G16B16A16_SNORM  }, // GL_RGBA16_SNORM
+    { 0x8D76, DXGI_FORMAT_R16G16B16A16_UINT   }, // GL_RGBA16UI
+    { 0x8D88, DXGI_FORMAT_R16G16B16A16_SINT   }, // GL_RGBA16I
+    { 0x881A, DXGI_FORMAT_R16G16B16A16_FLOAT  }, // GL_RGBA16F
+    { 0x8236, DXGI_FORMAT_R32_UINT            }, // GL_R32UI
+    { 0x8235, DXGI_FORMAT_R32_SINT            }, // GL_R32I
+    { 0x822E, DXGI_FORMAT_R32_FLOAT           }, // GL_R32F
+    { 0x823C, DXGI_FORMAT_R32G32_UINT         }, // GL_RG32UI
+    { 0x823B, DXGI_FORMAT_R32G32_SINT         }, // GL_RG32I
+    { 0x8230, DXGI_FORMAT_R32G32_FLOAT        }, // GL_RG32F
+    { 0x8D71, DXGI_FORMAT_R32G32B32_UINT      }, // GL_RGB32UI
+    { 0x8D83, DXGI_FORMAT_R32G32B32_SINT      }, // GL_RGB32I
+    { 0x8815, DXGI_FORMAT_R32G32B32_FLOAT     }, // GL_RGB32F
+    { 0x8D70, DXGI_FORMAT_R32G32B32A32_UINT   }, // GL_RGBA32UI
+    { 0x8D82, DXGI_FORMAT_R32G32B32A32_SINT   }, // GL_RGBA32I
+    { 0x8814, DXGI_FORMAT_R32G32B32A32_FLOAT  }, // GL_RGBA32F
+    { 0x8C3A, DXGI_FORMAT_R11G11B10_FLOAT     }, // GL_R11F_G11F_B10F
+    { 0x8C3D, DXGI_FORMAT_R9G9B9E5_SHAREDEXP  }, // GL_RGB9_E5
+    { 0x81A5, DXGI_FORMAT_D16_UNORM           }, // GL_DEPTH_COMPONENT16
+    { 0x8CAC, DXGI_FORMAT_D32_FLOAT           }, // GL_DEPTH_COMPONENT32F
+    { 0x83F0, DXGI_FORMAT_BC1_UNORM           }, // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    { 0x83F1, DXGI_FORMAT_BC1_UNORM           }, // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+    { 0x83F2, DXGI_FORMAT_BC2_UNORM           }, // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+    { 0x83F3, DXGI_FORMAT_BC3_UNORM           }, // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    { 0x8C4C, DXGI_FORMAT_BC1_UNORM_SRGB      }, // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+    { 0x8C4D, DXGI_FORMAT_BC1_UNORM_SRGB      }, // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+    { 0x8C4E, DXGI_FORMAT_BC2_UNORM_SRGB      }, // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+    { 0x8C4F, DXGI_FORMAT_BC3_UNORM_SRGB      }, // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+    { 0x8DBB, DXGI_FORMAT_BC4_UNORM           }, // GL_COMPRESSED_RED_RGTC1
+    { 0x8DBC, DXGI_FORMAT_BC4_SNORM           }, // GL_COMPRESSED_SIGNED_RED_RGTC1
+    { 0x8DBD, DXGI_FORMAT_BC5_UNORM           }, // GL_COMPRESSED_RG_RGTC2
+    { 0x8DBE, DXGI_FORMAT_BC5_SNORM           }, // GL_COMPRESSED_SIGNED_RG_RGTC2
+    { 0x8E8C, DXGI_FORMAT_BC7_UNORM           }, // GL_COMPRESSED_RGBA_BPTC_UNORM
+    { 0x8E8D, DXGI_FORMAT_BC7_UNORM_SRGB      }, // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+    { 0x8E8E, DXGI_FORMAT_BC6H_SF16           }, // GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+    { 0x8E8F, DXGI_FORMAT_BC6H_UF16           }, // GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+};
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Reads a little-endian 32-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint32_t ktx_u32(uint8_t const *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/// @summary Reads a little-endian 64-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint64_t ktx_u64(uint8_t const *p)
+{
+    return uint64_t(ktx_u32(p)) | (uint64_t(ktx_u32(p + 4)) << 32);
+}
+
+/// @summary Looks up the DXGI format equivalent to a VkFormat or OpenGL internal format.
+/// @param map The format table to search.
+/// @param count The number of entries in the table.
+/// @param source The VkFormat or OpenGL internal format value.
+/// @return One of dxgi_format_e, or DXGI_FORMAT_UNKNOWN if there is no equivalent.
+internal_function uint32_t ktx_find_format(ktx_format_map_t const *map, size_t count, uint32_t source)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (map[i].Source == source)
+            return map[i].Format;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+/// @summary Copies up to a given number of bytes from the stream decoder into a buffer.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state, whose FilePos and HeaderWritePos are updated.
+/// @param buffer The destination buffer.
+/// @param size The total number of bytes to buffer.
+/// @return true if the buffer is complete.
+internal_function bool ktx_buffer(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, uint8_t *buffer, size_t size)
+{
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = size - ktxp->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&buffer[ktxp->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    ktxp->HeaderWritePos    += bytes_to_copy;
+    ktxp->FilePos           += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (ktxp->HeaderWritePos < size)
+    {   // this is a partial read; wait for more data.
+        return false;
+    }
+    ktxp->HeaderWritePos = 0;
+    return true;
+}
+
+/// @summary Moves the parser to a later position in the file.
+/// @param ktxp The KTX parser state.
+/// @param offset The file offset to move to. Must not be before the current position.
+/// @param next_state The parser state to enter at the new position.
+/// @return The new parser state.
+internal_function int ktx_skip_to(ktx_parser_state_t *ktxp, uint64_t offset, int next_state)
+{
+    if (offset < ktxp->FilePos)
+    {   // the sections of the file overlap, or are out of order.
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    if (offset == ktxp->FilePos)
+    {
+        return next_state;
+    }
+    ktxp->SkipRemain = offset - ktxp->FilePos;
+    ktxp->SkipState  = next_state;
+    return KTX_PARSE_STATE_SKIP_DATA;
+}
+
+/// @summary Determines whether an element of a level has been received in its entirety.
+/// @param ktxp The KTX parser state.
+/// @param level The zero-based index of the level.
+/// @param element The zero-based index of the element.
+/// @return true if all of the element's data for the level has been received.
+internal_function inline bool ktx_received(ktx_parser_state_t const *ktxp, size_t level, size_t element)
+{
+    size_t rank = ktxp->LevelRank[level];
+    if (rank < ktxp->ReceiveRank) return true;
+    if (rank > ktxp->ReceiveRank) return false;
+    return element < ktxp->ReceiveElement;
+}
+
+/// @summary Passes received subresources to the encoder in the order it expects them: every level of one element, then the next element.
+/// @param ktxp The KTX parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @param direct Specify true if the subresource just received was written to the encoder as it arrived.
+/// @return true if the subresources were encoded, or false if the encoder returned an error.
+internal_function bool ktx_drain(ktx_parser_state_t *ktxp, image_encoder_t *encoder, bool direct)
+{
+    while (ktxp->ElementIndex < ktxp->ElementFinal && ktx_received(ktxp, ktxp->LevelIndex, ktxp->ElementIndex))
+    {
+        if (!direct)
+        {   // the subresource arrived before the encoder reached it, and was staged.
+            size_t         size = ktxp->LevelInfo[ktxp->LevelIndex].DataSize;
+            uint8_t const *data = ktxp->Stage[ktxp->LevelIndex] + (ktxp->ElementIndex - ktxp->ElementFirst) * size;
+            if (encoder->encode(ktxp->ElementIndex, data, size) != ERROR_SUCCESS)
+            {
+                ktxp->ParserError = KTX_PARSE_ERROR_ENCODER;
+                return false;
+            }
+        }
+        direct = false;
+        encoder->mark_level(ktxp->ElementIndex);
+        if (++ktxp->LevelIndex == ktxp->LevelCount)
+        {   // all levels of the element have been written.
+            encoder->mark_element(ktxp->ElementIndex++);
+            ktxp->LevelIndex = 0;
+            if (ktxp->ElementIndex < ktxp->ElementFinal)
+                encoder->reset_element(ktxp->ElementIndex);
+        }
+    }
+    return true;
+}
+
+/// @summary Consumes data of the level being received, in KTX2 layout: each element in turn, with no padding. Data for the subresource the encoder is waiting on is written to it directly; other requested subresources are staged.
+/// @param ktxp The KTX parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @param data The level data.
+/// @param size The number of bytes of level data.
+/// @return true if the data was consumed, or false if the level is too long, memory allocation failed or the encoder returned an error.
+internal_function bool ktx_receive(ktx_parser_state_t *ktxp, image_encoder_t *encoder, uint8_t const *data, size_t size)
+{
+    size_t const level    = ktxp->ReceiveLevel;
+    size_t const sub_size = ktxp->LevelInfo[level].DataSize;
+    while (size > 0)
+    {
+        if (ktxp->ReceiveElement == ktxp->ElementCount)
+        {   // there's more data than the level holds.
+            ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+            return false;
+        }
+        size_t element = ktxp->ReceiveElement;
+        size_t count   = image_min2<size_t>(sub_size - ktxp->ReceiveOffset, size);
+        bool   direct  = level == ktxp->LevelIndex && element == ktxp->ElementIndex && element < ktxp->ElementFinal;
+        if (direct)
+        {   // the encoder is waiting on this subresource.
+            if (encoder->encode(element, data, count) != ERROR_SUCCESS)
+            {
+                ktxp->ParserError = KTX_PARSE_ERROR_ENCODER;
+                return false;
+            }
+        }
+        else if (element >= ktxp->ElementFirst && element < ktxp->ElementFinal)
+        {   // keep the data until the encoder reaches it.
+            if (ktxp->Stage[level] == NULL && (ktxp->Stage[level] = (uint8_t*) malloc(sub_size * (ktxp->ElementFinal - ktxp->ElementFirst))) == NULL)
+            {
+                ktxp->ParserError = KTX_PARSE_ERROR_NOMEMORY;
+                return false;
+            }
+            memcpy(ktxp->Stage[level] + (element - ktxp->ElementFirst) * sub_size + ktxp->ReceiveOffset, data, count);
+        }
+        // else, the element wasn't requested.
+        data += count;
+        size -= count;
+        if ((ktxp->ReceiveOffset += count) == sub_size)
+        {   // the subresource is complete.
+            ktxp->ReceiveOffset = 0;
+            ktxp->ReceiveElement++;
+            if (!ktx_drain(ktxp, encoder, direct))
+                return false;
+        }
+    }
+    return true;
+}
+
+/// @summary Consumes data of the level being received, in KTX layout, where each row is padded to a multiple of four bytes. The padding is discarded.
+/// @param ktxp The KTX parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @param data The level data.
+/// @param size The number of bytes of level data.
+/// @return true if the data was consumed.
+internal_function bool ktx1_receive(ktx_parser_state_t *ktxp, image_encoder_t *encoder, uint8_t const *data, size_t size)
+{
+    if (ktxp->RowPitch == ktxp->RowSize)
+    {   // rows are already a multiple of four bytes, as with all block-compressed formats.
+        ktxp->RowPos += size;
+        return ktx_receive(ktxp, encoder, data, size);
+    }
+    while (size > 0)
+    {
+        size_t column = size_t(ktxp->RowPos % ktxp->RowPitch);
+        size_t count;
+        if (column < ktxp->RowSize)
+        {
+            count = image_min2<size_t>(ktxp->RowSize - column, size);
+            if (!ktx_receive(ktxp, encoder, data, count))
+                return false;
+        }
+        else count = image_min2<size_t>(ktxp->RowPitch - column, size);
+        ktxp->RowPos += count;
+        data         += count;
+        size         -= count;
+    }
+    return true;
+}
+
+/// @summary Determines the number of levels, elements and the DXGI format from the KTX header.
+/// @param ktxp The KTX parser state, with the complete header in HeaderBuffer.
+/// @return The new parser state.
+internal_function int ktx1_process_header(ktx_parser_state_t *ktxp)
+{
+    uint8_t const *h        = ktxp->HeaderBuffer;
+    uint32_t       gl_type  = ktx_u32(h + 16);
+    uint32_t       gl_fmt   = ktx_u32(h + 24);
+    uint32_t       gl_ifmt  = ktx_u32(h + 28);
+    uint32_t       layers   = ktx_u32(h + 48);
+    uint32_t       faces    = ktx_u32(h + 52);
+    uint32_t       levels   = ktx_u32(h + 56);
+    if (ktx_u32(h + 12) != KTX1_ENDIAN_REF)
+    {   // the file was written big-endian.
+        ktxp->ParserError = KTX_PARSE_ERROR_UNSUPPORTED;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    ktxp->Width        = ktx_u32(h + 36);
+    ktxp->Height       = image_max2<size_t>(1, ktx_u32(h + 40));
+    ktxp->Depth        = image_max2<size_t>(1, ktx_u32(h + 44));
+    ktxp->LayerCount   = image_max2<size_t>(1, layers);
+    ktxp->FaceCount    = faces;
+    ktxp->LevelCount   = image_max2<size_t>(1, levels);
+    ktxp->KeyValueSize = ktx_u32(h + 60);
+    ktxp->FaceImageSize=(faces == 6 && layers == 0);
+    if (gl_ifmt == 0x8058 && gl_fmt == KTX_GL_BGRA)
+    {   // RGBA8 storage with the bytes in BGRA order.
+        ktxp->Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    }
+    else if (gl_ifmt == 0x8C43 && gl_fmt == KTX_GL_BGRA)
+    {
+        ktxp->Format = DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+    }
+    else if (gl_ifmt == 0x8D62 && gl_type == KTX_GL_UNSIGNED_SHORT_565)
+    {   // GL_RGB565, with red in the high bits.
+        ktxp->Format = DXGI_FORMAT_B5G6R5_UNORM;
+    }
+    else
+    {
+        ktxp->Format = ktx_find_format(KTX1_FORMATS, sizeof(KTX1_FORMATS) / sizeof(KTX1_FORMATS[0]), gl_ifmt);
+    }
+    if (ktxp->Format == DXGI_FORMAT_UNKNOWN)
+    {   // ETC, ASTC, PVRTC, unsized and packed RGB formats have no DXGI equivalent.
+        ktxp->ParserError = KTX_PARSE_ERROR_UNSUPPORTED;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    return KTX_PARSE_STATE_COMPLETE;
+}
+
+/// @summary Determines the number of levels, elements and the DXGI format from the KTX2 header, and reads the level index.
+/// @param ktxp The KTX parser state, with the complete header in HeaderBuffer and the level index in IndexBuffer.
+/// @return The new parser state.
+internal_function int ktx2_process_header(ktx_parser_state_t *ktxp)
+{
+    uint8_t const *h        = ktxp->HeaderBuffer;
+    uint32_t       vkformat = ktx_u32(h + 12);
+    ktxp->Width             = ktx_u32(h + 20);
+    ktxp->Height            = image_max2<size_t>(1, ktx_u32(h + 24));
+    ktxp->Depth             = image_max2<size_t>(1, ktx_u32(h + 28));
+    ktxp->LayerCount        = image_max2<size_t>(1, ktx_u32(h + 32));
+    ktxp->FaceCount         = ktx_u32(h + 36);
+    ktxp->Supercompression  = ktx_u32(h + 44);
+    ktxp->DFDOffset         = ktx_u32(h + 48);
+    ktxp->DFDSize           = ktx_u32(h + 52);
+    ktxp->Format            = ktx_find_format(KTX2_FORMATS, sizeof(KTX2_FORMATS) / sizeof(KTX2_FORMATS[0]), vkformat);
+    if (ktxp->Format == DXGI_FORMAT_UNKNOWN || ktxp->Supercompression == KTX_SUPERCOMPRESSION_BASISLZ || ktxp->Supercompression > KTX_SUPERCOMPRESSION_ZLIB)
+    {   // Basis Universal, ASTC, ETC and other formats with no DXGI equivalent, or an unknown supercompression scheme.
+        ktxp->ParserError = KTX_PARSE_ERROR_UNSUPPORTED;
+        return KTX_PARSE_STATE_ERROR;
+    }
+
+    // levels are normally stored smallest first; sort them into file order.
+    for (size_t i = 0; i < ktxp->LevelCount; ++i)
+    {
+        uint8_t const *e = ktxp->IndexBuffer + i * KTX2_LEVEL_ENTRY_SIZE;
+        ktxp->Levels[i].ByteOffset         = ktx_u64(e + 0);
+        ktxp->Levels[i].ByteLength         = ktx_u64(e + 8);
+        ktxp->Levels[i].UncompressedLength = ktx_u64(e + 16);
+        size_t j = i;
+        while (j > 0 && ktxp->Levels[ktxp->LevelOrder[j - 1]].ByteOffset > ktxp->Levels[i].ByteOffset)
+        {
+            ktxp->LevelOrder[j] = ktxp->LevelOrder[j - 1];
+            j--;
+        }
+        ktxp->LevelOrder[j] = uint8_t(i);
+    }
+    for (size_t i = 0; i < ktxp->LevelCount; ++i)
+    {
+        ktxp->LevelRank[ktxp->LevelOrder[i]] = uint8_t(i);
+    }
+    return KTX_PARSE_STATE_COMPLETE;
+}
+
+/// @summary Checks the dimensions read from a KTX or KTX2 header.
+/// @param ktxp The KTX parser state.
+/// @return true if the dimensions describe a texture the parser can load.
+internal_function bool ktx_validate_dimensions(ktx_parser_state_t *ktxp)
+{
+    if (ktxp->Width == 0 || ktxp->Width > KTX_MAX_DIMENSION || ktxp->Height > KTX_MAX_DIMENSION || ktxp->Depth > KTX_MAX_DIMENSION ||
+        ktxp->LayerCount > KTX_MAX_LAYERS || (ktxp->FaceCount != 1 && ktxp->FaceCount != 6) || ktxp->LevelCount > KTX_MAX_LEVELS ||
+       (ktxp->FaceCount == 6 && (ktxp->Width != ktxp->Height || ktxp->Depth > 1)))
+    {   // the header is invalid.
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return false;
+    }
+    if (ktxp->Depth > 1 && ktxp->LayerCount > 1)
+    {   // arrays of volumes can't be described by a DDS header.
+        ktxp->ParserError = KTX_PARSE_ERROR_UNSUPPORTED;
+        return false;
+    }
+    ktxp->ElementCount = ktxp->LayerCount * ktxp->FaceCount;
+    return true;
+}
+
+/// @summary Sets up to receive the next KTX2 level in file order.
+/// @param ktxp The KTX parser state.
+/// @return The new parser state.
+internal_function int ktx2_begin_level(ktx_parser_state_t *ktxp)
+{
+    size_t      level  = ktxp->LevelOrder[ktxp->ReceiveRank];
+    ktx_level_t const &entry = ktxp->Levels[level];
+    uint64_t    expect = uint64_t(ktxp->LevelInfo[level].DataSize) * ktxp->ElementCount;
+    uint64_t    length = ktxp->Supercompression == KTX_SUPERCOMPRESSION_NONE ? entry.ByteLength : entry.UncompressedLength;
+    if (length != expect || entry.ByteLength == 0 || entry.ByteLength > expect + (expect >> 6) + 4096)
+    {   // the level doesn't hold exactly one subresource for each element, or is far larger than any compressor would produce.
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    ktxp->ReceiveLevel   = level;
+    ktxp->ReceiveElement = 0;
+    ktxp->ReceiveOffset  = 0;
+    ktxp->LevelRemain    = entry.ByteLength;
+    ktxp->LevelFill      = 0;
+    if (ktxp->Supercompression == KTX_SUPERCOMPRESSION_ZSTD && ktxp->LevelOutputSize < expect)
+    {   // each level is decompressed into memory in one pass.
+        free(ktxp->LevelOutput);
+        if ((ktxp->LevelOutput = (uint8_t*) malloc(size_t(expect))) == NULL)
+        {
+            ktxp->LevelOutputSize = 0;
+            ktxp->ParserError     = KTX_PARSE_ERROR_NOMEMORY;
+            return KTX_PARSE_STATE_ERROR;
+        }
+        ktxp->LevelOutputSize = size_t(expect);
+    }
+    if (ktxp->Supercompression == KTX_SUPERCOMPRESSION_ZLIB)
+    {   // each level is a separate zlib stream.
+        if (ktxp->InflateReady)
+        {
+            inflate_delete(&ktxp->Inflate);
+            ktxp->InflateReady = false;
+        }
+        if (!inflate_init(&ktxp->Inflate, true))
+        {
+            ktxp->ParserError = KTX_PARSE_ERROR_NOMEMORY;
+            return KTX_PARSE_STATE_ERROR;
+        }
+        ktxp->InflateReady = true;
+    }
+    return ktx_skip_to(ktxp, entry.ByteOffset, KTX_PARSE_STATE_LEVEL_DATA);
+}
+
+/// @summary Completes the level being received and moves on to the next level, if the encoder still needs data.
+/// @param ktxp The KTX parser state.
+/// @return The new parser state.
+internal_function int ktx_finish_level(ktx_parser_state_t *ktxp)
+{
+    if (ktxp->ReceiveElement != ktxp->ElementCount)
+    {   // the level data ended early.
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    ktxp->ReceiveRank++;
+    ktxp->ReceiveElement = 0;
+    if (ktxp->ElementIndex == ktxp->ElementFinal)
+    {   // all of the requested elements have been written. the rest of the file isn't needed.
+        return KTX_PARSE_STATE_COMPLETE;
+    }
+    if (ktxp->ReceiveRank == ktxp->LevelCount)
+    {   // unreachable if the level data was consistent.
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    if (ktxp->Version == 1) return KTX_PARSE_STATE_LEVEL_SIZE;
+    else return ktx2_begin_level(ktxp);
+}
+
+/// @summary Calculates all of the static data once the headers have been received and validated.
+/// @param ktxp The parser state to update.
+/// @return The new parser state.
+internal_function int ktx_parser_setup_image_info(ktx_parser_state_t *ktxp)
+{
+    image_definition_t *meta = ktxp->Metadata;
+    if (ktxp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // completely initialize the metadata block with information we've read.
+        dds_header_t       dds;
+        dds_header_dxt10_t dx10;
+        dds_headers_for_texture(&dds, &dx10, ktxp->Format, ktxp->Width, ktxp->Height, ktxp->Depth, ktxp->LevelCount, ktxp->LayerCount, ktxp->FaceCount == 6, ktxp->AlphaMode);
+        if (!dds_image_definition(meta, ktxp->Config.ImageId, &dds, &dx10, ktxp->Config.Compression, ktxp->Config.Encoding))
+        {   // unable to allocate storage for the mip-level descriptors and offsets.
+            ktxp->ParserError = KTX_PARSE_ERROR_NOMEMORY;
+            return KTX_PARSE_STATE_ERROR;
+        }
+    }
+    else if (meta->ElementCount != ktxp->ElementCount || meta->LevelCount != ktxp->LevelCount)
+    {   // the file has changed since the image was defined.
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+
+    // create the image encoder instance.
+    ktxp->Encoder = create_image_encoder(
+        ktxp->Config.ImageId,
+        ktxp->Config.Memory,
+        IMAGE_COMPRESSION_NONE,
+        IMAGE_ENCODING_RAW,
+        ktxp->Config.Compression,
+        ktxp->Config.Encoding,
+        dds_access_type(meta),
+        ktxp->Config.DefinitionQueue,
+        ktxp->Config.DefinitionAlloc,
+        ktxp->Config.PlacementQueue,
+        ktxp->Config.PlacementAlloc,
+        meta->ImageFormat,
+        ktxp->Config.Format,
+        ktxp->Config.Quality,
+        ktxp->Config.WorkPool,
+        ktxp->Config.EncoderFlags);
+    if (ktxp->Encoder == NULL)
+    {   // unable to create the encoder to write to image memory.
+        ktxp->ParserError = KTX_PARSE_ERROR_NOENCODER;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    if (ktxp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // notify the encoder of the image attributes:
+        if (ktxp->Encoder->define_image(meta) != ERROR_SUCCESS)
+        {
+            ktxp->ParserError = KTX_PARSE_ERROR_ENCODER;
+            return KTX_PARSE_STATE_ERROR;
+        }
+    }
+    else
+    {   // the image is already defined, but encoders that change the format need the source attributes.
+        ktxp->Encoder->Metadata = meta;
+    }
+
+    // the headers are needed to locate any frame, so the block offsets are left at zero.
+    if ((ktxp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_PIXELS) == 0 || ktxp->Config.FirstFrame >= meta->ElementCount)
+    {   // not reading any pixel data, so we're done.
+        return KTX_PARSE_STATE_COMPLETE;
+    }
+    ktxp->LevelInfo    = meta->LevelInfo;
+    ktxp->ElementFirst = ktxp->Config.FirstFrame;
+    ktxp->ElementFinal =(ktxp->Config.FinalFrame >= meta->ElementCount) ? meta->ElementCount : ktxp->Config.FinalFrame + 1;
+    ktxp->ElementIndex = ktxp->ElementFirst;
+    ktxp->LevelIndex   = 0;
+    ktxp->ReceiveRank  = 0;
+    if (ktxp->ElementFinal <= ktxp->ElementFirst)
+    {   // the frame range is empty.
+        return KTX_PARSE_STATE_COMPLETE;
+    }
+    if (ktxp->Supercompression == KTX_SUPERCOMPRESSION_ZSTD)
+    {
+        if (!zstd_init(&ktxp->Zstd))
+        {
+            ktxp->ParserError = KTX_PARSE_ERROR_NOMEMORY;
+            return KTX_PARSE_STATE_ERROR;
+        }
+        ktxp->ZstdReady = true;
+    }
+    ktxp->Encoder->reset_element(ktxp->ElementIndex);
+    if (ktxp->Version == 1)
+    {   // the key/value data follows the header, then the first level.
+        return ktx_skip_to(ktxp, KTX1_HEADER_SIZE + uint64_t(ktxp->KeyValueSize), KTX_PARSE_STATE_LEVEL_SIZE);
+    }
+    else return ktx2_begin_level(ktxp);
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_SEEK_OFFSET.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_seek_offset(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    stream_decode_pos_t &target  = ktxp->Config.StartOffset;
+    stream_decode_pos_t  current;  decoder->pos(current);
+    if (current.FileOffset      >= target.FileOffset &&
+        current.FileOffset      <= target.FileOffset)
+    {   // this encoded data chunk contains the start of the data we're looking for.
+        size_t available         = decoder->amount();
+        size_t consume           =(target.DecodeOffset >= available) ? available : target.DecodeOffset;
+        decoder->ReadCursor     += consume; // consume from available decoded input
+        target.DecodeOffset     -= consume; // decrement bytes remaining to consume
+        if (decoder->ReadCursor != decoder->FinalByte)
+        {   // level data is located through the headers, so they are always read.
+            return KTX_PARSE_STATE_BUFFER_IDENTIFIER;
+        }
+        // else, refill the decoded data buffer and remain in the same state.
+    }
+    return KTX_PARSE_STATE_SEEK_OFFSET;
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_BUFFER_IDENTIFIER.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_buffer_identifier(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    if (!ktx_buffer(decoder, ktxp, ktxp->HeaderBuffer, KTX_IDENTIFIER_SIZE))
+    {   // this is a partial read; wait for more data.
+        return KTX_PARSE_STATE_BUFFER_IDENTIFIER;
+    }
+    if (memcmp(ktxp->HeaderBuffer, KTX1_IDENTIFIER, KTX_IDENTIFIER_SIZE) == 0)
+    {
+        ktxp->Version = 1;
+    }
+    else if (memcmp(ktxp->HeaderBuffer, KTX2_IDENTIFIER, KTX_IDENTIFIER_SIZE) == 0)
+    {
+        ktxp->Version = 2;
+    }
+    else
+    {   // this isn't a KTX or KTX2 file.
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    ktxp->HeaderWritePos = KTX_IDENTIFIER_SIZE;
+    return KTX_PARSE_STATE_BUFFER_HEADER;
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_BUFFER_HEADER.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_buffer_header(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    if (!ktx_buffer(decoder, ktxp, ktxp->HeaderBuffer, ktxp->Version == 1 ? KTX1_HEADER_SIZE : KTX2_HEADER_SIZE))
+    {   // this is a partial read; wait for more data.
+        return KTX_PARSE_STATE_BUFFER_HEADER;
+    }
+    if (ktxp->Version == 1)
+    {
+        if (ktx1_process_header(ktxp) == KTX_PARSE_STATE_ERROR || !ktx_validate_dimensions(ktxp))
+            return KTX_PARSE_STATE_ERROR;
+        for (size_t i = 0; i < ktxp->LevelCount; ++i)
+        {   // KTX stores levels in order.
+            ktxp->LevelOrder[i] = uint8_t(i);
+            ktxp->LevelRank [i] = uint8_t(i);
+        }
+        return ktx_parser_setup_image_info(ktxp);
+    }
+    // a level count of zero asks for the mipmaps to be generated; the file stores the first level only.
+    ktxp->LevelCount = image_max2<size_t>(1, ktx_u32(ktxp->HeaderBuffer + 40));
+    if (ktxp->LevelCount > KTX_MAX_LEVELS)
+    {
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    return KTX_PARSE_STATE_BUFFER_LEVEL_INDEX;
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_BUFFER_LEVEL_INDEX.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_buffer_level_index(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    if (!ktx_buffer(decoder, ktxp, ktxp->IndexBuffer, ktxp->LevelCount * KTX2_LEVEL_ENTRY_SIZE))
+    {   // this is a partial read; wait for more data.
+        return KTX_PARSE_STATE_BUFFER_LEVEL_INDEX;
+    }
+    if (ktx2_process_header(ktxp) == KTX_PARSE_STATE_ERROR || !ktx_validate_dimensions(ktxp))
+    {
+        return KTX_PARSE_STATE_ERROR;
+    }
+    if (ktxp->DFDSize >= KTX2_DFD_PREFIX_SIZE)
+    {   // the descriptor says whether the color values are premultiplied.
+        return ktx_skip_to(ktxp, ktxp->DFDOffset, KTX_PARSE_STATE_BUFFER_DFD);
+    }
+    return ktx_parser_setup_image_info(ktxp);
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_BUFFER_DFD.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_buffer_dfd(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    if (!ktx_buffer(decoder, ktxp, ktxp->HeaderBuffer, KTX2_DFD_PREFIX_SIZE))
+    {   // this is a partial read; wait for more data.
+        return KTX_PARSE_STATE_BUFFER_DFD;
+    }
+    if (ktx_u32(ktxp->HeaderBuffer + 4) == 0 && (ktxp->HeaderBuffer[15] & KTX2_DF_FLAG_PREMULTIPLIED) != 0)
+    {   // a Khronos basic descriptor block with the premultiplied flag set.
+        ktxp->AlphaMode = DDS_ALPHA_MODE_PREMULTIPLIED;
+    }
+    return ktx_parser_setup_image_info(ktxp);
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_SKIP_DATA.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_skip_data(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_skip     =(ktxp->SkipRemain < bytes_available) ? size_t(ktxp->SkipRemain) : bytes_available;
+    decoder->ReadCursor     += bytes_to_skip;
+    ktxp->SkipRemain        -= bytes_to_skip;
+    ktxp->FilePos           += bytes_to_skip;
+    return (ktxp->SkipRemain == 0) ? ktxp->SkipState : KTX_PARSE_STATE_SKIP_DATA;
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_LEVEL_SIZE.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_level_size(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    if (!ktx_buffer(decoder, ktxp, ktxp->HeaderBuffer, sizeof(uint32_t)))
+    {   // this is a partial read; wait for more data.
+        return KTX_PARSE_STATE_LEVEL_SIZE;
+    }
+    // the size field covers one face of a cubemap that isn't an array, or the whole level otherwise.
+    // rows are padded to four bytes; faces and levels then need no further padding.
+    dds_level_desc_t const &desc = ktxp->LevelInfo[ktxp->ReceiveRank];
+    uint64_t image_size = ktx_u32(ktxp->HeaderBuffer);
+    uint64_t row_count  = desc.DataSize / desc.BytesPerRow;
+    uint64_t padded     = row_count * ((desc.BytesPerRow + 3) & ~size_t(3));
+    uint64_t expect     = ktxp->FaceImageSize ? padded : padded * ktxp->ElementCount;
+    if (image_size != expect)
+    {
+        ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        return KTX_PARSE_STATE_ERROR;
+    }
+    ktxp->ReceiveLevel   = ktxp->ReceiveRank;
+    ktxp->ReceiveElement = 0;
+    ktxp->ReceiveOffset  = 0;
+    ktxp->LevelRemain    = padded * ktxp->ElementCount;
+    ktxp->RowSize        = desc.BytesPerRow;
+    ktxp->RowPitch       =(desc.BytesPerRow + 3) & ~size_t(3);
+    ktxp->RowPos         = 0;
+    return KTX_PARSE_STATE_LEVEL_DATA;
+}
+
+/// @summary Implements the parser logic for the KTX_PARSE_STATE_LEVEL_DATA.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param ktxp The KTX parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int ktx_level_data(stream_decoder_t *decoder, ktx_parser_state_t *ktxp, image_encoder_t *encoder)
+{
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_read     =(ktxp->LevelRemain < bytes_available) ? size_t(ktxp->LevelRemain) : bytes_available;
+    if (ktxp->Supercompression == KTX_SUPERCOMPRESSION_ZLIB)
+    {   // inflate the level as it arrives.
+        for ( ; ; )
+        {
+            if (bytes_to_read > 0)
+            {
+                size_t bytes_fed     = inflate_feed(&ktxp->Inflate, decoder->ReadCursor, bytes_to_read);
+                decoder->ReadCursor += bytes_fed;
+                ktxp->LevelRemain   -= bytes_fed;
+                ktxp->FilePos       += bytes_fed;
+                bytes_to_read       -= bytes_fed;
+                if (ktxp->LevelRemain == 0) inflate_finish(&ktxp->Inflate);
+            }
+            size_t         avail = 0;
+            int            res   = inflate_run(&ktxp->Inflate);
+            uint8_t const *data  = inflate_output(&ktxp->Inflate, avail);
+            if (!ktx_receive(ktxp, encoder, data, avail))
+            {   // ParserError was set by ktx_receive.
+                return KTX_PARSE_STATE_ERROR;
+            }
+            inflate_consume(&ktxp->Inflate, avail);
+            if (res == INFLATE_RESULT_DONE)
+            {
+                return ktx_finish_level(ktxp);
+            }
+            if (res == INFLATE_RESULT_NEED_OUTPUT)
+            {   // the output was consumed, so there's space for more.
+                continue;
+            }
+            if (res == INFLATE_RESULT_NEED_INPUT && ktxp->LevelRemain > 0)
+            {
+                if (bytes_to_read == 0)
+                {   // wait for the stream decoder to be refilled.
+                    return KTX_PARSE_STATE_LEVEL_DATA;
+                }
+                continue;
+            }
+            // the zlib stream is invalid, or ended before the level was complete.
+            ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+            return KTX_PARSE_STATE_ERROR;
+        }
+    }
+    if (ktxp->Supercompression == KTX_SUPERCOMPRESSION_ZSTD)
+    {   // the whole frame is needed before decoding. if the stream decoder holds all of it, decode it in place.
+        uint8_t const *src      = decoder->ReadCursor;
+        size_t         src_size = size_t(ktxp->Levels[ktxp->ReceiveLevel].ByteLength);
+        if (ktxp->LevelFill > 0 || bytes_to_read < ktxp->LevelRemain)
+        {
+            if (ktxp->LevelBufferSize < src_size)
+            {
+                free(ktxp->LevelBuffer);
+                if ((ktxp->LevelBuffer = (uint8_t*) malloc(src_size)) == NULL)
+                {
+                    ktxp->LevelBufferSize = 0;
+                    ktxp->ParserError     = KTX_PARSE_ERROR_NOMEMORY;
+                    return KTX_PARSE_STATE_ERROR;
+                }
+                ktxp->LevelBufferSize = src_size;
+            }
+            memcpy(ktxp->LevelBuffer + ktxp->LevelFill, decoder->ReadCursor, bytes_to_read);
+            ktxp->LevelFill    += bytes_to_read;
+            src                 = ktxp->LevelBuffer;
+        }
+        decoder->ReadCursor    += bytes_to_read;
+        ktxp->LevelRemain      -= bytes_to_read;
+        ktxp->FilePos          += bytes_to_read;
+        if (ktxp->LevelRemain > 0)
+        {   // wait for the rest of the frame.
+            return KTX_PARSE_STATE_LEVEL_DATA;
+        }
+        size_t expect = ktxp->LevelInfo[ktxp->ReceiveLevel].DataSize * ktxp->ElementCount;
+        size_t actual = 0;
+        if (!zstd_decompress(&ktxp->Zstd, ktxp->LevelOutput, expect, src, src_size, actual) || actual != expect)
+        {
+            ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+            return KTX_PARSE_STATE_ERROR;
+        }
+        if (!ktx_receive(ktxp, encoder, ktxp->LevelOutput, actual))
+        {   // ParserError was set by ktx_receive.
+            return KTX_PARSE_STATE_ERROR;
+        }
+        return ktx_finish_level(ktxp);
+    }
+    // the level data is stored as-is.
+    bool ok = ktxp->Version == 1 ? ktx1_receive(ktxp, encoder, decoder->ReadCursor, bytes_to_read) : ktx_receive(ktxp, encoder, decoder->ReadCursor, bytes_to_read);
+    decoder->ReadCursor     += bytes_to_read;
+    ktxp->LevelRemain       -= bytes_to_read;
+    ktxp->FilePos           += bytes_to_read;
+    if (!ok)
+    {   // ParserError was set by ktx_receive.
+        return KTX_PARSE_STATE_ERROR;
+    }
+    return (ktxp->LevelRemain == 0) ? ktx_finish_level(ktxp) : KTX_PARSE_STATE_LEVEL_DATA;
+}
+
+/// @summary Implements the primary update tick for a streaming KTX parser.
+/// @param ktxp The KTX parser state to update.
+/// @return One of ktx_parser_result_e.
+internal_function int ktx_parser_update(ktx_parser_state_t *ktxp)
+{
+    stream_decoder_t *decoder   = ktxp->Config.Decoder;
+    while (ktxp->CurrentState  != KTX_PARSE_STATE_COMPLETE)
+    {
+        if (ktxp->CurrentState == KTX_PARSE_STATE_ERROR)
+        {   // return from the error state immediately.
+            return KTX_PARSE_RESULT_ERROR;
+        }
+        if (decoder->ReadCursor == decoder->FinalByte && !decoder->atend())
+        {   // attempt to obtain additional input data.
+            switch (decoder->refill(decoder))
+            {
+            case STREAM_REFILL_RESULT_START:
+                break;
+            case STREAM_REFILL_RESULT_YIELD:
+                return KTX_PARSE_RESULT_CONTINUE;
+            case STREAM_REFILL_RESULT_ERROR:
+                ktxp->CurrentState = KTX_PARSE_STATE_ERROR;
+                ktxp->ParserError  = KTX_PARSE_ERROR_DECODER;
+                return KTX_PARSE_RESULT_ERROR;
+            }
+        }
+        // perform a state update, which may consume zero or more bytes.
+        uint8_t *cursor = decoder->ReadCursor;
+        int      s      = ktxp->CurrentState;
+        switch (ktxp->CurrentState)
+        {
+        case KTX_PARSE_STATE_SEEK_OFFSET:
+            s = ktx_seek_offset(decoder, ktxp, ktxp->Encoder);
+            break;
+        case KTX_PARSE_STATE_BUFFER_IDENTIFIER:
+            s = ktx_buffer_identifier(decoder, ktxp, ktxp->Encoder);
+            break;
+        case KTX_PARSE_STATE_BUFFER_HEADER:
+            s = ktx_buffer_header(decoder, ktxp, ktxp->Encoder);
+            break;
+        case KTX_PARSE_STATE_BUFFER_LEVEL_INDEX:
+            s = ktx_buffer_level_index(decoder, ktxp, ktxp->Encoder);
+            break;
+        case KTX_PARSE_STATE_BUFFER_DFD:
+            s = ktx_buffer_dfd(decoder, ktxp, ktxp->Encoder);
+            break;
+        case KTX_PARSE_STATE_SKIP_DATA:
+            s = ktx_skip_data(decoder, ktxp, ktxp->Encoder);
+            break;
+        case KTX_PARSE_STATE_LEVEL_SIZE:
+            s = ktx_level_size(decoder, ktxp, ktxp->Encoder);
+            break;
+        case KTX_PARSE_STATE_LEVEL_DATA:
+            s = ktx_level_data(decoder, ktxp, ktxp->Encoder);
+            break;
+        default:
+            break;
+        }
+        if (s == ktxp->CurrentState && cursor == decoder->ReadCursor && decoder->atend())
+        {   // the state needs more data, but the stream has ended.
+            s = KTX_PARSE_STATE_ERROR;
+            ktxp->ParserError = KTX_PARSE_ERROR_BAD_DATA;
+        }
+        ktxp->CurrentState = s;
+    }
+    return KTX_PARSE_RESULT_COMPLETE;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initializes or resets the state of a streaming KTX parser.
+/// @param ktxp The streaming KTX parser state to initialize.
+/// @param config Parser configuration data indicating what portions of the file to parse.
+public_function void ktx_parser_state_init(ktx_parser_state_t *ktxp, image_parser_config_t const &config)
+{
+    ktxp->CurrentState     = KTX_PARSE_STATE_SEEK_OFFSET;
+    ktxp->ParserError      = KTX_PARSE_ERROR_SUCCESS;
+    ktxp->Config           = config;
+    ktxp->Encoder          = NULL;
+    ktxp->Metadata         = config.Metadata;
+    ktxp->ZstdReady        = false;
+    ktxp->InflateReady     = false;
+    ktxp->Version          = 0;
+    ktxp->Format           = DXGI_FORMAT_UNKNOWN;
+    ktxp->AlphaMode        = DDS_ALPHA_MODE_UNKNOWN;
+    ktxp->Supercompression = KTX_SUPERCOMPRESSION_NONE;
+    ktxp->Width            = 0;
+    ktxp->Height           = 0;
+    ktxp->Depth            = 0;
+    ktxp->LayerCount       = 0;
+    ktxp->FaceCount        = 0;
+    ktxp->LevelCount       = 0;
+    ktxp->ElementCount     = 0;
+    ktxp->KeyValueSize     = 0;
+    ktxp->FaceImageSize    = false;
+    ktxp->DFDOffset        = 0;
+    ktxp->DFDSize          = 0;
+    ktxp->FilePos          = 0;
+    ktxp->SkipRemain       = 0;
+    ktxp->SkipState        = KTX_PARSE_STATE_ERROR;
+    ktxp->HeaderWritePos   = 0;
+    ktxp->ElementFirst     = 0;
+    ktxp->ElementFinal     = 0;
+    ktxp->ElementIndex     = 0;
+    ktxp->LevelIndex       = 0;
+    ktxp->LevelInfo        = NULL;
+    ktxp->ReceiveRank      = 0;
+    ktxp->ReceiveLevel     = 0;
+    ktxp->ReceiveElement   = 0;
+    ktxp->ReceiveOffset    = 0;
+    ktxp->LevelRemain      = 0;
+    ktxp->LevelFill        = 0;
+    ktxp->LevelBufferSize  = 0;
+    ktxp->LevelOutputSize  = 0;
+    ktxp->LevelBuffer      = NULL;
+    ktxp->LevelOutput      = NULL;
+    ktxp->RowSize          = 0;
+    ktxp->RowPitch         = 0;
+    ktxp->RowPos           = 0;
+    for (size_t i = 0; i < KTX_MAX_LEVELS; ++i)
+    {
+        ktxp->LevelOrder[i] = uint8_t(i);
+        ktxp->LevelRank [i] = uint8_t(i);
+        ktxp->Stage     [i] = NULL;
+    }
+}
+
+/// @summary Frees any locally-allocated resources for a parser instance.
+/// @param ktxp The streaming KTX parser state to clean up.
+public_function void ktx_parser_state_cleanup(ktx_parser_state_t *ktxp)
+{
+    if (ktxp->ZstdReady)
+    {
+        zstd_delete(&ktxp->Zstd);
+        ktxp->ZstdReady = false;
+    }
+    if (ktxp->InflateReady)
+    {
+        inflate_delete(&ktxp->Inflate);
+        ktxp->InflateReady = false;
+    }
+    for (size_t i = 0; i < KTX_MAX_LEVELS; ++i)
+    {
+        free(ktxp->Stage[i]);
+        ktxp->Stage[i] = NULL;
+    }
+    free(ktxp->LevelOutput); ktxp->LevelOutput = NULL;
+    free(ktxp->LevelBuffer); ktxp->LevelBuffer = NULL;
+    if (ktxp->Encoder != NULL)
+    {
+        delete  ktxp->Encoder;
+        ktxp->Encoder  = NULL;
+    }
+}
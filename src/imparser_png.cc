@@ -0,0 +1,1106 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a streaming parser for PNG files. The parser consumes
+/// the file in whatever chunks the stream decoder produces; only the small
+/// header chunks are buffered. IDAT data is passed through a resumable zlib
+/// decoder, and each scanline is unfiltered and converted to a DXGI format as
+/// soon as it is complete, then written to the image encoder. Interlaced
+/// images and chunk CRCs are not supported; the CRCs are skipped.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <emmintrin.h>
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The size of the PNG file signature, in bytes.
+#define PNG_SIGNATURE_SIZE        8
+
+/// @summary The size of the length and type fields at the start of each chunk, in bytes.
+#define PNG_CHUNK_HEADER_SIZE     8
+
+/// @summary The size of the CRC field at the end of each chunk, in bytes.
+#define PNG_CHUNK_CRC_SIZE        4
+
+/// @summary The size of the buffer used for the header chunks. The largest is a 256-entry PLTE.
+#define PNG_CHUNK_BUFFER_SIZE     768
+
+/// @summary The number of zero bytes before and after each row buffer, so that filters can read the pixel to the left of the first pixel, and SIMD loops can run past the last pixel.
+#define PNG_ROW_PADDING           16
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define identifiers for the recognized parser states.
+enum png_parser_state_e : int
+{
+    PNG_PARSE_STATE_SEEK_OFFSET          = 0,   /// The parser is looking for a known byte offset.
+    PNG_PARSE_STATE_BUFFER_SIGNATURE     = 1,   /// The parser is receiving the file signature.
+    PNG_PARSE_STATE_CHUNK_HEADER         = 2,   /// The parser is receiving the length and type of the next chunk.
+    PNG_PARSE_STATE_BUFFER_CHUNK         = 3,   /// The parser is receiving the data of a header chunk.
+    PNG_PARSE_STATE_SKIP_CHUNK           = 4,   /// The parser is skipping chunk data and CRCs.
+    PNG_PARSE_STATE_IMAGE_DATA           = 5,   /// The parser is decompressing IDAT data and encoding scanlines.
+    PNG_PARSE_STATE_COMPLETE             = 6,   /// The parser has processed the entire file contents.
+    PNG_PARSE_STATE_ERROR                = 7    /// The parser has encountered a fatal error.
+};
+
+/// @summary Define identifiers for the recognized parser errors.
+enum png_parser_error_e : int
+{
+    PNG_PARSE_ERROR_SUCCESS              = 0,   /// No error has occurred.
+    PNG_PARSE_ERROR_NOMEMORY             = 1,   /// Required memory could not be allocated.
+    PNG_PARSE_ERROR_DECODER              = 2,   /// The underlying stream decoder returned an error.
+    PNG_PARSE_ERROR_NOENCODER            = 3,   /// No encoder was found that supports the required transcoding.
+    PNG_PARSE_ERROR_ENCODER              = 4,   /// The image encoder returned an error.
+    PNG_PARSE_ERROR_BAD_DATA             = 5,   /// The file is not a valid PNG, or is truncated.
+    PNG_PARSE_ERROR_UNSUPPORTED          = 6,   /// The file uses a feature the parser doesn't support.
+};
+
+/// @summary Define the possible return codes from the top-level streaming parser update function.
+enum png_parser_result_e : int
+{
+    PNG_PARSE_RESULT_CONTINUE            = 0,   /// The parser is yielding, waiting for more data.
+    PNG_PARSE_RESULT_COMPLETE            = 1,   /// Stop parsing. All data was parsed successfully.
+    PNG_PARSE_RESULT_ERROR               = 2    /// Stop parsing. An error was encountered.
+};
+
+/// @summary Define the PNG color types specified in the IHDR chunk.
+enum png_color_type_e : uint8_t
+{
+    PNG_COLOR_TYPE_GRAY                  = 0,   /// Grayscale samples.
+    PNG_COLOR_TYPE_RGB                   = 2,   /// Red, green and blue samples.
+    PNG_COLOR_TYPE_PALETTE               = 3,   /// Indices into the PLTE chunk.
+    PNG_COLOR_TYPE_GRAY_ALPHA            = 4,   /// Grayscale and alpha samples.
+    PNG_COLOR_TYPE_RGB_ALPHA             = 6,   /// Red, green, blue and alpha samples.
+};
+
+/// @summary Define the PNG scanline filter types.
+enum png_filter_e : uint8_t
+{
+    PNG_FILTER_NONE                      = 0,   /// The row is stored unfiltered.
+    PNG_FILTER_SUB                       = 1,   /// Each byte is predicted from the pixel to the left.
+    PNG_FILTER_UP                        = 2,   /// Each byte is predicted from the pixel above.
+    PNG_FILTER_AVERAGE                   = 3,   /// Each byte is predicted from the average of the pixels to the left and above.
+    PNG_FILTER_PAETH                     = 4,   /// Each byte is predicted from the left, above or upper-left pixel.
+};
+
+/// @summary Define the conversions from unfiltered PNG scanlines to DXGI formats.
+enum png_convert_e : int
+{
+    PNG_CONVERT_COPY                     = 0,   /// 8-bit samples are written as-is.
+    PNG_CONVERT_SWAP16                   = 1,   /// Big-endian 16-bit samples are byte-swapped.
+    PNG_CONVERT_GRAY_BITS                = 2,   /// 1, 2 or 4-bit grayscale samples are expanded to 8 bits.
+    PNG_CONVERT_RGB8                     = 3,   /// 8-bit RGB pixels are expanded to RGBA.
+    PNG_CONVERT_RGB16                    = 4,   /// 16-bit RGB pixels are byte-swapped and expanded to RGBA.
+    PNG_CONVERT_PALETTE                  = 5,   /// Palette indices are expanded to RGBA.
+};
+
+/// @summary Define the state data associated with a streaming PNG file parser.
+struct png_parser_state_t
+{
+    int                   CurrentState;         /// One of png_parser_state_e.
+    int                   ParserError;          /// One of png_parser_error_e.
+    image_parser_config_t Config;               /// The input parser configuration.
+    image_encoder_t      *Encoder;              /// The local image encoder. Deleted on error or completion.
+    image_definition_t   *Metadata;             /// Pointer to the image metadata block.
+    inflate_t             Inflate;              /// The decoder for the zlib stream formed by the IDAT chunks.
+    bool                  InflateReady;         /// true if the Inflate buffers have been allocated.
+    bool                  HaveHeader;           /// true if the IHDR chunk has been received.
+    bool                  HaveSRGB;             /// true if an sRGB chunk has been received.
+    bool                  HaveTransparency;     /// true if a tRNS chunk has been received.
+    uint32_t              ChunkType;            /// The FourCC of the current chunk.
+    size_t                ChunkSize;            /// The size of the data of the current chunk, in bytes.
+    size_t                ChunkRemain;          /// The number of bytes of chunk data remaining to be consumed or skipped.
+    size_t                HeaderWritePos;       /// The current write position in HeaderBuffer.
+    size_t                ChunkWritePos;        /// The current write position in ChunkBuffer.
+    size_t                Width;                /// The image width, in pixels.
+    size_t                Height;               /// The image height, in pixels.
+    uint8_t               BitDepth;             /// The number of bits per sample or palette index.
+    uint8_t               ColorType;            /// One of png_color_type_e.
+    uint8_t               RowFilter;            /// The png_filter_e of the row being received.
+    int                   Conversion;           /// One of png_convert_e.
+    uint32_t              Format;               /// One of dxgi_format_e specifying the format of the encoded pixel data.
+    size_t                FilterStride;         /// The distance between corresponding bytes of adjacent pixels, at least 1.
+    size_t                RowSize;              /// The size of an unfiltered row, not including the filter type byte.
+    size_t                RowFill;              /// The number of bytes of the current row received, including the filter type byte.
+    size_t                RowIndex;             /// The zero-based index of the row being received.
+    size_t                OutputRowSize;        /// The size of a converted row, in bytes.
+    uint8_t              *RowMemory;            /// The allocation containing the row buffers.
+    uint8_t              *PriorRow;             /// The previous unfiltered row, or zeroes.
+    uint8_t              *CurrentRow;           /// The row being received and unfiltered.
+    uint8_t              *OutputRow;            /// The converted row.
+    uint16_t              TransparentKey[3];    /// The gray or RGB sample values that are fully transparent, if HaveTransparency is set.
+    uint32_t              Palette[256];         /// The palette as R8G8B8A8 values.
+    uint8_t               HeaderBuffer[PNG_CHUNK_HEADER_SIZE]; /// Internal buffer for the signature and chunk headers.
+    uint8_t               ChunkBuffer[PNG_CHUNK_BUFFER_SIZE];  /// Internal buffer for the data of header chunks.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The eight bytes at the start of every PNG file.
+global_variable uint8_t const PNG_SIGNATURE[PNG_SIGNATURE_SIZE] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Reads a big-endian 32-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint32_t png_u32(uint8_t const *p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+/// @summary Reads a big-endian 16-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint16_t png_u16(uint8_t const *p)
+{
+    return uint16_t((p[0] << 8) | p[1]);
+}
+
+/// @summary Loads one pixel of BPP bytes into the low bytes of a register. Pixels of 3 and 6 bytes are loaded together with the bytes that follow them, which are ignored; the row buffers are padded so this never reads past the end of the buffer.
+/// @param p The first byte of the pixel.
+/// @return The pixel bytes.
+template <size_t BPP>
+internal_function inline __m128i png_load_pixel(uint8_t const *p)
+{
+    if (BPP <= 4)
+    {
+        uint32_t v; memcpy(&v, p, sizeof(uint32_t));
+        return _mm_cvtsi32_si128(int(v));
+    }
+    return _mm_loadl_epi64((__m128i const*) p);
+}
+
+/// @summary Stores the BPP low bytes of a register as one pixel, without touching the bytes that follow it.
+/// @param p The first byte of the pixel.
+/// @param x The pixel bytes.
+template <size_t BPP>
+internal_function inline void png_store_pixel(uint8_t *p, __m128i x)
+{
+    uint32_t lo = uint32_t(_mm_cvtsi128_si32(x));
+    if (BPP == 3)
+    {
+        memcpy(p, &lo, 3);
+    }
+    else if (BPP == 4)
+    {
+        memcpy(p, &lo, 4);
+    }
+    else if (BPP == 6)
+    {
+        uint16_t hi = uint16_t(_mm_extract_epi16(x, 2));
+        memcpy(p + 0, &lo, 4);
+        memcpy(p + 4, &hi, 2);
+    }
+    else
+    {
+        _mm_storel_epi64((__m128i*) p, x);
+    }
+}
+
+/// @summary Reverses the Sub filter for rows whose pixels are BPP bytes. Each pixel depends on the previous one, so pixels are processed one at a time, with all bytes of a pixel in parallel.
+/// @param row The row to unfilter in place.
+/// @param size The size of the row, in bytes.
+template <size_t BPP>
+internal_function void png_unfilter_sub(uint8_t *row, size_t size)
+{
+    __m128i a = _mm_setzero_si128();
+    for (size_t i = 0; i < size; i += BPP)
+    {
+        a = _mm_add_epi8(a, png_load_pixel<BPP>(row + i));
+        png_store_pixel<BPP>(row + i, a);
+    }
+}
+
+/// @summary Reverses the Average filter for rows whose pixels are BPP bytes. _mm_avg_epu8 rounds up, so the carry is subtracted to get floor((a + b) / 2).
+/// @param row The row to unfilter in place.
+/// @param prior The previous unfiltered row.
+/// @param size The size of the row, in bytes.
+template <size_t BPP>
+internal_function void png_unfilter_average(uint8_t *row, uint8_t const *prior, size_t size)
+{
+    __m128i const one = _mm_set1_epi8(1);
+    __m128i       a   = _mm_setzero_si128();
+    for (size_t i = 0; i < size; i += BPP)
+    {
+        __m128i b   = png_load_pixel<BPP>(prior + i);
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_add_epi8(png_load_pixel<BPP>(row + i), avg);
+        png_store_pixel<BPP>(row + i, a);
+    }
+}
+
+/// @summary Computes the absolute value of signed 16-bit lanes using SSE2.
+/// @param x The input values.
+/// @return The absolute values.
+internal_function inline __m128i png_abs_epi16(__m128i x)
+{
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+/// @summary Reverses the Paeth filter for rows whose pixels are BPP bytes. The predictor is evaluated in 16-bit lanes so the intermediate sums don't overflow.
+/// @param row The row to unfilter in place.
+/// @param prior The previous unfiltered row.
+/// @param size The size of the row, in bytes.
+template <size_t BPP>
+internal_function void png_unfilter_paeth(uint8_t *row, uint8_t const *prior, size_t size)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i       a    = zero;
+    __m128i       c    = zero;
+    for (size_t i = 0; i < size; i += BPP)
+    {
+        __m128i b  = _mm_unpacklo_epi8(png_load_pixel<BPP>(prior + i), zero);
+        __m128i x  = png_load_pixel<BPP>(row + i);
+        // pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|.
+        __m128i pa = _mm_sub_epi16(b, c);
+        __m128i pb = _mm_sub_epi16(a, c);
+        __m128i pc = _mm_add_epi16(pa, pb);
+        pa = png_abs_epi16(pa);
+        pb = png_abs_epi16(pb);
+        pc = png_abs_epi16(pc);
+        // select a, then b, then c, in that order of preference.
+        __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+        __m128i mask_c   = _mm_cmpeq_epi16(smallest, pc);
+        __m128i mask_b   = _mm_cmpeq_epi16(smallest, pb);
+        __m128i mask_a   = _mm_cmpeq_epi16(smallest, pa);
+        __m128i nearest  = _mm_or_si128(_mm_and_si128(mask_c, c), _mm_andnot_si128(mask_c, b));
+        nearest = _mm_or_si128(_mm_and_si128(mask_b, b), _mm_andnot_si128(mask_b, nearest));
+        nearest = _mm_or_si128(_mm_and_si128(mask_a, a), _mm_andnot_si128(mask_a, nearest));
+        x = _mm_add_epi8(x, _mm_packus_epi16(nearest, nearest));
+        png_store_pixel<BPP>(row + i, x);
+        a = _mm_unpacklo_epi8(x, zero);
+        c = b;
+    }
+}
+
+/// @summary Computes the Paeth predictor for a single byte.
+/// @param a The byte to the left.
+/// @param b The byte above.
+/// @param c The byte above and to the left.
+/// @return The predicted value.
+internal_function inline uint8_t png_paeth(int a, int b, int c)
+{
+    int p  = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return uint8_t(a);
+    if (pb <= pc) return uint8_t(b);
+    return uint8_t(c);
+}
+
+/// @summary Reverses the filter applied to a row one byte at a time. Used for rows whose pixels are one or two bytes, where there's little parallelism within a pixel.
+/// @param filter One of png_filter_e.
+/// @param row The row to unfilter in place. The PNG_ROW_PADDING bytes before the row must be zero.
+/// @param prior The previous unfiltered row. The PNG_ROW_PADDING bytes before the row must be zero.
+/// @param size The size of the row, in bytes.
+/// @param bpp The distance between corresponding bytes of adjacent pixels.
+internal_function void png_unfilter_bytes(uint8_t filter, uint8_t *row, uint8_t const *prior, size_t size, size_t bpp)
+{
+    switch (filter)
+    {
+    case PNG_FILTER_SUB:
+        for (size_t i = 0; i < size; ++i)
+            row[i] = uint8_t(row[i] + row[i - bpp]);
+        break;
+    case PNG_FILTER_AVERAGE:
+        for (size_t i = 0; i < size; ++i)
+            row[i] = uint8_t(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+        break;
+    case PNG_FILTER_PAETH:
+        for (size_t i = 0; i < size; ++i)
+            row[i] = uint8_t(row[i] + png_paeth(row[i - bpp], prior[i], prior[i - bpp]));
+        break;
+    default:
+        break;
+    }
+}
+
+/// @summary Reverses the filter applied to a row for pixels of BPP bytes.
+/// @param filter One of PNG_FILTER_SUB, PNG_FILTER_AVERAGE or PNG_FILTER_PAETH.
+/// @param row The row to unfilter in place.
+/// @param prior The previous unfiltered row.
+/// @param size The size of the row, in bytes.
+template <size_t BPP>
+internal_function void png_unfilter_pixels(uint8_t filter, uint8_t *row, uint8_t const *prior, size_t size)
+{
+    switch (filter)
+    {
+    case PNG_FILTER_SUB:
+        png_unfilter_sub<BPP>(row, size);
+        break;
+    case PNG_FILTER_AVERAGE:
+        png_unfilter_average<BPP>(row, prior, size);
+        break;
+    case PNG_FILTER_PAETH:
+        png_unfilter_paeth<BPP>(row, prior, size);
+        break;
+    default:
+        break;
+    }
+}
+
+/// @summary Reverses the filter applied to a row.
+/// @param filter One of png_filter_e.
+/// @param row The row to unfilter in place. The row buffer must be padded with PNG_ROW_PADDING zero bytes at each end.
+/// @param prior The previous unfiltered row, padded in the same way as row.
+/// @param size The size of the row, in bytes.
+/// @param bpp The distance between corresponding bytes of adjacent pixels.
+internal_function void png_unfilter_row(uint8_t filter, uint8_t *row, uint8_t const *prior, size_t size, size_t bpp)
+{
+    if (filter == PNG_FILTER_NONE)
+    {   // nothing to do.
+        return;
+    }
+    if (filter == PNG_FILTER_UP)
+    {   // there's no dependency between bytes in the row, so process 16 at a time.
+        for (size_t i = 0; i < size; i += 16)
+        {
+            __m128i x = _mm_loadu_si128((__m128i const*)(row   + i));
+            __m128i b = _mm_loadu_si128((__m128i const*)(prior + i));
+            _mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(x, b));
+        }
+        return;
+    }
+    switch (bpp)
+    {
+    case 3: png_unfilter_pixels<3>(filter, row, prior, size); break;
+    case 4: png_unfilter_pixels<4>(filter, row, prior, size); break;
+    case 6: png_unfilter_pixels<6>(filter, row, prior, size); break;
+    case 8: png_unfilter_pixels<8>(filter, row, prior, size); break;
+    default:png_unfilter_bytes(filter, row, prior, size, bpp); break;
+    }
+}
+
+/// @summary Converts an unfiltered row to the encoded pixel format.
+/// @param pngp The PNG parser state, with CurrentRow holding the unfiltered row.
+/// @return A pointer to the converted row, which is either CurrentRow or OutputRow.
+internal_function uint8_t const* png_convert_row(png_parser_state_t *pngp)
+{
+    uint8_t const *src   = pngp->CurrentRow;
+    uint8_t       *dst   = pngp->OutputRow;
+    size_t  const  width = pngp->Width;
+    switch (pngp->Conversion)
+    {
+    case PNG_CONVERT_SWAP16:
+        {
+            for (size_t i = 0; i < pngp->RowSize; i += 16)
+            {
+                __m128i x = _mm_loadu_si128((__m128i const*)(src + i));
+                _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+            }
+        }
+        return dst;
+    case PNG_CONVERT_GRAY_BITS:
+        {
+            size_t   bits  = pngp->BitDepth;
+            uint32_t mask  =(1U << bits) - 1;
+            uint32_t scale = 255 / mask;
+            for (size_t x  = 0; x < width; ++x)
+            {
+                size_t bit = x * bits;
+                dst[x] = uint8_t(((src[bit >> 3] >> (8 - bits - (bit & 7))) & mask) * scale);
+            }
+        }
+        return dst;
+    case PNG_CONVERT_RGB8:
+        {
+            uint32_t *out = (uint32_t*) dst;
+            uint32_t  key = 0xFFFFFFFFU;
+            if (pngp->HaveTransparency)
+            {   // pixels matching the key become fully transparent.
+                key = uint32_t(pngp->TransparentKey[0] & 0xFF) | (uint32_t(pngp->TransparentKey[1] & 0xFF) << 8) | (uint32_t(pngp->TransparentKey[2] & 0xFF) << 16);
+            }
+            for (size_t x = 0; x < width; ++x)
+            {   // the row padding allows a four-byte read at the last pixel.
+                uint32_t v; memcpy(&v, src + x * 3, sizeof(uint32_t));
+                v &= 0x00FFFFFFU;
+                out[x] = (v == key) ? v : (v | 0xFF000000U);
+            }
+        }
+        return dst;
+    case PNG_CONVERT_RGB16:
+        {
+            uint16_t *out = (uint16_t*) dst;
+            for (size_t x = 0; x < width; ++x)
+            {
+                uint16_t r = png_u16(src + x * 6 + 0);
+                uint16_t g = png_u16(src + x * 6 + 2);
+                uint16_t b = png_u16(src + x * 6 + 4);
+                bool     t = pngp->HaveTransparency && r == pngp->TransparentKey[0] && g == pngp->TransparentKey[1] && b == pngp->TransparentKey[2];
+                out[x * 4 + 0] = r;
+                out[x * 4 + 1] = g;
+                out[x * 4 + 2] = b;
+                out[x * 4 + 3] = t ? 0 : 0xFFFF;
+            }
+        }
+        return dst;
+    case PNG_CONVERT_PALETTE:
+        {
+            uint32_t *out = (uint32_t*) dst;
+            if (pngp->BitDepth == 8)
+            {   // the common case - one index per byte.
+                for (size_t x = 0; x < width; ++x)
+                    out[x] = pngp->Palette[src[x]];
+            }
+            else
+            {
+                size_t   bits = pngp->BitDepth;
+                uint32_t mask =(1U << bits) - 1;
+                for (size_t x = 0; x < width; ++x)
+                {
+                    size_t bit = x * bits;
+                    out[x] = pngp->Palette[(src[bit >> 3] >> (8 - bits - (bit & 7))) & mask];
+                }
+            }
+        }
+        return dst;
+    default:
+        break;
+    }
+    return src;
+}
+
+/// @summary Consumes decompressed IDAT data, unfiltering, converting and encoding each row as it is completed.
+/// @param pngp The PNG parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return true if the data was consumed, or false if the data is invalid or the encoder returned an error.
+internal_function bool png_receive_rows(png_parser_state_t *pngp, image_encoder_t *encoder)
+{
+    size_t         avail = 0;
+    size_t         used  = 0;
+    uint8_t const *data  = inflate_output(&pngp->Inflate, avail);
+    while (used < avail && pngp->RowIndex < pngp->Height)
+    {
+        if (pngp->RowFill == 0)
+        {   // each row starts with the filter type.
+            if ((pngp->RowFilter = data[used++]) > PNG_FILTER_PAETH)
+            {
+                pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+                return false;
+            }
+            pngp->RowFill = 1;
+            continue;
+        }
+        size_t need  = pngp->RowSize + 1 - pngp->RowFill;
+        size_t count =(avail - used < need) ? avail - used : need;
+        memcpy(pngp->CurrentRow + pngp->RowFill - 1, data + used, count);
+        pngp->RowFill += count;
+        used          += count;
+        if (count == need)
+        {   // the row is complete.
+            png_unfilter_row(pngp->RowFilter, pngp->CurrentRow, pngp->PriorRow, pngp->RowSize, pngp->FilterStride);
+            uint8_t const *row = png_convert_row(pngp);
+            if (encoder->encode(0, row, pngp->OutputRowSize) != ERROR_SUCCESS)
+            {
+                pngp->ParserError = PNG_PARSE_ERROR_ENCODER;
+                return false;
+            }
+            uint8_t *prior   = pngp->PriorRow;
+            pngp->PriorRow   = pngp->CurrentRow;
+            pngp->CurrentRow = prior;
+            pngp->RowFill    = 0;
+            pngp->RowIndex++;
+        }
+    }
+    inflate_consume(&pngp->Inflate, used);
+    return true;
+}
+
+/// @summary Validates the IHDR chunk and determines the format of the encoded pixel data.
+/// @param pngp The PNG parser state, with the chunk data in ChunkBuffer.
+/// @return The new parser state.
+internal_function int png_process_header(png_parser_state_t *pngp)
+{
+    uint8_t const *data = pngp->ChunkBuffer;
+    if (pngp->ChunkSize != 13 || pngp->HaveHeader)
+    {   // IHDR is always 13 bytes, and appears once.
+        pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    pngp->Width      = png_u32(data + 0);
+    pngp->Height     = png_u32(data + 4);
+    pngp->BitDepth   = data[8];
+    pngp->ColorType  = data[9];
+    pngp->HaveHeader = true;
+    if (pngp->Width == 0 || pngp->Height == 0 || pngp->Width > 0x7FFFFFFF || pngp->Height > 0x7FFFFFFF || data[10] != 0 || data[11] != 0)
+    {   // invalid dimensions, or an unknown compression or filter method.
+        pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    if (data[12] != 0)
+    {   // Adam7 interlacing would require buffering the whole image.
+        pngp->ParserError = PNG_PARSE_ERROR_UNSUPPORTED;
+        return PNG_PARSE_STATE_ERROR;
+    }
+
+    size_t  depth    = pngp->BitDepth;
+    size_t  channels = 0;
+    bool    valid    = false;
+    switch (pngp->ColorType)
+    {
+    case PNG_COLOR_TYPE_GRAY:
+        channels = 1;
+        valid    = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+        pngp->Format     = depth == 16 ? DXGI_FORMAT_R16_UNORM : DXGI_FORMAT_R8_UNORM;
+        pngp->Conversion = depth == 16 ? PNG_CONVERT_SWAP16 : (depth == 8 ? PNG_CONVERT_COPY : PNG_CONVERT_GRAY_BITS);
+        break;
+    case PNG_COLOR_TYPE_RGB:
+        channels = 3;
+        valid    = depth == 8 || depth == 16;
+        pngp->Format     = depth == 16 ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+        pngp->Conversion = depth == 16 ? PNG_CONVERT_RGB16 : PNG_CONVERT_RGB8;
+        break;
+    case PNG_COLOR_TYPE_PALETTE:
+        channels = 1;
+        valid    = depth == 1 || depth == 2 || depth == 4 || depth == 8;
+        pngp->Format     = DXGI_FORMAT_R8G8B8A8_UNORM;
+        pngp->Conversion = PNG_CONVERT_PALETTE;
+        break;
+    case PNG_COLOR_TYPE_GRAY_ALPHA:
+        channels = 2;
+        valid    = depth == 8 || depth == 16;
+        pngp->Format     = depth == 16 ? DXGI_FORMAT_R16G16_UNORM : DXGI_FORMAT_R8G8_UNORM;
+        pngp->Conversion = depth == 16 ? PNG_CONVERT_SWAP16 : PNG_CONVERT_COPY;
+        break;
+    case PNG_COLOR_TYPE_RGB_ALPHA:
+        channels = 4;
+        valid    = depth == 8 || depth == 16;
+        pngp->Format     = depth == 16 ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+        pngp->Conversion = depth == 16 ? PNG_CONVERT_SWAP16 : PNG_CONVERT_COPY;
+        break;
+    default:
+        break;
+    }
+    if (!valid)
+    {   // the color type or bit depth isn't allowed by the specification.
+        pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    pngp->FilterStride  = image_max2<size_t>(1, channels * depth / 8);
+    pngp->RowSize       =(pngp->Width * channels * depth + 7) / 8;
+    pngp->OutputRowSize = dxgi_pitch(pngp->Format, pngp->Width);
+    return PNG_PARSE_STATE_SKIP_CHUNK;
+}
+
+/// @summary Processes a buffered header chunk.
+/// @param pngp The PNG parser state, with the chunk data in ChunkBuffer.
+/// @return The new parser state.
+internal_function int png_process_chunk(png_parser_state_t *pngp)
+{
+    uint8_t const *data = pngp->ChunkBuffer;
+    size_t  const  size = pngp->ChunkSize;
+    if (pngp->ChunkType == image_fourcc_le('I','H','D','R'))
+    {
+        return png_process_header(pngp);
+    }
+    if (pngp->ChunkType == image_fourcc_le('P','L','T','E'))
+    {   // entries not set by tRNS are opaque.
+        if (size % 3 != 0)
+        {
+            pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+            return PNG_PARSE_STATE_ERROR;
+        }
+        for (size_t i = 0, n = size / 3; i < n; ++i)
+        {
+            pngp->Palette[i] = uint32_t(data[i * 3 + 0]) | (uint32_t(data[i * 3 + 1]) << 8) | (uint32_t(data[i * 3 + 2]) << 16) | 0xFF000000U;
+        }
+        return PNG_PARSE_STATE_SKIP_CHUNK;
+    }
+    if (pngp->ChunkType == image_fourcc_le('t','R','N','S'))
+    {   // tRNS follows PLTE, and stores either palette alpha or a transparent color.
+        if (pngp->ColorType == PNG_COLOR_TYPE_PALETTE && size <= 256)
+        {
+            for (size_t i = 0; i < size; ++i)
+                pngp->Palette[i] = (pngp->Palette[i] & 0x00FFFFFFU) | (uint32_t(data[i]) << 24);
+            pngp->HaveTransparency = true;
+        }
+        else if (pngp->ColorType == PNG_COLOR_TYPE_RGB && size == 6)
+        {
+            pngp->TransparentKey[0] = png_u16(data + 0);
+            pngp->TransparentKey[1] = png_u16(data + 2);
+            pngp->TransparentKey[2] = png_u16(data + 4);
+            pngp->HaveTransparency  = true;
+        }
+        // there's no alpha channel to put a grayscale key in, so it's ignored.
+        return PNG_PARSE_STATE_SKIP_CHUNK;
+    }
+    if (pngp->ChunkType == image_fourcc_le('s','R','G','B'))
+    {
+        pngp->HaveSRGB = true;
+        return PNG_PARSE_STATE_SKIP_CHUNK;
+    }
+    return PNG_PARSE_STATE_SKIP_CHUNK;
+}
+
+/// @summary Calculates all of the static data and allocates the row buffers once the first IDAT chunk is reached.
+/// @param pngp The parser state to update.
+/// @return The new parser state.
+internal_function int png_parser_setup_image_info(png_parser_state_t *pngp)
+{
+    image_definition_t *meta  = pngp->Metadata;
+    uint32_t            alpha = DDS_ALPHA_MODE_OPAQUE;
+    if (pngp->ColorType == PNG_COLOR_TYPE_GRAY_ALPHA || pngp->ColorType == PNG_COLOR_TYPE_RGB_ALPHA || (pngp->HaveTransparency && pngp->ColorType != PNG_COLOR_TYPE_GRAY))
+    {   // the alpha channel carries data.
+        alpha = DDS_ALPHA_MODE_STRAIGHT;
+    }
+    if (pngp->HaveSRGB && pngp->Format == DXGI_FORMAT_R8G8B8A8_UNORM)
+    {   // the color channels are stored sRGB-encoded.
+        pngp->Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    }
+    if (pngp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // completely initialize the metadata block with information we've read.
+        dds_header_t       dds;
+        dds_header_dxt10_t dx10;
+        dds_headers_for_image(&dds, &dx10, pngp->Format, pngp->Width, pngp->Height, alpha);
+        if (!dds_image_definition(meta, pngp->Config.ImageId, &dds, &dx10, pngp->Config.Compression, pngp->Config.Encoding))
+        {   // unable to allocate storage for the mip-level descriptors and offsets.
+            pngp->ParserError = PNG_PARSE_ERROR_NOMEMORY;
+            return PNG_PARSE_STATE_ERROR;
+        }
+    }
+
+    // create the image encoder instance.
+    pngp->Encoder = create_image_encoder(
+        pngp->Config.ImageId,
+        pngp->Config.Memory,
+        IMAGE_COMPRESSION_NONE,
+        IMAGE_ENCODING_RAW,
+        pngp->Config.Compression,
+        pngp->Config.Encoding,
+        dds_access_type(meta),
+        pngp->Config.DefinitionQueue,
+        pngp->Config.DefinitionAlloc,
+        pngp->Config.PlacementQueue,
+        pngp->Config.PlacementAlloc,
+        meta->ImageFormat,
+        pngp->Config.Format,
+        pngp->Config.Quality,
+        pngp->Config.WorkPool,
+        pngp->Config.EncoderFlags);
+    if (pngp->Encoder == NULL)
+    {   // unable to create the encoder to write to image memory.
+        pngp->ParserError = PNG_PARSE_ERROR_NOENCODER;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    if (pngp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // notify the encoder of the image attributes:
+        if (pngp->Encoder->define_image(meta) != ERROR_SUCCESS)
+        {
+            pngp->ParserError = PNG_PARSE_ERROR_ENCODER;
+            return PNG_PARSE_STATE_ERROR;
+        }
+    }
+    else
+    {   // the image is already defined, but encoders that change the format need the source attributes.
+        pngp->Encoder->Metadata = meta;
+    }
+
+    // a PNG file stores a single image element.
+    if ((pngp->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_PIXELS) == 0 || pngp->Config.FirstFrame >= meta->ElementCount)
+    {   // not reading any pixel data, so we're done.
+        return PNG_PARSE_STATE_COMPLETE;
+    }
+
+    // allocate the decompressor and three padded row buffers: the prior row, the current row and the converted row.
+    size_t row_bytes  = image_max2<size_t>(pngp->RowSize, pngp->OutputRowSize);
+    size_t row_stride = PNG_ROW_PADDING + ((row_bytes + 15) & ~size_t(15)) + PNG_ROW_PADDING;
+    if ((pngp->RowMemory = (uint8_t*) malloc(row_stride * 3)) == NULL)
+    {
+        pngp->ParserError = PNG_PARSE_ERROR_NOMEMORY;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    if (!inflate_init(&pngp->Inflate, true))
+    {
+        pngp->ParserError = PNG_PARSE_ERROR_NOMEMORY;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    memset(pngp->RowMemory, 0, row_stride * 3);
+    pngp->InflateReady = true;
+    pngp->PriorRow     = pngp->RowMemory + PNG_ROW_PADDING;
+    pngp->CurrentRow   = pngp->RowMemory + PNG_ROW_PADDING + row_stride;
+    pngp->OutputRow    = pngp->RowMemory + PNG_ROW_PADDING + row_stride * 2;
+    pngp->RowFill      = 0;
+    pngp->RowIndex     = 0;
+    pngp->Encoder->reset_element(0);
+    return PNG_PARSE_STATE_IMAGE_DATA;
+}
+
+/// @summary Implements the parser logic for the PNG_PARSE_STATE_SEEK_OFFSET.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param pngp The PNG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int png_seek_offset(stream_decoder_t *decoder, png_parser_state_t *pngp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    stream_decode_pos_t &target  = pngp->Config.StartOffset;
+    stream_decode_pos_t  current;  decoder->pos(current);
+    if (current.FileOffset      >= target.FileOffset &&
+        current.FileOffset      <= target.FileOffset)
+    {   // this encoded data chunk contains the start of the data we're looking for.
+        size_t available         = decoder->amount();
+        size_t consume           =(target.DecodeOffset >= available) ? available : target.DecodeOffset;
+        decoder->ReadCursor     += consume; // consume from available decoded input
+        target.DecodeOffset     -= consume; // decrement bytes remaining to consume
+        if (decoder->ReadCursor != decoder->FinalByte)
+        {   // the pixel data is compressed, so the headers are always read.
+            return PNG_PARSE_STATE_BUFFER_SIGNATURE;
+        }
+        // else, refill the decoded data buffer and remain in the same state.
+    }
+    return PNG_PARSE_STATE_SEEK_OFFSET;
+}
+
+/// @summary Implements the parser logic for the PNG_PARSE_STATE_BUFFER_SIGNATURE.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param pngp The PNG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int png_buffer_signature(stream_decoder_t *decoder, png_parser_state_t *pngp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = PNG_SIGNATURE_SIZE - pngp->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&pngp->HeaderBuffer[pngp->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    pngp->HeaderWritePos    += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (pngp->HeaderWritePos < PNG_SIGNATURE_SIZE)
+    {   // this is a partial read; wait for more data.
+        return PNG_PARSE_STATE_BUFFER_SIGNATURE;
+    }
+    if (memcmp(pngp->HeaderBuffer, PNG_SIGNATURE, PNG_SIGNATURE_SIZE) != 0)
+    {   // this isn't a PNG file.
+        pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    pngp->HeaderWritePos = 0;
+    return PNG_PARSE_STATE_CHUNK_HEADER;
+}
+
+/// @summary Implements the parser logic for the PNG_PARSE_STATE_CHUNK_HEADER.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param pngp The PNG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int png_chunk_header(stream_decoder_t *decoder, png_parser_state_t *pngp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = PNG_CHUNK_HEADER_SIZE - pngp->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&pngp->HeaderBuffer[pngp->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    pngp->HeaderWritePos    += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (pngp->HeaderWritePos < PNG_CHUNK_HEADER_SIZE)
+    {   // this is a partial read; wait for more data.
+        return PNG_PARSE_STATE_CHUNK_HEADER;
+    }
+    pngp->HeaderWritePos = 0;
+    pngp->ChunkSize      = png_u32(&pngp->HeaderBuffer[0]);
+    pngp->ChunkType      = image_fourcc_le(pngp->HeaderBuffer[4], pngp->HeaderBuffer[5], pngp->HeaderBuffer[6], pngp->HeaderBuffer[7]);
+    if (pngp->ChunkSize > 0x7FFFFFFF || (!pngp->HaveHeader && pngp->ChunkType != image_fourcc_le('I','H','D','R')))
+    {   // IHDR must be the first chunk.
+        pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    if (pngp->ChunkType == image_fourcc_le('I','D','A','T'))
+    {   // the IDAT chunks form a single zlib stream.
+        pngp->ChunkRemain = pngp->ChunkSize;
+        if (pngp->Encoder == NULL) return png_parser_setup_image_info(pngp);
+        else return PNG_PARSE_STATE_IMAGE_DATA;
+    }
+    if (pngp->Encoder != NULL)
+    {   // the IDAT chunks have ended; decode the remaining buffered data.
+        pngp->ChunkRemain = 0;
+        inflate_finish(&pngp->Inflate);
+        return PNG_PARSE_STATE_IMAGE_DATA;
+    }
+    if (pngp->ChunkType == image_fourcc_le('I','E','N','D'))
+    {   // the file has no image data.
+        pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        return PNG_PARSE_STATE_ERROR;
+    }
+    if (pngp->ChunkType == image_fourcc_le('I','H','D','R') ||
+        pngp->ChunkType == image_fourcc_le('P','L','T','E') ||
+        pngp->ChunkType == image_fourcc_le('t','R','N','S') ||
+        pngp->ChunkType == image_fourcc_le('s','R','G','B'))
+    {   // buffer the chunk data, then skip the CRC.
+        if (pngp->ChunkSize > PNG_CHUNK_BUFFER_SIZE)
+        {
+            pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+            return PNG_PARSE_STATE_ERROR;
+        }
+        pngp->ChunkWritePos = 0;
+        pngp->ChunkRemain   = PNG_CHUNK_CRC_SIZE;
+        return PNG_PARSE_STATE_BUFFER_CHUNK;
+    }
+    // skip ancillary chunks and their CRC.
+    pngp->ChunkRemain = pngp->ChunkSize + PNG_CHUNK_CRC_SIZE;
+    return PNG_PARSE_STATE_SKIP_CHUNK;
+}
+
+/// @summary Implements the parser logic for the PNG_PARSE_STATE_BUFFER_CHUNK.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param pngp The PNG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int png_buffer_chunk(stream_decoder_t *decoder, png_parser_state_t *pngp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = pngp->ChunkSize - pngp->ChunkWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&pngp->ChunkBuffer[pngp->ChunkWritePos], decoder->ReadCursor, bytes_to_copy);
+    pngp->ChunkWritePos     += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (pngp->ChunkWritePos < pngp->ChunkSize)
+    {   // this is a partial read; wait for more data.
+        return PNG_PARSE_STATE_BUFFER_CHUNK;
+    }
+    return png_process_chunk(pngp);
+}
+
+/// @summary Implements the parser logic for the PNG_PARSE_STATE_SKIP_CHUNK.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param pngp The PNG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int png_skip_chunk(stream_decoder_t *decoder, png_parser_state_t *pngp, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_skip     =(pngp->ChunkRemain < bytes_available) ? pngp->ChunkRemain : bytes_available;
+    decoder->ReadCursor     += bytes_to_skip;
+    pngp->ChunkRemain       -= bytes_to_skip;
+    return (pngp->ChunkRemain == 0) ? PNG_PARSE_STATE_CHUNK_HEADER : PNG_PARSE_STATE_SKIP_CHUNK;
+}
+
+/// @summary Implements the parser logic for the PNG_PARSE_STATE_IMAGE_DATA.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param pngp The PNG parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int png_image_data(stream_decoder_t *decoder, png_parser_state_t *pngp, image_encoder_t *encoder)
+{
+    for ( ; ; )
+    {
+        if (pngp->ChunkRemain > 0 && decoder->ReadCursor != decoder->FinalByte)
+        {   // pass as much of the chunk data as possible to the decompressor.
+            size_t bytes_available = decoder->amount();
+            size_t bytes_to_feed   =(pngp->ChunkRemain < bytes_available) ? pngp->ChunkRemain : bytes_available;
+            size_t bytes_fed       = inflate_feed(&pngp->Inflate, decoder->ReadCursor, bytes_to_feed);
+            decoder->ReadCursor   += bytes_fed;
+            pngp->ChunkRemain     -= bytes_fed;
+        }
+        int res = inflate_run(&pngp->Inflate);
+        if (!png_receive_rows(pngp, encoder))
+        {   // ParserError was set by png_receive_rows.
+            return PNG_PARSE_STATE_ERROR;
+        }
+        if (pngp->RowIndex == pngp->Height)
+        {   // all rows have been received; any remaining chunks are ignored.
+            encoder->mark_level(0);
+            encoder->mark_element(0);
+            return PNG_PARSE_STATE_COMPLETE;
+        }
+        if (res == INFLATE_RESULT_NEED_OUTPUT)
+        {   // the rows were consumed, so there's space for more output.
+            continue;
+        }
+        if (res == INFLATE_RESULT_NEED_INPUT && !pngp->Inflate.InputFinal)
+        {
+            if (pngp->ChunkRemain == 0)
+            {   // skip the CRC, then continue with the next IDAT chunk.
+                pngp->ChunkRemain = PNG_CHUNK_CRC_SIZE;
+                return PNG_PARSE_STATE_SKIP_CHUNK;
+            }
+            if (decoder->ReadCursor == decoder->FinalByte)
+            {   // wait for the stream decoder to be refilled.
+                return PNG_PARSE_STATE_IMAGE_DATA;
+            }
+            continue;
+        }
+        // the zlib stream is invalid, or ended before all rows were received.
+        pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        return PNG_PARSE_STATE_ERROR;
+    }
+}
+
+/// @summary Implements the primary update tick for a streaming PNG parser.
+/// @param pngp The PNG parser state to update.
+/// @return One of png_parser_result_e.
+internal_function int png_parser_update(png_parser_state_t *pngp)
+{
+    stream_decoder_t *decoder   = pngp->Config.Decoder;
+    while (pngp->CurrentState  != PNG_PARSE_STATE_COMPLETE)
+    {
+        if (pngp->CurrentState == PNG_PARSE_STATE_ERROR)
+        {   // return from the error state immediately.
+            return PNG_PARSE_RESULT_ERROR;
+        }
+        if (decoder->ReadCursor == decoder->FinalByte && !decoder->atend())
+        {   // attempt to obtain additional input data.
+            switch (decoder->refill(decoder))
+            {
+            case STREAM_REFILL_RESULT_START:
+                break;
+            case STREAM_REFILL_RESULT_YIELD:
+                return PNG_PARSE_RESULT_CONTINUE;
+            case STREAM_REFILL_RESULT_ERROR:
+                pngp->CurrentState = PNG_PARSE_STATE_ERROR;
+                pngp->ParserError  = PNG_PARSE_ERROR_DECODER;
+                return PNG_PARSE_RESULT_ERROR;
+            }
+        }
+        // perform a state update, which may consume zero or more bytes.
+        uint8_t *cursor = decoder->ReadCursor;
+        int      s      = pngp->CurrentState;
+        switch (pngp->CurrentState)
+        {
+        case PNG_PARSE_STATE_SEEK_OFFSET:
+            s = png_seek_offset(decoder, pngp, pngp->Encoder);
+            break;
+        case PNG_PARSE_STATE_BUFFER_SIGNATURE:
+            s = png_buffer_signature(decoder, pngp, pngp->Encoder);
+            break;
+        case PNG_PARSE_STATE_CHUNK_HEADER:
+            s = png_chunk_header(decoder, pngp, pngp->Encoder);
+            break;
+        case PNG_PARSE_STATE_BUFFER_CHUNK:
+            s = png_buffer_chunk(decoder, pngp, pngp->Encoder);
+            break;
+        case PNG_PARSE_STATE_SKIP_CHUNK:
+            s = png_skip_chunk(decoder, pngp, pngp->Encoder);
+            break;
+        case PNG_PARSE_STATE_IMAGE_DATA:
+            s = png_image_data(decoder, pngp, pngp->Encoder);
+            break;
+        default:
+            break;
+        }
+        if (s == pngp->CurrentState && cursor == decoder->ReadCursor && decoder->atend())
+        {   // the state needs more data, but the stream has ended.
+            s = PNG_PARSE_STATE_ERROR;
+            pngp->ParserError = PNG_PARSE_ERROR_BAD_DATA;
+        }
+        pngp->CurrentState = s;
+    }
+    return PNG_PARSE_RESULT_COMPLETE;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initializes or resets the state of a streaming PNG parser.
+/// @param pngp The streaming PNG parser state to initialize.
+/// @param config Parser configuration data indicating what portions of the file to parse.
+public_function void png_parser_state_init(png_parser_state_t *pngp, image_parser_config_t const &config)
+{
+    pngp->CurrentState     = PNG_PARSE_STATE_SEEK_OFFSET;
+    pngp->ParserError      = PNG_PARSE_ERROR_SUCCESS;
+    pngp->Config           = config;
+    pngp->Encoder          = NULL;
+    pngp->Metadata         = config.Metadata;
+    pngp->InflateReady     = false;
+    pngp->HaveHeader       = false;
+    pngp->HaveSRGB         = false;
+    pngp->HaveTransparency = false;
+    pngp->ChunkType        = 0;
+    pngp->ChunkSize        = 0;
+    pngp->ChunkRemain      = 0;
+    pngp->HeaderWritePos   = 0;
+    pngp->ChunkWritePos    = 0;
+    pngp->Width            = 0;
+    pngp->Height           = 0;
+    pngp->BitDepth         = 0;
+    pngp->ColorType        = 0;
+    pngp->RowFilter        = PNG_FILTER_NONE;
+    pngp->Conversion       = PNG_CONVERT_COPY;
+    pngp->Format           = DXGI_FORMAT_UNKNOWN;
+    pngp->FilterStride     = 0;
+    pngp->RowSize          = 0;
+    pngp->RowFill          = 0;
+    pngp->RowIndex         = 0;
+    pngp->OutputRowSize    = 0;
+    pngp->RowMemory        = NULL;
+    pngp->PriorRow         = NULL;
+    pngp->CurrentRow       = NULL;
+    pngp->OutputRow        = NULL;
+    pngp->TransparentKey[0]= 0;
+    pngp->TransparentKey[1]= 0;
+    pngp->TransparentKey[2]= 0;
+    for (size_t i = 0; i < 256; ++i)
+    {   // indices outside of the palette decode as opaque black.
+        pngp->Palette[i]   = 0xFF000000U;
+    }
+}
+
+/// @summary Frees any locally-allocated resources for a parser instance.
+/// @param pngp The streaming PNG parser state to clean up.
+public_function void png_parser_state_cleanup(png_parser_state_t *pngp)
+{
+    if (pngp->InflateReady)
+    {
+        inflate_delete(&pngp->Inflate);
+        pngp->InflateReady = false;
+    }
+    if (pngp->RowMemory != NULL)
+    {
+        free(pngp->RowMemory);
+        pngp->RowMemory = NULL;
+    }
+    if (pngp->Encoder != NULL)
+    {
+        delete  pngp->Encoder;
+        pngp->Encoder  = NULL;
+    }
+}
+
+/// @summary Measure the throughput of the streaming PNG parser on a file held in memory, including inflate, unfiltering, pixel 
+/// conversion and the write to image memory. Compare with dds_parser_benchmark() on the same image stored as a DDS file.
+/// @param data The contents of a PNG file.
+/// @param size The size of the file, in bytes.
+/// @param iterations The number of times to load the file.
+/// @return The load throughput, in millions of output pixels per-second, or zero if the file can't be loaded.
+public_function double png_parser_benchmark(void const *data, size_t size, size_t iterations)
+{
+    LARGE_INTEGER  frequency, start, end;
+    image_memory_t memory;
+    double         pixels = 0.0;
+    double         rate   = 0.0;
+    bool           failed = false;
+    image_memory_create(&memory, 1);
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (size_t i = 0; i < iterations && !failed; ++i)
+    {
+        stream_decoder_t      stream;
+        image_definition_t    meta;
+        image_parser_config_t config;
+        png_parser_state_t    pngp;
+        image_definition_init(&meta);
+        image_parser_memory_config(config, &stream, data, size, &memory, &meta, 1);
+        png_parser_state_init(&pngp, config);
+        if (png_parser_update(&pngp) == PNG_PARSE_RESULT_COMPLETE)
+            pixels += double(pngp.Width) * double(pngp.Height);
+        else failed = true;
+        png_parser_state_cleanup(&pngp);
+        image_memory_drop_image(&memory, 1, true);
+        image_definition_free(&meta);
+    }
+    QueryPerformanceCounter(&end);
+    image_memory_delete(&memory);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(frequency.QuadPart);
+    if (seconds > 0.0 && !failed)
+    {
+        rate = pixels / (seconds * 1000000.0);
+    }
+    return rate;
+}
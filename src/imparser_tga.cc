@@ -0,0 +1,764 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a streaming parser for Truevision TGA files. The parser
+/// consumes the file in whatever chunks the stream decoder produces; RLE
+/// packets are decoded as they arrive, and may span chunks and rows. Each row
+/// is converted to an 8-bit DXGI format as soon as it is complete. Rows of
+/// bottom-up images are written directly to their flipped offsets in image
+/// memory, so no second pass over the image is required.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The size of the fixed TGA file header, in bytes.
+#define TGA_HEADER_SIZE           18
+
+/// @summary The bit of the image descriptor indicating that pixels are stored right-to-left.
+#define TGA_DESC_RIGHT_TO_LEFT    0x10
+
+/// @summary The bit of the image descriptor indicating that rows are stored top-down.
+#define TGA_DESC_TOP_DOWN         0x20
+
+/// @summary The bits of the image descriptor specifying the number of alpha bits in each pixel.
+#define TGA_DESC_ALPHA_BITS       0x0F
+
+/// @summary The bits of the image descriptor specifying row interleaving, which is obsolete.
+#define TGA_DESC_INTERLEAVE       0xC0
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define identifiers for the recognized parser states.
+enum tga_parser_state_e : int
+{
+    TGA_PARSE_STATE_SEEK_OFFSET          = 0,   /// The parser is looking for a known byte offset.
+    TGA_PARSE_STATE_BUFFER_HEADER        = 1,   /// The parser is receiving the fixed file header.
+    TGA_PARSE_STATE_SKIP_IMAGE_ID        = 2,   /// The parser is skipping the image ID field.
+    TGA_PARSE_STATE_COLOR_MAP            = 3,   /// The parser is receiving the color map entries.
+    TGA_PARSE_STATE_PIXEL_DATA           = 4,   /// The parser is receiving uncompressed pixel data.
+    TGA_PARSE_STATE_RLE_DATA             = 5,   /// The parser is receiving run-length encoded pixel data.
+    TGA_PARSE_STATE_COMPLETE             = 6,   /// The parser has processed the entire file contents.
+    TGA_PARSE_STATE_ERROR                = 7    /// The parser has encountered a fatal error.
+};
+
+/// @summary Define identifiers for the recognized parser errors.
+enum tga_parser_error_e : int
+{
+    TGA_PARSE_ERROR_SUCCESS              = 0,   /// No error has occurred.
+    TGA_PARSE_ERROR_NOMEMORY             = 1,   /// Required memory could not be allocated.
+    TGA_PARSE_ERROR_DECODER              = 2,   /// The underlying stream decoder returned an error.
+    TGA_PARSE_ERROR_NOENCODER            = 3,   /// No encoder was found that supports the required transcoding.
+    TGA_PARSE_ERROR_ENCODER              = 4,   /// The image encoder returned an error.
+    TGA_PARSE_ERROR_BAD_DATA             = 5,   /// The file is not a valid TGA, or is truncated.
+    TGA_PARSE_ERROR_UNSUPPORTED          = 6,   /// The file uses a feature the parser doesn't support.
+};
+
+/// @summary Define the possible return codes from the top-level streaming parser update function.
+enum tga_parser_result_e : int
+{
+    TGA_PARSE_RESULT_CONTINUE            = 0,   /// The parser is yielding, waiting for more data.
+    TGA_PARSE_RESULT_COMPLETE            = 1,   /// Stop parsing. All data was parsed successfully.
+    TGA_PARSE_RESULT_ERROR               = 2    /// Stop parsing. An error was encountered.
+};
+
+/// @summary Define the TGA image types specified in the file header.
+enum tga_image_type_e : uint8_t
+{
+    TGA_IMAGE_TYPE_COLOR_MAPPED          = 1,   /// Uncompressed indices into the color map.
+    TGA_IMAGE_TYPE_TRUE_COLOR            = 2,   /// Uncompressed BGR or BGRA pixels.
+    TGA_IMAGE_TYPE_GRAYSCALE             = 3,   /// Uncompressed grayscale samples.
+    TGA_IMAGE_TYPE_RLE_COLOR_MAPPED      = 9,   /// Run-length encoded indices into the color map.
+    TGA_IMAGE_TYPE_RLE_TRUE_COLOR        = 10,  /// Run-length encoded BGR or BGRA pixels.
+    TGA_IMAGE_TYPE_RLE_GRAYSCALE         = 11,  /// Run-length encoded grayscale samples.
+};
+
+/// @summary Define the conversions from TGA pixels to DXGI formats.
+enum tga_convert_e : int
+{
+    TGA_CONVERT_COPY                     = 0,   /// 8-bit grayscale and 32-bit BGRA pixels are written as-is.
+    TGA_CONVERT_BGR5                     = 1,   /// 16-bit X1R5G5B5 or A1R5G5B5 pixels are expanded to BGRA.
+    TGA_CONVERT_BGR8                     = 2,   /// 24-bit BGR pixels are expanded to BGRX.
+    TGA_CONVERT_PALETTE                  = 3,   /// 8-bit indices are expanded through the color map.
+};
+
+/// @summary Define the state data associated with a streaming TGA file parser.
+struct tga_parser_state_t
+{
+    int                   CurrentState;         /// One of tga_parser_state_e.
+    int                   ParserError;          /// One of tga_parser_error_e.
+    image_parser_config_t Config;               /// The input parser configuration.
+    image_encoder_t      *Encoder;              /// The local image encoder. Deleted on error or completion.
+    image_definition_t   *Metadata;             /// Pointer to the image metadata block.
+    image_row_writer_t    Rows;                 /// Writes converted rows to the encoder, flipping bottom-up images.
+    size_t                HeaderWritePos;       /// The current write position in HeaderBuffer.
+    size_t                SkipRemain;           /// The number of bytes of the image ID remaining to be skipped.
+    size_t                ColorMapFirst;        /// The index of the first color map entry.
+    size_t                ColorMapCount;        /// The number of color map entries.
+    size_t                ColorMapIndex;        /// The number of color map entries received.
+    size_t                EntrySize;            /// The size of a color map entry, in bytes.
+    uint8_t               EntryBits;            /// The number of bits per color map entry.
+    uint8_t               ImageType;            /// One of tga_image_type_e.
+    uint8_t               PixelBits;            /// The number of bits per pixel or color map index.
+    uint8_t               AlphaBits;            /// The number of alpha bits in each pixel or color map entry.
+    bool                  RightToLeft;          /// true if pixels are stored right-to-left within each row.
+    bool                  BottomUp;             /// true if rows are stored bottom-up.
+    int                   Conversion;           /// One of tga_convert_e.
+    uint32_t              Format;               /// One of dxgi_format_e specifying the format of the encoded pixel data.
+    size_t                Width;                /// The image width, in pixels.
+    size_t                Height;               /// The image height, in pixels.
+    size_t                PixelSize;            /// The size of a stored pixel, in bytes.
+    size_t                RowSize;              /// The size of a stored row, in bytes.
+    size_t                RowFill;              /// The number of bytes of the current row received.
+    size_t                OutputRowSize;        /// The size of a converted row, in bytes.
+    size_t                PacketRemain;         /// The number of bytes of decoded pixel data remaining in the current RLE packet.
+    bool                  PacketRun;            /// true if the current RLE packet repeats a single pixel.
+    size_t                PixelFill;            /// The number of bytes received in PixelBuffer.
+    uint8_t              *RowMemory;            /// The allocation containing the row buffers.
+    uint8_t              *CurrentRow;           /// The stored row being received.
+    uint8_t              *OutputRow;            /// The converted row.
+    uint32_t              Palette[256];         /// The color map as B8G8R8A8 values.
+    uint8_t               PixelBuffer[4];       /// Internal buffer for the color map entry or RLE run pixel being received.
+    uint8_t               HeaderBuffer[TGA_HEADER_SIZE]; /// Internal buffer for the file header.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Reads a little-endian 16-bit value.
+/// @param p The first byte of the value.
+/// @return The value.
+internal_function inline uint16_t tga_u16(uint8_t const *p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+/// @summary Expands a 16-bit A1R5G5B5 value to B8G8R8A8.
+/// @param v The 16-bit value.
+/// @param alpha true if the top bit stores alpha; otherwise the result is opaque.
+/// @return The B8G8R8A8 value.
+internal_function inline uint32_t tga_expand_bgr5(uint32_t v, bool alpha)
+{
+    uint32_t b = (v >>  0) & 0x1F;
+    uint32_t g = (v >>  5) & 0x1F;
+    uint32_t r = (v >> 10) & 0x1F;
+    uint32_t a = (!alpha || (v & 0x8000)) ? 0xFFU : 0;
+    b = (b << 3) | (b >> 2);
+    g = (g << 3) | (g >> 2);
+    r = (r << 3) | (r >> 2);
+    return b | (g << 8) | (r << 16) | (a << 24);
+}
+
+/// @summary Converts a stored color map entry to a B8G8R8A8 value.
+/// @param tgap The TGA parser state.
+/// @param p The first byte of the entry.
+/// @return The B8G8R8A8 value.
+internal_function uint32_t tga_color_map_entry(tga_parser_state_t const *tgap, uint8_t const *p)
+{
+    switch (tgap->EntryBits)
+    {
+    case 15:
+        return tga_expand_bgr5(tga_u16(p), false);
+    case 16:
+        return tga_expand_bgr5(tga_u16(p), tgap->AlphaBits > 0);
+    case 24:
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | 0xFF000000U;
+    default:
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (tgap->AlphaBits > 0 ? (uint32_t(p[3]) << 24) : 0xFF000000U);
+    }
+}
+
+/// @summary Converts a complete stored row to the output format and writes it to the encoder.
+/// @param tgap The TGA parser state.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @param src The stored row.
+/// @return true if the row was written, or false if the encoder returned an error.
+internal_function bool tga_emit_row(tga_parser_state_t *tgap, image_encoder_t *encoder, uint8_t const *src)
+{
+    size_t   const width = tgap->Width;
+    uint8_t const *row   = src;
+    if (tgap->Conversion != TGA_CONVERT_COPY || tgap->RightToLeft)
+    {
+        uint8_t *dst = tgap->OutputRow;
+        switch (tgap->Conversion)
+        {
+        case TGA_CONVERT_COPY:
+            memcpy(dst, src, tgap->OutputRowSize);
+            break;
+        case TGA_CONVERT_BGR5:
+            {
+                bool alpha = tgap->AlphaBits > 0;
+                for (size_t i = 0; i < width; ++i)
+                {
+                    uint32_t v = tga_expand_bgr5(tga_u16(src + i * 2), alpha);
+                    memcpy(dst + i * 4, &v, sizeof(uint32_t));
+                }
+            }
+            break;
+        case TGA_CONVERT_BGR8:
+            for (size_t i = 0; i < width; ++i)
+            {
+                dst[i * 4 + 0] = src[i * 3 + 0];
+                dst[i * 4 + 1] = src[i * 3 + 1];
+                dst[i * 4 + 2] = src[i * 3 + 2];
+                dst[i * 4 + 3] = 0xFF;
+            }
+            break;
+        case TGA_CONVERT_PALETTE:
+            for (size_t i = 0; i < width; ++i)
+            {
+                memcpy(dst + i * 4, &tgap->Palette[src[i]], sizeof(uint32_t));
+            }
+            break;
+        }
+        if (tgap->RightToLeft)
+        {   // mirror the row; output pixels are either 1 or 4 bytes.
+            if (tgap->Format == DXGI_FORMAT_R8_UNORM)
+            {
+                for (size_t i = 0, j = width - 1; i < j; ++i, --j)
+                {
+                    uint8_t t = dst[i]; dst[i] = dst[j]; dst[j] = t;
+                }
+            }
+            else
+            {
+                uint32_t *px = (uint32_t*) dst;
+                for (size_t i = 0, j = width - 1; i < j; ++i, --j)
+                {
+                    uint32_t t = px[i]; px[i] = px[j]; px[j] = t;
+                }
+            }
+        }
+        row = dst;
+    }
+    uint32_t res = image_row_writer_write(&tgap->Rows, encoder, row, 1);
+    if (res != ERROR_SUCCESS)
+    {
+        tgap->ParserError = res == ERROR_OUTOFMEMORY ? TGA_PARSE_ERROR_NOMEMORY : TGA_PARSE_ERROR_ENCODER;
+        return false;
+    }
+    return true;
+}
+
+/// @summary Completes the image once all rows have been written.
+/// @param tgap The TGA parser state.
+/// @param encoder The image encoder to which pixel data was written.
+/// @return The new parser state.
+internal_function int tga_finish_image(tga_parser_state_t *tgap, image_encoder_t *encoder)
+{
+    if (image_row_writer_finish(&tgap->Rows, encoder) != ERROR_SUCCESS)
+    {
+        tgap->ParserError = TGA_PARSE_ERROR_ENCODER;
+        return TGA_PARSE_STATE_ERROR;
+    }
+    encoder->mark_level(0);
+    encoder->mark_element(0);
+    return TGA_PARSE_STATE_COMPLETE;
+}
+
+/// @summary Validates the file header and determines the format of the encoded pixel data.
+/// @param tgap The TGA parser state, with the header in HeaderBuffer.
+/// @return The new parser state.
+internal_function int tga_process_header(tga_parser_state_t *tgap)
+{
+    uint8_t const *data  = tgap->HeaderBuffer;
+    uint8_t const  cmap  = data[1];
+    uint8_t const  desc  = data[17];
+    tgap->SkipRemain     = data[0];
+    tgap->ImageType      = data[2];
+    tgap->ColorMapFirst  = tga_u16(data + 3);
+    tgap->ColorMapCount  = tga_u16(data + 5);
+    tgap->EntryBits      = data[7];
+    tgap->Width          = tga_u16(data + 12);
+    tgap->Height         = tga_u16(data + 14);
+    tgap->PixelBits      = data[16];
+    tgap->AlphaBits      = desc & TGA_DESC_ALPHA_BITS;
+    tgap->RightToLeft    =(desc & TGA_DESC_RIGHT_TO_LEFT) != 0;
+    tgap->BottomUp       =(desc & TGA_DESC_TOP_DOWN) == 0;
+    if (tgap->Width == 0 || tgap->Height == 0 || cmap > 1)
+    {   // invalid dimensions, or an unknown color map type.
+        tgap->ParserError = TGA_PARSE_ERROR_BAD_DATA;
+        return TGA_PARSE_STATE_ERROR;
+    }
+    if (desc & TGA_DESC_INTERLEAVE)
+    {   // interleaved rows are obsolete, and would require buffering the whole image.
+        tgap->ParserError = TGA_PARSE_ERROR_UNSUPPORTED;
+        return TGA_PARSE_STATE_ERROR;
+    }
+    if (cmap == 0)
+    {   // there's no color map to read.
+        tgap->ColorMapCount = 0;
+    }
+    else if (tgap->EntryBits != 15 && tgap->EntryBits != 16 && tgap->EntryBits != 24 && tgap->EntryBits != 32)
+    {
+        tgap->ParserError = TGA_PARSE_ERROR_BAD_DATA;
+        return TGA_PARSE_STATE_ERROR;
+    }
+    tgap->EntrySize = (tgap->EntryBits + 7) / 8;
+
+    bool valid = false;
+    switch (tgap->ImageType)
+    {
+    case TGA_IMAGE_TYPE_COLOR_MAPPED:
+    case TGA_IMAGE_TYPE_RLE_COLOR_MAPPED:
+        valid = cmap == 1 && tgap->PixelBits == 8;
+        tgap->Conversion = TGA_CONVERT_PALETTE;
+        tgap->Format     =(tgap->AlphaBits > 0 && tgap->EntryBits >= 16 && tgap->EntryBits != 24) ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8X8_UNORM;
+        break;
+    case TGA_IMAGE_TYPE_TRUE_COLOR:
+    case TGA_IMAGE_TYPE_RLE_TRUE_COLOR:
+        valid = tgap->PixelBits == 15 || tgap->PixelBits == 16 || tgap->PixelBits == 24 || tgap->PixelBits == 32;
+        if (tgap->PixelBits == 15)
+        {   // 15-bit pixels never carry alpha.
+            tgap->AlphaBits = 0;
+        }
+        if (tgap->PixelBits <= 16) tgap->Conversion = TGA_CONVERT_BGR5;
+        else if (tgap->PixelBits == 24) tgap->Conversion = TGA_CONVERT_BGR8;
+        else tgap->Conversion = TGA_CONVERT_COPY;
+        tgap->Format     =(tgap->AlphaBits > 0 && tgap->PixelBits != 24) ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8X8_UNORM;
+        break;
+    case TGA_IMAGE_TYPE_GRAYSCALE:
+    case TGA_IMAGE_TYPE_RLE_GRAYSCALE:
+        valid = tgap->PixelBits == 8;
+        tgap->Conversion = TGA_CONVERT_COPY;
+        tgap->Format     = DXGI_FORMAT_R8_UNORM;
+        break;
+    default:
+        break;
+    }
+    if (!valid)
+    {   // the image type or pixel depth isn't supported.
+        tgap->ParserError = TGA_PARSE_ERROR_UNSUPPORTED;
+        return TGA_PARSE_STATE_ERROR;
+    }
+    tgap->PixelSize     =(tgap->PixelBits + 7) / 8;
+    tgap->RowSize       = tgap->Width * tgap->PixelSize;
+    tgap->OutputRowSize = dxgi_pitch(tgap->Format, tgap->Width);
+    return TGA_PARSE_STATE_SKIP_IMAGE_ID;
+}
+
+/// @summary Calculates all of the static data and allocates the row buffers once the start of the pixel data is reached.
+/// @param tgap The parser state to update.
+/// @return The new parser state.
+internal_function int tga_parser_setup_image_info(tga_parser_state_t *tgap)
+{
+    image_definition_t *meta  = tgap->Metadata;
+    uint32_t            alpha =(tgap->Format == DXGI_FORMAT_B8G8R8A8_UNORM) ? DDS_ALPHA_MODE_STRAIGHT : DDS_ALPHA_MODE_OPAQUE;
+    if (tgap->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // completely initialize the metadata block with information we've read.
+        dds_header_t       dds;
+        dds_header_dxt10_t dx10;
+        dds_headers_for_image(&dds, &dx10, tgap->Format, tgap->Width, tgap->Height, alpha);
+        if (!dds_image_definition(meta, tgap->Config.ImageId, &dds, &dx10, tgap->Config.Compression, tgap->Config.Encoding))
+        {   // unable to allocate storage for the mip-level descriptors and offsets.
+            tgap->ParserError = TGA_PARSE_ERROR_NOMEMORY;
+            return TGA_PARSE_STATE_ERROR;
+        }
+    }
+
+    // create the image encoder instance.
+    tgap->Encoder = create_image_encoder(
+        tgap->Config.ImageId,
+        tgap->Config.Memory,
+        IMAGE_COMPRESSION_NONE,
+        IMAGE_ENCODING_RAW,
+        tgap->Config.Compression,
+        tgap->Config.Encoding,
+        dds_access_type(meta),
+        tgap->Config.DefinitionQueue,
+        tgap->Config.DefinitionAlloc,
+        tgap->Config.PlacementQueue,
+        tgap->Config.PlacementAlloc,
+        meta->ImageFormat,
+        tgap->Config.Format,
+        tgap->Config.Quality,
+        tgap->Config.WorkPool,
+        tgap->Config.EncoderFlags);
+    if (tgap->Encoder == NULL)
+    {   // unable to create the encoder to write to image memory.
+        tgap->ParserError = TGA_PARSE_ERROR_NOENCODER;
+        return TGA_PARSE_STATE_ERROR;
+    }
+    if (tgap->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_METADATA)
+    {   // notify the encoder of the image attributes:
+        if (tgap->Encoder->define_image(meta) != ERROR_SUCCESS)
+        {
+            tgap->ParserError = TGA_PARSE_ERROR_ENCODER;
+            return TGA_PARSE_STATE_ERROR;
+        }
+    }
+    else
+    {   // the image is already defined, but encoders that change the format need the source attributes.
+        tgap->Encoder->Metadata = meta;
+    }
+
+    // a TGA file stores a single image element.
+    if ((tgap->Config.ParseFlags & IMAGE_PARSER_FLAGS_READ_PIXELS) == 0 || tgap->Config.FirstFrame >= meta->ElementCount)
+    {   // not reading any pixel data, so we're done.
+        return TGA_PARSE_STATE_COMPLETE;
+    }
+
+    // allocate the stored row and converted row buffers. the converted row is 16-byte aligned.
+    size_t row_stride  =(tgap->RowSize + 15) & ~size_t(15);
+    if ((tgap->RowMemory = (uint8_t*) malloc(row_stride + tgap->OutputRowSize)) == NULL)
+    {
+        tgap->ParserError = TGA_PARSE_ERROR_NOMEMORY;
+        return TGA_PARSE_STATE_ERROR;
+    }
+    tgap->CurrentRow   = tgap->RowMemory;
+    tgap->OutputRow    = tgap->RowMemory + row_stride;
+    tgap->RowFill      = 0;
+    tgap->PacketRemain = 0;
+    tgap->PixelFill    = 0;
+    image_row_writer_init(&tgap->Rows, tgap->OutputRowSize, tgap->Height, tgap->BottomUp);
+    tgap->Encoder->reset_element(0);
+    return (tgap->ImageType >= TGA_IMAGE_TYPE_RLE_COLOR_MAPPED) ? TGA_PARSE_STATE_RLE_DATA : TGA_PARSE_STATE_PIXEL_DATA;
+}
+
+/// @summary Implements the parser logic for the TGA_PARSE_STATE_SEEK_OFFSET.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param tgap The TGA parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int tga_seek_offset(stream_decoder_t *decoder, tga_parser_state_t *tgap, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    stream_decode_pos_t &target  = tgap->Config.StartOffset;
+    stream_decode_pos_t  current;  decoder->pos(current);
+    if (current.FileOffset      >= target.FileOffset &&
+        current.FileOffset      <= target.FileOffset)
+    {   // this encoded data chunk contains the start of the data we're looking for.
+        size_t available         = decoder->amount();
+        size_t consume           =(target.DecodeOffset >= available) ? available : target.DecodeOffset;
+        decoder->ReadCursor     += consume; // consume from available decoded input
+        target.DecodeOffset     -= consume; // decrement bytes remaining to consume
+        if (decoder->ReadCursor != decoder->FinalByte)
+        {   // the header describes the pixel layout, so it's always read.
+            return TGA_PARSE_STATE_BUFFER_HEADER;
+        }
+        // else, refill the decoded data buffer and remain in the same state.
+    }
+    return TGA_PARSE_STATE_SEEK_OFFSET;
+}
+
+/// @summary Implements the parser logic for the TGA_PARSE_STATE_BUFFER_HEADER.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param tgap The TGA parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int tga_buffer_header(stream_decoder_t *decoder, tga_parser_state_t *tgap, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_copy     = TGA_HEADER_SIZE - tgap->HeaderWritePos;
+    if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+    memcpy(&tgap->HeaderBuffer[tgap->HeaderWritePos], decoder->ReadCursor, bytes_to_copy);
+    tgap->HeaderWritePos    += bytes_to_copy;
+    decoder->ReadCursor     += bytes_to_copy;
+    if (tgap->HeaderWritePos < TGA_HEADER_SIZE)
+    {   // this is a partial read; wait for more data.
+        return TGA_PARSE_STATE_BUFFER_HEADER;
+    }
+    return tga_process_header(tgap);
+}
+
+/// @summary Implements the parser logic for the TGA_PARSE_STATE_SKIP_IMAGE_ID.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param tgap The TGA parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int tga_skip_image_id(stream_decoder_t *decoder, tga_parser_state_t *tgap, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    size_t bytes_available   = decoder->amount();
+    size_t bytes_to_skip     =(tgap->SkipRemain < bytes_available) ? tgap->SkipRemain : bytes_available;
+    decoder->ReadCursor     += bytes_to_skip;
+    tgap->SkipRemain        -= bytes_to_skip;
+    if (tgap->SkipRemain > 0)
+    {   // wait for more data.
+        return TGA_PARSE_STATE_SKIP_IMAGE_ID;
+    }
+    if (tgap->ColorMapCount > 0)
+    {   // true-color images may also store a color map, which is read and ignored.
+        return TGA_PARSE_STATE_COLOR_MAP;
+    }
+    return tga_parser_setup_image_info(tgap);
+}
+
+/// @summary Implements the parser logic for the TGA_PARSE_STATE_COLOR_MAP.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param tgap The TGA parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int tga_color_map(stream_decoder_t *decoder, tga_parser_state_t *tgap, image_encoder_t *encoder)
+{   UNREFERENCED_PARAMETER(encoder);
+    while (tgap->ColorMapIndex < tgap->ColorMapCount && decoder->ReadCursor != decoder->FinalByte)
+    {
+        size_t bytes_available   = decoder->amount();
+        size_t bytes_to_copy     = tgap->EntrySize - tgap->PixelFill;
+        if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+        memcpy(&tgap->PixelBuffer[tgap->PixelFill], decoder->ReadCursor, bytes_to_copy);
+        tgap->PixelFill         += bytes_to_copy;
+        decoder->ReadCursor     += bytes_to_copy;
+        if (tgap->PixelFill == tgap->EntrySize)
+        {   // entries that can't be referenced by an 8-bit index are discarded.
+            size_t index = tgap->ColorMapFirst + tgap->ColorMapIndex++;
+            if (index < 256) tgap->Palette[index] = tga_color_map_entry(tgap, tgap->PixelBuffer);
+            tgap->PixelFill = 0;
+        }
+    }
+    if (tgap->ColorMapIndex < tgap->ColorMapCount)
+    {   // wait for more data.
+        return TGA_PARSE_STATE_COLOR_MAP;
+    }
+    return tga_parser_setup_image_info(tgap);
+}
+
+/// @summary Implements the parser logic for the TGA_PARSE_STATE_PIXEL_DATA. Complete rows that need no conversion are written directly from the stream decoder buffer.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param tgap The TGA parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int tga_pixel_data(stream_decoder_t *decoder, tga_parser_state_t *tgap, image_encoder_t *encoder)
+{
+    bool const direct = tgap->Conversion == TGA_CONVERT_COPY && !tgap->RightToLeft;
+    while (tgap->Rows.RowIndex < tgap->Height && decoder->ReadCursor != decoder->FinalByte)
+    {
+        size_t bytes_available = decoder->amount();
+        if (direct && tgap->RowFill == 0 && bytes_available >= tgap->RowSize)
+        {   // pass as many complete rows as possible straight through.
+            size_t   rows = bytes_available / tgap->RowSize;
+            size_t   left = tgap->Height - tgap->Rows.RowIndex;
+            if (rows > left) rows = left;
+            uint32_t res  = image_row_writer_write(&tgap->Rows, encoder, decoder->ReadCursor, rows);
+            if (res != ERROR_SUCCESS)
+            {
+                tgap->ParserError = res == ERROR_OUTOFMEMORY ? TGA_PARSE_ERROR_NOMEMORY : TGA_PARSE_ERROR_ENCODER;
+                return TGA_PARSE_STATE_ERROR;
+            }
+            decoder->ReadCursor += rows * tgap->RowSize;
+            continue;
+        }
+        size_t bytes_to_copy   = tgap->RowSize - tgap->RowFill;
+        if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+        memcpy(tgap->CurrentRow + tgap->RowFill, decoder->ReadCursor, bytes_to_copy);
+        tgap->RowFill         += bytes_to_copy;
+        decoder->ReadCursor   += bytes_to_copy;
+        if (tgap->RowFill == tgap->RowSize)
+        {   // the row is complete.
+            if (!tga_emit_row(tgap, encoder, tgap->CurrentRow))
+                return TGA_PARSE_STATE_ERROR;
+            tgap->RowFill = 0;
+        }
+    }
+    if (tgap->Rows.RowIndex < tgap->Height)
+    {   // wait for more data.
+        return TGA_PARSE_STATE_PIXEL_DATA;
+    }
+    // any remaining data, such as the extension area and footer, is ignored.
+    return tga_finish_image(tgap, encoder);
+}
+
+/// @summary Implements the parser logic for the TGA_PARSE_STATE_RLE_DATA. Packets may cross row boundaries and stream decoder chunks.
+/// @param decoder The stream decoder providing the data to consume.
+/// @param tgap The TGA parser state to update.
+/// @param encoder The image encoder to which pixel data should be written.
+/// @return The updated parser state identifier.
+internal_function int tga_rle_data(stream_decoder_t *decoder, tga_parser_state_t *tgap, image_encoder_t *encoder)
+{
+    size_t const pixel_size = tgap->PixelSize;
+    while (tgap->Rows.RowIndex < tgap->Height)
+    {
+        size_t bytes_available = decoder->amount();
+        if (tgap->PacketRemain == 0)
+        {   // read the next packet header.
+            if (bytes_available == 0)
+                break;
+            uint8_t header      = *decoder->ReadCursor++;
+            tgap->PacketRun     =(header & 0x80) != 0;
+            tgap->PacketRemain  =((header & 0x7F) + 1) * pixel_size;
+            tgap->PixelFill     = 0;
+            continue;
+        }
+        size_t row_remain      = tgap->RowSize - tgap->RowFill;
+        size_t count           =(tgap->PacketRemain < row_remain) ? tgap->PacketRemain : row_remain;
+        if (tgap->PacketRun)
+        {
+            if (tgap->PixelFill < pixel_size)
+            {   // receive the pixel to be repeated.
+                if (bytes_available == 0)
+                    break;
+                size_t bytes_to_copy = pixel_size - tgap->PixelFill;
+                if (bytes_to_copy > bytes_available) bytes_to_copy = bytes_available;
+                memcpy(&tgap->PixelBuffer[tgap->PixelFill], decoder->ReadCursor, bytes_to_copy);
+                tgap->PixelFill     += bytes_to_copy;
+                decoder->ReadCursor += bytes_to_copy;
+                continue;
+            }
+            uint8_t *dst = tgap->CurrentRow + tgap->RowFill;
+            if (pixel_size == 1)
+            {
+                memset(dst, tgap->PixelBuffer[0], count);
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i += pixel_size)
+                    memcpy(dst + i, tgap->PixelBuffer, pixel_size);
+            }
+        }
+        else
+        {   // copy literal pixels, which may be split across chunks.
+            if (bytes_available == 0)
+                break;
+            if (count > bytes_available) count = bytes_available;
+            memcpy(tgap->CurrentRow + tgap->RowFill, decoder->ReadCursor, count);
+            decoder->ReadCursor += count;
+        }
+        tgap->PacketRemain    -= count;
+        tgap->RowFill         += count;
+        if (tgap->RowFill == tgap->RowSize)
+        {   // the row is complete.
+            if (!tga_emit_row(tgap, encoder, tgap->CurrentRow))
+                return TGA_PARSE_STATE_ERROR;
+            tgap->RowFill = 0;
+        }
+    }
+    if (tgap->Rows.RowIndex < tgap->Height)
+    {   // wait for more data.
+        return TGA_PARSE_STATE_RLE_DATA;
+    }
+    return tga_finish_image(tgap, encoder);
+}
+
+/// @summary Implements the primary update tick for a streaming TGA parser.
+/// @param tgap The TGA parser state to update.
+/// @return One of tga_parser_result_e.
+internal_function int tga_parser_update(tga_parser_state_t *tgap)
+{
+    stream_decoder_t *decoder   = tgap->Config.Decoder;
+    while (tgap->CurrentState  != TGA_PARSE_STATE_COMPLETE)
+    {
+        if (tgap->CurrentState == TGA_PARSE_STATE_ERROR)
+        {   // return from the error state immediately.
+            return TGA_PARSE_RESULT_ERROR;
+        }
+        if (decoder->ReadCursor == decoder->FinalByte && !decoder->atend())
+        {   // attempt to obtain additional input data.
+            switch (decoder->refill(decoder))
+            {
+            case STREAM_REFILL_RESULT_START:
+                break;
+            case STREAM_REFILL_RESULT_YIELD:
+                return TGA_PARSE_RESULT_CONTINUE;
+            case STREAM_REFILL_RESULT_ERROR:
+                tgap->CurrentState = TGA_PARSE_STATE_ERROR;
+                tgap->ParserError  = TGA_PARSE_ERROR_DECODER;
+                return TGA_PARSE_RESULT_ERROR;
+            }
+        }
+        // perform a state update, which may consume zero or more bytes.
+        uint8_t *cursor = decoder->ReadCursor;
+        int      s      = tgap->CurrentState;
+        switch (tgap->CurrentState)
+        {
+        case TGA_PARSE_STATE_SEEK_OFFSET:
+            s = tga_seek_offset(decoder, tgap, tgap->Encoder);
+            break;
+        case TGA_PARSE_STATE_BUFFER_HEADER:
+            s = tga_buffer_header(decoder, tgap, tgap->Encoder);
+            break;
+        case TGA_PARSE_STATE_SKIP_IMAGE_ID:
+            s = tga_skip_image_id(decoder, tgap, tgap->Encoder);
+            break;
+        case TGA_PARSE_STATE_COLOR_MAP:
+            s = tga_color_map(decoder, tgap, tgap->Encoder);
+            break;
+        case TGA_PARSE_STATE_PIXEL_DATA:
+            s = tga_pixel_data(decoder, tgap, tgap->Encoder);
+            break;
+        case TGA_PARSE_STATE_RLE_DATA:
+            s = tga_rle_data(decoder, tgap, tgap->Encoder);
+            break;
+        default:
+            break;
+        }
+        if (s == tgap->CurrentState && cursor == decoder->ReadCursor && decoder->atend())
+        {   // the state needs more data, but the stream has ended.
+            s = TGA_PARSE_STATE_ERROR;
+            tgap->ParserError = TGA_PARSE_ERROR_BAD_DATA;
+        }
+        tgap->CurrentState = s;
+    }
+    return TGA_PARSE_RESULT_COMPLETE;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initializes or resets the state of a streaming TGA parser.
+/// @param tgap The streaming TGA parser state to initialize.
+/// @param config Parser configuration data indicating what portions of the file to parse.
+public_function void tga_parser_state_init(tga_parser_state_t *tgap, image_parser_config_t const &config)
+{
+    tgap->CurrentState     = TGA_PARSE_STATE_SEEK_OFFSET;
+    tgap->ParserError      = TGA_PARSE_ERROR_SUCCESS;
+    tgap->Config           = config;
+    tgap->Encoder          = NULL;
+    tgap->Metadata         = config.Metadata;
+    tgap->HeaderWritePos   = 0;
+    tgap->SkipRemain       = 0;
+    tgap->ColorMapFirst    = 0;
+    tgap->ColorMapCount    = 0;
+    tgap->ColorMapIndex    = 0;
+    tgap->EntrySize        = 0;
+    tgap->EntryBits        = 0;
+    tgap->ImageType        = 0;
+    tgap->PixelBits        = 0;
+    tgap->AlphaBits        = 0;
+    tgap->RightToLeft      = false;
+    tgap->BottomUp         = true;
+    tgap->Conversion       = TGA_CONVERT_COPY;
+    tgap->Format           = DXGI_FORMAT_UNKNOWN;
+    tgap->Width            = 0;
+    tgap->Height           = 0;
+    tgap->PixelSize        = 0;
+    tgap->RowSize          = 0;
+    tgap->RowFill          = 0;
+    tgap->OutputRowSize    = 0;
+    tgap->PacketRemain     = 0;
+    tgap->PacketRun        = false;
+    tgap->PixelFill        = 0;
+    tgap->RowMemory        = NULL;
+    tgap->CurrentRow       = NULL;
+    tgap->OutputRow        = NULL;
+    image_row_writer_init(&tgap->Rows, 0, 0, false);
+    for (size_t i = 0; i < 256; ++i)
+    {   // indices outside of the color map decode as opaque black.
+        tgap->Palette[i]   = 0xFF000000U;
+    }
+}
+
+/// @summary Frees any locally-allocated resources for a parser instance.
+/// @param tgap The streaming TGA parser state to clean up.
+public_function void tga_parser_state_cleanup(tga_parser_state_t *tgap)
+{
+    image_row_writer_free(&tgap->Rows);
+    if (tgap->RowMemory != NULL)
+    {
+        free(tgap->RowMemory);
+        tgap->RowMemory = NULL;
+    }
+    if (tgap->Encoder != NULL)
+    {
+        delete  tgap->Encoder;
+        tgap->Encoder  = NULL;
+    }
+}
@@ -0,0 +1,329 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a header-only image probe, used to build catalogs of
+/// many image files without loading any pixel data. Each probe opens a file,
+/// issues a single sector-aligned read for the first page, parses the DDS
+/// headers and returns the image definition. No image memory is allocated.
+/// Many reads are kept in flight at once, so thousands of files can be probed
+/// in the time it would take to stream a handful of them.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The number of bytes of header data required to describe a DDS file.
+#define IMAGE_PROBE_HEADER_SIZE   (sizeof(uint32_t) + sizeof(dds_header_t) + sizeof(dds_header_dxt10_t))
+
+/// @summary The size of the read buffer for a single probe. Two pages, so a
+/// header that starts near the end of a sector, as a tarball entry may, can
+/// still be read with one request on a disk with 4KB sectors.
+#define IMAGE_PROBE_BUFFER_SIZE   8192
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Defines a single header-only probe of an image file.
+struct image_probe_t
+{
+    char const               *FilePath;        /// The NULL-terminated UTF-8 virtual file path to probe.
+    uintptr_t                 ImageId;         /// The application-defined logical image identifier to set on the definition.
+    DWORD                     Result;          /// On return, ERROR_SUCCESS, ERROR_BAD_FORMAT, ERROR_OUTOFMEMORY or the system error code.
+    image_definition_t        Definition;      /// On return, the image definition. BlockOffsets hold the byte offset of each level from the start of the file. Free with image_definition_free().
+};
+
+/// @summary Maintains the state used to keep many probe reads in flight from a single thread.
+struct image_prober_t
+{
+    thread_io_t              *IO;              /// The I/O interface of the thread running the probes.
+    size_t                    SlotCount;       /// The maximum number of reads in flight.
+    size_t                    FreeCount;       /// The number of slots without a read in flight.
+    size_t                   *FreeList;        /// The indices of the slots without a read in flight.
+    size_t                   *SlotProbe;       /// The index of the probe using each slot, in the current batch.
+    vfs_file_t               *SlotFile;        /// The open file for each slot. The AIO result Identifier points into this array.
+    void                    **SlotBuffer;      /// The sector-aligned read buffer for each slot.
+    size_t                   *OffsetList;      /// Scratch storage for the level offsets returned by dds_describe().
+    size_t                    OffsetCapacity;  /// The number of values that can be stored in OffsetList.
+    io_buffer_allocator_t     BufferPool;      /// The pool of sector-aligned read buffers.
+    aio_result_alloc_t        ResultAlloc;     /// The FIFO node allocator used by the AIO driver to post read results.
+    aio_result_queue_t        ResultQueue;     /// The SPSC unbounded FIFO where the AIO driver posts read results.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Opens the file for a probe and submits the read for the first page.
+/// @param prober The prober state.
+/// @param probe_index The zero-based index of the probe in the current batch.
+/// @param probe The probe to start.
+/// @return ERROR_SUCCESS if the read was submitted, or the reason the probe failed.
+internal_function DWORD image_probe_start(image_prober_t *prober, size_t probe_index, image_probe_t &probe)
+{
+    size_t      slot  = prober->FreeList[prober->FreeCount - 1];
+    vfs_file_t *file  =&prober->SlotFile[slot];
+    DWORD       error = prober->IO->open_file(probe.FilePath, VFS_FILE_HINT_UNBUFFERED | VFS_FILE_HINT_ASYNCHRONOUS, VFS_DECODER_HINT_NONE, file);
+    if (error != ERROR_SUCCESS)
+    {   // the file doesn't exist or can't be opened.
+        return error;
+    }
+
+    // the header may not start on a sector boundary within an archive.
+    // read every sector that overlaps the header with one request.
+    size_t  sector_size = image_max2<size_t>(file->SectorSize, 1);
+    int64_t read_offset = file->BaseOffset - (file->BaseOffset % int64_t(sector_size));
+    size_t  read_size   = align_up(size_t(file->BaseOffset - read_offset) + IMAGE_PROBE_HEADER_SIZE, sector_size);
+    if (read_size > prober->BufferPool.AllocSize)
+    {   // the sector size is too large for the probe buffers.
+        prober->IO->close_file(file);
+        return ERROR_NOT_SUPPORTED;
+    }
+    error = prober->IO->read_async(file, read_offset, prober->SlotBuffer[slot], read_size, 0, AIO_CLOSE_ON_COMPLETE, &prober->ResultQueue, &prober->ResultAlloc);
+    if (error != ERROR_SUCCESS)
+    {   // the read couldn't be submitted, so the file handle won't be closed by the AIO driver.
+        prober->IO->close_file(file);
+        return error;
+    }
+    prober->SlotProbe[slot] = probe_index;
+    prober->FreeCount--;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Parses the DDS headers read for a probe and builds the image definition.
+/// @param prober The prober state.
+/// @param file The file that was read. The file handle has already been closed by the AIO driver.
+/// @param result The result of the read operation.
+/// @param probe The probe to complete.
+/// @return ERROR_SUCCESS, ERROR_BAD_FORMAT, ERROR_OUTOFMEMORY or the system error code returned by the read.
+internal_function DWORD image_probe_finish(image_prober_t *prober, vfs_file_t const *file, aio_result_t const &result, image_probe_t &probe)
+{
+    if (FAILED(result.OSError))
+    {   // the read operation failed.
+        return result.OSError;
+    }
+
+    // locate the start of the file data within the sector-aligned read.
+    dds_header_t        dds;
+    dds_header_dxt10_t  dx10;
+    size_t              skip = size_t(file->BaseOffset - result.FileOffset);
+    uint8_t const      *data =(uint8_t const*) result.DataBuffer + skip;
+    size_t              size =(result.DataAmount > skip) ? result.DataAmount - skip : 0;
+    if (int64_t(size) > file->BaseSize) size = size_t(file->BaseSize);
+    if (!dds_header(data, size, &dds))
+    {   // the file is not a DDS file, or is truncated.
+        return ERROR_BAD_FORMAT;
+    }
+    bool has_dx10 = dds_header_dxt10(data, size, &dx10);
+    if (!dds_image_definition(&probe.Definition, probe.ImageId, &dds, has_dx10 ? &dx10 : NULL, IMAGE_COMPRESSION_NONE, IMAGE_ENCODING_RAW))
+    {   // unable to allocate the level descriptors and offsets.
+        return ERROR_OUTOFMEMORY;
+    }
+
+    // record where each level of each element starts in the file.
+    size_t noffsets = probe.Definition.ElementCount * probe.Definition.LevelCount;
+    if (noffsets > prober->OffsetCapacity)
+    {   // grow the scratch offset list.
+        size_t *list = (size_t*) realloc(prober->OffsetList, noffsets * sizeof(size_t));
+        if (list == NULL)
+        {
+            image_definition_free(&probe.Definition);
+            return ERROR_OUTOFMEMORY;
+        }
+        prober->OffsetList     = list;
+        prober->OffsetCapacity = noffsets;
+    }
+    dds_describe(data, size, &dds, has_dx10 ? &dx10 : NULL, probe.Definition.LevelInfo, prober->OffsetList, probe.Definition.LevelCount);
+    for (size_t i = 0; i < noffsets; ++i)
+    {
+        probe.Definition.BlockOffsets[i].FileOffset   = int64_t(prober->OffsetList[i]);
+        probe.Definition.BlockOffsets[i].DecodeOffset = 0;
+    }
+    return ERROR_SUCCESS;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initializes a prober for use on the calling thread.
+/// @param prober The prober state to initialize.
+/// @param io The I/O interface of the calling thread.
+/// @param max_active The maximum number of reads to keep in flight.
+/// @return ERROR_SUCCESS, ERROR_INVALID_PARAMETER or ERROR_OUTOFMEMORY.
+public_function DWORD image_prober_create(image_prober_t *prober, thread_io_t *io, size_t max_active)
+{
+    prober->IO             = io;
+    prober->SlotCount      = 0;
+    prober->FreeCount      = 0;
+    prober->FreeList       = NULL;
+    prober->SlotProbe      = NULL;
+    prober->SlotFile       = NULL;
+    prober->SlotBuffer     = NULL;
+    prober->OffsetList     = NULL;
+    prober->OffsetCapacity = 0;
+    aio_create_result_queue(&prober->ResultQueue, &prober->ResultAlloc);
+    if (io == NULL || max_active == 0)
+    {   // at least one read must be allowed in flight.
+        return ERROR_INVALID_PARAMETER;
+    }
+    // the prober is used only on the calling thread, so place the read buffers on that thread's node.
+    if (!prober->BufferPool.reserve(max_active * IMAGE_PROBE_BUFFER_SIZE, IMAGE_PROBE_BUFFER_SIZE, win32_numa_current_node()))
+    {   // unable to reserve the read buffers.
+        return ERROR_OUTOFMEMORY;
+    }
+
+    size_t       *freel = (size_t      *) malloc(max_active * sizeof(size_t));
+    size_t       *probe = (size_t      *) malloc(max_active * sizeof(size_t));
+    vfs_file_t   *files = (vfs_file_t  *) malloc(max_active * sizeof(vfs_file_t));
+    void        **bufs  = (void       **) malloc(max_active * sizeof(void*));
+    if (freel == NULL || probe == NULL || files == NULL || bufs == NULL)
+    {
+        free(bufs); free(files); free(probe); free(freel);
+        prober->BufferPool.release();
+        return ERROR_OUTOFMEMORY;
+    }
+    for (size_t i = 0; i < max_active; ++i)
+    {
+        freel[i] = max_active - 1 - i;
+        probe[i] = 0;
+        bufs [i] = prober->BufferPool.get_buffer();
+    }
+    prober->SlotCount  = max_active;
+    prober->FreeCount  = max_active;
+    prober->FreeList   = freel;
+    prober->SlotProbe  = probe;
+    prober->SlotFile   = files;
+    prober->SlotBuffer = bufs;
+    return ERROR_SUCCESS;
+}
+
+/// @summary Frees all resources associated with a prober. No probes may be in progress.
+/// @param prober The prober state to delete.
+public_function void image_prober_delete(image_prober_t *prober)
+{
+    for (size_t i = 0, n = prober->SlotCount; i < n; ++i)
+    {
+        prober->BufferPool.put_buffer(prober->SlotBuffer[i]);
+    }
+    prober->BufferPool.release();
+    aio_delete_result_queue(&prober->ResultQueue, &prober->ResultAlloc);
+    free(prober->OffsetList);
+    free(prober->SlotBuffer);
+    free(prober->SlotFile);
+    free(prober->SlotProbe);
+    free(prober->FreeList);
+    prober->SlotCount      = 0;
+    prober->FreeCount      = 0;
+    prober->FreeList       = NULL;
+    prober->SlotProbe      = NULL;
+    prober->SlotFile       = NULL;
+    prober->SlotBuffer     = NULL;
+    prober->OffsetList     = NULL;
+    prober->OffsetCapacity = 0;
+}
+
+/// @summary Probes a batch of image files, reading only the first page of each. Up to max_active reads are kept in flight.
+/// The function returns once every probe has completed; no reads remain in flight.
+/// @param prober The prober state.
+/// @param probes The probes to run. The FilePath and ImageId fields must be set; on return, the Result and Definition fields are set.
+/// @param count The number of probes.
+/// @return The number of probes that completed successfully.
+public_function size_t image_probe_files(image_prober_t *prober, image_probe_t *probes, size_t count)
+{
+    size_t next = 0;
+    size_t done = 0;
+    size_t good = 0;
+    while (done < count)
+    {   // submit reads for as many probes as there are free slots.
+        while (next < count && prober->FreeCount > 0)
+        {
+            image_probe_t &probe = probes[next];
+            image_definition_init(&probe.Definition);
+            if ((probe.Result = image_probe_start(prober, next, probe)) != ERROR_SUCCESS)
+            {   // the probe failed before any I/O was submitted.
+                done++;
+            }
+            next++;
+        }
+
+        // process all completed reads, returning their slots to the free list.
+        aio_result_t result;
+        bool         idle = true;
+        while (spsc_fifo_u_consume(&prober->ResultQueue, result))
+        {
+            vfs_file_t    *file  = (vfs_file_t*) result.Identifier;
+            size_t         slot  = size_t(file - prober->SlotFile);
+            image_probe_t &probe = probes[prober->SlotProbe[slot]];
+            if ((probe.Result = image_probe_finish(prober, file, result, probe)) == ERROR_SUCCESS)
+            {
+                good++;
+            }
+            prober->FreeList[prober->FreeCount++] = slot;
+            idle = false;
+            done++;
+        }
+        if (idle && done < count)
+        {   // all slots are busy or waiting on the disk; give up the timeslice.
+            SwitchToThread();
+        }
+    }
+    return good;
+}
+
+/// @summary Measure the throughput of the header-only probe over a set of files, such as every file in a directory or tarball mount.
+/// @param io The I/O interface of the calling thread.
+/// @param paths The NULL-terminated UTF-8 virtual paths of the files to probe.
+/// @param count The number of paths.
+/// @param max_active The maximum number of reads to keep in flight.
+/// @param num_good If non-NULL, on return, set to the number of files that were probed successfully.
+/// @return The probe throughput, in files per-second, or zero if memory allocation fails.
+public_function double image_probe_benchmark(thread_io_t *io, char const **paths, size_t count, size_t max_active, size_t *num_good)
+{
+    LARGE_INTEGER  frequency, start, end;
+    image_prober_t prober;
+    image_probe_t *probes = (image_probe_t*) malloc(count * sizeof(image_probe_t));
+    double         rate   = 0.0;
+    size_t         good   = 0;
+    if (num_good != NULL) *num_good = 0;
+    if (probes == NULL || count == 0)
+    {
+        free(probes);
+        return 0.0;
+    }
+    if (image_prober_create(&prober, io, max_active) != ERROR_SUCCESS)
+    {
+        image_prober_delete(&prober);
+        free(probes);
+        return 0.0;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        probes[i].FilePath = paths[i];
+        probes[i].ImageId  = i;
+    }
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    good = image_probe_files(&prober, probes, count);
+    QueryPerformanceCounter(&end);
+    double seconds = double(end.QuadPart - start.QuadPart) / double(frequency.QuadPart);
+    if (seconds > 0.0)
+    {
+        rate = double(count) / seconds;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        image_definition_free(&probes[i].Definition);
+    }
+    image_prober_delete(&prober);
+    free(probes);
+    if (num_good != NULL) *num_good = good;
+    return rate;
+}
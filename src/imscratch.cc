@@ -0,0 +1,347 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements the IMAGE_ENCODING_LZ storage format and a small pool of
+/// scratch buffers into which LZ-encoded frames are decoded when they are used.
+/// Each mipmap level of an LZ-encoded element is stored as a sequence of chunks,
+/// each compressed independently with the LZ block codec, so that a level can
+/// be decoded without decoding the rest of the element. The scratch pool is not
+/// thread-safe; it is owned by the thread that consumes the decoded frames,
+/// typically the presentation thread, and keeps recently-released frames
+/// decoded so that a frame locked on consecutive presentation frames is
+/// decoded only once.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary Define the maximum number of uncompressed bytes in a single chunk of an LZ-encoded level.
+#ifndef IMAGE_LZ_CHUNK_SIZE
+#define IMAGE_LZ_CHUNK_SIZE         (256U * 1024U)
+#endif
+
+/// @summary Define the default number of idle scratch bytes retained by a scratch pool.
+#ifndef IMAGE_SCRATCH_RETAIN_LIMIT
+#define IMAGE_SCRATCH_RETAIN_LIMIT  (64U * 1024U * 1024U)
+#endif
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Defines the header preceding each chunk of an LZ-encoded level.
+/// A chunk whose StoredSize equals its RawSize did not compress, and is stored as-is.
+struct image_lz_chunk_t
+{
+    uint32_t             RawSize;         /// The number of bytes of level data in the chunk, when decoded.
+    uint32_t             StoredSize;      /// The number of bytes of chunk data following the header.
+};
+
+/// @summary Defines the data associated with a single scratch buffer.
+struct image_scratch_slot_t
+{
+    uintptr_t            ImageId;         /// The application-defined identifier of the image decoded into the slot.
+    size_t               FrameIndex;      /// The zero-based index of the frame decoded into the slot, or IMAGE_ALL_FRAMES if the slot is empty.
+    size_t               LockCount;       /// The number of outstanding acquisitions of the slot.
+    uint64_t             LastUse;         /// The pool clock value when the slot was last acquired.
+    size_t               DataSize;        /// The number of bytes of decoded frame data.
+    size_t               Capacity;        /// The number of bytes allocated for Data.
+    uint8_t             *Data;            /// The decoded frame data.
+};
+
+/// @summary Defines the state associated with a pool of scratch buffers. Slots are found by linear search; the pool is expected to be small.
+struct image_scratch_pool_t
+{
+    size_t               SlotCount;       /// The number of slots that have been used.
+    size_t               SlotCapacity;    /// The maximum number of slots, and the maximum number of frames that can be acquired at once.
+    image_scratch_slot_t*SlotList;        /// The list of scratch slots.
+    uint64_t             Clock;           /// Incremented on each acquisition; used for least-recently-used replacement.
+    size_t               BytesIdle;       /// The number of bytes allocated for slots that are not acquired.
+    size_t               RetainLimit;     /// The maximum value of BytesIdle. Idle buffers beyond this amount are freed.
+    uint64_t             DecodeCount;     /// The number of frames decoded into the pool.
+    uint64_t             ReuseCount;      /// The number of acquisitions satisfied by an already-decoded frame.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Free the buffers of idle slots, least-recently used first, until the idle byte count is within the retain limit.
+/// @param pool The scratch pool.
+internal_function void image_scratch_trim(image_scratch_pool_t *pool)
+{
+    while (pool->BytesIdle > pool->RetainLimit)
+    {
+        size_t oldest = pool->SlotCount;
+        for (size_t i = 0, n = pool->SlotCount; i < n; ++i)
+        {
+            image_scratch_slot_t &s = pool->SlotList[i];
+            if (s.LockCount == 0 && s.Data != NULL && (oldest == n || s.LastUse < pool->SlotList[oldest].LastUse))
+                oldest = i;
+        }
+        if (oldest == pool->SlotCount)
+            break;
+        image_scratch_slot_t &s = pool->SlotList[oldest];
+        pool->BytesIdle -= s.Capacity;
+        free(s.Data);
+        s.Data       = NULL;
+        s.Capacity   = 0;
+        s.DataSize   = 0;
+        s.FrameIndex = IMAGE_ALL_FRAMES;
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Calculate the maximum number of bytes required to store a level with LZ encoding, which occurs when no chunk compresses.
+/// @param raw_size The size of the level data, in bytes.
+/// @return The maximum size of the LZ-encoded level data, in bytes.
+public_function inline size_t image_lz_level_bound(size_t raw_size)
+{
+    size_t chunks = (raw_size + IMAGE_LZ_CHUNK_SIZE - 1) / IMAGE_LZ_CHUNK_SIZE;
+    return raw_size + chunks * sizeof(image_lz_chunk_t);
+}
+
+/// @summary Calculate the number of bytes of address space to reserve per-element for an LZ-encoded image.
+/// @param def The image definition, describing the uncompressed levels.
+/// @return The maximum size of an LZ-encoded element, in bytes.
+public_function size_t image_lz_element_bound(image_definition_t const *def)
+{
+    size_t total = 0;
+    for (size_t i = 0, n = def->LevelCount; i < n; ++i)
+    {
+        total += image_lz_level_bound(def->LevelInfo[i].Slices * def->LevelInfo[i].BytesPerSlice);
+    }
+    return total;
+}
+
+/// @summary Encode one chunk of level data.
+/// @param dst The output buffer, which must be at least sizeof(image_lz_chunk_t) + src_size bytes.
+/// @param src The level data.
+/// @param src_size The number of bytes of level data, at most IMAGE_LZ_CHUNK_SIZE.
+/// @return The number of bytes written to dst, including the chunk header.
+public_function size_t image_lz_encode_chunk(void *dst, void const *src, size_t src_size)
+{
+    image_lz_chunk_t *hdr  = (image_lz_chunk_t*) dst;
+    uint8_t          *data = (uint8_t*) dst + sizeof(image_lz_chunk_t);
+    size_t            size =  lz_compress(data, src_size - 1, src, src_size);
+    if (size == 0)
+    {   // the chunk didn't compress; store it as-is.
+        memcpy(data, src, src_size);
+        size = src_size;
+    }
+    hdr->RawSize    = uint32_t(src_size);
+    hdr->StoredSize = uint32_t(size);
+    return sizeof(image_lz_chunk_t) + size;
+}
+
+/// @summary Decode LZ-encoded level data. Chunks are decoded until dst_size bytes have been produced, so consecutive levels may be decoded with one call.
+/// @param dst The output buffer.
+/// @param dst_size The number of bytes of decoded data expected.
+/// @param src The LZ-encoded data.
+/// @param src_size The maximum number of bytes of LZ-encoded data that may be read.
+/// @param src_used On return, the number of bytes of LZ-encoded data consumed.
+/// @return true if exactly dst_size bytes were decoded, or false if the data is malformed.
+public_function bool image_lz_decode(void *dst, size_t dst_size, void const *src, size_t src_size, size_t &src_used)
+{
+    uint8_t const *ip   = (uint8_t const*) src;
+    uint8_t const *iend = ip + src_size;
+    uint8_t       *op   = (uint8_t*) dst;
+    uint8_t       *oend = op + dst_size;
+    src_used = 0;
+    while (op < oend)
+    {
+        image_lz_chunk_t hdr;
+        if (size_t(iend - ip) < sizeof(image_lz_chunk_t))
+            return false;
+        memcpy(&hdr, ip, sizeof(image_lz_chunk_t));
+        ip += sizeof(image_lz_chunk_t);
+        if (hdr.RawSize == 0 || hdr.RawSize > size_t(oend - op) || hdr.StoredSize > hdr.RawSize || hdr.StoredSize > size_t(iend - ip))
+            return false;
+        if (hdr.StoredSize == hdr.RawSize)
+        {   // the chunk was stored as-is.
+            memcpy(op, ip, hdr.RawSize);
+        }
+        else if (lz_decompress(op, hdr.RawSize, ip, hdr.StoredSize) != hdr.RawSize)
+        {   // the chunk data is corrupt.
+            return false;
+        }
+        ip += hdr.StoredSize;
+        op += hdr.RawSize;
+    }
+    src_used = size_t(ip - (uint8_t const*) src);
+    return true;
+}
+
+/// @summary Initialize a scratch pool.
+/// @param pool The scratch pool to initialize.
+/// @param max_frames The maximum number of frames that may be acquired at the same time.
+/// @param retain_limit The maximum number of bytes of decoded data kept for frames that are not acquired.
+public_function void image_scratch_pool_create(image_scratch_pool_t *pool, size_t max_frames, size_t retain_limit=IMAGE_SCRATCH_RETAIN_LIMIT)
+{
+    pool->SlotCount    = 0;
+    pool->SlotCapacity = 0;
+    pool->SlotList     = (image_scratch_slot_t*) malloc(max_frames * sizeof(image_scratch_slot_t));
+    pool->Clock        = 0;
+    pool->BytesIdle    = 0;
+    pool->RetainLimit  = retain_limit;
+    pool->DecodeCount  = 0;
+    pool->ReuseCount   = 0;
+    if (pool->SlotList != NULL)
+    {   // the pool is usable.
+        pool->SlotCapacity = max_frames;
+    }
+}
+
+/// @summary Free all resources associated with a scratch pool. Any pointers returned by image_scratch_acquire become invalid.
+/// @param pool The scratch pool to delete.
+public_function void image_scratch_pool_delete(image_scratch_pool_t *pool)
+{
+    for (size_t i = 0, n = pool->SlotCount; i < n; ++i)
+    {
+        free(pool->SlotList[i].Data);
+    }
+    free(pool->SlotList);
+    pool->SlotList     = NULL;
+    pool->SlotCount    = 0;
+    pool->SlotCapacity = 0;
+    pool->BytesIdle    = 0;
+}
+
+/// @summary Retrieve the uncompressed data for a locked frame. Frames stored with IMAGE_ENCODING_RAW are returned as-is.
+/// Frames stored with IMAGE_ENCODING_LZ are decoded into a scratch buffer, unless the frame is already decoded in the pool.
+/// @param pool The scratch pool.
+/// @param image_id The application-defined image identifier.
+/// @param frame_index The zero-based index of the frame.
+/// @param encoding One of image_encoding_e specifying the storage encoding of the frame.
+/// @param levels The LevelCount descriptors of the frame mipmap levels. The DataSize fields specify the uncompressed level sizes.
+/// @param level_count The number of levels in the frame.
+/// @param src The locked frame data.
+/// @param src_size The number of bytes of locked frame data.
+/// @param data_size On return, the number of bytes of uncompressed frame data.
+/// @param error On return, ERROR_SUCCESS, ERROR_NOT_SUPPORTED, ERROR_NOT_ENOUGH_MEMORY or ERROR_INVALID_DATA.
+/// @return A pointer to the uncompressed frame data, or NULL. Call image_scratch_release when the data is no longer needed.
+public_function void* image_scratch_acquire(image_scratch_pool_t *pool, uintptr_t image_id, size_t frame_index, int encoding, dds_level_desc_t const *levels, size_t level_count, void const *src, size_t src_size, size_t &data_size, uint32_t &error)
+{
+    if (encoding == IMAGE_ENCODING_RAW)
+    {   // there's nothing to decode.
+        data_size = src_size;
+        error     = ERROR_SUCCESS;
+        return (void*) src;
+    }
+    if (encoding != IMAGE_ENCODING_LZ)
+    {   // the encoding isn't one that can be decoded here.
+        data_size = 0;
+        error     = ERROR_NOT_SUPPORTED;
+        return NULL;
+    }
+    size_t raw_size = 0;
+    for (size_t i = 0; i < level_count; ++i)
+    {
+        raw_size += levels[i].DataSize;
+    }
+    size_t victim = pool->SlotCapacity;
+    for (size_t i = 0, n = pool->SlotCount; i < n; ++i)
+    {
+        image_scratch_slot_t &s = pool->SlotList[i];
+        if (s.ImageId == image_id && s.FrameIndex == frame_index && s.DataSize == raw_size)
+        {   // the frame is still decoded from an earlier acquisition.
+            if (s.LockCount++ == 0) pool->BytesIdle -= s.Capacity;
+            s.LastUse  = pool->Clock++;
+            data_size  = s.DataSize;
+            error      = ERROR_SUCCESS;
+            pool->ReuseCount++;
+            return s.Data;
+        }
+        if (s.LockCount == 0 && (victim == pool->SlotCapacity || s.LastUse < pool->SlotList[victim].LastUse))
+        {   // this is the least-recently used idle slot so far.
+            victim = i;
+        }
+    }
+    if (pool->SlotCount < pool->SlotCapacity)
+    {   // prefer an unused slot to discarding a decoded frame.
+        victim = pool->SlotCount++;
+        memset(&pool->SlotList[victim], 0, sizeof(image_scratch_slot_t));
+        pool->SlotList[victim].FrameIndex = IMAGE_ALL_FRAMES;
+    }
+    if (victim == pool->SlotCapacity)
+    {   // every slot is in use.
+        data_size = 0;
+        error     = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+    image_scratch_slot_t &s = pool->SlotList[victim];
+    pool->BytesIdle -= s.Capacity;
+    s.FrameIndex     = IMAGE_ALL_FRAMES;
+    s.DataSize       = 0;
+    if (s.Capacity < raw_size)
+    {   // grow the scratch buffer. the old contents are not needed.
+        free(s.Data);
+        s.Data       = (uint8_t*) malloc(raw_size);
+        s.Capacity   = (s.Data != NULL) ? raw_size : 0;
+    }
+    size_t src_used  = 0;
+    if (s.Data == NULL || !image_lz_decode(s.Data, raw_size, src, src_size, src_used))
+    {   // the slot remains idle and empty.
+        pool->BytesIdle += s.Capacity;
+        data_size = 0;
+        error     = (s.Data == NULL) ? ERROR_NOT_ENOUGH_MEMORY : ERROR_INVALID_DATA;
+        return NULL;
+    }
+    s.ImageId    = image_id;
+    s.FrameIndex = frame_index;
+    s.LockCount  = 1;
+    s.LastUse    = pool->Clock++;
+    s.DataSize   = raw_size;
+    data_size    = raw_size;
+    error        = ERROR_SUCCESS;
+    pool->DecodeCount++;
+    return s.Data;
+}
+
+/// @summary Release a frame acquired with image_scratch_acquire. The decoded data is retained for reuse, subject to the retain limit.
+/// @param pool The scratch pool.
+/// @param image_id The application-defined image identifier.
+/// @param frame_index The zero-based index of the frame.
+public_function void image_scratch_release(image_scratch_pool_t *pool, uintptr_t image_id, size_t frame_index)
+{
+    for (size_t i = 0, n = pool->SlotCount; i < n; ++i)
+    {
+        image_scratch_slot_t &s = pool->SlotList[i];
+        if (s.ImageId == image_id && s.FrameIndex == frame_index && s.LockCount > 0)
+        {
+            if (--s.LockCount == 0)
+            {   // the slot is idle, but keeps the decoded frame.
+                pool->BytesIdle += s.Capacity;
+                image_scratch_trim(pool);
+            }
+            return;
+        }
+    }
+}
+
+/// @summary Discard any decoded copy of a frame, for example, because the frame was reloaded with different content.
+/// @param pool The scratch pool.
+/// @param image_id The application-defined image identifier.
+/// @param frame_index The zero-based index of the frame.
+public_function void image_scratch_discard(image_scratch_pool_t *pool, uintptr_t image_id, size_t frame_index)
+{
+    for (size_t i = 0, n = pool->SlotCount; i < n; ++i)
+    {
+        image_scratch_slot_t &s = pool->SlotList[i];
+        if (s.ImageId == image_id && s.FrameIndex == frame_index && s.LockCount == 0)
+        {   // keep the buffer for reuse, but forget the frame.
+            s.FrameIndex = IMAGE_ALL_FRAMES;
+            s.DataSize   = 0;
+        }
+    }
+}
@@ -0,0 +1,356 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Defines a bounded, compressed, in-memory tier for image elements
+/// evicted from image memory. Just before an element is decommitted, a copy is
+/// compressed with the LZ block codec and retained here. A later lock or load
+/// of the element decompresses the copy in place of re-reading the source file.
+/// Elements that are unlikely to compress (block-compressed formats and data
+/// with high byte entropy) are not admitted. The tier is not thread-safe; it
+/// is accessed only under the TierLock of the associated image memory.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary Define the maximum estimated entropy, in bits per-byte, of an element admitted to the tier.
+#ifndef IMAGE_TIER_MAX_ENTROPY
+#define IMAGE_TIER_MAX_ENTROPY      7.5f
+#endif
+
+/// @summary Define the maximum number of bytes sampled when estimating the entropy of an element.
+#ifndef IMAGE_TIER_ENTROPY_SAMPLES
+#define IMAGE_TIER_ENTROPY_SAMPLES  65536U
+#endif
+
+/// @summary Elements must compress to at most (N-1)/N of their original size to be admitted.
+#ifndef IMAGE_TIER_MIN_SAVINGS
+#define IMAGE_TIER_MIN_SAVINGS      8U
+#endif
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Defines the data associated with a single compressed image element.
+struct image_tier_entry_t
+{
+    uintptr_t            ImageId;         /// The application-defined image identifier.
+    size_t               Element;         /// The zero-based index of the image element.
+    size_t               RawSize;         /// The size of the element data when decompressed, in bytes.
+    size_t               StoredSize;      /// The size of the compressed element data, in bytes.
+    uint64_t             LastUse;         /// The tier clock value at the time the entry was admitted.
+    void                *Data;            /// The compressed element data.
+};
+
+/// @summary Defines the statistics reported for a compressed tier.
+struct image_tier_stats_t
+{
+    size_t               BytesLimit;      /// The maximum number of bytes of compressed data retained.
+    size_t               BytesUsed;       /// The number of bytes of compressed data currently retained.
+    size_t               BytesRaw;        /// The uncompressed size of the data currently retained.
+    size_t               EntryCount;      /// The number of elements currently retained.
+    uint64_t             AdmitCount;      /// The number of elements compressed into the tier.
+    uint64_t             RejectCount;     /// The number of elements not admitted by the admission rule.
+    uint64_t             DropCount;       /// The number of elements discarded to make room for newer elements.
+    uint64_t             HitCount;        /// The number of elements restored from the tier.
+    uint64_t             MissCount;       /// The number of retained elements that could not be restored.
+    float                CompressionRatio;/// BytesRaw / BytesUsed, or 0 if the tier is empty.
+    float                HitRate;         /// HitCount / (HitCount + MissCount), or 0 if there have been no requests.
+};
+
+/// @summary Defines the state associated with a compressed tier. Entries are
+/// found by linear search; the number of entries is bounded by the tier size.
+struct image_tier_t
+{
+    size_t               BytesLimit;      /// The maximum number of bytes of compressed data retained.
+    size_t               BytesUsed;       /// The number of bytes of compressed data currently retained.
+    size_t               BytesRaw;        /// The uncompressed size of the data currently retained.
+    uint64_t             Clock;           /// Incremented on each admission; used for least-recently-used replacement.
+    size_t               EntryCount;      /// The number of valid entries in EntryList.
+    size_t               EntryCapacity;   /// The number of entries that can be stored without reallocating.
+    image_tier_entry_t  *EntryList;       /// The list of retained elements.
+    size_t               ScratchSize;     /// The size of the compression scratch buffer, in bytes. Not counted against BytesLimit.
+    uint8_t             *Scratch;         /// The compression scratch buffer.
+    uint64_t             AdmitCount;      /// The number of elements compressed into the tier.
+    uint64_t             RejectCount;     /// The number of elements not admitted by the admission rule.
+    uint64_t             DropCount;       /// The number of elements discarded to make room for newer elements.
+    uint64_t             HitCount;        /// The number of elements restored from the tier.
+    uint64_t             MissCount;       /// The number of retained elements that could not be restored.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Search for the entry corresponding to an image element.
+/// @param tier The compressed tier to search.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the image element.
+/// @param index On return, stores the zero-based index of the entry in EntryList.
+/// @return true if the element is retained in the tier.
+internal_function bool image_tier_find(image_tier_t *tier, uintptr_t image_id, size_t element, size_t &index)
+{
+    for (size_t i = 0, n = tier->EntryCount; i < n; ++i)
+    {
+        if (tier->EntryList[i].ImageId == image_id && tier->EntryList[i].Element == element)
+        {
+            index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @summary Free the data associated with an entry and remove it from the entry list.
+/// @param tier The compressed tier that owns the entry.
+/// @param index The zero-based index of the entry in EntryList.
+internal_function void image_tier_remove(image_tier_t *tier, size_t index)
+{
+    image_tier_entry_t &e = tier->EntryList[index];
+    tier->BytesUsed -= e.StoredSize;
+    tier->BytesRaw  -= e.RawSize;
+    free(e.Data);
+    array_swap(tier->EntryList, index, tier->EntryCount - 1);
+    tier->EntryCount--;
+}
+
+/// @summary Discard the least-recently admitted entries until a given number of bytes are available.
+/// @param tier The compressed tier.
+/// @param size The number of bytes of compressed data that must fit in the tier.
+internal_function void image_tier_make_room(image_tier_t *tier, size_t size)
+{
+    while (tier->EntryCount > 0 && (tier->BytesUsed + size) > tier->BytesLimit)
+    {
+        size_t oldest = 0;
+        for (size_t i = 1, n = tier->EntryCount; i < n; ++i)
+        {
+            if (tier->EntryList[i].LastUse < tier->EntryList[oldest].LastUse)
+                oldest = i;
+        }
+        image_tier_remove(tier, oldest);
+        tier->DropCount++;
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize a compressed tier.
+/// @param tier The compressed tier to initialize.
+/// @param size_limit The maximum number of bytes of compressed data to retain. Specify zero to disable the tier.
+public_function void image_tier_create(image_tier_t *tier, size_t size_limit)
+{
+    tier->BytesLimit    = size_limit;
+    tier->BytesUsed     = 0;
+    tier->BytesRaw      = 0;
+    tier->Clock         = 0;
+    tier->EntryCount    = 0;
+    tier->EntryCapacity = 0;
+    tier->EntryList     = NULL;
+    tier->ScratchSize   = 0;
+    tier->Scratch       = NULL;
+    tier->AdmitCount    = 0;
+    tier->RejectCount   = 0;
+    tier->DropCount     = 0;
+    tier->HitCount      = 0;
+    tier->MissCount     = 0;
+}
+
+/// @summary Free all resources associated with a compressed tier.
+/// @param tier The compressed tier to delete.
+public_function void image_tier_delete(image_tier_t *tier)
+{
+    for (size_t i = 0, n = tier->EntryCount; i < n; ++i)
+    {
+        free(tier->EntryList[i].Data);
+    }
+    free(tier->EntryList);
+    free(tier->Scratch);
+    tier->BytesUsed     = 0;
+    tier->BytesRaw      = 0;
+    tier->EntryCount    = 0;
+    tier->EntryCapacity = 0;
+    tier->EntryList     = NULL;
+    tier->ScratchSize   = 0;
+    tier->Scratch       = NULL;
+}
+
+/// @summary Attempt to compress an image element into the tier. Any existing copy of the element is replaced.
+/// @param tier The compressed tier.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the image element.
+/// @param format One of dxgi_format_e specifying the storage format of the element data.
+/// @param data The element data. This must remain valid only for the duration of the call.
+/// @param size The number of bytes of element data.
+/// @return true if the element was admitted to the tier.
+public_function bool image_tier_admit(image_tier_t *tier, uintptr_t image_id, size_t element, uint32_t format, void const *data, size_t size)
+{
+    size_t index;
+    if (image_tier_find(tier, image_id, element, index))
+    {   // discard the existing copy; it's out-of-date.
+        image_tier_remove(tier, index);
+    }
+    if (size == 0 || size > tier->BytesLimit || size >= LZ_MAX_BLOCK_SIZE)
+    {   // the tier is disabled, or the element could never fit.
+        tier->RejectCount++;
+        return false;
+    }
+    if (dxgi_block_compressed(format))
+    {   // block-compressed data is already compressed; LZ won't help.
+        tier->RejectCount++;
+        return false;
+    }
+    if (lz_estimate_entropy(data, size, IMAGE_TIER_ENTROPY_SAMPLES) > IMAGE_TIER_MAX_ENTROPY)
+    {   // noisy data (photographic, dithered, etc.) is unlikely to compress.
+        tier->RejectCount++;
+        return false;
+    }
+    size_t max_size = size - (size / IMAGE_TIER_MIN_SAVINGS);
+    if (tier->ScratchSize < max_size)
+    {   // grow the scratch buffer; it's retained for future admissions.
+        uint8_t *buf = (uint8_t*) realloc(tier->Scratch, max_size);
+        if (buf == NULL)
+        {   // not enough memory to compress the element.
+            tier->RejectCount++;
+            return false;
+        }
+        tier->Scratch     = buf;
+        tier->ScratchSize = max_size;
+    }
+    size_t stored_size = lz_compress(tier->Scratch, max_size, data, size);
+    if (stored_size == 0 || stored_size > tier->BytesLimit)
+    {   // the element didn't compress well enough to be worth keeping.
+        tier->RejectCount++;
+        return false;
+    }
+    void  *stored_data = malloc(stored_size);
+    if (stored_data == NULL)
+    {   // not enough memory to retain the element.
+        tier->RejectCount++;
+        return false;
+    }
+    memcpy(stored_data, tier->Scratch, stored_size);
+    image_tier_make_room(tier, stored_size);
+    if (tier->EntryCount == tier->EntryCapacity)
+    {   // grow the entry list.
+        size_t new_amount = calculate_capacity(tier->EntryCapacity, tier->EntryCapacity+1, 64, 64);
+        image_tier_entry_t *list = (image_tier_entry_t*) realloc(tier->EntryList, new_amount * sizeof(image_tier_entry_t));
+        if (list == NULL)
+        {   // not enough memory to grow the entry list.
+            free(stored_data);
+            tier->RejectCount++;
+            return false;
+        }
+        tier->EntryList     = list;
+        tier->EntryCapacity = new_amount;
+    }
+    image_tier_entry_t &e = tier->EntryList[tier->EntryCount++];
+    e.ImageId          = image_id;
+    e.Element          = element;
+    e.RawSize          = size;
+    e.StoredSize       = stored_size;
+    e.LastUse          = tier->Clock++;
+    e.Data             = stored_data;
+    tier->BytesUsed   += stored_size;
+    tier->BytesRaw    += size;
+    tier->AdmitCount++;
+    return true;
+}
+
+/// @summary Determine whether the tier retains a copy of an image element.
+/// @param tier The compressed tier.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the image element.
+/// @param raw_size On return, stores the size of the element data when decompressed.
+/// @return true if the element can be restored from the tier.
+public_function bool image_tier_contains(image_tier_t *tier, uintptr_t image_id, size_t element, size_t &raw_size)
+{
+    size_t index;
+    if (image_tier_find(tier, image_id, element, index))
+    {
+        raw_size = tier->EntryList[index].RawSize;
+        return true;
+    }
+    raw_size = 0;
+    return false;
+}
+
+/// @summary Decompress an image element retained by the tier. On success, the entry is removed from the tier.
+/// @param tier The compressed tier.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the image element.
+/// @param dst The destination buffer, which must be committed memory.
+/// @param dst_size The maximum number of bytes that can be written to the destination buffer.
+/// @return true if the element data was restored.
+public_function bool image_tier_restore(image_tier_t *tier, uintptr_t image_id, size_t element, void *dst, size_t dst_size)
+{
+    size_t index;
+    if (image_tier_find(tier, image_id, element, index))
+    {
+        image_tier_entry_t &e = tier->EntryList[index];
+        bool   valid  =(e.RawSize <= dst_size);
+        if    (valid)  valid = (lz_decompress(dst, dst_size, e.Data, e.StoredSize) == e.RawSize);
+        // either the element is resident again, or the entry is unusable.
+        // it will be re-admitted when the element is next evicted.
+        image_tier_remove(tier, index);
+        if (valid) tier->HitCount++;
+        else tier->MissCount++;
+        return valid;
+    }
+    // the element was never demoted; this is its first commit, not a miss.
+    return false;
+}
+
+/// @summary Discard the copy of an image element retained by the tier, if any.
+/// @param tier The compressed tier.
+/// @param image_id The application-defined image identifier.
+/// @param element The zero-based index of the image element.
+public_function void image_tier_discard_element(image_tier_t *tier, uintptr_t image_id, size_t element)
+{
+    size_t index;
+    if (image_tier_find(tier, image_id, element, index))
+    {
+        image_tier_remove(tier, index);
+    }
+}
+
+/// @summary Discard all elements of an image retained by the tier.
+/// @param tier The compressed tier.
+/// @param image_id The application-defined image identifier.
+public_function void image_tier_discard_image(image_tier_t *tier, uintptr_t image_id)
+{
+    for (size_t i = 0; i < tier->EntryCount; /* empty */)
+    {
+        if (tier->EntryList[i].ImageId == image_id)
+            image_tier_remove(tier, i);
+        else i++;
+    }
+}
+
+/// @summary Retrieve compression and hit-rate statistics for a compressed tier.
+/// @param tier The compressed tier.
+/// @param stats On return, stores the current tier statistics.
+public_function void image_tier_stats(image_tier_t const *tier, image_tier_stats_t &stats)
+{
+    uint64_t requests      = tier->HitCount + tier->MissCount;
+    stats.BytesLimit       = tier->BytesLimit;
+    stats.BytesUsed        = tier->BytesUsed;
+    stats.BytesRaw         = tier->BytesRaw;
+    stats.EntryCount       = tier->EntryCount;
+    stats.AdmitCount       = tier->AdmitCount;
+    stats.RejectCount      = tier->RejectCount;
+    stats.DropCount        = tier->DropCount;
+    stats.HitCount         = tier->HitCount;
+    stats.MissCount        = tier->MissCount;
+    stats.CompressionRatio =(tier->BytesUsed > 0) ? float(double(tier->BytesRaw) / double(tier->BytesUsed)) : 0.0f;
+    stats.HitRate          =(requests > 0) ? float(double(tier->HitCount) / double(requests)) : 0.0f;
+}
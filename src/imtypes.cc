@@ -289,6 +289,7 @@ enum d3d11_resource_misc_flag_e
 enum image_encoding_e : int
 {
     IMAGE_ENCODING_RAW             = 0,  /// The image is encoded in a DXGI format.
+    IMAGE_ENCODING_LZ              = 1,  /// The image is encoded in a DXGI format, and each level is stored as LZ-compressed chunks.
 };
 
 /// @summary Define the recognized image compression types. Image compression 
@@ -299,6 +300,34 @@ enum image_compression_e : int
     IMAGE_COMPRESSION_NONE         = 0,  /// The image has no additional compression applied.
 };
 
+/// @summary Define the quality settings recognized by encoders that trade
+/// output quality for encoding speed, such as the block-compression encoders.
+enum image_encoder_quality_e : int
+{
+    IMAGE_ENCODER_QUALITY_FAST     = 0,  /// Favor speed. Endpoints are taken from the inset bounding box of each block.
+    IMAGE_ENCODER_QUALITY_NORMAL   = 1,  /// Endpoints are taken along the principal axis of each block.
+    IMAGE_ENCODER_QUALITY_HIGH     = 2,  /// Principal-axis endpoints are refined with a least-squares fit.
+};
+
+/// @summary Define flags enabling optional encoder stages. Mipmap generation 
+/// runs on the source pixel data, before any format conversion is applied. The 
+/// color stages are applied as part of the format conversion, and require RGBA8, 
+/// BGRA8, BGRX8, RGBA16F or RGBA32F source data.
+enum image_encoder_flags_e : uint32_t
+{
+    IMAGE_ENCODER_FLAGS_NONE              = (0 << 0), /// No optional stages are enabled.
+    IMAGE_ENCODER_FLAGS_GENERATE_MIPMAPS  = (1 << 0), /// Generate a complete mipmap chain for images that supply only level 0.
+    IMAGE_ENCODER_FLAGS_PREMULTIPLY_ALPHA = (1 << 1), /// Convert straight alpha to premultiplied alpha. Color channels are multiplied in linear space.
+    IMAGE_ENCODER_FLAGS_SRGB_TO_LINEAR    = (1 << 2), /// Decode 8-bit data to linear RGBA16F, or RGBA32F if requested.
+    IMAGE_ENCODER_FLAGS_LINEAR_TO_SRGB    = (1 << 3), /// Encode linear floating-point data to 8-bit sRGB.
+    IMAGE_ENCODER_FLAGS_COLOR_STAGES      = (7 << 1), /// The mask of the color stage flags.
+    IMAGE_ENCODER_FLAGS_YUV_BT709         = (1 << 4), /// Convert YUV data using the BT.709 matrix. BT.601 is used if no matrix is specified.
+    IMAGE_ENCODER_FLAGS_YUV_BT2020        = (1 << 5), /// Convert YUV data using the BT.2020 non-constant luminance matrix.
+    IMAGE_ENCODER_FLAGS_YUV_FULL_RANGE    = (1 << 6), /// YUV data uses the full code range instead of the studio (limited) range.
+    IMAGE_ENCODER_FLAGS_CHROMA_LINEAR     = (1 << 7), /// Upsample subsampled chroma with a linear filter instead of replicating samples.
+    IMAGE_ENCODER_FLAGS_YUV_STAGES        = (15<< 4), /// The mask of the YUV conversion flags.
+};
+
 /// @summary Define the recognized image access and storage types.
 enum image_access_type_e : int
 {
@@ -447,6 +476,68 @@ public_function inline uint32_t image_fourcc_be(char a, char b, char c, char d)
     return ((A << 24) | (B << 16) | (C << 8) | (D << 0));
 }
 
+/// @summary Converts a single-precision floating-point value to half-precision, rounding to nearest even.
+/// Values too large to represent become infinity; NaN is preserved as a quiet NaN.
+/// @param value The single-precision value.
+/// @return The bit pattern of the half-precision value.
+public_function inline uint16_t image_float_to_half(float value)
+{
+    uint32_t const f32_infinity = 255U << 23;
+    uint32_t const f16_limit    =(127U + 16U) << 23;
+    uint32_t const denorm_magic =((127U - 15U) + (23U - 10U) + 1U) << 23;
+    uint32_t       bits; memcpy(&bits, &value, sizeof(uint32_t));
+    uint32_t       sign = bits & 0x80000000U;
+    uint32_t       half;
+    bits ^= sign;
+    if (bits >= f16_limit)
+    {   // the value is too large to represent, infinity or NaN.
+        half = (bits > f32_infinity) ? 0x7E00U : 0x7C00U;
+    }
+    else if (bits < (113U << 23))
+    {   // the result is a half-precision denormal; let the FPU do the rounding.
+        float magic, f;
+        memcpy(&magic, &denorm_magic, sizeof(float));
+        memcpy(&f    , &bits        , sizeof(float));
+        f += magic;
+        memcpy(&bits , &f           , sizeof(float));
+        half = bits - denorm_magic;
+    }
+    else
+    {   // rebias the exponent and round the mantissa to nearest even.
+        uint32_t odd = (bits >> 13) & 1U;
+        bits += ((15U - 127U) << 23) + 0xFFFU + odd;
+        half  = bits >> 13;
+    }
+    return uint16_t(half | (sign >> 16));
+}
+
+/// @summary Converts a half-precision floating-point value to single-precision. The conversion is exact.
+/// @param half The bit pattern of the half-precision value.
+/// @return The single-precision value.
+public_function inline float image_half_to_float(uint16_t half)
+{
+    uint32_t sign = uint32_t(half & 0x8000U) << 16;
+    uint32_t expo =(half >> 10) & 0x1FU;
+    uint32_t mant = half & 0x03FFU;
+    uint32_t bits;
+    float    value;
+    if (expo == 0)
+    {   // zero or denormal; the value is mant * 2^-24.
+        value = float(mant) * (1.0f / 16777216.0f);
+        return sign ? -value : value;
+    }
+    if (expo == 31)
+    {   // infinity or NaN.
+        bits = sign | 0x7F800000U | (mant << 13);
+    }
+    else
+    {   // normal; rebias the exponent.
+        bits = sign | ((expo + 112U) << 23) | (mant << 13);
+    }
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
 /// @summary Determines the dxgi_format value based on data in dds headers.
 /// @param header the base surface header of the dds.
 /// @param header_ex the extended surface header of the dds, or NULL.
@@ -685,11 +776,57 @@ public_function bool dxgi_block_compressed(uint32_t format)
 
 /// @summary Determines if a DXGI fomrat value specifies a packed format.
 /// @param format One of dxgi_format_e.
-/// @return true if format is one of DXGI_FORMAT_R8G8_B8G8_UNORM or DXGI_FORMAT_G8R8_G8B8_UNORM.
+/// @return true if format is one of DXGI_FORMAT_R8G8_B8G8_UNORM, DXGI_FORMAT_G8R8_G8B8_UNORM or DXGI_FORMAT_YUY2.
 public_function bool dxgi_packed(uint32_t format)
 {
     if (format == DXGI_FORMAT_R8G8_B8G8_UNORM ||
-        format == DXGI_FORMAT_G8R8_G8B8_UNORM)
+        format == DXGI_FORMAT_G8R8_G8B8_UNORM ||
+        format == DXGI_FORMAT_YUY2)
+    {
+        return true;
+    }
+    else return false;
+}
+
+/// @summary Determines if a DXGI format value specifies a planar 4:2:0 format.
+/// Planar levels store a full-resolution luma plane followed by an interleaved
+/// chroma plane with half as many rows, both using the same row pitch.
+/// @param format One of dxgi_format_e.
+/// @return true if format is one of DXGI_FORMAT_NV12 or DXGI_FORMAT_P010.
+public_function bool dxgi_planar(uint32_t format)
+{
+    if (format == DXGI_FORMAT_NV12 ||
+        format == DXGI_FORMAT_P010)
+    {
+        return true;
+    }
+    else return false;
+}
+
+/// @summary Calculates the number of rows of data in a level, including the
+/// chroma plane of planar formats. Block-compressed formats are not supported.
+/// @param format One of dxgi_format_e.
+/// @param height The height of the level, in pixels.
+/// @return The number of rows of row pitch bytes in the level.
+public_function size_t dxgi_plane_rows(uint32_t format, size_t height)
+{
+    if (dxgi_planar(format))
+    {
+        return height + ((height + 1) >> 1);
+    }
+    else return height;
+}
+
+/// @summary Determines if a DXGI format value specifies a YUV format that can
+/// be converted to RGB by the image encoders.
+/// @param format One of dxgi_format_e.
+/// @return true if format is one of DXGI_FORMAT_AYUV, DXGI_FORMAT_NV12, DXGI_FORMAT_P010 or DXGI_FORMAT_YUY2.
+public_function bool dxgi_yuv(uint32_t format)
+{
+    if (format == DXGI_FORMAT_AYUV ||
+        format == DXGI_FORMAT_NV12 ||
+        format == DXGI_FORMAT_P010 ||
+        format == DXGI_FORMAT_YUY2)
     {
         return true;
     }
@@ -864,8 +1001,12 @@ public_function size_t dxgi_bits_per_pixel(uint32_t format)
         case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
         case DXGI_FORMAT_B8G8R8X8_TYPELESS:
         case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        case DXGI_FORMAT_AYUV:
             return 32;
 
+        case DXGI_FORMAT_P010:
+            return 24;
+
         case DXGI_FORMAT_R8G8_TYPELESS:
         case DXGI_FORMAT_R8G8_UNORM:
         case DXGI_FORMAT_R8G8_UINT:
@@ -881,8 +1022,12 @@ public_function size_t dxgi_bits_per_pixel(uint32_t format)
         case DXGI_FORMAT_B5G6R5_UNORM:
         case DXGI_FORMAT_B5G5R5A1_UNORM:
         case DXGI_FORMAT_B4G4R4A4_UNORM:
+        case DXGI_FORMAT_YUY2:
             return 16;
 
+        case DXGI_FORMAT_NV12:
+            return 12;
+
         case DXGI_FORMAT_R8_TYPELESS:
         case DXGI_FORMAT_R8_UNORM:
         case DXGI_FORMAT_R8_UINT:
@@ -1053,6 +1198,11 @@ public_function size_t dxgi_pitch(uint32_t format, size_t width)
     {
         return ((width + 1) >> 1) * 4;
     }
+    if (dxgi_planar(format))
+    {   // the pitch of the luma plane; chroma rows use the same pitch.
+        size_t bpc = format == DXGI_FORMAT_P010 ? 2 : 1;
+        return ((width + 1) >> 1) * 2 * bpc;
+    }
     return (width * dxgi_bits_per_pixel(format) + 7) / 8;
 }
 
@@ -1069,3 +1219,65 @@ public_function inline size_t dxgi_image_dimension(uint32_t format, size_t dimen
     }
     else return image_max2<size_t>(1, dimension);
 }
+
+/// @summary Generates the DDS headers describing a texture decoded from a container format other than DDS.
+/// @param dds The base DDS header to populate.
+/// @param dx10 The DX10 extended DDS header to populate.
+/// @param format One of dxgi_format_e specifying the format of the pixel data.
+/// @param width The width of the first level, in pixels.
+/// @param height The height of the first level, in pixels.
+/// @param depth The number of slices in the first level. Volumes cannot also be arrays or cubemaps.
+/// @param levels The number of levels in the mipmap chain, at least 1.
+/// @param layers The number of array elements. For a cubemap, the number of cubes.
+/// @param cubemap Specify true if each array element is a cubemap with six faces.
+/// @param alpha_mode One of dds_alpha_mode_e describing the contents of the alpha channel.
+public_function void dds_headers_for_texture(dds_header_t *dds, dds_header_dxt10_t *dx10, uint32_t format, size_t width, size_t height, size_t depth, size_t levels, size_t layers, bool cubemap, uint32_t alpha_mode)
+{
+    memset(dds , 0, sizeof(dds_header_t));
+    memset(dx10, 0, sizeof(dds_header_dxt10_t));
+    dds->Size           = sizeof(dds_header_t);
+    dds->Flags          = DDS_HEADER_FLAGS_TEXTURE | DDSD_PITCH;
+    dds->Height         = uint32_t(height);
+    dds->Width          = uint32_t(width);
+    dds->Pitch          = uint32_t(dxgi_pitch(format, width));
+    dds->Levels         = uint32_t(levels);
+    dds->Format.Size    = sizeof(dds_pixelformat_t);
+    dds->Format.Flags   = DDPF_FOURCC;
+    dds->Format.FourCC  = image_fourcc_le('D','X','1','0');
+    dds->Caps           = DDSCAPS_TEXTURE;
+    dx10->Format        = format;
+    dx10->Dimension     = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+    dx10->ArraySize     = uint32_t(layers);
+    dx10->Flags2        = alpha_mode;
+    if (levels > 1)
+    {
+        dds->Flags     |= DDS_HEADER_FLAGS_MIPMAP;
+        dds->Caps      |= DDS_SURFACE_FLAGS_MIPMAP;
+    }
+    if (cubemap)
+    {
+        dds->Caps      |= DDS_SURFACE_FLAGS_CUBEMAP;
+        dds->Caps2     |= DDS_CUBEMAP_ALLFACES;
+        dx10->Flags     = D3D11_RESOURCE_MISC_TEXTURECUBE;
+    }
+    if (depth > 1)
+    {
+        dds->Flags     |= DDS_HEADER_FLAGS_VOLUME;
+        dds->Depth      = uint32_t(depth);
+        dds->Caps      |= DDSCAPS_COMPLEX;
+        dds->Caps2     |= DDS_FLAG_VOLUME;
+        dx10->Dimension = D3D11_RESOURCE_DIMENSION_TEXTURE3D;
+    }
+}
+
+/// @summary Generates the DDS headers describing a single 2D image with one mip-level, as decoded from a container format other than DDS.
+/// @param dds The base DDS header to populate.
+/// @param dx10 The DX10 extended DDS header to populate.
+/// @param format One of dxgi_format_e specifying the format of the pixel data.
+/// @param width The image width, in pixels.
+/// @param height The image height, in pixels.
+/// @param alpha_mode One of dds_alpha_mode_e describing the contents of the alpha channel.
+public_function void dds_headers_for_image(dds_header_t *dds, dds_header_dxt10_t *dx10, uint32_t format, size_t width, size_t height, uint32_t alpha_mode)
+{
+    dds_headers_for_texture(dds, dx10, format, width, height, 1, 1, 1, false, alpha_mode);
+}
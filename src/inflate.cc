@@ -0,0 +1,617 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a resumable decoder for DEFLATE (RFC 1951) streams,
+/// optionally wrapped in a zlib (RFC 1950) header. Compressed data is fed in
+/// pieces of any size and staged in a bounded input buffer; the decoder only
+/// starts a symbol or block header when enough input is staged to finish it,
+/// so it always stops at a symbol boundary and no per-symbol state has to be
+/// saved. Output is written to a buffer that retains the 32KB match window;
+/// the caller consumes the output after every call to inflate_run(), and the
+/// buffer slides down when it fills. Symbols are decoded with a 64-bit bit
+/// buffer and a 10-bit lookup table, and long match copies use 16-byte SSE2
+/// loads and stores. The zlib Adler-32 checksum is not verified.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <emmintrin.h>
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The size of the DEFLATE match window, in bytes.
+#define INFLATE_WINDOW_SIZE       32768
+
+/// @summary The number of bytes of new output that fit in the output buffer after the window.
+#define INFLATE_OUTPUT_SIZE       65536
+
+/// @summary The capacity of the staged compressed input, in bytes.
+#define INFLATE_INPUT_SIZE        65536
+
+/// @summary The number of input bytes that must be staged before a symbol is decoded, so that the two bit buffer refills it may need read only real input.
+#define INFLATE_SYMBOL_MARGIN     16
+
+/// @summary The number of input bytes guaranteed to hold any block header, including the dynamic Huffman code lengths.
+#define INFLATE_HEADER_MARGIN     320
+
+/// @summary The number of bytes of output space reserved for one symbol: the longest match, plus the overrun of a 16-byte copy.
+#define INFLATE_MATCH_SLACK       (258 + 16)
+
+/// @summary The number of code bits resolved by a single table lookup.
+#define INFLATE_FAST_BITS         10
+
+/// @summary The maximum length of a Huffman code, in bits.
+#define INFLATE_MAX_BITS          15
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define the states of the decoder.
+enum inflate_state_e : int
+{
+    INFLATE_STATE_ZLIB_HEADER   = 0,   /// The decoder is waiting for the two-byte zlib header.
+    INFLATE_STATE_BLOCK_HEADER  = 1,   /// The decoder is waiting for the header of the next block.
+    INFLATE_STATE_STORED        = 2,   /// The decoder is copying the data of a stored block.
+    INFLATE_STATE_HUFFMAN       = 3,   /// The decoder is decoding the symbols of a compressed block.
+    INFLATE_STATE_DONE          = 4,   /// The final block has been decoded.
+    INFLATE_STATE_ERROR         = 5,   /// The stream is invalid or truncated.
+};
+
+/// @summary Define the results returned by inflate_run().
+enum inflate_result_e : int
+{
+    INFLATE_RESULT_NEED_INPUT   = 0,   /// The decoder needs more input before it can continue.
+    INFLATE_RESULT_NEED_OUTPUT  = 1,   /// The output buffer is full; consume the output and call inflate_run() again.
+    INFLATE_RESULT_DONE         = 2,   /// The end of the stream was reached.
+    INFLATE_RESULT_ERROR        = 3,   /// The stream is invalid or truncated.
+};
+
+/// @summary Describes a canonical Huffman code, as built by inflate_build().
+struct inflate_huffman_t
+{
+    uint16_t                  Fast[1 << INFLATE_FAST_BITS]; /// Maps the next INFLATE_FAST_BITS input bits to (length << 9) | symbol, or 0 for longer codes.
+    uint16_t                  Count [INFLATE_MAX_BITS + 1]; /// The number of codes of each length.
+    uint16_t                  Symbol[320];                  /// The symbols, ordered by code.
+};
+
+/// @summary Defines the state of a resumable DEFLATE decoder.
+struct inflate_t
+{
+    int                       State;             /// One of inflate_state_e.
+    bool                      Final;             /// true if the current block is the final block.
+    bool                      InputFinal;        /// true if all of the compressed data has been fed.
+    uint64_t                  BitBuffer;         /// Input bits not yet consumed, least-significant bit first.
+    size_t                    BitCount;          /// The number of valid bits in BitBuffer.
+    size_t                    StoredSize;        /// The number of bytes remaining in the current stored block.
+    size_t                    InputRead;         /// The offset of the next unread byte of staged input.
+    size_t                    InputSize;         /// The number of bytes of staged input.
+    size_t                    OutputRead;        /// The offset of the first output byte not yet consumed by the caller.
+    size_t                    OutputSize;        /// The number of bytes in the output buffer, including the window.
+    uint8_t                  *Input;             /// Staged input, with INFLATE_SYMBOL_MARGIN zero bytes of padding.
+    uint8_t                  *Output;            /// The output buffer, including the match window.
+    inflate_huffman_t         LitLen;            /// The literal/length code of the current block.
+    inflate_huffman_t         Distance;          /// The distance code of the current block.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The base match length for each length symbol, starting at symbol 257.
+global_variable uint16_t const INFLATE_LENGTH_BASE [29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+
+/// @summary The number of extra bits for each length symbol, starting at symbol 257.
+global_variable uint8_t  const INFLATE_LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+/// @summary The base match distance for each distance symbol.
+global_variable uint16_t const INFLATE_DIST_BASE   [30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+
+/// @summary The number of extra bits for each distance symbol.
+global_variable uint8_t  const INFLATE_DIST_EXTRA  [30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+/// @summary The order in which the code length code lengths are stored.
+global_variable uint8_t  const INFLATE_CLEN_ORDER  [19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Fill the bit buffer with at least 56 bits, or with all of the remaining staged input.
+/// Once the staged input is exhausted, the zero padding is read; inflate_overrun() detects this.
+/// @param inf The decoder state.
+internal_function inline void inflate_refill(inflate_t *inf)
+{
+    if (inf->InputRead + 8 <= inf->InputSize + INFLATE_SYMBOL_MARGIN)
+    {   // load eight bytes, and advance past the whole bytes that fit.
+        uint64_t v; memcpy(&v, inf->Input + inf->InputRead, sizeof(uint64_t));
+        inf->BitBuffer |= v << inf->BitCount;
+        inf->InputRead += (63 - inf->BitCount) >> 3;
+        inf->BitCount  |=  56;
+    }
+    else
+    {   // past the end of the padding; the bits shifted in are already zero.
+        inf->InputRead += (63 - inf->BitCount) >> 3;
+        inf->BitCount  |=  56;
+    }
+}
+
+/// @summary Determine whether the decoder has consumed bits past the end of the staged input.
+/// @param inf The decoder state.
+/// @return true if the decoder read into the zero padding.
+internal_function inline bool inflate_overrun(inflate_t const *inf)
+{
+    return (inf->InputRead * 8) > (inf->InputSize * 8 + inf->BitCount);
+}
+
+/// @summary Determine the number of staged input bytes that have not been consumed, including the whole bytes in the bit buffer.
+/// @param inf The decoder state.
+/// @return The number of bytes available.
+internal_function inline size_t inflate_available(inflate_t const *inf)
+{
+    size_t bits = inf->InputSize * 8 + inf->BitCount;
+    size_t read = inf->InputRead * 8;
+    return (bits > read) ? (bits - read) / 8 : 0;
+}
+
+/// @summary Read bits from the input. The caller must have ensured that enough input is staged.
+/// @param inf The decoder state.
+/// @param n The number of bits to read, at most 32.
+/// @return The bits, least-significant bit first.
+internal_function inline uint32_t inflate_bits(inflate_t *inf, size_t n)
+{
+    if (inf->BitCount < n) inflate_refill(inf);
+    uint32_t v = uint32_t(inf->BitBuffer & ((uint64_t(1) << n) - 1));
+    inf->BitBuffer >>= n;
+    inf->BitCount   -= n;
+    return v;
+}
+
+/// @summary Build the decoding tables for a canonical Huffman code.
+/// @param h The code to build.
+/// @param lengths The code length of each symbol, or zero for unused symbols.
+/// @param count The number of symbols.
+/// @return true if the code is valid. Incomplete codes are accepted, as required for single-symbol distance codes.
+internal_function bool inflate_build(inflate_huffman_t *h, uint8_t const *lengths, size_t count)
+{
+    uint16_t offset[INFLATE_MAX_BITS + 2];
+    uint32_t next  [INFLATE_MAX_BITS + 1];
+    memset(h->Count, 0, sizeof(h->Count));
+    memset(h->Fast , 0, sizeof(h->Fast));
+    for (size_t i = 0; i < count; ++i)
+        h->Count[lengths[i]]++;
+    h->Count[0] = 0;
+
+    int left = 1;
+    for (size_t len = 1; len <= INFLATE_MAX_BITS; ++len)
+    {   // check for an over-subscribed code.
+        left <<= 1;
+        left  -= h->Count[len];
+        if (left < 0) return false;
+    }
+    offset[1] = 0;
+    next  [0] = 0;
+    uint32_t code = 0;
+    for (size_t len = 1; len <= INFLATE_MAX_BITS; ++len)
+    {
+        offset[len + 1] = uint16_t(offset[len] + h->Count[len]);
+        code = (code + h->Count[len - 1]) << 1;
+        next[len] = code;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t len = lengths[i];
+        if (len == 0) continue;
+        h->Symbol[offset[len]++] = uint16_t(i);
+        uint32_t c = next[len]++;
+        if (len <= INFLATE_FAST_BITS)
+        {   // codes are stored most-significant bit first, but read least-significant bit first.
+            uint32_t r = 0;
+            for (size_t b = 0; b < len; ++b)
+                r |= ((c >> b) & 1) << (len - 1 - b);
+            for (uint32_t j = r; j < (1U << INFLATE_FAST_BITS); j += (1U << len))
+                h->Fast[j] = uint16_t((len << 9) | i);
+        }
+    }
+    return true;
+}
+
+/// @summary Decode one symbol. The bit buffer must hold at least INFLATE_MAX_BITS bits.
+/// @param inf The decoder state.
+/// @param h The code to decode.
+/// @return The symbol, or -1 if the bits don't form a code.
+internal_function inline int inflate_decode(inflate_t *inf, inflate_huffman_t const *h)
+{
+    uint32_t e = h->Fast[inf->BitBuffer & ((1U << INFLATE_FAST_BITS) - 1)];
+    if (e != 0)
+    {   // the common case - the code is at most INFLATE_FAST_BITS long.
+        size_t len = e >> 9;
+        inf->BitBuffer >>= len;
+        inf->BitCount   -= len;
+        return int(e & 0x1FF);
+    }
+    // decode the long code one bit at a time.
+    int code = 0, first = 0, index = 0;
+    for (size_t len = 1; len <= INFLATE_MAX_BITS; ++len)
+    {
+        code |= int(inf->BitBuffer & 1);
+        inf->BitBuffer >>= 1;
+        inf->BitCount   -= 1;
+        int count = h->Count[len];
+        if (code - first < count)
+            return h->Symbol[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code  <<= 1;
+    }
+    return -1;
+}
+
+/// @summary Copy a match within the output buffer. Up to 15 bytes past the end of the match may be overwritten.
+/// @param dst The first byte to write.
+/// @param distance The distance back to the source of the match, in [1, INFLATE_WINDOW_SIZE].
+/// @param length The length of the match, in bytes.
+internal_function inline void inflate_copy(uint8_t *dst, size_t distance, size_t length)
+{
+    uint8_t const *src = dst - distance;
+    if (distance >= 16)
+    {   // the source and destination of each 16-byte copy don't overlap.
+        for (size_t i = 0; i < length; i += 16)
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_loadu_si128((__m128i const*)(src + i)));
+    }
+    else if (distance == 1)
+    {   // a run of a single byte.
+        memset(dst, src[0], length);
+    }
+    else
+    {   // short distances repeat a pattern, which must be copied forward.
+        for (size_t i = 0; i < length; ++i)
+            dst[i] = src[i];
+    }
+}
+
+/// @summary Read a block header, and the code lengths of a dynamic block. INFLATE_HEADER_MARGIN bytes must be available, unless all input has been fed.
+/// @param inf The decoder state.
+/// @return The next state.
+internal_function int inflate_block_header(inflate_t *inf)
+{
+    inf->Final    = inflate_bits(inf, 1) != 0;
+    uint32_t type = inflate_bits(inf, 2);
+    if (type == 0)
+    {   // stored block - discard the remaining bits of the current byte.
+        inflate_bits(inf, inf->BitCount & 7);
+        uint32_t len  = inflate_bits(inf, 16);
+        uint32_t nlen = inflate_bits(inf, 16);
+        if ((len ^ 0xFFFF) != nlen || inflate_overrun(inf))
+            return INFLATE_STATE_ERROR;
+        inf->StoredSize = len;
+        return INFLATE_STATE_STORED;
+    }
+    if (type == 1)
+    {   // fixed Huffman codes.
+        uint8_t lengths[288 + 30];
+        memset(lengths +   0, 8, 144);
+        memset(lengths + 144, 9, 112);
+        memset(lengths + 256, 7,  24);
+        memset(lengths + 280, 8,   8);
+        memset(lengths + 288, 5,  30);
+        inflate_build(&inf->LitLen  , lengths      , 288);
+        inflate_build(&inf->Distance, lengths + 288,  30);
+        return INFLATE_STATE_HUFFMAN;
+    }
+    if (type == 2)
+    {   // dynamic Huffman codes.
+        uint8_t lengths[288 + 30];
+        uint8_t clen[19] = {0};
+        size_t  nlit  = inflate_bits(inf, 5) + 257;
+        size_t  ndist = inflate_bits(inf, 5) + 1;
+        size_t  nclen = inflate_bits(inf, 4) + 4;
+        if (nlit > 286 || ndist > 30)
+            return INFLATE_STATE_ERROR;
+        for (size_t i = 0; i < nclen; ++i)
+            clen[INFLATE_CLEN_ORDER[i]] = uint8_t(inflate_bits(inf, 3));
+        if (!inflate_build(&inf->LitLen, clen, 19))
+            return INFLATE_STATE_ERROR;
+        size_t  n = 0;
+        while  (n < nlit + ndist)
+        {
+            if (inf->BitCount < INFLATE_MAX_BITS) inflate_refill(inf);
+            int sym = inflate_decode(inf, &inf->LitLen);
+            if (sym < 0)
+                return INFLATE_STATE_ERROR;
+            if (sym < 16)
+            {   // a literal code length.
+                lengths[n++] = uint8_t(sym);
+                continue;
+            }
+            uint8_t value  = 0;
+            size_t  repeat = 0;
+            if (sym == 16)
+            {   // repeat the previous length 3-6 times.
+                if (n == 0) return INFLATE_STATE_ERROR;
+                value  = lengths[n - 1];
+                repeat = 3 + inflate_bits(inf, 2);
+            }
+            else if (sym == 17) repeat = 3  + inflate_bits(inf, 3);
+            else                repeat = 11 + inflate_bits(inf, 7);
+            if (n + repeat > nlit + ndist)
+                return INFLATE_STATE_ERROR;
+            memset(lengths + n, value, repeat);
+            n += repeat;
+        }
+        if (lengths[256] == 0 || inflate_overrun(inf))
+        {   // the end-of-block code is required.
+            return INFLATE_STATE_ERROR;
+        }
+        if (!inflate_build(&inf->LitLen, lengths, nlit) || !inflate_build(&inf->Distance, lengths + nlit, ndist))
+            return INFLATE_STATE_ERROR;
+        return INFLATE_STATE_HUFFMAN;
+    }
+    return INFLATE_STATE_ERROR;
+}
+
+/// @summary Decode the symbols of a compressed block until the block ends, the staged input runs low, or the output buffer fills.
+/// @param inf The decoder state.
+/// @return The next state, or INFLATE_STATE_HUFFMAN if the decoder must stop within the block.
+internal_function int inflate_huffman(inflate_t *inf)
+{
+    uint8_t *out   = inf->Output + inf->OutputSize;
+    uint8_t *limit = inf->Output + INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE - INFLATE_MATCH_SLACK;
+    int      state = INFLATE_STATE_HUFFMAN;
+    for ( ; ; )
+    {
+        if (out > limit)
+        {   // there may not be room for the next match.
+            break;
+        }
+        if (inf->InputRead + INFLATE_SYMBOL_MARGIN > inf->InputSize)
+        {   // the next symbol might not be complete; wait for more input.
+            if (!inf->InputFinal || inflate_overrun(inf))
+                break;
+        }
+        inflate_refill(inf);
+        int sym = inflate_decode(inf, &inf->LitLen);
+        while (uint32_t(sym) < 256 && inf->BitCount >= INFLATE_MAX_BITS && out < limit)
+        {   // decode runs of literals without refilling while a whole code remains in the bit buffer.
+            *out++ = uint8_t(sym);
+            sym = inflate_decode(inf, &inf->LitLen);
+        }
+        if (uint32_t(sym) < 256)
+        {
+            *out++ = uint8_t(sym);
+            continue;
+        }
+        if (sym < 0)
+        {
+            state = INFLATE_STATE_ERROR;
+            break;
+        }
+        if (sym == 256)
+        {   // end of block.
+            state = inf->Final ? INFLATE_STATE_DONE : INFLATE_STATE_BLOCK_HEADER;
+            break;
+        }
+        if (sym > 285)
+        {
+            state = INFLATE_STATE_ERROR;
+            break;
+        }
+        if (inf->BitCount < 33)
+        {   // the length extra bits, distance code and distance extra bits need up to 33 bits.
+            inflate_refill(inf);
+        }
+        size_t length  = INFLATE_LENGTH_BASE [sym - 257] + inflate_bits(inf, INFLATE_LENGTH_EXTRA[sym - 257]);
+        int    dsym    = inflate_decode(inf, &inf->Distance);
+        if (dsym < 0 || dsym > 29)
+        {
+            state = INFLATE_STATE_ERROR;
+            break;
+        }
+        size_t distance= INFLATE_DIST_BASE[dsym] + inflate_bits(inf, INFLATE_DIST_EXTRA[dsym]);
+        if (distance > size_t(out - inf->Output))
+        {   // the match starts before the first byte of output.
+            state = INFLATE_STATE_ERROR;
+            break;
+        }
+        inflate_copy(out, distance, length);
+        out += length;
+    }
+    if (inflate_overrun(inf))
+    {   // the stream is truncated.
+        state = INFLATE_STATE_ERROR;
+    }
+    inf->OutputSize = size_t(out - inf->Output);
+    return state;
+}
+
+/// @summary Copy the data of a stored block until the block ends, the staged input is exhausted, or the output buffer fills.
+/// @param inf The decoder state.
+/// @return The next state.
+internal_function int inflate_stored(inflate_t *inf)
+{
+    size_t space = INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE - inf->OutputSize;
+    while (inf->StoredSize > 0 && space > 0 && inf->BitCount >= 8)
+    {   // drain the whole bytes already in the bit buffer.
+        inf->Output[inf->OutputSize++] = uint8_t(inf->BitBuffer);
+        inf->BitBuffer >>= 8;
+        inf->BitCount   -= 8;
+        inf->StoredSize--;
+        space--;
+    }
+    if (inf->BitCount == 0)
+    {   // the bit buffer may still hold bytes that are about to be copied directly.
+        inf->BitBuffer = 0;
+    }
+    size_t count = inf->InputSize - inf->InputRead;
+    if (count > space) count = space;
+    if (count > inf->StoredSize) count = inf->StoredSize;
+    memcpy(inf->Output + inf->OutputSize, inf->Input + inf->InputRead, count);
+    inf->OutputSize += count;
+    inf->InputRead  += count;
+    inf->StoredSize -= count;
+    if (inf->StoredSize > 0)
+    {   // wait for more input or output space.
+        if (inf->InputFinal && inf->InputRead == inf->InputSize)
+            return INFLATE_STATE_ERROR;
+        return INFLATE_STATE_STORED;
+    }
+    return inf->Final ? INFLATE_STATE_DONE : INFLATE_STATE_BLOCK_HEADER;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize a decoder and allocate its buffers.
+/// @param inf The decoder state to initialize.
+/// @param zlib Specify true if the stream starts with a zlib header, or false for a raw DEFLATE stream.
+/// @return true if the decoder was initialized, or false if memory allocation failed.
+public_function bool inflate_init(inflate_t *inf, bool zlib)
+{
+    inf->State      = zlib ? INFLATE_STATE_ZLIB_HEADER : INFLATE_STATE_BLOCK_HEADER;
+    inf->Final      = false;
+    inf->InputFinal = false;
+    inf->BitBuffer  = 0;
+    inf->BitCount   = 0;
+    inf->StoredSize = 0;
+    inf->InputRead  = 0;
+    inf->InputSize  = 0;
+    inf->OutputRead = 0;
+    inf->OutputSize = 0;
+    inf->Input      =(uint8_t*) malloc(INFLATE_INPUT_SIZE + INFLATE_SYMBOL_MARGIN);
+    inf->Output     =(uint8_t*) malloc(INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE);
+    if (inf->Input == NULL || inf->Output == NULL)
+    {
+        free(inf->Output); inf->Output = NULL;
+        free(inf->Input);  inf->Input  = NULL;
+        return false;
+    }
+    memset(inf->Input, 0, INFLATE_INPUT_SIZE + INFLATE_SYMBOL_MARGIN);
+    return true;
+}
+
+/// @summary Free the buffers owned by a decoder.
+/// @param inf The decoder state.
+public_function void inflate_delete(inflate_t *inf)
+{
+    free(inf->Output); inf->Output = NULL;
+    free(inf->Input);  inf->Input  = NULL;
+}
+
+/// @summary Stage compressed input. Consumed input is discarded first, so staging succeeds whenever the decoder has made progress.
+/// @param inf The decoder state.
+/// @param data The compressed data.
+/// @param size The number of bytes of compressed data.
+/// @return The number of bytes staged, which may be less than size.
+public_function size_t inflate_feed(inflate_t *inf, void const *data, size_t size)
+{
+    if (inf->BitCount >= 8)
+    {   // return whole bytes in the bit buffer to the input, since refills may have read into the padding.
+        size_t whole    = inf->BitCount >> 3;
+        inf->InputRead -= whole;
+        inf->BitCount  -= whole << 3;
+        inf->BitBuffer &=(uint64_t(1) << inf->BitCount) - 1;
+    }
+    if (inf->InputRead > 0)
+    {   // move the unread input to the front of the buffer.
+        memmove(inf->Input, inf->Input + inf->InputRead, inf->InputSize - inf->InputRead);
+        inf->InputSize -= inf->InputRead;
+        inf->InputRead  = 0;
+    }
+    size_t count = INFLATE_INPUT_SIZE - inf->InputSize;
+    if (count > size) count = size;
+    memcpy(inf->Input + inf->InputSize, data, count);
+    inf->InputSize += count;
+    memset(inf->Input + inf->InputSize, 0, INFLATE_SYMBOL_MARGIN);
+    return count;
+}
+
+/// @summary Indicate that all of the compressed data has been staged, so the decoder may read up to the end of the input.
+/// @param inf The decoder state.
+public_function void inflate_finish(inflate_t *inf)
+{
+    inf->InputFinal = true;
+}
+
+/// @summary Decode as much of the staged input as possible. All output returned by inflate_output() must have been consumed.
+/// @param inf The decoder state.
+/// @return One of inflate_result_e.
+public_function int inflate_run(inflate_t *inf)
+{
+    if (inf->OutputSize > INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE / 2)
+    {   // slide the output buffer, keeping the match window and any unconsumed output.
+        size_t keep = inf->OutputSize - inf->OutputRead;
+        if (keep < INFLATE_WINDOW_SIZE) keep = INFLATE_WINDOW_SIZE;
+        size_t drop = inf->OutputSize - keep;
+        memmove(inf->Output, inf->Output + drop, keep);
+        inf->OutputSize -= drop;
+        inf->OutputRead -= drop;
+    }
+    for ( ; ; )
+    {
+        switch (inf->State)
+        {
+            case INFLATE_STATE_ZLIB_HEADER:
+                {
+                    if (inflate_available(inf) < 2)
+                        return inf->InputFinal ? (inf->State = INFLATE_STATE_ERROR, INFLATE_RESULT_ERROR) : INFLATE_RESULT_NEED_INPUT;
+                    uint32_t cmf = inflate_bits(inf, 8);
+                    uint32_t flg = inflate_bits(inf, 8);
+                    if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20) != 0)
+                    {   // not DEFLATE, an invalid window size, a bad check value or a preset dictionary.
+                        inf->State = INFLATE_STATE_ERROR;
+                        return INFLATE_RESULT_ERROR;
+                    }
+                    inf->State = INFLATE_STATE_BLOCK_HEADER;
+                }
+                break;
+            case INFLATE_STATE_BLOCK_HEADER:
+                if (inflate_available(inf) < INFLATE_HEADER_MARGIN && !inf->InputFinal)
+                    return INFLATE_RESULT_NEED_INPUT;
+                if (inf->OutputSize + INFLATE_MATCH_SLACK > INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE)
+                    return INFLATE_RESULT_NEED_OUTPUT;
+                inf->State = inflate_block_header(inf);
+                break;
+            case INFLATE_STATE_STORED:
+                {
+                    size_t before = inf->OutputSize;
+                    inf->State = inflate_stored(inf);
+                    if (inf->State == INFLATE_STATE_STORED)
+                        return (inf->OutputSize == before && inf->OutputSize < INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE) ? INFLATE_RESULT_NEED_INPUT : INFLATE_RESULT_NEED_OUTPUT;
+                }
+                break;
+            case INFLATE_STATE_HUFFMAN:
+                inf->State = inflate_huffman(inf);
+                if (inf->State == INFLATE_STATE_HUFFMAN)
+                {   // stopped within the block.
+                    if (inf->OutputSize + INFLATE_MATCH_SLACK > INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE)
+                        return INFLATE_RESULT_NEED_OUTPUT;
+                    return INFLATE_RESULT_NEED_INPUT;
+                }
+                break;
+            case INFLATE_STATE_DONE:
+                return INFLATE_RESULT_DONE;
+            default:
+                return INFLATE_RESULT_ERROR;
+        }
+    }
+}
+
+/// @summary Retrieve the output that has not yet been consumed.
+/// @param inf The decoder state.
+/// @param size On return, the number of bytes of output available.
+/// @return A pointer to the first byte of output.
+public_function uint8_t const* inflate_output(inflate_t const *inf, size_t &size)
+{
+    size = inf->OutputSize - inf->OutputRead;
+    return inf->Output + inf->OutputRead;
+}
+
+/// @summary Mark output as consumed.
+/// @param inf The decoder state.
+/// @param size The number of bytes consumed.
+public_function void inflate_consume(inflate_t *inf, size_t size)
+{
+    inf->OutputRead += size;
+}
@@ -41,7 +41,7 @@ struct io_buffer_allocator_t final
     size_t  buffers_free(void) const;
     size_t  buffers_used(void) const;
 
-    bool    reserve(size_t total_size, size_t alloc_size);
+    bool    reserve(size_t total_size, size_t alloc_size, uint32_t numa_node=NUMA_NO_PREFERRED_NODE);
     void    release(void);
     void   *get_buffer(void);
     void    put_buffer(void *buffer);
@@ -141,9 +141,12 @@ inline size_t io_buffer_allocator_t::buffers_free(void) const
 /// @param alloc_size The sub-allocation size, in bytes. This is the size of a
 /// single buffer that can be returned to the application. This size is rounded
 /// up to the nearest even multiple of the largest disk sector size.
+/// @param numa_node The NUMA node from which physical memory should be taken, usually
+/// the node of the thread that consumes the buffers, or NUMA_NO_PREFERRED_NODE to take 
+/// pages from the node of the thread that first touches them, which may be an I/O thread.
 /// @return true if the memory pool was reserved. Check the TotalSize and
 /// AllocSize fields to determine the values selected by the system.
-bool io_buffer_allocator_t::reserve(size_t total_size, size_t alloc_size)
+bool io_buffer_allocator_t::reserve(size_t total_size, size_t alloc_size, uint32_t numa_node)
 {
     SYSTEM_INFO sysinfo = {0};
     GetNativeSystemInfo_Func(&sysinfo);
@@ -179,7 +182,7 @@ bool io_buffer_allocator_t::reserve(size_t total_size, size_t alloc_size)
     // if the address range cannot be pinned, it's not a fatal error.
     DWORD  protect  = PAGE_READWRITE;
     DWORD  flags    = MEM_COMMIT | MEM_RESERVE;
-    void  *baseaddr = VirtualAlloc(NULL, total_size, flags, protect);
+    void  *baseaddr = win32_numa_virtual_alloc(NULL, total_size, flags, protect, numa_node);
     if (baseaddr == NULL)
     {   // the requested amount of memory could not be allocated.
         return false;
@@ -99,6 +99,7 @@ struct stream_decoder_t
     aio_result_alloc_t     AIOResultAlloc;        /// The FIFO node allocator for the AIO driver queue.
     aio_result_queue_t     AIOResultQueue;        /// The SPSC FIFO to which the AIO driver posts read results.
     io_buffer_allocator_t *BufferAllocator;       /// The active I/O buffer allocator; may not be &InternalAllocator.
+    SRWLOCK               *BufferLock;            /// The lock protecting a BufferAllocator shared with other decoders, or NULL.
     io_buffer_allocator_t  InternalAllocator;     /// The (possibly unused) internal I/O buffer allocator.
     std::atomic<intptr_t>  ReferenceCount;        /// The reference count used for lifetime management.
 };
@@ -214,6 +215,7 @@ stream_decoder_t::stream_decoder_t(void)
     EncodedDataOffset(0), 
     EncodedDataSize(0), 
     BufferAllocator(NULL), 
+    BufferLock(NULL), 
     ReferenceCount(0)
 {
     aio_create_result_queue(&AIOResultQueue, &AIOResultAlloc);
@@ -290,7 +292,10 @@ void* stream_decoder_t::nextbuf(void)
     if (EncodedData != NULL)
     {   // the buffer is returned to the active allocator, which may or may 
         // not be the internal I/O buffer allocator managed by the decoder.
+        // a shared allocator may be accessed by parsers on several threads.
+        if (BufferLock != NULL) AcquireSRWLockExclusive(BufferLock);
         BufferAllocator->put_buffer(EncodedData);
+        if (BufferLock != NULL) ReleaseSRWLockExclusive(BufferLock);
         EncodedData       = NULL;
         EncodedDataOffset = 0;
         EncodedDataSize   = 0;
@@ -0,0 +1,312 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a fast, byte-oriented LZ77 block codec in the style of
+/// LZ4. The codec trades compression ratio for speed; compression runs at a
+/// few hundred MB/s per core and decompression is bounded by memory bandwidth.
+/// The block format is a sequence of (token, literals, offset, match) records:
+/// the high nibble of the token is the literal length and the low nibble is
+/// the match length minus LZ_MIN_MATCH, each extended with 255-valued bytes.
+/// The final sequence contains only literals. Blocks are self-contained.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <math.h>
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary Define the number of bits used to index the compressor hash table.
+/// The table is allocated on the stack and occupies (1 << LZ_HASH_BITS) * 4 bytes.
+#ifndef LZ_HASH_BITS
+#define LZ_HASH_BITS          12
+#endif
+
+/// @summary The minimum length of a match, in bytes.
+#define LZ_MIN_MATCH          4
+
+/// @summary The maximum distance back to the start of a match, in bytes.
+#define LZ_MAX_OFFSET         65535
+
+/// @summary The number of bytes at the end of a block that are always stored as literals.
+#define LZ_LAST_LITERALS      5
+
+/// @summary The minimum distance from the end of a block at which a match may start.
+#define LZ_MATCH_LIMIT        12
+
+/// @summary The largest block size, in bytes, that can be compressed in a single call.
+#define LZ_MAX_BLOCK_SIZE     0x7E000000U
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Read a 32-bit value from an address that may not be aligned.
+/// @param p The address to read from.
+/// @return The 32-bit value at the specified address.
+internal_function inline uint32_t lz_read32(uint8_t const *p)
+{
+    uint32_t v; memcpy(&v, p, sizeof(uint32_t));
+    return v;
+}
+
+/// @summary Compute the hash table index for a four-byte sequence.
+/// @param sequence The four-byte sequence.
+/// @return The hash table index.
+internal_function inline uint32_t lz_hash(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/// @summary Write the extension bytes of a literal or match length of 15 or more.
+/// @param op The output write cursor.
+/// @param len The length value, minus 15.
+/// @return The updated output write cursor.
+internal_function inline uint8_t* lz_write_length(uint8_t *op, size_t len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len  -= 255;
+    }
+    *op++ = uint8_t(len);
+    return op;
+}
+
+/// @summary Read the extension bytes of a literal or match length.
+/// @param ip The input read cursor, updated on return.
+/// @param iend A pointer to one-past the last byte of input.
+/// @param len The length value, updated on return.
+/// @return true if the length was read, or false if the input is truncated.
+internal_function inline bool lz_read_length(uint8_t const *&ip, uint8_t const *iend, size_t &len)
+{
+    uint32_t b = 255;
+    while (b == 255)
+    {
+        if (ip >= iend)
+        {   // the input is truncated.
+            return false;
+        }
+        b    = *ip++;
+        len +=  b;
+    }
+    return true;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Calculate the maximum size of a compressed block, which occurs when the input is incompressible.
+/// @param src_size The size of the uncompressed data, in bytes.
+/// @return The minimum size of an output buffer guaranteed to hold the compressed data.
+public_function inline size_t lz_compress_bound(size_t src_size)
+{
+    return src_size + (src_size / 255) + 16;
+}
+
+/// @summary Compress a block of data.
+/// @param dst The output buffer.
+/// @param dst_size The maximum number of bytes that can be written to the output buffer.
+/// @param src The data to compress.
+/// @param src_size The number of bytes to read from src. This value must be less than LZ_MAX_BLOCK_SIZE.
+/// @return The number of bytes written to dst, or zero if the compressed data does not fit in dst_size bytes.
+public_function size_t lz_compress(void *dst, size_t dst_size, void const *src, size_t src_size)
+{
+    uint8_t const *base   =(uint8_t const*) src;
+    uint8_t const *iend   = base + src_size;
+    uint8_t const *ip     = base;
+    uint8_t const *anchor = base;
+    uint8_t       *op     =(uint8_t*) dst;
+    uint8_t       *oend   = op + dst_size;
+    uint32_t       table[1 << LZ_HASH_BITS];
+
+    if (src_size >= LZ_MAX_BLOCK_SIZE)
+    {   // positions are stored as 32-bit values.
+        return 0;
+    }
+    if (src_size > LZ_MATCH_LIMIT)
+    {   // search for matches; the tail of the block is always emitted as literals.
+        uint8_t const *match_start = iend - LZ_MATCH_LIMIT;
+        uint8_t const *match_end   = iend - LZ_LAST_LITERALS;
+        memset(table, 0, sizeof(table));
+        table[lz_hash(lz_read32(ip))] = 0;
+        ip++;
+        while (ip < match_start)
+        {
+            uint32_t       seq = lz_read32(ip);
+            uint32_t       h   = lz_hash(seq);
+            uint8_t const *ref = base + table[h];
+            table[h]  = uint32_t(ip - base);
+            if (ref >= ip || (ip - ref) > LZ_MAX_OFFSET || lz_read32(ref) != seq)
+            {   // no match; skip ahead faster the longer we go without finding one.
+                ip += 1 + (size_t(ip - anchor) >> 6);
+                continue;
+            }
+            // extend the match backwards into the pending literals.
+            while (ip > anchor && ref > base && ip[-1] == ref[-1])
+            {
+                ip--; ref--;
+            }
+            // extend the match forwards.
+            uint8_t const *mp = ip  + LZ_MIN_MATCH;
+            uint8_t const *rp = ref + LZ_MIN_MATCH;
+            while (mp < match_end && *mp == *rp)
+            {
+                mp++; rp++;
+            }
+            size_t lit_len   = size_t(ip - anchor);
+            size_t match_len = size_t(mp - ip) - LZ_MIN_MATCH;
+            size_t offset    = size_t(ip - ref);
+            if (size_t(oend - op) < 1 + (lit_len / 255) + 1 + lit_len + 2 + (match_len / 255) + 1)
+            {   // the output buffer is too small.
+                return 0;
+            }
+            // emit the sequence token and the literal run.
+            uint8_t *token = op++;
+            *token = uint8_t((lit_len >= 15 ? 15 : lit_len) << 4);
+            if (lit_len >= 15) op = lz_write_length(op, lit_len - 15);
+            memcpy(op, anchor, lit_len); op += lit_len;
+            // emit the match offset and length.
+            op[0]  = uint8_t(offset);
+            op[1]  = uint8_t(offset >> 8); op += 2;
+            *token|= uint8_t(match_len >= 15 ? 15 : match_len);
+            if (match_len >= 15) op = lz_write_length(op, match_len - 15);
+            // resume the search after the match, seeding the table with a nearby position.
+            ip     = mp;
+            anchor = mp;
+            table[lz_hash(lz_read32(ip - 2))] = uint32_t(ip - 2 - base);
+        }
+    }
+    // emit the final literal run.
+    size_t lit_len = size_t(iend - anchor);
+    if (size_t(oend - op) < 1 + (lit_len / 255) + 1 + lit_len)
+    {   // the output buffer is too small.
+        return 0;
+    }
+    uint8_t *token = op++;
+    *token = uint8_t((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15) op = lz_write_length(op, lit_len - 15);
+    memcpy(op, anchor, lit_len); op += lit_len;
+    return size_t(op - (uint8_t*) dst);
+}
+
+/// @summary Decompress a block of data produced by lz_compress(). The input is fully validated.
+/// @param dst The output buffer.
+/// @param dst_size The maximum number of bytes that can be written to the output buffer.
+/// @param src The compressed data.
+/// @param src_size The number of bytes of compressed data.
+/// @return The number of bytes written to dst, or zero if the input is malformed or does not fit in dst_size bytes.
+public_function size_t lz_decompress(void *dst, size_t dst_size, void const *src, size_t src_size)
+{
+    uint8_t const *ip   =(uint8_t const*) src;
+    uint8_t const *iend = ip + src_size;
+    uint8_t       *base =(uint8_t*) dst;
+    uint8_t       *op   = base;
+    uint8_t       *oend = op + dst_size;
+    while (ip < iend)
+    {
+        uint32_t token   = *ip++;
+        size_t   lit_len = token >> 4;
+        if (lit_len == 15 && !lz_read_length(ip, iend, lit_len))
+        {   // the input is truncated.
+            return 0;
+        }
+        if (lit_len > size_t(iend - ip) || lit_len > size_t(oend - op))
+        {   // the literal run extends past the end of the input or output.
+            return 0;
+        }
+        memcpy(op, ip, lit_len);
+        op += lit_len;
+        ip += lit_len;
+        if (ip == iend)
+        {   // the final sequence has no match.
+            break;
+        }
+        if (size_t(iend - ip) < 2)
+        {   // the input is truncated.
+            return 0;
+        }
+        size_t offset    = size_t(ip[0]) | (size_t(ip[1]) << 8); ip += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !lz_read_length(ip, iend, match_len))
+        {   // the input is truncated.
+            return 0;
+        }
+        match_len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > size_t(op - base) || match_len > size_t(oend - op))
+        {   // the match references data outside of the output buffer.
+            return 0;
+        }
+        uint8_t const *ref = op - offset;
+        if (offset >= match_len)
+        {   // the source and destination ranges do not overlap.
+            memcpy(op, ref, match_len);
+        }
+        else
+        {   // overlapping copy, used to encode runs; must proceed byte-by-byte.
+            for (size_t i = 0; i < match_len; ++i)
+            {
+                op[i] = ref[i];
+            }
+        }
+        op += match_len;
+    }
+    return size_t(op - base);
+}
+
+/// @summary Estimate the order-0 entropy of a block of data by sampling it.
+/// Data with an entropy close to 8 bits per-byte is unlikely to compress.
+/// @param src The data to examine.
+/// @param src_size The number of bytes of data.
+/// @param max_samples The maximum number of bytes to sample. Samples are taken in evenly-spaced 64-byte runs.
+/// @return The estimated entropy, in bits per-byte, in [0, 8].
+public_function float lz_estimate_entropy(void const *src, size_t src_size, size_t max_samples)
+{
+    uint8_t const *data  =(uint8_t const*) src;
+    size_t const   run   = 64;
+    size_t         count = 0;
+    size_t         step  = run;
+    uint32_t       histogram[256];
+
+    if (src_size == 0 || max_samples == 0)
+    {   // no data; report it as perfectly compressible.
+        return 0.0f;
+    }
+    if (src_size > max_samples)
+    {   // sample runs of bytes spread evenly across the input.
+        step = (src_size / (max_samples / run + 1)) & ~(run - 1);
+        if (step < run) step = run;
+    }
+    memset(histogram, 0, sizeof(histogram));
+    for (size_t offset = 0; offset < src_size; offset += step)
+    {
+        size_t n = (src_size - offset) < run ? (src_size - offset) : run;
+        for (size_t i = 0; i < n; ++i)
+        {
+            histogram[data[offset + i]]++;
+        }
+        count += n;
+    }
+    double entropy = 0.0;
+    double scale   = 1.0 / double(count);
+    for (size_t i = 0; i < 256; ++i)
+    {
+        if (histogram[i] > 0)
+        {
+            double p = double(histogram[i]) * scale;
+            entropy -= p * log(p);
+        }
+    }
+    return float(entropy * 1.4426950408889634); // convert from nats to bits.
+}
@@ -59,6 +59,8 @@ struct pio_sti_request_t
     size_t            SectorSize;    /// The physical disk sector size, in bytes.
     int64_t           BaseOffset;    /// The absolute offset of the start of the data within the file.
     int64_t           BaseSize;      /// The size of the data within the file, in bytes.
+    int64_t           RangeOffset;   /// The offset of the first byte to read, relative to BaseOffset. Must be a multiple of SectorSize for unbuffered I/O.
+    int64_t           RangeFinal;    /// The offset one past the last byte to read, relative to BaseOffset, or BaseSize to read to the end of the data.
     uint64_t          IntervalNs;    /// The required delivery interval, in nanoseconds, or zero.
     uint32_t          StreamFlags;   /// A combination of pio_stream_in_flags_e.
     uint8_t           BasePriority;  /// The base priority of the stream.
@@ -73,6 +75,8 @@ struct pio_sti_state_t
     HANDLE            Fildes;        /// The file descriptor for the file.
     int64_t           BaseOffset;    /// The absolute byte offset of the start of the file data.
     int64_t           BaseSize;      /// The physical file size, in bytes.
+    int64_t           RangeOffset;   /// The offset at which the stream starts and restarts, relative to BaseOffset.
+    int64_t           RangeFinal;    /// The offset at which the stream ends, relative to BaseOffset.
     int64_t           ReadOffset;    /// The current read offset for the stream, in bytes.
 };
 
@@ -800,7 +804,9 @@ internal_function void pio_driver_main(pio_driver_t *driver)
         si.Fildes        = openrq.Fildes;
         si.BaseOffset    = openrq.BaseOffset;
         si.BaseSize      = openrq.BaseSize;
-        si.ReadOffset    = 0;
+        si.RangeOffset   = openrq.RangeOffset;
+        si.RangeFinal    = openrq.RangeFinal;
+        si.ReadOffset    = openrq.RangeOffset;
 
         // data required for interval-based delivery.
         pio_sti_delivery_t *sd = &driver->StreamInDelivery[list_index];
@@ -833,7 +839,7 @@ internal_function void pio_driver_main(pio_driver_t *driver)
                     break;
                 case PIO_STREAM_IN_CONTROL_REWIND:
                     driver->StreamInStatus[i] &=~PIO_STREAM_IN_STATUS_PAUSED;
-                    driver->StreamInState [i].ReadOffset = 0;
+                    driver->StreamInState [i].ReadOffset = driver->StreamInState[i].RangeOffset;
                     break;
                 case PIO_STREAM_IN_CONTROL_SEEK:
                     {   // reads can only start at even multiples of the disk sector size.
@@ -889,7 +895,9 @@ internal_function void pio_driver_main(pio_driver_t *driver)
         if (pio_sti_priority_queue_top(driver->STIActiveQueue, index, priority))
         {   // attempt to reserve a buffer for the read operation.
             stream_decoder_t *sc = driver->StreamInDecoder[index];
+            if (sc->BufferLock != NULL) AcquireSRWLockExclusive(sc->BufferLock);
             void *rdbuf  =    sc->BufferAllocator->get_buffer();
+            if (sc->BufferLock != NULL) ReleaseSRWLockExclusive(sc->BufferLock);
             if   (rdbuf == NULL)
             {   // no buffer space. pop this stream and continue with the next.
                 pio_sti_priority_queue_pop(driver->STIActiveQueue);
@@ -903,25 +911,25 @@ internal_function void pio_driver_main(pio_driver_t *driver)
             uint32_t data_amount  =(uint32_t) sc->BufferAllocator->AllocSize;
             uint32_t stream_flags = si.StreamFlags;
             HANDLE   fd           = si.Fildes;
-            int64_t  file_size    = si.BaseSize;
+            int64_t  range_final  = si.RangeFinal;
             int64_t  base_offset  = si.BaseOffset;
             int64_t  start_offset = si.ReadOffset;
             int64_t  final_offset = si.ReadOffset + data_amount;
             uint32_t status_flags = STREAM_DECODE_STATUS_NONE;
             uint32_t close_flags  = AIO_CLOSE_FLAGS_NONE;
 
-            if (final_offset  < file_size)
-            {   // this read operation does not reach or exceed the end of the file.
+            if (final_offset  < range_final)
+            {   // this read operation does not reach or exceed the end of the range.
                 si.ReadOffset = final_offset;
                 end_of_stream = false;
                 data_actual   = data_amount;
             }
             else
-            {   // this read operation reaches the end of the file.
+            {   // this read operation reaches the end of the range.
                 // compute the amount of data that's actually valid,
                 // even though the read operation may transfer more.
                 pio_sti_priority_queue_pop(driver->STIActiveQueue);
-                data_actual   = uint32_t(file_size - start_offset);
+                data_actual   = uint32_t(range_final - start_offset);
                 end_of_stream = true;
                 if (stream_flags  & PIO_STREAM_IN_FLAGS_LOAD)
                 {   // this is a load-once stream; mark it pending close.
@@ -933,7 +941,7 @@ internal_function void pio_driver_main(pio_driver_t *driver)
                 else
                 {   // this is a controlled stream, so loop back to the beginning.
                     status_flags |= STREAM_DECODE_STATUS_RESTART;
-                    si.ReadOffset = 0;
+                    si.ReadOffset = si.RangeOffset;
                 }
             }
 
@@ -0,0 +1,853 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements conversions between uncompressed pixel formats: RGBA8
+/// and BGRA8 channel swizzles, BGRX8 alpha expansion, RGB32F to RGBA32F, the
+/// unpacking of R10G10B10A2 to RGBA8, RGBA16 or RGBA16F, and conversions between
+/// 16-bit and 32-bit floating-point channels. The color kernel additionally 
+/// converts straight alpha to premultiplied alpha and decodes or encodes sRGB; 
+/// sRGB decoding uses a 256-entry table, and encoding uses a piecewise-linear 
+/// table indexed by the float exponent and leading mantissa bits. Every 
+/// conversion is a function of a single pixel, so a pixel stream may be 
+/// converted in pieces of any length, in any order, and on any thread. The 
+/// kernels use SSE2; half-float conversion uses F16C when the processor and 
+/// operating system support it.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <intrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The number of pixels processed by one iteration of a conversion kernel.
+#define PIXEL_CONVERT_GROUP       4
+
+/// @summary The size of the largest supported pixel (RGBA32F), in bytes.
+#define PIXEL_CONVERT_MAX_SIZE    16
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define the supported conversion kernels.
+enum pixel_convert_kernel_e : int
+{
+    PIXEL_CONVERT_KERNEL_NONE           = 0, /// No conversion is available.
+    PIXEL_CONVERT_KERNEL_SWAP_RB        = 1, /// RGBA8 <-> BGRA8.
+    PIXEL_CONVERT_KERNEL_SET_ALPHA      = 2, /// BGRX8 -> BGRA8, with alpha set to 255.
+    PIXEL_CONVERT_KERNEL_SWAP_RB_ALPHA  = 3, /// BGRX8 -> RGBA8, with alpha set to 255.
+    PIXEL_CONVERT_KERNEL_RGB32F_RGBA32F = 4, /// RGB32F -> RGBA32F, with alpha set to 1.0.
+    PIXEL_CONVERT_KERNEL_RGB10A2_RGBA8  = 5, /// R10G10B10A2 -> RGBA8.
+    PIXEL_CONVERT_KERNEL_RGB10A2_RGBA16 = 6, /// R10G10B10A2 -> RGBA16 UNORM.
+    PIXEL_CONVERT_KERNEL_RGB10A2_RGBA16F= 7, /// R10G10B10A2 -> RGBA16F.
+    PIXEL_CONVERT_KERNEL_HALF_FLOAT     = 8, /// 16-bit float channels -> 32-bit float channels.
+    PIXEL_CONVERT_KERNEL_FLOAT_HALF     = 9, /// 32-bit float channels -> 16-bit float channels.
+    PIXEL_CONVERT_KERNEL_COLOR          =10, /// RGBA8, RGBA16F or RGBA32F -> RGBA8, RGBA16F or RGBA32F, applying pixel_convert_option_e.
+};
+
+/// @summary Define the options applied by the color kernel. The kernel decodes each pixel to linear RGBA32F, 
+/// applies the options, and encodes the result in the target format.
+enum pixel_convert_option_e : uint32_t
+{
+    PIXEL_CONVERT_OPTION_NONE           = (0 << 0), /// Channel values are converted without modification.
+    PIXEL_CONVERT_OPTION_PREMULTIPLY    = (1 << 0), /// The color channels are multiplied by alpha, in linear space.
+    PIXEL_CONVERT_OPTION_DECODE_SRGB    = (1 << 1), /// The 8-bit source color channels are sRGB-encoded.
+    PIXEL_CONVERT_OPTION_ENCODE_SRGB    = (1 << 2), /// The 8-bit target color channels are sRGB-encoded.
+    PIXEL_CONVERT_OPTION_SWAP_SOURCE    = (1 << 3), /// The 8-bit source pixels are in BGRA order.
+    PIXEL_CONVERT_OPTION_SWAP_TARGET    = (1 << 4), /// The 8-bit target pixels are in BGRA order.
+    PIXEL_CONVERT_OPTION_OPAQUE         = (1 << 5), /// The source has no alpha channel, so alpha is 1.0.
+};
+
+/// @summary Describes a conversion between two pixel formats, as initialized by pixel_convert_setup().
+struct pixel_convert_t
+{
+    int                       Kernel;            /// One of pixel_convert_kernel_e.
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the source pixel format.
+    uint32_t                  TargetFormat;      /// One of dxgi_format_e specifying the target pixel format.
+    size_t                    SourceSize;        /// The size of one source pixel, in bytes.
+    size_t                    TargetSize;        /// The size of one target pixel, in bytes.
+    size_t                    Channels;          /// The number of channels per-pixel, for the floating-point kernels.
+    uint32_t                  Options;           /// A combination of pixel_convert_option_e, for the color kernel.
+    bool                      UseF16C;           /// true if the F16C instructions may be used for half-float conversion.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary Maps an 8-bit sRGB-encoded value to the corresponding linear value in [0, 1].
+global_variable float const PIXEL_SRGB8_TO_LINEAR[256] = 
+{
+    0.000000000e+00f, 3.035269835e-04f, 6.070539671e-04f, 9.105809506e-04f, 1.214107934e-03f, 1.517634918e-03f, 1.821161901e-03f, 2.124688885e-03f,
+    2.428215868e-03f, 2.731742852e-03f, 3.035269835e-03f, 3.346535764e-03f, 3.676507324e-03f, 4.024717018e-03f, 4.391442037e-03f, 4.776953481e-03f,
+    5.181516702e-03f, 5.605391624e-03f, 6.048833023e-03f, 6.512090793e-03f, 6.995410187e-03f, 7.499032043e-03f, 8.023192985e-03f, 8.568125618e-03f,
+    9.134058702e-03f, 9.721217320e-03f, 1.032982303e-02f, 1.096009401e-02f, 1.161224518e-02f, 1.228648836e-02f, 1.298303234e-02f, 1.370208305e-02f,
+    1.444384360e-02f, 1.520851442e-02f, 1.599629337e-02f, 1.680737575e-02f, 1.764195449e-02f, 1.850022013e-02f, 1.938236096e-02f, 2.028856306e-02f,
+    2.121901038e-02f, 2.217388479e-02f, 2.315336618e-02f, 2.415763245e-02f, 2.518685963e-02f, 2.624122189e-02f, 2.732089164e-02f, 2.842603950e-02f,
+    2.955683444e-02f, 3.071344373e-02f, 3.189603307e-02f, 3.310476657e-02f, 3.433980681e-02f, 3.560131488e-02f, 3.688945040e-02f, 3.820437160e-02f,
+    3.954623528e-02f, 4.091519691e-02f, 4.231141062e-02f, 4.373502926e-02f, 4.518620439e-02f, 4.666508634e-02f, 4.817182423e-02f, 4.970656598e-02f,
+    5.126945837e-02f, 5.286064702e-02f, 5.448027644e-02f, 5.612849005e-02f, 5.780543019e-02f, 5.951123816e-02f, 6.124605423e-02f, 6.301001765e-02f,
+    6.480326669e-02f, 6.662593864e-02f, 6.847816984e-02f, 7.036009570e-02f, 7.227185068e-02f, 7.421356838e-02f, 7.618538148e-02f, 7.818742181e-02f,
+    8.021982031e-02f, 8.228270713e-02f, 8.437621154e-02f, 8.650046204e-02f, 8.865558629e-02f, 9.084171118e-02f, 9.305896285e-02f, 9.530746663e-02f,
+    9.758734714e-02f, 9.989872825e-02f, 1.022417331e-01f, 1.046164841e-01f, 1.070231030e-01f, 1.094617108e-01f, 1.119324278e-01f, 1.144353738e-01f,
+    1.169706678e-01f, 1.195384280e-01f, 1.221387722e-01f, 1.247718176e-01f, 1.274376804e-01f, 1.301364767e-01f, 1.328683216e-01f, 1.356333297e-01f,
+    1.384316150e-01f, 1.412632911e-01f, 1.441284709e-01f, 1.470272665e-01f, 1.499597898e-01f, 1.529261520e-01f, 1.559264637e-01f, 1.589608351e-01f,
+    1.620293756e-01f, 1.651321945e-01f, 1.682694002e-01f, 1.714411007e-01f, 1.746474037e-01f, 1.778884160e-01f, 1.811642442e-01f, 1.844749945e-01f,
+    1.878207723e-01f, 1.912016827e-01f, 1.946178304e-01f, 1.980693196e-01f, 2.015562538e-01f, 2.050787364e-01f, 2.086368701e-01f, 2.122307574e-01f,
+    2.158605001e-01f, 2.195261997e-01f, 2.232279573e-01f, 2.269658735e-01f, 2.307400485e-01f, 2.345505822e-01f, 2.383975738e-01f, 2.422811225e-01f,
+    2.462013267e-01f, 2.501582847e-01f, 2.541520943e-01f, 2.581828529e-01f, 2.622506575e-01f, 2.663556048e-01f, 2.704977910e-01f, 2.746773121e-01f,
+    2.788942635e-01f, 2.831487404e-01f, 2.874408377e-01f, 2.917706498e-01f, 2.961382708e-01f, 3.005437944e-01f, 3.049873141e-01f, 3.094689228e-01f,
+    3.139887134e-01f, 3.185467781e-01f, 3.231432091e-01f, 3.277780981e-01f, 3.324515363e-01f, 3.371636150e-01f, 3.419144249e-01f, 3.467040564e-01f,
+    3.515325995e-01f, 3.564001441e-01f, 3.613067798e-01f, 3.662525956e-01f, 3.712376805e-01f, 3.762621230e-01f, 3.813260114e-01f, 3.864294338e-01f,
+    3.915724777e-01f, 3.967552307e-01f, 4.019777798e-01f, 4.072402119e-01f, 4.125426135e-01f, 4.178850708e-01f, 4.232676700e-01f, 4.286904966e-01f,
+    4.341536362e-01f, 4.396571738e-01f, 4.452011945e-01f, 4.507857828e-01f, 4.564110232e-01f, 4.620769997e-01f, 4.677837961e-01f, 4.735314961e-01f,
+    4.793201831e-01f, 4.851499401e-01f, 4.910208498e-01f, 4.969329951e-01f, 5.028864580e-01f, 5.088813209e-01f, 5.149176654e-01f, 5.209955732e-01f,
+    5.271151257e-01f, 5.332764040e-01f, 5.394794890e-01f, 5.457244614e-01f, 5.520114015e-01f, 5.583403896e-01f, 5.647115057e-01f, 5.711248295e-01f,
+    5.775804404e-01f, 5.840784179e-01f, 5.906188409e-01f, 5.972017884e-01f, 6.038273389e-01f, 6.104955708e-01f, 6.172065624e-01f, 6.239603917e-01f,
+    6.307571363e-01f, 6.375968740e-01f, 6.444796820e-01f, 6.514056374e-01f, 6.583748173e-01f, 6.653872983e-01f, 6.724431570e-01f, 6.795424696e-01f,
+    6.866853124e-01f, 6.938717613e-01f, 7.011018919e-01f, 7.083757799e-01f, 7.156935005e-01f, 7.230551289e-01f, 7.304607401e-01f, 7.379104088e-01f,
+    7.454042095e-01f, 7.529422168e-01f, 7.605245047e-01f, 7.681511472e-01f, 7.758222183e-01f, 7.835377915e-01f, 7.912979403e-01f, 7.991027380e-01f,
+    8.069522577e-01f, 8.148465722e-01f, 8.227857544e-01f, 8.307698768e-01f, 8.387990117e-01f, 8.468732315e-01f, 8.549926081e-01f, 8.631572135e-01f,
+    8.713671192e-01f, 8.796223969e-01f, 8.879231179e-01f, 8.962693534e-01f, 9.046611744e-01f, 9.130986518e-01f, 9.215818563e-01f, 9.301108584e-01f,
+    9.386857285e-01f, 9.473065367e-01f, 9.559733532e-01f, 9.646862479e-01f, 9.734452904e-01f, 9.822505503e-01f, 9.911020971e-01f, 1.000000000e+00f
+};
+
+/// @summary The piecewise-linear approximation of the sRGB encoding curve used by pixel_linear_to_srgb8(). 
+/// Entry i covers linear values with biased exponent and leading three mantissa bits (i + ((127 - 13) << 3)). 
+/// The high 16 bits store the bias, divided by 512, and the low 16 bits store the slope; both are 16.16 fixed-point. 
+/// The result is within 0.544 of the exact encoded value, so it is off by at most one code value.
+global_variable uint32_t const PIXEL_LINEAR_TO_SRGB8[104] = 
+{
+    0x0073000D, 0x007A000D, 0x0080000D, 0x0087000D, 0x008D000D, 0x0094000D, 0x009A000D, 0x00A1000D,
+    0x00A7001A, 0x00B4001A, 0x00C1001A, 0x00CE001A, 0x00DA001A, 0x00E7001A, 0x00F4001A, 0x0101001A,
+    0x010E0033, 0x01280033, 0x01410033, 0x015B0033, 0x01750033, 0x018F0033, 0x01A80033, 0x01C20033,
+    0x01DC0067, 0x020F0067, 0x02430067, 0x02760067, 0x02AA0067, 0x02DD0067, 0x03110067, 0x03440067,
+    0x037800CE, 0x03DF00CE, 0x044600CE, 0x04AD00CE, 0x051400CE, 0x057B00C5, 0x05DD00BC, 0x063B00B5,
+    0x06970158, 0x07420142, 0x07E30130, 0x087B0120, 0x090B0112, 0x09940106, 0x0A1700FC, 0x0A9500F2,
+    0x0B0F01CB, 0x0BF401AE, 0x0CCB0195, 0x0D950180, 0x0E56016E, 0x0F0D015E, 0x0FBC0150, 0x10630143,
+    0x11070264, 0x1238023E, 0x1357021D, 0x14660201, 0x156601E9, 0x165A01D3, 0x174401C0, 0x182401AF,
+    0x18FE0331, 0x1A9602FE, 0x1C1502D2, 0x1D7E02AD, 0x1ED4028D, 0x201A0270, 0x21520256, 0x227D0240,
+    0x239F0443, 0x25C003FE, 0x27BF03C4, 0x29A10392, 0x2B6A0367, 0x2D1D0341, 0x2EBE031F, 0x304D0300,
+    0x31D105B0, 0x34A80555, 0x37520507, 0x39D504C5, 0x3C37048B, 0x3E7C0458, 0x40A8042A, 0x42BD0401,
+    0x44C20798, 0x488E071E, 0x4C1C06B6, 0x4F76065D, 0x52A50610, 0x55AC05CC, 0x5892058F, 0x5B590559,
+    0x5E0C0A23, 0x631C0980, 0x67DB08F6, 0x6C55087F, 0x70940818, 0x74A007BD, 0x787D076C, 0x7C330723
+};
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Determine whether the F16C half-float conversion instructions are available. The AVX state must be enabled by the operating system.
+/// @return true if F16C may be used.
+internal_function bool pixel_cpu_has_f16c(void)
+{
+    int info[4] = {0};
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx     = (info[2] & (1 << 28)) != 0;
+    bool f16c    = (info[2] & (1 << 29)) != 0;
+    if (!osxsave || !avx || !f16c)
+        return false;
+    // the XMM and YMM register state must be saved and restored by the OS.
+    return (_xgetbv(0) & 0x6) == 0x6;
+}
+
+/// @summary Exchange the red and blue channels of four packed 8-bit pixels.
+/// @param p Four RGBA8 or BGRA8 pixels.
+/// @return The four pixels with the red and blue channels exchanged.
+internal_function inline __m128i pixel_swap_rb(__m128i p)
+{
+    __m128i ag = _mm_and_si128(p, _mm_set1_epi32(int(0xFF00FF00)));
+    __m128i rb = _mm_and_si128(p, _mm_set1_epi32(int(0x00FF00FF)));
+    return _mm_or_si128(ag, _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+}
+
+/// @summary Convert four half-precision values, each stored in the low 16 bits of a 32-bit lane, to single precision.
+/// Denormals are renormalized by the multiply, and infinities and NaNs are preserved.
+/// @param h The half-precision values, zero-extended to 32 bits.
+/// @return The single-precision values.
+internal_function inline __m128 pixel_half_to_float_sse2(__m128i h)
+{
+    __m128i expmant  = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+    __m128i justsign = _mm_xor_si128(h, expmant);
+    __m128i infnan   = _mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7BFF));
+    // shift the exponent and mantissa into place, then rebias the exponent from 15 to 127.
+    __m128  scaled   = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+    __m128i infexp   = _mm_and_si128(infnan, _mm_set1_epi32(255 << 23));
+    __m128i sign     = _mm_or_si128(_mm_slli_epi32(justsign, 16), infexp);
+    return _mm_or_ps(scaled, _mm_castsi128_ps(sign));
+}
+
+/// @summary Convert four single-precision values to half precision, rounding to nearest even. Values too large for
+/// half precision become infinity, and NaNs remain NaNs.
+/// @param f The single-precision values.
+/// @return The half-precision values, each in the low 16 bits of a 32-bit lane.
+internal_function inline __m128i pixel_float_to_half_sse2(__m128 f)
+{
+    __m128i c_subnorm = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    __m128  justsign  = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000))));
+    __m128  absf      = _mm_xor_ps(f, justsign);
+    __m128i absi      = _mm_castps_si128(absf);
+    __m128i isnan     = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+    __m128i isregular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), absi);
+    __m128i issub     = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), absi);
+    __m128i infnan    = _mm_or_si128(_mm_and_si128(isnan, _mm_set1_epi32(0x0200)), _mm_set1_epi32(0x7C00));
+    // results in the subnormal range are rounded by the FPU when adding the magic value.
+    __m128i subnorm   = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(c_subnorm))), c_subnorm);
+    // normal results rebias the exponent and round the mantissa to nearest even.
+    __m128i mantodd   = _mm_srai_epi32(_mm_slli_epi32(absi, 31 - 13), 31);
+    __m128i rounded   = _mm_sub_epi32(_mm_add_epi32(absi, _mm_set1_epi32(0x0FFF - ((127 - 15) << 23))), mantodd);
+    __m128i normal    = _mm_srli_epi32(rounded, 13);
+    __m128i finite    = _mm_or_si128(_mm_and_si128(issub, subnorm), _mm_andnot_si128(issub, normal));
+    __m128i joined    = _mm_or_si128(_mm_and_si128(isregular, finite), _mm_andnot_si128(isregular, infnan));
+    return _mm_or_si128(joined, _mm_srli_epi32(_mm_castps_si128(justsign), 16));
+}
+
+/// @summary Pack eight half-precision values, each in the low 16 bits of a 32-bit lane, into a single register.
+/// @param lo The first four values.
+/// @param hi The last four values.
+/// @return The eight 16-bit values.
+internal_function inline __m128i pixel_pack_half(__m128i lo, __m128i hi)
+{   // sign-extend so that the signed saturating pack passes every bit pattern through unchanged.
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+/// @summary Encode four linear values in [0, 1] to 8-bit sRGB. Values below 2^-13, and NaNs, encode to 0; values above 1 encode to 255.
+/// @param f The linear values.
+/// @return The sRGB-encoded values, each in the low 8 bits of a 32-bit lane.
+internal_function inline __m128i pixel_linear_to_srgb8(__m128 f)
+{
+    __m128i minval = _mm_set1_epi32((127 - 13) << 23);
+    __m128  clamp  = _mm_min_ps(_mm_max_ps(f, _mm_castsi128_ps(minval)), _mm_castsi128_ps(_mm_set1_epi32(0x3F7FFFFF)));
+    __m128i bits   = _mm_castps_si128(clamp);
+    uint32_t index[4];
+    _mm_storeu_si128((__m128i*) index, _mm_srli_epi32(_mm_sub_epi32(bits, minval), 20));
+    // the table lookup is the only scalar step. madd computes (slope * mantissa) + (bias * 512).
+    __m128i entry  = _mm_setr_epi32(int(PIXEL_LINEAR_TO_SRGB8[index[0]]), int(PIXEL_LINEAR_TO_SRGB8[index[1]]), int(PIXEL_LINEAR_TO_SRGB8[index[2]]), int(PIXEL_LINEAR_TO_SRGB8[index[3]]));
+    __m128i mant   = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(bits, 12), _mm_set1_epi32(0xFF)), _mm_set1_epi32(512 << 16));
+    return _mm_srli_epi32(_mm_madd_epi16(entry, mant), 16);
+}
+
+/// @summary Load one RGBA8, RGBA16F or RGBA32F pixel and decode it to linear RGBA32F, applying the source options of the color kernel.
+/// @param cvt The conversion descriptor.
+/// @param src The source pixel.
+/// @return The pixel, as (r, g, b, a).
+internal_function inline __m128 pixel_color_load(pixel_convert_t const *cvt, uint8_t const *src)
+{
+    __m128 p;
+    if (cvt->SourceSize == 4)
+    {
+        int r = src[(cvt->Options & PIXEL_CONVERT_OPTION_SWAP_SOURCE) ? 2 : 0];
+        int g = src[1];
+        int b = src[(cvt->Options & PIXEL_CONVERT_OPTION_SWAP_SOURCE) ? 0 : 2];
+        int a = src[3];
+        if (cvt->Options & PIXEL_CONVERT_OPTION_DECODE_SRGB)
+            p = _mm_setr_ps(PIXEL_SRGB8_TO_LINEAR[r], PIXEL_SRGB8_TO_LINEAR[g], PIXEL_SRGB8_TO_LINEAR[b], float(a) * (1.0f / 255.0f));
+        else
+            p = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(r, g, b, a)), _mm_set1_ps(1.0f / 255.0f));
+    }
+    else if (cvt->SourceSize == 8)
+    {
+        __m128i h = _mm_loadl_epi64((__m128i const*) src);
+        if (cvt->UseF16C) p = _mm_cvtph_ps(h);
+        else p = pixel_half_to_float_sse2(_mm_unpacklo_epi16(h, _mm_setzero_si128()));
+    }
+    else p = _mm_loadu_ps((float const*) src);
+
+    if (cvt->Options & PIXEL_CONVERT_OPTION_OPAQUE)
+    {   // replace the undefined alpha channel with 1.0.
+        p = _mm_or_ps(_mm_and_ps(p, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    if (cvt->Options & PIXEL_CONVERT_OPTION_PREMULTIPLY)
+    {   // multiply (r, g, b, a) by (a, a, a, 1).
+        __m128 a = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+        p = _mm_mul_ps(p, _mm_or_ps(_mm_and_ps(a, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f)));
+    }
+    return p;
+}
+
+/// @summary Encode one linear RGBA32F pixel to RGBA8, applying the target options of the color kernel.
+/// @param cvt The conversion descriptor.
+/// @param p The pixel, as (r, g, b, a).
+/// @return The encoded channel values, one per 32-bit lane, in target order.
+internal_function inline __m128i pixel_color_encode8(pixel_convert_t const *cvt, __m128 p)
+{
+    __m128  unorm = _mm_mul_ps(_mm_min_ps(_mm_max_ps(p, _mm_setzero_ps()), _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f));
+    __m128i q     = _mm_cvtps_epi32(unorm);
+    if (cvt->Options & PIXEL_CONVERT_OPTION_ENCODE_SRGB)
+    {   // alpha is always stored linearly.
+        __m128i amask = _mm_setr_epi32(0, 0, 0, -1);
+        q = _mm_or_si128(_mm_andnot_si128(amask, pixel_linear_to_srgb8(p)), _mm_and_si128(amask, q));
+    }
+    if (cvt->Options & PIXEL_CONVERT_OPTION_SWAP_TARGET)
+    {
+        q = _mm_shuffle_epi32(q, _MM_SHUFFLE(3, 0, 1, 2));
+    }
+    return q;
+}
+
+/// @summary Convert pixels with the color kernel, which decodes to linear RGBA32F, optionally premultiplies alpha, and encodes to the target format.
+/// @param cvt The conversion descriptor.
+/// @param src The source RGBA8, BGRA8, BGRX8, RGBA16F or RGBA32F pixels.
+/// @param dst The destination RGBA8, BGRA8, RGBA16F or RGBA32F pixels.
+/// @param count The number of pixels to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+internal_function void pixel_convert_color(pixel_convert_t const *cvt, uint8_t const *src, uint8_t *dst, size_t count)
+{
+    size_t const ss = cvt->SourceSize;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128 p0 = pixel_color_load(cvt, src + (i + 0) * ss);
+        __m128 p1 = pixel_color_load(cvt, src + (i + 1) * ss);
+        __m128 p2 = pixel_color_load(cvt, src + (i + 2) * ss);
+        __m128 p3 = pixel_color_load(cvt, src + (i + 3) * ss);
+        if (cvt->TargetSize == 4)
+        {   // pack the four pixels to 8-bit; the values are in [0, 255], so saturation never applies.
+            __m128i lo = _mm_packs_epi32(pixel_color_encode8(cvt, p0), pixel_color_encode8(cvt, p1));
+            __m128i hi = _mm_packs_epi32(pixel_color_encode8(cvt, p2), pixel_color_encode8(cvt, p3));
+            _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+        else if (cvt->TargetSize == 8)
+        {
+            if (cvt->UseF16C)
+            {
+                _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), _mm_unpacklo_epi64(_mm_cvtps_ph(p0, 0), _mm_cvtps_ph(p1, 0)));
+                _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), _mm_unpacklo_epi64(_mm_cvtps_ph(p2, 0), _mm_cvtps_ph(p3, 0)));
+            }
+            else
+            {
+                _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), pixel_pack_half(pixel_float_to_half_sse2(p0), pixel_float_to_half_sse2(p1)));
+                _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), pixel_pack_half(pixel_float_to_half_sse2(p2), pixel_float_to_half_sse2(p3)));
+            }
+        }
+        else
+        {
+            float *d = (float*)(dst + i * 16);
+            _mm_storeu_ps(d +  0, p0);
+            _mm_storeu_ps(d +  4, p1);
+            _mm_storeu_ps(d +  8, p2);
+            _mm_storeu_ps(d + 12, p3);
+        }
+    }
+}
+
+/// @summary Determine whether a format can be read or written by the color kernel as 8-bit RGBA or BGRA.
+/// @param format One of dxgi_format_e.
+/// @return true if format is an 8-bit RGBA, BGRA or BGRX format.
+internal_function bool pixel_color_format_8bit(uint32_t format)
+{
+    switch (format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+/// @summary Determine the pixel format produced by the color stages of an encoder.
+/// @param src_format One of dxgi_format_e specifying the source pixel format.
+/// @param dst_format One of dxgi_format_e specifying the requested pixel format, or DXGI_FORMAT_UNKNOWN.
+/// @param flags A combination of the IMAGE_ENCODER_FLAGS_COLOR_STAGES flags. At least one must be set.
+/// @return The format of the converted data, or DXGI_FORMAT_UNKNOWN if the conversion is not supported.
+internal_function uint32_t pixel_color_target_format(uint32_t src_format, uint32_t dst_format, uint32_t flags)
+{
+    bool src_8bit  = pixel_color_format_8bit(src_format);
+    bool src_float =(src_format == DXGI_FORMAT_R16G16B16A16_FLOAT || src_format == DXGI_FORMAT_R32G32B32A32_FLOAT);
+    if (flags & IMAGE_ENCODER_FLAGS_SRGB_TO_LINEAR)
+    {   // the target is linear floating-point; RGBA16F unless RGBA32F is requested.
+        if ((flags & IMAGE_ENCODER_FLAGS_LINEAR_TO_SRGB) || (!src_8bit && !src_float))
+            return DXGI_FORMAT_UNKNOWN;
+        if (dst_format == DXGI_FORMAT_UNKNOWN || dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        if (dst_format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        return DXGI_FORMAT_UNKNOWN;
+    }
+    if (flags & IMAGE_ENCODER_FLAGS_LINEAR_TO_SRGB)
+    {   // the target is 8-bit sRGB; RGBA unless BGRA is requested.
+        if (!src_float)
+            return DXGI_FORMAT_UNKNOWN;
+        if (dst_format == DXGI_FORMAT_UNKNOWN || dst_format == DXGI_FORMAT_R8G8B8A8_UNORM || dst_format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+            return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        if (dst_format == DXGI_FORMAT_B8G8R8A8_UNORM || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+            return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+        return DXGI_FORMAT_UNKNOWN;
+    }
+    // premultiply only; the format may also be swizzled, or converted between RGBA16F and RGBA32F.
+    if (dst_format == DXGI_FORMAT_UNKNOWN || dst_format == src_format)
+    {
+        return (src_8bit || src_float) ? src_format : DXGI_FORMAT_UNKNOWN;
+    }
+    if (src_8bit)
+    {   // the sRGB-ness of the target follows the source.
+        bool srgb =(src_format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || src_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || src_format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB);
+        if (dst_format == DXGI_FORMAT_R8G8B8A8_UNORM || dst_format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+            return srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        if (dst_format == DXGI_FORMAT_B8G8R8A8_UNORM || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+            return srgb ? DXGI_FORMAT_B8G8R8A8_UNORM_SRGB : DXGI_FORMAT_B8G8R8A8_UNORM;
+    }
+    if (src_float && (dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT || dst_format == DXGI_FORMAT_R32G32B32A32_FLOAT))
+    {
+        return dst_format;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+/// @summary Convert 8-bit pixels by exchanging red and blue, forcing alpha to 255, or both.
+/// @param src The source RGBA8, BGRA8 or BGRX8 pixels.
+/// @param dst The destination pixels.
+/// @param count The number of pixels to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+/// @param swap Specify true to exchange the red and blue channels.
+/// @param alpha The value OR'd into each pixel; either 0 or 0xFF000000.
+internal_function void pixel_convert_rgba8(uint8_t const *src, uint8_t *dst, size_t count, bool swap, uint32_t alpha)
+{
+    __m128i a = _mm_set1_epi32(int(alpha));
+    size_t  i = 0;
+    for ( ; i + 8 <= count; i += 8)
+    {   // two registers per-iteration hide the latency of the dependent shifts.
+        __m128i p0 = _mm_loadu_si128((__m128i const*)(src + i * 4 +  0));
+        __m128i p1 = _mm_loadu_si128((__m128i const*)(src + i * 4 + 16));
+        if (swap)
+        {
+            p0 = pixel_swap_rb(p0);
+            p1 = pixel_swap_rb(p1);
+        }
+        _mm_storeu_si128((__m128i*)(dst + i * 4 +  0), _mm_or_si128(p0, a));
+        _mm_storeu_si128((__m128i*)(dst + i * 4 + 16), _mm_or_si128(p1, a));
+    }
+    for ( ; i < count; i += 4)
+    {
+        __m128i p0 = _mm_loadu_si128((__m128i const*)(src + i * 4));
+        if (swap) p0 = pixel_swap_rb(p0);
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(p0, a));
+    }
+}
+
+/// @summary Expand RGB32F pixels to RGBA32F, setting alpha to 1.0.
+/// @param src The source RGB32F pixels.
+/// @param dst The destination RGBA32F pixels.
+/// @param count The number of pixels to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+internal_function void pixel_convert_rgb32f_rgba32f(uint8_t const *src, uint8_t *dst, size_t count)
+{
+    __m128 one = _mm_set1_ps(1.0f);
+    for (size_t i = 0; i < count; i += 4)
+    {   // three loads hold four pixels: (r0 g0 b0 r1) (g1 b1 r2 g2) (b2 r3 g3 b3).
+        float const *s  = (float const*)(src + i * 12);
+        float       *d  = (float      *)(dst + i * 16);
+        __m128       v0 = _mm_loadu_ps(s + 0);
+        __m128       v1 = _mm_loadu_ps(s + 4);
+        __m128       v2 = _mm_loadu_ps(s + 8);
+        __m128       t0 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 0, 3, 3)); // (r1 r1 g1 b1)
+        __m128       t1 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0, 0, 3, 2)); // (r2 g2 b2 b2)
+        __m128       t2 = _mm_movehl_ps(one, v2);                          // (g3 b3  1  1)
+        __m128       p0 = _mm_shuffle_ps(v0, _mm_unpackhi_ps(v0, one), _MM_SHUFFLE(3, 0, 1, 0));
+        __m128       p1 = _mm_shuffle_ps(t0, _mm_unpackhi_ps(t0, one), _MM_SHUFFLE(3, 2, 2, 0));
+        __m128       p2 = _mm_shuffle_ps(t1, _mm_unpackhi_ps(t1, one), _MM_SHUFFLE(3, 0, 1, 0));
+        __m128       p3 = _mm_shuffle_ps(v2, t2, _MM_SHUFFLE(2, 1, 2, 1));
+        _mm_storeu_ps(d +  0, p0);
+        _mm_storeu_ps(d +  4, p1);
+        _mm_storeu_ps(d +  8, p2);
+        _mm_storeu_ps(d + 12, p3);
+    }
+}
+
+/// @summary Unpack R10G10B10A2 pixels to RGBA8, rounding each channel to the nearest 8-bit value.
+/// @param src The source R10G10B10A2 pixels.
+/// @param dst The destination RGBA8 pixels.
+/// @param count The number of pixels to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+internal_function void pixel_convert_rgb10a2_rgba8(uint8_t const *src, uint8_t *dst, size_t count)
+{
+    __m128i m10 = _mm_set1_epi32(0x3FF);
+    __m128  s10 = _mm_set1_ps(255.0f / 1023.0f);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128i p = _mm_loadu_si128((__m128i const*)(src + i * 4));
+        __m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(p, m10)), s10));
+        __m128i g = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 10), m10)), s10));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 20), m10)), s10));
+        __m128i a = _mm_mullo_epi16(_mm_srli_epi32(p, 30), _mm_set1_epi32(0x55));
+        __m128i o = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), o);
+    }
+}
+
+/// @summary Unpack R10G10B10A2 pixels to RGBA16 UNORM. The 10-bit channels are widened by bit replication, which is exact at 0 and 1.
+/// @param src The source R10G10B10A2 pixels.
+/// @param dst The destination RGBA16 pixels.
+/// @param count The number of pixels to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+internal_function void pixel_convert_rgb10a2_rgba16(uint8_t const *src, uint8_t *dst, size_t count)
+{
+    __m128i m10 = _mm_set1_epi32(0x3FF);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128i p  = _mm_loadu_si128((__m128i const*)(src + i * 4));
+        __m128i r  = _mm_and_si128(p, m10);
+        __m128i g  = _mm_and_si128(_mm_srli_epi32(p, 10), m10);
+        __m128i b  = _mm_and_si128(_mm_srli_epi32(p, 20), m10);
+        __m128i a  = _mm_mullo_epi16(_mm_srli_epi32(p, 30), _mm_set1_epi32(0x5555));
+        r = _mm_or_si128(_mm_slli_epi32(r, 6), _mm_srli_epi32(r, 4));
+        g = _mm_or_si128(_mm_slli_epi32(g, 6), _mm_srli_epi32(g, 4));
+        b = _mm_or_si128(_mm_slli_epi32(b, 6), _mm_srli_epi32(b, 4));
+        __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+        __m128i ba = _mm_or_si128(b, _mm_slli_epi32(a, 16));
+        _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), _mm_unpacklo_epi32(rg, ba));
+        _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), _mm_unpackhi_epi32(rg, ba));
+    }
+}
+
+/// @summary Unpack R10G10B10A2 pixels to RGBA16F.
+/// @param src The source R10G10B10A2 pixels.
+/// @param dst The destination RGBA16F pixels.
+/// @param count The number of pixels to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+/// @param f16c Specify true to use the F16C instructions.
+internal_function void pixel_convert_rgb10a2_rgba16f(uint8_t const *src, uint8_t *dst, size_t count, bool f16c)
+{
+    __m128i m10 = _mm_set1_epi32(0x3FF);
+    __m128  s10 = _mm_set1_ps(1.0f / 1023.0f);
+    __m128  s2  = _mm_set1_ps(1.0f / 3.0f);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128i p = _mm_loadu_si128((__m128i const*)(src + i * 4));
+        __m128  r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(p, m10)), s10);
+        __m128  g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 10), m10)), s10);
+        __m128  b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 20), m10)), s10);
+        __m128  a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(p, 30)), s2);
+        // transpose from one register per-channel to one register per-pixel.
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        if (f16c)
+        {
+            _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), _mm_unpacklo_epi64(_mm_cvtps_ph(r, 0), _mm_cvtps_ph(g, 0)));
+            _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), _mm_unpacklo_epi64(_mm_cvtps_ph(b, 0), _mm_cvtps_ph(a, 0)));
+        }
+        else
+        {
+            _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), pixel_pack_half(pixel_float_to_half_sse2(r), pixel_float_to_half_sse2(g)));
+            _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), pixel_pack_half(pixel_float_to_half_sse2(b), pixel_float_to_half_sse2(a)));
+        }
+    }
+}
+
+/// @summary Convert 16-bit floating-point channel values to 32-bit floating-point.
+/// @param src The source half-precision values.
+/// @param dst The destination single-precision values.
+/// @param count The number of values to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+/// @param f16c Specify true to use the F16C instructions.
+internal_function void pixel_convert_half_float(uint8_t const *src, uint8_t *dst, size_t count, bool f16c)
+{
+    float  *d = (float*) dst;
+    size_t  i = 0;
+    if (f16c)
+    {
+        for ( ; i + 8 <= count; i += 8)
+        {
+            __m128i h = _mm_loadu_si128((__m128i const*)(src + i * 2));
+            _mm_storeu_ps(d + i + 0, _mm_cvtph_ps(h));
+            _mm_storeu_ps(d + i + 4, _mm_cvtph_ps(_mm_srli_si128(h, 8)));
+        }
+        for ( ; i < count; i += 4)
+        {
+            _mm_storeu_ps(d + i, _mm_cvtph_ps(_mm_loadl_epi64((__m128i const*)(src + i * 2))));
+        }
+        return;
+    }
+    __m128i zero = _mm_setzero_si128();
+    for ( ; i + 8 <= count; i += 8)
+    {
+        __m128i h = _mm_loadu_si128((__m128i const*)(src + i * 2));
+        _mm_storeu_ps(d + i + 0, pixel_half_to_float_sse2(_mm_unpacklo_epi16(h, zero)));
+        _mm_storeu_ps(d + i + 4, pixel_half_to_float_sse2(_mm_unpackhi_epi16(h, zero)));
+    }
+    for ( ; i < count; i += 4)
+    {
+        __m128i h = _mm_loadl_epi64((__m128i const*)(src + i * 2));
+        _mm_storeu_ps(d + i, pixel_half_to_float_sse2(_mm_unpacklo_epi16(h, zero)));
+    }
+}
+
+/// @summary Convert 32-bit floating-point channel values to 16-bit floating-point, rounding to nearest even.
+/// @param src The source single-precision values.
+/// @param dst The destination half-precision values.
+/// @param count The number of values to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+/// @param f16c Specify true to use the F16C instructions.
+internal_function void pixel_convert_float_half(uint8_t const *src, uint8_t *dst, size_t count, bool f16c)
+{
+    float const *s = (float const*) src;
+    size_t       i = 0;
+    if (f16c)
+    {
+        for ( ; i + 8 <= count; i += 8)
+        {
+            __m128i lo = _mm_cvtps_ph(_mm_loadu_ps(s + i + 0), 0);
+            __m128i hi = _mm_cvtps_ph(_mm_loadu_ps(s + i + 4), 0);
+            _mm_storeu_si128((__m128i*)(dst + i * 2), _mm_unpacklo_epi64(lo, hi));
+        }
+        for ( ; i < count; i += 4)
+        {
+            _mm_storel_epi64((__m128i*)(dst + i * 2), _mm_cvtps_ph(_mm_loadu_ps(s + i), 0));
+        }
+        return;
+    }
+    for ( ; i + 8 <= count; i += 8)
+    {
+        __m128i lo = pixel_float_to_half_sse2(_mm_loadu_ps(s + i + 0));
+        __m128i hi = pixel_float_to_half_sse2(_mm_loadu_ps(s + i + 4));
+        _mm_storeu_si128((__m128i*)(dst + i * 2), pixel_pack_half(lo, hi));
+    }
+    for ( ; i < count; i += 4)
+    {
+        __m128i h = pixel_float_to_half_sse2(_mm_loadu_ps(s + i));
+        _mm_storel_epi64((__m128i*)(dst + i * 2), pixel_pack_half(h, h));
+    }
+}
+
+/// @summary Run a conversion kernel over a whole number of pixel groups.
+/// @param cvt The conversion descriptor.
+/// @param src The source pixels.
+/// @param dst The destination pixels.
+/// @param count The number of pixels to convert. Must be a multiple of PIXEL_CONVERT_GROUP.
+internal_function void pixel_convert_groups(pixel_convert_t const *cvt, uint8_t const *src, uint8_t *dst, size_t count)
+{
+    switch (cvt->Kernel)
+    {
+        case PIXEL_CONVERT_KERNEL_SWAP_RB:
+            pixel_convert_rgba8(src, dst, count, true , 0x00000000);
+            break;
+        case PIXEL_CONVERT_KERNEL_SET_ALPHA:
+            pixel_convert_rgba8(src, dst, count, false, 0xFF000000);
+            break;
+        case PIXEL_CONVERT_KERNEL_SWAP_RB_ALPHA:
+            pixel_convert_rgba8(src, dst, count, true , 0xFF000000);
+            break;
+        case PIXEL_CONVERT_KERNEL_RGB32F_RGBA32F:
+            pixel_convert_rgb32f_rgba32f(src, dst, count);
+            break;
+        case PIXEL_CONVERT_KERNEL_RGB10A2_RGBA8:
+            pixel_convert_rgb10a2_rgba8(src, dst, count);
+            break;
+        case PIXEL_CONVERT_KERNEL_RGB10A2_RGBA16:
+            pixel_convert_rgb10a2_rgba16(src, dst, count);
+            break;
+        case PIXEL_CONVERT_KERNEL_RGB10A2_RGBA16F:
+            pixel_convert_rgb10a2_rgba16f(src, dst, count, cvt->UseF16C);
+            break;
+        case PIXEL_CONVERT_KERNEL_HALF_FLOAT:
+            pixel_convert_half_float(src, dst, count * cvt->Channels, cvt->UseF16C);
+            break;
+        case PIXEL_CONVERT_KERNEL_FLOAT_HALF:
+            pixel_convert_float_half(src, dst, count * cvt->Channels, cvt->UseF16C);
+            break;
+        case PIXEL_CONVERT_KERNEL_COLOR:
+            pixel_convert_color(cvt, src, dst, count);
+            break;
+        default:
+            break;
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Determine the pixel format produced when converting uncompressed source data to a requested format.
+/// The sRGB-ness of 8-bit formats follows the source data, so requesting either variant of RGBA8 or BGRA8 is sufficient.
+/// If color stages are requested, the sRGB-ness and channel type of the target are determined by the stages.
+/// @param src_format One of dxgi_format_e specifying the source pixel format.
+/// @param dst_format One of dxgi_format_e specifying the requested pixel format.
+/// @param flags A combination of image_encoder_flags_e. Only the IMAGE_ENCODER_FLAGS_COLOR_STAGES flags are used.
+/// @return The format of the converted data, or DXGI_FORMAT_UNKNOWN if the conversion is not supported.
+public_function uint32_t pixel_convert_target_format(uint32_t src_format, uint32_t dst_format, uint32_t flags=IMAGE_ENCODER_FLAGS_NONE)
+{
+    if (flags & IMAGE_ENCODER_FLAGS_COLOR_STAGES)
+    {   // the color kernel handles every conversion with a color stage.
+        return pixel_color_target_format(src_format, dst_format, flags & IMAGE_ENCODER_FLAGS_COLOR_STAGES);
+    }
+    switch (src_format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+            {
+                if (dst_format == DXGI_FORMAT_R8G8B8A8_UNORM || dst_format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+                    return DXGI_FORMAT_R8G8B8A8_UNORM;
+                if (dst_format == DXGI_FORMAT_B8G8R8A8_UNORM || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+                    return DXGI_FORMAT_B8G8R8A8_UNORM;
+            }
+            break;
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            {
+                if (dst_format == DXGI_FORMAT_R8G8B8A8_UNORM || dst_format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+                    return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+                if (dst_format == DXGI_FORMAT_B8G8R8A8_UNORM || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+                    return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+            }
+            break;
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+            {
+                if (dst_format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+                    return dst_format;
+            }
+            break;
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+            {
+                if (dst_format == DXGI_FORMAT_R8G8B8A8_UNORM     ||
+                    dst_format == DXGI_FORMAT_R16G16B16A16_UNORM ||
+                    dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+                    return dst_format;
+            }
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return (dst_format == DXGI_FORMAT_R32G32B32A32_FLOAT) ? dst_format : DXGI_FORMAT_UNKNOWN;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return (dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT) ? dst_format : DXGI_FORMAT_UNKNOWN;
+        case DXGI_FORMAT_R16G16_FLOAT:
+            return (dst_format == DXGI_FORMAT_R32G32_FLOAT)       ? dst_format : DXGI_FORMAT_UNKNOWN;
+        case DXGI_FORMAT_R32G32_FLOAT:
+            return (dst_format == DXGI_FORMAT_R16G16_FLOAT)       ? dst_format : DXGI_FORMAT_UNKNOWN;
+        case DXGI_FORMAT_R16_FLOAT:
+            return (dst_format == DXGI_FORMAT_R32_FLOAT)          ? dst_format : DXGI_FORMAT_UNKNOWN;
+        case DXGI_FORMAT_R32_FLOAT:
+            return (dst_format == DXGI_FORMAT_R16_FLOAT)          ? dst_format : DXGI_FORMAT_UNKNOWN;
+        default:
+            break;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+/// @summary Initialize a conversion descriptor and select the conversion kernel.
+/// @param cvt The conversion descriptor to initialize.
+/// @param src_format One of dxgi_format_e specifying the source pixel format.
+/// @param dst_format The target pixel format, as returned by pixel_convert_target_format().
+/// @param flags The flags passed to pixel_convert_target_format(). If any color stage is set, the color kernel is selected.
+/// @return true if the conversion is supported. A conversion between identical formats, without color stages, is a copy.
+public_function bool pixel_convert_setup(pixel_convert_t *cvt, uint32_t src_format, uint32_t dst_format, uint32_t flags=IMAGE_ENCODER_FLAGS_NONE)
+{
+    cvt->Kernel       = PIXEL_CONVERT_KERNEL_NONE;
+    cvt->SourceFormat = src_format;
+    cvt->TargetFormat = dst_format;
+    cvt->SourceSize   = dxgi_bits_per_pixel(src_format) / 8;
+    cvt->TargetSize   = dxgi_bits_per_pixel(dst_format) / 8;
+    cvt->Channels     = 1;
+    cvt->Options      = PIXEL_CONVERT_OPTION_NONE;
+    cvt->UseF16C      = false;
+    if (pixel_convert_target_format(src_format, dst_format, flags) != dst_format)
+    {   // the conversion is not supported.
+        return false;
+    }
+    if (flags & IMAGE_ENCODER_FLAGS_COLOR_STAGES)
+    {   // derive the color kernel options from the formats.
+        if (flags & IMAGE_ENCODER_FLAGS_PREMULTIPLY_ALPHA)
+            cvt->Options |= PIXEL_CONVERT_OPTION_PREMULTIPLY;
+        if (src_format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || src_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || src_format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+            cvt->Options |= PIXEL_CONVERT_OPTION_DECODE_SRGB;
+        if (dst_format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || dst_format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+            cvt->Options |= PIXEL_CONVERT_OPTION_ENCODE_SRGB;
+        if (src_format == DXGI_FORMAT_B8G8R8A8_UNORM || src_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || 
+            src_format == DXGI_FORMAT_B8G8R8X8_UNORM || src_format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+            cvt->Options |= PIXEL_CONVERT_OPTION_SWAP_SOURCE;
+        if (dst_format == DXGI_FORMAT_B8G8R8A8_UNORM || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || 
+            dst_format == DXGI_FORMAT_B8G8R8X8_UNORM || dst_format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+            cvt->Options |= PIXEL_CONVERT_OPTION_SWAP_TARGET;
+        if (src_format == DXGI_FORMAT_B8G8R8X8_UNORM || src_format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+            cvt->Options |= PIXEL_CONVERT_OPTION_OPAQUE;
+        cvt->Kernel  = PIXEL_CONVERT_KERNEL_COLOR;
+        cvt->UseF16C = pixel_cpu_has_f16c();
+        return true;
+    }
+    switch (src_format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            cvt->Kernel = PIXEL_CONVERT_KERNEL_SWAP_RB;
+            break;
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            {
+                bool bgra   =(dst_format == DXGI_FORMAT_B8G8R8A8_UNORM || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+                cvt->Kernel = bgra ? PIXEL_CONVERT_KERNEL_SET_ALPHA : PIXEL_CONVERT_KERNEL_SWAP_RB_ALPHA;
+            }
+            break;
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+            cvt->Kernel = PIXEL_CONVERT_KERNEL_RGB32F_RGBA32F;
+            break;
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+            {
+                if (dst_format == DXGI_FORMAT_R8G8B8A8_UNORM)
+                    cvt->Kernel = PIXEL_CONVERT_KERNEL_RGB10A2_RGBA8;
+                else if (dst_format == DXGI_FORMAT_R16G16B16A16_UNORM)
+                    cvt->Kernel = PIXEL_CONVERT_KERNEL_RGB10A2_RGBA16;
+                else
+                    cvt->Kernel = PIXEL_CONVERT_KERNEL_RGB10A2_RGBA16F;
+            }
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16_FLOAT:
+        case DXGI_FORMAT_R16_FLOAT:
+            cvt->Kernel   = PIXEL_CONVERT_KERNEL_HALF_FLOAT;
+            cvt->Channels = cvt->SourceSize / 2;
+            break;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32_FLOAT:
+        case DXGI_FORMAT_R32_FLOAT:
+            cvt->Kernel   = PIXEL_CONVERT_KERNEL_FLOAT_HALF;
+            cvt->Channels = cvt->SourceSize / 4;
+            break;
+        default:
+            return false;
+    }
+    if (src_format == dst_format)
+    {   // the sRGB-ness of the source was preserved, and no swizzle is needed.
+        cvt->Kernel = PIXEL_CONVERT_KERNEL_NONE;
+    }
+    if (cvt->Kernel == PIXEL_CONVERT_KERNEL_HALF_FLOAT      ||
+        cvt->Kernel == PIXEL_CONVERT_KERNEL_FLOAT_HALF      ||
+        cvt->Kernel == PIXEL_CONVERT_KERNEL_RGB10A2_RGBA16F)
+    {   // check for F16C once, rather than on every call.
+        cvt->UseF16C = pixel_cpu_has_f16c();
+    }
+    return true;
+}
+
+/// @summary Convert a run of pixels. The source and destination must not overlap.
+/// @param cvt The conversion descriptor, initialized by pixel_convert_setup().
+/// @param src The source pixels.
+/// @param dst The destination pixels.
+/// @param count The number of pixels to convert.
+public_function void pixel_convert(pixel_convert_t const *cvt, void const *src, void *dst, size_t count)
+{
+    uint8_t const *s = (uint8_t const*) src;
+    uint8_t       *d = (uint8_t      *) dst;
+    if (cvt->Kernel == PIXEL_CONVERT_KERNEL_NONE)
+    {   // the formats are identical.
+        memcpy(d, s, count * cvt->SourceSize);
+        return;
+    }
+    size_t bulk = count & ~size_t(PIXEL_CONVERT_GROUP - 1);
+    size_t tail = count -  bulk;
+    if (bulk > 0)
+    {
+        pixel_convert_groups(cvt, s, d, bulk);
+    }
+    if (tail > 0)
+    {   // the kernels only process whole groups; convert the remainder through a temporary group.
+        uint8_t tmp_src[PIXEL_CONVERT_GROUP * PIXEL_CONVERT_MAX_SIZE] = {0};
+        uint8_t tmp_dst[PIXEL_CONVERT_GROUP * PIXEL_CONVERT_MAX_SIZE];
+        memcpy(tmp_src, s + bulk * cvt->SourceSize, tail * cvt->SourceSize);
+        pixel_convert_groups(cvt, tmp_src, tmp_dst, PIXEL_CONVERT_GROUP);
+        memcpy(d + bulk * cvt->TargetSize, tmp_dst, tail * cvt->TargetSize);
+    }
+}
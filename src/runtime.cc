@@ -19,6 +19,10 @@
     #define ETW_C_API
 #endif
 
+#ifndef NUMA_NO_PREFERRED_NODE
+    #define NUMA_NO_PREFERRED_NODE             ((DWORD) -1)
+#endif
+
 #ifdef __GNUC__
 #ifndef QUOTA_LIMITS_HARDWS_MIN_ENABLE
     #define QUOTA_LIMITS_HARDWS_MIN_ENABLE     0x00000001
@@ -216,6 +220,13 @@ typedef BOOL     (WINAPI    *SetFileInformationByHandleFn)(HANDLE, FILE_INFO_BY_
 typedef BOOL     (WINAPI    *GetQueuedCompletionStatusExFn)(HANDLE, LPOVERLAPPED_ENTRY, ULONG, PULONG, DWORD, BOOL);
 typedef BOOL     (WINAPI    *SetFileCompletionNotificationModesFn)(HANDLE, UCHAR);
 typedef DWORD    (WINAPI    *GetFinalPathNameByHandleFn)(HANDLE, LPWSTR, DWORD, DWORD);
+typedef LPVOID   (WINAPI    *VirtualAllocExNumaFn)(HANDLE, LPVOID, SIZE_T, DWORD, DWORD, DWORD);
+typedef DWORD    (WINAPI    *GetCurrentProcessorNumberFn)(void);
+typedef void     (WINAPI    *GetCurrentProcessorNumberExFn)(PPROCESSOR_NUMBER);
+typedef BOOL     (WINAPI    *GetNumaProcessorNodeExFn)(PPROCESSOR_NUMBER, PUSHORT);
+typedef BOOL     (WINAPI    *GetNumaNodeProcessorMaskExFn)(USHORT, PGROUP_AFFINITY);
+typedef BOOL     (WINAPI    *GetThreadGroupAffinityFn)(HANDLE, PGROUP_AFFINITY);
+typedef BOOL     (WINAPI    *SetThreadGroupAffinityFn)(HANDLE, GROUP_AFFINITY const*, PGROUP_AFFINITY);
 
 /// @summary Function pointer typedefs for the functions exported from etwprovider.dll.
 /// The DLL may export more or fewer functions, but these are the ones we look for.
@@ -278,6 +289,16 @@ global_variable SetFileInformationByHandleFn         SetFileInformationByHandle_
 global_variable GetQueuedCompletionStatusExFn        GetQueuedCompletionStatusEx_Func        = NULL;
 global_variable SetFileCompletionNotificationModesFn SetFileCompletionNotificationModes_Func = NULL;
 
+/// @summary Global function pointers for the optional NUMA functions dynamically loaded from kernel32.dll.
+/// These may be NULL, in which case memory placement falls back to the default first-touch policy.
+global_variable VirtualAllocExNumaFn                 VirtualAllocExNuma_Func                 = NULL;
+global_variable GetCurrentProcessorNumberFn          GetCurrentProcessorNumber_Func          = NULL;
+global_variable GetCurrentProcessorNumberExFn        GetCurrentProcessorNumberEx_Func        = NULL;
+global_variable GetNumaProcessorNodeExFn             GetNumaProcessorNodeEx_Func             = NULL;
+global_variable GetNumaNodeProcessorMaskExFn         GetNumaNodeProcessorMaskEx_Func         = NULL;
+global_variable GetThreadGroupAffinityFn             GetThreadGroupAffinity_Func             = NULL;
+global_variable SetThreadGroupAffinityFn             SetThreadGroupAffinity_Func             = NULL;
+
 /// @summary Global function pointers for the custom ETW functions dynamically loaded from etwprovider.dll.
 /// Any functions that cannot be loaded will be set to no-op stub implementations in win32_runtime_init().
 global_variable ETWRegisterCustomProvidersFn         ETWRegisterCustomProviders_Func         = NULL;
@@ -423,6 +444,142 @@ internal_function void ETW_C_API ETWKeyDown_Stub(DWORD character, char const *na
     UNREFERENCED_PARAMETER(flags);
 }
 
+/// @summary Retrieve the number of NUMA nodes in the system. Non-NUMA systems report a single node.
+/// @return The number of NUMA nodes in the system, always at least one.
+public_function size_t win32_numa_node_count(void)
+{
+    ULONG highest_node = 0;
+    if (!GetNumaHighestNodeNumber(&highest_node))
+    {   // assume a single node (a non-NUMA system).
+        return 1;
+    }
+    return size_t(highest_node) + 1;
+}
+
+/// @summary Retrieve the NUMA node of the processor the calling thread is currently running on.
+/// @return The zero-based NUMA node number, or NUMA_NO_PREFERRED_NODE if the node cannot be determined.
+public_function uint32_t win32_numa_current_node(void)
+{
+    UCHAR node = 0;
+    if (GetCurrentProcessorNumberEx_Func != NULL && GetNumaProcessorNodeEx_Func != NULL)
+    {   // Windows 7+; the processor may be in any processor group.
+        PROCESSOR_NUMBER proc;
+        USHORT           node_ex = 0;
+        GetCurrentProcessorNumberEx_Func(&proc);
+        if (!GetNumaProcessorNodeEx_Func(&proc, &node_ex))
+        {   // the processor number is not valid.
+            return NUMA_NO_PREFERRED_NODE;
+        }
+        return uint32_t(node_ex);
+    }
+    if (GetCurrentProcessorNumber_Func == NULL)
+    {   // Vista+ only; we can't determine the current processor.
+        return NUMA_NO_PREFERRED_NODE;
+    }
+    if (!GetNumaProcessorNode(UCHAR(GetCurrentProcessorNumber_Func()), &node))
+    {   // the processor number is not valid.
+        return NUMA_NO_PREFERRED_NODE;
+    }
+    return uint32_t(node);
+}
+
+/// @summary Restrict a thread to run only on the processors belonging to a given NUMA node. On systems with 
+/// more than 64 logical processors, the node may be in any processor group, and the thread is moved into that 
+/// group. Prior to Windows 7, only the processors in group 0 are considered.
+/// @param thread The handle of the thread to bind, for example GetCurrentThread().
+/// @param node The zero-based NUMA node number.
+/// @param old_affinity If non-NULL, on return stores the group affinity of the thread prior to the call, which can be restored with win32_restore_thread_affinity().
+/// @return true if the thread affinity was updated.
+public_function bool win32_numa_bind_thread(HANDLE thread, uint32_t node, GROUP_AFFINITY *old_affinity=NULL)
+{
+    GROUP_AFFINITY node_affinity;
+    GROUP_AFFINITY prev_affinity;
+    GROUP_AFFINITY curr_affinity;
+    DWORD_PTR      proc_mask = 0;
+    DWORD_PTR       sys_mask = 0;
+    ZeroMemory(&node_affinity, sizeof(GROUP_AFFINITY));
+    ZeroMemory(&prev_affinity, sizeof(GROUP_AFFINITY));
+    if (node == NUMA_NO_PREFERRED_NODE || node > 0xFFFF)
+    {   // there's no node to bind to.
+        return false;
+    }
+    if (GetNumaNodeProcessorMaskEx_Func != NULL && GetThreadGroupAffinity_Func != NULL && SetThreadGroupAffinity_Func != NULL)
+    {   // Windows 7+; the node may be in any processor group.
+        if (!GetNumaNodeProcessorMaskEx_Func(USHORT(node), &node_affinity))
+        {   // the node number is not valid.
+            return false;
+        }
+        // the process affinity mask is only reported when all threads are in a single group, 
+        // and it applies to that group only. it's non-zero if the process is restricted.
+        if (GetProcessAffinityMask(GetCurrentProcess(), &proc_mask, &sys_mask) && proc_mask != 0 && 
+            GetThreadGroupAffinity_Func(thread, &curr_affinity) && curr_affinity.Group == node_affinity.Group)
+        {
+            node_affinity.Mask &= KAFFINITY(proc_mask);
+        }
+        if (node_affinity.Mask == 0)
+        {   // the process isn't allowed to run on any processor in the node.
+            return false;
+        }
+        if (!SetThreadGroupAffinity_Func(thread, &node_affinity, &prev_affinity))
+        {   // the thread affinity could not be changed.
+            return false;
+        }
+    }
+    else
+    {   // prior to Windows 7, there's only processor group 0.
+        ULONGLONG node_mask = 0;
+        if (node > 0xFF || !GetNumaNodeProcessorMask(UCHAR(node), &node_mask))
+        {   // the node number is not valid.
+            return false;
+        }
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &proc_mask, &sys_mask))
+        {   // unable to retrieve the set of processors the process may run on.
+            return false;
+        }
+        DWORD_PTR thread_mask = DWORD_PTR(node_mask) & proc_mask;
+        if (thread_mask == 0)
+        {   // the process isn't allowed to run on any processor in the node.
+            return false;
+        }
+        if ((prev_affinity.Mask = KAFFINITY(SetThreadAffinityMask(thread, thread_mask))) == 0)
+        {   // the thread affinity could not be changed.
+            return false;
+        }
+    }
+    if (old_affinity != NULL) *old_affinity = prev_affinity;
+    return true;
+}
+
+/// @summary Restore the affinity of a thread saved by win32_numa_bind_thread().
+/// @param thread The handle of the thread to restore, for example GetCurrentThread().
+/// @param affinity The group affinity returned by win32_numa_bind_thread().
+/// @return true if the thread affinity was restored.
+public_function bool win32_restore_thread_affinity(HANDLE thread, GROUP_AFFINITY const &affinity)
+{
+    if (SetThreadGroupAffinity_Func != NULL)
+    {   // Windows 7+; this may move the thread back to its original group.
+        return SetThreadGroupAffinity_Func(thread, &affinity, NULL) != FALSE;
+    }
+    else return SetThreadAffinityMask(thread, DWORD_PTR(affinity.Mask)) != 0;
+}
+
+/// @summary Reserve and/or commit a range of virtual address space, preferring physical pages from a given NUMA node.
+/// If the NUMA APIs are not available, or no node is specified, this is equivalent to VirtualAlloc().
+/// @param address The starting address of the region, or NULL to let the system choose.
+/// @param size The size of the region, in bytes.
+/// @param alloc_type A combination of MEM_RESERVE, MEM_COMMIT, etc.
+/// @param protect The page protection flags, for example PAGE_READWRITE.
+/// @param node The preferred NUMA node, or NUMA_NO_PREFERRED_NODE.
+/// @return The base address of the allocated region, or NULL.
+public_function void* win32_numa_virtual_alloc(void *address, size_t size, DWORD alloc_type, DWORD protect, uint32_t node)
+{
+    if (node != NUMA_NO_PREFERRED_NODE && VirtualAllocExNuma_Func != NULL)
+    {   // physical pages are taken from the preferred node when they're first touched.
+        return VirtualAllocExNuma_Func(GetCurrentProcess(), address, size, alloc_type, protect, DWORD(node));
+    }
+    else return VirtualAlloc(address, size, alloc_type, protect);
+}
+
 /// @summary Indicates that a named, timed scope is being entered. Typically,
 /// this function is not called directly by user code; instead, it is easier
 /// and safer to use the trace_scope_main_t class.
@@ -623,6 +780,14 @@ public_function bool win32_runtime_init(void)
         SetFileInformationByHandle_Func          = (SetFileInformationByHandleFn)         GetProcAddress(kernel, "SetFileInformationByHandle");
         GetQueuedCompletionStatusEx_Func         = (GetQueuedCompletionStatusExFn)        GetProcAddress(kernel, "GetQueuedCompletionStatusEx");
         SetFileCompletionNotificationModes_Func  = (SetFileCompletionNotificationModesFn) GetProcAddress(kernel, "SetFileCompletionNotificationModes");
+        // the NUMA APIs are optional; they're used only for placement hints.
+        VirtualAllocExNuma_Func                  = (VirtualAllocExNumaFn)                 GetProcAddress(kernel, "VirtualAllocExNuma");
+        GetCurrentProcessorNumber_Func           = (GetCurrentProcessorNumberFn)          GetProcAddress(kernel, "GetCurrentProcessorNumber");
+        GetCurrentProcessorNumberEx_Func         = (GetCurrentProcessorNumberExFn)        GetProcAddress(kernel, "GetCurrentProcessorNumberEx");
+        GetNumaProcessorNodeEx_Func              = (GetNumaProcessorNodeExFn)             GetProcAddress(kernel, "GetNumaProcessorNodeEx");
+        GetNumaNodeProcessorMaskEx_Func          = (GetNumaNodeProcessorMaskExFn)         GetProcAddress(kernel, "GetNumaNodeProcessorMaskEx");
+        GetThreadGroupAffinity_Func              = (GetThreadGroupAffinityFn)             GetProcAddress(kernel, "GetThreadGroupAffinity");
+        SetThreadGroupAffinity_Func              = (SetThreadGroupAffinityFn)             GetProcAddress(kernel, "SetThreadGroupAffinity");
     }
     // fail if any of these APIs are not available.
     if (GetNativeSystemInfo_Func                == NULL) return false;
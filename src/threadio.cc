@@ -73,6 +73,12 @@ struct thread_io_t
         vfs_file_t         *file
     );                                        /// Synchronously open a file for manual I/O.
 
+    DWORD                   open_file_mapping
+    (
+        char const         *virtual_path, 
+        vfs_file_t         *file
+    );                                        /// Synchronously open a file for reading and read-only mapping.
+
     DWORD                   read_sync
     (
         vfs_file_t         *file, 
@@ -149,6 +155,19 @@ struct thread_io_t
         stream_control_t   *control
     );                                        /// Asynchronously stream a file into memory, then close it.
 
+    stream_decoder_t*       load_file_range
+    (
+        char const         *virtual_path, 
+        int                 file_hints, 
+        int                 decoder_hint, 
+        uintptr_t           stream_id, 
+        uint8_t             priority, 
+        int64_t             range_offset, 
+        int64_t             range_size, 
+        int64_t            &read_offset, 
+        stream_control_t   *control
+    );                                        /// Asynchronously stream a byte range of a file into memory, then close it.
+
     stream_decoder_t*       stream_file
     (
         char const         *virtual_path, 
@@ -298,6 +317,15 @@ DWORD thread_io_t::open_file(char const *virtual_path, uint32_t file_hints, int3
     return vfs_open_file(VFSDriver, virtual_path, file_hints, decoder_hint, file);
 }
 
+/// @summary Synchronously opens a file for synchronous reads and read-only mapping into the address space. No stream decoder is created.
+/// @param virtual_path A NULL-terminated UTF-8 string specifying the virtual file path.
+/// @param file On return, this structure is populated with file information. The file data begins at file->BaseOffset.
+/// @return ERROR_SUCCESS or a system error code.
+DWORD thread_io_t::open_file_mapping(char const *virtual_path, vfs_file_t *file)
+{
+    return vfs_open_file_mapping(VFSDriver, virtual_path, file);
+}
+
 /// @summary Synchronously reads data from a file.
 /// @param file The file to read from.
 /// @param offset The absolute byte offset at which to start reading data.
@@ -402,6 +430,22 @@ stream_decoder_t* thread_io_t::load_file(char const *virtual_path, int file_hint
     return vfs_load_file(VFSDriver, virtual_path, stream_id, priority, file_hints, decoder_hint, &PIOStreamInAlloc, &PIOControlAlloc, control);
 }
 
+/// @summary Asynchronously loads a byte range of a file by streaming it into memory as quickly as possible. Only the sectors covering the range are read.
+/// @param virtual_path A NULL-terminated UTF-8 string specifying the virtual file path.
+/// @param file_hints A combination of vfs_file_hint_e specifying the preferred file behavior, or VFS_FILE_HINT_NONT (0) to let the implementation decide. These hints may not be honored.
+/// @param decoder_hint One of vfs_decoder_hint_e specifying the preferred decoder type, or VFS_DECODER_HINT_USE_DEFAULT (0) to let the implementation decide.
+/// @param stream_id An application-defined identifier for the stream.
+/// @param priority The priority value for the load, with higher numeric values representing higher priority.
+/// @param range_offset The byte offset of the first byte to load, relative to the start of the file.
+/// @param range_size The number of bytes to load. The range is clamped to the end of the file.
+/// @param read_offset On return, set to the file offset of the first byte delivered to the decoder. Due to alignment restrictions, this may be less than range_offset.
+/// @param control If non-NULL, on return, this structure is initialized with information necessary to control streaming of the file.
+/// @return The stream decoder that can be used to access the file data. When finished accessing the file data, call the stream_decoder_t::release() method to delete the stream decoder instance.
+stream_decoder_t* thread_io_t::load_file_range(char const *virtual_path, int file_hints, int decoder_hint, uintptr_t stream_id, uint8_t priority, int64_t range_offset, int64_t range_size, int64_t &read_offset, stream_control_t *control)
+{
+    return vfs_load_file_range(VFSDriver, virtual_path, stream_id, priority, file_hints, decoder_hint, range_offset, range_size, read_offset, &PIOStreamInAlloc, &PIOControlAlloc, control);
+}
+
 /// @summary Asynchronously loads a file by streaming it into memory in fixed-size chunks, delivered to the decoder at a given interval. 
 /// @param virtual_path A NULL-terminated UTF-8 string specifying the virtual file path.
 /// @param file_hints A combination of vfs_file_hint_e specifying the preferred file behavior, or VFS_FILE_HINT_NONT (0) to let the implementation decide. These hints may not be honored.
@@ -83,6 +83,7 @@ enum vfs_file_usage_e : int32_t
     VFS_USAGE_STREAM_IN_LOAD      = 1, /// The file will be streamed into memory and then closed (read-only).
     VFS_USAGE_STREAM_OUT          = 2, /// The file will be created or overwritten (write-only). 
     VFS_USAGE_MANUAL_IO           = 3, /// The file will be opened for manual I/O (read-write).
+    VFS_USAGE_MEMORY_MAP          = 4, /// The file will be opened for synchronous reads and mapping into the address space (read-only).
 };
 
 /// @summary Defines status bits that may be set on opened files. These flags are
@@ -256,6 +257,7 @@ struct vfs_file_t
     int64_t        BaseOffset;    /// The offset of the start of the file data, in bytes.
     int64_t        BaseSize;      /// The size of the file data, in bytes, as stored.
     int64_t        FileSize;      /// The runtime size of the file data, in bytes.
+    uint64_t       FileTime;      /// The last write time of the file data, as a UNIX timestamp, or 0 if unknown.
     uint32_t       FileHints;     /// A combination of vfs_file_hints_e.
     uint32_t       FileFlags;     /// A combination of vfs_file_flags_e.
     decoder_t     *Decoder;       /// The stream decoder to use, for usages that read data.
@@ -325,6 +327,7 @@ struct vfs_driver_t
     vfs_mounts_t   Mounts;        /// The set of active mount points.
     SRWLOCK        MountsLock;    /// The slim reader/writer lock protecting the list of mount points.
     iobuf_alloc_t  StreamBuffer;  /// The global buffer used for streaming files into memory.
+    SRWLOCK        StreamLock;    /// The slim reader/writer lock protecting StreamBuffer, which is returned to by parsers on several threads.
 };
 
 /*///////////////
@@ -802,6 +805,7 @@ internal_function DWORD vfs_open_fs(vfs_mount_t *m, char const *path, int32_t us
 {
     vfs_mount_fs_t *fs      =(vfs_mount_fs_t*)   m->State;
     LARGE_INTEGER   fsize   = {0};
+    FILETIME        mtime   = {0};
     WCHAR          *pathbuf = vfs_make_system_path_fs(fs, path);
     HANDLE          hFile   = INVALID_HANDLE_VALUE;
     DWORD           result  = ERROR_NOT_SUPPORTED;
@@ -810,6 +814,7 @@ internal_function DWORD vfs_open_fs(vfs_mount_t *m, char const *path, int32_t us
     DWORD           create  = 0;
     DWORD           flags   = 0;
     size_t          ssize   = 0;
+    uint64_t        ftime   = 0;
 
     // figure out access flags, share modes, etc. based on the intended usage.
     switch (usage)
@@ -841,6 +846,14 @@ internal_function DWORD vfs_open_fs(vfs_mount_t *m, char const *path, int32_t us
         if (file_hints & VFS_FILE_HINT_TRUNCATE)     create = CREATE_ALWAYS;
         break;
 
+    case VFS_USAGE_MEMORY_MAP:
+        access = GENERIC_READ;
+        share  = FILE_SHARE_READ;
+        create = OPEN_EXISTING;
+        flags  = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS;
+        // the data is accessed through the system cache, so unbuffered I/O isn't supported.
+        break;
+
     default:
         result = ERROR_NOT_SUPPORTED;
         goto error_cleanup;
@@ -861,6 +874,11 @@ internal_function DWORD vfs_open_fs(vfs_mount_t *m, char const *path, int32_t us
         result = GetLastError();
         goto error_cleanup;
     }
+    if (GetFileTime(hFile, NULL, NULL, &mtime))
+    {   // convert from 100ns intervals since 1601 to seconds since 1970.
+        uint64_t ft = (uint64_t(mtime.dwHighDateTime) << 32) | uint64_t(mtime.dwLowDateTime);
+        ftime = ft > 116444736000000000ULL ? (ft - 116444736000000000ULL) / 10000000ULL : 0;
+    }
 
     // clean up temporary buffers.
     free(pathbuf);
@@ -875,6 +893,7 @@ internal_function DWORD vfs_open_fs(vfs_mount_t *m, char const *path, int32_t us
     file->BaseOffset = 0;
     file->BaseSize   = fsize.QuadPart;
     file->FileSize   = fsize.QuadPart;
+    file->FileTime   = ftime;
     file->FileHints  = file_hints;
     file->FileFlags  = VFS_FILE_FLAG_EXPLICIT_CLOSE;
     file->Decoder    = vfs_create_decoder(usage, decoder_hint);
@@ -892,6 +911,7 @@ error_cleanup:
     file->BaseOffset  =  0;
     file->BaseSize    =  0;
     file->FileSize    =  0;
+    file->FileTime    =  0;
     file->FileHints   =  file_hints;
     file->FileFlags   =  VFS_FILE_FLAG_NONE;
     file->Decoder     =  NULL;
@@ -1043,6 +1063,7 @@ internal_function DWORD vfs_support_fs(vfs_mount_t *m, int32_t usage, int32_t de
     case VFS_USAGE_STREAM_IN_LOAD:
     case VFS_USAGE_STREAM_OUT:
     case VFS_USAGE_MANUAL_IO:
+    case VFS_USAGE_MEMORY_MAP:
         break;
     default:
         return ERROR_NOT_SUPPORTED;
@@ -1338,6 +1359,15 @@ internal_function DWORD vfs_open_tarball(vfs_mount_t *m, char const *path, int32
         if (file_hints & VFS_FILE_HINT_ASYNCHRONOUS) flags |= FILE_FLAG_OVERLAPPED;
         break;
 
+    case VFS_USAGE_MEMORY_MAP:
+        // the tarball handle is opened for overlapped I/O, which prevents synchronous reads.
+        dupfd  = false;
+        access = GENERIC_READ;
+        share  = FILE_SHARE_READ;
+        create = OPEN_EXISTING;
+        flags  = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS;
+        break;
+
     default:
         result = ERROR_NOT_SUPPORTED;
         goto error_cleanup;
@@ -1380,6 +1410,7 @@ internal_function DWORD vfs_open_tarball(vfs_mount_t *m, char const *path, int32
                 file->BaseOffset  = tar->EntryInfo[i].DataOffset;
                 file->BaseSize    = tar->EntryInfo[i].FileSize;
                 file->FileSize    = tar->EntryInfo[i].FileSize;
+                file->FileTime    = tar->EntryInfo[i].FileTime;
                 file->FileHints   = file_hints;
                 file->FileFlags   = VFS_FILE_FLAG_EXPLICIT_CLOSE;
                 file->Decoder     = vfs_create_decoder(usage, decoder_hint);
@@ -1399,6 +1430,7 @@ error_cleanup:
     file->BaseOffset  =  0;
     file->BaseSize    =  0;
     file->FileSize    =  0;
+    file->FileTime    =  0;
     file->FileHints   =  file_hints;
     file->FileFlags   =  VFS_FILE_FLAG_NONE;
     file->Decoder     =  NULL;
@@ -1432,6 +1464,7 @@ internal_function DWORD vfs_support_tarball(vfs_mount_t *m, int32_t usage, int32
     case VFS_USAGE_STREAM_IN:
     case VFS_USAGE_STREAM_IN_LOAD:
     case VFS_USAGE_MANUAL_IO:
+    case VFS_USAGE_MEMORY_MAP:
         break;
     default:
         return ERROR_NOT_SUPPORTED;
@@ -1762,8 +1795,10 @@ public_function DWORD vfs_driver_open(vfs_driver_t *driver, aio_driver_t *aio, p
     driver->AIO = aio;
     driver->PIO = pio;
     InitializeSRWLock(&driver->MountsLock);
+    InitializeSRWLock(&driver->StreamLock);
     vfs_mounts_create( driver->Mounts, 128);
-    driver->StreamBuffer.reserve(STREAM_BUFFER_SIZE, STREAM_IN_CHUNK_SIZE);
+    // the stream buffer is shared by parsers on every node, so it isn't placed on any one node.
+    driver->StreamBuffer.reserve(STREAM_BUFFER_SIZE, STREAM_IN_CHUNK_SIZE, NUMA_NO_PREFERRED_NODE);
     return ERROR_SUCCESS;
 }
 
@@ -1949,6 +1984,20 @@ public_function DWORD vfs_open_file(vfs_driver_t *driver, char const *path, uint
     return ERROR_SUCCESS;
 }
 
+/// @summary Open a file for synchronous reads and read-only mapping into the process address space. The file data starts at BaseOffset bytes from the start of the returned handle, which is the offset of the entry within the archive for archive-based mount points. Close the file using vfs_close_file().
+/// @param driver The virtual file system driver used to resolve the file path.
+/// @param path A NULL-terminated UTF-8 string specifying the virtual file path.
+/// @param file On return, this structure is populated with file information. No stream decoder is created.
+/// @return ERROR_SUCCESS or a system error code.
+public_function DWORD vfs_open_file_mapping(vfs_driver_t *driver, char const *path, vfs_file_t *file)
+{
+    char const  *relpath     = NULL;
+    int32_t      usage       = VFS_USAGE_MEMORY_MAP;
+    uint32_t     file_hints  = VFS_FILE_HINT_NONE;
+    int32_t      decoder     = VFS_DECODER_HINT_NONE;
+    return vfs_resolve_and_open_file(driver, path, usage, file_hints, decoder, file, &relpath);
+}
+
 /// @summary Synchronously reads data from a file.
 /// @param driver The virtual file system driver used to open the file.
 /// @param file The file state returned from vfs_open_file().
@@ -1984,6 +2033,7 @@ public_function DWORD vfs_read_file_sync(vfs_driver_t *driver, vfs_file_t *file,
         }
         if (ReadFile(file->Fildes, &bufferp[bytes_read], rsize, &nread, NULL))
         {   // the synchronous read completed successfully.
+            if (nread == 0) break; // end-of-file.
             bytes_read += nread;
         }
         else
@@ -2250,9 +2300,10 @@ public_function stream_decoder_t* vfs_get_file(vfs_driver_t *driver, char const
     // it will hold a single buffer with the entire file contents, plus
     // an extra four zero bytes at the end, in case the resulting 
     // encoded data is passed to a string processing function.
+    // the calling thread reads the data, so place it on that thread's node.
     size_t    file_size = (size_t) (file_info.BaseSize + sizeof(uint32_t));
     stream_decoder_t *d = file_info.Decoder;
-    if (!d->InternalAllocator.reserve(file_size, file_size))
+    if (!d->InternalAllocator.reserve(file_size, file_size, win32_numa_current_node()))
     {   // unable to allocate the necessary buffer space.
         vfs_close_file(&file_info);
         return NULL;
@@ -2313,18 +2364,21 @@ public_function stream_decoder_t* vfs_get_file(vfs_driver_t *driver, char const
     return d;
 }
 
-/// @summary Asynchronously loads a file by streaming it into memory as quickly as possible.
+/// @summary Asynchronously loads a byte range of a file by streaming it into memory as quickly as possible. Only the sectors covering the range are read; the stream ends after the last byte of the range.
 /// @param driver The virtual file system driver used to resolve the file path.
 /// @param path A NULL-terminated UTF-8 string specifying the virtual file path.
 /// @param id An application-defined identifier for the stream.
 /// @param priority The priority value for the load, with higher numeric values representing higher priority.
 /// @param user_hints A combination of vfs_file_hint_e specifying the preferred file behavior, or VFS_FILE_HINT_NONE (0) to let the implementation decide. These hints may not be honored.
 /// @param decoder_hint One of vfs_decoder_hint_e specifying the preferred decoder type, or VFS_DECODER_HINT_USE_DEFAULT (0) to let the implementation decide.
+/// @param range_offset The byte offset of the first byte to load, relative to the start of the file data as stored.
+/// @param range_size The number of bytes to load. The range is clamped to the end of the file data.
+/// @param read_offset On return, set to the file offset of the first byte delivered to the decoder. For unbuffered I/O, this is range_offset rounded down to a multiple of the disk sector size.
 /// @param thread_alloc_open The FIFO node allocator used to enqueue stream open commands to the PIO driver.
 /// @param thread_alloc_control The FIFO node allocator used to enqueue stream control commands to the PIO driver. May be NULL if control is NULL.
 /// @param control If non-NULL, on return, this structure is initialized with information necessary to control streaming of the file.
-/// @return The stream decoder that can be used to access the file data. When finished accessing the file data, call the stream_decoder_t::release() method to delete the stream decoder instance.
-public_function stream_decoder_t* vfs_load_file(vfs_driver_t *driver, char const *path, uintptr_t id, uint8_t priority, int32_t user_hints, int32_t decoder_hint, pio_sti_pending_alloc_t *thread_alloc_open, pio_sti_control_alloc_t *thread_alloc_control, stream_control_t *control)
+/// @return The stream decoder that can be used to access the file data, or NULL if the file could not be opened or the range starts past the end of the file data. When finished accessing the file data, call the stream_decoder_t::release() method to delete the stream decoder instance.
+public_function stream_decoder_t* vfs_load_file_range(vfs_driver_t *driver, char const *path, uintptr_t id, uint8_t priority, int32_t user_hints, int32_t decoder_hint, int64_t range_offset, int64_t range_size, int64_t &read_offset, pio_sti_pending_alloc_t *thread_alloc_open, pio_sti_control_alloc_t *thread_alloc_control, stream_control_t *control)
 {   // open the file and retrieve relevant information.
     vfs_file_t   file_info;
     char const  *relpath     = NULL;
@@ -2332,6 +2386,23 @@ public_function stream_decoder_t* vfs_load_file(vfs_driver_t *driver, char const
     uint32_t     file_hints  =(user_hints == VFS_FILE_HINT_NONE) ? VFS_FILE_HINT_UNBUFFERED | VFS_FILE_HINT_ASYNCHRONOUS : user_hints;
     DWORD        open_result = vfs_resolve_and_open_file(driver, path, usage, file_hints, decoder_hint, &file_info, &relpath);
     if (!SUCCESS(open_result)) return NULL;
+
+    // clamp the range to the file data, and align the start for unbuffered I/O.
+    int64_t      range_final = file_info.BaseSize;
+    if (range_offset < 0) range_offset = 0;
+    if (range_size >= 0 && range_size < file_info.BaseSize - range_offset)
+    {   // the range ends before the end of the file data.
+        range_final = range_offset + range_size;
+    }
+    if (range_offset >  range_final)
+    {   // the range starts past the end of the file data.
+        vfs_close_file(&file_info);
+        return NULL;
+    }
+    if ((file_info.OpenFlags & FILE_FLAG_NO_BUFFERING) != 0)
+    {   // reads can only start at even multiples of the disk sector size.
+        range_offset -= range_offset % int64_t(file_info.SectorSize);
+    }
     DWORD        asio_result = aio_driver_prepare(driver->AIO, file_info.Fildes);
     if (!SUCCESS(asio_result))
     {   // could not associate the file handle with the I/O completion port.
@@ -2341,6 +2412,7 @@ public_function stream_decoder_t* vfs_load_file(vfs_driver_t *driver, char const
 
     // the decoder allocates buffer space from the I/O system pool.
     file_info.Decoder->BufferAllocator = &driver->StreamBuffer;
+    file_info.Decoder->BufferLock      = &driver->StreamLock;
     
     // initialize the stream control structure for the caller.
     if (control != NULL)
@@ -2361,6 +2433,8 @@ public_function stream_decoder_t* vfs_load_file(vfs_driver_t *driver, char const
     iocmd.SectorSize   = file_info.SectorSize;
     iocmd.BaseOffset   = file_info.BaseOffset;
     iocmd.BaseSize     = file_info.BaseSize;
+    iocmd.RangeOffset  = range_offset;
+    iocmd.RangeFinal   = range_final;
     iocmd.IntervalNs   = 0;
     iocmd.StreamFlags  = PIO_STREAM_IN_FLAGS_LOAD;
     iocmd.BasePriority = priority;
@@ -2368,9 +2442,27 @@ public_function stream_decoder_t* vfs_load_file(vfs_driver_t *driver, char const
     
     // add a decoder reference for the caller:
     file_info.Decoder->addref(); // +1=2
+    read_offset = range_offset;
     return file_info.Decoder;
 }
 
+/// @summary Asynchronously loads a file by streaming it into memory as quickly as possible.
+/// @param driver The virtual file system driver used to resolve the file path.
+/// @param path A NULL-terminated UTF-8 string specifying the virtual file path.
+/// @param id An application-defined identifier for the stream.
+/// @param priority The priority value for the load, with higher numeric values representing higher priority.
+/// @param user_hints A combination of vfs_file_hint_e specifying the preferred file behavior, or VFS_FILE_HINT_NONE (0) to let the implementation decide. These hints may not be honored.
+/// @param decoder_hint One of vfs_decoder_hint_e specifying the preferred decoder type, or VFS_DECODER_HINT_USE_DEFAULT (0) to let the implementation decide.
+/// @param thread_alloc_open The FIFO node allocator used to enqueue stream open commands to the PIO driver.
+/// @param thread_alloc_control The FIFO node allocator used to enqueue stream control commands to the PIO driver. May be NULL if control is NULL.
+/// @param control If non-NULL, on return, this structure is initialized with information necessary to control streaming of the file.
+/// @return The stream decoder that can be used to access the file data. When finished accessing the file data, call the stream_decoder_t::release() method to delete the stream decoder instance.
+public_function stream_decoder_t* vfs_load_file(vfs_driver_t *driver, char const *path, uintptr_t id, uint8_t priority, int32_t user_hints, int32_t decoder_hint, pio_sti_pending_alloc_t *thread_alloc_open, pio_sti_control_alloc_t *thread_alloc_control, stream_control_t *control)
+{
+    int64_t read_offset = 0;
+    return vfs_load_file_range(driver, path, id, priority, user_hints, decoder_hint, 0, -1, read_offset, thread_alloc_open, thread_alloc_control, control);
+}
+
 /// @summary Asynchronously loads a file by streaming it into memory in fixed-size chunks, delivered to the decoder at a given interval. 
 /// @param driver The virtual file system driver used to resolve the file path.
 /// @param path A NULL-terminated UTF-8 string specifying the virtual file path.
@@ -2402,7 +2494,8 @@ public_function stream_decoder_t* vfs_stream_file(vfs_driver_t *driver, char con
     }
 
     // set up the buffer allocator. allocate a fixed number of chunk_size chunks.
-    if (!file_info.Decoder->InternalAllocator.reserve(chunk_size * chunk_count, chunk_size))
+    // the thread opening the stream consumes it, so place the chunks on that thread's node.
+    if (!file_info.Decoder->InternalAllocator.reserve(chunk_size * chunk_count, chunk_size, win32_numa_current_node()))
     {   // unable to reserve the requested amount of buffer space.
         vfs_close_file(&file_info);
         return NULL;
@@ -2433,6 +2526,8 @@ public_function stream_decoder_t* vfs_stream_file(vfs_driver_t *driver, char con
     iocmd.SectorSize   = file_info.SectorSize;
     iocmd.BaseOffset   = file_info.BaseOffset;
     iocmd.BaseSize     = file_info.BaseSize;
+    iocmd.RangeOffset  = 0;
+    iocmd.RangeFinal   = file_info.BaseSize;
     iocmd.IntervalNs   = interval_ns;
     iocmd.StreamFlags  = PIO_STREAM_IN_FLAGS_LOAD;
     iocmd.BasePriority = priority;
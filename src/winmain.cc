@@ -94,6 +94,10 @@
 #include "idtable.cc"
 #include "strtable.cc"
 #include "parseutl.cc"
+#include "lzcodec.cc"
+#include "inflate.cc"
+#include "zstd.cc"
+#include "workpool.cc"
 
 #include "filepath.cc"
 #include "iobuffer.cc"
@@ -104,10 +108,24 @@
 #include "threadio.cc"
 
 #include "imtypes.cc"
+#include "bccodec.cc"
+#include "pxconvert.cc"
+#include "yuvconvert.cc"
+#include "immipmap.cc"
+#include "imtier.cc"
+#include "imcommit.cc"
 #include "immemory.cc"
+#include "imscratch.cc"
 #include "imencode.cc"
 #include "imparser.cc"
 #include "imparser_dds.cc"
+#include "imparser_png.cc"
+#include "imparser_ktx.cc"
+#include "imparser_jpeg.cc"
+#include "imparser_tga.cc"
+#include "imparser_bmp.cc"
+#include "improbe.cc"
+#include "imindex.cc"
 #include "imloader.cc"
 #include "imcache.cc"
 
@@ -135,6 +153,9 @@
 /// @summary The scale used to convert from seconds into nanoseconds.
 static uint64_t const SEC_TO_NANOSEC = 1000000000ULL;
 
+/// @summary The virtual path of the block-offset index file loaded when none is specified on the command line.
+static char const * const IMAGE_INDEX_DEFAULT_PATH = "/images/images.sidx";
+
 /*///////////////////
 //   Local Types   //
 ///////////////////*/
@@ -147,6 +168,14 @@ struct io_thread_args_t
     vfs_driver_t      *VFSDriver;      /// The application virtual file system driver.
     image_memory_t    *ImageMemory;    /// The memory block into which image data will be loaded.
     image_cache_t     *ImageCache;     /// The image cache used to manage the image memory.
+    char const        *IndexPath;      /// The virtual path of the block-offset index file, or NULL to read the header of every file.
+};
+
+/// @summary Defines the options that can be specified on the application command line.
+struct app_options_t
+{
+    char               IndexPath[MAX_PATH]; /// The virtual path of the block-offset index file, or an empty string.
+    bool               BuildIndex;          /// true to write the block-offset index for the images directory, then exit.
 };
 
 /// @summary Defines the data associated with a window that needs to be passed to the WNDPROC.
@@ -304,9 +333,13 @@ internal_function unsigned __stdcall IoDriverThread(void *args)
     io_thread_args_t          *state  = (io_thread_args_t*) args;
     image_cache_error_queue_t  cache_error_queue;
     image_load_error_queue_t   load_error_queue;
+    image_load_error_alloc_t   load_error_alloc;
     image_loader_t             raw_loader_state;
     image_loader_config_t      raw_loader_config;
     thread_image_loader_t      raw_image_loader;
+    work_pool_t                parser_pool;
+    bool                       have_parser_pool;
+    image_index_t              image_index;
     thread_io_t                io;
 
     // save local references to values used in the main loop:
@@ -329,7 +362,12 @@ internal_function unsigned __stdcall IoDriverThread(void *args)
 
     // initialize interfaces used to access the imaging subsystem:
     mpsc_fifo_u_init(&load_error_queue);
+    fifo_allocator_init(&load_error_alloc);
     mpsc_fifo_u_init(&cache_error_queue);
+    have_parser_pool = work_pool_create(&parser_pool);
+    // the block-offset index is optional; if it's missing, headers are read from each file.
+    if (state->IndexPath != NULL) image_index_load(&image_index, &io, state->IndexPath);
+    else image_index_init(&image_index);
     raw_loader_config.VFSDriver       = VFSDriver;
     raw_loader_config.ImageMemory     = ImageMemory;
     raw_loader_config.DefinitionQueue =&ImageCache->DefinitionQueue;
@@ -338,6 +376,14 @@ internal_function unsigned __stdcall IoDriverThread(void *args)
     raw_loader_config.ImageCapacity   = 1;
     raw_loader_config.Compression     = IMAGE_COMPRESSION_NONE;
     raw_loader_config.Encoding        = IMAGE_ENCODING_RAW;
+    raw_loader_config.Residency       = IMAGE_RESIDENCY_COPY;
+    raw_loader_config.Format          = DXGI_FORMAT_UNKNOWN;
+    raw_loader_config.Quality         = IMAGE_ENCODER_QUALITY_NORMAL;
+    raw_loader_config.WorkPool        = NULL;
+    raw_loader_config.EncoderFlags    = IMAGE_ENCODER_FLAGS_NONE;
+    raw_loader_config.ParserPool      = have_parser_pool ? &parser_pool : NULL;
+    raw_loader_config.ParserCount     = 0;
+    raw_loader_config.Index           =&image_index;
     image_loader_create(&raw_loader_state, raw_loader_config);
     raw_image_loader.initialize(&raw_loader_state);
 
@@ -373,6 +419,8 @@ internal_function unsigned __stdcall IoDriverThread(void *args)
         {
             image_memory_evict_element(state->ImageMemory, ev.ImageId, ev.FrameIndex);
         }
+        // release any elements whose eviction waited on a pin from another thread.
+        image_memory_update(state->ImageMemory);
 
         // poll the image loaders. this will produce events in the image cache's 
         // definition and location queues, and possibly error events in our queue.
@@ -383,6 +431,8 @@ internal_function unsigned __stdcall IoDriverThread(void *args)
         while (mpsc_fifo_u_consume(&load_error_queue, le))
         {
             dbg_printf("Error loading %s.\n", le.FilePath);
+            // let the cache fail any waiting locks and release partially loaded frames.
+            image_cache_load_failed(ImageCache, le, &load_error_alloc);
         }
 
         // sleep for the remainder of the timeslice.
@@ -398,8 +448,11 @@ internal_function unsigned __stdcall IoDriverThread(void *args)
 
     // cleanup resources and terminate the thread.
     image_loader_delete(&raw_loader_state);
+    if (have_parser_pool) work_pool_delete(&parser_pool);
+    image_index_delete(&image_index);
     mpsc_fifo_u_delete(&cache_error_queue);
     mpsc_fifo_u_delete(&load_error_queue);
+    fifo_allocator_reinit(&load_error_alloc);
     return thread_terminate(0);
 }
 
@@ -411,6 +464,94 @@ internal_function HANDLE launch_io_thread(io_thread_args_t *args)
     return (HANDLE) _beginthreadex(NULL, 0, IoDriverThread, args, 0, NULL);
 }
 
+/// @summary Extract the next whitespace-delimited token from a command line. Tokens may be enclosed in double quotes.
+/// @param cursor The current position in the command line. On return, points to the character after the token.
+/// @param buf The buffer to which the NULL-terminated token is written. Tokens longer than the buffer are truncated.
+/// @param buf_size The size of the buffer, in bytes.
+/// @return true if a token was extracted, or false if the end of the command line was reached.
+internal_function bool next_token(char const *&cursor, char *buf, size_t buf_size)
+{
+    size_t len = 0;
+    while (*cursor == ' ' || *cursor == '\t') ++cursor;
+    if (*cursor == 0) return false;
+    if (*cursor == '"')
+    {   // the token extends to the closing quote.
+        for (++cursor; *cursor != 0 && *cursor != '"'; ++cursor)
+        {
+            if (len + 1 < buf_size) buf[len++] = *cursor;
+        }
+        if (*cursor == '"') ++cursor;
+    }
+    else
+    {   // the token extends to the next whitespace character.
+        for ( ; *cursor != 0 && *cursor != ' ' && *cursor != '\t'; ++cursor)
+        {
+            if (len + 1 < buf_size) buf[len++] = *cursor;
+        }
+    }
+    buf[len] = 0;
+    return true;
+}
+
+/// @summary Parse the application command line. The recognized options are:
+/// -index <path>  Load the block-offset index from the given virtual path instead of IMAGE_INDEX_DEFAULT_PATH.
+/// -noindex       Don't load a block-offset index; the header of every image file is read when it's loaded.
+/// -buildindex    Write the block-offset index for every DDS file in the images directory, then exit.
+/// @param cmdline The command line for the application, excluding the program name.
+/// @param opts On return, the options specified on the command line.
+internal_function void parse_command_line(char const *cmdline, app_options_t &opts)
+{
+    char        token[MAX_PATH];
+    char const *cursor = cmdline != NULL ? cmdline : "";
+    strcpy_s(opts.IndexPath, MAX_PATH, IMAGE_INDEX_DEFAULT_PATH);
+    opts.BuildIndex = false;
+    while (next_token(cursor, token, MAX_PATH))
+    {
+        if (_stricmp(token, "-index") == 0 && next_token(cursor, token, MAX_PATH))
+        {
+            strcpy_s(opts.IndexPath, MAX_PATH, token);
+        }
+        else if (_stricmp(token, "-noindex") == 0)
+        {
+            opts.IndexPath[0] = 0;
+        }
+        else if (_stricmp(token, "-buildindex") == 0)
+        {
+            opts.BuildIndex = true;
+        }
+        else dbg_printf("Ignoring unrecognized command line option %s.\n", token);
+    }
+}
+
+/// @summary Write the block-offset index for every DDS file in the images directory next to the executable.
+/// The directory is the one mounted at /images by io_setup(), so the indexed paths match those the loader receives.
+/// @param io The I/O system interface for the main thread.
+/// @param index_path The NULL-terminated UTF-8 virtual path of the index file to write.
+/// @return true if the index file was written.
+internal_function bool build_image_index(thread_io_t *io, char const *index_path)
+{
+    char   native_root[MAX_PATH];
+    char  *separator = NULL;
+    size_t num_files = 0;
+    DWORD  nchars    = GetModuleFileNameA(NULL, native_root, MAX_PATH);
+    if (nchars == 0 || nchars >= MAX_PATH || (separator = strrchr(native_root, '\\')) == NULL)
+    {   // unable to determine the directory containing the executable.
+        return false;
+    }
+    if (strcpy_s(separator + 1, MAX_PATH - size_t(separator + 1 - native_root), "images") != 0)
+    {   // the path of the images directory is too long.
+        return false;
+    }
+    DWORD error = image_index_build_tree(io, native_root, "/images", index_path, &num_files);
+    if (error != ERROR_SUCCESS)
+    {
+        dbg_printf("ERROR: Unable to write index %s (%u).\n", index_path, error);
+        return false;
+    }
+    dbg_printf("Indexed %Iu files in %s.\n", num_files, index_path);
+    return true;
+}
+
 /// @summary Perform any mount-point setup for the I/O system on the main thread.
 /// @param io The I/O system interface for the main thread.
 /// @return true if the I/O system setup completed successfully.
@@ -524,10 +665,11 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrev, LPSTR lpCmdLine, int
 #endif
 
     file_list_t      image_files;
+    app_options_t    options;
     int result = 0; // return zero if the message loop isn't entered.
     UNREFERENCED_PARAMETER(hPrev);
-    UNREFERENCED_PARAMETER(lpCmdLine);
     UNREFERENCED_PARAMETER(nCmdShow);
+    parse_command_line(lpCmdLine, options);
     if (!win32_runtime_init())
     {
         OutputDebugString(_T("ERROR: Unable to initialize Windows runtime support.\n"));
@@ -549,13 +691,29 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrev, LPSTR lpCmdLine, int
         OutputDebugString(_T("ERROR: Unable to initialize the I/O system.\n"));
         return 0;
     }
+    if (options.BuildIndex)
+    {   // write the block-offset index and exit without opening a window.
+        bool built = build_image_index(&io, options.IndexPath[0] != 0 ? options.IndexPath : IMAGE_INDEX_DEFAULT_PATH);
+        vfs_driver_close(&vfs);
+        pio_driver_close(&pio);
+        aio_driver_close(&aio);
+        return built ? 0 : 1;
+    }
 
     // initialize the imaging subsystem.
     image_memory_t       image_memory;
+    image_tier_t         image_tier;
+    image_committer_t    image_committer;
     image_cache_t        cache_state;
     image_cache_config_t cache_config;
     thread_image_cache_t image_cache;
     image_memory_create(&image_memory, 256);
+    image_tier_create(&image_tier, 64 * 1024 * 1024);
+    image_memory_attach_tier(&image_memory, &image_tier);
+    if (image_committer_create(&image_committer))
+    {   // pre-fault image pages on a helper thread; without it, the I/O thread takes the faults.
+        image_memory_attach_committer(&image_memory, &image_committer);
+    }
     cache_config.Behavior  = IMAGE_CACHE_BEHAVIOR_MANUAL;
     cache_config.CacheSize = 128 * 1024 * 1024;
     image_cache_create(&cache_state, 256, cache_config);
@@ -571,6 +729,7 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrev, LPSTR lpCmdLine, int
     io_args.VFSDriver   = &vfs;
     io_args.ImageMemory = &image_memory;
     io_args.ImageCache  = &cache_state;
+    io_args.IndexPath   = options.IndexPath[0] != 0 ? options.IndexPath : NULL;
     HANDLE  io_thread   = launch_io_thread(&io_args);
     if (io_thread == INVALID_HANDLE_VALUE)
     {
@@ -764,6 +923,8 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrev, LPSTR lpCmdLine, int
     delete_display_list(&display_list);
     image_cache_delete(&cache_state);
     image_memory_delete(&image_memory);
+    image_committer_delete(&image_committer);
+    image_tier_delete(&image_tier);
     vfs_driver_close(&vfs);
     pio_driver_close(&pio);
     aio_driver_close(&aio);
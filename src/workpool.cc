@@ -0,0 +1,293 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a simple worker pool that executes batches of work items.
+/// A batch is either run to completion by work_pool_run(), in which case the
+/// submitting thread participates and the call returns when every item has
+/// completed, or submitted asynchronously with work_pool_submit() and waited
+/// on later with work_pool_wait(). Batches are queued in submission order and
+/// items are claimed under a lock, so items should be coarse enough (a row of
+/// blocks, a band of scanlines) that the cost of claiming one is negligible.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The maximum number of worker threads in a pool.
+#define WORK_POOL_MAX_THREADS     64
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Defines the signature of a function executed for each item in a batch.
+/// @param context Opaque data supplied with the batch.
+/// @param index The zero-based index of the work item.
+typedef void (*work_pool_func_t)(void *context, size_t index);
+
+/// @summary Defines the state associated with a batch of work items. The batch
+/// is owned by the submitter, and must remain valid until the batch completes.
+struct work_pool_batch_t
+{
+    work_pool_func_t       Func;            /// The function to execute for each item in the batch.
+    void                  *Context;         /// Opaque data passed to Func.
+    size_t                 ItemCount;       /// The number of items in the batch.
+    size_t                 NextItem;        /// The index of the next unclaimed item. Protected by the pool QueueLock.
+    std::atomic<size_t>    Remaining;       /// The number of items that have not yet completed.
+    HANDLE                 Done;            /// A manual-reset event signaled when the last item completes.
+    work_pool_batch_t     *Next;            /// The next batch in the pool queue.
+};
+
+/// @summary Defines the state associated with a pool of worker threads.
+struct work_pool_t
+{
+    HANDLE                 Threads[WORK_POOL_MAX_THREADS]; /// The handles of the worker threads.
+    size_t                 ThreadCount;     /// The number of worker threads, not counting the submitting thread.
+    HANDLE                 Wakeup;          /// A semaphore released once per-worker when a batch is submitted.
+    HANDLE                 RunDone;         /// The completion event for batches executed with work_pool_run.
+    SRWLOCK                SubmitLock;      /// Serializes calls to work_pool_run, which share RunDone.
+    SRWLOCK                QueueLock;       /// Protects the batch queue and the NextItem field of queued batches.
+    work_pool_batch_t     *Head;            /// The oldest batch with unclaimed items.
+    work_pool_batch_t     *Tail;            /// The newest batch with unclaimed items.
+    std::atomic<bool>      Shutdown;        /// Set to true to terminate the worker threads.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Claim the next unclaimed item from the batch queue. A batch is removed from the queue when its last item is claimed.
+/// @param pool The worker pool.
+/// @param only The batch to claim from, or NULL to claim from the oldest queued batch.
+/// @param index On return, the zero-based index of the claimed item.
+/// @return The batch owning the claimed item, or NULL if no items are available.
+internal_function work_pool_batch_t* work_pool_claim(work_pool_t *pool, work_pool_batch_t *only, size_t *index)
+{
+    work_pool_batch_t *prev  = NULL;
+    work_pool_batch_t *batch = NULL;
+    AcquireSRWLockExclusive(&pool->QueueLock);
+    batch = pool->Head;
+    while (only != NULL && batch != NULL && batch != only)
+    {   // search for the specified batch; it may have been fully claimed already.
+        prev  = batch;
+        batch = batch->Next;
+    }
+    if (batch != NULL)
+    {
+        *index = batch->NextItem++;
+        if (batch->NextItem == batch->ItemCount)
+        {   // unlink the batch; no thread may access it through the queue after this point.
+            if (prev != NULL) prev->Next = batch->Next;
+            else pool->Head = batch->Next;
+            if (pool->Tail == batch) pool->Tail = prev;
+        }
+    }
+    ReleaseSRWLockExclusive(&pool->QueueLock);
+    return batch;
+}
+
+/// @summary Execute a claimed item and signal the batch if it was the last item to complete.
+/// @param batch The batch owning the item. The batch may be freed by its owner once this function returns.
+/// @param index The zero-based index of the item.
+internal_function void work_pool_execute(work_pool_batch_t *batch, size_t index)
+{
+    batch->Func(batch->Context, index);
+    HANDLE done  = batch->Done;
+    if (batch->Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {   // this was the last item; the owner may now reuse the batch.
+        SetEvent(done);
+    }
+}
+
+/// @summary Implements the main loop of a worker thread.
+/// @param args The work_pool_t instance.
+/// @return Zero if the thread has terminated normally.
+internal_function unsigned __stdcall work_pool_thread(void *args)
+{
+    work_pool_t *pool = (work_pool_t*) args;
+    for ( ; ; )
+    {
+        if (WaitForSingleObject(pool->Wakeup, INFINITE) != WAIT_OBJECT_0)
+            break;
+        if (pool->Shutdown.load(std::memory_order_acquire))
+            break;
+        size_t             index = 0;
+        work_pool_batch_t *batch = NULL;
+        while ((batch = work_pool_claim(pool, NULL, &index)) != NULL)
+        {
+            work_pool_execute(batch, index);
+        }
+    }
+    return 0;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize a worker pool and launch its threads.
+/// @param pool The worker pool to initialize.
+/// @param thread_count The number of worker threads to launch, or zero to launch one fewer than the number of logical processors.
+/// @return true if the pool was initialized. The pool may have fewer threads than requested.
+public_function bool work_pool_create(work_pool_t *pool, size_t thread_count=0)
+{
+    if (thread_count == 0)
+    {   // the submitting thread also executes work items.
+        SYSTEM_INFO sysinfo = {};
+        GetNativeSystemInfo(&sysinfo);
+        thread_count = (sysinfo.dwNumberOfProcessors > 1) ? size_t(sysinfo.dwNumberOfProcessors - 1) : 0;
+    }
+    if (thread_count > WORK_POOL_MAX_THREADS)
+    {   // clamp to the maximum supported thread count.
+        thread_count = WORK_POOL_MAX_THREADS;
+    }
+    pool->ThreadCount = 0;
+    pool->Wakeup      = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+    pool->RunDone     = CreateEvent(NULL, TRUE, FALSE, NULL);
+    pool->Head        = NULL;
+    pool->Tail        = NULL;
+    pool->Shutdown.store(false, std::memory_order_relaxed);
+    InitializeSRWLock(&pool->SubmitLock);
+    InitializeSRWLock(&pool->QueueLock);
+    if (pool->Wakeup == NULL || pool->RunDone == NULL)
+    {   // unable to create the synchronization objects.
+        if (pool->RunDone != NULL) CloseHandle(pool->RunDone);
+        if (pool->Wakeup  != NULL) CloseHandle(pool->Wakeup);
+        pool->RunDone = NULL;
+        pool->Wakeup  = NULL;
+        return false;
+    }
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        HANDLE thread = (HANDLE) _beginthreadex(NULL, 0, work_pool_thread, pool, 0, NULL);
+        if (thread == NULL)
+            break;
+        pool->Threads[pool->ThreadCount++] = thread;
+    }
+    return true;
+}
+
+/// @summary Stop all worker threads and free the resources associated with a worker pool.
+/// @param pool The worker pool to delete. No batch may be executing or pending.
+public_function void work_pool_delete(work_pool_t *pool)
+{
+    if (pool->ThreadCount > 0)
+    {   // wake every worker; each sees the shutdown flag and exits.
+        pool->Shutdown.store(true, std::memory_order_release);
+        ReleaseSemaphore(pool->Wakeup, LONG(pool->ThreadCount), NULL);
+        WaitForMultipleObjects(DWORD(pool->ThreadCount), pool->Threads, TRUE, INFINITE);
+        for (size_t i = 0; i < pool->ThreadCount; ++i)
+        {
+            CloseHandle(pool->Threads[i]);
+        }
+    }
+    if (pool->RunDone != NULL) CloseHandle(pool->RunDone);
+    if (pool->Wakeup  != NULL) CloseHandle(pool->Wakeup);
+    pool->ThreadCount = 0;
+    pool->RunDone     = NULL;
+    pool->Wakeup      = NULL;
+}
+
+/// @summary Initialize a batch for use with work_pool_submit.
+/// @param batch The batch to initialize.
+/// @return true if the batch completion event was created.
+public_function bool work_pool_batch_create(work_pool_batch_t *batch)
+{
+    batch->Func      = NULL;
+    batch->Context   = NULL;
+    batch->ItemCount = 0;
+    batch->NextItem  = 0;
+    batch->Next      = NULL;
+    batch->Done      = CreateEvent(NULL, TRUE, TRUE, NULL);
+    batch->Remaining.store(0, std::memory_order_relaxed);
+    return (batch->Done != NULL);
+}
+
+/// @summary Free the resources associated with a batch. The batch must not be pending.
+/// @param batch The batch to delete.
+public_function void work_pool_batch_delete(work_pool_batch_t *batch)
+{
+    if (batch->Done != NULL) CloseHandle(batch->Done);
+    batch->Done = NULL;
+}
+
+/// @summary Submit a batch of work items to execute on the pool, and return without waiting for them to complete.
+/// If the pool has no worker threads, every item is executed on the calling thread before the function returns.
+/// @param pool The worker pool, or NULL to execute every item on the calling thread.
+/// @param batch The batch, initialized with work_pool_batch_create. The batch must not already be pending.
+/// @param func The function to execute for each item.
+/// @param context Opaque data passed to func. Must remain valid until the batch completes.
+/// @param count The number of items in the batch.
+public_function void work_pool_submit(work_pool_t *pool, work_pool_batch_t *batch, work_pool_func_t func, void *context, size_t count)
+{
+    batch->Func      = func;
+    batch->Context   = context;
+    batch->ItemCount = count;
+    batch->NextItem  = 0;
+    batch->Next      = NULL;
+    batch->Remaining.store(count, std::memory_order_relaxed);
+    if (pool == NULL || pool->ThreadCount == 0 || count == 0)
+    {   // there are no workers to hand the items to; execute everything here.
+        for (size_t i = 0; i < count; ++i)
+        {
+            func(context, i);
+        }
+        batch->Remaining.store(0, std::memory_order_relaxed);
+        SetEvent(batch->Done);
+        return;
+    }
+    ResetEvent(batch->Done);
+    AcquireSRWLockExclusive(&pool->QueueLock);
+    if (pool->Tail != NULL) pool->Tail->Next = batch;
+    else pool->Head = batch;
+    pool->Tail = batch;
+    ReleaseSRWLockExclusive(&pool->QueueLock);
+    ReleaseSemaphore(pool->Wakeup, LONG(count < pool->ThreadCount ? count : pool->ThreadCount), NULL);
+}
+
+/// @summary Wait for a submitted batch to complete. The calling thread executes any items of the batch that haven't been claimed by a worker.
+/// @param pool The worker pool to which the batch was submitted, or NULL.
+/// @param batch The batch to wait on.
+public_function void work_pool_wait(work_pool_t *pool, work_pool_batch_t *batch)
+{
+    if (pool != NULL && pool->ThreadCount > 0)
+    {
+        size_t             index = 0;
+        work_pool_batch_t *found = NULL;
+        while ((found = work_pool_claim(pool, batch, &index)) != NULL)
+        {
+            work_pool_execute(found, index);
+        }
+    }
+    WaitForSingleObject(batch->Done, INFINITE);
+}
+
+/// @summary Execute a batch of work items on the pool and the calling thread, and wait for all of them to complete.
+/// @param pool The worker pool, or NULL to execute every item on the calling thread.
+/// @param func The function to execute for each item.
+/// @param context Opaque data passed to func.
+/// @param count The number of items in the batch.
+public_function void work_pool_run(work_pool_t *pool, work_pool_func_t func, void *context, size_t count)
+{
+    if (pool == NULL || pool->ThreadCount == 0 || count <= 1)
+    {   // not worth waking the workers; execute everything here.
+        for (size_t i = 0; i < count; ++i)
+        {
+            func(context, i);
+        }
+        return;
+    }
+    work_pool_batch_t batch;
+    AcquireSRWLockExclusive(&pool->SubmitLock);
+    batch.Done = pool->RunDone;
+    work_pool_submit(pool, &batch, func, context, count);
+    work_pool_wait  (pool, &batch);
+    ReleaseSRWLockExclusive(&pool->SubmitLock);
+}
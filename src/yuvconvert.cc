@@ -0,0 +1,632 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements the conversion of YUV video formats (AYUV, YUY2, NV12
+/// and P010) to RGBA8, BGRA8 or RGBA16F using the BT.601, BT.709 or BT.2020
+/// matrix, in studio or full range. Each row is first unpacked to 16-bit Y, U,
+/// V and A samples, upsampling subsampled chroma by replication or with a
+/// linear filter that assumes MPEG-2 chroma siting: co-sited horizontally and,
+/// for 4:2:0 formats, centered vertically. The matrix kernel then converts the
+/// samples eight pixels at a time, using AVX2 when the processor and operating
+/// system support it, or SSE2. A level is converted in bands of rows on a
+/// worker pool; every band reads only the source level, so bands are independent.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <intrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The number of pixels processed by one iteration of the matrix kernel.
+#define YUV_CONVERT_GROUP         8
+
+/// @summary The number of pixels unpacked and converted at a time. Must be a multiple of YUV_CONVERT_GROUP * 2.
+#define YUV_CONVERT_SPAN          256
+
+/// @summary The number of target rows converted by one work item.
+#define YUV_CONVERT_BAND_ROWS     8
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Describes a conversion from a YUV format to an RGB format, as initialized by yuv_convert_setup().
+/// Samples are scaled to 16 bits before conversion, so the offsets are specified in 16-bit code values.
+struct yuv_convert_t
+{
+    uint32_t                  SourceFormat;      /// One of dxgi_format_e specifying the source YUV format.
+    uint32_t                  TargetFormat;      /// One of dxgi_format_e specifying the target RGB format.
+    size_t                    TargetSize;        /// The size of one target pixel, in bytes.
+    bool                      SwapRB;            /// true if the target pixels are in BGRA order.
+    bool                      HalfFloat;         /// true if the target pixels are RGBA16F.
+    bool                      LinearChroma;      /// true if subsampled chroma is upsampled with a linear filter.
+    bool                      UseAVX2;           /// true if the AVX2 matrix kernel may be used.
+    bool                      UseF16C;           /// true if the F16C instructions may be used for half-float conversion.
+    float                     YOffset;           /// The luma code value corresponding to black.
+    float                     YScale;            /// The reciprocal of the luma code range.
+    float                     COffset;           /// The chroma code value corresponding to zero.
+    float                     CScale;            /// The reciprocal of the chroma code range.
+    float                     RV;                /// The contribution of V to red.
+    float                     GU;                /// The contribution of U to green, negated.
+    float                     GV;                /// The contribution of V to green, negated.
+    float                     BU;                /// The contribution of U to blue.
+};
+
+/// @summary Describes a level conversion executed on a worker pool. Each work item converts YUV_CONVERT_BAND_ROWS rows.
+struct yuv_convert_band_t
+{
+    yuv_convert_t const      *Convert;           /// The conversion descriptor.
+    uint8_t const            *Source;            /// The first row of the source slice.
+    size_t                    SourcePitch;       /// The number of bytes between source rows, in every plane.
+    size_t                    Width;             /// The width of the slice, in pixels.
+    size_t                    Height;            /// The height of the slice, in pixels.
+    uint8_t                  *Target;            /// The first target row.
+    size_t                    TargetPitch;       /// The number of bytes between target rows.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Determine whether the processor and operating system support the AVX2 and F16C instructions.
+/// @return true if the AVX2 matrix kernel may be used.
+internal_function bool yuv_cpu_has_avx2(void)
+{
+    int info[4] = {0};
+    if (!pixel_cpu_has_f16c())
+    {   // AVX, F16C and the YMM register state are required as well.
+        return false;
+    }
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+/// @summary Average two sets of eight 16-bit samples, giving the nearer row a weight of 3/4.
+/// @param a The samples from the nearer row.
+/// @param b The samples from the farther row.
+/// @return The blended samples.
+internal_function inline __m128i yuv_blend_rows(__m128i a, __m128i b)
+{
+    return _mm_avg_epu16(a, _mm_avg_epu16(a, b));
+}
+
+/// @summary Blend two 16-bit samples, giving the nearer row a weight of 3/4. The result matches yuv_blend_rows().
+/// @param a The sample from the nearer row.
+/// @param b The sample from the farther row.
+/// @return The blended sample.
+internal_function inline uint16_t yuv_blend_sample(uint32_t a, uint32_t b)
+{
+    return uint16_t((a + ((a + b + 1) >> 1) + 1) >> 1);
+}
+
+/// @summary Load a run of chroma samples from one or two chroma rows, scaled to 16 bits. When two rows are
+/// given, the samples are blended with yuv_blend_rows().
+/// @param format One of DXGI_FORMAT_NV12, DXGI_FORMAT_P010 or DXGI_FORMAT_YUY2.
+/// @param ca The nearer chroma row. For YUY2, this is the source row.
+/// @param cb The farther chroma row, or the same value as ca.
+/// @param k0 The zero-based index of the first chroma column to load.
+/// @param count The number of chroma columns to load.
+/// @param cu On return, the blue-difference samples.
+/// @param cv On return, the red-difference samples.
+internal_function void yuv_load_chroma(uint32_t format, uint8_t const *ca, uint8_t const *cb, size_t k0, size_t count, uint16_t *cu, uint16_t *cv)
+{
+    __m128i lo8 = _mm_set1_epi16(0x00FF);
+    size_t  k   = 0;
+    switch (format)
+    {
+        case DXGI_FORMAT_NV12:
+            {   // interleaved 8-bit U, V pairs.
+                uint8_t const *a = ca + k0 * 2;
+                uint8_t const *b = cb + k0 * 2;
+                for ( ; k + 8 <= count; k += 8)
+                {
+                    __m128i pa = _mm_loadu_si128((__m128i const*)(a + k * 2));
+                    __m128i ua = _mm_and_si128 (pa, lo8);
+                    __m128i va = _mm_srli_epi16(pa, 8);
+                    ua = _mm_or_si128(ua, _mm_slli_epi16(ua, 8));
+                    va = _mm_or_si128(va, _mm_slli_epi16(va, 8));
+                    if (a != b)
+                    {
+                        __m128i pb = _mm_loadu_si128((__m128i const*)(b + k * 2));
+                        __m128i ub = _mm_and_si128 (pb, lo8);
+                        __m128i vb = _mm_srli_epi16(pb, 8);
+                        ua = yuv_blend_rows(ua, _mm_or_si128(ub, _mm_slli_epi16(ub, 8)));
+                        va = yuv_blend_rows(va, _mm_or_si128(vb, _mm_slli_epi16(vb, 8)));
+                    }
+                    _mm_storeu_si128((__m128i*)(cu + k), ua);
+                    _mm_storeu_si128((__m128i*)(cv + k), va);
+                }
+                for ( ; k < count; ++k)
+                {
+                    cu[k] = uint16_t(a[k * 2 + 0] * 257U);
+                    cv[k] = uint16_t(a[k * 2 + 1] * 257U);
+                    if (a != b)
+                    {
+                        cu[k] = yuv_blend_sample(cu[k], b[k * 2 + 0] * 257U);
+                        cv[k] = yuv_blend_sample(cv[k], b[k * 2 + 1] * 257U);
+                    }
+                }
+            }
+            break;
+        case DXGI_FORMAT_P010:
+            {   // interleaved 16-bit U, V pairs. the 10-bit value is stored in the high bits; the low bits are ignored.
+                uint16_t const *a = ((uint16_t const*) ca) + k0 * 2;
+                uint16_t const *b = ((uint16_t const*) cb) + k0 * 2;
+                __m128i         m = _mm_set1_epi16(short(0xFFC0));
+                for ( ; k + 4 <= count; k += 4)
+                {   // gather U into the low half and V into the high half.
+                    __m128i pa = _mm_and_si128(_mm_loadu_si128((__m128i const*)(a + k * 2)), m);
+                    pa = _mm_shufflelo_epi16(pa, _MM_SHUFFLE(3, 1, 2, 0));
+                    pa = _mm_shufflehi_epi16(pa, _MM_SHUFFLE(3, 1, 2, 0));
+                    pa = _mm_shuffle_epi32  (pa, _MM_SHUFFLE(3, 1, 2, 0));
+                    if (a != b)
+                    {
+                        __m128i pb = _mm_and_si128(_mm_loadu_si128((__m128i const*)(b + k * 2)), m);
+                        pb = _mm_shufflelo_epi16(pb, _MM_SHUFFLE(3, 1, 2, 0));
+                        pb = _mm_shufflehi_epi16(pb, _MM_SHUFFLE(3, 1, 2, 0));
+                        pb = _mm_shuffle_epi32  (pb, _MM_SHUFFLE(3, 1, 2, 0));
+                        pa = yuv_blend_rows(pa, pb);
+                    }
+                    _mm_storel_epi64((__m128i*)(cu + k), pa);
+                    _mm_storel_epi64((__m128i*)(cv + k), _mm_srli_si128(pa, 8));
+                }
+                for ( ; k < count; ++k)
+                {
+                    cu[k] = uint16_t(a[k * 2 + 0] & 0xFFC0U);
+                    cv[k] = uint16_t(a[k * 2 + 1] & 0xFFC0U);
+                    if (a != b)
+                    {
+                        cu[k] = yuv_blend_sample(cu[k], b[k * 2 + 0] & 0xFFC0U);
+                        cv[k] = yuv_blend_sample(cv[k], b[k * 2 + 1] & 0xFFC0U);
+                    }
+                }
+            }
+            break;
+        case DXGI_FORMAT_YUY2:
+            {   // Y0, U, Y1, V; 4:2:2 has no second chroma row.
+                uint8_t const *a = ca + k0 * 4;
+                for ( ; k + 4 <= count; k += 4)
+                {   // after discarding luma, the chroma bytes are the odd bytes of the 16-bit lanes.
+                    __m128i c = _mm_srli_epi16(_mm_loadu_si128((__m128i const*)(a + k * 4)), 8);
+                    c = _mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 1, 2, 0));
+                    c = _mm_shufflehi_epi16(c, _MM_SHUFFLE(3, 1, 2, 0));
+                    c = _mm_shuffle_epi32  (c, _MM_SHUFFLE(3, 1, 2, 0));
+                    c = _mm_or_si128(c, _mm_slli_epi16(c, 8));
+                    _mm_storel_epi64((__m128i*)(cu + k), c);
+                    _mm_storel_epi64((__m128i*)(cv + k), _mm_srli_si128(c, 8));
+                }
+                for ( ; k < count; ++k)
+                {
+                    cu[k] = uint16_t(a[k * 4 + 1] * 257U);
+                    cv[k] = uint16_t(a[k * 4 + 3] * 257U);
+                }
+            }
+            break;
+        default:
+            for ( ; k < count; ++k)
+                cu[k] = cv[k] = 0x8000;
+            break;
+    }
+}
+
+/// @summary Upsample a run of chroma samples horizontally by a factor of two. Target sample 2k is source sample k; 
+/// target sample 2k+1 is either source sample k, or the average of source samples k and k+1.
+/// @param c The source samples. Sample count is the last one available; later samples are clamped to it.
+/// @param count The number of source samples available.
+/// @param dst The target samples.
+/// @param n The number of target samples to produce, at most count * 2.
+/// @param linear Specify true to interpolate the odd target samples.
+internal_function void yuv_upsample_chroma(uint16_t const *c, size_t count, uint16_t *dst, size_t n, bool linear)
+{
+    size_t i = 0;
+    for ( ; i + 16 <= n && (i >> 1) + 9 <= count; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((__m128i const*)(c + (i >> 1)));
+        __m128i b = linear ? _mm_avg_epu16(a, _mm_loadu_si128((__m128i const*)(c + (i >> 1) + 1))) : a;
+        _mm_storeu_si128((__m128i*)(dst + i + 0), _mm_unpacklo_epi16(a, b));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpackhi_epi16(a, b));
+    }
+    for ( ; i < n; ++i)
+    {
+        size_t k = i >> 1;
+        size_t j = image_min2<size_t>(k + 1, count - 1);
+        if ((i & 1) == 0 || !linear) dst[i] = c[k];
+        else dst[i] = uint16_t((c[k] + c[j] + 1U) >> 1);
+    }
+}
+
+/// @summary Unpack a span of one source row to 16-bit Y, U, V and A samples. Samples past the end of the span are set to zero, up to a multiple of YUV_CONVERT_GROUP.
+/// @param cvt The conversion descriptor.
+/// @param src The first row of the source slice.
+/// @param pitch The number of bytes between source rows.
+/// @param width The width of the slice, in pixels.
+/// @param height The height of the slice, in pixels.
+/// @param y The zero-based index of the row.
+/// @param x0 The zero-based index of the first pixel in the span. Must be even.
+/// @param n The number of pixels in the span, at most YUV_CONVERT_SPAN.
+/// @param Y On return, the luma samples.
+/// @param U On return, the blue-difference samples.
+/// @param V On return, the red-difference samples.
+/// @param A On return, the alpha samples. Only AYUV sources have alpha.
+internal_function void yuv_load_span(yuv_convert_t const *cvt, uint8_t const *src, size_t pitch, size_t width, size_t height, size_t y, size_t x0, size_t n, uint16_t *Y, uint16_t *U, uint16_t *V, uint16_t *A)
+{
+    uint8_t const *row = src + y * pitch;
+    size_t         end =(n + YUV_CONVERT_GROUP - 1) & ~size_t(YUV_CONVERT_GROUP - 1);
+    size_t         i   = 0;
+    for (i = n; i < end; ++i)
+    {   // the kernel processes whole groups.
+        Y[i] = U[i] = V[i] = A[i] = 0;
+    }
+    switch (cvt->SourceFormat)
+    {
+        case DXGI_FORMAT_AYUV:
+            {   // 4:4:4, stored as V, U, Y, A.
+                uint8_t const *p = row + x0 * 4;
+                for (i = 0; i < n; ++i)
+                {
+                    V[i] = uint16_t(p[i * 4 + 0] * 257U);
+                    U[i] = uint16_t(p[i * 4 + 1] * 257U);
+                    Y[i] = uint16_t(p[i * 4 + 2] * 257U);
+                    A[i] = uint16_t(p[i * 4 + 3] * 257U);
+                }
+            }
+            return;
+        case DXGI_FORMAT_YUY2:
+            {   // 4:2:2, stored as Y0, U, Y1, V.
+                uint8_t const *p = row + x0 * 2;
+                __m128i      lo8 = _mm_set1_epi16(0x00FF);
+                for (i = 0; i + 8 <= n; i += 8)
+                {
+                    __m128i l = _mm_and_si128(_mm_loadu_si128((__m128i const*)(p + i * 2)), lo8);
+                    _mm_storeu_si128((__m128i*)(Y + i), _mm_or_si128(l, _mm_slli_epi16(l, 8)));
+                }
+                for ( ; i < n; ++i)
+                    Y[i] = uint16_t(p[i * 2] * 257U);
+            }
+            break;
+        case DXGI_FORMAT_NV12:
+            {   // 4:2:0, with a plane of 8-bit luma.
+                uint8_t const *p = row + x0;
+                for (i = 0; i + 16 <= n; i += 16)
+                {   // unpacking a byte with itself multiplies by 257.
+                    __m128i b = _mm_loadu_si128((__m128i const*)(p + i));
+                    _mm_storeu_si128((__m128i*)(Y + i + 0), _mm_unpacklo_epi8(b, b));
+                    _mm_storeu_si128((__m128i*)(Y + i + 8), _mm_unpackhi_epi8(b, b));
+                }
+                for ( ; i < n; ++i)
+                    Y[i] = uint16_t(p[i] * 257U);
+            }
+            break;
+        case DXGI_FORMAT_P010:
+            {   // 4:2:0, with a plane of 16-bit luma.
+                uint16_t const *p = ((uint16_t const*) row) + x0;
+                for (i = 0; i < n; ++i)
+                    Y[i] = uint16_t(p[i] & 0xFFC0U);
+            }
+            break;
+        default:
+            return;
+    }
+
+    // gather the chroma samples covering the span, blending rows for 4:2:0.
+    uint16_t       cu[YUV_CONVERT_SPAN / 2 + 2];
+    uint16_t       cv[YUV_CONVERT_SPAN / 2 + 2];
+    uint8_t const *ca = row;
+    uint8_t const *cb = row;
+    size_t         cw =(width + 1) >> 1;
+    size_t         k0 = x0 >> 1;
+    size_t         k1 = image_min2<size_t>(cw, ((x0 + n - 1) >> 1) + 2);
+    if (dxgi_planar(cvt->SourceFormat))
+    {   // chroma sample j is centered between luma rows 2j and 2j+1.
+        size_t         ch    =(height + 1) >> 1;
+        size_t         cy    = y >> 1;
+        uint8_t const *plane = src + pitch * height;
+        ca = plane + cy * pitch;
+        cb = ca;
+        if (cvt->LinearChroma)
+        {
+            size_t cn = (y & 1) ? image_min2<size_t>(cy + 1, ch - 1) : (cy > 0 ? cy - 1 : 0);
+            cb = plane + cn * pitch;
+        }
+    }
+    yuv_load_chroma(cvt->SourceFormat, ca, cb, k0, k1 - k0, cu, cv);
+    yuv_upsample_chroma(cu, k1 - k0, U, n, cvt->LinearChroma);
+    yuv_upsample_chroma(cv, k1 - k0, V, n, cvt->LinearChroma);
+}
+
+/// @summary Convert groups of 16-bit YUV samples to RGB using SSE2, four pixels at a time.
+/// @param cvt The conversion descriptor.
+/// @param Y The luma samples.
+/// @param U The blue-difference samples.
+/// @param V The red-difference samples.
+/// @param A The alpha samples, or NULL if alpha is 1.0.
+/// @param dst The destination pixels.
+/// @param count The number of pixels to convert. Must be a multiple of YUV_CONVERT_GROUP.
+internal_function void yuv_convert_kernel_sse2(yuv_convert_t const *cvt, uint16_t const *Y, uint16_t const *U, uint16_t const *V, uint16_t const *A, uint8_t *dst, size_t count)
+{
+    __m128i z    = _mm_setzero_si128();
+    __m128  yoff = _mm_set1_ps(cvt->YOffset);
+    __m128  ysc  = _mm_set1_ps(cvt->YScale);
+    __m128  coff = _mm_set1_ps(cvt->COffset);
+    __m128  csc  = _mm_set1_ps(cvt->CScale);
+    __m128  rv   = _mm_set1_ps(cvt->RV);
+    __m128  gu   = _mm_set1_ps(cvt->GU);
+    __m128  gv   = _mm_set1_ps(cvt->GV);
+    __m128  bu   = _mm_set1_ps(cvt->BU);
+    __m128  one  = _mm_set1_ps(1.0f);
+    __m128  s255 = _mm_set1_ps(255.0f);
+    bool    half = cvt->HalfFloat;
+    bool    f16c = cvt->UseF16C;
+    bool    swap = cvt->SwapRB;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128 yf = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(Y + i)), z)), yoff), ysc);
+        __m128 uf = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(U + i)), z)), coff), csc);
+        __m128 vf = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(V + i)), z)), coff), csc);
+        __m128 r  = _mm_add_ps(yf, _mm_mul_ps(rv, vf));
+        __m128 g  = _mm_sub_ps(yf, _mm_add_ps(_mm_mul_ps(gu, uf), _mm_mul_ps(gv, vf)));
+        __m128 b  = _mm_add_ps(yf, _mm_mul_ps(bu, uf));
+        __m128 a  = one;
+        if (A != NULL)
+        {
+            a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)(A + i)), z)), _mm_set1_ps(1.0f / 65535.0f));
+        }
+        r = _mm_min_ps(_mm_max_ps(r, _mm_setzero_ps()), one);
+        g = _mm_min_ps(_mm_max_ps(g, _mm_setzero_ps()), one);
+        b = _mm_min_ps(_mm_max_ps(b, _mm_setzero_ps()), one);
+        if (half)
+        {   // transpose from one register per-channel to one register per-pixel.
+            _MM_TRANSPOSE4_PS(r, g, b, a);
+            if (f16c)
+            {
+                _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), _mm_unpacklo_epi64(_mm_cvtps_ph(r, 0), _mm_cvtps_ph(g, 0)));
+                _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), _mm_unpacklo_epi64(_mm_cvtps_ph(b, 0), _mm_cvtps_ph(a, 0)));
+            }
+            else
+            {
+                _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), pixel_pack_half(pixel_float_to_half_sse2(r), pixel_float_to_half_sse2(g)));
+                _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), pixel_pack_half(pixel_float_to_half_sse2(b), pixel_float_to_half_sse2(a)));
+            }
+        }
+        else
+        {
+            __m128i ri = _mm_cvtps_epi32(_mm_mul_ps(swap ? b : r, s255));
+            __m128i gi = _mm_cvtps_epi32(_mm_mul_ps(g, s255));
+            __m128i bi = _mm_cvtps_epi32(_mm_mul_ps(swap ? r : b, s255));
+            __m128i ai = _mm_cvtps_epi32(_mm_mul_ps(a, s255));
+            __m128i p  = _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)), _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_slli_epi32(ai, 24)));
+            _mm_storeu_si128((__m128i*)(dst + i * 4), p);
+        }
+    }
+}
+
+/// @summary Convert groups of 16-bit YUV samples to RGB using AVX2 and F16C, eight pixels at a time.
+/// @param cvt The conversion descriptor.
+/// @param Y The luma samples.
+/// @param U The blue-difference samples.
+/// @param V The red-difference samples.
+/// @param A The alpha samples, or NULL if alpha is 1.0.
+/// @param dst The destination pixels.
+/// @param count The number of pixels to convert. Must be a multiple of YUV_CONVERT_GROUP.
+internal_function void yuv_convert_kernel_avx2(yuv_convert_t const *cvt, uint16_t const *Y, uint16_t const *U, uint16_t const *V, uint16_t const *A, uint8_t *dst, size_t count)
+{
+    __m256  yoff = _mm256_set1_ps(cvt->YOffset);
+    __m256  ysc  = _mm256_set1_ps(cvt->YScale);
+    __m256  coff = _mm256_set1_ps(cvt->COffset);
+    __m256  csc  = _mm256_set1_ps(cvt->CScale);
+    __m256  rv   = _mm256_set1_ps(cvt->RV);
+    __m256  gu   = _mm256_set1_ps(cvt->GU);
+    __m256  gv   = _mm256_set1_ps(cvt->GV);
+    __m256  bu   = _mm256_set1_ps(cvt->BU);
+    __m256  zero = _mm256_setzero_ps();
+    __m256  one  = _mm256_set1_ps(1.0f);
+    __m256  s255 = _mm256_set1_ps(255.0f);
+    bool    half = cvt->HalfFloat;
+    bool    swap = cvt->SwapRB;
+    for (size_t i = 0; i < count; i += 8)
+    {
+        __m256 yf = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)(Y + i)))), yoff), ysc);
+        __m256 uf = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)(U + i)))), coff), csc);
+        __m256 vf = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)(V + i)))), coff), csc);
+        __m256 r  = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(yf, _mm256_mul_ps(rv, vf)), zero), one);
+        __m256 g  = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(yf, _mm256_add_ps(_mm256_mul_ps(gu, uf), _mm256_mul_ps(gv, vf))), zero), one);
+        __m256 b  = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(yf, _mm256_mul_ps(bu, uf)), zero), one);
+        __m256 a  = one;
+        if (A != NULL)
+        {
+            a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)(A + i)))), _mm256_set1_ps(1.0f / 65535.0f));
+        }
+        if (half)
+        {   // interleave the channels of eight pixels.
+            __m128i rh  = _mm256_cvtps_ph(r, 0);
+            __m128i gh  = _mm256_cvtps_ph(g, 0);
+            __m128i bh  = _mm256_cvtps_ph(b, 0);
+            __m128i ah  = _mm256_cvtps_ph(a, 0);
+            __m128i rgl = _mm_unpacklo_epi16(rh, gh);
+            __m128i rgh = _mm_unpackhi_epi16(rh, gh);
+            __m128i bal = _mm_unpacklo_epi16(bh, ah);
+            __m128i bah = _mm_unpackhi_epi16(bh, ah);
+            _mm_storeu_si128((__m128i*)(dst + i * 8 +  0), _mm_unpacklo_epi32(rgl, bal));
+            _mm_storeu_si128((__m128i*)(dst + i * 8 + 16), _mm_unpackhi_epi32(rgl, bal));
+            _mm_storeu_si128((__m128i*)(dst + i * 8 + 32), _mm_unpacklo_epi32(rgh, bah));
+            _mm_storeu_si128((__m128i*)(dst + i * 8 + 48), _mm_unpackhi_epi32(rgh, bah));
+        }
+        else
+        {
+            __m256i ri = _mm256_cvtps_epi32(_mm256_mul_ps(swap ? b : r, s255));
+            __m256i gi = _mm256_cvtps_epi32(_mm256_mul_ps(g, s255));
+            __m256i bi = _mm256_cvtps_epi32(_mm256_mul_ps(swap ? r : b, s255));
+            __m256i ai = _mm256_cvtps_epi32(_mm256_mul_ps(a, s255));
+            __m256i p  = _mm256_or_si256(_mm256_or_si256(ri, _mm256_slli_epi32(gi, 8)), _mm256_or_si256(_mm256_slli_epi32(bi, 16), _mm256_slli_epi32(ai, 24)));
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), p);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+/// @summary Convert one source row to the target format.
+/// @param band The level being converted.
+/// @param y The zero-based index of the row.
+internal_function void yuv_convert_row(yuv_convert_band_t const *band, size_t y)
+{
+    uint16_t             Y[YUV_CONVERT_SPAN];
+    uint16_t             U[YUV_CONVERT_SPAN];
+    uint16_t             V[YUV_CONVERT_SPAN];
+    uint16_t             A[YUV_CONVERT_SPAN];
+    yuv_convert_t const *cvt   = band->Convert;
+    uint16_t const      *alpha =(cvt->SourceFormat == DXGI_FORMAT_AYUV) ? A : NULL;
+    uint8_t             *row   = band->Target + y * band->TargetPitch;
+    for (size_t x0 = 0; x0 < band->Width; x0 += YUV_CONVERT_SPAN)
+    {
+        size_t   n    = image_min2<size_t>(YUV_CONVERT_SPAN, band->Width - x0);
+        size_t   bulk = n & ~size_t(YUV_CONVERT_GROUP - 1);
+        size_t   tail = n -  bulk;
+        uint8_t *d    = row + x0 * cvt->TargetSize;
+        yuv_load_span(cvt, band->Source, band->SourcePitch, band->Width, band->Height, y, x0, n, Y, U, V, A);
+        if (bulk > 0)
+        {
+            if (cvt->UseAVX2) yuv_convert_kernel_avx2(cvt, Y, U, V, alpha, d, bulk);
+            else              yuv_convert_kernel_sse2(cvt, Y, U, V, alpha, d, bulk);
+        }
+        if (tail > 0)
+        {   // the kernels only process whole groups; convert the remainder through a temporary group.
+            uint8_t tmp[YUV_CONVERT_GROUP * 8];
+            if (cvt->UseAVX2) yuv_convert_kernel_avx2(cvt, Y + bulk, U + bulk, V + bulk, alpha ? A + bulk : NULL, tmp, YUV_CONVERT_GROUP);
+            else              yuv_convert_kernel_sse2(cvt, Y + bulk, U + bulk, V + bulk, alpha ? A + bulk : NULL, tmp, YUV_CONVERT_GROUP);
+            memcpy(d + bulk * cvt->TargetSize, tmp, tail * cvt->TargetSize);
+        }
+    }
+}
+
+/// @summary Converts one band of rows. Called on a worker pool thread.
+/// @param context The yuv_convert_band_t describing the level.
+/// @param index The zero-based index of the band.
+internal_function void yuv_convert_band(void *context, size_t index)
+{
+    yuv_convert_band_t *band  = (yuv_convert_band_t*) context;
+    size_t              first =  index * YUV_CONVERT_BAND_ROWS;
+    size_t              last  =  image_min2<size_t>(first + YUV_CONVERT_BAND_ROWS, band->Height);
+    for (size_t y = first; y < last; ++y)
+    {
+        yuv_convert_row(band, y);
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Determine the format produced when converting YUV data to a requested RGB format.
+/// @param src_format One of dxgi_format_e specifying the source pixel format.
+/// @param dst_format One of dxgi_format_e specifying the requested target format.
+/// @return The target format, or DXGI_FORMAT_UNKNOWN if the source is not a supported YUV format or the target is not supported.
+public_function uint32_t yuv_convert_target_format(uint32_t src_format, uint32_t dst_format)
+{
+    if (!dxgi_yuv(src_format))
+        return DXGI_FORMAT_UNKNOWN;
+
+    switch (dst_format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return dst_format;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+/// @summary Initialize a conversion descriptor. The matrix, range and chroma filter are selected by the encoder flags.
+/// @param cvt The conversion descriptor to initialize.
+/// @param src_format One of dxgi_format_e specifying the source YUV format.
+/// @param dst_format One of dxgi_format_e specifying the target format, as returned by yuv_convert_target_format().
+/// @param flags A combination of the IMAGE_ENCODER_FLAGS_YUV_BT709, IMAGE_ENCODER_FLAGS_YUV_BT2020, IMAGE_ENCODER_FLAGS_YUV_FULL_RANGE and IMAGE_ENCODER_FLAGS_CHROMA_LINEAR flags.
+/// @return true if the conversion is supported.
+public_function bool yuv_convert_setup(yuv_convert_t *cvt, uint32_t src_format, uint32_t dst_format, uint32_t flags)
+{
+    memset(cvt, 0, sizeof(yuv_convert_t));
+    if (yuv_convert_target_format(src_format, dst_format) == DXGI_FORMAT_UNKNOWN)
+        return false;
+
+    // the luma weights of red and blue define the matrix.
+    float kr = 0.299f, kb = 0.114f;
+    if (flags & IMAGE_ENCODER_FLAGS_YUV_BT709)
+    {
+        kr = 0.2126f; kb = 0.0722f;
+    }
+    if (flags & IMAGE_ENCODER_FLAGS_YUV_BT2020)
+    {
+        kr = 0.2627f; kb = 0.0593f;
+    }
+    float kg = 1.0f - kr - kb;
+    cvt->RV  = 2.0f * (1.0f - kr);
+    cvt->BU  = 2.0f * (1.0f - kb);
+    cvt->GU  = 2.0f * kb * (1.0f - kb) / kg;
+    cvt->GV  = 2.0f * kr * (1.0f - kr) / kg;
+
+    // 8-bit samples are scaled by 257, and 10-bit samples are stored in the high bits.
+    bool  ten   =(src_format == DXGI_FORMAT_P010);
+    float unit  = ten ? 64.0f  : 257.0f;
+    float black = ten ? 64.0f  : 16.0f;
+    float zero  = ten ? 512.0f : 128.0f;
+    float top   = ten ? 1023.0f: 255.0f;
+    if (flags & IMAGE_ENCODER_FLAGS_YUV_FULL_RANGE)
+    {
+        cvt->YOffset = 0.0f;
+        cvt->YScale  = 1.0f / (top * unit);
+        cvt->COffset = zero * unit;
+        cvt->CScale  = 1.0f / (top * unit);
+    }
+    else
+    {   // studio range: luma in [16, 235] and chroma in [16, 240], scaled for 10-bit.
+        float scale  = ten ? 4.0f : 1.0f;
+        cvt->YOffset = black * unit;
+        cvt->YScale  = 1.0f / (219.0f * scale * unit);
+        cvt->COffset = zero  * unit;
+        cvt->CScale  = 1.0f / (224.0f * scale * unit);
+    }
+    cvt->SourceFormat = src_format;
+    cvt->TargetFormat = dst_format;
+    cvt->HalfFloat    =(dst_format == DXGI_FORMAT_R16G16B16A16_FLOAT);
+    cvt->SwapRB       =(dst_format == DXGI_FORMAT_B8G8R8A8_UNORM || dst_format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+    cvt->TargetSize   = cvt->HalfFloat ? 8 : 4;
+    cvt->LinearChroma =(flags & IMAGE_ENCODER_FLAGS_CHROMA_LINEAR) != 0;
+    cvt->UseF16C      = pixel_cpu_has_f16c();
+    cvt->UseAVX2      = yuv_cpu_has_avx2();
+    return true;
+}
+
+/// @summary Convert one slice of a YUV level. For planar formats, the chroma plane immediately follows the luma plane.
+/// @param cvt The conversion descriptor, initialized by yuv_convert_setup().
+/// @param pool The worker pool used to convert bands of rows in parallel, or NULL.
+/// @param src The first row of the source slice.
+/// @param src_pitch The number of bytes between source rows, in every plane.
+/// @param width The width of the slice, in pixels.
+/// @param height The height of the slice, in pixels.
+/// @param dst The first target row.
+/// @param dst_pitch The number of bytes between target rows.
+public_function void yuv_convert_slice(yuv_convert_t const *cvt, work_pool_t *pool, void const *src, size_t src_pitch, size_t width, size_t height, void *dst, size_t dst_pitch)
+{
+    yuv_convert_band_t band;
+    band.Convert     = cvt;
+    band.Source      =(uint8_t const*) src;
+    band.SourcePitch = src_pitch;
+    band.Width       = width;
+    band.Height      = height;
+    band.Target      =(uint8_t*) dst;
+    band.TargetPitch = dst_pitch;
+    work_pool_run(pool, yuv_convert_band, &band, (height + YUV_CONVERT_BAND_ROWS - 1) / YUV_CONVERT_BAND_ROWS);
+}
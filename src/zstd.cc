@@ -0,0 +1,1158 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a decoder for Zstandard (RFC 8878) frames that are held
+/// in memory in their entirety, such as the supercompressed mipmap levels of a
+/// KTX2 file, where both the compressed and the decompressed sizes are known
+/// up front. All output is written to a single caller-supplied buffer, which
+/// also serves as the match window. Literals are decoded with an 11-bit
+/// Huffman lookup table, reading the four literal streams together, and each
+/// sequence is executed as soon as it is decoded. Dictionaries aren't
+/// supported, and the optional XXH64 content checksum is skipped unverified.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <emmintrin.h>
+
+/*/////////////////
+//   Constants   //
+/////////////////*/
+/// @summary The magic number at the start of each Zstandard frame.
+#define ZSTD_MAGIC                0xFD2FB528U
+
+/// @summary The magic number of a skippable frame; the low four bits may have any value.
+#define ZSTD_SKIPPABLE_MAGIC      0x184D2A50U
+
+/// @summary The maximum number of bytes decompressed from a single block.
+#define ZSTD_BLOCK_SIZE_MAX       (128 * 1024)
+
+/// @summary The number of bytes after the literal buffer that 16-byte literal copies may read.
+#define ZSTD_LITERAL_PADDING      32
+
+/// @summary The maximum length of a literal Huffman code, in bits.
+#define ZSTD_HUFFMAN_MAX_BITS     11
+
+/// @summary The maximum accuracy log of any FSE table.
+#define ZSTD_FSE_MAX_LOG          9
+
+/// @summary The maximum accuracy log of the FSE table used to compress Huffman weights.
+#define ZSTD_WEIGHT_MAX_LOG       6
+
+/*///////////////////
+//   Local Types   //
+///////////////////*/
+/// @summary Define the block types found in a block header.
+enum zstd_block_type_e : uint32_t
+{
+    ZSTD_BLOCK_RAW              = 0,   /// The block is stored uncompressed.
+    ZSTD_BLOCK_RLE              = 1,   /// The block is a single byte, repeated.
+    ZSTD_BLOCK_COMPRESSED       = 2,   /// The block has a literals section and a sequences section.
+};
+
+/// @summary Define the encodings of the literals section.
+enum zstd_literals_type_e : uint32_t
+{
+    ZSTD_LITERALS_RAW           = 0,   /// The literals are stored uncompressed.
+    ZSTD_LITERALS_RLE           = 1,   /// The literals are a single byte, repeated.
+    ZSTD_LITERALS_COMPRESSED    = 2,   /// The literals are Huffman-coded, and a new table is given.
+    ZSTD_LITERALS_TREELESS      = 3,   /// The literals are Huffman-coded with the table of the previous block.
+};
+
+/// @summary Define the ways in which a sequence symbol table is specified.
+enum zstd_table_mode_e : uint32_t
+{
+    ZSTD_TABLE_PREDEFINED       = 0,   /// Use the predefined distribution.
+    ZSTD_TABLE_RLE              = 1,   /// Every sequence uses the same symbol.
+    ZSTD_TABLE_COMPRESSED       = 2,   /// The distribution is stored in the block.
+    ZSTD_TABLE_REPEAT           = 3,   /// Use the table of the previous block.
+};
+
+/// @summary Reads a bitstream backward, from its final byte toward its first byte.
+/// Once the stream is exhausted, zero bits are read and Consumed exceeds 64.
+struct zstd_bits_t
+{
+    uint8_t const            *Start;             /// The first byte of the stream.
+    uint8_t const            *Cursor;            /// The address of the eight bytes last loaded into Bits.
+    uint64_t                  Bits;              /// The unread bits, most-significant first.
+    size_t                    Consumed;          /// The number of bits consumed from the eight bytes at Cursor.
+};
+
+/// @summary Describes a single FSE decoding state.
+struct zstd_fse_entry_t
+{
+    uint32_t                  Value;             /// The decoded symbol or, for sequence codes, the base value of the length or offset.
+    uint16_t                  Base;              /// The base value of the next state.
+    uint8_t                   BitCount;          /// The number of bits added to Base to get the next state.
+    uint8_t                   Extra;             /// For sequence codes, the number of extra bits added to Value.
+};
+
+/// @summary Defines an FSE decoding table.
+struct zstd_fse_t
+{
+    zstd_fse_entry_t          Table[1 << ZSTD_FSE_MAX_LOG]; /// The decoding states.
+    uint32_t                  Log;               /// The accuracy log; the table has 1 << Log states.
+    bool                      Valid;             /// true if the table was defined by this frame.
+};
+
+/// @summary Defines the state of a Zstandard decoder, which persists across the blocks of a frame.
+struct zstd_decoder_t
+{
+    uint16_t                  Huffman[1 << ZSTD_HUFFMAN_MAX_BITS]; /// Maps the next HuffmanBits bits to (length << 8) | symbol.
+    uint32_t                  HuffmanBits;       /// The length of the longest literal code, or 0 if no table is defined.
+    zstd_fse_t                LitLen;            /// The literal length code table.
+    zstd_fse_t                Offset;            /// The offset code table.
+    zstd_fse_t                MatchLen;          /// The match length code table.
+    size_t                    Repeat[3];         /// The three most recent match offsets.
+    uint8_t                  *Literals;          /// The decoded literals of the current block, with ZSTD_LITERAL_PADDING bytes of padding.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The base value for each literal length code.
+global_variable uint32_t const ZSTD_LITLEN_BASE   [36] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536 };
+
+/// @summary The number of extra bits for each literal length code.
+global_variable uint8_t  const ZSTD_LITLEN_EXTRA  [36] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+/// @summary The base value for each match length code.
+global_variable uint32_t const ZSTD_MATCHLEN_BASE [53] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051, 4099, 8195, 16387, 32771, 65539 };
+
+/// @summary The number of extra bits for each match length code.
+global_variable uint8_t  const ZSTD_MATCHLEN_EXTRA[53] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+/// @summary The predefined distribution of literal length codes, with an accuracy log of 6.
+global_variable int16_t  const ZSTD_LITLEN_DEFAULT  [36] = { 4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1 };
+
+/// @summary The predefined distribution of match length codes, with an accuracy log of 6.
+global_variable int16_t  const ZSTD_MATCHLEN_DEFAULT[53] = { 1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1 };
+
+/// @summary The predefined distribution of offset codes, with an accuracy log of 5.
+global_variable int16_t  const ZSTD_OFFSET_DEFAULT  [29] = { 1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1 };
+
+/*///////////////////////
+//   Local Functions   //
+///////////////////////*/
+/// @summary Read a little-endian 16-bit value from an address that may not be aligned.
+/// @param p The address to read from.
+/// @return The value at the specified address.
+internal_function inline uint32_t zstd_read16(uint8_t const *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8);
+}
+
+/// @summary Read a little-endian 24-bit value from an address that may not be aligned.
+/// @param p The address to read from.
+/// @return The value at the specified address.
+internal_function inline uint32_t zstd_read24(uint8_t const *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+}
+
+/// @summary Read a little-endian 32-bit value from an address that may not be aligned.
+/// @param p The address to read from.
+/// @return The value at the specified address.
+internal_function inline uint32_t zstd_read32(uint8_t const *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/// @summary Read a little-endian 64-bit value from an address that may not be aligned.
+/// @param p The address to read from.
+/// @return The value at the specified address.
+internal_function inline uint64_t zstd_read64(uint8_t const *p)
+{
+    uint64_t v; memcpy(&v, p, sizeof(uint64_t));
+    return v;
+}
+
+/// @summary Find the index of the most significant set bit.
+/// @param v The value to examine. Must be non-zero.
+/// @return The zero-based index of the highest set bit.
+internal_function inline uint32_t zstd_highbit(uint32_t v)
+{
+    uint32_t n = 0;
+    while (v >>= 1) ++n;
+    return n;
+}
+
+/// @summary Read bits forward from a byte buffer, least-significant bit first. Bits past the end of the buffer read as zero.
+/// @param src The buffer to read from.
+/// @param size The size of the buffer, in bytes.
+/// @param pos The bit position to read from. On return, advanced by n.
+/// @param n The number of bits to read, in [0, 16].
+/// @return The bits read.
+internal_function uint32_t zstd_forward_bits(uint8_t const *src, size_t size, size_t &pos, uint32_t n)
+{
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < n; ++i, ++pos)
+    {
+        size_t byte = pos >> 3;
+        if (byte < size) v |= uint32_t((src[byte] >> (pos & 7)) & 1) << i;
+    }
+    return v;
+}
+
+/// @summary Prepare to read a backward bitstream, and skip the padding above its final set bit.
+/// @param br The bit reader to initialize.
+/// @param src The first byte of the stream.
+/// @param size The size of the stream, in bytes.
+/// @return true if the stream is valid, or false if it is empty or its final byte is zero.
+internal_function bool zstd_bits_init(zstd_bits_t *br, uint8_t const *src, size_t size)
+{
+    if (size == 0 || src[size - 1] == 0)
+    {   // the final byte must contain the end marker.
+        return false;
+    }
+    if (size >= 8)
+    {   // load the final eight bytes of the stream.
+        br->Start    = src;
+        br->Cursor   = src + size - 8;
+        br->Bits     = zstd_read64(br->Cursor);
+        br->Consumed = 0;
+    }
+    else
+    {   // the whole stream fits in the bit buffer, and is never reloaded.
+        // the missing bytes count as consumed.
+        uint64_t v = 0;
+        for (size_t i = 0; i < size; ++i)
+            v |= uint64_t(src[i]) << (i * 8);
+        br->Start    = src;
+        br->Cursor   = src;
+        br->Bits     = v << (64 - size * 8);
+        br->Consumed = 64 - size * 8;
+    }
+    size_t pad = 8 - zstd_highbit(src[size - 1]);
+    br->Bits   <<= pad;
+    br->Consumed+= pad;
+    return true;
+}
+
+/// @summary Refill the bit reader, so that at least 57 bits are available unless the start of the stream is reached.
+/// @param br The bit reader to refill.
+internal_function inline void zstd_bits_reload(zstd_bits_t *br)
+{
+    size_t bytes = br->Consumed >> 3;
+    size_t avail = size_t(br->Cursor - br->Start);
+    if (bytes <= avail)
+    {   // the common case; step back over the consumed bytes.
+        br->Cursor  -= bytes;
+        br->Consumed&= 7;
+        br->Bits     = zstd_read64(br->Cursor) << br->Consumed;
+    }
+    else if (avail > 0)
+    {   // load the first eight bytes of the stream.
+        br->Cursor   = br->Start;
+        br->Consumed-= avail * 8;
+        br->Bits     =(br->Consumed < 64) ? (zstd_read64(br->Cursor) << br->Consumed) : 0;
+    }
+    // else, all of the stream is in the bit buffer already.
+}
+
+/// @summary Read bits from a backward bitstream. The bits must have been made available by zstd_bits_reload().
+/// @param br The bit reader.
+/// @param n The number of bits to read, in [0, 57].
+/// @return The bits read, with the first bit read in the most-significant position.
+internal_function inline uint32_t zstd_bits_read(zstd_bits_t *br, uint32_t n)
+{
+    uint32_t v = uint32_t((br->Bits >> 1) >> (63 - n));
+    br->Bits   <<= n;
+    br->Consumed+= n;
+    return v;
+}
+
+/// @summary Determine whether more bits were read from a backward bitstream than it contains.
+/// @param br The bit reader.
+/// @return true if the reader has consumed bits past the start of the stream.
+internal_function inline bool zstd_bits_overflow(zstd_bits_t const *br)
+{
+    return br->Cursor == br->Start && br->Consumed > 64;
+}
+
+/// @summary Determine whether exactly all of the bits of a backward bitstream were read.
+/// @param br The bit reader.
+/// @return true if the stream was consumed exactly.
+internal_function inline bool zstd_bits_finished(zstd_bits_t const *br)
+{
+    return br->Cursor == br->Start && br->Consumed == 64;
+}
+
+/// @summary Build an FSE decoding table from a normalized distribution.
+/// @param fse The table to build.
+/// @param freq The normalized count of each symbol; -1 marks a symbol with a probability below one.
+/// @param count The number of symbols.
+/// @param log The accuracy log; the counts must sum to 1 << log.
+/// @return true if the table was built, or false if the distribution is invalid.
+internal_function bool zstd_fse_build(zstd_fse_t *fse, int16_t const *freq, uint32_t count, uint32_t log)
+{
+    uint16_t next[256];
+    uint32_t size = 1U << log;
+    uint32_t high = size;
+    uint32_t mask = size - 1;
+    uint32_t step =(size >> 1) + (size >> 3) + 3;
+    uint32_t pos  = 0;
+
+    // symbols with a probability below one take a single state each, at the top of the table.
+    for (uint32_t s = 0; s < count; ++s)
+    {
+        if (freq[s] == -1)
+        {
+            if (high == 0) return false;
+            fse->Table[--high].Value = s;
+            next[s] = 1;
+        }
+    }
+    // the remaining states are spread across the table.
+    for (uint32_t s = 0; s < count; ++s)
+    {
+        if (freq[s] <= 0) continue;
+        next[s] = uint16_t(freq[s]);
+        for (int32_t i = 0; i < freq[s]; ++i)
+        {
+            fse->Table[pos].Value = s;
+            do
+            {   // skip the positions taken by the low-probability symbols.
+                pos = (pos + step) & mask;
+            } while (pos >= high);
+        }
+    }
+    if (pos != 0)
+    {   // the counts don't fill the table exactly.
+        return false;
+    }
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        zstd_fse_entry_t &e = fse->Table[i];
+        uint32_t       n    = next[e.Value]++;
+        e.BitCount          = uint8_t(log - zstd_highbit(n));
+        e.Base              = uint16_t((n << e.BitCount) - size);
+        e.Extra             = 0;
+    }
+    fse->Log   = log;
+    fse->Valid = true;
+    return true;
+}
+
+/// @summary Read an FSE table description and build the decoding table.
+/// @param fse The table to build.
+/// @param src The table description.
+/// @param size The maximum number of bytes to read.
+/// @param max_log The largest accuracy log allowed.
+/// @param max_symbol The largest symbol allowed.
+/// @param used On return, the number of bytes in the table description.
+/// @return true if the table was read, or false if the description is invalid.
+internal_function bool zstd_fse_read(zstd_fse_t *fse, uint8_t const *src, size_t size, uint32_t max_log, uint32_t max_symbol, size_t &used)
+{
+    int16_t  freq[256];
+    size_t   pos       = 0;
+    uint32_t count     = 0;
+    uint32_t log       = zstd_forward_bits(src, size, pos, 4) + 5;
+    int32_t  remaining = 1 << log;
+    if (log > max_log)
+    {   // the table would be too large.
+        return false;
+    }
+    while (remaining > 0 && count <= max_symbol)
+    {   // values are stored in just enough bits for the remaining probability,
+        // and the smaller values use one bit less.
+        uint32_t bits      = zstd_highbit(uint32_t(remaining + 1)) + 1;
+        uint32_t value     = zstd_forward_bits(src, size, pos, bits);
+        uint32_t lower     =(1U << (bits - 1)) - 1;
+        uint32_t threshold =(1U << bits) - 1 - uint32_t(remaining + 1);
+        if ((value & lower) < threshold)
+        {
+            value &= lower;
+            pos   -= 1;
+        }
+        else if (value > lower)
+        {
+            value -= threshold;
+        }
+        int32_t proba  = int32_t(value) - 1;
+        remaining     -= proba < 0 ? -proba : proba;
+        freq[count++]  = int16_t(proba);
+        if (proba == 0)
+        {   // a zero probability is followed by 2-bit counts of additional zeros.
+            uint32_t repeat = zstd_forward_bits(src, size, pos, 2);
+            for ( ; ; )
+            {
+                for (uint32_t i = 0; i < repeat && count <= max_symbol; ++i)
+                    freq[count++] = 0;
+                if (repeat != 3) break;
+                repeat = zstd_forward_bits(src, size, pos, 2);
+            }
+        }
+    }
+    used = (pos + 7) >> 3;
+    if (remaining != 0 || used > size)
+    {   // the distribution doesn't sum to 1 << log, or the description is truncated.
+        return false;
+    }
+    return zstd_fse_build(fse, freq, count, log);
+}
+
+/// @summary Set up an FSE decoding table in which every state decodes the same symbol without reading any bits.
+/// @param fse The table to build.
+/// @param symbol The symbol to decode.
+internal_function void zstd_fse_rle(zstd_fse_t *fse, uint8_t symbol)
+{
+    fse->Table[0].Value    = symbol;
+    fse->Table[0].Base     = 0;
+    fse->Table[0].BitCount = 0;
+    fse->Table[0].Extra    = 0;
+    fse->Log   = 0;
+    fse->Valid = true;
+}
+
+/// @summary Replace the symbols of a sequence code table with the base values and extra bit counts of the codes.
+/// @param fse The table to update.
+/// @param base The base value of each code, or NULL for offset codes, where the base value is 1 << code.
+/// @param extra The number of extra bits of each code, or NULL for offset codes, where it is the code itself.
+internal_function void zstd_fse_values(zstd_fse_t *fse, uint32_t const *base, uint8_t const *extra)
+{
+    for (size_t i = 0, n = size_t(1) << fse->Log; i < n; ++i)
+    {
+        zstd_fse_entry_t &e = fse->Table[i];
+        uint32_t       code = e.Value;
+        e.Value             = base  != NULL ? base [code] : (1U << code);
+        e.Extra             = extra != NULL ? extra[code] : uint8_t(code);
+    }
+}
+
+/// @summary Set up one of the sequence code tables, as specified by the compression mode in the sequences section header.
+/// @param fse The table to set up. For ZSTD_TABLE_REPEAT, the table of the previous block.
+/// @param mode One of zstd_table_mode_e.
+/// @param src The table description, if any.
+/// @param size The maximum number of bytes to read.
+/// @param default_freq The predefined distribution.
+/// @param default_count The number of codes in the predefined distribution.
+/// @param default_log The accuracy log of the predefined distribution.
+/// @param max_log The largest accuracy log allowed.
+/// @param max_symbol The largest code allowed.
+/// @param base The base value of each code, or NULL for offset codes.
+/// @param extra The number of extra bits of each code, or NULL for offset codes.
+/// @param used On return, the number of bytes of table description read.
+/// @return true if the table is ready, or false if the description is invalid.
+internal_function bool zstd_sequence_table(zstd_fse_t *fse, uint32_t mode, uint8_t const *src, size_t size, int16_t const *default_freq, uint32_t default_count, uint32_t default_log, uint32_t max_log, uint32_t max_symbol, uint32_t const *base, uint8_t const *extra, size_t &used)
+{
+    used = 0;
+    switch (mode)
+    {
+    case ZSTD_TABLE_PREDEFINED:
+        if (!zstd_fse_build(fse, default_freq, default_count, default_log))
+            return false;
+        break;
+    case ZSTD_TABLE_RLE:
+        if (size < 1 || src[0] > max_symbol)
+            return false;
+        zstd_fse_rle(fse, src[0]);
+        used = 1;
+        break;
+    case ZSTD_TABLE_COMPRESSED:
+        if (!zstd_fse_read(fse, src, size, max_log, max_symbol, used))
+            return false;
+        break;
+    default:
+        return fse->Valid;
+    }
+    zstd_fse_values(fse, base, extra);
+    return true;
+}
+
+/// @summary Read the Huffman tree description of a compressed literals section and build the literal decoding table.
+/// @param zd The decoder state.
+/// @param src The tree description.
+/// @param size The maximum number of bytes to read.
+/// @param used On return, the number of bytes in the tree description.
+/// @return true if the table was built, or false if the description is invalid.
+internal_function bool zstd_huffman_read(zstd_decoder_t *zd, uint8_t const *src, size_t size, size_t &used)
+{
+    uint8_t  weights[256];
+    uint32_t count  = 0;
+    uint32_t header = size > 0 ? src[0] : 0;
+    if (size == 0)
+    {
+        return false;
+    }
+    if (header >= 128)
+    {   // the weights are stored directly, as 4-bit values.
+        count = header - 127;
+        used  = 1 + (count + 1) / 2;
+        if (used > size) return false;
+        for (uint32_t i = 0; i < count; ++i)
+            weights[i] = (i & 1) ? (src[1 + i / 2] & 15) : (src[1 + i / 2] >> 4);
+    }
+    else
+    {   // the weights are FSE-compressed, with two interleaved states.
+        zstd_fse_t  table;
+        zstd_bits_t br;
+        size_t      table_size = 0;
+        used = 1 + header;
+        if (header == 0 || used > size)
+            return false;
+        if (!zstd_fse_read(&table, src + 1, header, ZSTD_WEIGHT_MAX_LOG, 255, table_size))
+            return false;
+        if (!zstd_bits_init(&br, src + 1 + table_size, header - table_size))
+            return false;
+        uint32_t s1 = zstd_bits_read(&br, table.Log);
+        uint32_t s2 = zstd_bits_read(&br, table.Log);
+        for ( ; ; )
+        {   // the stream ends when a state update reads past its start; the other state then holds the final weight.
+            if (count > 253) return false;
+            zstd_bits_reload(&br);
+            weights[count++] = uint8_t(table.Table[s1].Value);
+            s1 = table.Table[s1].Base + zstd_bits_read(&br, table.Table[s1].BitCount);
+            if (zstd_bits_overflow(&br))
+            {
+                weights[count++] = uint8_t(table.Table[s2].Value);
+                break;
+            }
+            zstd_bits_reload(&br);
+            weights[count++] = uint8_t(table.Table[s2].Value);
+            s2 = table.Table[s2].Base + zstd_bits_read(&br, table.Table[s2].BitCount);
+            if (zstd_bits_overflow(&br))
+            {
+                weights[count++] = uint8_t(table.Table[s1].Value);
+                break;
+            }
+        }
+    }
+
+    // the weight of the final symbol is implied by the others, since the weights must sum to a power of two.
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (weights[i] > ZSTD_HUFFMAN_MAX_BITS) return false;
+        if (weights[i] > 0) total += 1U << (weights[i] - 1);
+    }
+    if (total == 0)
+    {
+        return false;
+    }
+    uint32_t max_bits = zstd_highbit(total) + 1;
+    uint32_t left     =(1U << max_bits) - total;
+    if (max_bits > ZSTD_HUFFMAN_MAX_BITS || (left & (left - 1)) != 0 || count > 255)
+    {
+        return false;
+    }
+    weights[count++] = uint8_t(zstd_highbit(left) + 1);
+
+    // assign codes in order of increasing weight, then symbol; each code fills a run of table entries.
+    uint32_t rank_count[ZSTD_HUFFMAN_MAX_BITS + 1];
+    uint32_t rank_start[ZSTD_HUFFMAN_MAX_BITS + 1];
+    memset(rank_count, 0, sizeof(rank_count));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (weights[i] > 0) rank_count[max_bits + 1 - weights[i]]++;
+    }
+    rank_start[max_bits] = 0;
+    for (uint32_t b = max_bits; b >= 1; --b)
+    {
+        rank_start[b - 1] = rank_start[b] + (rank_count[b] << (max_bits - b));
+    }
+    if (rank_start[0] != (1U << max_bits))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (weights[i] == 0) continue;
+        uint32_t bits  = max_bits + 1 - weights[i];
+        uint32_t first = rank_start[bits];
+        uint32_t n     = 1U << (max_bits - bits);
+        uint16_t entry = uint16_t((bits << 8) | i);
+        for (uint32_t j = 0; j < n; ++j)
+            zd->Huffman[first + j] = entry;
+        rank_start[bits] += n;
+    }
+    zd->HuffmanBits = max_bits;
+    return true;
+}
+
+/// @summary Decode one literal from a Huffman-coded stream.
+/// @param zd The decoder state.
+/// @param br The bit reader. At least HuffmanBits bits must be available.
+/// @param shift 64 - HuffmanBits.
+/// @return The decoded literal.
+internal_function inline uint8_t zstd_huffman_decode(zstd_decoder_t const *zd, zstd_bits_t *br, uint32_t shift)
+{
+    uint32_t e    = zd->Huffman[br->Bits >> shift];
+    uint32_t n    = e >> 8;
+    br->Bits    <<= n;
+    br->Consumed += n;
+    return uint8_t(e);
+}
+
+/// @summary Decode the remaining literals of a Huffman-coded stream one at a time, and check that the stream was consumed exactly.
+/// @param zd The decoder state.
+/// @param br The bit reader for the stream.
+/// @param dst The location at which to write the literals.
+/// @param end The end of the stream's literals.
+/// @param shift 64 - HuffmanBits.
+/// @return true if the stream was consumed exactly.
+internal_function inline bool zstd_huffman_tail(zstd_decoder_t const *zd, zstd_bits_t *br, uint8_t *dst, uint8_t const *end, uint32_t shift)
+{
+    while (dst < end)
+    {
+        zstd_bits_reload(br);
+        *dst++ = zstd_huffman_decode(zd, br, shift);
+    }
+    zstd_bits_reload(br);
+    return zstd_bits_finished(br);
+}
+
+/// @summary Decode a single Huffman-coded literal stream.
+/// @param zd The decoder state.
+/// @param dst The location at which to write the literals.
+/// @param count The number of literals in the stream.
+/// @param src The compressed stream.
+/// @param size The size of the compressed stream, in bytes.
+/// @return true if the stream was decoded and consumed exactly.
+internal_function bool zstd_huffman_stream(zstd_decoder_t const *zd, uint8_t *dst, size_t count, uint8_t const *src, size_t size)
+{
+    zstd_bits_t    br;
+    uint32_t const shift = 64 - zd->HuffmanBits;
+    uint8_t       *end   = dst + count;
+    if (!zstd_bits_init(&br, src, size))
+    {
+        return false;
+    }
+    while (end - dst >= 4)
+    {   // four codes of up to 11 bits fit in one refill.
+        zstd_bits_reload(&br);
+        dst[0] = zstd_huffman_decode(zd, &br, shift);
+        dst[1] = zstd_huffman_decode(zd, &br, shift);
+        dst[2] = zstd_huffman_decode(zd, &br, shift);
+        dst[3] = zstd_huffman_decode(zd, &br, shift);
+        dst   += 4;
+    }
+    return zstd_huffman_tail(zd, &br, dst, end, shift);
+}
+
+/// @summary Decode four Huffman-coded literal streams. The first three streams each decode a quarter of the literals, rounded up, and the fourth decodes the rest.
+/// @param zd The decoder state.
+/// @param dst The location at which to write the literals.
+/// @param count The total number of literals.
+/// @param src The jump table, followed by the four compressed streams.
+/// @param size The total size of the jump table and streams, in bytes.
+/// @return true if all four streams were decoded and consumed exactly.
+internal_function bool zstd_huffman_streams(zstd_decoder_t const *zd, uint8_t *dst, size_t count, uint8_t const *src, size_t size)
+{
+    if (size < 6)
+    {   // the jump table is missing.
+        return false;
+    }
+    size_t   seg   =(count + 3) / 4;
+    size_t   size1 = zstd_read16(src + 0);
+    size_t   size2 = zstd_read16(src + 2);
+    size_t   size3 = zstd_read16(src + 4);
+    if (seg * 3 > count || 6 + size1 + size2 + size3 > size)
+    {
+        return false;
+    }
+    size_t   size4 = size - 6 - size1 - size2 - size3;
+    uint8_t const *s1 = src + 6;
+    uint8_t const *s2 = s1  + size1;
+    uint8_t const *s3 = s2  + size2;
+    uint8_t const *s4 = s3  + size3;
+    zstd_bits_t b1, b2, b3, b4;
+    if (!zstd_bits_init(&b1, s1, size1) || !zstd_bits_init(&b2, s2, size2) ||
+        !zstd_bits_init(&b3, s3, size3) || !zstd_bits_init(&b4, s4, size4))
+    {
+        return false;
+    }
+
+    // decode the four streams together while each has at least four literals left.
+    // the fourth stream is never longer than the others.
+    uint32_t const shift = 64 - zd->HuffmanBits;
+    uint8_t *o1 = dst;
+    uint8_t *o2 = o1 + seg;
+    uint8_t *o3 = o2 + seg;
+    uint8_t *o4 = o3 + seg;
+    uint8_t *e4 = dst + count;
+    while (e4 - o4 >= 4)
+    {
+        zstd_bits_reload(&b1); zstd_bits_reload(&b2); zstd_bits_reload(&b3); zstd_bits_reload(&b4);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            o1[i] = zstd_huffman_decode(zd, &b1, shift);
+            o2[i] = zstd_huffman_decode(zd, &b2, shift);
+            o3[i] = zstd_huffman_decode(zd, &b3, shift);
+            o4[i] = zstd_huffman_decode(zd, &b4, shift);
+        }
+        o1 += 4; o2 += 4; o3 += 4; o4 += 4;
+    }
+
+    // finish each stream separately.
+    return zstd_huffman_tail(zd, &b1, o1, dst + seg    , shift) &&
+           zstd_huffman_tail(zd, &b2, o2, dst + seg * 2, shift) &&
+           zstd_huffman_tail(zd, &b3, o3, dst + seg * 3, shift) &&
+           zstd_huffman_tail(zd, &b4, o4, e4           , shift);
+}
+
+/// @summary Decode the literals section of a compressed block into the literal buffer.
+/// @param zd The decoder state.
+/// @param src The start of the compressed block.
+/// @param size The size of the compressed block, in bytes.
+/// @param lit_size On return, the number of literals decoded.
+/// @param used On return, the size of the literals section, in bytes.
+/// @return true if the literals were decoded, or false if the section is invalid.
+internal_function bool zstd_literals(zstd_decoder_t *zd, uint8_t const *src, size_t size, size_t &lit_size, size_t &used)
+{
+    if (size < 1)
+    {
+        return false;
+    }
+    uint32_t type   = src[0] & 3;
+    uint32_t format =(src[0] >> 2) & 3;
+    if (type == ZSTD_LITERALS_RAW || type == ZSTD_LITERALS_RLE)
+    {   // the size of the section header depends on the size format.
+        size_t header = 1;
+        switch (format)
+        {
+        case 1: header = 2; lit_size = size >= 2 ? zstd_read16(src) >> 4 : 0; break;
+        case 3: header = 3; lit_size = size >= 3 ? zstd_read24(src) >> 4 : 0; break;
+        default:            lit_size = src[0] >> 3; break;
+        }
+        if (header > size || lit_size > ZSTD_BLOCK_SIZE_MAX)
+        {
+            return false;
+        }
+        if (type == ZSTD_LITERALS_RAW)
+        {   // copy the literals, so that the copies in zstd_sequences() may read past the end.
+            if (lit_size > size - header) return false;
+            memcpy(zd->Literals, src + header, lit_size);
+            used = header + lit_size;
+        }
+        else
+        {
+            if (size - header < 1) return false;
+            memset(zd->Literals, src[header], lit_size);
+            used = header + 1;
+        }
+        return true;
+    }
+
+    // Huffman-coded literals; the header holds both the compressed and decompressed sizes.
+    size_t header  = 0;
+    size_t packed  = 0;
+    bool   single  = false;
+    switch (format)
+    {
+    case 0:
+    case 1:
+        {
+            if (size < 3) return false;
+            uint32_t h = zstd_read24(src);
+            header     = 3;
+            lit_size   =(h >>  4) & 0x3FF;
+            packed     =(h >> 14) & 0x3FF;
+            single     =(format == 0);
+        }
+        break;
+    case 2:
+        {
+            if (size < 4) return false;
+            uint32_t h = zstd_read32(src);
+            header     = 4;
+            lit_size   =(h >>  4) & 0x3FFF;
+            packed     =(h >> 18);
+        }
+        break;
+    default:
+        {
+            if (size < 5) return false;
+            uint64_t h = uint64_t(zstd_read32(src)) | (uint64_t(src[4]) << 32);
+            header     = 5;
+            lit_size   = size_t((h >>  4) & 0x3FFFF);
+            packed     = size_t((h >> 22) & 0x3FFFF);
+        }
+        break;
+    }
+    if (lit_size > ZSTD_BLOCK_SIZE_MAX || packed > size - header)
+    {
+        return false;
+    }
+    uint8_t const *body = src + header;
+    size_t   body_size  = packed;
+    if (type == ZSTD_LITERALS_COMPRESSED)
+    {   // a new Huffman table precedes the streams.
+        size_t table_size = 0;
+        if (!zstd_huffman_read(zd, body, body_size, table_size))
+            return false;
+        body      += table_size;
+        body_size -= table_size;
+    }
+    else if (zd->HuffmanBits == 0)
+    {   // there's no previous table to reuse.
+        return false;
+    }
+    used = header + packed;
+    if (single) return zstd_huffman_stream (zd, zd->Literals, lit_size, body, body_size);
+    else        return zstd_huffman_streams(zd, zd->Literals, lit_size, body, body_size);
+}
+
+/// @summary Copy a run of literals to the output.
+/// @param dst The first byte to write.
+/// @param src The first literal. At least 16 bytes past the end of the run must be readable.
+/// @param length The number of literals.
+/// @param dst_end The end of the output buffer.
+internal_function inline void zstd_copy_literals(uint8_t *dst, uint8_t const *src, size_t length, uint8_t const *dst_end)
+{
+    if (size_t(dst_end - dst) >= length + 16)
+    {   // copy 16 bytes at a time, possibly writing past the end of the run.
+        for (size_t i = 0; i < length; i += 16)
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_loadu_si128((__m128i const*)(src + i)));
+    }
+    else memcpy(dst, src, length);
+}
+
+/// @summary Copy a match within the output buffer.
+/// @param dst The first byte to write.
+/// @param distance The distance back to the source of the match. Must be non-zero.
+/// @param length The length of the match, in bytes.
+/// @param dst_end The end of the output buffer.
+internal_function inline void zstd_copy_match(uint8_t *dst, size_t distance, size_t length, uint8_t const *dst_end)
+{
+    uint8_t const *src = dst - distance;
+    if (distance >= 16 && size_t(dst_end - dst) >= length + 16)
+    {   // the source and destination of each 16-byte copy don't overlap.
+        for (size_t i = 0; i < length; i += 16)
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_loadu_si128((__m128i const*)(src + i)));
+    }
+    else if (distance == 1)
+    {   // a run of a single byte.
+        memset(dst, src[0], length);
+    }
+    else if (distance >= length)
+    {   // the source and destination don't overlap.
+        memcpy(dst, src, length);
+    }
+    else
+    {   // the output repeats with a period of distance bytes. copy whole periods
+        // from src, doubling the amount copied each time.
+        size_t done = 0;
+        while (done < length)
+        {
+            size_t n = done + distance;
+            if (n > length - done) n = length - done;
+            memcpy(dst + done, src, n);
+            done += n;
+        }
+    }
+}
+
+/// @summary Decode the sequences section of a compressed block and execute the sequences, writing the block's output.
+/// @param zd The decoder state, with the block's literals already decoded.
+/// @param src The sequences section.
+/// @param size The size of the sequences section, in bytes.
+/// @param lit_size The number of decoded literals.
+/// @param frame The start of the output of the current frame. Matches may not reach before it.
+/// @param out The current output position. On return, advanced past the block's output.
+/// @param out_end The end of the output buffer.
+/// @return true if the block was decoded, or false if it is invalid or the output buffer is too small.
+internal_function bool zstd_sequences(zstd_decoder_t *zd, uint8_t const *src, size_t size, size_t lit_size, uint8_t const *frame, uint8_t *&out, uint8_t *out_end)
+{
+    uint8_t const *lit     = zd->Literals;
+    uint8_t const *lit_end = zd->Literals + lit_size;
+    uint8_t       *op      = out;
+    size_t         count   = 0;
+    size_t         pos     = 0;
+    if (size < 1)
+    {
+        return false;
+    }
+    if (src[0] < 128)
+    {
+        count = src[0];
+        pos   = 1;
+    }
+    else if (src[0] < 255)
+    {
+        if (size < 2) return false;
+        count = ((size_t(src[0]) - 128) << 8) + src[1];
+        pos   = 2;
+    }
+    else
+    {
+        if (size < 3) return false;
+        count = size_t(src[1]) + (size_t(src[2]) << 8) + 0x7F00;
+        pos   = 3;
+    }
+    if (count > 0)
+    {
+        if (pos >= size || (src[pos] & 3) != 0)
+        {   // the compression modes are missing, or the reserved bits are set.
+            return false;
+        }
+        uint32_t modes = src[pos++];
+        size_t   used  = 0;
+        if (!zstd_sequence_table(&zd->LitLen  , (modes >> 6) & 3, src + pos, size - pos, ZSTD_LITLEN_DEFAULT  , 36, 6, 9, 35, ZSTD_LITLEN_BASE  , ZSTD_LITLEN_EXTRA  , used)) return false;
+        pos += used;
+        if (!zstd_sequence_table(&zd->Offset  , (modes >> 4) & 3, src + pos, size - pos, ZSTD_OFFSET_DEFAULT  , 29, 5, 8, 31, NULL              , NULL               , used)) return false;
+        pos += used;
+        if (!zstd_sequence_table(&zd->MatchLen, (modes >> 2) & 3, src + pos, size - pos, ZSTD_MATCHLEN_DEFAULT, 53, 6, 9, 52, ZSTD_MATCHLEN_BASE, ZSTD_MATCHLEN_EXTRA, used)) return false;
+        pos += used;
+
+        zstd_bits_t br;
+        if (!zstd_bits_init(&br, src + pos, size - pos))
+        {
+            return false;
+        }
+        zstd_fse_entry_t const *ll_table = zd->LitLen.Table;
+        zstd_fse_entry_t const *of_table = zd->Offset.Table;
+        zstd_fse_entry_t const *ml_table = zd->MatchLen.Table;
+        uint32_t ll_state = zstd_bits_read(&br, zd->LitLen.Log);
+        uint32_t of_state = zstd_bits_read(&br, zd->Offset.Log);
+        uint32_t ml_state = zstd_bits_read(&br, zd->MatchLen.Log);
+        size_t   rep0     = zd->Repeat[0];
+        size_t   rep1     = zd->Repeat[1];
+        size_t   rep2     = zd->Repeat[2];
+        for (size_t i = 0; i < count; ++i)
+        {   // read the extra bits of the offset, match length and literal length codes, in that order.
+            zstd_fse_entry_t const ll = ll_table[ll_state];
+            zstd_fse_entry_t const of = of_table[of_state];
+            zstd_fse_entry_t const ml = ml_table[ml_state];
+            zstd_bits_reload(&br);
+            size_t offset = of.Value + zstd_bits_read(&br, of.Extra);
+            if (br.Consumed > 32)
+            {   // a long offset; the lengths may need up to 32 more bits.
+                zstd_bits_reload(&br);
+            }
+            size_t mlen   = ml.Value + zstd_bits_read(&br, ml.Extra);
+            size_t llen   = ll.Value + zstd_bits_read(&br, ll.Extra);
+            if (i + 1 < count)
+            {   // update the states for the next sequence, which needs up to 26 bits.
+                if (br.Consumed > 38) zstd_bits_reload(&br);
+                ll_state = ll.Base + zstd_bits_read(&br, ll.BitCount);
+                ml_state = ml.Base + zstd_bits_read(&br, ml.BitCount);
+                of_state = of.Base + zstd_bits_read(&br, of.BitCount);
+            }
+
+            // offset values 1-3 select a recent offset; when there are no literals they are shifted by one.
+            if (offset > 3)
+            {
+                offset = offset - 3;
+                rep2   = rep1;
+                rep1   = rep0;
+                rep0   = offset;
+            }
+            else
+            {
+                size_t index = offset - 1 + (llen == 0 ? 1 : 0);
+                if (index == 0)
+                {
+                    offset = rep0;
+                }
+                else
+                {
+                    offset = index == 1 ? rep1 : (index == 2 ? rep2 : rep0 - 1);
+                    if (index > 1) rep2 = rep1;
+                    rep1   = rep0;
+                    rep0   = offset;
+                }
+            }
+
+            // copy the literals, then the match.
+            if (llen > size_t(lit_end - lit) || llen + mlen > size_t(out_end - op))
+            {   // the block overruns its literals or the output buffer.
+                return false;
+            }
+            zstd_copy_literals(op, lit, llen, out_end);
+            op  += llen;
+            lit += llen;
+            if (offset == 0 || offset > size_t(op - frame))
+            {   // the match starts before the start of the frame.
+                return false;
+            }
+            zstd_copy_match(op, offset, mlen, out_end);
+            op  += mlen;
+        }
+        zstd_bits_reload(&br);
+        if (!zstd_bits_finished(&br))
+        {   // the sequence bitstream wasn't consumed exactly.
+            return false;
+        }
+        zd->Repeat[0] = rep0;
+        zd->Repeat[1] = rep1;
+        zd->Repeat[2] = rep2;
+    }
+
+    // the literals remaining after the last sequence end the block.
+    size_t rest = size_t(lit_end - lit);
+    if (rest > size_t(out_end - op))
+    {
+        return false;
+    }
+    memcpy(op, lit, rest);
+    out = op + rest;
+    return true;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize a Zstandard decoder and allocate its literal buffer.
+/// @param zd The decoder state to initialize.
+/// @return true if the decoder was initialized, or false if memory allocation failed.
+public_function bool zstd_init(zstd_decoder_t *zd)
+{
+    zd->HuffmanBits     = 0;
+    zd->LitLen.Valid    = false;
+    zd->Offset.Valid    = false;
+    zd->MatchLen.Valid  = false;
+    zd->Repeat[0]       = 1;
+    zd->Repeat[1]       = 4;
+    zd->Repeat[2]       = 8;
+    if ((zd->Literals   = (uint8_t*) malloc(ZSTD_BLOCK_SIZE_MAX + ZSTD_LITERAL_PADDING)) == NULL)
+    {
+        return false;
+    }
+    memset(zd->Literals + ZSTD_BLOCK_SIZE_MAX, 0, ZSTD_LITERAL_PADDING);
+    return true;
+}
+
+/// @summary Free the resources associated with a Zstandard decoder.
+/// @param zd The decoder state.
+public_function void zstd_delete(zstd_decoder_t *zd)
+{
+    free(zd->Literals); zd->Literals = NULL;
+}
+
+/// @summary Decompress one or more complete Zstandard frames. Skippable frames are ignored.
+/// @param zd The decoder state.
+/// @param dst The buffer to which the decompressed data is written.
+/// @param dst_size The size of the output buffer, in bytes.
+/// @param src The compressed frames.
+/// @param src_size The size of the compressed data, in bytes.
+/// @param out_size On return, the number of bytes written to dst.
+/// @return true if all of the data was decompressed, or false if it is invalid, uses a dictionary, or doesn't fit in the output buffer.
+public_function bool zstd_decompress(zstd_decoder_t *zd, void *dst, size_t dst_size, void const *src, size_t src_size, size_t &out_size)
+{
+    uint8_t const *ip   = (uint8_t const*) src;
+    uint8_t const *iend = ip + src_size;
+    uint8_t       *op   = (uint8_t*) dst;
+    uint8_t       *oend = op + dst_size;
+    out_size = 0;
+    while (ip < iend)
+    {
+        if (iend - ip < 4)
+        {   // truncated frame.
+            return false;
+        }
+        uint32_t magic = zstd_read32(ip);
+        if ((magic & 0xFFFFFFF0U) == ZSTD_SKIPPABLE_MAGIC)
+        {   // skippable frames hold application data.
+            if (iend - ip < 8 || zstd_read32(ip + 4) > size_t(iend - ip) - 8)
+                return false;
+            ip += 8 + zstd_read32(ip + 4);
+            continue;
+        }
+        if (magic != ZSTD_MAGIC || iend - ip < 5)
+        {
+            return false;
+        }
+
+        // parse the frame header.
+        uint32_t desc      = ip[4];
+        uint32_t fcs_flag  = desc >> 6;
+        bool     single    =(desc & 0x20) != 0;
+        bool     checksum  =(desc & 0x04) != 0;
+        size_t   dict_size =(desc & 3) == 3 ? 4 : (desc & 3);
+        size_t   fcs_size  = fcs_flag == 0 ? (single ? 1 : 0) : (size_t(1) << fcs_flag);
+        size_t   header    = 5 + (single ? 0 : 1) + dict_size + fcs_size;
+        if ((desc & 0x08) != 0 || size_t(iend - ip) < header)
+        {   // the reserved bit is set, or the header is truncated.
+            return false;
+        }
+        uint8_t const *field = ip + 5 + (single ? 0 : 1);
+        uint32_t dict_id     = 0;
+        for (size_t i = 0; i < dict_size; ++i)
+            dict_id |= uint32_t(field[i]) << (i * 8);
+        if (dict_id != 0)
+        {   // dictionaries aren't supported.
+            return false;
+        }
+        field += dict_size;
+        uint64_t content = 0;
+        for (size_t i = 0; i < fcs_size; ++i)
+            content |= uint64_t(field[i]) << (i * 8);
+        if (fcs_size == 2) content += 256;
+        if (fcs_size > 0 && content > uint64_t(oend - op))
+        {   // the output buffer is too small.
+            return false;
+        }
+        ip += header;
+
+        // reset the state carried between blocks.
+        uint8_t const *frame = op;
+        zd->HuffmanBits    = 0;
+        zd->LitLen.Valid   = false;
+        zd->Offset.Valid   = false;
+        zd->MatchLen.Valid = false;
+        zd->Repeat[0]      = 1;
+        zd->Repeat[1]      = 4;
+        zd->Repeat[2]      = 8;
+        for ( ; ; )
+        {
+            if (iend - ip < 3)
+            {   // truncated block header.
+                return false;
+            }
+            uint32_t block = zstd_read24(ip);
+            bool     last  =(block & 1) != 0;
+            uint32_t type  =(block >> 1) & 3;
+            size_t   size  = block >> 3;
+            ip += 3;
+            if (size > ZSTD_BLOCK_SIZE_MAX)
+            {
+                return false;
+            }
+            if (type == ZSTD_BLOCK_RAW)
+            {
+                if (size > size_t(iend - ip) || size > size_t(oend - op))
+                    return false;
+                memcpy(op, ip, size);
+                ip += size;
+                op += size;
+            }
+            else if (type == ZSTD_BLOCK_RLE)
+            {
+                if (iend - ip < 1 || size > size_t(oend - op))
+                    return false;
+                memset(op, ip[0], size);
+                ip += 1;
+                op += size;
+            }
+            else if (type == ZSTD_BLOCK_COMPRESSED)
+            {
+                size_t lit_size = 0;
+                size_t used     = 0;
+                if (size > size_t(iend - ip))
+                    return false;
+                if (!zstd_literals(zd, ip, size, lit_size, used))
+                    return false;
+                if (!zstd_sequences(zd, ip + used, size - used, lit_size, frame, op, oend))
+                    return false;
+                ip += size;
+            }
+            else return false;
+            if (last) break;
+        }
+        if (checksum)
+        {   // the content checksum isn't verified.
+            if (iend - ip < 4) return false;
+            ip += 4;
+        }
+        if (fcs_size > 0 && uint64_t(op - frame) != content)
+        {   // the frame didn't produce the declared amount of data.
+            return false;
+        }
+    }
+    out_size = size_t(op - (uint8_t*) dst);
+    return true;
+}